@@ -21,6 +21,7 @@ LOCAL_C_INCLUDES += $(LOCAL_PATH)/../../ouzel \
 LOCAL_SRC_FILES := ../../ouzel/assets/BmfLoader.cpp \
 	../../ouzel/assets/Bundle.cpp \
 	../../ouzel/assets/Cache.cpp \
+	../../ouzel/assets/Cooker.cpp \
     ../../ouzel/assets/ColladaLoader.cpp \
     ../../ouzel/assets/CueLoader.cpp \
 	../../ouzel/assets/GltfLoader.cpp \
@@ -34,6 +35,8 @@ LOCAL_SRC_FILES := ../../ouzel/assets/BmfLoader.cpp \
     ../../ouzel/assets/WaveLoader.cpp \
     ../../ouzel/audio/empty/EmptyAudioDevice.cpp \
     ../../ouzel/audio/mixer/Bus.cpp \
+    ../../ouzel/audio/mixer/Decoder.cpp \
+    ../../ouzel/audio/mixer/Kernels.cpp \
 	../../ouzel/audio/mixer/Mixer.cpp \
     ../../ouzel/audio/opensl/OSLAudioDevice.cpp \
     ../../ouzel/audio/Audio.cpp \
@@ -69,6 +72,11 @@ LOCAL_SRC_FILES := ../../ouzel/assets/BmfLoader.cpp \
 	../../ouzel/graphics/opengl/OGLRenderTarget.cpp \
     ../../ouzel/graphics/opengl/OGLShader.cpp \
     ../../ouzel/graphics/opengl/OGLTexture.cpp \
+    ../../ouzel/graphics/software/SoftwareTexture.cpp \
+    ../../ouzel/graphics/software/SoftwareShader.cpp \
+    ../../ouzel/graphics/software/SoftwareRenderDevice.cpp \
+    ../../ouzel/graphics/empty/EmptyRenderDevice.cpp \
+    ../../ouzel/graphics/software/SoftwareRasterizer.cpp \
     ../../ouzel/graphics/BlendState.cpp \
     ../../ouzel/graphics/Buffer.cpp \
 	../../ouzel/graphics/DepthStencilState.cpp \
@@ -106,6 +114,7 @@ LOCAL_SRC_FILES := ../../ouzel/assets/BmfLoader.cpp \
 	../../ouzel/scene/Animators.cpp \
     ../../ouzel/scene/Camera.cpp \
     ../../ouzel/scene/Component.cpp \
+    ../../ouzel/scene/InstanceBatch.cpp \
     ../../ouzel/scene/Layer.cpp \
     ../../ouzel/scene/Light.cpp \
     ../../ouzel/scene/ParticleSystem.cpp \
@@ -113,9 +122,14 @@ LOCAL_SRC_FILES := ../../ouzel/assets/BmfLoader.cpp \
     ../../ouzel/scene/SceneManager.cpp \
     ../../ouzel/scene/ShapeRenderer.cpp \
     ../../ouzel/scene/SkinnedMeshRenderer.cpp \
+    ../../ouzel/scene/SpatialIndex.cpp \
+    ../../ouzel/scene/SpriteBatch.cpp \
     ../../ouzel/scene/SpriteRenderer.cpp \
     ../../ouzel/scene/StaticMeshRenderer.cpp \
     ../../ouzel/scene/TextRenderer.cpp \
+    ../../ouzel/storage/Archive.cpp \
+    ../../ouzel/storage/Inflater.cpp \
+    ../../ouzel/storage/Pack.cpp \
     ../../ouzel/storage/FileSystem.cpp \
     ../../ouzel/utils/Log.cpp \
     ../../ouzel/utils/Obf.cpp \
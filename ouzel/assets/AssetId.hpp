@@ -0,0 +1,52 @@
+// Copyright 2015-2019 Elviss Strazdins. All rights reserved.
+
+#ifndef OUZEL_ASSETS_ASSETID_HPP
+#define OUZEL_ASSETS_ASSETID_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "math/Fnv.hpp"
+
+namespace ouzel
+{
+    namespace assets
+    {
+        // Hash of an asset name, computed at compile time for string literals
+        class AssetId final
+        {
+        public:
+            constexpr AssetId() noexcept = default;
+
+            template <size_t N>
+            constexpr AssetId(const char (&name)[N]) noexcept:
+                value(fnv::hash<uint64_t>(name, getLength(name)))
+            {
+            }
+
+            AssetId(const std::string& name) noexcept:
+                value(fnv::hash<uint64_t>(name.data(), name.length()))
+            {
+            }
+
+            constexpr auto getValue() const noexcept { return value; }
+
+            constexpr bool operator==(const AssetId& other) const noexcept { return value == other.value; }
+            constexpr bool operator!=(const AssetId& other) const noexcept { return value != other.value; }
+
+        private:
+            // the array can also be a buffer that is longer than the name
+            template <size_t N>
+            static constexpr size_t getLength(const char (&name)[N]) noexcept
+            {
+                size_t length = 0;
+                while (length < N && name[length]) ++length;
+                return length;
+            }
+
+            uint64_t value = fnv::offsetBasis<uint64_t>;
+        };
+    } // namespace assets
+} // namespace ouzel
+
+#endif // OUZEL_ASSETS_ASSETID_HPP
@@ -0,0 +1,129 @@
+// Copyright 2015-2019 Elviss Strazdins. All rights reserved.
+
+#ifndef OUZEL_ASSETS_ASSETMAP_HPP
+#define OUZEL_ASSETS_ASSETMAP_HPP
+
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "assets/AssetId.hpp"
+
+namespace ouzel
+{
+    namespace assets
+    {
+        // Open addressing hash table of assets keyed by the hash of their name,
+        // the assets are allocated separately, so their addresses do not change when the table grows
+        template <class T>
+        class AssetMap final
+        {
+        public:
+            T* find(const AssetId& id) noexcept
+            {
+                const Slot* slot = findSlot(id.getValue());
+                return slot ? &slot->node->value : nullptr;
+            }
+
+            const T* find(const AssetId& id) const noexcept
+            {
+                const Slot* slot = findSlot(id.getValue());
+                return slot ? &slot->node->value : nullptr;
+            }
+
+            // returns the existing asset with the name or a new default constructed one
+            T& insert(const std::string& name)
+            {
+                const AssetId id(name);
+
+                if (const Slot* slot = findSlot(id.getValue()))
+                {
+                    // the name is kept only to tell different names with the same hash apart
+                    if (slot->node->name != name)
+                        throw std::runtime_error("Asset " + name + " has the same hash as " + slot->node->name);
+
+                    return slot->node->value;
+                }
+
+                // keep the load factor at most 0.5
+                if ((count + 1) * 2 > slots.size())
+                    resize(slots.empty() ? MIN_CAPACITY : slots.size() * 2);
+
+                Slot& slot = slots[findEmptySlot(id.getValue())];
+                slot.hash = id.getValue();
+                slot.node.reset(new Node{name, T()});
+                ++count;
+
+                return slot.node->value;
+            }
+
+            void clear() noexcept
+            {
+                slots.clear();
+                count = 0;
+            }
+
+            inline auto getSize() const noexcept { return count; }
+            inline auto isEmpty() const noexcept { return count == 0; }
+
+        private:
+            static constexpr size_t MIN_CAPACITY = 16;
+
+            struct Node final
+            {
+                std::string name;
+                T value;
+            };
+
+            struct Slot final
+            {
+                uint64_t hash = 0;
+                std::unique_ptr<Node> node;
+            };
+
+            const Slot* findSlot(uint64_t hash) const noexcept
+            {
+                if (slots.empty()) return nullptr;
+
+                const size_t mask = slots.size() - 1;
+
+                for (size_t i = static_cast<size_t>(hash) & mask;; i = (i + 1) & mask)
+                {
+                    const Slot& slot = slots[i];
+                    if (!slot.node) return nullptr;
+                    if (slot.hash == hash) return &slot;
+                }
+            }
+
+            size_t findEmptySlot(uint64_t hash) const noexcept
+            {
+                const size_t mask = slots.size() - 1;
+
+                size_t i = static_cast<size_t>(hash) & mask;
+                while (slots[i].node) i = (i + 1) & mask;
+
+                return i;
+            }
+
+            void resize(size_t capacity)
+            {
+                std::vector<Slot> oldSlots(capacity);
+                oldSlots.swap(slots);
+
+                for (Slot& oldSlot : oldSlots)
+                    if (oldSlot.node)
+                    {
+                        Slot& slot = slots[findEmptySlot(oldSlot.hash)];
+                        slot.hash = oldSlot.hash;
+                        slot.node = std::move(oldSlot.node);
+                    }
+            }
+
+            std::vector<Slot> slots;
+            size_t count = 0;
+        };
+    } // namespace assets
+} // namespace ouzel
+
+#endif // OUZEL_ASSETS_ASSETMAP_HPP
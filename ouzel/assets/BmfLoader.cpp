@@ -15,7 +15,7 @@ namespace ouzel
 
         bool BmfLoader::loadAsset(Bundle& bundle,
                                   const std::string& name,
-                                  const std::vector<uint8_t>& data,
+                                  Span<const uint8_t> data,
                                   bool)
         {
             try
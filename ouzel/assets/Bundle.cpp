@@ -1,6 +1,9 @@
 // Copyright 2015-2019 Elviss Strazdins. All rights reserved.
 
+#include <atomic>
 #include <cctype>
+#include <exception>
+#include <functional>
 #include <stdexcept>
 #include "Bundle.hpp"
 #include "Cache.hpp"
@@ -12,6 +15,142 @@ namespace ouzel
 {
     namespace assets
     {
+        namespace
+        {
+            // reads the asset list without building a DOM
+            class AssetListHandler final: public json::Handler
+            {
+            public:
+                explicit AssetListHandler(std::vector<Asset>& initAssets): assets(initAssets) {}
+
+                void key(const std::string& newKey) { currentKey = newKey; }
+
+                void startObject()
+                {
+                    if (++depth == 3 && inAssets)
+                    {
+                        type = 0;
+                        hasType = false;
+                        name.clear();
+                        filename.clear();
+                        mipmaps = true;
+                    }
+                }
+
+                void endObject()
+                {
+                    if (depth-- == 3 && inAssets)
+                    {
+                        if (!hasType || filename.empty())
+                            throw json::RangeError("Member does not exist");
+
+                        assets.emplace_back(type, name.empty() ? filename : name, filename, mipmaps);
+                    }
+                }
+
+                void startArray()
+                {
+                    if (++depth == 2 && currentKey == "assets") inAssets = true;
+                }
+
+                void endArray()
+                {
+                    if (depth-- == 2) inAssets = false;
+                }
+
+                void boolean(bool value) { setNumber(value ? 1.0 : 0.0); }
+                void integer(int64_t value) { setNumber(static_cast<double>(value)); }
+                void floatingPoint(double value) { setNumber(value); }
+
+                void string(const std::string& value)
+                {
+                    if (depth != 3 || !inAssets) return;
+
+                    if (currentKey == "filename") filename = value;
+                    else if (currentKey == "name") name = value;
+                }
+
+            private:
+                void setNumber(double value)
+                {
+                    if (depth != 3 || !inAssets) return;
+
+                    if (currentKey == "type")
+                    {
+                        type = static_cast<uint32_t>(value);
+                        hasType = true;
+                    }
+                    else if (currentKey == "mipmaps")
+                        mipmaps = (value != 0.0);
+                }
+
+                std::vector<Asset>& assets;
+                uint32_t depth = 0;
+                bool inAssets = false;
+                std::string currentKey;
+
+                uint32_t type = 0;
+                bool hasType = false;
+                std::string name;
+                std::string filename;
+                bool mipmaps = true;
+            };
+
+        }
+
+        std::vector<Asset> Bundle::readAssetList(Span<const uint8_t> data)
+        {
+            std::vector<Asset> assets;
+            AssetListHandler handler(assets);
+            json::parse(data, handler);
+            return assets;
+        }
+
+        struct Bundle::LoadingBatch final
+        {
+            std::promise<void> promise;
+            size_t remaining = 0;
+            std::exception_ptr exception;
+        };
+
+        struct Bundle::LoadingJob final
+        {
+            enum class State
+            {
+                Queued,
+                Preparing,
+                Prepared
+            };
+
+            LoadingJob(const Asset& initAsset,
+                       storage::FileSystem& initFileSystem,
+                       const std::shared_ptr<LoadingBatch>& initBatch):
+                asset(initAsset),
+                fileSystem(initFileSystem),
+                batch(initBatch),
+                prepared(preparedPromise.get_future())
+            {
+            }
+
+            Asset asset;
+            storage::FileSystem& fileSystem;
+            std::shared_ptr<LoadingBatch> batch;
+            std::vector<Loader*> loaders; // in the order they are tried
+
+            // the job is prepared by whichever thread moves it out of the queued state first
+            std::atomic<State> state{State::Queued};
+            std::promise<void> preparedPromise;
+            std::future<void> prepared;
+
+            // written by the preparing thread, read on the update thread after the job is prepared
+            std::shared_ptr<const storage::FileView> data;
+            size_t loaderIndex = 0;
+            std::function<bool(Bundle&)> finish;
+            std::exception_ptr exception;
+
+            bool finished = false; // accessed only on the update thread
+        };
+
         Bundle::Bundle(Cache& initCache, storage::FileSystem& initFileSystem):
             cache(initCache), fileSystem(initFileSystem)
         {
@@ -20,13 +159,24 @@ namespace ouzel
 
         Bundle::~Bundle()
         {
+            // jobs that are still queued or being prepared own everything they need
             cache.removeBundle(this);
         }
 
         void Bundle::loadAsset(uint32_t loaderType, const std::string& name,
                                const std::string& filename, bool mipmaps)
         {
-            const std::vector<uint8_t> data = fileSystem.readFile(filename);
+            // an asset that is being loaded asynchronously is finished right away instead of being loaded twice
+            for (const auto& job : loadingJobs)
+                if (!job->finished && job->asset.type == loaderType && job->asset.name == name)
+                {
+                    const auto pendingJob = job;
+                    finishJob(*pendingJob);
+                    if (pendingJob->exception) std::rethrow_exception(pendingJob->exception);
+                    return;
+                }
+
+            const auto data = std::make_shared<const storage::FileView>(fileSystem.readFileView(filename, loaderType, mipmaps));
 
             const auto& loaders = cache.getLoaders();
 
@@ -34,7 +184,7 @@ namespace ouzel
             {
                 Loader* loader = i->get();
                 if (loader->getType() == loaderType &&
-                    loader->loadAsset(*this, name, data, mipmaps))
+                    loader->loadSharedAsset(*this, name, data, mipmaps))
                     return;
             }
 
@@ -43,15 +193,7 @@ namespace ouzel
 
         void Bundle::loadAssets(const std::string& filename)
         {
-            const json::Data data(fileSystem.readFile(filename));
-
-            for (const json::Value& asset : data["assets"])
-            {
-                const auto file = asset["filename"].as<std::string>();
-                const auto name = asset.hasMember("name") ? asset["name"].as<std::string>() : file;
-                const auto mipmaps = asset.hasMember("mipmaps") ? asset["mipmaps"].as<bool>() : true;
-                loadAsset(asset["type"].as<uint32_t>(), name, file, mipmaps);
-            }
+            loadAssets(readAssetList(fileSystem.readFileView(filename)));
         }
 
         void Bundle::loadAssets(const std::vector<Asset>& assets)
@@ -60,84 +202,247 @@ namespace ouzel
                 loadAsset(asset.type, asset.name, asset.filename, asset.mipmaps);
         }
 
-        std::shared_ptr<graphics::Texture> Bundle::getTexture(const std::string& name) const
+        std::future<void> Bundle::loadAssetsAsync(const std::string& filename)
+        {
+            return loadAssetsAsync(readAssetList(fileSystem.readFileView(filename)));
+        }
+
+        std::future<void> Bundle::loadAssetsAsync(const std::vector<Asset>& assets)
+        {
+            auto batch = std::make_shared<LoadingBatch>();
+            batch->remaining = assets.size();
+            std::future<void> result = batch->promise.get_future();
+
+            if (assets.empty())
+            {
+                batch->promise.set_value();
+                return result;
+            }
+
+            const auto& loaders = cache.getLoaders();
+
+            for (const Asset& asset : assets)
+            {
+                auto job = std::make_shared<LoadingJob>(asset, fileSystem, batch);
+
+                for (auto i = loaders.rbegin(); i != loaders.rend(); ++i)
+                    if ((*i)->getType() == asset.type)
+                        job->loaders.push_back(i->get());
+
+                loadingJobs.push_back(job);
+
+                cache.addJob([job]() {
+                    auto expected = LoadingJob::State::Queued;
+                    if (job->state.compare_exchange_strong(expected, LoadingJob::State::Preparing))
+                        prepareJob(*job);
+                });
+            }
+
+            requestedAssetCount += assets.size();
+            pendingAssetCount += assets.size();
+
+            return result;
+        }
+
+        void Bundle::loadPack(const std::string& filename)
+        {
+            loadAssets(mountPack(filename));
+        }
+
+        std::future<void> Bundle::loadPackAsync(const std::string& filename)
+        {
+            return loadAssetsAsync(mountPack(filename));
+        }
+
+        float Bundle::getLoadingProgress() const noexcept
+        {
+            if (requestedAssetCount == 0) return 1.0F;
+
+            return static_cast<float>(requestedAssetCount - pendingAssetCount) /
+                static_cast<float>(requestedAssetCount);
+        }
+
+        std::vector<Asset> Bundle::mountPack(const std::string& filename)
+        {
+            storage::Pack pack(fileSystem.readFileView(filename));
+
+            std::vector<Asset> assets;
+            assets.reserve(pack.getEntries().size());
+
+            for (const storage::Pack::Entry& entry : pack.getEntries())
+                assets.emplace_back(entry.type, entry.name, entry.filename, entry.mipmaps);
+
+            // the assets are read from the pack for as long as it is mounted
+            fileSystem.addPack(filename, std::move(pack));
+
+            return assets;
+        }
+
+        void Bundle::prepareJob(LoadingJob& job)
+        {
+            try
+            {
+                job.data = std::make_shared<const storage::FileView>(job.fileSystem.readFileView(job.asset.filename,
+                                                                                                 job.asset.type,
+                                                                                                 job.asset.mipmaps));
+
+                for (; job.loaderIndex < job.loaders.size(); ++job.loaderIndex)
+                    if ((job.finish = job.loaders[job.loaderIndex]->prepareSharedAsset(job.asset.name,
+                                                                                       job.data,
+                                                                                       job.asset.mipmaps)))
+                        break;
+            }
+            catch (...)
+            {
+                job.exception = std::current_exception();
+            }
+
+            job.state = LoadingJob::State::Prepared;
+            job.preparedPromise.set_value();
+        }
+
+        void Bundle::finishJob(LoadingJob& job)
+        {
+            // marked first, so that the assets loaded by the finisher do not wait for this job
+            job.finished = true;
+
+            // the job has not been picked up by a loader thread yet, so it is prepared right here
+            auto expected = LoadingJob::State::Queued;
+            if (job.state.compare_exchange_strong(expected, LoadingJob::State::Preparing))
+                prepareJob(job);
+            else
+                job.prepared.wait();
+
+            try
+            {
+                if (job.exception) std::rethrow_exception(job.exception);
+
+                bool loaded = job.finish && job.finish(*this);
+
+                // the loaders after the one that prepared the asset load it on the update thread
+                for (size_t i = job.loaderIndex + 1; !loaded && i < job.loaders.size(); ++i)
+                    loaded = job.loaders[i]->loadSharedAsset(*this, job.asset.name, job.data, job.asset.mipmaps);
+
+                if (!loaded)
+                    throw std::runtime_error("Failed to load asset " + job.asset.filename);
+            }
+            catch (...)
+            {
+                job.exception = std::current_exception();
+            }
+
+            job.finish = nullptr;
+            job.data.reset();
+
+            if (--pendingAssetCount == 0) requestedAssetCount = 0;
+
+            LoadingBatch& batch = *job.batch;
+            if (job.exception && !batch.exception) batch.exception = job.exception;
+
+            if (--batch.remaining == 0)
+            {
+                if (batch.exception)
+                    batch.promise.set_exception(batch.exception);
+                else
+                    batch.promise.set_value();
+            }
+        }
+
+        void Bundle::update()
         {
-            auto i = textures.find(name);
+            // the jobs are finished in the order they were requested, so that the dependencies are created first
+            while (!loadingJobs.empty())
+            {
+                const auto job = loadingJobs.front();
 
-            if (i != textures.end())
-                return i->second;
+                if (!job->finished)
+                {
+                    if (job->state != LoadingJob::State::Prepared) break;
+                    finishJob(*job);
+                }
+
+                loadingJobs.pop_front();
+            }
+        }
+
+        std::shared_ptr<graphics::Texture> Bundle::getTexture(const AssetId& id) const
+        {
+            if (const auto result = textures.find(id))
+                return *result;
 
             return nullptr;
         }
 
         void Bundle::setTexture(const std::string& name, const std::shared_ptr<graphics::Texture>& texture)
         {
-            textures[name] = texture;
+            textures.insert(name) = texture;
+            cache.invalidate();
         }
 
         void Bundle::releaseTextures()
         {
             textures.clear();
+            cache.invalidate();
         }
 
-        const graphics::Shader* Bundle::getShader(const std::string& name) const
+        const graphics::Shader* Bundle::getShader(const AssetId& id) const
         {
-            auto i = shaders.find(name);
-
-            if (i != shaders.end())
-                return i->second.get();
+            if (const auto result = shaders.find(id))
+                return result->get();
 
             return nullptr;
         }
 
         void Bundle::setShader(const std::string& name, std::unique_ptr<graphics::Shader> shader)
         {
-            shaders[name] = std::move(shader);
+            shaders.insert(name) = std::move(shader);
+            cache.invalidate();
         }
 
         void Bundle::releaseShaders()
         {
             shaders.clear();
+            cache.invalidate();
         }
 
-        const graphics::BlendState* Bundle::getBlendState(const std::string& name) const
+        const graphics::BlendState* Bundle::getBlendState(const AssetId& id) const
         {
-            auto i = blendStates.find(name);
-
-            if (i != blendStates.end())
-                return i->second.get();
+            if (const auto result = blendStates.find(id))
+                return result->get();
 
             return nullptr;
         }
 
         void Bundle::setBlendState(const std::string& name, std::unique_ptr<graphics::BlendState> blendState)
         {
-            blendStates[name] = std::move(blendState);
+            blendStates.insert(name) = std::move(blendState);
+            cache.invalidate();
         }
 
         void Bundle::releaseBlendStates()
         {
             blendStates.clear();
+            cache.invalidate();
         }
 
-        const graphics::DepthStencilState* Bundle::getDepthStencilState(const std::string& name) const
+        const graphics::DepthStencilState* Bundle::getDepthStencilState(const AssetId& id) const
         {
-            auto i = depthStencilStates.find(name);
-
-            if (i != depthStencilStates.end())
-                return i->second.get();
+            if (const auto result = depthStencilStates.find(id))
+                return result->get();
 
             return nullptr;
         }
 
         void Bundle::setDepthStencilState(const std::string& name, std::unique_ptr<graphics::DepthStencilState> depthStencilState)
         {
-            depthStencilStates[name] = std::move(depthStencilState);
+            depthStencilStates.insert(name) = std::move(depthStencilState);
+            cache.invalidate();
         }
 
         void Bundle::releaseDepthStencilStates()
         {
             depthStencilStates.clear();
+            cache.invalidate();
         }
 
         void Bundle::preloadSpriteData(const std::string& filename, bool mipmaps,
@@ -183,171 +488,172 @@ namespace ouzel
 
                     newSpriteData.animations[""] = std::move(animation);
 
-                    spriteData[filename] = newSpriteData;
+                    spriteData.insert(filename) = newSpriteData;
+                    cache.invalidate();
                 }
             }
             else
                 loadAsset(Loader::Sprite, filename, filename, mipmaps);
         }
 
-        const scene::SpriteData* Bundle::getSpriteData(const std::string& name) const
+        const scene::SpriteData* Bundle::getSpriteData(const AssetId& id) const
         {
-            auto i = spriteData.find(name);
-
-            if (i != spriteData.end())
-                return &i->second;
+            if (const auto result = spriteData.find(id))
+                return result;
 
             return nullptr;
         }
 
         void Bundle::setSpriteData(const std::string& name, const scene::SpriteData& newSpriteData)
         {
-            spriteData[name] = newSpriteData;
+            spriteData.insert(name) = newSpriteData;
+            cache.invalidate();
         }
 
         void Bundle::releaseSpriteData()
         {
             spriteData.clear();
+            cache.invalidate();
         }
 
-        const scene::ParticleSystemData* Bundle::getParticleSystemData(const std::string& name) const
+        const scene::ParticleSystemData* Bundle::getParticleSystemData(const AssetId& id) const
         {
-            auto i = particleSystemData.find(name);
-
-            if (i != particleSystemData.end())
-                return &i->second;
+            if (const auto result = particleSystemData.find(id))
+                return result;
 
             return nullptr;
         }
 
         void Bundle::setParticleSystemData(const std::string& name, const scene::ParticleSystemData& newParticleSystemData)
         {
-            particleSystemData[name] = newParticleSystemData;
+            particleSystemData.insert(name) = newParticleSystemData;
+            cache.invalidate();
         }
 
         void Bundle::releaseParticleSystemData()
         {
             particleSystemData.clear();
+            cache.invalidate();
         }
 
-        const gui::Font* Bundle::getFont(const std::string& name) const
+        const gui::Font* Bundle::getFont(const AssetId& id) const
         {
-            auto i = fonts.find(name);
-
-            if (i != fonts.end())
-                return i->second.get();
+            if (const auto result = fonts.find(id))
+                return result->get();
 
             return nullptr;
         }
 
         void Bundle::setFont(const std::string& name, std::unique_ptr<gui::Font> font)
         {
-            fonts[name] = std::move(font);
+            fonts.insert(name) = std::move(font);
+            cache.invalidate();
         }
 
         void Bundle::releaseFonts()
         {
             fonts.clear();
+            cache.invalidate();
         }
 
-        const audio::Cue* Bundle::getCue(const std::string& name) const
+        const audio::Cue* Bundle::getCue(const AssetId& id) const
         {
-            auto i = cues.find(name);
-
-            if (i != cues.end())
-                return i->second.get();
+            if (const auto result = cues.find(id))
+                return result->get();
 
             return nullptr;
         }
 
         void Bundle::setCue(const std::string& name, std::unique_ptr<audio::Cue> cue)
         {
-            cues[name] = std::move(cue);
+            cues.insert(name) = std::move(cue);
+            cache.invalidate();
         }
 
         void Bundle::releaseCues()
         {
             cues.clear();
+            cache.invalidate();
         }
 
-        const audio::Sound* Bundle::getSound(const std::string& name) const
+        const audio::Sound* Bundle::getSound(const AssetId& id) const
         {
-            auto i = sounds.find(name);
-
-            if (i != sounds.end())
-                return i->second.get();
+            if (const auto result = sounds.find(id))
+                return result->get();
 
             return nullptr;
         }
 
         void Bundle::setSound(const std::string& name, std::unique_ptr<audio::Sound> sound)
         {
-            sounds[name] = std::move(sound);
+            sounds.insert(name) = std::move(sound);
+            cache.invalidate();
         }
 
         void Bundle::releaseSounds()
         {
             sounds.clear();
+            cache.invalidate();
         }
 
-        const graphics::Material* Bundle::getMaterial(const std::string& name) const
+        const graphics::Material* Bundle::getMaterial(const AssetId& id) const
         {
-            auto i = materials.find(name);
-
-            if (i != materials.end())
-                return i->second.get();
+            if (const auto result = materials.find(id))
+                return result->get();
 
             return nullptr;
         }
 
         void Bundle::setMaterial(const std::string& name, std::unique_ptr<graphics::Material> material)
         {
-            materials[name] = std::move(material);
+            materials.insert(name) = std::move(material);
+            cache.invalidate();
         }
 
         void Bundle::releaseMaterials()
         {
             materials.clear();
+            cache.invalidate();
         }
 
-        const scene::SkinnedMeshData* Bundle::getSkinnedMeshData(const std::string& name) const
+        const scene::SkinnedMeshData* Bundle::getSkinnedMeshData(const AssetId& id) const
         {
-            auto i = skinnedMeshData.find(name);
-
-            if (i != skinnedMeshData.end())
-                return &i->second;
+            if (const auto result = skinnedMeshData.find(id))
+                return result;
 
             return nullptr;
         }
 
         void Bundle::setSkinnedMeshData(const std::string& name, scene::SkinnedMeshData&& newSkinnedMeshData)
         {
-            skinnedMeshData[name] = std::move(newSkinnedMeshData);
+            skinnedMeshData.insert(name) = std::move(newSkinnedMeshData);
+            cache.invalidate();
         }
 
         void Bundle::releaseSkinnedMeshData()
         {
             skinnedMeshData.clear();
+            cache.invalidate();
         }
 
-        const scene::StaticMeshData* Bundle::getStaticMeshData(const std::string& name) const
+        const scene::StaticMeshData* Bundle::getStaticMeshData(const AssetId& id) const
         {
-            auto i = staticMeshData.find(name);
-
-            if (i != staticMeshData.end())
-                return &i->second;
+            if (const auto result = staticMeshData.find(id))
+                return result;
 
             return nullptr;
         }
 
         void Bundle::setStaticMeshData(const std::string& name, scene::StaticMeshData&& newStaticMeshData)
         {
-            staticMeshData[name] = std::move(newStaticMeshData);
+            staticMeshData.insert(name) = std::move(newStaticMeshData);
+            cache.invalidate();
         }
 
         void Bundle::releaseStaticMeshData()
         {
             staticMeshData.clear();
+            cache.invalidate();
         }
     } // namespace assets
 } // namespace ouzel
@@ -3,9 +3,12 @@
 #ifndef OUZEL_ASSETS_BUNDLE_HPP
 #define OUZEL_ASSETS_BUNDLE_HPP
 
-#include <map>
+#include <deque>
+#include <future>
 #include <memory>
 #include <string>
+#include "assets/AssetId.hpp"
+#include "assets/AssetMap.hpp"
 #include "audio/Cue.hpp"
 #include "audio/Sound.hpp"
 #include "graphics/BlendState.hpp"
@@ -19,6 +22,7 @@
 #include "scene/SpriteRenderer.hpp"
 #include "scene/ParticleSystem.hpp"
 #include "storage/FileSystem.hpp"
+#include "utils/Span.hpp"
 
 namespace ouzel
 {
@@ -64,73 +68,100 @@ namespace ouzel
             void loadAssets(const std::string& filename);
             void loadAssets(const std::vector<Asset>& assets);
 
-            std::shared_ptr<graphics::Texture> getTexture(const std::string& name) const;
+            // Reads and decodes the assets on the loader threads, the engine objects are created on the
+            // update thread in the order of the list, so an asset can depend on the ones listed before it
+            std::future<void> loadAssetsAsync(const std::string& filename);
+            std::future<void> loadAssetsAsync(const std::vector<Asset>& assets);
+
+            // Mounts a pack made by the asset cooker in the file system and loads all of the assets in it
+            void loadPack(const std::string& filename);
+            std::future<void> loadPackAsync(const std::string& filename);
+
+            static std::vector<Asset> readAssetList(Span<const uint8_t> data);
+
+            inline auto getPendingAssetCount() const noexcept { return pendingAssetCount; }
+            float getLoadingProgress() const noexcept;
+
+            std::shared_ptr<graphics::Texture> getTexture(const AssetId& id) const;
             void setTexture(const std::string& name, const std::shared_ptr<graphics::Texture>& texture);
             void releaseTextures();
 
-            const graphics::Shader* getShader(const std::string& shaderName) const;
+            const graphics::Shader* getShader(const AssetId& id) const;
             void setShader(const std::string& name, std::unique_ptr<graphics::Shader> shader);
             void releaseShaders();
 
-            const graphics::BlendState* getBlendState(const std::string& name) const;
+            const graphics::BlendState* getBlendState(const AssetId& id) const;
             void setBlendState(const std::string& name, std::unique_ptr<graphics::BlendState> blendState);
             void releaseBlendStates();
 
-            const graphics::DepthStencilState* getDepthStencilState(const std::string& name) const;
+            const graphics::DepthStencilState* getDepthStencilState(const AssetId& id) const;
             void setDepthStencilState(const std::string& name, std::unique_ptr<graphics::DepthStencilState> depthStencilState);
             void releaseDepthStencilStates();
 
             void preloadSpriteData(const std::string& filename, bool mipmaps = true,
                                    uint32_t spritesX = 1, uint32_t spritesY = 1,
                                    const Vector2F& pivot = Vector2F{0.5F, 0.5F});
-            const scene::SpriteData* getSpriteData(const std::string& name) const;
+            const scene::SpriteData* getSpriteData(const AssetId& id) const;
             void setSpriteData(const std::string& name, const scene::SpriteData& newSpriteData);
             void releaseSpriteData();
 
-            const scene::ParticleSystemData* getParticleSystemData(const std::string& name) const;
+            const scene::ParticleSystemData* getParticleSystemData(const AssetId& id) const;
             void setParticleSystemData(const std::string& name, const scene::ParticleSystemData& newParticleSystemData);
             void releaseParticleSystemData();
 
-            const gui::Font* getFont(const std::string& name) const;
+            const gui::Font* getFont(const AssetId& id) const;
             void setFont(const std::string& name, std::unique_ptr<gui::Font> font);
             void releaseFonts();
 
-            const audio::Cue* getCue(const std::string& name) const;
+            const audio::Cue* getCue(const AssetId& id) const;
             void setCue(const std::string& name, std::unique_ptr<audio::Cue> cue);
             void releaseCues();
 
-            const audio::Sound* getSound(const std::string& name) const;
+            const audio::Sound* getSound(const AssetId& id) const;
             void setSound(const std::string& name, std::unique_ptr<audio::Sound> sound);
             void releaseSounds();
 
-            const graphics::Material* getMaterial(const std::string& name) const;
+            const graphics::Material* getMaterial(const AssetId& id) const;
             void setMaterial(const std::string& name, std::unique_ptr<graphics::Material> material);
             void releaseMaterials();
 
-            const scene::SkinnedMeshData* getSkinnedMeshData(const std::string& name) const;
+            const scene::SkinnedMeshData* getSkinnedMeshData(const AssetId& id) const;
             void setSkinnedMeshData(const std::string& name, scene::SkinnedMeshData&& newSkinnedMeshData);
             void releaseSkinnedMeshData();
 
-            const scene::StaticMeshData* getStaticMeshData(const std::string& name) const;
+            const scene::StaticMeshData* getStaticMeshData(const AssetId& id) const;
             void setStaticMeshData(const std::string& name, scene::StaticMeshData&& newStaticMeshData);
             void releaseStaticMeshData();
 
         private:
+            struct LoadingBatch;
+            struct LoadingJob;
+
+            std::vector<Asset> mountPack(const std::string& filename);
+
+            static void prepareJob(LoadingJob& job);
+            void finishJob(LoadingJob& job);
+            void update();
+
             Cache& cache;
             storage::FileSystem& fileSystem;
 
-            std::map<std::string, std::shared_ptr<graphics::Texture>> textures;
-            std::map<std::string, std::unique_ptr<graphics::Shader>> shaders;
-            std::map<std::string, scene::ParticleSystemData> particleSystemData;
-            std::map<std::string, std::unique_ptr<graphics::BlendState>> blendStates;
-            std::map<std::string, std::unique_ptr<graphics::DepthStencilState>> depthStencilStates;
-            std::map<std::string, scene::SpriteData> spriteData;
-            std::map<std::string, std::unique_ptr<gui::Font>> fonts;
-            std::map<std::string, std::unique_ptr<audio::Cue>> cues;
-            std::map<std::string, std::unique_ptr<audio::Sound>> sounds;
-            std::map<std::string, std::unique_ptr<graphics::Material>> materials;
-            std::map<std::string, scene::SkinnedMeshData> skinnedMeshData;
-            std::map<std::string, scene::StaticMeshData> staticMeshData;
+            std::deque<std::shared_ptr<LoadingJob>> loadingJobs;
+            size_t requestedAssetCount = 0;
+            size_t pendingAssetCount = 0;
+
+            AssetMap<std::shared_ptr<graphics::Texture>> textures;
+            AssetMap<std::unique_ptr<graphics::Shader>> shaders;
+            AssetMap<scene::ParticleSystemData> particleSystemData;
+            AssetMap<std::unique_ptr<graphics::BlendState>> blendStates;
+            AssetMap<std::unique_ptr<graphics::DepthStencilState>> depthStencilStates;
+            AssetMap<scene::SpriteData> spriteData;
+            AssetMap<std::unique_ptr<gui::Font>> fonts;
+            AssetMap<std::unique_ptr<audio::Cue>> cues;
+            AssetMap<std::unique_ptr<audio::Sound>> sounds;
+            AssetMap<std::unique_ptr<graphics::Material>> materials;
+            AssetMap<scene::SkinnedMeshData> skinnedMeshData;
+            AssetMap<scene::StaticMeshData> staticMeshData;
         };
     } // namespace assets
 } // namespace ouzel
@@ -1,6 +1,7 @@
 // Copyright 2015-2019 Elviss Strazdins. All rights reserved.
 
 #include <algorithm>
+#include <thread>
 #include "Cache.hpp"
 #include "BmfLoader.hpp"
 #include "ColladaLoader.hpp"
@@ -36,20 +37,96 @@ namespace ouzel
             addLoader(std::make_unique<TtfLoader>(*this));
             addLoader(std::make_unique<VorbisLoader>(*this));
             addLoader(std::make_unique<WaveLoader>(*this));
+
+#if !defined(__EMSCRIPTEN__)
+            // the update, render and audio threads share the remaining cores with the loader threads
+            const unsigned int cpuCount = std::thread::hardware_concurrency();
+            const unsigned int loaderThreadCount = (cpuCount > 2) ? cpuCount - 1 : 1;
+
+            loaderThreads.reserve(loaderThreadCount);
+            for (unsigned int i = 0; i < loaderThreadCount; ++i)
+                loaderThreads.emplace_back(&Cache::runJobs, this);
+#endif
+        }
+
+        Cache::~Cache()
+        {
+            std::unique_lock<std::mutex> lock(jobMutex);
+            running = false;
+            lock.unlock();
+            jobCondition.notify_all();
+
+            for (Thread& loaderThread : loaderThreads)
+                if (loaderThread.isJoinable()) loaderThread.join();
         }
 
-        void Cache::addBundle(const Bundle* bundle)
+        void Cache::update()
+        {
+#if defined(__EMSCRIPTEN__)
+            // there are no loader threads, so the jobs are run on the update thread
+            std::unique_lock<std::mutex> lock(jobMutex);
+            while (!jobs.empty())
+            {
+                auto job = std::move(jobs.front());
+                jobs.pop();
+                lock.unlock();
+                job();
+                lock.lock();
+            }
+            lock.unlock();
+#endif
+
+            for (size_t i = 0; i < bundles.size(); ++i)
+                bundles[i]->update();
+        }
+
+        template <class Getter>
+        auto Cache::findAsset(AssetType type, const AssetId& id, Getter getter) const
+            -> decltype(getter(std::declval<const Bundle&>()))
+        {
+            auto& index = bundleIndex[static_cast<size_t>(type)];
+
+            auto i = index.find(id.getValue());
+            if (i != index.end())
+                return i->second ? getter(*i->second) : nullptr;
+
+            for (const Bundle* bundle : bundles)
+                if (auto asset = getter(*bundle))
+                {
+                    index[id.getValue()] = bundle;
+                    return asset;
+                }
+
+            index[id.getValue()] = nullptr;
+            return nullptr;
+        }
+
+        void Cache::invalidate() noexcept
+        {
+            ++generation;
+
+            for (auto& index : bundleIndex)
+                index.clear();
+        }
+
+        void Cache::addBundle(Bundle* bundle)
         {
             auto i = std::find(bundles.begin(), bundles.end(), bundle);
             if (i == bundles.end())
+            {
                 bundles.push_back(bundle);
+                invalidate();
+            }
         }
 
         void Cache::removeBundle(const Bundle* bundle)
         {
             auto i = std::find(bundles.begin(), bundles.end(), bundle);
             if (i != bundles.end())
+            {
                 bundles.erase(i);
+                invalidate();
+            }
         }
 
         void Cache::addLoader(std::unique_ptr<Loader> loader)
@@ -59,6 +136,32 @@ namespace ouzel
                 loaders.push_back(std::move(loader));
         }
 
+        void Cache::addJob(std::function<void()> job)
+        {
+            std::unique_lock<std::mutex> lock(jobMutex);
+            jobs.push(std::move(job));
+            lock.unlock();
+            jobCondition.notify_one();
+        }
+
+        void Cache::runJobs()
+        {
+            Thread::setCurrentThreadName("Asset loader");
+
+            for (;;)
+            {
+                std::unique_lock<std::mutex> lock(jobMutex);
+                jobCondition.wait(lock, [this]() { return !running || !jobs.empty(); });
+                if (!running) break;
+
+                auto job = std::move(jobs.front());
+                jobs.pop();
+                lock.unlock();
+
+                job();
+            }
+        }
+
         void Cache::removeLoader(const Loader* loader)
         {
             auto i = std::find_if(loaders.begin(), loaders.end(), [loader](const auto& ownedLoader) noexcept {
@@ -68,112 +171,148 @@ namespace ouzel
                 loaders.erase(i);
         }
 
-        std::shared_ptr<graphics::Texture> Cache::getTexture(const std::string& name) const
+        std::shared_ptr<graphics::Texture> Cache::getTexture(const AssetId& id) const
         {
-            for (const Bundle* bundle : bundles)
-                if (auto texture = bundle->getTexture(name))
-                    return texture;
+            return findAsset(AssetType::Texture, id, [&id](const Bundle& bundle) {
+                return bundle.getTexture(id);
+            });
+        }
 
-            return nullptr;
+        const graphics::Shader* Cache::getShader(const AssetId& id) const
+        {
+            return findAsset(AssetType::Shader, id, [&id](const Bundle& bundle) {
+                return bundle.getShader(id);
+            });
         }
 
-        const graphics::Shader* Cache::getShader(const std::string& name) const
+        const graphics::BlendState* Cache::getBlendState(const AssetId& id) const
         {
-            for (const Bundle* bundle : bundles)
-                if (auto shader = bundle->getShader(name))
-                    return shader;
+            return findAsset(AssetType::BlendState, id, [&id](const Bundle& bundle) {
+                return bundle.getBlendState(id);
+            });
+        }
 
-            return nullptr;
+        const graphics::DepthStencilState* Cache::getDepthStencilState(const AssetId& id) const
+        {
+            return findAsset(AssetType::DepthStencilState, id, [&id](const Bundle& bundle) {
+                return bundle.getDepthStencilState(id);
+            });
         }
 
-        const graphics::BlendState* Cache::getBlendState(const std::string& name) const
+        const scene::SpriteData* Cache::getSpriteData(const AssetId& id) const
         {
-            for (const Bundle* bundle : bundles)
-                if (auto blendState = bundle->getBlendState(name))
-                    return blendState;
+            return findAsset(AssetType::SpriteData, id, [&id](const Bundle& bundle) {
+                return bundle.getSpriteData(id);
+            });
+        }
 
-            return nullptr;
+        const scene::ParticleSystemData* Cache::getParticleSystemData(const AssetId& id) const
+        {
+            return findAsset(AssetType::ParticleSystemData, id, [&id](const Bundle& bundle) {
+                return bundle.getParticleSystemData(id);
+            });
         }
 
-        const graphics::DepthStencilState* Cache::getDepthStencilState(const std::string& name) const
+        const gui::Font* Cache::getFont(const AssetId& id) const
         {
-            for (const Bundle* bundle : bundles)
-                if (auto depthStencilState = bundle->getDepthStencilState(name))
-                    return depthStencilState;
+            return findAsset(AssetType::Font, id, [&id](const Bundle& bundle) {
+                return bundle.getFont(id);
+            });
+        }
 
-            return nullptr;
+        const audio::Cue* Cache::getCue(const AssetId& id) const
+        {
+            return findAsset(AssetType::Cue, id, [&id](const Bundle& bundle) {
+                return bundle.getCue(id);
+            });
         }
 
-        const scene::SpriteData* Cache::getSpriteData(const std::string& name) const
+        const audio::Sound* Cache::getSound(const AssetId& id) const
         {
-            for (const Bundle* bundle : bundles)
-                if (auto spriteData = bundle->getSpriteData(name))
-                    return spriteData;
+            return findAsset(AssetType::Sound, id, [&id](const Bundle& bundle) {
+                return bundle.getSound(id);
+            });
+        }
 
-            return nullptr;
+        const graphics::Material* Cache::getMaterial(const AssetId& id) const
+        {
+            return findAsset(AssetType::Material, id, [&id](const Bundle& bundle) {
+                return bundle.getMaterial(id);
+            });
         }
 
-        const scene::ParticleSystemData* Cache::getParticleSystemData(const std::string& name) const
+        const scene::SkinnedMeshData* Cache::getSkinnedMeshData(const AssetId& id) const
         {
-            for (const Bundle* bundle : bundles)
-                if (auto particleSystemData = bundle->getParticleSystemData(name))
-                    return particleSystemData;
+            return findAsset(AssetType::SkinnedMeshData, id, [&id](const Bundle& bundle) {
+                return bundle.getSkinnedMeshData(id);
+            });
+        }
 
-            return nullptr;
+        const scene::StaticMeshData* Cache::getStaticMeshData(const AssetId& id) const
+        {
+            return findAsset(AssetType::StaticMeshData, id, [&id](const Bundle& bundle) {
+                return bundle.getStaticMeshData(id);
+            });
         }
 
-        const gui::Font* Cache::getFont(const std::string& name) const
+        template <> const graphics::Texture* Cache::getAsset(const AssetId& id) const
         {
-            for (const Bundle* bundle : bundles)
-                if (auto font = bundle->getFont(name))
-                    return font;
+            return getTexture(id).get();
+        }
 
-            return nullptr;
+        template <> const graphics::Shader* Cache::getAsset(const AssetId& id) const
+        {
+            return getShader(id);
         }
 
-        const audio::Cue* Cache::getCue(const std::string& name) const
+        template <> const graphics::BlendState* Cache::getAsset(const AssetId& id) const
         {
-            for (const Bundle* bundle : bundles)
-                if (auto cue = bundle->getCue(name))
-                    return cue;
+            return getBlendState(id);
+        }
 
-            return nullptr;
+        template <> const graphics::DepthStencilState* Cache::getAsset(const AssetId& id) const
+        {
+            return getDepthStencilState(id);
         }
 
-        const audio::Sound* Cache::getSound(const std::string& name) const
+        template <> const scene::SpriteData* Cache::getAsset(const AssetId& id) const
         {
-            for (const Bundle* bundle : bundles)
-                if (auto sound = bundle->getSound(name))
-                    return sound;
+            return getSpriteData(id);
+        }
 
-            return nullptr;
+        template <> const scene::ParticleSystemData* Cache::getAsset(const AssetId& id) const
+        {
+            return getParticleSystemData(id);
         }
 
-        const graphics::Material* Cache::getMaterial(const std::string& name) const
+        template <> const gui::Font* Cache::getAsset(const AssetId& id) const
         {
-            for (const Bundle* bundle : bundles)
-                if (auto material = bundle->getMaterial(name))
-                    return material;
+            return getFont(id);
+        }
 
-            return nullptr;
+        template <> const audio::Cue* Cache::getAsset(const AssetId& id) const
+        {
+            return getCue(id);
         }
 
-        const scene::SkinnedMeshData* Cache::getSkinnedMeshData(const std::string& name) const
+        template <> const audio::Sound* Cache::getAsset(const AssetId& id) const
         {
-            for (const Bundle* bundle : bundles)
-                if (const scene::SkinnedMeshData* meshData = bundle->getSkinnedMeshData(name))
-                    return meshData;
+            return getSound(id);
+        }
 
-            return nullptr;
+        template <> const graphics::Material* Cache::getAsset(const AssetId& id) const
+        {
+            return getMaterial(id);
         }
 
-        const scene::StaticMeshData* Cache::getStaticMeshData(const std::string& name) const
+        template <> const scene::SkinnedMeshData* Cache::getAsset(const AssetId& id) const
         {
-            for (const Bundle* bundle : bundles)
-                if (const scene::StaticMeshData* meshData = bundle->getStaticMeshData(name))
-                    return meshData;
+            return getSkinnedMeshData(id);
+        }
 
-            return nullptr;
+        template <> const scene::StaticMeshData* Cache::getAsset(const AssetId& id) const
+        {
+            return getStaticMeshData(id);
         }
     } // namespace assets
 } // namespace ouzel
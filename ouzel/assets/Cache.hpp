@@ -3,9 +3,20 @@
 #ifndef OUZEL_ASSETS_CACHE_HPP
 #define OUZEL_ASSETS_CACHE_HPP
 
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <queue>
 #include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "assets/AssetId.hpp"
 #include "assets/Bundle.hpp"
+#include "utils/Thread.hpp"
 
 namespace ouzel
 {
@@ -19,6 +30,7 @@ namespace ouzel
             friend Bundle;
         public:
             Cache();
+            ~Cache();
 
             Cache(const Cache&) = delete;
             Cache& operator=(const Cache&) = delete;
@@ -29,29 +41,88 @@ namespace ouzel
             auto& getBundles() const noexcept { return bundles; }
             auto& getLoaders() const noexcept { return loaders; }
 
-            std::shared_ptr<graphics::Texture> getTexture(const std::string& name) const;
-            const graphics::Shader* getShader(const std::string& name) const;
-            const graphics::BlendState* getBlendState(const std::string& name) const;
-            const graphics::DepthStencilState* getDepthStencilState(const std::string& name) const;
-            const scene::SpriteData* getSpriteData(const std::string& name) const;
-            const scene::ParticleSystemData* getParticleSystemData(const std::string& name) const;
-            const gui::Font* getFont(const std::string& name) const;
-            const audio::Cue* getCue(const std::string& name) const;
-            const audio::Sound* getSound(const std::string& name) const;
-            const graphics::Material* getMaterial(const std::string& name) const;
-            const scene::SkinnedMeshData* getSkinnedMeshData(const std::string& name) const;
-            const scene::StaticMeshData* getStaticMeshData(const std::string& name) const;
+            std::shared_ptr<graphics::Texture> getTexture(const AssetId& id) const;
+            const graphics::Shader* getShader(const AssetId& id) const;
+            const graphics::BlendState* getBlendState(const AssetId& id) const;
+            const graphics::DepthStencilState* getDepthStencilState(const AssetId& id) const;
+            const scene::SpriteData* getSpriteData(const AssetId& id) const;
+            const scene::ParticleSystemData* getParticleSystemData(const AssetId& id) const;
+            const gui::Font* getFont(const AssetId& id) const;
+            const audio::Cue* getCue(const AssetId& id) const;
+            const audio::Sound* getSound(const AssetId& id) const;
+            const graphics::Material* getMaterial(const AssetId& id) const;
+            const scene::SkinnedMeshData* getSkinnedMeshData(const AssetId& id) const;
+            const scene::StaticMeshData* getStaticMeshData(const AssetId& id) const;
+
+            template <class T> const T* getAsset(const AssetId& id) const;
+
+            // incremented every time an asset is added to or removed from any of the bundles
+            inline auto getGeneration() const noexcept { return generation; }
+
+            // finishes the assets that the loader threads have prepared, called on the update thread
+            void update();
 
         private:
-            void addBundle(const Bundle* bundle);
+            enum class AssetType
+            {
+                Texture,
+                Shader,
+                BlendState,
+                DepthStencilState,
+                SpriteData,
+                ParticleSystemData,
+                Font,
+                Cue,
+                Sound,
+                Material,
+                SkinnedMeshData,
+                StaticMeshData,
+                Count
+            };
+
+            template <class Getter>
+            auto findAsset(AssetType type, const AssetId& id, Getter getter) const
+                -> decltype(getter(std::declval<const Bundle&>()));
+
+            // called every time the contents of the bundles change
+            void invalidate() noexcept;
+
+            void addBundle(Bundle* bundle);
             void removeBundle(const Bundle* bundle);
 
             void addLoader(std::unique_ptr<Loader> loader);
             void removeLoader(const Loader* loader);
 
-            std::vector<const Bundle*> bundles;
+            void addJob(std::function<void()> job);
+            void runJobs();
+
+            std::vector<Bundle*> bundles;
+            uint32_t generation = 0;
+
+            // the first bundle that has the asset (or null if none of them have it) for each of the looked up ids,
+            // cleared when the contents of the bundles change
+            mutable std::array<std::unordered_map<uint64_t, const Bundle*>, static_cast<size_t>(AssetType::Count)> bundleIndex;
             std::vector<std::unique_ptr<Loader>> loaders;
+
+            std::queue<std::function<void()>> jobs;
+            std::mutex jobMutex;
+            std::condition_variable jobCondition;
+            bool running = true;
+            std::vector<Thread> loaderThreads; // started after all the other members are initialized
         };
+
+        template <> const graphics::Texture* Cache::getAsset(const AssetId& id) const;
+        template <> const graphics::Shader* Cache::getAsset(const AssetId& id) const;
+        template <> const graphics::BlendState* Cache::getAsset(const AssetId& id) const;
+        template <> const graphics::DepthStencilState* Cache::getAsset(const AssetId& id) const;
+        template <> const scene::SpriteData* Cache::getAsset(const AssetId& id) const;
+        template <> const scene::ParticleSystemData* Cache::getAsset(const AssetId& id) const;
+        template <> const gui::Font* Cache::getAsset(const AssetId& id) const;
+        template <> const audio::Cue* Cache::getAsset(const AssetId& id) const;
+        template <> const audio::Sound* Cache::getAsset(const AssetId& id) const;
+        template <> const graphics::Material* Cache::getAsset(const AssetId& id) const;
+        template <> const scene::SkinnedMeshData* Cache::getAsset(const AssetId& id) const;
+        template <> const scene::StaticMeshData* Cache::getAsset(const AssetId& id) const;
     } // namespace assets
 } // namespace ouzel
 
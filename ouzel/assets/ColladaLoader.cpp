@@ -17,17 +17,20 @@ namespace ouzel
 
         bool ColladaLoader::loadAsset(Bundle& bundle,
                                       const std::string& name,
-                                      const std::vector<uint8_t>& data,
+                                      Span<const uint8_t> data,
                                       bool)
         {
-            xml::Data colladaData(data);
+            // the document is streamed, so only the root tag has to be read to identify the file
+            xml::Reader reader(data);
 
-            if (colladaData.getChildren().empty())
-                throw std::runtime_error("Invalid Collada file");
+            xml::Reader::Token token;
+            while ((token = reader.read()) != xml::Reader::Token::StartTag)
+                if (token == xml::Reader::Token::End)
+                    throw std::runtime_error("Invalid Collada file");
 
-            xml::Node rootNode = colladaData.getChildren().front();
+            const auto& rootName = reader.getName();
 
-            if (rootNode.getValue() != "COLLADA")
+            if (std::string(rootName.begin(), rootName.end()) != "COLLADA")
                 throw std::runtime_error("Invalid Collada file");
 
             scene::SkinnedMeshData meshData;
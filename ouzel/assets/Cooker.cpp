@@ -0,0 +1,152 @@
+// Copyright 2015-2019 Elviss Strazdins. All rights reserved.
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include "Cooker.hpp"
+#include "Cache.hpp"
+#include "Loader.hpp"
+#include "math/Fnv.hpp"
+#include "storage/File.hpp"
+#include "storage/FileSystem.hpp"
+#include "storage/MappedFile.hpp"
+#include "storage/Pack.hpp"
+#include "utils/Utils.hpp"
+
+namespace ouzel
+{
+    namespace assets
+    {
+        namespace
+        {
+            // the hash changes when the source file, the settings or the cooked format changes
+            uint64_t hashAsset(const Asset& asset, Span<const uint8_t> data)
+            {
+                uint8_t settings[9];
+                encodeLittleEndian<uint32_t>(settings, Cooker::VERSION);
+                encodeLittleEndian<uint32_t>(settings + 4, asset.type);
+                settings[8] = asset.mipmaps ? 1 : 0;
+
+                const uint64_t result = fnv::hash<uint64_t>(reinterpret_cast<const char*>(settings), sizeof(settings));
+                return fnv::hash<uint64_t>(reinterpret_cast<const char*>(data.data()), data.size(), result);
+            }
+        }
+
+        constexpr uint32_t Cooker::VERSION;
+
+        void Cooker::cook(const std::vector<Asset>& assets,
+                          const std::string& resourcePath,
+                          const std::string& packPath)
+        {
+            cookedAssetCount = 0;
+            reusedAssetCount = 0;
+
+            std::unique_ptr<storage::Pack> previousPack;
+
+            try
+            {
+                previousPack = std::make_unique<storage::Pack>(storage::FileView(storage::MappedFile(packPath)));
+            }
+            catch (const std::exception&)
+            {
+                // there is no pack yet or it was made by a different version, so everything is cooked
+            }
+
+            std::vector<storage::Pack::Entry> entries;
+            std::vector<Span<const uint8_t>> entryData;
+            std::vector<std::vector<uint8_t>> cookedData;
+
+            entries.reserve(assets.size());
+            entryData.reserve(assets.size());
+            cookedData.reserve(assets.size());
+
+            for (const Asset& asset : assets)
+            {
+                // an asset that is listed several times with the same type and settings is stored once,
+                // a file that is used as several asset types is cooked for each of them
+                auto duplicate = std::find_if(entries.begin(), entries.end(), [&asset](const storage::Pack::Entry& entry) {
+                    return entry.filename == asset.filename &&
+                        entry.type == asset.type &&
+                        entry.mipmaps == asset.mipmaps;
+                });
+
+                if (duplicate != entries.end())
+                {
+                    storage::Pack::Entry entry = *duplicate;
+                    entry.name = asset.name;
+                    entryData.push_back(entryData[static_cast<size_t>(duplicate - entries.begin())]);
+                    entries.push_back(std::move(entry));
+                    continue;
+                }
+
+                const storage::MappedFile source(resourcePath.empty() ? asset.filename :
+                                                 resourcePath + storage::FileSystem::DIRECTORY_SEPARATOR + asset.filename);
+                const Span<const uint8_t> sourceData(source.getData(), source.getSize());
+
+                storage::Pack::Entry entry;
+                entry.type = asset.type;
+                entry.mipmaps = asset.mipmaps;
+                entry.hash = hashAsset(asset, sourceData);
+                entry.name = asset.name;
+                entry.filename = asset.filename;
+
+                const storage::Pack::Entry* previousEntry = nullptr;
+
+                if (previousPack)
+                    for (const storage::Pack::Entry& packEntry : previousPack->getEntries())
+                        if (packEntry.filename == entry.filename &&
+                            packEntry.type == entry.type &&
+                            packEntry.mipmaps == entry.mipmaps &&
+                            packEntry.hash == entry.hash)
+                        {
+                            previousEntry = &packEntry;
+                            break;
+                        }
+
+                if (previousEntry)
+                {
+                    entryData.push_back(previousPack->getData(*previousEntry));
+                    ++reusedAssetCount;
+                }
+                else
+                {
+                    std::vector<uint8_t> data;
+
+                    const auto& loaders = cache.getLoaders();
+
+                    for (auto i = loaders.rbegin(); i != loaders.rend() && data.empty(); ++i)
+                        if ((*i)->getType() == asset.type)
+                            data = (*i)->cookAsset(sourceData, asset.mipmaps);
+
+                    // assets that none of the loaders cook are stored as they are
+                    if (data.empty())
+                        data.assign(sourceData.begin(), sourceData.end());
+
+                    cookedData.push_back(std::move(data));
+                    entryData.push_back(cookedData.back());
+                    ++cookedAssetCount;
+                }
+
+                entries.push_back(std::move(entry));
+            }
+
+            const std::vector<uint8_t> pack = storage::Pack::encode(entries, entryData);
+
+            // the previous pack is still mapped until it has been encoded
+            entryData.clear();
+            previousPack.reset();
+
+            const storage::File file(packPath, storage::File::Mode::Write |
+                                     storage::File::Mode::Create |
+                                     storage::File::Mode::Truncate);
+
+            for (size_t offset = 0; offset < pack.size();)
+            {
+                const auto size = static_cast<uint32_t>(std::min(pack.size() - offset,
+                                                                 static_cast<size_t>(std::numeric_limits<uint32_t>::max())));
+                offset += file.write(pack.data() + offset, size, true);
+            }
+        }
+    } // namespace assets
+} // namespace ouzel
@@ -0,0 +1,44 @@
+// Copyright 2015-2019 Elviss Strazdins. All rights reserved.
+
+#ifndef OUZEL_ASSETS_COOKER_HPP
+#define OUZEL_ASSETS_COOKER_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "assets/Bundle.hpp"
+
+namespace ouzel
+{
+    namespace assets
+    {
+        class Cache;
+
+        // Converts the assets with the loaders of the cache to the form that the loaders can load
+        // without parsing or decoding them and writes them to a pack
+        class Cooker final
+        {
+        public:
+            // incremented when the cooked data of any of the loaders changes
+            static constexpr uint32_t VERSION = 1;
+
+            explicit Cooker(Cache& initCache): cache(initCache) {}
+
+            // The source files are read relative to the resource path. Assets whose source file and settings
+            // have not changed are copied from the pack that is already at the pack path.
+            void cook(const std::vector<Asset>& assets,
+                      const std::string& resourcePath,
+                      const std::string& packPath);
+
+            inline auto getCookedAssetCount() const noexcept { return cookedAssetCount; }
+            inline auto getReusedAssetCount() const noexcept { return reusedAssetCount; }
+
+        private:
+            Cache& cache;
+            size_t cookedAssetCount = 0;
+            size_t reusedAssetCount = 0;
+        };
+    } // namespace assets
+} // namespace ouzel
+
+#endif // OUZEL_ASSETS_COOKER_HPP
@@ -114,7 +114,7 @@ namespace ouzel
 
         bool CueLoader::loadAsset(Bundle& bundle,
                                   const std::string& name,
-                                  const std::vector<uint8_t>& data,
+                                  Span<const uint8_t> data,
                                   bool)
         {
             audio::SourceDefinition sourceDefinition;
@@ -0,0 +1,58 @@
+// Copyright 2015-2019 Elviss Strazdins. All rights reserved.
+
+#ifndef OUZEL_ASSETS_HANDLE_HPP
+#define OUZEL_ASSETS_HANDLE_HPP
+
+#include <cstdint>
+#include "assets/AssetId.hpp"
+#include "assets/Cache.hpp"
+
+namespace ouzel
+{
+    namespace assets
+    {
+        // Reference to an asset in the cache, the asset is looked up only after the contents
+        // of the cache have changed since the last lookup
+        template <class T>
+        class Handle final
+        {
+        public:
+            Handle() noexcept = default;
+
+            Handle(const Cache& initCache, const AssetId& initId) noexcept:
+                cache(&initCache), id(initId)
+            {
+            }
+
+            const T* get() const
+            {
+                if (!cache) return nullptr;
+
+                const auto currentGeneration = cache->getGeneration();
+                if (!resolved || generation != currentGeneration)
+                {
+                    asset = cache->template getAsset<T>(id);
+                    generation = currentGeneration;
+                    resolved = true;
+                }
+
+                return asset;
+            }
+
+            inline auto& getId() const noexcept { return id; }
+
+            inline const T* operator->() const { return get(); }
+            inline const T& operator*() const { return *get(); }
+            explicit inline operator bool() const { return get() != nullptr; }
+
+        private:
+            const Cache* cache = nullptr;
+            AssetId id;
+            mutable const T* asset = nullptr;
+            mutable uint32_t generation = 0;
+            mutable bool resolved = false;
+        };
+    } // namespace assets
+} // namespace ouzel
+
+#endif // OUZEL_ASSETS_HANDLE_HPP
@@ -5,7 +5,6 @@
 #include "ImageLoader.hpp"
 #include "Bundle.hpp"
 #include "core/Engine.hpp"
-#include "graphics/Image.hpp"
 #include "graphics/Texture.hpp"
 
 #if defined(_MSC_VER)
@@ -46,120 +45,206 @@ namespace ouzel
 {
     namespace assets
     {
-        ImageLoader::ImageLoader(Cache& initCache):
-            Loader(initCache, Loader::Image)
+        namespace
         {
-        }
+            constexpr uint32_t COOKED_SIGNATURE = 0x4F544558; // "OTEX"
 
-        bool ImageLoader::loadAsset(Bundle& bundle,
-                                    const std::string& name,
-                                    const std::vector<uint8_t>& data,
-                                    bool mipmaps)
-        {
-            int width;
-            int height;
-            int comp;
+            enum CookedKey: uint32_t
+            {
+                Width,
+                Height,
+                Format,
+                Levels,
+                Data
+            };
+
+            struct DecodedImage final
+            {
+                Size2U size;
+                graphics::PixelFormat pixelFormat = graphics::PixelFormat::RGBA8UNorm;
+                std::vector<std::pair<Size2U, std::vector<uint8_t>>> levels;
+            };
+
+            DecodedImage decodeImage(Span<const uint8_t> data, bool mipmaps)
+            {
+                int width;
+                int height;
+                int comp;
 
-            stbi_uc* tempData = stbi_load_from_memory(data.data(), static_cast<int>(data.size()), &width, &height, &comp, STBI_default);
+                stbi_uc* tempData = stbi_load_from_memory(data.data(), static_cast<int>(data.size()), &width, &height, &comp, STBI_default);
 
-            if (!tempData)
-                throw std::runtime_error("Failed to load texture, reason: " + std::string(stbi_failure_reason()));
+                if (!tempData)
+                    throw std::runtime_error("Failed to load texture, reason: " + std::string(stbi_failure_reason()));
 
-            graphics::PixelFormat pixelFormat;
-            std::vector<uint8_t> imageData;
+                graphics::PixelFormat pixelFormat;
+                std::vector<uint8_t> imageData;
 
-            switch (comp)
-            {
-                case STBI_grey:
+                switch (comp)
                 {
-                    pixelFormat = graphics::PixelFormat::RGBA8UNorm;
+                    case STBI_grey:
+                    {
+                        pixelFormat = graphics::PixelFormat::RGBA8UNorm;
 
-                    imageData.resize(static_cast<size_t>(width * height * 4));
+                        imageData.resize(static_cast<size_t>(width * height * 4));
 
-                    for (int y = 0; y < height; ++y)
-                    {
-                        for (int x = 0; x < width; ++x)
+                        for (int y = 0; y < height; ++y)
                         {
-                            const auto sourceOffset = static_cast<size_t>(y * width + x);
-                            const auto destinationOffset = static_cast<size_t>((y * width + x) * 4);
-                            imageData[destinationOffset + 0] = tempData[sourceOffset];
-                            imageData[destinationOffset + 1] = tempData[sourceOffset];
-                            imageData[destinationOffset + 2] = tempData[sourceOffset];
-                            imageData[destinationOffset + 3] = 255;
+                            for (int x = 0; x < width; ++x)
+                            {
+                                const auto sourceOffset = static_cast<size_t>(y * width + x);
+                                const auto destinationOffset = static_cast<size_t>((y * width + x) * 4);
+                                imageData[destinationOffset + 0] = tempData[sourceOffset];
+                                imageData[destinationOffset + 1] = tempData[sourceOffset];
+                                imageData[destinationOffset + 2] = tempData[sourceOffset];
+                                imageData[destinationOffset + 3] = 255;
+                            }
                         }
+                        stbi_image_free(tempData);
+                        break;
                     }
-                    stbi_image_free(tempData);
-                    break;
-                }
-                case STBI_grey_alpha:
-                {
-                    pixelFormat = graphics::PixelFormat::RGBA8UNorm;
+                    case STBI_grey_alpha:
+                    {
+                        pixelFormat = graphics::PixelFormat::RGBA8UNorm;
 
-                    imageData.resize(static_cast<size_t>(width * height * 4));
+                        imageData.resize(static_cast<size_t>(width * height * 4));
 
-                    for (int y = 0; y < height; ++y)
-                    {
-                        for (int x = 0; x < width; ++x)
+                        for (int y = 0; y < height; ++y)
                         {
-                            const auto sourceOffset = static_cast<size_t>((y * width + x) * 2);
-                            const auto destinationOffset = static_cast<size_t>((y * width + x) * 4);
-                            imageData[destinationOffset + 0] = tempData[sourceOffset + 0];
-                            imageData[destinationOffset + 1] = tempData[sourceOffset + 0];
-                            imageData[destinationOffset + 2] = tempData[sourceOffset + 0];
-                            imageData[destinationOffset + 3] = tempData[sourceOffset + 1];
+                            for (int x = 0; x < width; ++x)
+                            {
+                                const auto sourceOffset = static_cast<size_t>((y * width + x) * 2);
+                                const auto destinationOffset = static_cast<size_t>((y * width + x) * 4);
+                                imageData[destinationOffset + 0] = tempData[sourceOffset + 0];
+                                imageData[destinationOffset + 1] = tempData[sourceOffset + 0];
+                                imageData[destinationOffset + 2] = tempData[sourceOffset + 0];
+                                imageData[destinationOffset + 3] = tempData[sourceOffset + 1];
+                            }
                         }
+                        stbi_image_free(tempData);
+                        break;
                     }
-                    stbi_image_free(tempData);
-                    break;
-                }
-                case STBI_rgb:
-                {
-                    pixelFormat = graphics::PixelFormat::RGBA8UNorm;
+                    case STBI_rgb:
+                    {
+                        pixelFormat = graphics::PixelFormat::RGBA8UNorm;
 
-                    imageData.resize(static_cast<size_t>(width * height * 4));
+                        imageData.resize(static_cast<size_t>(width * height * 4));
 
-                    for (int y = 0; y < height; ++y)
-                    {
-                        for (int x = 0; x < width; ++x)
+                        for (int y = 0; y < height; ++y)
                         {
-                            const auto sourceOffset = static_cast<size_t>((y * width + x) * 3);
-                            const auto destinationOffset = static_cast<size_t>((y * width + x) * 4);
-                            imageData[destinationOffset + 0] = tempData[sourceOffset + 0];
-                            imageData[destinationOffset + 1] = tempData[sourceOffset + 1];
-                            imageData[destinationOffset + 2] = tempData[sourceOffset + 2];
-                            imageData[destinationOffset + 3] = 255;
+                            for (int x = 0; x < width; ++x)
+                            {
+                                const auto sourceOffset = static_cast<size_t>((y * width + x) * 3);
+                                const auto destinationOffset = static_cast<size_t>((y * width + x) * 4);
+                                imageData[destinationOffset + 0] = tempData[sourceOffset + 0];
+                                imageData[destinationOffset + 1] = tempData[sourceOffset + 1];
+                                imageData[destinationOffset + 2] = tempData[sourceOffset + 2];
+                                imageData[destinationOffset + 3] = 255;
+                            }
                         }
+                        stbi_image_free(tempData);
+                        break;
+                    }
+                    case STBI_rgb_alpha:
+                    {
+                        pixelFormat = graphics::PixelFormat::RGBA8UNorm;
+                        imageData.assign(tempData,
+                                         tempData + static_cast<size_t>(width * height) * 4);
+                        stbi_image_free(tempData);
+                        break;
                     }
-                    stbi_image_free(tempData);
-                    break;
+                    default:
+                        stbi_image_free(tempData);
+                        throw std::runtime_error("Unsupported pixel format");
                 }
-                case STBI_rgb_alpha:
+
+                const Size2U size(static_cast<uint32_t>(width), static_cast<uint32_t>(height));
+
+                // the mip levels are generated here, only the texture is created on the update thread
+                auto levels = graphics::Texture::generateLevels(size, imageData, mipmaps ? 0 : 1, pixelFormat);
+
+                return DecodedImage{size, pixelFormat, std::move(levels)};
+            }
+
+            DecodedImage readCookedImage(const obf::View& value)
+            {
+                DecodedImage image;
+                image.size = Size2U(value.at(Width).as<uint32_t>(), value.at(Height).as<uint32_t>());
+                image.pixelFormat = static_cast<graphics::PixelFormat>(value.at(Format).as<uint32_t>());
+
+                const obf::View levels = value.at(Levels);
+                if (levels.getType() != obf::Value::Type::Array)
+                    throw std::runtime_error("Invalid cooked texture");
+
+                image.levels.reserve(levels.getSize());
+
+                for (const obf::View level : levels)
                 {
-                    pixelFormat = graphics::PixelFormat::RGBA8UNorm;
-                    imageData.assign(tempData,
-                                     tempData + static_cast<size_t>(width * height) * 4);
-                    stbi_image_free(tempData);
-                    break;
+                    const auto levelData = level.at(Data).as<Span<const uint8_t>>();
+                    image.levels.emplace_back(Size2U(level.at(Width).as<uint32_t>(), level.at(Height).as<uint32_t>()),
+                                              std::vector<uint8_t>(levelData.begin(), levelData.end()));
                 }
-                default:
-                    stbi_image_free(tempData);
-                    throw std::runtime_error("Unsupported pixel format");
+
+                if (image.levels.empty())
+                    throw std::runtime_error("Invalid cooked texture");
+
+                return image;
             }
+        }
 
-            graphics::Image image(pixelFormat,
-                                  Size2U(static_cast<uint32_t>(width),
-                                         static_cast<uint32_t>(height)),
-                                  imageData);
+        ImageLoader::ImageLoader(Cache& initCache):
+            Loader(initCache, Loader::Image)
+        {
+        }
+
+        bool ImageLoader::loadAsset(Bundle& bundle,
+                                    const std::string& name,
+                                    Span<const uint8_t> data,
+                                    bool mipmaps)
+        {
+            const auto finish = prepareAsset(name, data, mipmaps);
+            return finish && finish(bundle);
+        }
+
+        std::function<bool(Bundle&)> ImageLoader::prepareAsset(const std::string& name,
+                                                               Span<const uint8_t> data,
+                                                               bool mipmaps)
+        {
+            // cooked textures already have all of their mip levels
+            const obf::View cookedValue = decodeCookedData(COOKED_SIGNATURE, data);
+            DecodedImage image = cookedValue.isNull() ? decodeImage(data, mipmaps) : readCookedImage(cookedValue);
 
-            auto texture = std::make_shared<graphics::Texture>(*engine->getRenderer(),
-                                                               image.getData(),
-                                                               image.getSize(), 0,
-                                                               mipmaps ? 0 : 1,
-                                                               image.getPixelFormat());
+            return [name, image = std::move(image)](Bundle& bundle) {
+                auto texture = std::make_shared<graphics::Texture>(*engine->getRenderer(),
+                                                                   image.levels,
+                                                                   image.size, 0,
+                                                                   image.pixelFormat);
 
-            bundle.setTexture(name, texture);
+                bundle.setTexture(name, texture);
 
-            return true;
+                return true;
+            };
+        }
+
+        std::vector<uint8_t> ImageLoader::cookAsset(Span<const uint8_t> data, bool mipmaps)
+        {
+            const DecodedImage image = decodeImage(data, mipmaps);
+
+            obf::Value::Array levels;
+            levels.reserve(image.levels.size());
+
+            for (const auto& level : image.levels)
+                levels.push_back(obf::Value::Object{
+                    {Width, level.first.v[0]},
+                    {Height, level.first.v[1]},
+                    {Data, level.second}
+                });
+
+            return encodeCookedData(COOKED_SIGNATURE, obf::Value::Object{
+                {Width, image.size.v[0]},
+                {Height, image.size.v[1]},
+                {Format, static_cast<uint32_t>(image.pixelFormat)},
+                {Levels, levels}
+            });
         }
     } // namespace assets
 } // namespace ouzel
@@ -3,8 +3,14 @@
 #ifndef OUZEL_ASSETS_LOADER_HPP
 #define OUZEL_ASSETS_LOADER_HPP
 
+#include <functional>
+#include <memory>
 #include <string>
 #include <vector>
+#include "storage/FileView.hpp"
+#include "utils/Obf.hpp"
+#include "utils/Span.hpp"
+#include "utils/Utils.hpp"
 
 namespace ouzel
 {
@@ -47,10 +53,67 @@ namespace ouzel
 
             virtual bool loadAsset(Bundle& bundle,
                                    const std::string& name,
-                                   const std::vector<uint8_t>& data,
+                                   Span<const uint8_t> data,
                                    bool mipmaps = true) = 0;
 
+            // Called on a worker thread to decode the data, the returned function is called on the update
+            // thread to create the engine objects and add them to the bundle. The data stays valid until then.
+            // Returns an empty function if the loader does not support the data. Loaders that do not override
+            // this do all of the work on the update thread.
+            virtual std::function<bool(Bundle&)> prepareAsset(const std::string& name,
+                                                              Span<const uint8_t> data,
+                                                              bool mipmaps = true)
+            {
+                return [this, name, data, mipmaps](Bundle& bundle) {
+                    return loadAsset(bundle, name, data, mipmaps);
+                };
+            }
+
+            // Loaders that keep reading the data after the asset has been loaded (e.g. to stream it) override
+            // these to share the ownership of the file view, the others load the asset from a span of it
+            virtual bool loadSharedAsset(Bundle& bundle,
+                                         const std::string& name,
+                                         const std::shared_ptr<const storage::FileView>& data,
+                                         bool mipmaps = true)
+            {
+                return loadAsset(bundle, name, *data, mipmaps);
+            }
+
+            virtual std::function<bool(Bundle&)> prepareSharedAsset(const std::string& name,
+                                                                    const std::shared_ptr<const storage::FileView>& data,
+                                                                    bool mipmaps = true)
+            {
+                return prepareAsset(name, *data, mipmaps);
+            }
+
+            // Called by the asset cooker to convert the data to a form that the loader can load without
+            // parsing or decoding it. Returns an empty buffer if the loader does not cook the data.
+            virtual std::vector<uint8_t> cookAsset(Span<const uint8_t>, bool = true)
+            {
+                return std::vector<uint8_t>();
+            }
+
         protected:
+            // cooked data starts with a signature of the loader followed by an OBF value
+            static std::vector<uint8_t> encodeCookedData(uint32_t signature, const obf::Value& value)
+            {
+                std::vector<uint8_t> result(sizeof(signature));
+                encodeBigEndian<uint32_t>(result.data(), signature);
+                value.encode(result);
+                return result;
+            }
+
+            // returns a null view if the data was not cooked by the loader
+            static obf::View decodeCookedData(uint32_t signature, Span<const uint8_t> data)
+            {
+                if (data.size() <= sizeof(signature) ||
+                    decodeBigEndian<uint32_t>(data.data()) != signature)
+                    return obf::View();
+
+                return obf::View(Span<const uint8_t>(data.data() + sizeof(signature),
+                                                     data.size() - sizeof(signature)));
+            }
+
             Cache& cache;
             uint32_t type;
         };
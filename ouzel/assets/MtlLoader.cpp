@@ -29,8 +29,8 @@ namespace ouzel
                 return c <= 0x1F;
             }
 
-            void skipWhitespaces(std::vector<uint8_t>::const_iterator& iterator,
-                                 std::vector<uint8_t>::const_iterator end)
+            void skipWhitespaces(const uint8_t*& iterator,
+                                 const uint8_t* end)
             {
                 while (iterator != end)
                     if (isWhitespace(*iterator))
@@ -39,8 +39,8 @@ namespace ouzel
                         break;
             }
 
-            void skipLine(std::vector<uint8_t>::const_iterator& iterator,
-                          std::vector<uint8_t>::const_iterator end)
+            void skipLine(const uint8_t*& iterator,
+                          const uint8_t* end)
             {
                 while (iterator != end)
                 {
@@ -54,8 +54,8 @@ namespace ouzel
                 }
             }
 
-            std::string parseString(std::vector<uint8_t>::const_iterator& iterator,
-                                    std::vector<uint8_t>::const_iterator end)
+            std::string parseString(const uint8_t*& iterator,
+                                    const uint8_t* end)
             {
                 std::string result;
 
@@ -71,8 +71,8 @@ namespace ouzel
                 return result;
             }
 
-            float parseFloat(std::vector<uint8_t>::const_iterator& iterator,
-                             std::vector<uint8_t>::const_iterator end)
+            float parseFloat(const uint8_t*& iterator,
+                             const uint8_t* end)
             {
                 std::string value;
                 uint32_t length = 1;
@@ -118,7 +118,7 @@ namespace ouzel
 
         bool MtlLoader::loadAsset(Bundle& bundle,
                                   const std::string& name,
-                                  const std::vector<uint8_t>& data,
+                                  Span<const uint8_t> data,
                                   bool mipmaps)
         {
             std::string materialName = name;
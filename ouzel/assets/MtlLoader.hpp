@@ -15,7 +15,7 @@ namespace ouzel
             explicit MtlLoader(Cache& initCache);
             bool loadAsset(Bundle& bundle,
                            const std::string& name,
-                           const std::vector<uint8_t>& data,
+                           Span<const uint8_t> data,
                            bool mipmaps = true) final;
         };
     } // namespace assets
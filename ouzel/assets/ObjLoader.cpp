@@ -9,6 +9,7 @@
 #include "Bundle.hpp"
 #include "Cache.hpp"
 #include "graphics/Material.hpp"
+#include "utils/Utils.hpp"
 
 namespace ouzel
 {
@@ -31,8 +32,8 @@ namespace ouzel
                 return c <= 0x1F;
             }
 
-            void skipWhitespaces(std::vector<uint8_t>::const_iterator& iterator,
-                                 std::vector<uint8_t>::const_iterator end)
+            void skipWhitespaces(const uint8_t*& iterator,
+                                 const uint8_t* end)
             {
                 while (iterator != end)
                     if (isWhitespace(*iterator))
@@ -41,8 +42,8 @@ namespace ouzel
                         break;
             }
 
-            void skipLine(std::vector<uint8_t>::const_iterator& iterator,
-                          std::vector<uint8_t>::const_iterator end)
+            void skipLine(const uint8_t*& iterator,
+                          const uint8_t* end)
             {
                 while (iterator != end)
                 {
@@ -56,8 +57,8 @@ namespace ouzel
                 }
             }
 
-            std::string parseString(std::vector<uint8_t>::const_iterator& iterator,
-                                    std::vector<uint8_t>::const_iterator end)
+            std::string parseString(const uint8_t*& iterator,
+                                    const uint8_t* end)
             {
                 std::string result;
 
@@ -74,8 +75,8 @@ namespace ouzel
                 return result;
             }
 
-            int32_t parseInt32(std::vector<uint8_t>::const_iterator& iterator,
-                               std::vector<uint8_t>::const_iterator end)
+            int32_t parseInt32(const uint8_t*& iterator,
+                               const uint8_t* end)
             {
                 std::string value;
                 uint32_t length = 1;
@@ -99,8 +100,8 @@ namespace ouzel
                 return std::stoi(value);
             }
 
-            float parseFloat(std::vector<uint8_t>::const_iterator& iterator,
-                             std::vector<uint8_t>::const_iterator end)
+            float parseFloat(const uint8_t*& iterator,
+                             const uint8_t* end)
             {
                 std::string value;
                 uint32_t length = 1;
@@ -138,8 +139,8 @@ namespace ouzel
                 return std::stof(value);
             }
 
-            bool parseToken(const std::vector<uint8_t>& str,
-                            std::vector<uint8_t>::const_iterator& iterator,
+            bool parseToken(Span<const uint8_t> str,
+                            const uint8_t*& iterator,
                             char token)
             {
                 if (iterator == str.end() || *iterator != static_cast<uint8_t>(token)) return false;
@@ -148,243 +149,439 @@ namespace ouzel
 
                 return true;
             }
-        }
 
-        ObjLoader::ObjLoader(Cache& initCache):
-            Loader(initCache, Loader::StaticMesh)
-        {
-        }
+            struct Object final
+            {
+                std::string name;
+                std::string materialName;
+                Box3F boundingBox;
+                std::vector<uint32_t> indices;
+                std::vector<graphics::Vertex> vertices;
+            };
+
+            struct Mesh final
+            {
+                std::vector<std::string> materialLibraries;
+                std::vector<Object> objects;
+            };
 
-        bool ObjLoader::loadAsset(Bundle& bundle,
-                                  const std::string& name,
-                                  const std::vector<uint8_t>& data,
-                                  bool mipmaps)
-        {
-            std::string objectName = name;
-            const graphics::Material* material = nullptr;
-            std::vector<Vector3F> positions;
-            std::vector<Vector2F> texCoords;
-            std::vector<Vector3F> normals;
-            std::vector<graphics::Vertex> vertices;
-            std::map<std::tuple<uint32_t, uint32_t, uint32_t>, uint32_t> vertexMap;
-            std::vector<uint32_t> indices;
-            Box3F boundingBox;
+            constexpr uint32_t COOKED_SIGNATURE = 0x4F4D5348; // "OMSH"
 
-            uint32_t objectCount = 0;
+            enum CookedKey: uint32_t
+            {
+                MaterialLibraries,
+                Objects,
+                ObjectName,
+                MaterialName,
+                BoundingBoxMin,
+                BoundingBoxMax,
+                Indices,
+                Vertices
+            };
+
+            // position, color, two sets of texture coordinates and normal
+            constexpr size_t COOKED_VERTEX_SIZE = 3 * sizeof(float) + 4 + 2 * 2 * sizeof(float) + 3 * sizeof(float);
+
+            obf::Value::ByteArray encodeVector(const Vector3F& vector)
+            {
+                obf::Value::ByteArray result(3 * sizeof(float));
+                for (size_t i = 0; i < 3; ++i)
+                    encodeLittleEndian<float>(result.data() + i * sizeof(float), vector.v[i]);
+                return result;
+            }
 
-            auto iterator = data.cbegin();
+            Vector3F decodeVector(Span<const uint8_t> data)
+            {
+                if (data.size() != 3 * sizeof(float))
+                    throw std::runtime_error("Invalid cooked mesh");
 
-            std::string keyword;
-            std::string value;
+                return Vector3F(decodeLittleEndian<float>(data.data()),
+                                decodeLittleEndian<float>(data.data() + sizeof(float)),
+                                decodeLittleEndian<float>(data.data() + 2 * sizeof(float)));
+            }
 
-            while (iterator != data.end())
+            obf::Value::ByteArray encodeVertices(const std::vector<graphics::Vertex>& vertices)
             {
-                if (isNewline(*iterator))
+                obf::Value::ByteArray result(vertices.size() * COOKED_VERTEX_SIZE);
+                uint8_t* buffer = result.data();
+
+                const auto encodeFloats = [&buffer](const float* values, size_t count) {
+                    for (size_t i = 0; i < count; ++i, buffer += sizeof(float))
+                        encodeLittleEndian<float>(buffer, values[i]);
+                };
+
+                for (const graphics::Vertex& vertex : vertices)
                 {
-                    // skip empty lines
-                    ++iterator;
+                    encodeFloats(vertex.position.v, 3);
+                    for (size_t i = 0; i < 4; ++i) *buffer++ = vertex.color.v[i];
+                    encodeFloats(vertex.texCoords[0].v, 2);
+                    encodeFloats(vertex.texCoords[1].v, 2);
+                    encodeFloats(vertex.normal.v, 3);
                 }
-                else if (*iterator == '#')
+
+                return result;
+            }
+
+            std::vector<graphics::Vertex> decodeVertices(Span<const uint8_t> data)
+            {
+                if (data.size() % COOKED_VERTEX_SIZE)
+                    throw std::runtime_error("Invalid cooked mesh");
+
+                std::vector<graphics::Vertex> result(data.size() / COOKED_VERTEX_SIZE);
+                const uint8_t* buffer = data.data();
+
+                const auto decodeFloats = [&buffer](float* values, size_t count) {
+                    for (size_t i = 0; i < count; ++i, buffer += sizeof(float))
+                        values[i] = decodeLittleEndian<float>(buffer);
+                };
+
+                for (graphics::Vertex& vertex : result)
                 {
-                    // skip the comment
-                    skipLine(iterator, data.end());
+                    decodeFloats(vertex.position.v, 3);
+                    for (size_t i = 0; i < 4; ++i) vertex.color.v[i] = *buffer++;
+                    decodeFloats(vertex.texCoords[0].v, 2);
+                    decodeFloats(vertex.texCoords[1].v, 2);
+                    decodeFloats(vertex.normal.v, 3);
                 }
-                else
-                {
-                    skipWhitespaces(iterator, data.end());
-                    keyword = parseString(iterator, data.end());
 
-                    if (keyword == "mtllib")
+                return result;
+            }
+
+            Mesh readCookedMesh(const obf::View& value)
+            {
+                Mesh mesh;
+
+                const obf::View materialLibraries = value.at(MaterialLibraries);
+                const obf::View objects = value.at(Objects);
+                if (materialLibraries.getType() != obf::Value::Type::Array ||
+                    objects.getType() != obf::Value::Type::Array)
+                    throw std::runtime_error("Invalid cooked mesh");
+
+                for (const obf::View materialLibrary : materialLibraries)
+                    mesh.materialLibraries.push_back(materialLibrary.as<std::string>());
+
+                mesh.objects.reserve(objects.getSize());
+
+                for (const obf::View objectValue : objects)
+                {
+                    Object object;
+                    object.name = objectValue.at(ObjectName).as<std::string>();
+                    object.materialName = objectValue.at(MaterialName).as<std::string>();
+                    object.boundingBox = Box3F(decodeVector(objectValue.at(BoundingBoxMin).as<Span<const uint8_t>>()),
+                                               decodeVector(objectValue.at(BoundingBoxMax).as<Span<const uint8_t>>()));
+                    object.vertices = decodeVertices(objectValue.at(Vertices).as<Span<const uint8_t>>());
+
+                    const auto indices = objectValue.at(Indices).as<Span<const uint8_t>>();
+                    object.indices.resize(indices.size() / sizeof(uint32_t));
+                    for (size_t i = 0; i < object.indices.size(); ++i)
                     {
-                        skipWhitespaces(iterator, data.end());
-                        value = parseString(iterator, data.end());
+                        object.indices[i] = decodeLittleEndian<uint32_t>(indices.data() + i * sizeof(uint32_t));
+                        if (object.indices[i] >= object.vertices.size())
+                            throw std::runtime_error("Invalid cooked mesh");
+                    }
 
-                        skipLine(iterator, data.end());
+                    mesh.objects.push_back(std::move(object));
+                }
+
+                return mesh;
+            }
 
-                        //if (!cache.getMaterial(filename))
-                        // TODO don't load material lib every time
-                        bundle.loadAsset(Loader::Material, value, value, mipmaps);
+            Mesh parseMesh(Span<const uint8_t> data)
+            {
+                Mesh mesh;
+                std::string objectName; // the first object is named after the asset if it has no name
+                std::string materialName;
+                std::vector<Vector3F> positions;
+                std::vector<Vector2F> texCoords;
+                std::vector<Vector3F> normals;
+                std::vector<graphics::Vertex> vertices;
+                std::map<std::tuple<uint32_t, uint32_t, uint32_t>, uint32_t> vertexMap;
+                std::vector<uint32_t> indices;
+                Box3F boundingBox;
+
+                uint32_t objectCount = 0;
+
+                auto iterator = data.cbegin();
+
+                std::string keyword;
+                std::string value;
+
+                while (iterator != data.end())
+                {
+                    if (isNewline(*iterator))
+                    {
+                        // skip empty lines
+                        ++iterator;
                     }
-                    else if (keyword == "usemtl")
+                    else if (*iterator == '#')
                     {
-                        skipWhitespaces(iterator, data.end());
-                        value = parseString(iterator, data.end());
-
+                        // skip the comment
                         skipLine(iterator, data.end());
-
-                        material = cache.getMaterial(value);
                     }
-                    else if (keyword == "o")
+                    else
                     {
-                        if (objectCount)
-                        {
-                            scene::StaticMeshData meshData(boundingBox, indices, vertices, material);
-                            bundle.setStaticMeshData(objectName, std::move(meshData));
-                        }
-
                         skipWhitespaces(iterator, data.end());
-                        objectName = parseString(iterator, data.end());
+                        keyword = parseString(iterator, data.end());
 
-                        skipLine(iterator, data.end());
+                        if (keyword == "mtllib")
+                        {
+                            skipWhitespaces(iterator, data.end());
+                            value = parseString(iterator, data.end());
 
-                        material = nullptr;
-                        vertices.clear();
-                        indices.clear();
-                        vertexMap.clear();
-                        boundingBox.reset();
-                        ++objectCount;
-                    }
-                    else if (keyword == "v")
-                    {
-                        Vector3F position;
+                            skipLine(iterator, data.end());
 
-                        skipWhitespaces(iterator, data.end());
-                        position.v[0] = parseFloat(iterator, data.end());
-                        skipWhitespaces(iterator, data.end());
-                        position.v[1] = parseFloat(iterator, data.end());
-                        skipWhitespaces(iterator, data.end());
-                        position.v[2] = parseFloat(iterator, data.end());
+                            mesh.materialLibraries.push_back(value);
+                        }
+                        else if (keyword == "usemtl")
+                        {
+                            skipWhitespaces(iterator, data.end());
+                            value = parseString(iterator, data.end());
 
-                        skipLine(iterator, data.end());
+                            skipLine(iterator, data.end());
 
-                        positions.push_back(position);
-                    }
-                    else if (keyword == "vt")
-                    {
-                        Vector2F texCoord;
+                            materialName = value;
+                        }
+                        else if (keyword == "o")
+                        {
+                            if (objectCount)
+                                mesh.objects.push_back(Object{objectName, materialName, boundingBox,
+                                                              std::move(indices), std::move(vertices)});
 
-                        skipWhitespaces(iterator, data.end());
-                        texCoord.v[0] = parseFloat(iterator, data.end());
-                        skipWhitespaces(iterator, data.end());
-                        texCoord.v[1] = parseFloat(iterator, data.end());
+                            skipWhitespaces(iterator, data.end());
+                            objectName = parseString(iterator, data.end());
 
-                        skipLine(iterator, data.end());
+                            skipLine(iterator, data.end());
 
-                        texCoords.push_back(texCoord);
-                    }
-                    else if (keyword == "vn")
-                    {
-                        Vector3F normal;
+                            materialName.clear();
+                            vertices.clear();
+                            indices.clear();
+                            vertexMap.clear();
+                            boundingBox.reset();
+                            ++objectCount;
+                        }
+                        else if (keyword == "v")
+                        {
+                            Vector3F position;
 
-                        skipWhitespaces(iterator, data.end());
-                        normal.v[0] = parseFloat(iterator, data.end());
-                        skipWhitespaces(iterator, data.end());
-                        normal.v[1] = parseFloat(iterator, data.end());
-                        skipWhitespaces(iterator, data.end());
-                        normal.v[2] = parseFloat(iterator, data.end());
+                            skipWhitespaces(iterator, data.end());
+                            position.v[0] = parseFloat(iterator, data.end());
+                            skipWhitespaces(iterator, data.end());
+                            position.v[1] = parseFloat(iterator, data.end());
+                            skipWhitespaces(iterator, data.end());
+                            position.v[2] = parseFloat(iterator, data.end());
 
-                        skipLine(iterator, data.end());
+                            skipLine(iterator, data.end());
 
-                        normals.push_back(normal);
-                    }
-                    else if (keyword == "f")
-                    {
-                        std::vector<uint32_t> vertexIndices;
+                            positions.push_back(position);
+                        }
+                        else if (keyword == "vt")
+                        {
+                            Vector2F texCoord;
 
-                        auto i = std::make_tuple<uint32_t, uint32_t, uint32_t>(0, 0, 0);
-                        int32_t positionIndex = 0;
-                        int32_t texCoordIndex = 0;
-                        int32_t normalIndex = 0;
+                            skipWhitespaces(iterator, data.end());
+                            texCoord.v[0] = parseFloat(iterator, data.end());
+                            skipWhitespaces(iterator, data.end());
+                            texCoord.v[1] = parseFloat(iterator, data.end());
+
+                            skipLine(iterator, data.end());
 
-                        while (iterator != data.end())
+                            texCoords.push_back(texCoord);
+                        }
+                        else if (keyword == "vn")
                         {
-                            if (isNewline(*iterator)) break;
+                            Vector3F normal;
 
                             skipWhitespaces(iterator, data.end());
-                            positionIndex = parseInt32(iterator, data.end());
+                            normal.v[0] = parseFloat(iterator, data.end());
+                            skipWhitespaces(iterator, data.end());
+                            normal.v[1] = parseFloat(iterator, data.end());
+                            skipWhitespaces(iterator, data.end());
+                            normal.v[2] = parseFloat(iterator, data.end());
 
-                            if (positionIndex < 0)
-                                positionIndex = static_cast<int32_t>(positions.size()) + positionIndex + 1;
+                            skipLine(iterator, data.end());
 
-                            if (positionIndex < 1 || positionIndex > static_cast<int32_t>(positions.size()))
-                                throw std::runtime_error("Invalid position index");
+                            normals.push_back(normal);
+                        }
+                        else if (keyword == "f")
+                        {
+                            std::vector<uint32_t> vertexIndices;
 
-                            std::get<0>(i) = static_cast<uint32_t>(positionIndex);
+                            auto i = std::make_tuple<uint32_t, uint32_t, uint32_t>(0, 0, 0);
+                            int32_t positionIndex = 0;
+                            int32_t texCoordIndex = 0;
+                            int32_t normalIndex = 0;
 
-                            // has texture coordinates
-                            if (parseToken(data, iterator, '/'))
+                            while (iterator != data.end())
                             {
-                                // two slashes in a row indicates no texture coordinates
-                                if (iterator != data.end() && *iterator != '/')
-                                {
-                                    texCoordIndex = parseInt32(iterator, data.end());
+                                if (isNewline(*iterator)) break;
 
-                                    if (texCoordIndex < 0)
-                                        texCoordIndex = static_cast<int32_t>(texCoords.size()) + texCoordIndex + 1;
+                                skipWhitespaces(iterator, data.end());
+                                positionIndex = parseInt32(iterator, data.end());
 
-                                    if (texCoordIndex < 1 || texCoordIndex > static_cast<int32_t>(texCoords.size()))
-                                        throw std::runtime_error("Invalid texture coordinate index");
+                                if (positionIndex < 0)
+                                    positionIndex = static_cast<int32_t>(positions.size()) + positionIndex + 1;
 
-                                    std::get<1>(i) = static_cast<uint32_t>(texCoordIndex);
-                                }
+                                if (positionIndex < 1 || positionIndex > static_cast<int32_t>(positions.size()))
+                                    throw std::runtime_error("Invalid position index");
 
-                                // has normal
+                                std::get<0>(i) = static_cast<uint32_t>(positionIndex);
+
+                                // has texture coordinates
                                 if (parseToken(data, iterator, '/'))
                                 {
-                                    normalIndex = parseInt32(iterator, data.end());
+                                    // two slashes in a row indicates no texture coordinates
+                                    if (iterator != data.end() && *iterator != '/')
+                                    {
+                                        texCoordIndex = parseInt32(iterator, data.end());
+
+                                        if (texCoordIndex < 0)
+                                            texCoordIndex = static_cast<int32_t>(texCoords.size()) + texCoordIndex + 1;
+
+                                        if (texCoordIndex < 1 || texCoordIndex > static_cast<int32_t>(texCoords.size()))
+                                            throw std::runtime_error("Invalid texture coordinate index");
+
+                                        std::get<1>(i) = static_cast<uint32_t>(texCoordIndex);
+                                    }
+
+                                    // has normal
+                                    if (parseToken(data, iterator, '/'))
+                                    {
+                                        normalIndex = parseInt32(iterator, data.end());
 
-                                    if (normalIndex < 0)
-                                        normalIndex = static_cast<int32_t>(normals.size()) + normalIndex + 1;
+                                        if (normalIndex < 0)
+                                            normalIndex = static_cast<int32_t>(normals.size()) + normalIndex + 1;
 
-                                    if (normalIndex < 1 || normalIndex > static_cast<int32_t>(normals.size()))
-                                        throw std::runtime_error("Invalid normal index");
+                                        if (normalIndex < 1 || normalIndex > static_cast<int32_t>(normals.size()))
+                                            throw std::runtime_error("Invalid normal index");
 
-                                    std::get<2>(i) = static_cast<uint32_t>(normalIndex);
+                                        std::get<2>(i) = static_cast<uint32_t>(normalIndex);
+                                    }
                                 }
-                            }
 
-                            uint32_t index = 0;
+                                uint32_t index = 0;
 
-                            auto vertexIterator = vertexMap.find(i);
-                            if (vertexIterator == vertexMap.end())
-                            {
-                                index = static_cast<uint32_t>(vertices.size());
-                                vertexMap[i] = index;
-
-                                graphics::Vertex vertex;
-                                if (std::get<0>(i) >= 1) vertex.position = positions[std::get<0>(i) - 1];
-                                if (std::get<1>(i) >= 1) vertex.texCoords[0] = texCoords[std::get<1>(i) - 1];
-                                vertex.color = Color::white();
-                                if (std::get<2>(i) >= 1) vertex.normal = normals[std::get<2>(i) - 1];
-                                vertices.push_back(vertex);
-                                boundingBox.insertPoint(vertex.position);
+                                auto vertexIterator = vertexMap.find(i);
+                                if (vertexIterator == vertexMap.end())
+                                {
+                                    index = static_cast<uint32_t>(vertices.size());
+                                    vertexMap[i] = index;
+
+                                    graphics::Vertex vertex;
+                                    if (std::get<0>(i) >= 1) vertex.position = positions[std::get<0>(i) - 1];
+                                    if (std::get<1>(i) >= 1) vertex.texCoords[0] = texCoords[std::get<1>(i) - 1];
+                                    vertex.color = Color::white();
+                                    if (std::get<2>(i) >= 1) vertex.normal = normals[std::get<2>(i) - 1];
+                                    vertices.push_back(vertex);
+                                    boundingBox.insertPoint(vertex.position);
+                                }
+                                else
+                                    index = vertexIterator->second;
+
+                                vertexIndices.push_back(index);
                             }
-                            else
-                                index = vertexIterator->second;
 
-                            vertexIndices.push_back(index);
+                            if (vertexIndices.size() < 3)
+                                throw std::runtime_error("Invalid face count");
+                            else if (vertexIndices.size() == 3)
+                                for (const uint32_t vertexIndex : vertexIndices)
+                                    indices.push_back(vertexIndex);
+                            else
+                                for (uint32_t index = 0; index < vertexIndices.size() - 2; ++index)
+                                {
+                                    indices.push_back(vertexIndices[0]);
+                                    indices.push_back(vertexIndices[index + 1]);
+                                    indices.push_back(vertexIndices[index + 2]);
+                                }
                         }
-
-                        if (vertexIndices.size() < 3)
-                            throw std::runtime_error("Invalid face count");
-                        else if (vertexIndices.size() == 3)
-                            for (const uint32_t vertexIndex : vertexIndices)
-                                indices.push_back(vertexIndex);
                         else
-                            for (uint32_t index = 0; index < vertexIndices.size() - 2; ++index)
-                            {
-                                indices.push_back(vertexIndices[0]);
-                                indices.push_back(vertexIndices[index + 1]);
-                                indices.push_back(vertexIndices[index + 2]);
-                            }
-                    }
-                    else
-                    {
-                        // skip all unknown commands
-                        skipLine(iterator, data.end());
-                    }
+                        {
+                            // skip all unknown commands
+                            skipLine(iterator, data.end());
+                        }
 
-                    if (!objectCount) ++objectCount; // if we got at least one attribute, we have an object
+                        if (!objectCount) ++objectCount; // if we got at least one attribute, we have an object
+                    }
                 }
+
+                if (objectCount)
+                    mesh.objects.push_back(Object{objectName, materialName, boundingBox,
+                                                  std::move(indices), std::move(vertices)});
+
+                return mesh;
             }
+        }
+
+        ObjLoader::ObjLoader(Cache& initCache):
+            Loader(initCache, Loader::StaticMesh)
+        {
+        }
+
+        bool ObjLoader::loadAsset(Bundle& bundle,
+                                  const std::string& name,
+                                  Span<const uint8_t> data,
+                                  bool mipmaps)
+        {
+            const auto finish = prepareAsset(name, data, mipmaps);
+            return finish && finish(bundle);
+        }
+
+        std::function<bool(Bundle&)> ObjLoader::prepareAsset(const std::string& name,
+                                                             Span<const uint8_t> data,
+                                                             bool mipmaps)
+        {
+            const obf::View cookedValue = decodeCookedData(COOKED_SIGNATURE, data);
+            Mesh mesh = cookedValue.isNull() ? parseMesh(data) : readCookedMesh(cookedValue);
+
+            // the file is parsed here, the material libraries and the meshes are created on the update thread
+            return [this, name, mipmaps, mesh = std::move(mesh)](Bundle& bundle) {
+                // TODO don't load material lib every time
+                for (const std::string& materialLibrary : mesh.materialLibraries)
+                    bundle.loadAsset(Loader::Material, materialLibrary, materialLibrary, mipmaps);
+
+                for (const Object& object : mesh.objects)
+                {
+                    const graphics::Material* material = object.materialName.empty() ?
+                        nullptr : cache.getMaterial(object.materialName);
+
+                    scene::StaticMeshData meshData(object.boundingBox, object.indices, object.vertices, material);
+                    bundle.setStaticMeshData(object.name.empty() ? name : object.name, std::move(meshData));
+                }
+
+                return true;
+            };
+        }
+
+        std::vector<uint8_t> ObjLoader::cookAsset(Span<const uint8_t> data, bool)
+        {
+            const Mesh mesh = parseMesh(data);
+
+            obf::Value::Array materialLibraries;
+            for (const std::string& materialLibrary : mesh.materialLibraries)
+                materialLibraries.push_back(materialLibrary);
+
+            obf::Value::Array objects;
+            objects.reserve(mesh.objects.size());
 
-            if (objectCount)
+            for (const Object& object : mesh.objects)
             {
-                scene::StaticMeshData meshData(boundingBox, indices, vertices, material);
-                bundle.setStaticMeshData(objectName, std::move(meshData));
+                obf::Value::ByteArray indices(object.indices.size() * sizeof(uint32_t));
+                for (size_t i = 0; i < object.indices.size(); ++i)
+                    encodeLittleEndian<uint32_t>(indices.data() + i * sizeof(uint32_t), object.indices[i]);
+
+                objects.push_back(obf::Value::Object{
+                    {ObjectName, object.name},
+                    {MaterialName, object.materialName},
+                    {BoundingBoxMin, encodeVector(object.boundingBox.min)},
+                    {BoundingBoxMax, encodeVector(object.boundingBox.max)},
+                    {Indices, indices},
+                    {Vertices, encodeVertices(object.vertices)}
+                });
             }
 
-            return true;
+            return encodeCookedData(COOKED_SIGNATURE, obf::Value::Object{
+                {MaterialLibraries, materialLibraries},
+                {Objects, objects}
+            });
         }
     } // namespace assets
 } // namespace ouzel
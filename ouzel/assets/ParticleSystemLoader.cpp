@@ -10,6 +10,117 @@ namespace ouzel
 {
     namespace assets
     {
+        namespace
+        {
+            // reads the flat particle system description without building a DOM
+            class ParticleSystemHandler final: public json::Handler
+            {
+            public:
+                explicit ParticleSystemHandler(scene::ParticleSystemData& initData): data(initData) {}
+
+                void key(const std::string& newKey) { currentKey = newKey; }
+
+                void startObject() { ++depth; }
+                void endObject() { --depth; }
+                void startArray() { ++depth; }
+                void endArray() { --depth; }
+
+                void boolean(bool value) { setNumber(value ? 1.0 : 0.0); }
+                void integer(int64_t value) { setNumber(static_cast<double>(value)); }
+                void floatingPoint(double value) { setNumber(value); }
+
+                void string(const std::string& value)
+                {
+                    if (depth != 1) return;
+
+                    if (currentKey == "configName")
+                    {
+                        data.name = value;
+                        hasConfigName = true;
+                    }
+                    else if (currentKey == "textureFileName")
+                        textureFileName = value;
+                }
+
+                bool hasConfigName = false;
+                std::string textureFileName;
+                bool valid = true;
+
+            private:
+                void setNumber(double value)
+                {
+                    if (depth != 1) return;
+
+                    if (currentKey == "emitterType")
+                    {
+                        switch (static_cast<uint32_t>(value))
+                        {
+                            case 0: data.emitterType = scene::ParticleSystemData::EmitterType::Gravity; break;
+                            case 1: data.emitterType = scene::ParticleSystemData::EmitterType::Radius; break;
+                            default: valid = false;
+                        }
+                    }
+                    else if (currentKey == "blendFuncSource") data.blendFuncSource = static_cast<uint32_t>(value);
+                    else if (currentKey == "blendFuncDestination") data.blendFuncDestination = static_cast<uint32_t>(value);
+                    else if (currentKey == "maxParticles") data.maxParticles = static_cast<uint32_t>(value);
+                    else if (currentKey == "duration") data.duration = static_cast<float>(value);
+                    else if (currentKey == "particleLifespan") data.particleLifespan = static_cast<float>(value);
+                    else if (currentKey == "particleLifespanVariance") data.particleLifespanVariance = static_cast<float>(value);
+                    else if (currentKey == "speed") data.speed = static_cast<float>(value);
+                    else if (currentKey == "speedVariance") data.speedVariance = static_cast<float>(value);
+                    else if (currentKey == "absolutePosition") data.absolutePosition = (value != 0.0);
+                    else if (currentKey == "yCoordFlipped") data.yCoordFlipped = (static_cast<uint32_t>(value) == 1);
+                    else if (currentKey == "sourcePositionx") data.sourcePosition.v[0] = static_cast<float>(value);
+                    else if (currentKey == "sourcePositiony") data.sourcePosition.v[1] = static_cast<float>(value);
+                    else if (currentKey == "sourcePositionVariancex") data.sourcePositionVariance.v[0] = static_cast<float>(value);
+                    else if (currentKey == "sourcePositionVariancey") data.sourcePositionVariance.v[1] = static_cast<float>(value);
+                    else if (currentKey == "startParticleSize") data.startParticleSize = static_cast<float>(value);
+                    else if (currentKey == "startParticleSizeVariance") data.startParticleSizeVariance = static_cast<float>(value);
+                    else if (currentKey == "finishParticleSize") data.finishParticleSize = static_cast<float>(value);
+                    else if (currentKey == "finishParticleSizeVariance") data.finishParticleSizeVariance = static_cast<float>(value);
+                    else if (currentKey == "angle") data.angle = static_cast<float>(value);
+                    else if (currentKey == "angleVariance") data.angleVariance = static_cast<float>(value);
+                    else if (currentKey == "rotationStart") data.startRotation = static_cast<float>(value);
+                    else if (currentKey == "rotationStartVariance") data.startRotationVariance = static_cast<float>(value);
+                    else if (currentKey == "rotationEnd") data.finishRotation = static_cast<float>(value);
+                    else if (currentKey == "rotationEndVariance") data.finishRotationVariance = static_cast<float>(value);
+                    else if (currentKey == "rotatePerSecond") data.rotatePerSecond = static_cast<float>(value);
+                    else if (currentKey == "rotatePerSecondVariance") data.rotatePerSecondVariance = static_cast<float>(value);
+                    else if (currentKey == "minRadius") data.minRadius = static_cast<float>(value);
+                    else if (currentKey == "minRadiusVariance") data.minRadiusVariance = static_cast<float>(value);
+                    else if (currentKey == "maxRadius") data.maxRadius = static_cast<float>(value);
+                    else if (currentKey == "maxRadiusVariance") data.maxRadiusVariance = static_cast<float>(value);
+                    else if (currentKey == "radialAcceleration") data.radialAcceleration = static_cast<float>(value);
+                    else if (currentKey == "radialAccelVariance") data.radialAccelVariance = static_cast<float>(value);
+                    else if (currentKey == "tangentialAcceleration") data.tangentialAcceleration = static_cast<float>(value);
+                    else if (currentKey == "tangentialAccelVariance") data.tangentialAccelVariance = static_cast<float>(value);
+                    else if (currentKey == "rotationIsDir") data.rotationIsDir = (value != 0.0);
+                    else if (currentKey == "gravityx") data.gravity.v[0] = static_cast<float>(value);
+                    else if (currentKey == "gravityy") data.gravity.v[1] = static_cast<float>(value);
+                    else if (currentKey == "startColorRed") data.startColorRed = static_cast<float>(value);
+                    else if (currentKey == "startColorGreen") data.startColorGreen = static_cast<float>(value);
+                    else if (currentKey == "startColorBlue") data.startColorBlue = static_cast<float>(value);
+                    else if (currentKey == "startColorAlpha") data.startColorAlpha = static_cast<float>(value);
+                    else if (currentKey == "startColorVarianceRed") data.startColorRedVariance = static_cast<float>(value);
+                    else if (currentKey == "startColorVarianceGreen") data.startColorGreenVariance = static_cast<float>(value);
+                    else if (currentKey == "startColorVarianceBlue") data.startColorBlueVariance = static_cast<float>(value);
+                    else if (currentKey == "startColorVarianceAlpha") data.startColorAlphaVariance = static_cast<float>(value);
+                    else if (currentKey == "finishColorRed") data.finishColorRed = static_cast<float>(value);
+                    else if (currentKey == "finishColorGreen") data.finishColorGreen = static_cast<float>(value);
+                    else if (currentKey == "finishColorBlue") data.finishColorBlue = static_cast<float>(value);
+                    else if (currentKey == "finishColorAlpha") data.finishColorAlpha = static_cast<float>(value);
+                    else if (currentKey == "finishColorVarianceRed") data.finishColorRedVariance = static_cast<float>(value);
+                    else if (currentKey == "finishColorVarianceGreen") data.finishColorGreenVariance = static_cast<float>(value);
+                    else if (currentKey == "finishColorVarianceBlue") data.finishColorBlueVariance = static_cast<float>(value);
+                    else if (currentKey == "finishColorVarianceAlpha") data.finishColorAlphaVariance = static_cast<float>(value);
+                }
+
+                scene::ParticleSystemData& data;
+                uint32_t depth = 0;
+                std::string currentKey;
+            };
+        }
+
         ParticleSystemLoader::ParticleSystemLoader(Cache& initCache):
             Loader(initCache, Loader::ParticleSystem)
         {
@@ -17,100 +128,32 @@ namespace ouzel
 
         bool ParticleSystemLoader::loadAsset(Bundle& bundle,
                                              const std::string& name,
-                                             const std::vector<uint8_t>& data,
+                                             Span<const uint8_t> data,
                                              bool mipmaps)
         {
-            scene::ParticleSystemData particleSystemData;
+            const auto finish = prepareAsset(name, data, mipmaps);
+            return finish && finish(bundle);
+        }
 
-            const json::Data d(data);
+        std::function<bool(Bundle&)> ParticleSystemLoader::prepareAsset(const std::string& name,
+                                                                        Span<const uint8_t> data,
+                                                                        bool mipmaps)
+        {
+            scene::ParticleSystemData particleSystemData;
 
-            if (!d.hasMember("textureFileName") ||
-                !d.hasMember("configName"))
-                return false;
+            ParticleSystemHandler handler(particleSystemData);
+            json::parse(data, handler);
 
-            particleSystemData.name = d["configName"].as<std::string>();
+            if (handler.textureFileName.empty() ||
+                !handler.hasConfigName ||
+                !handler.valid)
+                return nullptr;
 
-            if (d.hasMember("blendFuncSource")) particleSystemData.blendFuncSource = d["blendFuncSource"].as<uint32_t>();
-            if (d.hasMember("blendFuncDestination")) particleSystemData.blendFuncDestination = d["blendFuncDestination"].as<uint32_t>();
+            particleSystemData.emissionRate = static_cast<float>(particleSystemData.maxParticles) / particleSystemData.particleLifespan;
 
-            if (d.hasMember("emitterType"))
-            {
-                switch (d["emitterType"].as<uint32_t>())
-                {
-                    case 0: particleSystemData.emitterType = scene::ParticleSystemData::EmitterType::Gravity; break;
-                    case 1: particleSystemData.emitterType = scene::ParticleSystemData::EmitterType::Radius; break;
-                    default: return false;
-                }
-            }
-
-            if (d.hasMember("maxParticles")) particleSystemData.maxParticles = d["maxParticles"].as<uint32_t>();
-
-            if (d.hasMember("duration")) particleSystemData.duration = d["duration"].as<float>();
-            if (d.hasMember("particleLifespan")) particleSystemData.particleLifespan = d["particleLifespan"].as<float>();
-            if (d.hasMember("particleLifespanVariance")) particleSystemData.particleLifespanVariance = d["particleLifespanVariance"].as<float>();
-
-            if (d.hasMember("speed")) particleSystemData.speed = d["speed"].as<float>();
-            if (d.hasMember("speedVariance")) particleSystemData.speedVariance = d["speedVariance"].as<float>();
-
-            if (d.hasMember("absolutePosition")) particleSystemData.absolutePosition = d["absolutePosition"].as<bool>();
-
-            if (d.hasMember("yCoordFlipped")) particleSystemData.yCoordFlipped = (d["yCoordFlipped"].as<uint32_t>() == 1);
-
-            if (d.hasMember("sourcePositionx")) particleSystemData.sourcePosition.v[0] = d["sourcePositionx"].as<float>();
-            if (d.hasMember("sourcePositiony")) particleSystemData.sourcePosition.v[1] = d["sourcePositiony"].as<float>();
-            if (d.hasMember("sourcePositionVariancex")) particleSystemData.sourcePositionVariance.v[0] = d["sourcePositionVariancex"].as<float>();
-            if (d.hasMember("sourcePositionVariancey")) particleSystemData.sourcePositionVariance.v[1] = d["sourcePositionVariancey"].as<float>();
-
-            if (d.hasMember("startParticleSize")) particleSystemData.startParticleSize = d["startParticleSize"].as<float>();
-            if (d.hasMember("startParticleSizeVariance")) particleSystemData.startParticleSizeVariance = d["startParticleSizeVariance"].as<float>();
-            if (d.hasMember("finishParticleSize")) particleSystemData.finishParticleSize = d["finishParticleSize"].as<float>();
-            if (d.hasMember("finishParticleSizeVariance")) particleSystemData.finishParticleSizeVariance = d["finishParticleSizeVariance"].as<float>();
-            if (d.hasMember("angle")) particleSystemData.angle = d["angle"].as<float>();
-            if (d.hasMember("angleVariance")) particleSystemData.angleVariance = d["angleVariance"].as<float>();
-            if (d.hasMember("rotationStart")) particleSystemData.startRotation = d["rotationStart"].as<float>();
-            if (d.hasMember("rotationStartVariance")) particleSystemData.startRotationVariance = d["rotationStartVariance"].as<float>();
-            if (d.hasMember("rotationEnd")) particleSystemData.finishRotation = d["rotationEnd"].as<float>();
-            if (d.hasMember("rotationEndVariance")) particleSystemData.finishRotationVariance = d["rotationEndVariance"].as<float>();
-            if (d.hasMember("rotatePerSecond")) particleSystemData.rotatePerSecond = d["rotatePerSecond"].as<float>();
-            if (d.hasMember("rotatePerSecondVariance")) particleSystemData.rotatePerSecondVariance = d["rotatePerSecondVariance"].as<float>();
-            if (d.hasMember("minRadius")) particleSystemData.minRadius = d["minRadius"].as<float>();
-            if (d.hasMember("minRadiusVariance")) particleSystemData.minRadiusVariance = d["minRadiusVariance"].as<float>();
-            if (d.hasMember("maxRadius")) particleSystemData.maxRadius = d["maxRadius"].as<float>();
-            if (d.hasMember("maxRadiusVariance")) particleSystemData.maxRadiusVariance = d["maxRadiusVariance"].as<float>();
-
-            if (d.hasMember("radialAcceleration")) particleSystemData.radialAcceleration = d["radialAcceleration"].as<float>();
-            if (d.hasMember("radialAccelVariance")) particleSystemData.radialAccelVariance = d["radialAccelVariance"].as<float>();
-            if (d.hasMember("tangentialAcceleration")) particleSystemData.tangentialAcceleration = d["tangentialAcceleration"].as<float>();
-            if (d.hasMember("tangentialAccelVariance")) particleSystemData.tangentialAccelVariance = d["tangentialAccelVariance"].as<float>();
-
-            if (d.hasMember("rotationIsDir")) particleSystemData.rotationIsDir = d["rotationIsDir"].as<bool>();
-
-            if (d.hasMember("gravityx")) particleSystemData.gravity.v[0] = d["gravityx"].as<float>();
-            if (d.hasMember("gravityy")) particleSystemData.gravity.v[1] = d["gravityy"].as<float>();
-
-            if (d.hasMember("startColorRed")) particleSystemData.startColorRed = d["startColorRed"].as<float>();
-            if (d.hasMember("startColorGreen")) particleSystemData.startColorGreen = d["startColorGreen"].as<float>();
-            if (d.hasMember("startColorBlue")) particleSystemData.startColorBlue = d["startColorBlue"].as<float>();
-            if (d.hasMember("startColorAlpha")) particleSystemData.startColorAlpha = d["startColorAlpha"].as<float>();
-
-            if (d.hasMember("startColorVarianceRed")) particleSystemData.startColorRedVariance = d["startColorVarianceRed"].as<float>();
-            if (d.hasMember("startColorVarianceGreen")) particleSystemData.startColorGreenVariance = d["startColorVarianceGreen"].as<float>();
-            if (d.hasMember("startColorVarianceBlue")) particleSystemData.startColorBlueVariance = d["startColorVarianceBlue"].as<float>();
-            if (d.hasMember("startColorVarianceAlpha")) particleSystemData.startColorAlphaVariance = d["startColorVarianceAlpha"].as<float>();
-
-            if (d.hasMember("finishColorRed")) particleSystemData.finishColorRed = d["finishColorRed"].as<float>();
-            if (d.hasMember("finishColorGreen")) particleSystemData.finishColorGreen = d["finishColorGreen"].as<float>();
-            if (d.hasMember("finishColorBlue")) particleSystemData.finishColorBlue = d["finishColorBlue"].as<float>();
-            if (d.hasMember("finishColorAlpha")) particleSystemData.finishColorAlpha = d["finishColorAlpha"].as<float>();
-
-            if (d.hasMember("finishColorVarianceRed")) particleSystemData.finishColorRedVariance = d["finishColorVarianceRed"].as<float>();
-            if (d.hasMember("finishColorVarianceGreen")) particleSystemData.finishColorGreenVariance = d["finishColorVarianceGreen"].as<float>();
-            if (d.hasMember("finishColorVarianceBlue")) particleSystemData.finishColorBlueVariance = d["finishColorVarianceBlue"].as<float>();
-            if (d.hasMember("finishColorVarianceAlpha")) particleSystemData.finishColorAlphaVariance = d["finishColorVarianceAlpha"].as<float>();
-
-            if (d.hasMember("textureFileName"))
-            {
-                auto textureFileName = d["textureFileName"].as<std::string>();
+            // only the texture is resolved on the update thread
+            return [this, name, mipmaps, particleSystemData,
+                    textureFileName = handler.textureFileName](Bundle& bundle) mutable {
                 particleSystemData.texture = cache.getTexture(textureFileName);
 
                 if (!particleSystemData.texture)
@@ -118,13 +161,11 @@ namespace ouzel
                     bundle.loadAsset(Loader::Image, textureFileName, textureFileName, mipmaps);
                     particleSystemData.texture = cache.getTexture(textureFileName);
                 }
-            }
-
-            particleSystemData.emissionRate = static_cast<float>(particleSystemData.maxParticles) / particleSystemData.particleLifespan;
 
-            bundle.setParticleSystemData(name, particleSystemData);
+                bundle.setParticleSystemData(name, particleSystemData);
 
-            return true;
+                return true;
+            };
         }
     } // namespace assets
 } // namespace ouzel
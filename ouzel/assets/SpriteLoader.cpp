@@ -1,135 +1,467 @@
 // Copyright 2015-2019 Elviss Strazdins. All rights reserved.
 
 #include <algorithm>
+#include <stdexcept>
 #include "SpriteLoader.hpp"
 #include "Bundle.hpp"
 #include "Cache.hpp"
 #include "scene/SpriteRenderer.hpp"
 #include "utils/Json.hpp"
+#include "utils/Utils.hpp"
 
 namespace ouzel
 {
     namespace assets
     {
-        SpriteLoader::SpriteLoader(Cache& initCache):
-            Loader(initCache, Loader::Sprite)
+        namespace
         {
-        }
+            struct FrameDescription final
+            {
+                enum Members
+                {
+                    Rectangle = 0x01,
+                    SourceSize = 0x02,
+                    SpriteSourceSize = 0x04,
+                    Pivot = 0x08,
+                    Rotated = 0x10,
+                    Vertices = 0x20,
+                    VerticesUV = 0x40,
+                    Triangles = 0x80,
+
+                    Required = Rectangle | SourceSize | SpriteSourceSize | Pivot,
+                    Mesh = Vertices | VerticesUV | Triangles
+                };
+
+                std::string filename;
+                RectF frameRectangle;
+                Size2F sourceSize;
+                Vector2F sourceOffset;
+                Vector2F pivot;
+                bool rotated = false;
+                std::vector<uint16_t> indices;
+                std::vector<Vector2F> vertices; // in pixels
+                std::vector<Vector2F> verticesUV; // in pixels
+                uint32_t members = 0;
+            };
+
+            // collects the frames of the sprite sheet without building a DOM
+            class SpriteSheetHandler final: public json::Handler
+            {
+            public:
+                void key(const std::string& newKey) { currentKey = newKey; }
 
-        bool SpriteLoader::loadAsset(Bundle& bundle,
-                                     const std::string& name,
-                                     const std::vector<uint8_t>& data,
-                                     bool mipmaps)
-        {
-            scene::SpriteData spriteData;
+                void startObject()
+                {
+                    ++depth;
+
+                    if (depth == 2 && currentKey == "meta")
+                        hasMeta = inMeta = true;
+                    else if (depth == 2 && currentKey == "frames")
+                        throw json::TypeError("Wrong type");
+                    else if (depth == 3 && inFrames)
+                    {
+                        frames.emplace_back();
+                        inFrame = true;
+                    }
+                    else if (depth == 4 && inFrame)
+                        startContainer();
+                }
+
+                void endObject()
+                {
+                    if (depth == 2) inMeta = false;
+                    else if (depth == 3 && inFrame)
+                    {
+                        inFrame = false;
+
+                        const FrameDescription& frame = frames.back();
+
+                        if ((frame.members & FrameDescription::Required) != FrameDescription::Required ||
+                            ((frame.members & FrameDescription::Mesh) != FrameDescription::Mesh &&
+                             !(frame.members & FrameDescription::Rotated)))
+                            throw json::RangeError("Member does not exist");
+                    }
+
+                    --depth;
+                }
+
+                void startArray()
+                {
+                    ++depth;
+
+                    if (depth == 2 && currentKey == "frames")
+                        hasFrames = inFrames = true;
+                    else if (depth == 4 && inFrame)
+                        startContainer();
+                    else if (depth == 5 && inFrame)
+                        elementIndex = 0;
+                }
 
-            const json::Data d(data);
+                void endArray()
+                {
+                    if (depth == 2) inFrames = false;
+                    else if (depth == 5 && inFrame &&
+                             (container == FrameDescription::Vertices || container == FrameDescription::VerticesUV))
+                    {
+                        if (elementIndex < 2)
+                            throw json::RangeError("Index out of range");
+
+                        FrameDescription& frame = frames.back();
+                        if (container == FrameDescription::Vertices)
+                            frame.vertices.push_back(point);
+                        else
+                            frame.verticesUV.push_back(point);
+                    }
+
+                    --depth;
+                }
+
+                void boolean(bool value) { setNumber(value ? 1.0 : 0.0); }
+                void integer(int64_t value) { setNumber(static_cast<double>(value)); }
+                void floatingPoint(double value) { setNumber(value); }
+
+                void string(const std::string& value)
+                {
+                    if (depth == 2 && inMeta && currentKey == "image")
+                        imageFilename = value;
+                    else if (depth == 3 && inFrame && currentKey == "filename")
+                        frames.back().filename = value;
+                }
+
+                bool hasMeta = false;
+                bool hasFrames = false;
+                std::string imageFilename;
+                std::vector<FrameDescription> frames;
+
+            private:
+                void startContainer()
+                {
+                    if (currentKey == "frame") container = FrameDescription::Rectangle;
+                    else if (currentKey == "sourceSize") container = FrameDescription::SourceSize;
+                    else if (currentKey == "spriteSourceSize") container = FrameDescription::SpriteSourceSize;
+                    else if (currentKey == "pivot") container = FrameDescription::Pivot;
+                    else if (currentKey == "vertices") container = FrameDescription::Vertices;
+                    else if (currentKey == "verticesUV") container = FrameDescription::VerticesUV;
+                    else if (currentKey == "triangles") container = FrameDescription::Triangles;
+                    else container = 0;
+
+                    frames.back().members |= container;
+                }
 
-            if (!d.hasMember("meta") ||
-                !d.hasMember("frames"))
-                return false;
+                void setNumber(double value)
+                {
+                    if (!inFrame) return;
+
+                    FrameDescription& frame = frames.back();
 
-            const json::Value& metaObject = d["meta"];
+                    // the coordinates are in whole pixels
+                    const auto pixels = static_cast<float>(static_cast<int32_t>(value));
+
+                    if (depth == 3)
+                    {
+                        if (currentKey == "rotated")
+                        {
+                            frame.rotated = (value != 0.0);
+                            frame.members |= FrameDescription::Rotated;
+                        }
+                    }
+                    else if (depth == 4)
+                    {
+                        switch (container)
+                        {
+                            case FrameDescription::Rectangle:
+                                if (currentKey == "x") frame.frameRectangle.position.v[0] = pixels;
+                                else if (currentKey == "y") frame.frameRectangle.position.v[1] = pixels;
+                                else if (currentKey == "w") frame.frameRectangle.size.v[0] = pixels;
+                                else if (currentKey == "h") frame.frameRectangle.size.v[1] = pixels;
+                                break;
+                            case FrameDescription::SourceSize:
+                                if (currentKey == "w") frame.sourceSize.v[0] = pixels;
+                                else if (currentKey == "h") frame.sourceSize.v[1] = pixels;
+                                break;
+                            case FrameDescription::SpriteSourceSize:
+                                if (currentKey == "x") frame.sourceOffset.v[0] = pixels;
+                                else if (currentKey == "y") frame.sourceOffset.v[1] = pixels;
+                                break;
+                            case FrameDescription::Pivot:
+                                if (currentKey == "x") frame.pivot.v[0] = static_cast<float>(value);
+                                else if (currentKey == "y") frame.pivot.v[1] = static_cast<float>(value);
+                                break;
+                            default:
+                                break;
+                        }
+                    }
+                    else if (depth == 5)
+                    {
+                        if (container == FrameDescription::Triangles)
+                            frame.indices.push_back(static_cast<uint16_t>(value));
+                        else if (elementIndex < 2)
+                            point.v[elementIndex] = pixels;
+
+                        ++elementIndex;
+                    }
+                }
+
+                uint32_t depth = 0;
+                std::string currentKey;
+                bool inMeta = false;
+                bool inFrames = false;
+                bool inFrame = false;
+                uint32_t container = 0;
+                uint32_t elementIndex = 0;
+                Vector2F point;
+            };
+        }
 
-            auto imageFilename = metaObject["image"].as<std::string>();
-            spriteData.texture = cache.getTexture(imageFilename);
-            if (!spriteData.texture)
+        namespace
+        {
+            constexpr uint32_t COOKED_SIGNATURE = 0x4F535052; // "OSPR"
+
+            enum CookedKey: uint32_t
             {
-                bundle.loadAsset(Loader::Image, imageFilename, imageFilename, mipmaps);
-                spriteData.texture = cache.getTexture(imageFilename);
-            }
+                ImageFilename,
+                Frames,
+                FrameName,
+                FrameX,
+                FrameY,
+                FrameWidth,
+                FrameHeight,
+                SourceWidth,
+                SourceHeight,
+                SourceOffsetX,
+                SourceOffsetY,
+                PivotX,
+                PivotY,
+                Rotated,
+                Members,
+                Indices,
+                Vertices,
+                VerticesUV
+            };
+
+            struct SpriteSheet final
+            {
+                std::string imageFilename;
+                std::vector<FrameDescription> frames;
+            };
 
-            if (!spriteData.texture)
-                return false;
+            // returns false if the data is not a sprite sheet
+            bool parseSpriteSheet(Span<const uint8_t> data, SpriteSheet& spriteSheet)
+            {
+                SpriteSheetHandler handler;
+                json::parse(data, handler);
 
-            const Size2F textureSize(static_cast<float>(spriteData.texture->getSize().v[0]),
-                                           static_cast<float>(spriteData.texture->getSize().v[1]));
+                if (!handler.hasMeta || !handler.hasFrames)
+                    return false;
 
-            const json::Value& framesArray = d["frames"];
+                if (handler.imageFilename.empty())
+                    throw json::RangeError("Member does not exist");
 
-            scene::SpriteData::Animation animation;
+                // reverse the vertices, so that they are counterclockwise
+                for (FrameDescription& frame : handler.frames)
+                    std::reverse(frame.indices.begin(), frame.indices.end());
 
-            animation.frames.reserve(framesArray.getSize());
+                spriteSheet.imageFilename = std::move(handler.imageFilename);
+                spriteSheet.frames = std::move(handler.frames);
 
-            for (const json::Value& frameObject : framesArray)
+                return true;
+            }
+
+            obf::Value::ByteArray encodePoints(const std::vector<Vector2F>& points)
             {
-                const auto filename = frameObject["filename"].as<std::string>();
+                obf::Value::ByteArray result(points.size() * 2 * sizeof(float));
 
-                const json::Value& frameRectangleObject = frameObject["frame"];
+                for (size_t i = 0; i < points.size(); ++i)
+                {
+                    encodeLittleEndian<float>(result.data() + (i * 2 + 0) * sizeof(float), points[i].v[0]);
+                    encodeLittleEndian<float>(result.data() + (i * 2 + 1) * sizeof(float), points[i].v[1]);
+                }
 
-                RectF frameRectangle(static_cast<float>(frameRectangleObject["x"].as<int32_t>()),
-                                     static_cast<float>(frameRectangleObject["y"].as<int32_t>()),
-                                     static_cast<float>(frameRectangleObject["w"].as<int32_t>()),
-                                     static_cast<float>(frameRectangleObject["h"].as<int32_t>()));
+                return result;
+            }
 
-                const json::Value& sourceSizeObject = frameObject["sourceSize"];
+            std::vector<Vector2F> decodePoints(Span<const uint8_t> data)
+            {
+                std::vector<Vector2F> result(data.size() / (2 * sizeof(float)));
 
-                Size2F sourceSize(static_cast<float>(sourceSizeObject["w"].as<int32_t>()),
-                                  static_cast<float>(sourceSizeObject["h"].as<int32_t>()));
+                for (size_t i = 0; i < result.size(); ++i)
+                {
+                    result[i].v[0] = decodeLittleEndian<float>(data.data() + (i * 2 + 0) * sizeof(float));
+                    result[i].v[1] = decodeLittleEndian<float>(data.data() + (i * 2 + 1) * sizeof(float));
+                }
 
-                const json::Value& spriteSourceSizeObject = frameObject["spriteSourceSize"];
+                return result;
+            }
 
-                Vector2F sourceOffset(static_cast<float>(spriteSourceSizeObject["x"].as<int32_t>()),
-                                      static_cast<float>(spriteSourceSizeObject["y"].as<int32_t>()));
+            // cooked sprite sheets are already parsed and their indices are reversed
+            SpriteSheet readCookedSpriteSheet(const obf::View& value)
+            {
+                SpriteSheet spriteSheet;
+                spriteSheet.imageFilename = value.at(ImageFilename).as<std::string>();
 
-                const json::Value& pivotObject = frameObject["pivot"];
+                const obf::View frames = value.at(Frames);
+                if (frames.getType() != obf::Value::Type::Array)
+                    throw std::runtime_error("Invalid cooked sprite sheet");
 
-                const Vector2F pivot(pivotObject["x"].as<float>(),
-                                     pivotObject["y"].as<float>());
+                spriteSheet.frames.reserve(frames.getSize());
 
-                if (frameObject.hasMember("vertices") &&
-                    frameObject.hasMember("verticesUV") &&
-                    frameObject.hasMember("triangles"))
+                for (const obf::View frameValue : frames)
                 {
-                    std::vector<uint16_t> indices;
+                    FrameDescription frame;
+                    frame.filename = frameValue.at(FrameName).as<std::string>();
+                    frame.frameRectangle = RectF(frameValue.at(FrameX).as<float>(), frameValue.at(FrameY).as<float>(),
+                                                 frameValue.at(FrameWidth).as<float>(), frameValue.at(FrameHeight).as<float>());
+                    frame.sourceSize = Size2F(frameValue.at(SourceWidth).as<float>(), frameValue.at(SourceHeight).as<float>());
+                    frame.sourceOffset = Vector2F(frameValue.at(SourceOffsetX).as<float>(), frameValue.at(SourceOffsetY).as<float>());
+                    frame.pivot = Vector2F(frameValue.at(PivotX).as<float>(), frameValue.at(PivotY).as<float>());
+                    frame.rotated = frameValue.at(Rotated).as<uint32_t>() != 0;
+                    frame.members = frameValue.at(Members).as<uint32_t>();
+
+                    const auto indices = frameValue.at(Indices).as<Span<const uint8_t>>();
+                    frame.indices.resize(indices.size() / sizeof(uint16_t));
+                    for (size_t i = 0; i < frame.indices.size(); ++i)
+                        frame.indices[i] = decodeLittleEndian<uint16_t>(indices.data() + i * sizeof(uint16_t));
+
+                    frame.vertices = decodePoints(frameValue.at(Vertices).as<Span<const uint8_t>>());
+                    frame.verticesUV = decodePoints(frameValue.at(VerticesUV).as<Span<const uint8_t>>());
+
+                    spriteSheet.frames.push_back(std::move(frame));
+                }
 
-                    const json::Value& trianglesObject = frameObject["triangles"];
+                return spriteSheet;
+            }
+        }
 
-                    for (const json::Value& triangleObject : trianglesObject)
-                    {
-                        for (const json::Value& indexObject : triangleObject)
-                            indices.push_back(static_cast<uint16_t>(indexObject.as<uint32_t>()));
-                    }
+        SpriteLoader::SpriteLoader(Cache& initCache):
+            Loader(initCache, Loader::Sprite)
+        {
+        }
 
-                    // reverse the vertices, so that they are counterclockwise
-                    std::reverse(indices.begin(), indices.end());
+        bool SpriteLoader::loadAsset(Bundle& bundle,
+                                     const std::string& name,
+                                     Span<const uint8_t> data,
+                                     bool mipmaps)
+        {
+            const auto finish = prepareAsset(name, data, mipmaps);
+            return finish && finish(bundle);
+        }
+
+        std::function<bool(Bundle&)> SpriteLoader::prepareAsset(const std::string& name,
+                                                                Span<const uint8_t> data,
+                                                                bool mipmaps)
+        {
+            SpriteSheet spriteSheet;
+
+            const obf::View cookedValue = decodeCookedData(COOKED_SIGNATURE, data);
+            if (!cookedValue.isNull())
+                spriteSheet = readCookedSpriteSheet(cookedValue);
+            else if (!parseSpriteSheet(data, spriteSheet))
+                return nullptr;
+
+            // the frames need the size of the texture, so they are created on the update thread
+            return [this, name, mipmaps,
+                    imageFilename = std::move(spriteSheet.imageFilename),
+                    frames = std::move(spriteSheet.frames)](Bundle& bundle) {
+                scene::SpriteData spriteData;
+
+                spriteData.texture = cache.getTexture(imageFilename);
+                if (!spriteData.texture)
+                {
+                    bundle.loadAsset(Loader::Image, imageFilename, imageFilename, mipmaps);
+                    spriteData.texture = cache.getTexture(imageFilename);
+                }
+
+                if (!spriteData.texture)
+                    return false;
 
-                    std::vector<graphics::Vertex> vertices;
+                const Size2F textureSize(static_cast<float>(spriteData.texture->getSize().v[0]),
+                                         static_cast<float>(spriteData.texture->getSize().v[1]));
 
-                    const json::Value& verticesObject = frameObject["vertices"];
-                    const json::Value& verticesUVObject = frameObject["verticesUV"];
+                scene::SpriteData::Animation animation;
 
-                    Vector2F finalOffset(-sourceSize.v[0] * pivot.v[0] + sourceOffset.v[0],
-                                         -sourceSize.v[1] * pivot.v[1] + (sourceSize.v[1] - frameRectangle.size.v[1] - sourceOffset.v[1]));
+                animation.frames.reserve(frames.size());
 
-                    for (size_t vertexIndex = 0; vertexIndex < verticesObject.getSize(); ++vertexIndex)
+                for (const FrameDescription& frame : frames)
+                {
+                    if ((frame.members & FrameDescription::Mesh) == FrameDescription::Mesh)
                     {
-                        const json::Value& vertexObject = verticesObject[vertexIndex];
-                        const json::Value& vertexUVObject = verticesUVObject[vertexIndex];
-
-                        vertices.emplace_back(Vector3F{static_cast<float>(vertexObject[0].as<int32_t>()) + finalOffset.v[0],
-                                                       -static_cast<float>(vertexObject[1].as<int32_t>()) - finalOffset.v[1], 0.0F},
-                                              Color::white(),
-                                              Vector2F{static_cast<float>(vertexUVObject[0].as<int32_t>()) / textureSize.v[0],
-                                                       static_cast<float>(vertexUVObject[1].as<int32_t>()) / textureSize.v[1]},
-                                              Vector3F{0.0F, 0.0F, -1.0F});
+                        if (frame.verticesUV.size() < frame.vertices.size())
+                            throw json::RangeError("Index out of range");
+
+                        std::vector<graphics::Vertex> vertices;
+                        vertices.reserve(frame.vertices.size());
+
+                        Vector2F finalOffset(-frame.sourceSize.v[0] * frame.pivot.v[0] + frame.sourceOffset.v[0],
+                                             -frame.sourceSize.v[1] * frame.pivot.v[1] + (frame.sourceSize.v[1] - frame.frameRectangle.size.v[1] - frame.sourceOffset.v[1]));
+
+                        for (size_t vertexIndex = 0; vertexIndex < frame.vertices.size(); ++vertexIndex)
+                        {
+                            const Vector2F& vertex = frame.vertices[vertexIndex];
+                            const Vector2F& vertexUV = frame.verticesUV[vertexIndex];
+
+                            vertices.emplace_back(Vector3F{vertex.v[0] + finalOffset.v[0],
+                                                           -vertex.v[1] - finalOffset.v[1], 0.0F},
+                                                  Color::white(),
+                                                  Vector2F{vertexUV.v[0] / textureSize.v[0],
+                                                           vertexUV.v[1] / textureSize.v[1]},
+                                                  Vector3F{0.0F, 0.0F, -1.0F});
+                        }
+
+                        animation.frames.emplace_back(frame.filename, frame.indices, vertices, frame.frameRectangle,
+                                                      frame.sourceSize, frame.sourceOffset, frame.pivot);
                     }
-
-                    animation.frames.emplace_back(filename, indices, vertices, frameRectangle, sourceSize, sourceOffset, pivot);
+                    else
+                        animation.frames.emplace_back(frame.filename, textureSize, frame.frameRectangle, frame.rotated,
+                                                      frame.sourceSize, frame.sourceOffset, frame.pivot);
                 }
-                else
-                {
-                    const auto rotated = frameObject["rotated"].as<bool>();
 
-                    animation.frames.emplace_back(filename, textureSize, frameRectangle, rotated, sourceSize, sourceOffset, pivot);
-                }
-            }
+                spriteData.animations[""] = std::move(animation);
+
+                bundle.setSpriteData(name, spriteData);
 
-            spriteData.animations[""] = std::move(animation);
+                return true;
+            };
+        }
+
+        std::vector<uint8_t> SpriteLoader::cookAsset(Span<const uint8_t> data, bool)
+        {
+            SpriteSheet spriteSheet;
+            if (!parseSpriteSheet(data, spriteSheet))
+                return std::vector<uint8_t>();
 
-            bundle.setSpriteData(name, spriteData);
+            obf::Value::Array frames;
+            frames.reserve(spriteSheet.frames.size());
+
+            for (const FrameDescription& frame : spriteSheet.frames)
+            {
+                obf::Value::ByteArray indices(frame.indices.size() * sizeof(uint16_t));
+                for (size_t i = 0; i < frame.indices.size(); ++i)
+                    encodeLittleEndian<uint16_t>(indices.data() + i * sizeof(uint16_t), frame.indices[i]);
+
+                frames.push_back(obf::Value::Object{
+                    {FrameName, frame.filename},
+                    {FrameX, frame.frameRectangle.position.v[0]},
+                    {FrameY, frame.frameRectangle.position.v[1]},
+                    {FrameWidth, frame.frameRectangle.size.v[0]},
+                    {FrameHeight, frame.frameRectangle.size.v[1]},
+                    {SourceWidth, frame.sourceSize.v[0]},
+                    {SourceHeight, frame.sourceSize.v[1]},
+                    {SourceOffsetX, frame.sourceOffset.v[0]},
+                    {SourceOffsetY, frame.sourceOffset.v[1]},
+                    {PivotX, frame.pivot.v[0]},
+                    {PivotY, frame.pivot.v[1]},
+                    {Rotated, static_cast<uint32_t>(frame.rotated ? 1 : 0)},
+                    {Members, frame.members},
+                    {Indices, indices},
+                    {Vertices, encodePoints(frame.vertices)},
+                    {VerticesUV, encodePoints(frame.verticesUV)}
+                });
+            }
 
-            return true;
+            return encodeCookedData(COOKED_SIGNATURE, obf::Value::Object{
+                {ImageFilename, spriteSheet.imageFilename},
+                {Frames, frames}
+            });
         }
     } // namespace assets
 } // namespace ouzel
@@ -15,8 +15,12 @@ namespace ouzel
             explicit SpriteLoader(Cache& initCache);
             bool loadAsset(Bundle& bundle,
                            const std::string& name,
-                           const std::vector<uint8_t>& data,
+                           Span<const uint8_t> data,
                            bool mipmaps = true) final;
+            std::function<bool(Bundle&)> prepareAsset(const std::string& name,
+                                                      Span<const uint8_t> data,
+                                                      bool mipmaps = true) final;
+            std::vector<uint8_t> cookAsset(Span<const uint8_t> data, bool mipmaps = true) final;
         };
     } // namespace assets
 } // namespace ouzel
@@ -16,7 +16,7 @@ namespace ouzel
 
         bool VorbisLoader::loadAsset(Bundle& bundle,
                                      const std::string& name,
-                                     const std::vector<uint8_t>& data,
+                                     Span<const uint8_t> data,
                                      bool)
         {
             try
@@ -31,5 +31,33 @@ namespace ouzel
 
             return true;
         }
+
+        bool VorbisLoader::loadSharedAsset(Bundle& bundle,
+                                           const std::string& name,
+                                           const std::shared_ptr<const storage::FileView>& data,
+                                           bool)
+        {
+            try
+            {
+                auto sound = std::make_unique<audio::VorbisClip>(*engine->getAudio(), data);
+                bundle.setSound(name, std::move(sound));
+            }
+            catch (const std::exception&)
+            {
+                return false;
+            }
+
+            return true;
+        }
+
+        std::function<bool(Bundle&)> VorbisLoader::prepareSharedAsset(const std::string& name,
+                                                                      const std::shared_ptr<const storage::FileView>& data,
+                                                                      bool mipmaps)
+        {
+            // nothing is decoded ahead, the streams decode the data while they are playing
+            return [this, name, data, mipmaps](Bundle& bundle) {
+                return loadSharedAsset(bundle, name, data, mipmaps);
+            };
+        }
     } // namespace assets
 } // namespace ouzel
@@ -15,8 +15,17 @@ namespace ouzel
             explicit VorbisLoader(Cache& initCache);
             bool loadAsset(Bundle& bundle,
                            const std::string& name,
-                           const std::vector<uint8_t>& data,
+                           Span<const uint8_t> data,
                            bool mipmaps = true) final;
+
+            // the clip keeps the file view, so that the data is streamed from it instead of being copied
+            bool loadSharedAsset(Bundle& bundle,
+                                 const std::string& name,
+                                 const std::shared_ptr<const storage::FileView>& data,
+                                 bool mipmaps = true) final;
+            std::function<bool(Bundle&)> prepareSharedAsset(const std::string& name,
+                                                            const std::shared_ptr<const storage::FileView>& data,
+                                                            bool mipmaps = true) final;
         };
     } // namespace assets
 } // namespace ouzel
@@ -1,10 +1,12 @@
 // Copyright 2015-2019 Elviss Strazdins. All rights reserved.
 
 #include <cstring>
+#include <stdexcept>
 #include "WaveLoader.hpp"
 #include "Bundle.hpp"
 #include "audio/PcmClip.hpp"
 #include "core/Engine.hpp"
+#include "utils/Utils.hpp"
 
 enum WaveFormat
 {
@@ -16,17 +18,25 @@ namespace ouzel
 {
     namespace assets
     {
-        WaveLoader::WaveLoader(Cache& initCache):
-            Loader(initCache, Loader::Sound)
+        namespace
         {
-        }
+            constexpr uint32_t COOKED_SIGNATURE = 0x4F50434D; // "OPCM"
 
-        bool WaveLoader::loadAsset(Bundle& bundle,
-                                   const std::string& name,
-                                   const std::vector<uint8_t>& data,
-                                   bool)
-        {
-            try
+            enum CookedKey: uint32_t
+            {
+                Channels,
+                SampleRate,
+                Samples
+            };
+
+            struct DecodedSound final
+            {
+                uint32_t channels = 0;
+                uint32_t sampleRate = 0;
+                std::vector<float> samples;
+            };
+
+            DecodedSound decodeWave(Span<const uint8_t> data)
             {
                 uint32_t channels = 0;
                 uint32_t sampleRate = 0;
@@ -233,15 +243,88 @@ namespace ouzel
                         throw std::runtime_error("Failed to load sound file, unsupported bit depth");
                 }
 
-                auto sound = std::make_unique<audio::PcmClip>(*engine->getAudio(), channels, sampleRate, samples);
-                bundle.setSound(name, std::move(sound));
+                return DecodedSound{channels, sampleRate, std::move(samples)};
+            }
+
+            // cooked sounds are stored as planar float samples
+            DecodedSound readCookedSound(const obf::View& value)
+            {
+                DecodedSound sound;
+                sound.channels = value.at(Channels).as<uint32_t>();
+                sound.sampleRate = value.at(SampleRate).as<uint32_t>();
+
+                if (!sound.channels || !sound.sampleRate)
+                    throw std::runtime_error("Invalid cooked sound");
+
+                const auto samples = value.at(Samples).as<Span<const uint8_t>>();
+                sound.samples.resize(samples.size() / sizeof(float));
+
+                for (size_t i = 0; i < sound.samples.size(); ++i)
+                    sound.samples[i] = decodeLittleEndian<float>(samples.data() + i * sizeof(float));
+
+                return sound;
+            }
+        }
+
+        WaveLoader::WaveLoader(Cache& initCache):
+            Loader(initCache, Loader::Sound)
+        {
+        }
+
+        bool WaveLoader::loadAsset(Bundle& bundle,
+                                   const std::string& name,
+                                   Span<const uint8_t> data,
+                                   bool mipmaps)
+        {
+            const auto finish = prepareAsset(name, data, mipmaps);
+            return finish && finish(bundle);
+        }
+
+        std::function<bool(Bundle&)> WaveLoader::prepareAsset(const std::string& name,
+                                                              Span<const uint8_t> data,
+                                                              bool)
+        {
+            try
+            {
+                const obf::View cookedValue = decodeCookedData(COOKED_SIGNATURE, data);
+                DecodedSound sound = cookedValue.isNull() ? decodeWave(data) : readCookedSound(cookedValue);
+
+                // the samples are decoded here, only the clip is created on the update thread
+                return [name, sound = std::move(sound)](Bundle& bundle) {
+                    auto clip = std::make_unique<audio::PcmClip>(*engine->getAudio(), sound.channels,
+                                                                 sound.sampleRate, sound.samples);
+                    bundle.setSound(name, std::move(clip));
+                    return true;
+                };
             }
             catch (const std::exception&)
             {
-                return false;
+                return nullptr;
             }
+        }
+
+        std::vector<uint8_t> WaveLoader::cookAsset(Span<const uint8_t> data, bool)
+        {
+            DecodedSound sound;
+
+            try
+            {
+                sound = decodeWave(data);
+            }
+            catch (const std::exception&)
+            {
+                return std::vector<uint8_t>();
+            }
+
+            obf::Value::ByteArray samples(sound.samples.size() * sizeof(float));
+            for (size_t i = 0; i < sound.samples.size(); ++i)
+                encodeLittleEndian<float>(samples.data() + i * sizeof(float), sound.samples[i]);
 
-            return true;
+            return encodeCookedData(COOKED_SIGNATURE, obf::Value::Object{
+                {Channels, sound.channels},
+                {SampleRate, sound.sampleRate},
+                {Samples, samples}
+            });
         }
     } // namespace assets
 } // namespace ouzel
@@ -148,11 +148,11 @@ namespace ouzel
             }
         }
 
-        Audio::Audio(Driver driver, bool debugAudio):
+        Audio::Audio(Driver driver, bool debugAudio, uint32_t lookahead):
             device(createAudioDevice(driver,
                                      std::bind(&Audio::getSamples, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4),
                                      debugAudio)),
-            mixer(device->getBufferSize(), device->getChannels(),
+            mixer(device->getBufferSize(), device->getSampleRate(), device->getChannels(), lookahead,
                   std::bind(&Audio::eventCallback, this, std::placeholders::_1)),
             masterMix(*this),
             rootNode(*this) // mixer.getRootObjectId()
@@ -163,7 +163,7 @@ namespace ouzel
 
         void Audio::update()
         {
-            // TODO: handle events from the audio device
+            mixer.dispatchEvents();
 
             mixer.submitCommandBuffer(std::move(commandBuffer));
             commandBuffer = mixer::CommandBuffer();
@@ -171,6 +171,7 @@ namespace ouzel
 
         void Audio::deleteObject(uintptr_t objectId)
         {
+            dataObjects.erase(objectId);
             addCommand(std::make_unique<mixer::DeleteObjectCommand>(objectId));
         }
 
@@ -183,14 +184,19 @@ namespace ouzel
 
         uintptr_t Audio::initStream(uintptr_t sourceId)
         {
+            auto i = dataObjects.find(sourceId);
+            if (i == dataObjects.end())
+                throw std::runtime_error("Invalid audio data");
+
             uintptr_t streamId = mixer.getObjectId();
-            addCommand(std::make_unique<mixer::InitStreamCommand>(streamId, sourceId));
+            addCommand(std::make_unique<mixer::InitStreamCommand>(streamId, i->second->createStream()));
             return streamId;
         }
 
         uintptr_t Audio::initData(std::unique_ptr<mixer::Data> data)
         {
             uintptr_t dataId = mixer.getObjectId();
+            dataObjects[dataId] = data.get();
             addCommand(std::make_unique<mixer::InitDataCommand>(dataId, std::move(data)));
             return dataId;
         }
@@ -214,6 +220,8 @@ namespace ouzel
 
         void Audio::eventCallback(const mixer::Mixer::Event& event)
         {
+            if (event.type == mixer::Mixer::Event::Type::Starvation)
+                engine->log(Log::Level::Warning) << "Audio mixer starvation, " << mixer.getStarvationCount() << " in total";
         }
     } // namespace audio
 } // namespace ouzel
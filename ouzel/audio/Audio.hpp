@@ -7,6 +7,7 @@
 #include <functional>
 #include <memory>
 #include <set>
+#include <unordered_map>
 #include <vector>
 #include "audio/AudioDevice.hpp"
 #include "audio/Driver.hpp"
@@ -27,7 +28,8 @@ namespace ouzel
         class Audio final
         {
         public:
-            Audio(Driver driver, bool debugAudio);
+            // lookahead is the number of device buffers mixed in advance
+            Audio(Driver driver, bool debugAudio, uint32_t lookahead = 2);
 
             static Driver getDriver(const std::string& driver);
             static std::set<Driver> getAvailableAudioDrivers();
@@ -59,6 +61,7 @@ namespace ouzel
             std::unique_ptr<AudioDevice> device;
             mixer::Mixer mixer;
             mixer::CommandBuffer commandBuffer;
+            std::unordered_map<uintptr_t, mixer::Data*> dataObjects; // used to create the streams on the game thread
             Mix masterMix;
             Node rootNode;
         };
@@ -1,6 +1,8 @@
 // Copyright 2015-2019 Elviss Strazdins. All rights reserved.
 
 #include "AudioDevice.hpp"
+#include "mixer/Kernels.hpp"
+#include "utils/Log.hpp"
 
 namespace ouzel
 {
@@ -24,6 +26,9 @@ namespace ouzel
 
         void AudioDevice::getData(uint32_t frames, std::vector<uint8_t>& result)
         {
+            // this is called on the real-time thread of the audio driver, which must not wait for the log thread
+            Logger::setOverflowPolicy(Logger::OverflowPolicy::Drop);
+
             dataGetter(frames, channels, sampleRate, buffer);
 
             switch (sampleFormat)
@@ -31,29 +36,13 @@ namespace ouzel
                 case SampleFormat::SignedInt16:
                 {
                     result.resize(frames * channels * sizeof(int16_t));
-                    int16_t* resultPtr = reinterpret_cast<int16_t*>(result.data());
-
-                    for (uint32_t channel = 0; channel < channels; ++channel)
-                    {
-                        float* bufferChannel = &buffer[channel * frames];
-
-                        for (uint32_t frame = 0; frame < frames; ++frame)
-                            resultPtr[frame * channels + channel] = static_cast<int16_t>(bufferChannel[frame] * 32767.0F);
-                    }
+                    mixer::interleaveSamples(frames, channels, buffer.data(), reinterpret_cast<int16_t*>(result.data()));
                     break;
                 }
                 case SampleFormat::Float32:
                 {
                     result.resize(frames * channels * sizeof(float));
-                    float* resultPtr = reinterpret_cast<float*>(result.data());
-
-                    for (uint32_t channel = 0; channel < channels; ++channel)
-                    {
-                        float* bufferChannel = &buffer[channel * frames];
-
-                        for (uint32_t frame = 0; frame < frames; ++frame)
-                            resultPtr[frame * channels + channel] = bufferChannel[frame];
-                    }
+                    mixer::interleaveSamples(frames, channels, buffer.data(), reinterpret_cast<float*>(result.data()));
                     break;
                 }
                 default:
@@ -22,6 +22,8 @@ namespace ouzel
                 position = 0;
             }
 
+            void seek(uint32_t frame) final;
+
             void getSamples(uint32_t frames, std::vector<float>& samples) final;
 
         private:
@@ -95,6 +97,15 @@ namespace ouzel
             }
         }
 
+        void OscillatorStream::seek(uint32_t frame)
+        {
+            const auto length = static_cast<OscillatorData&>(data).getLength();
+            const auto frameCount = static_cast<uint32_t>(length * data.getSampleRate());
+
+            // sounds without a length never end
+            position = (length > 0.0F && frame > frameCount) ? frameCount : frame;
+        }
+
         void OscillatorStream::getSamples(uint32_t frames, std::vector<float>& samples)
         {
             OscillatorData& oscillatorData = static_cast<OscillatorData&>(data);
@@ -23,6 +23,8 @@ namespace ouzel
                 position = 0;
             }
 
+            void seek(uint32_t frame) final;
+
             void getSamples(uint32_t frames, std::vector<float>& samples) final;
 
         private:
@@ -56,6 +58,14 @@ namespace ouzel
         {
         }
 
+        void PcmStream::seek(uint32_t frame)
+        {
+            PcmData& pcmData = static_cast<PcmData&>(data);
+            const auto sourceFrames = static_cast<uint32_t>(pcmData.getSamples().size() / pcmData.getChannels());
+
+            position = (frame < sourceFrames) ? frame : sourceFrames;
+        }
+
         void PcmStream::getSamples(uint32_t frames, std::vector<float>& samples)
         {
             const uint32_t neededSize = frames * data.getChannels();
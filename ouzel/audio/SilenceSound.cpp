@@ -21,6 +21,8 @@ namespace ouzel
                 position = 0;
             }
 
+            void seek(uint32_t frame) final;
+
             void getSamples(uint32_t frames, std::vector<float>& samples) final;
 
         private:
@@ -53,6 +55,15 @@ namespace ouzel
         {
         }
 
+        void SilenceStream::seek(uint32_t frame)
+        {
+            const auto length = static_cast<SilenceData&>(data).getLength();
+            const auto frameCount = static_cast<uint32_t>(length * data.getSampleRate());
+
+            // sounds without a length never end
+            position = (length > 0.0F && frame > frameCount) ? frameCount : frame;
+        }
+
         void SilenceStream::getSamples(uint32_t frames, std::vector<float>& samples)
         {
             SilenceData& silenceData = static_cast<SilenceData&>(data);
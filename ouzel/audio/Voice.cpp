@@ -173,6 +173,11 @@ namespace ouzel
             // TODO: send StopCommand
         }
 
+        void Voice::seek(float time)
+        {
+            audio.addCommand(std::make_unique<mixer::SeekStreamCommand>(streamId, time));
+        }
+
         // executed on audio thread
         /*void Voice::onReset()
         {
@@ -51,6 +51,7 @@ namespace ouzel
             void play();
             void pause();
             void stop();
+            void seek(float time);
 
             inline auto isPlaying() const noexcept { return playing; }
 
@@ -1,9 +1,12 @@
 // Copyright 2015-2019 Elviss Strazdins. All rights reserved.
 
+#include <algorithm>
+#include <atomic>
 #include <stdexcept>
 #include "VorbisClip.hpp"
 #include "Audio.hpp"
 #include "mixer/Data.hpp"
+#include "mixer/Decoder.hpp"
 #include "mixer/Stream.hpp"
 #include "utils/Utils.hpp"
 
@@ -45,37 +48,67 @@ namespace ouzel
 {
     namespace audio
     {
+        namespace
+        {
+            // decoded frames that each stream buffers ahead of the mixer, must be a power of two
+            constexpr uint32_t PREFETCH_FRAMES = 16384;
+
+            // the decoder is woken up when this many frames of the buffer are free, so that it decodes in batches
+            constexpr uint32_t DECODE_FRAMES = PREFETCH_FRAMES / 4;
+
+            // maps the Vorbis channel order to the channel order of the mixer
+            inline uint32_t getOutputChannel(uint32_t channels, uint32_t channel) noexcept
+            {
+                constexpr uint32_t surroundChannels[] = {0, 2, 1, 4, 5, 3};
+                return (channels == 6) ? surroundChannels[channel] : channel;
+            }
+        }
+
         class VorbisData;
 
-        class VorbisStream final: public mixer::Stream
+        // Decoded by the shared decoder of the mixer into a ring buffer
+        class VorbisStream final: public mixer::Stream, public mixer::Decoder::Client
         {
         public:
             explicit VorbisStream(VorbisData& vorbisData);
-
-            ~VorbisStream()
-            {
-                if (vorbisStream)
-                    stb_vorbis_close(vorbisStream);
-            }
+            ~VorbisStream();
 
             void reset() final
             {
-                stb_vorbis_seek_start(vorbisStream);
+                seek(0);
             }
 
+            void seek(uint32_t frame) final;
+
             void getSamples(uint32_t frames, std::vector<float>& samples) final;
 
+            void decode() final;
+
         private:
+            mixer::Decoder& decoder;
+            std::shared_ptr<const storage::FileView> fileView; // the decoder reads the pages of the file view
             stb_vorbis* vorbisStream = nullptr;
+
+            // planar, written by the decoder and read by the mixer
+            std::vector<float> buffer;
+            std::atomic<size_t> readPosition{0};
+            std::atomic<size_t> writePosition{0};
+            std::atomic<bool> ended{false};
+
+            // the mixer does not read the buffer until the decoder has finished all the requested seeks
+            std::atomic<uint32_t> seekFrame{0};
+            std::atomic<uint32_t> requestedSeeks{0};
+            std::atomic<uint32_t> finishedSeeks{0};
         };
 
         class VorbisData final: public mixer::Data
         {
         public:
-            explicit VorbisData(const std::vector<uint8_t>& initData):
-                data(initData)
+            VorbisData(mixer::Decoder& initDecoder, std::shared_ptr<const storage::FileView> initData):
+                decoder(initDecoder),
+                data(std::move(initData))
             {
-                stb_vorbis* vorbisStream = stb_vorbis_open_memory(data.data(), static_cast<int>(data.size()), nullptr, nullptr);
+                stb_vorbis* vorbisStream = stb_vorbis_open_memory(data->data(), static_cast<int>(data->size()), nullptr, nullptr);
 
                 if (!vorbisStream)
                     throw std::runtime_error("Failed to load Vorbis stream");
@@ -86,8 +119,12 @@ namespace ouzel
                 sampleRate = info.sample_rate;
 
                 stb_vorbis_close(vorbisStream);
+
+                if (channels != 1 && channels != 2 && channels != 4 && channels != 6)
+                    throw std::runtime_error("Unsupported channel count");
             }
 
+            auto& getDecoder() const noexcept { return decoder; }
             auto& getData() const noexcept { return data; }
 
             std::unique_ptr<mixer::Stream> createStream() final
@@ -96,76 +133,142 @@ namespace ouzel
             }
 
         private:
-            std::vector<uint8_t> data;
+            mixer::Decoder& decoder;
+            std::shared_ptr<const storage::FileView> data;
         };
 
         VorbisStream::VorbisStream(VorbisData& vorbisData):
-            Stream(vorbisData)
+            Stream(vorbisData),
+            decoder(vorbisData.getDecoder()),
+            fileView(vorbisData.getData()),
+            buffer(PREFETCH_FRAMES * vorbisData.getChannels())
         {
-            vorbisStream = stb_vorbis_open_memory(vorbisData.getData().data(),
-                                                  static_cast<int>(vorbisData.getData().size()),
+            vorbisStream = stb_vorbis_open_memory(fileView->data(),
+                                                  static_cast<int>(fileView->size()),
                                                   nullptr, nullptr);
+
+            if (!vorbisStream)
+                throw std::runtime_error("Failed to open Vorbis stream");
+
+            decoder.addClient(this);
+        }
+
+        VorbisStream::~VorbisStream()
+        {
+            decoder.removeClient(this);
+
+            if (vorbisStream)
+                stb_vorbis_close(vorbisStream);
+        }
+
+        void VorbisStream::seek(uint32_t frame)
+        {
+            seekFrame.store(frame, std::memory_order_relaxed);
+            requestedSeeks.store(requestedSeeks.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+
+            decoder.notify();
         }
 
         void VorbisStream::getSamples(uint32_t frames, std::vector<float>& samples)
         {
-            uint32_t neededSize = frames * data.getChannels();
-            samples.resize(neededSize);
+            const uint32_t channels = data.getChannels();
+            samples.resize(frames * channels);
+
+#if defined(__EMSCRIPTEN__)
+            decode();
+#endif
 
-            int resultFrames = 0;
+            uint32_t copyFrames = 0;
 
-            if (neededSize > 0)
+            if (finishedSeeks.load(std::memory_order_acquire) == requestedSeeks.load(std::memory_order_relaxed))
             {
-                if (vorbisStream->eof)
-                    reset();
+                const size_t read = readPosition.load(std::memory_order_relaxed);
+                const size_t available = writePosition.load(std::memory_order_acquire) - read;
+                copyFrames = static_cast<uint32_t>(std::min(available, static_cast<size_t>(frames)));
+
+                const auto offset = static_cast<uint32_t>(read & (PREFETCH_FRAMES - 1));
+                const uint32_t firstFrames = std::min(copyFrames, PREFETCH_FRAMES - offset);
+
+                for (uint32_t channel = 0; channel < channels; ++channel)
+                {
+                    const float* bufferChannel = &buffer[channel * PREFETCH_FRAMES];
+                    float* outputChannel = &samples[channel * frames];
+
+                    std::copy(bufferChannel + offset, bufferChannel + offset + firstFrames, outputChannel);
+                    std::copy(bufferChannel, bufferChannel + (copyFrames - firstFrames), outputChannel + firstFrames);
+                }
 
-                std::vector<float*> channelData(data.getChannels());
+                const size_t freeFrames = PREFETCH_FRAMES - (available - copyFrames);
+                readPosition.store(read + copyFrames, std::memory_order_release);
 
-                switch (data.getChannels())
+                // everything that the decoder decoded before the end of the data has been played
+                if (copyFrames == available &&
+                    ended.load(std::memory_order_acquire) &&
+                    writePosition.load(std::memory_order_relaxed) == read + copyFrames)
                 {
-                    case 1:
-                        channelData[0] = &samples[0];
-                        break;
-                    case 2:
-                        channelData[0] = &samples[0 * frames];
-                        channelData[1] = &samples[1 * frames];
-                        break;
-                    case 4:
-                        channelData[0] = &samples[0 * frames];
-                        channelData[1] = &samples[1 * frames];
-                        channelData[2] = &samples[2 * frames];
-                        channelData[3] = &samples[3 * frames];
-                        break;
-                    case 6:
-                        channelData[0] = &samples[0 * frames];
-                        channelData[1] = &samples[2 * frames];
-                        channelData[2] = &samples[1 * frames];
-                        channelData[3] = &samples[4 * frames];
-                        channelData[4] = &samples[5 * frames];
-                        channelData[5] = &samples[3 * frames];
-                        break;
-                    default:
-                        throw std::runtime_error("Unsupported channel count");
+                    playing = false; // TODO: fire event
+                    reset();
                 }
+                else if (!ended.load(std::memory_order_relaxed) &&
+                         freeFrames >= DECODE_FRAMES && freeFrames - copyFrames < DECODE_FRAMES)
+                    decoder.notify();
+            }
+
+            for (uint32_t channel = 0; channel < channels; ++channel)
+                std::fill(samples.begin() + channel * frames + copyFrames,
+                          samples.begin() + (channel + 1) * frames,
+                          0.0F);
+        }
+
+        void VorbisStream::decode()
+        {
+            const uint32_t seeks = requestedSeeks.load(std::memory_order_acquire);
 
-                resultFrames = stb_vorbis_get_samples_float(vorbisStream, data.getChannels(),
-                                                            channelData.data(), static_cast<int>(frames));
+            if (seeks != finishedSeeks.load(std::memory_order_relaxed))
+            {
+                const uint32_t frame = seekFrame.load(std::memory_order_relaxed);
+                const int result = (frame > 0) ? stb_vorbis_seek(vorbisStream, frame) : stb_vorbis_seek_start(vorbisStream);
+
+                // the frames decoded before the seek are discarded
+                writePosition.store(readPosition.load(std::memory_order_acquire), std::memory_order_relaxed);
+                ended.store(result == 0, std::memory_order_relaxed);
+                finishedSeeks.store(seeks, std::memory_order_release);
             }
 
-            if (vorbisStream->eof)
+            const uint32_t channels = data.getChannels();
+            float* channelData[6];
+
+            while (!ended.load(std::memory_order_relaxed) &&
+                   requestedSeeks.load(std::memory_order_relaxed) == seeks)
             {
-                playing = false; // TODO: fire event
-                reset();
+                const size_t write = writePosition.load(std::memory_order_relaxed);
+                const size_t freeFrames = PREFETCH_FRAMES - (write - readPosition.load(std::memory_order_acquire));
+                if (freeFrames == 0) break;
+
+                const auto offset = static_cast<uint32_t>(write & (PREFETCH_FRAMES - 1));
+                const auto frames = static_cast<uint32_t>(std::min(freeFrames, static_cast<size_t>(PREFETCH_FRAMES - offset)));
+
+                for (uint32_t channel = 0; channel < channels; ++channel)
+                    channelData[channel] = &buffer[getOutputChannel(channels, channel) * PREFETCH_FRAMES + offset];
+
+                const int result = stb_vorbis_get_samples_float(vorbisStream, static_cast<int>(channels),
+                                                                channelData, static_cast<int>(frames));
+
+                if (result > 0)
+                    writePosition.store(write + static_cast<size_t>(result), std::memory_order_release);
+                else
+                    ended.store(true, std::memory_order_release);
             }
+        }
 
-            for (uint32_t channel = 0; channel < data.getChannels(); ++channel)
-                for (uint32_t frame = static_cast<uint32_t>(resultFrames); frame < frames; ++frame)
-                    samples[channel * frames + frame] = 0.0F;
+        VorbisClip::VorbisClip(Audio& initAudio, Span<const uint8_t> initData):
+            VorbisClip(initAudio, std::make_shared<const storage::FileView>(std::vector<uint8_t>(initData.begin(), initData.end())))
+        {
         }
 
-        VorbisClip::VorbisClip(Audio& initAudio, const std::vector<uint8_t>& initData):
+        VorbisClip::VorbisClip(Audio& initAudio, std::shared_ptr<const storage::FileView> initData):
             Sound(initAudio,
-                  initAudio.initData(std::unique_ptr<mixer::Data>(data = new VorbisData(initData))),
+                  initAudio.initData(std::unique_ptr<mixer::Data>(data = new VorbisData(initAudio.getMixer().getDecoder(), std::move(initData)))),
                   Sound::Format::Vorbis)
         {
         }
@@ -4,8 +4,11 @@
 #define OUZEL_AUDIO_VORBISCLIP_HPP
 
 #include <cstdint>
+#include <memory>
 #include <vector>
 #include "audio/Sound.hpp"
+#include "storage/FileView.hpp"
+#include "utils/Span.hpp"
 
 namespace ouzel
 {
@@ -16,7 +19,12 @@ namespace ouzel
         class VorbisClip final: public Sound
         {
         public:
-            VorbisClip(Audio& initAudio, const std::vector<uint8_t>& initData);
+            // copies the compressed data
+            VorbisClip(Audio& initAudio, Span<const uint8_t> initData);
+
+            // the streams of the clip decode the data (e.g. a mapped file) while they are playing,
+            // so only the pages that are being decoded have to be in memory
+            VorbisClip(Audio& initAudio, std::shared_ptr<const storage::FileView> initData);
 
         private:
             VorbisData* data;
@@ -28,6 +28,8 @@ namespace ouzel
                 Bus(Bus&&) = delete;
                 Bus& operator=(Bus&&) = delete;
 
+                void detach() final;
+
                 void setOutput(Bus* newOutput);
 
                 void getSamples(uint32_t frames, uint32_t channels, uint32_t sampleRate,
@@ -49,7 +51,6 @@ namespace ouzel
                 std::vector<Processor*> processors;
 
                 std::vector<float> resampleBuffer;
-                std::vector<float> mixBuffer;
                 std::vector<float> buffer;
             };
         }
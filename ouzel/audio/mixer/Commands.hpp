@@ -6,7 +6,10 @@
 #include <cstdint>
 #include <functional>
 #include <memory>
+#include <string>
+#include <vector>
 
+#include "audio/mixer/Bus.hpp"
 #include "audio/mixer/Processor.hpp"
 #include "audio/mixer/Source.hpp"
 #include "audio/mixer/Stream.hpp"
@@ -37,6 +40,7 @@ namespace ouzel
                     InitStream,
                     PlayStream,
                     StopStream,
+                    SeekStream,
                     SetStreamOutput,
                     InitData,
                     InitProcessor,
@@ -49,34 +53,37 @@ namespace ouzel
                 const Type type;
             };
 
+            // objects are created by the commands, so that the mixer thread does not allocate memory
             class InitObjectCommand final: public Command
             {
             public:
-                explicit constexpr InitObjectCommand(uintptr_t initObjectId) noexcept:
+                explicit InitObjectCommand(uintptr_t initObjectId):
                     Command(Command::Type::InitObject),
-                    objectId(initObjectId)
+                    objectId(initObjectId),
+                    object(std::make_unique<Object>())
                 {}
 
                 InitObjectCommand(uintptr_t initObjectId,
-                                  std::unique_ptr<Source> initSource) noexcept:
+                                  std::unique_ptr<Source> initSource):
                     Command(Command::Type::InitObject),
                     objectId(initObjectId),
-                    source(std::move(initSource))
+                    object(std::make_unique<Object>(std::move(initSource)))
                 {}
 
                 const uintptr_t objectId;
-                std::unique_ptr<Source> source;
+                std::unique_ptr<Object> object;
             };
 
             class DeleteObjectCommand final: public Command
             {
             public:
-                explicit constexpr DeleteObjectCommand(uintptr_t initObjectId) noexcept:
+                explicit DeleteObjectCommand(uintptr_t initObjectId) noexcept:
                     Command(Command::Type::DeleteObject),
                     objectId(initObjectId)
                 {}
 
                 const uintptr_t objectId;
+                std::unique_ptr<Object> object; // the detached object, destroyed together with the command
             };
 
             class AddChildCommand final: public Command
@@ -135,12 +142,14 @@ namespace ouzel
             class InitBusCommand final: public Command
             {
             public:
-                explicit constexpr InitBusCommand(uintptr_t initBusId) noexcept:
+                explicit InitBusCommand(uintptr_t initBusId):
                     Command(Command::Type::InitBus),
-                    busId(initBusId)
+                    busId(initBusId),
+                    bus(std::make_unique<Bus>())
                 {}
 
                 const uintptr_t busId;
+                std::unique_ptr<Bus> bus;
             };
 
             class SetBusOutputCommand final: public Command
@@ -199,15 +208,15 @@ namespace ouzel
             class InitStreamCommand final: public Command
             {
             public:
-                constexpr InitStreamCommand(uintptr_t initStreamId,
-                                            uintptr_t initDataId) noexcept:
+                InitStreamCommand(uintptr_t initStreamId,
+                                  std::unique_ptr<Stream> initStream) noexcept:
                     Command(Command::Type::InitStream),
                     streamId(initStreamId),
-                    dataId(initDataId)
+                    stream(std::move(initStream))
                 {}
 
                 const uintptr_t streamId;
-                const uintptr_t dataId;
+                std::unique_ptr<Stream> stream;
             };
 
             class PlayStreamCommand final: public Command
@@ -235,6 +244,20 @@ namespace ouzel
                 const bool reset;
             };
 
+            class SeekStreamCommand final: public Command
+            {
+            public:
+                constexpr SeekStreamCommand(uintptr_t initStreamId,
+                                            float initTime) noexcept:
+                    Command(Command::Type::SeekStream),
+                    streamId(initStreamId),
+                    time(initTime)
+                {}
+
+                const uintptr_t streamId;
+                const float time;
+            };
+
             class SetStreamOutputCommand final: public Command
             {
             public:
@@ -306,16 +329,10 @@ namespace ouzel
 
                 inline void pushCommand(std::unique_ptr<Command> command)
                 {
-                    commands.push(std::move(command));
-                }
-
-                inline std::unique_ptr<Command> popCommand()
-                {
-                    auto result = std::move(commands.front());
-                    commands.pop();
-                    return result;
+                    commands.push_back(std::move(command));
                 }
 
+                // the mixer processes the commands in place, they are destroyed together with the buffer
                 inline auto& getCommands() const
                 {
                     return commands;
@@ -323,7 +340,7 @@ namespace ouzel
 
             private:
                 std::string name;
-                std::queue<std::unique_ptr<Command>> commands;
+                std::vector<std::unique_ptr<Command>> commands;
             };
         }
     } // namespace audio
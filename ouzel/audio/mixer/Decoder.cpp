@@ -0,0 +1,90 @@
+// Copyright 2015-2019 Elviss Strazdins. All rights reserved.
+
+#include <algorithm>
+#include "Decoder.hpp"
+
+namespace ouzel
+{
+    namespace audio
+    {
+        namespace mixer
+        {
+            Decoder::Decoder()
+            {
+#if !defined(__EMSCRIPTEN__)
+                decoderThread = Thread(&Decoder::decoderMain, this);
+#endif
+            }
+
+            Decoder::~Decoder()
+            {
+#if !defined(__EMSCRIPTEN__)
+                std::unique_lock<std::mutex> lock(wakeMutex);
+                running = false;
+                lock.unlock();
+                wakeCondition.notify_all();
+
+                if (decoderThread.isJoinable())
+                    decoderThread.join();
+#endif
+            }
+
+            void Decoder::addClient(Client* client)
+            {
+#if defined(__EMSCRIPTEN__)
+                // without threads the streams decode the data when the mixer requests the samples
+                static_cast<void>(client);
+#else
+                std::unique_lock<std::mutex> lock(clientMutex);
+                clients.push_back(client);
+                lock.unlock();
+
+                notify();
+#endif
+            }
+
+            void Decoder::removeClient(Client* client)
+            {
+#if defined(__EMSCRIPTEN__)
+                static_cast<void>(client);
+#else
+                std::unique_lock<std::mutex> lock(clientMutex);
+
+                auto i = std::find(clients.begin(), clients.end(), client);
+                if (i != clients.end())
+                    clients.erase(i);
+#endif
+            }
+
+            void Decoder::notify()
+            {
+#if !defined(__EMSCRIPTEN__)
+                std::unique_lock<std::mutex> lock(wakeMutex);
+                pending = true;
+                lock.unlock();
+                wakeCondition.notify_one();
+#endif
+            }
+
+#if !defined(__EMSCRIPTEN__)
+            void Decoder::decoderMain()
+            {
+                Thread::setCurrentThreadName("Decoder");
+
+                for (;;)
+                {
+                    std::unique_lock<std::mutex> wakeLock(wakeMutex);
+                    wakeCondition.wait(wakeLock, [this]() { return !running || pending; });
+                    if (!running) break;
+                    pending = false;
+                    wakeLock.unlock();
+
+                    std::unique_lock<std::mutex> clientLock(clientMutex);
+                    for (Client* client : clients)
+                        client->decode();
+                }
+            }
+#endif
+        }
+    } // namespace audio
+} // namespace ouzel
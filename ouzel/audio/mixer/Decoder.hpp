@@ -0,0 +1,66 @@
+// Copyright 2015-2019 Elviss Strazdins. All rights reserved.
+
+#ifndef OUZEL_AUDIO_MIXER_DECODER_HPP
+#define OUZEL_AUDIO_MIXER_DECODER_HPP
+
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+#include "utils/Thread.hpp"
+
+namespace ouzel
+{
+    namespace audio
+    {
+        namespace mixer
+        {
+            // Decodes the compressed streams of all the voices on one thread, so that the mixer only copies the decoded frames
+            class Decoder final
+            {
+            public:
+                class Client
+                {
+                public:
+                    virtual ~Client() = default;
+
+                    // decodes until the buffer of the stream is full, called only on the decoder thread
+                    virtual void decode() = 0;
+                };
+
+                Decoder();
+                ~Decoder();
+
+                Decoder(const Decoder&) = delete;
+                Decoder& operator=(const Decoder&) = delete;
+
+                Decoder(Decoder&&) = delete;
+                Decoder& operator=(Decoder&&) = delete;
+
+                void addClient(Client* client);
+
+                // waits until the decoder thread has finished decoding the client
+                void removeClient(Client* client);
+
+                // wakes up the decoder thread, called by the streams after the mixer has consumed frames or seeked
+                void notify();
+
+            private:
+#if !defined(__EMSCRIPTEN__)
+                void decoderMain();
+
+                std::mutex clientMutex; // held while the clients are decoded
+                std::vector<Client*> clients;
+
+                bool running = true;
+                bool pending = false;
+                std::mutex wakeMutex;
+                std::condition_variable wakeCondition;
+
+                Thread decoderThread; // started after all the other members are initialized
+#endif
+            };
+        }
+    } // namespace audio
+} // namespace ouzel
+
+#endif // OUZEL_AUDIO_MIXER_DECODER_HPP
@@ -0,0 +1,485 @@
+// Copyright 2015-2019 Elviss Strazdins. All rights reserved.
+
+#include <algorithm>
+#if defined(__ARM_NEON__)
+#  include <arm_neon.h>
+#elif defined(__SSE2__)
+#  include <emmintrin.h>
+#endif
+#include "Kernels.hpp"
+#include "math/MathUtils.hpp"
+
+namespace ouzel
+{
+    namespace audio
+    {
+        namespace mixer
+        {
+            namespace
+            {
+                constexpr uint32_t MAX_MATRIX_CHANNELS = 6;
+
+                // gains of the source channels (columns) for every destination channel (rows)
+                struct ChannelMatrix final
+                {
+                    uint32_t sourceChannels;
+                    uint32_t channels;
+                    float gains[MAX_MATRIX_CHANNELS][MAX_MATRIX_CHANNELS];
+                };
+
+                constexpr ChannelMatrix CHANNEL_MATRICES[] = {
+                    // upmix 1 to 2: L = M, R = M
+                    {1, 2, {{1.0F}, {1.0F}}},
+                    // upmix 1 to 4: L = M, R = M, SL = 0, SR = 0
+                    {1, 4, {{1.0F}, {1.0F}, {0.0F}, {0.0F}}},
+                    // upmix 1 to 6: L = 0, R = 0, C = M, LFE = 0, SL = 0, SR = 0
+                    {1, 6, {{0.0F}, {0.0F}, {1.0F}, {0.0F}, {0.0F}, {0.0F}}},
+                    // downmix 2 to 1: M = (L + R) * 0.5
+                    {2, 1, {{0.5F, 0.5F}}},
+                    // upmix 2 to 4: L = L, R = R, SL = 0, SR = 0
+                    {2, 4, {{1.0F, 0.0F}, {0.0F, 1.0F}}},
+                    // upmix 2 to 6: L = L, R = R, C = 0, LFE = 0, SL = 0, SR = 0
+                    {2, 6, {{1.0F, 0.0F}, {0.0F, 1.0F}}},
+                    // downmix 4 to 1: M = (L + R + SL + SR) * 0.25
+                    {4, 1, {{0.25F, 0.25F, 0.25F, 0.25F}}},
+                    // downmix 4 to 2: L = (L + SL) * 0.5, R = (R + SR) * 0.5
+                    {4, 2, {{0.5F, 0.0F, 0.5F, 0.0F}, {0.0F, 0.5F, 0.0F, 0.5F}}},
+                    // upmix 4 to 6: L = L, R = R, C = 0, LFE = 0, SL = SL, SR = SR
+                    {4, 6, {{1.0F, 0.0F, 0.0F, 0.0F}, {0.0F, 1.0F, 0.0F, 0.0F}, {0.0F}, {0.0F}, {0.0F, 0.0F, 1.0F, 0.0F}, {0.0F, 0.0F, 0.0F, 1.0F}}},
+                    // downmix 6 to 1: M = (L + R) * 0.7071 + C + (SL + SR) * 0.5
+                    {6, 1, {{0.7071F, 0.7071F, 1.0F, 0.0F, 0.5F, 0.5F}}},
+                    // downmix 6 to 2: L = L + (C + SL) * 0.7071, R = R + (C + SR) * 0.7071
+                    {6, 2, {{1.0F, 0.0F, 0.7071F, 0.0F, 0.7071F, 0.0F}, {0.0F, 1.0F, 0.7071F, 0.0F, 0.0F, 0.7071F}}},
+                    // downmix 6 to 4: L = L + C * 0.7071, R = R + C * 0.7071, SL = SL, SR = SR
+                    {6, 4, {{1.0F, 0.0F, 0.7071F, 0.0F, 0.0F, 0.0F}, {0.0F, 1.0F, 0.7071F, 0.0F, 0.0F, 0.0F}, {0.0F, 0.0F, 0.0F, 0.0F, 1.0F, 0.0F}, {0.0F, 0.0F, 0.0F, 0.0F, 0.0F, 1.0F}}}
+                };
+
+                inline int16_t toInt16(float sample) noexcept
+                {
+                    return static_cast<int16_t>(clamp(sample, -1.0F, 1.0F) * 32767.0F);
+                }
+
+                // destination += sources[0] * gains[0] + sources[1] * gains[1] + ..., in a single pass over the destination
+                void addMixedSamples(const float* const* sources, const float* gains, uint32_t termCount,
+                                     float* destination, uint32_t count) noexcept
+                {
+                    uint32_t i = 0;
+
+                    if (isSimdAvailable)
+                    {
+#if defined(__ARM_NEON__)
+                        for (; i + 4 <= count; i += 4)
+                        {
+                            float32x4_t result = vld1q_f32(destination + i);
+                            for (uint32_t term = 0; term < termCount; ++term)
+                                result = vmlaq_n_f32(result, vld1q_f32(sources[term] + i), gains[term]);
+                            vst1q_f32(destination + i, result);
+                        }
+#elif defined(__SSE2__)
+                        __m128 gainVectors[MAX_MATRIX_CHANNELS];
+                        for (uint32_t term = 0; term < termCount; ++term)
+                            gainVectors[term] = _mm_set1_ps(gains[term]);
+
+                        // the downmixes to stereo have two terms per channel, the term loop is unrolled for them
+                        if (termCount == 2)
+                        {
+                            for (; i + 4 <= count; i += 4)
+                            {
+                                const __m128 first = _mm_mul_ps(_mm_loadu_ps(sources[0] + i), gainVectors[0]);
+                                const __m128 second = _mm_mul_ps(_mm_loadu_ps(sources[1] + i), gainVectors[1]);
+                                _mm_storeu_ps(destination + i, _mm_add_ps(_mm_add_ps(_mm_loadu_ps(destination + i), first), second));
+                            }
+                        }
+
+                        for (; i + 4 <= count; i += 4)
+                        {
+                            __m128 result = _mm_loadu_ps(destination + i);
+                            for (uint32_t term = 0; term < termCount; ++term)
+                                result = _mm_add_ps(result, _mm_mul_ps(_mm_loadu_ps(sources[term] + i), gainVectors[term]));
+                            _mm_storeu_ps(destination + i, result);
+                        }
+#endif
+                    }
+
+                    for (; i < count; ++i)
+                    {
+                        float result = destination[i];
+                        for (uint32_t term = 0; term < termCount; ++term)
+                            result += sources[term][i] * gains[term];
+                        destination[i] = result;
+                    }
+                }
+            }
+
+            void addSamples(const float* source, float* destination, uint32_t count) noexcept
+            {
+                uint32_t i = 0;
+
+                if (isSimdAvailable)
+                {
+#if defined(__ARM_NEON__)
+                    for (; i + 4 <= count; i += 4)
+                        vst1q_f32(destination + i, vaddq_f32(vld1q_f32(destination + i), vld1q_f32(source + i)));
+#elif defined(__SSE2__)
+                    // two vectors per iteration, so that the loads of the second one overlap the first addition
+                    for (; i + 8 <= count; i += 8)
+                    {
+                        const __m128 first = _mm_add_ps(_mm_loadu_ps(destination + i), _mm_loadu_ps(source + i));
+                        const __m128 second = _mm_add_ps(_mm_loadu_ps(destination + i + 4), _mm_loadu_ps(source + i + 4));
+                        _mm_storeu_ps(destination + i, first);
+                        _mm_storeu_ps(destination + i + 4, second);
+                    }
+
+                    for (; i + 4 <= count; i += 4)
+                        _mm_storeu_ps(destination + i, _mm_add_ps(_mm_loadu_ps(destination + i), _mm_loadu_ps(source + i)));
+#endif
+                }
+
+                for (; i < count; ++i)
+                    destination[i] += source[i];
+            }
+
+            void addScaledSamples(const float* source, float gain, float* destination, uint32_t count) noexcept
+            {
+                uint32_t i = 0;
+
+                if (isSimdAvailable)
+                {
+#if defined(__ARM_NEON__)
+                    for (; i + 4 <= count; i += 4)
+                        vst1q_f32(destination + i, vmlaq_n_f32(vld1q_f32(destination + i), vld1q_f32(source + i), gain));
+#elif defined(__SSE2__)
+                    const __m128 gainVector = _mm_set1_ps(gain);
+
+                    for (; i + 4 <= count; i += 4)
+                        _mm_storeu_ps(destination + i, _mm_add_ps(_mm_loadu_ps(destination + i),
+                                                                  _mm_mul_ps(_mm_loadu_ps(source + i), gainVector)));
+#endif
+                }
+
+                for (; i < count; ++i)
+                    destination[i] += source[i] * gain;
+            }
+
+            void clampSamples(float* samples, uint32_t count) noexcept
+            {
+                uint32_t i = 0;
+
+                if (isSimdAvailable)
+                {
+#if defined(__ARM_NEON__)
+                    const float32x4_t minimum = vdupq_n_f32(-1.0F);
+                    const float32x4_t maximum = vdupq_n_f32(1.0F);
+
+                    for (; i + 4 <= count; i += 4)
+                        vst1q_f32(samples + i, vminq_f32(vmaxq_f32(vld1q_f32(samples + i), minimum), maximum));
+#elif defined(__SSE2__)
+                    const __m128 minimum = _mm_set1_ps(-1.0F);
+                    const __m128 maximum = _mm_set1_ps(1.0F);
+
+                    for (; i + 4 <= count; i += 4)
+                        _mm_storeu_ps(samples + i, _mm_min_ps(_mm_max_ps(_mm_loadu_ps(samples + i), minimum), maximum));
+#endif
+                }
+
+                for (; i < count; ++i)
+                    samples[i] = clamp(samples[i], -1.0F, 1.0F);
+            }
+
+            void resampleSamples(uint32_t channels,
+                                 uint32_t sourceFrames, const float* source,
+                                 uint32_t frames, float* destination) noexcept
+            {
+                if (frames == 0) return;
+
+                if (sourceFrames < 2 || frames < 2)
+                {
+                    // there is nothing to interpolate between
+                    for (uint32_t channel = 0; channel < channels; ++channel)
+                        std::fill(destination + channel * frames,
+                                  destination + (channel + 1) * frames,
+                                  sourceFrames ? source[channel * sourceFrames] : 0.0F);
+                    return;
+                }
+
+                const float sourceIncrement = static_cast<float>(sourceFrames - 1) / static_cast<float>(frames - 1);
+                const uint32_t lastSourceFrame = sourceFrames - 2; // the last frame that has a next frame
+
+                uint32_t frame = 0;
+
+                // the positions of four frames are computed once and used for all the channels
+                if (isSimdAvailable)
+                {
+#if defined(__ARM_NEON__)
+                    const float32x4_t offsets = {0.0F, 1.0F, 2.0F, 3.0F};
+
+                    for (; frame + 4 <= frames - 1; frame += 4)
+                    {
+                        const float32x4_t positions = vmulq_n_f32(vaddq_f32(vdupq_n_f32(static_cast<float>(frame)), offsets),
+                                                                  sourceIncrement);
+                        const uint32x4_t indices = vminq_u32(vcvtq_u32_f32(positions), vdupq_n_u32(lastSourceFrame));
+                        const float32x4_t fractions = vsubq_f32(positions, vcvtq_f32_u32(indices));
+
+                        uint32_t sourceIndices[4];
+                        vst1q_u32(sourceIndices, indices);
+
+                        for (uint32_t channel = 0; channel < channels; ++channel)
+                        {
+                            const float* sourceChannel = source + channel * sourceFrames;
+
+                            const float currentValues[4] = {
+                                sourceChannel[sourceIndices[0]], sourceChannel[sourceIndices[1]],
+                                sourceChannel[sourceIndices[2]], sourceChannel[sourceIndices[3]]
+                            };
+                            const float nextValues[4] = {
+                                sourceChannel[sourceIndices[0] + 1], sourceChannel[sourceIndices[1] + 1],
+                                sourceChannel[sourceIndices[2] + 1], sourceChannel[sourceIndices[3] + 1]
+                            };
+
+                            const float32x4_t current = vld1q_f32(currentValues);
+                            const float32x4_t next = vld1q_f32(nextValues);
+                            vst1q_f32(destination + channel * frames + frame, vmlaq_f32(current, vsubq_f32(next, current), fractions));
+                        }
+                    }
+#elif defined(__SSE2__)
+                    const __m128 offsets = _mm_setr_ps(0.0F, 1.0F, 2.0F, 3.0F);
+                    const __m128 increment = _mm_set1_ps(sourceIncrement);
+                    const __m128i lastIndex = _mm_set1_epi32(static_cast<int32_t>(lastSourceFrame));
+
+                    for (; frame + 4 <= frames - 1; frame += 4)
+                    {
+                        const __m128 positions = _mm_mul_ps(_mm_add_ps(_mm_set1_ps(static_cast<float>(frame)), offsets),
+                                                            increment);
+                        __m128i indices = _mm_cvttps_epi32(positions);
+
+                        // SSE2 has no integer minimum, the indices past the last frame are replaced with it
+                        const __m128i pastLast = _mm_cmpgt_epi32(indices, lastIndex);
+                        indices = _mm_or_si128(_mm_and_si128(pastLast, lastIndex), _mm_andnot_si128(pastLast, indices));
+
+                        const __m128 fractions = _mm_sub_ps(positions, _mm_cvtepi32_ps(indices));
+
+                        alignas(16) int32_t sourceIndices[4];
+                        _mm_store_si128(reinterpret_cast<__m128i*>(sourceIndices), indices);
+
+                        for (uint32_t channel = 0; channel < channels; ++channel)
+                        {
+                            const float* sourceChannel = source + channel * sourceFrames;
+
+                            const __m128 current = _mm_setr_ps(sourceChannel[sourceIndices[0]], sourceChannel[sourceIndices[1]],
+                                                               sourceChannel[sourceIndices[2]], sourceChannel[sourceIndices[3]]);
+                            const __m128 next = _mm_setr_ps(sourceChannel[sourceIndices[0] + 1], sourceChannel[sourceIndices[1] + 1],
+                                                            sourceChannel[sourceIndices[2] + 1], sourceChannel[sourceIndices[3] + 1]);
+
+                            _mm_storeu_ps(destination + channel * frames + frame,
+                                          _mm_add_ps(current, _mm_mul_ps(_mm_sub_ps(next, current), fractions)));
+                        }
+                    }
+#endif
+                }
+
+                for (uint32_t channel = 0; channel < channels; ++channel)
+                {
+                    const float* sourceChannel = source + channel * sourceFrames;
+                    float* outputChannel = destination + channel * frames;
+
+                    for (uint32_t remainingFrame = frame; remainingFrame < frames - 1; ++remainingFrame)
+                    {
+                        const float sourcePosition = static_cast<float>(remainingFrame) * sourceIncrement;
+                        const uint32_t sourceCurrentFrame = std::min(static_cast<uint32_t>(sourcePosition), lastSourceFrame);
+                        const float fraction = sourcePosition - static_cast<float>(sourceCurrentFrame);
+
+                        outputChannel[remainingFrame] = lerp(sourceChannel[sourceCurrentFrame],
+                                                             sourceChannel[sourceCurrentFrame + 1],
+                                                             fraction);
+                    }
+
+                    // fill the last frame of the destination with the last frame of the source
+                    outputChannel[frames - 1] = sourceChannel[sourceFrames - 1];
+                }
+            }
+
+            void addConvertedSamples(uint32_t frames,
+                                     uint32_t sourceChannels, const float* source,
+                                     uint32_t channels, float* destination) noexcept
+            {
+                if (sourceChannels == channels)
+                {
+                    addSamples(source, destination, frames * channels);
+                    return;
+                }
+
+                for (const ChannelMatrix& matrix : CHANNEL_MATRICES)
+                {
+                    if (matrix.sourceChannels == sourceChannels && matrix.channels == channels)
+                    {
+                        // every destination channel is read and written once, whatever the number of its source channels
+                        for (uint32_t channel = 0; channel < channels; ++channel)
+                        {
+                            const float* sources[MAX_MATRIX_CHANNELS];
+                            float gains[MAX_MATRIX_CHANNELS];
+                            uint32_t termCount = 0;
+
+                            for (uint32_t sourceChannel = 0; sourceChannel < sourceChannels; ++sourceChannel)
+                            {
+                                const float gain = matrix.gains[channel][sourceChannel];
+
+                                if (gain != 0.0F)
+                                {
+                                    sources[termCount] = source + sourceChannel * frames;
+                                    gains[termCount] = gain;
+                                    ++termCount;
+                                }
+                            }
+
+                            if (termCount == 1 && gains[0] == 1.0F)
+                                addSamples(sources[0], destination + channel * frames, frames);
+                            else if (termCount)
+                                addMixedSamples(sources, gains, termCount, destination + channel * frames, frames);
+                        }
+
+                        return;
+                    }
+                }
+
+                // unknown layout, map the channels one to one
+                for (uint32_t channel = 0; channel < std::min(sourceChannels, channels); ++channel)
+                    addSamples(source + channel * frames, destination + channel * frames, frames);
+            }
+
+            void interleaveSamples(uint32_t frames, uint32_t channels, const float* source, float* destination) noexcept
+            {
+                if (channels == 1)
+                    std::copy(source, source + frames, destination);
+                else if (channels == 2)
+                {
+                    const float* left = source;
+                    const float* right = source + frames;
+                    uint32_t frame = 0;
+
+                    if (isSimdAvailable)
+                    {
+#if defined(__ARM_NEON__)
+                        for (; frame + 4 <= frames; frame += 4)
+                        {
+                            float32x4x2_t result;
+                            result.val[0] = vld1q_f32(left + frame);
+                            result.val[1] = vld1q_f32(right + frame);
+                            vst2q_f32(destination + frame * 2, result);
+                        }
+#elif defined(__SSE2__)
+                        for (; frame + 4 <= frames; frame += 4)
+                        {
+                            const __m128 leftSamples = _mm_loadu_ps(left + frame);
+                            const __m128 rightSamples = _mm_loadu_ps(right + frame);
+                            _mm_storeu_ps(destination + frame * 2, _mm_unpacklo_ps(leftSamples, rightSamples));
+                            _mm_storeu_ps(destination + frame * 2 + 4, _mm_unpackhi_ps(leftSamples, rightSamples));
+                        }
+#endif
+                    }
+
+                    for (; frame < frames; ++frame)
+                    {
+                        destination[frame * 2 + 0] = left[frame];
+                        destination[frame * 2 + 1] = right[frame];
+                    }
+                }
+                else
+                {
+                    for (uint32_t channel = 0; channel < channels; ++channel)
+                    {
+                        const float* sourceChannel = source + channel * frames;
+
+                        for (uint32_t frame = 0; frame < frames; ++frame)
+                            destination[frame * channels + channel] = sourceChannel[frame];
+                    }
+                }
+            }
+
+            void interleaveSamples(uint32_t frames, uint32_t channels, const float* source, int16_t* destination) noexcept
+            {
+                if (channels == 1 || channels == 2)
+                {
+                    const float* left = source;
+                    const float* right = source + frames;
+                    uint32_t frame = 0;
+
+                    if (isSimdAvailable)
+                    {
+#if defined(__ARM_NEON__)
+                        const float32x4_t minimum = vdupq_n_f32(-1.0F);
+                        const float32x4_t maximum = vdupq_n_f32(1.0F);
+
+                        auto convert = [minimum, maximum](const float* samples) {
+                            const float32x4_t low = vminq_f32(vmaxq_f32(vld1q_f32(samples), minimum), maximum);
+                            const float32x4_t high = vminq_f32(vmaxq_f32(vld1q_f32(samples + 4), minimum), maximum);
+                            return vcombine_s16(vqmovn_s32(vcvtq_s32_f32(vmulq_n_f32(low, 32767.0F))),
+                                                vqmovn_s32(vcvtq_s32_f32(vmulq_n_f32(high, 32767.0F))));
+                        };
+
+                        if (channels == 1)
+                        {
+                            for (; frame + 8 <= frames; frame += 8)
+                                vst1q_s16(destination + frame, convert(left + frame));
+                        }
+                        else
+                        {
+                            for (; frame + 8 <= frames; frame += 8)
+                            {
+                                int16x8x2_t result;
+                                result.val[0] = convert(left + frame);
+                                result.val[1] = convert(right + frame);
+                                vst2q_s16(destination + frame * 2, result);
+                            }
+                        }
+#elif defined(__SSE2__)
+                        const __m128 minimum = _mm_set1_ps(-1.0F);
+                        const __m128 maximum = _mm_set1_ps(1.0F);
+                        const __m128 scale = _mm_set1_ps(32767.0F);
+
+                        auto convert = [minimum, maximum, scale](const float* samples) {
+                            const __m128 low = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(samples), minimum), maximum);
+                            const __m128 high = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(samples + 4), minimum), maximum);
+                            return _mm_packs_epi32(_mm_cvttps_epi32(_mm_mul_ps(low, scale)),
+                                                   _mm_cvttps_epi32(_mm_mul_ps(high, scale)));
+                        };
+
+                        if (channels == 1)
+                        {
+                            for (; frame + 8 <= frames; frame += 8)
+                                _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + frame), convert(left + frame));
+                        }
+                        else
+                        {
+                            for (; frame + 8 <= frames; frame += 8)
+                            {
+                                const __m128i leftSamples = convert(left + frame);
+                                const __m128i rightSamples = convert(right + frame);
+                                _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + frame * 2),
+                                                 _mm_unpacklo_epi16(leftSamples, rightSamples));
+                                _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + frame * 2 + 8),
+                                                 _mm_unpackhi_epi16(leftSamples, rightSamples));
+                            }
+                        }
+#endif
+                    }
+
+                    for (; frame < frames; ++frame)
+                    {
+                        destination[frame * channels] = toInt16(left[frame]);
+                        if (channels == 2) destination[frame * channels + 1] = toInt16(right[frame]);
+                    }
+                }
+                else
+                {
+                    for (uint32_t channel = 0; channel < channels; ++channel)
+                    {
+                        const float* sourceChannel = source + channel * frames;
+
+                        for (uint32_t frame = 0; frame < frames; ++frame)
+                            destination[frame * channels + channel] = toInt16(sourceChannel[frame]);
+                    }
+                }
+            }
+        }
+    } // namespace audio
+} // namespace ouzel
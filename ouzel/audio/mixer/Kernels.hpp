@@ -0,0 +1,40 @@
+// Copyright 2015-2019 Elviss Strazdins. All rights reserved.
+
+#ifndef OUZEL_AUDIO_MIXER_KERNELS_HPP
+#define OUZEL_AUDIO_MIXER_KERNELS_HPP
+
+#include <cstdint>
+
+namespace ouzel
+{
+    namespace audio
+    {
+        namespace mixer
+        {
+            // destination += source
+            void addSamples(const float* source, float* destination, uint32_t count) noexcept;
+
+            // destination += source * gain
+            void addScaledSamples(const float* source, float gain, float* destination, uint32_t count) noexcept;
+
+            // clamps the samples to [-1, 1]
+            void clampSamples(float* samples, uint32_t count) noexcept;
+
+            // linearly resamples the planar source, the first and the last frames of the source and the destination match
+            void resampleSamples(uint32_t channels,
+                                 uint32_t sourceFrames, const float* source,
+                                 uint32_t frames, float* destination) noexcept;
+
+            // destination += channel matrix * source, both buffers are planar
+            void addConvertedSamples(uint32_t frames,
+                                     uint32_t sourceChannels, const float* source,
+                                     uint32_t channels, float* destination) noexcept;
+
+            // converts the planar samples to interleaved ones
+            void interleaveSamples(uint32_t frames, uint32_t channels, const float* source, float* destination) noexcept;
+            void interleaveSamples(uint32_t frames, uint32_t channels, const float* source, int16_t* destination) noexcept;
+        }
+    } // namespace audio
+} // namespace ouzel
+
+#endif // OUZEL_AUDIO_MIXER_KERNELS_HPP
@@ -1,10 +1,11 @@
 // Copyright 2015-2019 Elviss Strazdins. All rights reserved.
 
+#include <chrono>
 #include "Mixer.hpp"
 #include "Bus.hpp"
 #include "Data.hpp"
+#include "Kernels.hpp"
 #include "Stream.hpp"
-#include "math/MathUtils.hpp"
 
 namespace ouzel
 {
@@ -13,114 +14,152 @@ namespace ouzel
         namespace mixer
         {
             Mixer::Mixer(uint32_t initBufferSize,
+                         uint32_t initSampleRate,
                          uint32_t initChannels,
+                         uint32_t initLookahead,
                          const std::function<void(const Event&)>& initCallback):
                 bufferSize(initBufferSize),
+                sampleRate(initSampleRate),
                 channels(initChannels),
                 callback(initCallback),
-                mixerThread(&Mixer::mixerMain, this),
-                buffer(initBufferSize * 3, initChannels)
+                buffer(initBufferSize * std::max(initLookahead, 1U), initChannels),
+                mixBuffer(initBufferSize * initChannels),
+                minBufferedFrames(buffer.getMaxFrames())
             {
-                //mixerThread.setPriority(20.0F, true);
-
                 rootObjectId = getObjectId();
-                objects.resize(rootObjectId);
                 auto object = std::make_unique<RootObject>();
                 rootObject = object.get();
-                objects[rootObjectId - 1] = std::move(object);
+                getObject(rootObjectId) = std::move(object);
+
+#if !defined(__EMSCRIPTEN__)
+                mixerThread = Thread(&Mixer::mixerMain, this);
+                //mixerThread.setPriority(20.0F, true);
+#endif
             }
 
             Mixer::~Mixer()
             {
+                std::unique_lock<std::mutex> lock(bufferMutex);
+                running = false;
+                lock.unlock();
+                bufferCondition.notify_all();
+
                 if (mixerThread.isJoinable())
                     mixerThread.join();
             }
 
+            void Mixer::submitCommandBuffer(CommandBuffer&& commandBuffer)
+            {
+                // destroy the commands (and the objects deleted by them) that the mixer thread has processed
+                CommandBuffer processedCommandBuffer;
+                while (processedCommandBuffers.pop(processedCommandBuffer))
+                {
+                    processedCommandBuffer = CommandBuffer();
+                    --queuedCommandBuffers;
+                }
+
+                if (!commandBuffer.isEmpty())
+                    pendingCommandBuffers.push(std::move(commandBuffer));
+
+                // at most as many buffers as the queues hold are in flight, so the mixer thread can always hand them back
+                while (!pendingCommandBuffers.empty() &&
+                       queuedCommandBuffers < COMMAND_BUFFER_COUNT &&
+                       commandQueue.push(std::move(pendingCommandBuffers.front())))
+                {
+                    pendingCommandBuffers.pop();
+                    ++queuedCommandBuffers;
+                }
+            }
+
+            void Mixer::dispatchEvents()
+            {
+                const uint32_t currentStarvationCount = starvationCount.load(std::memory_order_relaxed);
+
+                if (currentStarvationCount != reportedStarvationCount)
+                {
+                    reportedStarvationCount = currentStarvationCount;
+                    if (callback) callback(Event(Event::Type::Starvation));
+                }
+            }
+
             void Mixer::process()
             {
                 CommandBuffer commandBuffer;
-                std::unique_ptr<Command> command;
 
-                for (;;)
+                while (commandQueue.pop(commandBuffer))
                 {
-                    std::unique_lock<std::mutex> lock(commandQueueMutex);
-                    if (commandQueue.empty()) break;
-                    commandBuffer = std::move(commandQueue.front());
-                    commandQueue.pop();
-                    lock.unlock();
-
-                    while (!commandBuffer.isEmpty())
+                    for (const auto& command : commandBuffer.getCommands())
                     {
-                        command = commandBuffer.popCommand();
-
                         switch (command->type)
                         {
                             case Command::Type::InitObject:
                             {
                                 auto initObjectCommand = static_cast<InitObjectCommand*>(command.get());
-                                objects[initObjectCommand->objectId - 1] = std::make_unique<Object>(std::move(initObjectCommand->source));
+                                getObject(initObjectCommand->objectId) = std::move(initObjectCommand->object);
                                 break;
                             }
                             case Command::Type::DeleteObject:
                             {
-                                auto deleteObjectCommand = static_cast<const DeleteObjectCommand*>(command.get());
-                                objects[deleteObjectCommand->objectId - 1].reset();
+                                auto deleteObjectCommand = static_cast<DeleteObjectCommand*>(command.get());
+                                std::unique_ptr<Object>& object = getObject(deleteObjectCommand->objectId);
+
+                                if (object.get() == masterBus) masterBus = nullptr;
+
+                                // the object is destroyed together with the command on the game thread
+                                if (object) object->detach();
+                                deleteObjectCommand->object = std::move(object);
                                 break;
                             }
                             case Command::Type::AddChild:
                             {
                                 auto addChildCommand = static_cast<const AddChildCommand*>(command.get());
-                                Object* object = objects[addChildCommand->objectId - 1].get();
-                                Object* child = objects[addChildCommand->objectId - 1].get();
+                                Object* object = getObject(addChildCommand->objectId).get();
+                                Object* child = getObject(addChildCommand->childId).get();
                                 object->addChild(*child);
                                 break;
                             }
                             case Command::Type::RemoveChild:
                             {
                                 auto removeChildCommand = static_cast<const RemoveChildCommand*>(command.get());
-                                Object* object = objects[removeChildCommand->objectId - 1].get();
-                                Object* child = objects[removeChildCommand->objectId - 1].get();
+                                Object* object = getObject(removeChildCommand->objectId).get();
+                                Object* child = getObject(removeChildCommand->childId).get();
                                 object->removeChild(*child);
                                 break;
                             }
                             case Command::Type::Play:
                             {
                                 auto playCommand = static_cast<const PlayCommand*>(command.get());
-                                Object* object = objects[playCommand->objectId - 1].get();
+                                Object* object = getObject(playCommand->objectId).get();
                                 object->play();
                                 break;
                             }
                             case Command::Type::Stop:
                             {
                                 auto stopCommand = static_cast<const StopCommand*>(command.get());
-                                Object* object = objects[stopCommand->objectId - 1].get();
+                                Object* object = getObject(stopCommand->objectId).get();
                                 object->stop(stopCommand->reset);
                                 break;
                             }
                             case Command::Type::InitBus:
                             {
-                                auto initBusCommand = static_cast<const InitBusCommand*>(command.get());
-
-                                if (initBusCommand->busId > objects.size())
-                                    objects.resize(initBusCommand->busId);
-
-                                objects[initBusCommand->busId - 1] = std::make_unique<Bus>();
+                                auto initBusCommand = static_cast<InitBusCommand*>(command.get());
+                                getObject(initBusCommand->busId) = std::move(initBusCommand->bus);
                                 break;
                             }
                             case Command::Type::SetBusOutput:
                             {
                                 auto setBusOutputCommand = static_cast<const SetBusOutputCommand*>(command.get());
 
-                                Bus* bus = static_cast<Bus*>(objects[setBusOutputCommand->busId - 1].get());
-                                bus->setOutput(setBusOutputCommand->outputBusId ? static_cast<Bus*>(objects[setBusOutputCommand->outputBusId - 1].get()) : nullptr);
+                                Bus* bus = static_cast<Bus*>(getObject(setBusOutputCommand->busId).get());
+                                bus->setOutput(setBusOutputCommand->outputBusId ? static_cast<Bus*>(getObject(setBusOutputCommand->outputBusId).get()) : nullptr);
                                 break;
                             }
                             case Command::Type::AddProcessor:
                             {
                                 auto addProcessorCommand = static_cast<const AddProcessorCommand*>(command.get());
 
-                                Bus* bus = static_cast<Bus*>(objects[addProcessorCommand->busId - 1].get());
-                                Processor* processor = static_cast<Processor*>(objects[addProcessorCommand->processorId - 1].get());
+                                Bus* bus = static_cast<Bus*>(getObject(addProcessorCommand->busId).get());
+                                Processor* processor = static_cast<Processor*>(getObject(addProcessorCommand->processorId).get());
                                 bus->addProcessor(processor);
                                 break;
                             }
@@ -128,8 +167,8 @@ namespace ouzel
                             {
                                 auto removeProcessorCommand = static_cast<const RemoveProcessorCommand*>(command.get());
 
-                                Bus* bus = static_cast<Bus*>(objects[removeProcessorCommand->busId - 1].get());
-                                Processor* processor = static_cast<Processor*>(objects[removeProcessorCommand->processorId - 1].get());
+                                Bus* bus = static_cast<Bus*>(getObject(removeProcessorCommand->busId).get());
+                                Processor* processor = static_cast<Processor*>(getObject(removeProcessorCommand->processorId).get());
                                 bus->removeProcessor(processor);
                                 break;
                             }
@@ -137,25 +176,20 @@ namespace ouzel
                             {
                                 auto setMasterBusCommand = static_cast<const SetMasterBusCommand*>(command.get());
 
-                                masterBus = setMasterBusCommand->busId ? static_cast<Bus*>(objects[setMasterBusCommand->busId - 1].get()) : nullptr;
+                                masterBus = setMasterBusCommand->busId ? static_cast<Bus*>(getObject(setMasterBusCommand->busId).get()) : nullptr;
                                 break;
                             }
                             case Command::Type::InitStream:
                             {
-                                auto initStreamCommand = static_cast<const InitStreamCommand*>(command.get());
-
-                                if (initStreamCommand->streamId > objects.size())
-                                    objects.resize(initStreamCommand->streamId);
-
-                                Data* data = static_cast<Data*>(objects[initStreamCommand->dataId - 1].get());
-                                objects[initStreamCommand->streamId - 1] = data->createStream();
+                                auto initStreamCommand = static_cast<InitStreamCommand*>(command.get());
+                                getObject(initStreamCommand->streamId) = std::move(initStreamCommand->stream);
                                 break;
                             }
                             case Command::Type::PlayStream:
                             {
                                 auto playStreamCommand = static_cast<const PlayStreamCommand*>(command.get());
 
-                                Stream* stream = static_cast<Stream*>(objects[playStreamCommand->streamId - 1].get());
+                                Stream* stream = static_cast<Stream*>(getObject(playStreamCommand->streamId).get());
                                 stream->play();
                                 break;
                             }
@@ -163,43 +197,44 @@ namespace ouzel
                             {
                                 auto stopStreamCommand = static_cast<const StopStreamCommand*>(command.get());
 
-                                Stream* stream = static_cast<Stream*>(objects[stopStreamCommand->streamId - 1].get());
+                                Stream* stream = static_cast<Stream*>(getObject(stopStreamCommand->streamId).get());
                                 stream->stop(stopStreamCommand->reset);
                                 break;
                             }
+                            case Command::Type::SeekStream:
+                            {
+                                auto seekStreamCommand = static_cast<const SeekStreamCommand*>(command.get());
+
+                                Stream* stream = static_cast<Stream*>(getObject(seekStreamCommand->streamId).get());
+                                const float frame = seekStreamCommand->time * static_cast<float>(stream->getData().getSampleRate());
+                                stream->seek(frame > 0.0F ? static_cast<uint32_t>(frame) : 0);
+                                break;
+                            }
                             case Command::Type::SetStreamOutput:
                             {
                                 auto setStreamOutputCommand = static_cast<const SetStreamOutputCommand*>(command.get());
 
-                                Stream* stream = static_cast<Stream*>(objects[setStreamOutputCommand->streamId - 1].get());
-                                stream->setOutput(setStreamOutputCommand->busId ? static_cast<Bus*>(objects[setStreamOutputCommand->busId - 1].get()) : nullptr);
+                                Stream* stream = static_cast<Stream*>(getObject(setStreamOutputCommand->streamId).get());
+                                stream->setOutput(setStreamOutputCommand->busId ? static_cast<Bus*>(getObject(setStreamOutputCommand->busId).get()) : nullptr);
                                 break;
                             }
                             case Command::Type::InitData:
                             {
                                 auto initDataCommand = static_cast<InitDataCommand*>(command.get());
-
-                                if (initDataCommand->dataId > objects.size())
-                                    objects.resize(initDataCommand->dataId);
-
-                                objects[initDataCommand->dataId - 1] = std::move(initDataCommand->data);
+                                getObject(initDataCommand->dataId) = std::move(initDataCommand->data);
                                 break;
                             }
                             case Command::Type::InitProcessor:
                             {
                                 auto initProcessorCommand = static_cast<InitProcessorCommand*>(command.get());
-
-                                if (initProcessorCommand->processorId > objects.size())
-                                    objects.resize(initProcessorCommand->processorId);
-
-                                objects[initProcessorCommand->processorId - 1] = std::move(initProcessorCommand->processor);
+                                getObject(initProcessorCommand->processorId) = std::move(initProcessorCommand->processor);
                                 break;
                             }
                             case Command::Type::UpdateProcessor:
                             {
                                 auto updateProcessorCommand = static_cast<const UpdateProcessorCommand*>(command.get());
 
-                                Processor* processor = static_cast<Processor*>(objects[updateProcessorCommand->processorId - 1].get());
+                                Processor* processor = static_cast<Processor*>(getObject(updateProcessorCommand->processorId).get());
                                 updateProcessorCommand->updateFunction(processor);
                                 break;
                             }
@@ -207,13 +242,52 @@ namespace ouzel
                                 throw std::runtime_error("Invalid command");
                         }
                     }
+
+                    // hand the buffer back to the game thread
+                    processedCommandBuffers.push(std::move(commandBuffer));
                 }
             }
 
-            void Mixer::getSamples(uint32_t frames, uint32_t channels, uint32_t sampleRate, std::vector<float>& samples)
+            void Mixer::getSamples(uint32_t frames, uint32_t deviceChannels, uint32_t deviceSampleRate, std::vector<float>& samples)
             {
+                samples.resize(frames * deviceChannels);
+
+                if (deviceChannels != channels || deviceSampleRate != sampleRate)
+                {
+                    std::fill(samples.begin(), samples.end(), 0.0F);
+                    return;
+                }
+
+#if defined(__EMSCRIPTEN__)
                 process();
+                mix(frames, samples);
+#else
+                // the device only copies the samples that the mixer thread has prepared
+                const uint32_t bufferedFrames = buffer.getFrames();
+                const uint32_t readFrames = buffer.read(frames, samples.data());
+
+                if (readFrames < frames)
+                {
+                    // fill the rest with silence
+                    for (uint32_t channel = 0; channel < channels; ++channel)
+                        std::fill(samples.begin() + channel * frames + readFrames,
+                                  samples.begin() + (channel + 1) * frames,
+                                  0.0F);
 
+                    starvationCount.fetch_add(1, std::memory_order_relaxed);
+                }
+
+                uint32_t currentMinBufferedFrames = minBufferedFrames.load(std::memory_order_relaxed);
+                while (bufferedFrames < currentMinBufferedFrames &&
+                       !minBufferedFrames.compare_exchange_weak(currentMinBufferedFrames, bufferedFrames,
+                                                                std::memory_order_relaxed));
+
+                bufferCondition.notify_one();
+#endif
+            }
+
+            void Mixer::mix(uint32_t frames, std::vector<float>& samples)
+            {
                 samples.resize(frames * channels);
 
                 if (masterBus)
@@ -222,35 +296,35 @@ namespace ouzel
                     QuaternionF listenerRotation;
 
                     masterBus->getSamples(frames, channels, sampleRate, listenerPosition, listenerRotation, samples);
-                }
 
-                for (float& sample : samples)
-                    sample = clamp(sample, -1.0F, 1.0F);
+                    clampSamples(samples.data(), frames * channels);
+                }
+                else
+                    std::fill(samples.begin(), samples.end(), 0.0F);
             }
 
             void Mixer::mixerMain()
             {
                 Thread::setCurrentThreadName("Mixer");
 
-                for (;;)
-                {
-                    break; // TODO: remove
+                // wake up at least once per period to process the commands even if the device is not reading
+                const auto period = std::chrono::microseconds(sampleRate ? bufferSize * 1000000ULL / sampleRate : 10000);
 
+                while (running)
+                {
                     process();
 
-                    std::unique_lock<std::mutex> lock(bufferMutex);
-                    bufferCondition.wait(lock);
-
-                    if (masterBus)
+                    while (running && buffer.getMaxFrames() - buffer.getFrames() >= bufferSize)
                     {
-                        //Vector3F listenerPosition;
-                        //QuaternionF listenerRotation;
-
-                        //masterBus->getData(frames, channels, sampleRate, listenerPosition, listenerRotation, samples);
+                        mix(bufferSize, mixBuffer);
+                        buffer.write(bufferSize, mixBuffer.data());
+                        process();
                     }
 
-                    //for (float& f : samples)
-                    //    f = clamp(f, -1.0F, 1.0F);
+                    std::unique_lock<std::mutex> lock(bufferMutex);
+                    bufferCondition.wait_for(lock, period, [this]() {
+                        return !running || buffer.getMaxFrames() - buffer.getFrames() >= bufferSize;
+                    });
                 }
             }
         }
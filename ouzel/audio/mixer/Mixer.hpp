@@ -3,17 +3,24 @@
 #ifndef OUZEL_AUDIO_MIXER_MIXER_HPP
 #define OUZEL_AUDIO_MIXER_MIXER_HPP
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <condition_variable>
 #include <cstdint>
 #include <functional>
+#include <memory>
 #include <mutex>
 #include <queue>
 #include <set>
+#include <stdexcept>
 #include <thread>
 #include <vector>
 #include "audio/mixer/Commands.hpp"
+#include "audio/mixer/Decoder.hpp"
 #include "audio/mixer/Object.hpp"
 #include "audio/mixer/Processor.hpp"
+#include "utils/SpscQueue.hpp"
 #include "utils/Thread.hpp"
 
 namespace ouzel
@@ -62,11 +69,18 @@ namespace ouzel
                     explicit Event(Type initType) noexcept: type(initType) {}
 
                     Type type;
-                    uintptr_t objectId;
+                    uintptr_t objectId = 0;
                 };
 
+                static constexpr size_t COMMAND_BUFFER_COUNT = 16;
+                static constexpr size_t OBJECT_CHUNK_SIZE = 256;
+                static constexpr size_t MAX_OBJECT_CHUNKS = 1024;
+
+                // the mixer thread renders up to lookahead periods of bufferSize frames ahead of the device
                 Mixer(uint32_t initBufferSize,
+                      uint32_t initSampleRate,
                       uint32_t initChannels,
+                      uint32_t initLookahead,
                       const std::function<void(const Event&)>& initCallback);
 
                 ~Mixer();
@@ -80,12 +94,21 @@ namespace ouzel
                 void process();
                 void getSamples(uint32_t frames, uint32_t channels, uint32_t sampleRate, std::vector<float>& samples);
 
+                // the object slot is allocated before the id is returned, so that the mixer thread does not allocate memory
                 uintptr_t getObjectId()
                 {
                     auto i = deletedObjectIds.begin();
 
                     if (i == deletedObjectIds.end())
+                    {
+                        if (lastObjectId >= OBJECT_CHUNK_SIZE * MAX_OBJECT_CHUNKS)
+                            throw std::runtime_error("Too many audio objects");
+
+                        auto& chunk = objectChunks[lastObjectId / OBJECT_CHUNK_SIZE];
+                        if (!chunk) chunk = std::make_unique<ObjectChunk>();
+
                         return ++lastObjectId; // zero is reserved for null node
+                    }
                     else
                     {
                         uintptr_t objectId = *i;
@@ -99,63 +122,152 @@ namespace ouzel
                     deletedObjectIds.insert(objectId);
                 }
 
-                void submitCommandBuffer(CommandBuffer&& commandBuffer)
-                {
-                    std::unique_lock<std::mutex> lock(commandQueueMutex);
-                    commandQueue.push(std::move(commandBuffer));
-                    lock.unlock();
-                }
+                // called only from the game thread, never blocks the mixer thread
+                void submitCommandBuffer(CommandBuffer&& commandBuffer);
+
+                // reports the events that happened on the mixer thread since the last call
+                void dispatchEvents();
+
+                inline Decoder& getDecoder() noexcept { return decoder; }
 
                 inline auto getRootObjectId() const noexcept
                 {
                     return rootObjectId;
                 }
 
+                // number of times the device requested more frames than were mixed ahead
+                inline auto getStarvationCount() const noexcept
+                {
+                    return starvationCount.load(std::memory_order_relaxed);
+                }
+
+                inline uint32_t getBufferedFrames() const noexcept { return buffer.getFrames(); }
+                inline uint32_t getMaxBufferedFrames() const noexcept { return buffer.getMaxFrames(); }
+
+                // the lowest fill level of the buffer seen by the device since the last reset
+                inline auto getMinBufferedFrames() const noexcept
+                {
+                    return minBufferedFrames.load(std::memory_order_relaxed);
+                }
+
+                inline void resetMinBufferedFrames() noexcept
+                {
+                    minBufferedFrames.store(buffer.getMaxFrames(), std::memory_order_relaxed);
+                }
+
             private:
+                using ObjectChunk = std::array<std::unique_ptr<Object>, OBJECT_CHUNK_SIZE>;
+
+                inline std::unique_ptr<Object>& getObject(uintptr_t objectId) noexcept
+                {
+                    return (*objectChunks[(objectId - 1) / OBJECT_CHUNK_SIZE])[(objectId - 1) % OBJECT_CHUNK_SIZE];
+                }
+
+                void mix(uint32_t frames, std::vector<float>& samples);
                 void mixerMain();
 
                 uint32_t bufferSize;
+                uint32_t sampleRate;
                 uint32_t channels;
                 std::function<void(const Event&)> callback;
 
+                // destroyed after the objects, so that the streams can remove themselves from it
+                Decoder decoder;
+
                 uintptr_t lastObjectId = 0;
                 std::set<uintptr_t> deletedObjectIds;
 
-                std::vector<std::unique_ptr<Object>> objects;
+                // chunks are allocated on the game thread and never move, so the mixer thread can access them without locking
+                std::array<std::unique_ptr<ObjectChunk>, MAX_OBJECT_CHUNKS> objectChunks;
                 uintptr_t rootObjectId = 0;
                 RootObject* rootObject = nullptr;
 
                 Bus* masterBus = nullptr;
 
+                // interleaved samples written by the mixer thread and read by the device
                 class Buffer final
                 {
                 public:
-                    Buffer(size_t size, uint32_t initChannels):
-                        maxFrames(size),
+                    Buffer(uint32_t initMaxFrames, uint32_t initChannels):
+                        maxFrames(initMaxFrames),
                         channels(initChannels),
-                        buffer(size * channels)
+                        samples(initMaxFrames * initChannels)
+                    {
+                    }
+
+                    inline uint32_t getFrames() const noexcept
                     {
+                        return static_cast<uint32_t>(samples.getCount() / channels);
+                    }
+
+                    inline uint32_t getMaxFrames() const noexcept { return maxFrames; }
+
+                    // source contains frames of each channel one after another
+                    void write(uint32_t frames, const float* source) noexcept
+                    {
+                        const size_t tail = samples.getTail();
+                        float* data = samples.getData();
+
+                        // the capacity is a multiple of the channel count, so a frame never wraps around
+                        size_t offset = tail % samples.getCapacity();
+                        for (uint32_t frame = 0; frame < frames; ++frame)
+                        {
+                            for (uint32_t channel = 0; channel < channels; ++channel)
+                                data[offset + channel] = source[channel * frames + frame];
+
+                            offset += channels;
+                            if (offset == samples.getCapacity()) offset = 0;
+                        }
+
+                        samples.commit(tail + frames * channels);
                     }
 
-                    bool canRead() const { return frames > 0; }
-                    bool canWrite() const { return frames < maxFrames; }
+                    // reads up to frames frames into destination with frames samples per channel, returns the number of frames read
+                    uint32_t read(uint32_t frames, float* destination) noexcept
+                    {
+                        const size_t head = samples.getHead();
+                        const uint32_t readFrames = std::min(frames, static_cast<uint32_t>((samples.getTail() - head) / channels));
+                        const float* data = samples.getData();
+
+                        size_t offset = head % samples.getCapacity();
+                        for (uint32_t frame = 0; frame < readFrames; ++frame)
+                        {
+                            for (uint32_t channel = 0; channel < channels; ++channel)
+                                destination[channel * frames + frame] = data[offset + channel];
+
+                            offset += channels;
+                            if (offset == samples.getCapacity()) offset = 0;
+                        }
+
+                        samples.release(head + readFrames * channels);
+                        return readFrames;
+                    }
 
                 private:
-                    size_t frames = 0;
-                    size_t maxFrames;
+                    uint32_t maxFrames;
                     uint32_t channels;
-                    size_t readPosition = 0;
-                    size_t writePosition = 0;
-                    std::vector<float> buffer;
+                    SpscQueue<float> samples;
                 };
 
-                Thread mixerThread;
+                Buffer buffer;
+                std::vector<float> mixBuffer;
+                std::atomic<uint32_t> minBufferedFrames;
+
+                std::atomic<bool> running{true};
                 std::mutex bufferMutex;
                 std::condition_variable bufferCondition;
-                Buffer buffer;
 
-                std::queue<CommandBuffer> commandQueue;
-                std::mutex commandQueueMutex;
+                // the mixer thread hands the processed buffers back, so that the commands (and the objects deleted
+                // by them) are destroyed on the game thread
+                SpscQueue<CommandBuffer> commandQueue{COMMAND_BUFFER_COUNT};
+                SpscQueue<CommandBuffer> processedCommandBuffers{COMMAND_BUFFER_COUNT};
+                size_t queuedCommandBuffers = 0; // not yet reclaimed by the game thread
+                std::queue<CommandBuffer> pendingCommandBuffers; // waiting for free space in the queue
+
+                std::atomic<uint32_t> starvationCount{0};
+                uint32_t reportedStarvationCount = 0;
+
+                Thread mixerThread; // started after all the other members are initialized
             };
         }
     } // namespace audio
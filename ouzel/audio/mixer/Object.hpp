@@ -3,6 +3,7 @@
 #ifndef OUZEL_AUDIO_MIXER_OBJECT_HPP
 #define OUZEL_AUDIO_MIXER_OBJECT_HPP
 
+#include <algorithm>
 #include <cstdint>
 #include <memory>
 #include <vector>
@@ -27,8 +28,7 @@ namespace ouzel
 
                 virtual ~Object()
                 {
-                    if (parent)
-                        parent->removeChild(*this);
+                    Object::detach();
                 }
 
                 Object(const Object&) = delete;
@@ -60,12 +60,24 @@ namespace ouzel
                         auto i = std::find(children.begin(), children.end(), &child);
                         if (i != children.end())
                         {
-                            child.parent = this;
+                            child.parent = nullptr;
                             children.erase(i);
                         }
                     }
                 }
 
+                // removes all the links to and from other objects, after which the object can be destroyed on any thread
+                virtual void detach()
+                {
+                    if (parent)
+                        parent->removeChild(*this);
+
+                    for (Object* child : children)
+                        child->parent = nullptr;
+
+                    children.clear();
+                }
+
                 void play()
                 {
                     if (source)
@@ -19,7 +19,7 @@ namespace ouzel
                 Processor() noexcept = default;
                 ~Processor()
                 {
-                    if (bus) bus->removeProcessor(this);
+                    Processor::detach();
                 }
 
                 Processor(const Processor&) = delete;
@@ -28,6 +28,13 @@ namespace ouzel
                 Processor(Processor&&) = delete;
                 Processor& operator=(Processor&&) = delete;
 
+                void detach() override
+                {
+                    if (bus) bus->removeProcessor(this);
+
+                    Object::detach();
+                }
+
                 virtual void process(uint32_t frames, uint32_t channels, uint32_t sampleRate,
                                      std::vector<float>& samples) = 0;
 
@@ -27,7 +27,7 @@ namespace ouzel
 
                 ~Stream()
                 {
-                    if (output) output->removeInput(this);
+                    Stream::detach();
                 }
 
                 Stream(const Stream&) = delete;
@@ -36,6 +36,14 @@ namespace ouzel
                 Stream(Stream&&) = delete;
                 Stream& operator=(Stream&&) = delete;
 
+                void detach() override
+                {
+                    if (output) output->removeInput(this);
+                    output = nullptr;
+
+                    Object::detach();
+                }
+
                 auto& getData() const noexcept { return data; }
 
                 void setOutput(Bus* newOutput)
@@ -56,6 +64,9 @@ namespace ouzel
 
                 virtual void reset() = 0;
 
+                // moves the playback position to the frame of the data
+                virtual void seek(uint32_t frame) = 0;
+
                 virtual void getSamples(uint32_t frames, std::vector<float>& samples) = 0;
 
             protected:
@@ -159,7 +159,7 @@ namespace ouzel
                 else
                     extensions = explodeString(std::string(reinterpret_cast<const char*>(extensionsPtr)), ' ');
 
-                engine->log(Log::Level::All) << "Supported OpenAL extensions: " << extensions;
+                engine->log<Log::Level::All>() << "Supported OpenAL extensions: " << extensions;
 
                 auto float32Supported = false;
                 for (const std::string& extension : extensions)
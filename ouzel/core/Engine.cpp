@@ -20,8 +20,10 @@
 #    include "opengl/TextureVSGLES2.h"
 #    include "opengl/ColorPSGLES3.h"
 #    include "opengl/ColorVSGLES3.h"
+#    include "opengl/ColorVSInstancedGLES3.h"
 #    include "opengl/TexturePSGLES3.h"
 #    include "opengl/TextureVSGLES3.h"
+#    include "opengl/TextureVSInstancedGLES3.h"
 #  else
 #    include "opengl/ColorPSGL2.h"
 #    include "opengl/ColorVSGL2.h"
@@ -29,23 +31,31 @@
 #    include "opengl/TextureVSGL2.h"
 #    include "opengl/ColorPSGL3.h"
 #    include "opengl/ColorVSGL3.h"
+#    include "opengl/ColorVSInstancedGL3.h"
 #    include "opengl/TexturePSGL3.h"
 #    include "opengl/TextureVSGL3.h"
+#    include "opengl/TextureVSInstancedGL3.h"
 #    include "opengl/ColorPSGL4.h"
 #    include "opengl/ColorVSGL4.h"
+#    include "opengl/ColorVSInstancedGL4.h"
 #    include "opengl/TexturePSGL4.h"
 #    include "opengl/TextureVSGL4.h"
+#    include "opengl/TextureVSInstancedGL4.h"
 #  endif
 #endif
 
 #if OUZEL_COMPILE_DIRECT3D11
 #  include "direct3d11/TexturePSD3D11.h"
 #  include "direct3d11/TextureVSD3D11.h"
+#  include "direct3d11/TextureVSInstancedD3D11.h"
 #  include "direct3d11/ColorPSD3D11.h"
 #  include "direct3d11/ColorVSD3D11.h"
+#  include "direct3d11/ColorVSInstancedD3D11.h"
 #endif
 
 #if OUZEL_COMPILE_METAL
+#  include "metal/ColorVSInstancedMetal.h"
+#  include "metal/TextureVSInstancedMetal.h"
 #  if TARGET_OS_IOS
 #    include "metal/ColorPSIOS.h"
 #    include "metal/ColorVSIOS.h"
@@ -124,9 +134,11 @@ namespace ouzel
         bool depth = false;
         bool stencil = false;
         bool debugRenderer = false;
+        uint32_t framesInFlight = 2;
         bool exclusiveFullscreen = false;
         bool highDpi = true; // should high DPI resolution be used
         bool debugAudio = false;
+        uint32_t audioLookahead = 2;
 
         defaultSettings = ini::Data(fileSystem.readFile("settings.ini"));
 
@@ -192,6 +204,9 @@ namespace ouzel
         std::string debugRendererValue = userEngineSection.getValue("debugRenderer", defaultEngineSection.getValue("debugRenderer"));
         if (!debugRendererValue.empty()) debugRenderer = (debugRendererValue == "true" || debugRendererValue == "1" || debugRendererValue == "yes");
 
+        std::string framesInFlightValue = userEngineSection.getValue("framesInFlight", defaultEngineSection.getValue("framesInFlight"));
+        if (!framesInFlightValue.empty()) framesInFlight = static_cast<uint32_t>(std::stoul(framesInFlightValue));
+
         std::string highDpiValue = userEngineSection.getValue("highDpi", defaultEngineSection.getValue("highDpi"));
         if (!highDpiValue.empty()) highDpi = (highDpiValue == "true" || highDpiValue == "1" || highDpiValue == "yes");
 
@@ -200,6 +215,9 @@ namespace ouzel
         std::string debugAudioValue = userEngineSection.getValue("debugAudio", defaultEngineSection.getValue("debugAudio"));
         if (!debugAudioValue.empty()) debugAudio = (debugAudioValue == "true" || debugAudioValue == "1" || debugAudioValue == "yes");
 
+        std::string audioLookaheadValue = userEngineSection.getValue("audioLookahead", defaultEngineSection.getValue("audioLookahead"));
+        if (!audioLookaheadValue.empty()) audioLookahead = static_cast<uint32_t>(std::stoul(audioLookaheadValue));
+
         graphics::Driver graphicsDriver = graphics::Renderer::getDriver(graphicsDriverValue);
 
         const uint32_t windowFlags = (resizable ? Window::Flags::Resizable : 0) |
@@ -225,9 +243,10 @@ namespace ouzel
                                                         depth,
                                                         stencil,
                                                         debugRenderer);
+        renderer->getDevice()->setFramesInFlight(framesInFlight);
 
         audio::Driver audioDriver = audio::Audio::getDriver(audioDriverValue);
-        audio = std::make_unique<audio::Audio>(audioDriver, debugAudio);
+        audio = std::make_unique<audio::Audio>(audioDriver, debugAudio, audioLookahead);
 
         inputManager = std::make_unique<input::InputManager>();
 
@@ -276,7 +295,10 @@ namespace ouzel
                                                                            },
                                                                            std::vector<std::pair<std::string, graphics::DataType>>{
                                                                                {"modelViewProj", graphics::DataType::FloatMatrix4}
-                                                                           });
+                                                                           },
+                                                                           0, 0, "", "",
+                                                                           std::vector<uint8_t>(std::begin(TextureVSInstancedGLES3_glsl),
+                                                                                                std::end(TextureVSInstancedGLES3_glsl)));
                         break;
 #  else
                     case 2:
@@ -313,7 +335,10 @@ namespace ouzel
                                                                            },
                                                                            std::vector<std::pair<std::string, graphics::DataType>>{
                                                                                {"modelViewProj", graphics::DataType::FloatMatrix4}
-                                                                           });
+                                                                           },
+                                                                           0, 0, "", "",
+                                                                           std::vector<uint8_t>(std::begin(TextureVSInstancedGL3_glsl),
+                                                                                                std::end(TextureVSInstancedGL3_glsl)));
                         break;
                     case 4:
                         textureShader = std::make_unique<graphics::Shader>(*renderer,
@@ -331,7 +356,10 @@ namespace ouzel
                                                                            },
                                                                            std::vector<std::pair<std::string, graphics::DataType>>{
                                                                                {"modelViewProj", graphics::DataType::FloatMatrix4}
-                                                                           });
+                                                                           },
+                                                                           0, 0, "", "",
+                                                                           std::vector<uint8_t>(std::begin(TextureVSInstancedGL4_glsl),
+                                                                                                std::end(TextureVSInstancedGL4_glsl)));
                         break;
 #  endif
                     default:
@@ -378,7 +406,10 @@ namespace ouzel
                                                                          },
                                                                          std::vector<std::pair<std::string, graphics::DataType>>{
                                                                              {"modelViewProj", graphics::DataType::FloatMatrix4}
-                                                                         });
+                                                                         },
+                                                                         0, 0, "", "",
+                                                                         std::vector<uint8_t>(std::begin(ColorVSInstancedGLES3_glsl),
+                                                                                              std::end(ColorVSInstancedGLES3_glsl)));
                         break;
 #  else
                     case 2:
@@ -413,7 +444,10 @@ namespace ouzel
                                                                          },
                                                                          std::vector<std::pair<std::string, graphics::DataType>>{
                                                                              {"modelViewProj", graphics::DataType::FloatMatrix4}
-                                                                         });
+                                                                         },
+                                                                         0, 0, "", "",
+                                                                         std::vector<uint8_t>(std::begin(ColorVSInstancedGL3_glsl),
+                                                                                              std::end(ColorVSInstancedGL3_glsl)));
                         break;
                     case 4:
                         colorShader = std::make_unique<graphics::Shader>(*renderer,
@@ -430,7 +464,10 @@ namespace ouzel
                                                                          },
                                                                          std::vector<std::pair<std::string, graphics::DataType>>{
                                                                              {"modelViewProj", graphics::DataType::FloatMatrix4}
-                                                                         });
+                                                                         },
+                                                                         0, 0, "", "",
+                                                                         std::vector<uint8_t>(std::begin(ColorVSInstancedGL4_glsl),
+                                                                                              std::end(ColorVSInstancedGL4_glsl)));
                         break;
 #  endif
                     default:
@@ -460,7 +497,10 @@ namespace ouzel
                                                                         },
                                                                         std::vector<std::pair<std::string, graphics::DataType>>{
                                                                             {"modelViewProj", graphics::DataType::FloatMatrix4}
-                                                                        });
+                                                                        },
+                                                                        0, 0, "", "",
+                                                                        std::vector<uint8_t>(std::begin(TextureVSInstanced_hlsl),
+                                                                                             std::end(TextureVSInstanced_hlsl)));
 
                 assetBundle.setShader(SHADER_TEXTURE, std::move(textureShader));
 
@@ -478,7 +518,10 @@ namespace ouzel
                                                                       },
                                                                       std::vector<std::pair<std::string, graphics::DataType>>{
                                                                           {"modelViewProj", graphics::DataType::FloatMatrix4}
-                                                                      });
+                                                                      },
+                                                                      0, 0, "", "",
+                                                                      std::vector<uint8_t>(std::begin(ColorVSInstanced_hlsl),
+                                                                                           std::end(ColorVSInstanced_hlsl)));
 
                 assetBundle.setShader(SHADER_COLOR, std::move(colorShader));
                 break;
@@ -505,7 +548,9 @@ namespace ouzel
                                                                             {"modelViewProj", graphics::DataType::FloatMatrix4}
                                                                         },
                                                                         256, 256,
-                                                                        "mainPS", "mainVS");
+                                                                        "mainPS", "mainVS",
+                                                                        std::vector<uint8_t>(std::begin(TextureVSInstanced_metal),
+                                                                                             std::end(TextureVSInstanced_metal)));
 
                 assetBundle.setShader(SHADER_TEXTURE, std::move(textureShader));
 
@@ -525,7 +570,9 @@ namespace ouzel
                                                                           {"modelViewProj", graphics::DataType::FloatMatrix4}
                                                                       },
                                                                       256, 256,
-                                                                      "mainPS", "mainVS");
+                                                                      "mainPS", "mainVS",
+                                                                        std::vector<uint8_t>(std::begin(ColorVSInstanced_metal),
+                                                                                             std::end(ColorVSInstanced_metal)));
 
                 assetBundle.setShader(SHADER_COLOR, std::move(colorShader));
                 break;
@@ -707,6 +754,7 @@ namespace ouzel
     void Engine::update()
     {
         eventDispatcher.dispatchEvents();
+        cache.update();
 
         auto currentTime = std::chrono::steady_clock::now();
         auto diff = currentTime - previousUpdateTime;
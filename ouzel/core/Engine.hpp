@@ -33,16 +33,16 @@ namespace ouzel
 {
     std::unique_ptr<Application> main(const std::vector<std::string>& args);
 
-    const std::string SHADER_TEXTURE = "shaderTexture";
-    const std::string SHADER_COLOR = "shaderColor";
+    constexpr char SHADER_TEXTURE[] = "shaderTexture";
+    constexpr char SHADER_COLOR[] = "shaderColor";
 
-    const std::string BLEND_NO_BLEND = "blendNoBlend";
-    const std::string BLEND_ADD = "blendAdd";
-    const std::string BLEND_MULTIPLY = "blendMultiply";
-    const std::string BLEND_ALPHA = "blendAlpha";
-    const std::string BLEND_SCREEN = "blendScreen";
+    constexpr char BLEND_NO_BLEND[] = "blendNoBlend";
+    constexpr char BLEND_ADD[] = "blendAdd";
+    constexpr char BLEND_MULTIPLY[] = "blendMultiply";
+    constexpr char BLEND_ALPHA[] = "blendAlpha";
+    constexpr char BLEND_SCREEN[] = "blendScreen";
 
-    const std::string TEXTURE_WHITE_PIXEL = "textureWhitePixel";
+    constexpr char TEXTURE_WHITE_PIXEL[] = "textureWhitePixel";
 
     class Engine
     {
@@ -61,6 +61,7 @@ namespace ouzel
         inline auto& getArgs() const noexcept { return args; }
 
         inline Log log(Log::Level level = Log::Level::Info) const { return logger.log(level); }
+        template <Log::Level level> inline auto log() const { return logger.log<level>(); }
         inline auto& getLogger() { return logger; }
         inline auto& getLogger() const { return logger; }
 
@@ -78,6 +78,7 @@ namespace ouzel
         switch (graphicsDriver)
         {
             case graphics::Driver::Empty:
+            case graphics::Driver::Software:
                 view = [[ViewIOS alloc] initWithFrame:windowFrame];
                 break;
 #if OUZEL_COMPILE_OPENGL
@@ -65,6 +65,7 @@ namespace ouzel
         switch (graphicsDriver)
         {
             case graphics::Driver::Empty:
+            case graphics::Driver::Software:
                 view = [[ViewTVOS alloc] initWithFrame:windowFrame];
                 break;
 #if OUZEL_COMPILE_OPENGL
@@ -3,8 +3,17 @@
 #ifndef OUZEL_GRAPHICS_COMMANDS_HPP
 #define OUZEL_GRAPHICS_COMMANDS_HPP
 
-#include <queue>
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <new>
 #include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
 #include "graphics/BlendFactor.hpp"
 #include "graphics/BlendOperation.hpp"
 #include "graphics/BufferType.hpp"
@@ -23,13 +32,19 @@
 #include "graphics/Vertex.hpp"
 #include "math/Color.hpp"
 #include "math/Rect.hpp"
+#include "utils/Span.hpp"
 
 namespace ouzel
 {
     namespace graphics
     {
+        class CommandBuffer;
+
+        // Commands and their data are written back to back to the memory blocks of the command buffer,
+        // so they must not own memory, variable-size data is referred to with spans to the same blocks
         class Command
         {
+            friend CommandBuffer;
         public:
             enum class Type
             {
@@ -48,15 +63,19 @@ namespace ouzel
                 SetDepthStencilState,
                 SetPipelineState,
                 Draw,
+                DrawInstanced,
+                MultiDraw,
                 PushDebugMarker,
                 PopDebugMarker,
                 InitBlendState,
                 InitBuffer,
                 SetBufferData,
+                UploadTransientGeometry,
                 InitShader,
                 SetShaderConstants,
                 InitTexture,
                 SetTextureData,
+                SetTextureRegion,
                 SetTextureParameters,
                 SetTextures
             };
@@ -66,9 +85,10 @@ namespace ouzel
             {
             }
 
-            virtual ~Command() = default;
-
             const Type type;
+
+        private:
+            Command* next = nullptr; // next command in the command buffer
         };
 
         class StopCommand final: public Command
@@ -112,9 +132,9 @@ namespace ouzel
         class InitRenderTargetCommand final: public Command
         {
         public:
-            InitRenderTargetCommand(uintptr_t initRenderTarget,
-                                    const std::set<uintptr_t>& initColorTextures,
-                                    uintptr_t initDepthTexture) noexcept:
+            constexpr InitRenderTargetCommand(uintptr_t initRenderTarget,
+                                              Span<const uintptr_t> initColorTextures,
+                                              uintptr_t initDepthTexture) noexcept:
                 Command(Command::Type::InitRenderTarget),
                 renderTarget(initRenderTarget),
                 colorTextures(initColorTextures),
@@ -123,7 +143,7 @@ namespace ouzel
             }
 
             const uintptr_t renderTarget;
-            const std::set<uintptr_t> colorTextures;
+            const Span<const uintptr_t> colorTextures; // stored in the command buffer
             const uintptr_t depthTexture;
         };
 
@@ -363,16 +383,87 @@ namespace ouzel
             const uint32_t startIndex;
         };
 
+        // per-instance data of the instanced draw calls, shaders with an instanced vertex shader read it as a per-instance
+        // vertex stream (the columns of the model view projection matrix and the color after the vertex attributes),
+        // other shaders get the matrix as the vertex shader constants and the color as the fragment shader constants
+        struct Instance final
+        {
+            float modelViewProjection[16];
+            float color[4];
+        };
+
+        // draws the same mesh once for every instance
+        class DrawInstancedCommand final: public Command
+        {
+        public:
+            DrawInstancedCommand(uintptr_t initIndexBuffer,
+                                 uint32_t initIndexCount,
+                                 uint32_t initIndexSize,
+                                 uintptr_t initVertexBuffer,
+                                 DrawMode initDrawMode,
+                                 uint32_t initStartIndex,
+                                 Span<const Instance> initInstances) noexcept:
+                Command(Command::Type::DrawInstanced),
+                indexBuffer(initIndexBuffer),
+                indexCount(initIndexCount),
+                indexSize(initIndexSize),
+                vertexBuffer(initVertexBuffer),
+                drawMode(initDrawMode),
+                startIndex(initStartIndex),
+                instances(initInstances)
+            {
+            }
+
+            const uintptr_t indexBuffer;
+            const uint32_t indexCount;
+            const uint32_t indexSize;
+            const uintptr_t vertexBuffer;
+            const DrawMode drawMode;
+            const uint32_t startIndex;
+            const Span<const Instance> instances; // stored in the command buffer
+        };
+
+        struct DrawRange final
+        {
+            uint32_t indexCount;
+            uint32_t startIndex;
+        };
+
+        // draws several index ranges of the same mesh with the same state
+        class MultiDrawCommand final: public Command
+        {
+        public:
+            MultiDrawCommand(uintptr_t initIndexBuffer,
+                             uint32_t initIndexSize,
+                             uintptr_t initVertexBuffer,
+                             DrawMode initDrawMode,
+                             Span<const DrawRange> initRanges) noexcept:
+                Command(Command::Type::MultiDraw),
+                indexBuffer(initIndexBuffer),
+                indexSize(initIndexSize),
+                vertexBuffer(initVertexBuffer),
+                drawMode(initDrawMode),
+                ranges(initRanges)
+            {
+            }
+
+            const uintptr_t indexBuffer;
+            const uint32_t indexSize;
+            const uintptr_t vertexBuffer;
+            const DrawMode drawMode;
+            const Span<const DrawRange> ranges; // stored in the command buffer
+        };
+
         class PushDebugMarkerCommand final: public Command
         {
         public:
-            explicit PushDebugMarkerCommand(const std::string& initName) noexcept:
+            explicit constexpr PushDebugMarkerCommand(const char* initName) noexcept:
                 Command(Command::Type::PushDebugMarker),
                 name(initName)
             {
             }
 
-            const std::string name;
+            const char* const name; // null-terminated, stored in the command buffer
         };
 
         class PopDebugMarkerCommand final: public Command
@@ -423,11 +514,11 @@ namespace ouzel
         class InitBufferCommand final: public Command
         {
         public:
-            InitBufferCommand(uintptr_t initBuffer,
-                              BufferType initBufferType,
-                              uint32_t initFlags,
-                              const std::vector<uint8_t>& initData,
-                              uint32_t initSize) noexcept:
+            constexpr InitBufferCommand(uintptr_t initBuffer,
+                                        BufferType initBufferType,
+                                        uint32_t initFlags,
+                                        Span<const uint8_t> initData,
+                                        uint32_t initSize) noexcept:
                 Command(Command::Type::InitBuffer),
                 buffer(initBuffer),
                 bufferType(initBufferType),
@@ -440,15 +531,15 @@ namespace ouzel
             const uintptr_t buffer;
             const BufferType bufferType;
             const uint32_t flags;
-            const std::vector<uint8_t> data;
+            const Span<const uint8_t> data; // stored in the command buffer
             const uint32_t size;
         };
 
         class SetBufferDataCommand final: public Command
         {
         public:
-            SetBufferDataCommand(uintptr_t initBuffer,
-                                 const std::vector<uint8_t>& initData) noexcept:
+            constexpr SetBufferDataCommand(uintptr_t initBuffer,
+                                           Span<const uint8_t> initData) noexcept:
                 Command(Command::Type::SetBufferData),
                 buffer(initBuffer),
                 data(initData)
@@ -456,22 +547,56 @@ namespace ouzel
             }
 
             const uintptr_t buffer;
-            const std::vector<uint8_t> data;
+            const Span<const uint8_t> data; // stored in the command buffer
+        };
+
+        // range of the transient geometry of the command buffer that is uploaded to one pair of buffers,
+        // offsets and counts are in indices and vertices
+        struct TransientBlock final
+        {
+            uintptr_t indexBuffer = 0;
+            uintptr_t vertexBuffer = 0;
+            uint32_t indexOffset = 0;
+            uint32_t indexCount = 0;
+            uint32_t vertexOffset = 0;
+            uint32_t vertexCount = 0;
+        };
+
+        // the block is complete by the time the command buffer is executed,
+        // so all the geometry written to it during the frame is uploaded at once
+        class UploadTransientGeometryCommand final: public Command
+        {
+        public:
+            explicit UploadTransientGeometryCommand(uint32_t initBlock) noexcept:
+                Command(Command::Type::UploadTransientGeometry),
+                block(initBlock)
+            {
+            }
+
+            const uint32_t block;
+        };
+
+        // name and type of a shader constant, the name is null-terminated and stored in the command buffer
+        struct ShaderConstantInfo final
+        {
+            const char* name;
+            DataType dataType;
         };
 
         class InitShaderCommand final: public Command
         {
         public:
-            InitShaderCommand(uintptr_t initShader,
-                              const std::vector<uint8_t>& initFragmentShader,
-                              const std::vector<uint8_t>& initVertexShader,
-                              const std::set<Vertex::Attribute::Usage>& initVertexAttributes,
-                              const std::vector<std::pair<std::string, DataType>>& initFragmentShaderConstantInfo,
-                              const std::vector<std::pair<std::string, DataType>>& initVertexShaderConstantInfo,
-                              uint32_t initFragmentShaderDataAlignment,
-                              uint32_t initVertexShaderDataAlignment,
-                              const std::string& initFragmentShaderFunction,
-                              const std::string& initVertexShaderFunction) noexcept:
+            constexpr InitShaderCommand(uintptr_t initShader,
+                                        Span<const uint8_t> initFragmentShader,
+                                        Span<const uint8_t> initVertexShader,
+                                        Span<const Vertex::Attribute::Usage> initVertexAttributes,
+                                        Span<const ShaderConstantInfo> initFragmentShaderConstantInfo,
+                                        Span<const ShaderConstantInfo> initVertexShaderConstantInfo,
+                                        uint32_t initFragmentShaderDataAlignment,
+                                        uint32_t initVertexShaderDataAlignment,
+                                        const char* initFragmentShaderFunction,
+                                        const char* initVertexShaderFunction,
+                                        Span<const uint8_t> initInstancedVertexShader) noexcept:
                 Command(Command::Type::InitShader),
                 shader(initShader),
                 fragmentShader(initFragmentShader),
@@ -482,46 +607,64 @@ namespace ouzel
                 fragmentShaderDataAlignment(initFragmentShaderDataAlignment),
                 vertexShaderDataAlignment(initVertexShaderDataAlignment),
                 fragmentShaderFunction(initFragmentShaderFunction),
-                vertexShaderFunction(initVertexShaderFunction)
+                vertexShaderFunction(initVertexShaderFunction),
+                instancedVertexShader(initInstancedVertexShader)
             {
             }
 
+            // the data, the attributes, the constant info and the function names are stored in the command buffer
             const uintptr_t shader;
-            const std::vector<uint8_t> fragmentShader;
-            const std::vector<uint8_t> vertexShader;
-            const std::set<Vertex::Attribute::Usage> vertexAttributes;
-            const std::vector<std::pair<std::string, DataType>> fragmentShaderConstantInfo;
-            const std::vector<std::pair<std::string, DataType>> vertexShaderConstantInfo;
+            const Span<const uint8_t> fragmentShader;
+            const Span<const uint8_t> vertexShader;
+            const Span<const Vertex::Attribute::Usage> vertexAttributes;
+            const Span<const ShaderConstantInfo> fragmentShaderConstantInfo;
+            const Span<const ShaderConstantInfo> vertexShaderConstantInfo;
             const uint32_t fragmentShaderDataAlignment;
             const uint32_t vertexShaderDataAlignment;
-            const std::string fragmentShaderFunction;
-            const std::string vertexShaderFunction;
+            const char* const fragmentShaderFunction;
+            const char* const vertexShaderFunction;
+            const Span<const uint8_t> instancedVertexShader;
+        };
+
+        // range of the constant arena of the command buffer that holds the constants of a shader stage
+        // in the order of the shader's constant info, offset and size are in floats
+        struct ConstantBlock final
+        {
+            uint32_t offset = 0;
+            uint32_t size = 0;
         };
 
         class SetShaderConstantsCommand final: public Command
         {
         public:
-            SetShaderConstantsCommand(std::vector<std::vector<float>> initFragmentShaderConstants,
-                                      std::vector<std::vector<float>> initVertexShaderConstants) noexcept:
+            constexpr SetShaderConstantsCommand(const ConstantBlock& initFragmentShaderConstants,
+                                                const ConstantBlock& initVertexShaderConstants) noexcept:
                 Command(Command::Type::SetShaderConstants),
                 fragmentShaderConstants(initFragmentShaderConstants),
                 vertexShaderConstants(initVertexShaderConstants)
             {
             }
 
-            const std::vector<std::vector<float>> fragmentShaderConstants;
-            const std::vector<std::vector<float>> vertexShaderConstants;
+            const ConstantBlock fragmentShaderConstants;
+            const ConstantBlock vertexShaderConstants;
+        };
+
+        // size and pixels of a mip level, the pixels are stored in the command buffer
+        struct TextureLevel final
+        {
+            Size2U size;
+            Span<const uint8_t> data;
         };
 
         class InitTextureCommand final: public Command
         {
         public:
-            InitTextureCommand(uintptr_t initTexture,
-                               const std::vector<std::pair<Size2U, std::vector<uint8_t>>>& initLevels,
-                               TextureType initTextureType,
-                               uint32_t initFlags,
-                               uint32_t initSampleCount,
-                               PixelFormat initPixelFormat) noexcept:
+            constexpr InitTextureCommand(uintptr_t initTexture,
+                                         Span<const TextureLevel> initLevels,
+                                         TextureType initTextureType,
+                                         uint32_t initFlags,
+                                         uint32_t initSampleCount,
+                                         PixelFormat initPixelFormat) noexcept:
                 Command(Command::Type::InitTexture),
                 texture(initTexture),
                 levels(initLevels),
@@ -533,7 +676,7 @@ namespace ouzel
             }
 
             const uintptr_t texture;
-            const std::vector<std::pair<Size2U, std::vector<uint8_t>>> levels;
+            const Span<const TextureLevel> levels; // stored in the command buffer
             const TextureType textureType;
             const uint32_t flags;
             const uint32_t sampleCount;
@@ -543,8 +686,8 @@ namespace ouzel
         class SetTextureDataCommand final: public Command
         {
         public:
-            SetTextureDataCommand(uintptr_t initTexture,
-                                  const std::vector<std::pair<Size2U, std::vector<uint8_t>>>& initLevels) noexcept:
+            constexpr SetTextureDataCommand(uintptr_t initTexture,
+                                            Span<const TextureLevel> initLevels) noexcept:
                 Command(Command::Type::SetTextureData),
                 texture(initTexture),
                 levels(initLevels),
@@ -552,9 +695,9 @@ namespace ouzel
             {
             }
 
-            SetTextureDataCommand(uintptr_t initTexture,
-                                  const std::vector<std::pair<Size2U, std::vector<uint8_t>>>& initLevels,
-                                  CubeFace initFace) noexcept:
+            constexpr SetTextureDataCommand(uintptr_t initTexture,
+                                            Span<const TextureLevel> initLevels,
+                                            CubeFace initFace) noexcept:
                 Command(Command::Type::SetTextureData),
                 texture(initTexture),
                 levels(initLevels),
@@ -563,10 +706,34 @@ namespace ouzel
             }
 
             const uintptr_t texture;
-            const std::vector<std::pair<Size2U, std::vector<uint8_t>>> levels;
+            const Span<const TextureLevel> levels; // stored in the command buffer
             const CubeFace face;
         };
 
+        class SetTextureRegionCommand final: public Command
+        {
+        public:
+            constexpr SetTextureRegionCommand(uintptr_t initTexture,
+                                              uint32_t initX,
+                                              uint32_t initY,
+                                              const Size2U& initSize,
+                                              Span<const uint8_t> initData) noexcept:
+                Command(Command::Type::SetTextureRegion),
+                texture(initTexture),
+                x(initX),
+                y(initY),
+                size(initSize),
+                data(initData)
+            {
+            }
+
+            const uintptr_t texture;
+            const uint32_t x;
+            const uint32_t y;
+            const Size2U size;
+            const Span<const uint8_t> data; // stored in the command buffer
+        };
+
         class SetTextureParametersCommand final: public Command
         {
         public:
@@ -600,48 +767,272 @@ namespace ouzel
         class SetTexturesCommand final: public Command
         {
         public:
-            explicit SetTexturesCommand(const std::vector<uintptr_t>& initTextures) noexcept:
+            static constexpr uint32_t MAX_TEXTURES = 4;
+
+            explicit SetTexturesCommand(const std::array<uintptr_t, MAX_TEXTURES>& initTextures) noexcept:
                 Command(Command::Type::SetTextures),
                 textures(initTextures)
             {
             }
 
-            const std::vector<uintptr_t> textures;
+            const std::array<uintptr_t, MAX_TEXTURES> textures;
         };
 
+        // Commands are constructed back to back in memory blocks that are kept between frames, together with
+        // the data they refer to, so recording a command does not allocate once the blocks have grown to the frame size.
+        // Every command links to the next one, so the commands are read by walking the blocks without an index.
         class CommandBuffer final
         {
         public:
+            static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
             CommandBuffer() = default;
             explicit CommandBuffer(const std::string& initName) noexcept:
                 name(initName)
             {
             }
 
+            CommandBuffer(const CommandBuffer&) = delete;
+            CommandBuffer& operator=(const CommandBuffer&) = delete;
+
+            CommandBuffer(CommandBuffer&& other) noexcept:
+                name(std::move(other.name)),
+                blocks(std::move(other.blocks)),
+                constants(std::move(other.constants)),
+                transientBlocks(std::move(other.transientBlocks)),
+                transientIndices(std::move(other.transientIndices)),
+                transientVertices(std::move(other.transientVertices)),
+                blockIndex(other.blockIndex),
+                blockOffset(other.blockOffset),
+                firstCommand(other.firstCommand),
+                lastCommand(other.lastCommand),
+                readCommand(other.readCommand)
+            {
+                other.blocks.clear();
+                other.clear();
+            }
+
+            CommandBuffer& operator=(CommandBuffer&& other) noexcept
+            {
+                if (&other == this) return *this;
+
+                name = std::move(other.name);
+                blocks = std::move(other.blocks);
+                constants = std::move(other.constants);
+                transientBlocks = std::move(other.transientBlocks);
+                transientIndices = std::move(other.transientIndices);
+                transientVertices = std::move(other.transientVertices);
+                blockIndex = other.blockIndex;
+                blockOffset = other.blockOffset;
+                firstCommand = other.firstCommand;
+                lastCommand = other.lastCommand;
+                readCommand = other.readCommand;
+
+                other.blocks.clear();
+                other.clear();
+
+                return *this;
+            }
+
             inline auto& getName() const noexcept { return name; }
 
-            inline auto isEmpty() const noexcept { return commands.empty(); }
+            inline auto isEmpty() const noexcept
+            {
+                return (readCommand ? readCommand->next : firstCommand) == nullptr;
+            }
 
-            inline void pushCommand(std::unique_ptr<Command> command)
+            template <class T, class ...Args>
+            T* pushCommand(Args&&... args)
             {
-                commands.push(std::move(command));
+                static_assert(std::is_base_of<Command, T>::value, "Not a command");
+                static_assert(std::is_trivially_destructible<T>::value, "Commands must not own memory");
+
+                T* command = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+
+                if (lastCommand)
+                    lastCommand->next = command;
+                else
+                    firstCommand = command;
+
+                lastCommand = command;
+                return command;
+            }
+
+            // copies the data to the memory blocks of the commands, so that the commands can refer to it
+            template <class T>
+            Span<const T> pushData(Span<const T> data)
+            {
+                static_assert(std::is_trivially_copyable<T>::value, "Data is not trivially copyable");
+
+                if (data.empty()) return Span<const T>();
+
+                T* result = static_cast<T*>(allocate(sizeof(T) * data.size(), alignof(T)));
+                std::copy(data.begin(), data.end(), result);
+                return Span<const T>(result, data.size());
+            }
+
+            // allocates the elements in the memory blocks of the commands, so that they can be filled in place
+            template <class T>
+            Span<T> allocateData(size_t count)
+            {
+                static_assert(std::is_trivially_destructible<T>::value, "Data must not own memory");
+
+                if (count == 0) return Span<T>();
+
+                T* result = static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+                for (size_t i = 0; i < count; ++i) new (result + i) T();
+                return Span<T>(result, count);
             }
 
-            inline std::unique_ptr<Command> popCommand()
+            // copies the string with the terminating null character to the memory blocks of the commands
+            const char* pushString(const std::string& str)
             {
-                auto result = std::move(commands.front());
-                commands.pop();
+                char* result = static_cast<char*>(allocate(str.size() + 1, alignof(char)));
+                std::copy(str.begin(), str.end(), result);
+                result[str.size()] = '\0';
                 return result;
             }
 
-            inline auto& getCommands() const
+            inline const Command* popCommand() noexcept
+            {
+                readCommand = readCommand ? readCommand->next : firstCommand;
+                return readCommand;
+            }
+
+            // walks the commands that have not been popped yet without consuming them,
+            // pass the previously returned command to get the one after it
+            inline const Command* peekCommand(const Command* previous = nullptr) const noexcept
+            {
+                if (previous) return previous->next;
+                return readCommand ? readCommand->next : firstCommand;
+            }
+
+            // appends the constants one after another to the constant arena, so that the constants
+            // of a draw call don't need allocations of their own
+            ConstantBlock pushConstants(std::initializer_list<Span<const float>> values)
             {
-                return commands;
+                ConstantBlock block;
+                block.offset = static_cast<uint32_t>(constants.size());
+
+                for (const Span<const float>& value : values)
+                    constants.insert(constants.end(), value.begin(), value.end());
+
+                block.size = static_cast<uint32_t>(constants.size()) - block.offset;
+                return block;
+            }
+
+            inline Span<const float> getConstants(const ConstantBlock& block) const noexcept
+            {
+                return Span<const float>(constants.data() + block.offset, block.size);
+            }
+
+            // starts a transient block that is uploaded to the given buffers and returns its number
+            uint32_t beginTransientBlock(uintptr_t indexBuffer, uintptr_t vertexBuffer)
+            {
+                TransientBlock block;
+                block.indexBuffer = indexBuffer;
+                block.vertexBuffer = vertexBuffer;
+                block.indexOffset = static_cast<uint32_t>(transientIndices.size());
+                block.vertexOffset = static_cast<uint32_t>(transientVertices.size());
+                transientBlocks.push_back(block);
+
+                return static_cast<uint32_t>(transientBlocks.size() - 1);
+            }
+
+            // appends the geometry to the last transient block and returns its start index in the block,
+            // the indices are offset by the vertices that are already in the block
+            uint32_t pushTransientGeometry(Span<const uint16_t> indices, Span<const Vertex> vertices)
+            {
+                TransientBlock& block = transientBlocks.back();
+                const uint32_t startIndex = block.indexCount;
+                const auto baseVertex = static_cast<uint16_t>(block.vertexCount);
+
+                for (const uint16_t index : indices)
+                    transientIndices.push_back(static_cast<uint16_t>(baseVertex + index));
+
+                transientVertices.insert(transientVertices.end(), vertices.begin(), vertices.end());
+
+                block.indexCount += static_cast<uint32_t>(indices.size());
+                block.vertexCount += static_cast<uint32_t>(vertices.size());
+
+                return startIndex;
+            }
+
+            inline auto& getTransientBlocks() const noexcept { return transientBlocks; }
+
+            inline Span<const uint8_t> getTransientIndexData(const TransientBlock& block) const noexcept
+            {
+                return Span<const uint8_t>(reinterpret_cast<const uint8_t*>(transientIndices.data() + block.indexOffset),
+                                           block.indexCount * sizeof(uint16_t));
+            }
+
+            inline Span<const uint8_t> getTransientVertexData(const TransientBlock& block) const noexcept
+            {
+                return Span<const uint8_t>(reinterpret_cast<const uint8_t*>(transientVertices.data() + block.vertexOffset),
+                                           block.vertexCount * sizeof(Vertex));
+            }
+
+            // forgets all the commands but keeps the memory blocks for reuse,
+            // the commands don't own memory, so they are not destroyed
+            void clear() noexcept
+            {
+                constants.clear();
+                transientBlocks.clear();
+                transientIndices.clear();
+                transientVertices.clear();
+                blockIndex = 0;
+                blockOffset = 0;
+                firstCommand = nullptr;
+                lastCommand = nullptr;
+                readCommand = nullptr;
             }
 
         private:
+            struct Block final
+            {
+                explicit Block(size_t initSize):
+                    data(new uint8_t[initSize]),
+                    size(initSize)
+                {
+                }
+
+                std::unique_ptr<uint8_t[]> data;
+                size_t size;
+            };
+
+            void* allocate(size_t size, size_t alignment)
+            {
+                for (;;)
+                {
+                    if (blockIndex >= blocks.size())
+                        blocks.emplace_back(size + alignment > BLOCK_SIZE ? size + alignment : BLOCK_SIZE);
+
+                    Block& block = blocks[blockIndex];
+                    const size_t offset = (blockOffset + alignment - 1) / alignment * alignment;
+
+                    if (offset + size <= block.size)
+                    {
+                        blockOffset = offset + size;
+                        return block.data.get() + offset;
+                    }
+
+                    // the command does not fit in the rest of the block, continue in the next one
+                    ++blockIndex;
+                    blockOffset = 0;
+                }
+            }
+
             std::string name;
-            std::queue<std::unique_ptr<Command>> commands;
+            std::vector<Block> blocks;
+            std::vector<float> constants;
+            std::vector<TransientBlock> transientBlocks;
+            std::vector<uint16_t> transientIndices;
+            std::vector<Vertex> transientVertices;
+            size_t blockIndex = 0;
+            size_t blockOffset = 0;
+            Command* firstCommand = nullptr;
+            Command* lastCommand = nullptr;
+            const Command* readCommand = nullptr; // last command that was read
         };
     } // namespace graphics
 } // namespace ouzel
@@ -14,7 +14,8 @@ namespace ouzel
             Dynamic = 0x01,
             BindRenderTarget = 0x02,
             BindShader = 0x04,
-            BindShaderMsaa = 0x08
+            BindShaderMsaa = 0x08,
+            Transient = 0x10 // rewritten every frame, so the backend does not keep a copy to restore it
         };
     } // namespace graphics
 } // namespace ouzel
@@ -18,6 +18,7 @@ namespace ouzel
         {
         public:
             static constexpr uint32_t TEXTURE_LAYERS = 4;
+            static_assert(TEXTURE_LAYERS <= SetTexturesCommand::MAX_TEXTURES, "Too many texture layers");
 
             Material() = default;
 
@@ -1,6 +1,8 @@
 // Copyright 2015-2019 Elviss Strazdins. All rights reserved.
 
 #include <algorithm>
+#include <stdexcept>
+#include <thread>
 #include "RenderDevice.hpp"
 
 namespace ouzel
@@ -79,6 +81,112 @@ namespace ouzel
             }
         }
 
+        void RenderDevice::submitFrame(CommandBuffer&& commandBuffer)
+        {
+            ++queuedFrameCount;
+
+            QueuedFrame frame;
+            frame.commandBuffer = std::move(commandBuffer);
+            frame.submitTime = std::chrono::steady_clock::now();
+
+            // the frame count is limited by the renderer, so this waits only if more frames are submitted
+            if (!frameQueue.push(std::move(frame)))
+            {
+                std::unique_lock<std::mutex> lock(frameSlotMutex);
+                waitingForFrameSlot = true;
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                while (!frameQueue.push(std::move(frame)))
+                    frameSlotCondition.wait(lock);
+                waitingForFrameSlot = false;
+            }
+
+            // wake the render thread only if it is already waiting for commands
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (waitingForCommands)
+            {
+                std::unique_lock<std::mutex> lock(commandQueueMutex);
+                lock.unlock();
+                commandQueueCondition.notify_all();
+            }
+        }
+
+        bool RenderDevice::acquireCommandBuffer(CommandBuffer& commandBuffer)
+        {
+            return freeCommandBuffers.pop(commandBuffer);
+        }
+
+        void RenderDevice::setFramesInFlight(uint32_t newFramesInFlight)
+        {
+            if (newFramesInFlight < 1 || newFramesInFlight > MAX_FRAMES_IN_FLIGHT)
+                throw std::runtime_error("Invalid number of frames in flight");
+
+            framesInFlight = newFramesInFlight;
+        }
+
+        void RenderDevice::waitForCommandBuffer(CommandBuffer& commandBuffer)
+        {
+            // the previous frame did not reach its present command (e.g. an exception was thrown)
+            if (executingFrame) finishCommandBuffer(commandBuffer);
+
+            QueuedFrame frame;
+
+            for (;;)
+            {
+                if (frameQueue.pop(frame))
+                {
+                    commandBuffer = std::move(frame.commandBuffer);
+                    executingFrame = true;
+                    executingFrameSubmitTime = frame.submitTime;
+
+                    // wake the submitting thread only if it is waiting for a free slot in the frame queue
+                    std::atomic_thread_fence(std::memory_order_seq_cst);
+                    if (waitingForFrameSlot)
+                    {
+                        std::unique_lock<std::mutex> lock(frameSlotMutex);
+                        lock.unlock();
+                        frameSlotCondition.notify_all();
+                    }
+                    return;
+                }
+
+                std::unique_lock<std::mutex> lock(commandQueueMutex);
+
+                if (!commandQueue.empty())
+                {
+                    commandBuffer = std::move(commandQueue.front());
+                    commandQueue.pop();
+                    return;
+                }
+
+                waitingForCommands = true;
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                while (frameQueue.isEmpty() && commandQueue.empty())
+                    commandQueueCondition.wait(lock);
+                waitingForCommands = false;
+            }
+        }
+
+        void RenderDevice::finishCommandBuffer(CommandBuffer& commandBuffer)
+        {
+            if (!executingFrame) return;
+
+            executingFrame = false;
+
+            const auto diff = std::chrono::steady_clock::now() - executingFrameSubmitTime;
+            frameLatency = std::chrono::duration_cast<std::chrono::microseconds>(diff).count() / 1000000.0F;
+
+            drawCallCount = currentDrawCallCount;
+            currentDrawCallCount = 0;
+            apiCallCount = currentAPICallCount;
+            currentAPICallCount = 0;
+
+            // keep the memory of the command buffer for the next frames
+            commandBuffer.clear();
+            freeCommandBuffers.push(std::move(commandBuffer));
+
+            --queuedFrameCount;
+        }
+
         std::vector<Size2U> RenderDevice::getSupportedResolutions() const
         {
             return std::vector<Size2U>();
@@ -16,6 +16,7 @@
 #include "graphics/Vertex.hpp"
 #include "math/Matrix.hpp"
 #include "math/Size.hpp"
+#include "utils/SpscQueue.hpp"
 
 namespace ouzel
 {
@@ -30,6 +31,7 @@ namespace ouzel
             friend Renderer;
         public:
             static const std::array<Vertex::Attribute, 5> VERTEX_ATTRIBUTES;
+            static constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 4;
 
             struct Event
             {
@@ -57,9 +59,11 @@ namespace ouzel
             inline auto getSampleCount() const noexcept { return sampleCount; }
             inline auto getTextureFilter() const noexcept { return textureFilter; }
             inline auto getMaxAnisotropy() const noexcept { return maxAnisotropy; }
+            inline auto isDebugRenderer() const noexcept { return debugRenderer; }
 
             virtual std::vector<Size2U> getSupportedResolutions() const;
 
+            // can be called from any thread, used for command buffers outside of the frame flow
             void submitCommandBuffer(CommandBuffer&& commandBuffer)
             {
                 std::unique_lock<std::mutex> lock(commandQueueMutex);
@@ -68,7 +72,23 @@ namespace ouzel
                 commandQueueCondition.notify_all();
             }
 
-            inline auto getDrawCallCount() const noexcept { return drawCallCount; }
+            // must be called only from the thread that records the frames
+            void submitFrame(CommandBuffer&& commandBuffer);
+            bool acquireCommandBuffer(CommandBuffer& commandBuffer);
+
+            inline auto getFramesInFlight() const noexcept { return framesInFlight.load(); }
+            void setFramesInFlight(uint32_t newFramesInFlight);
+
+            // number of frames submitted but not yet presented
+            inline auto getQueueDepth() const noexcept { return queuedFrameCount.load(); }
+            // time between the frame submission and its presentation in seconds
+            inline float getFrameLatency() const noexcept { return frameLatency; }
+
+            // number of draw calls in the last presented frame
+            inline auto getDrawCallCount() const noexcept { return drawCallCount.load(); }
+            // number of state changes and draw calls that the last presented frame issued to the graphics API,
+            // counted by the OpenGL render device
+            inline auto getAPICallCount() const noexcept { return apiCallCount.load(); }
 
             inline auto getAPIMajorVersion() const noexcept { return apiMajorVersion; }
             inline auto getAPIMinorVersion() const noexcept { return apiMinorVersion; }
@@ -164,6 +184,10 @@ namespace ouzel
 
             void executeAll();
 
+            // must be called only from the render thread
+            void waitForCommandBuffer(CommandBuffer& commandBuffer);
+            void finishCommandBuffer(CommandBuffer& commandBuffer);
+
             virtual void generateScreenshot(const std::string& filename);
 
             Driver driver;
@@ -194,7 +218,10 @@ namespace ouzel
             Matrix4F projectionTransform;
             Matrix4F renderTargetProjectionTransform;
 
-            uint32_t drawCallCount = 0;
+            uint32_t currentDrawCallCount = 0;
+            std::atomic<uint32_t> drawCallCount{0};
+            uint32_t currentAPICallCount = 0;
+            std::atomic<uint32_t> apiCallCount{0};
 
             std::queue<CommandBuffer> commandQueue;
             std::mutex commandQueueMutex;
@@ -211,6 +238,24 @@ namespace ouzel
             std::mutex executeMutex;
 
         private:
+            struct QueuedFrame final
+            {
+                CommandBuffer commandBuffer;
+                std::chrono::steady_clock::time_point submitTime;
+            };
+
+            SpscQueue<QueuedFrame> frameQueue{MAX_FRAMES_IN_FLIGHT};
+            SpscQueue<CommandBuffer> freeCommandBuffers{MAX_FRAMES_IN_FLIGHT};
+            std::atomic<uint32_t> framesInFlight{2};
+            std::atomic<uint32_t> queuedFrameCount{0};
+            std::atomic_bool waitingForCommands{false};
+            std::atomic_bool waitingForFrameSlot{false};
+            std::mutex frameSlotMutex;
+            std::condition_variable frameSlotCondition;
+            std::atomic<float> frameLatency{0.0F};
+            bool executingFrame = false;
+            std::chrono::steady_clock::time_point executingFrameSubmitTime;
+
             uintptr_t lastResourceId = 0;
             std::set<uintptr_t> deletedResourceIds;
         };
@@ -15,14 +15,14 @@ namespace ouzel
             colorTextures(initColorTextures),
             depthTexture(initDepthTexture)
         {
-            std::set<uintptr_t> colorTextureIds;
+            Span<uintptr_t> colorTextureIds = initRenderer.allocateData<uintptr_t>(colorTextures.size());
 
-            for (const auto& colorTexture : colorTextures)
-                colorTextureIds.insert(colorTexture ? colorTexture->getResource() : 0);
+            for (size_t i = 0; i < colorTextures.size(); ++i)
+                colorTextureIds[i] = colorTextures[i] ? colorTextures[i]->getResource() : 0;
 
-            initRenderer.addCommand(std::make_unique<InitRenderTargetCommand>(resource,
-                                                                              colorTextureIds,
-                                                                              depthTexture ? depthTexture->getResource() : uintptr_t(0)));
+            initRenderer.addCommand<InitRenderTargetCommand>(resource,
+                                                             colorTextureIds,
+                                                             depthTexture ? depthTexture->getResource() : uintptr_t(0));
         }
     } // namespace graphics
 } // namespace ouzel
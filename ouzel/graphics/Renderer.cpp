@@ -3,6 +3,7 @@
 #if defined(__APPLE__)
 #  include <TargetConditionals.h>
 #endif
+#include <limits>
 #include <stdexcept>
 #include "core/Setup.h"
 #include "Renderer.hpp"
@@ -37,6 +38,7 @@
 #include "graphics/opengl/OGLRenderDevice.hpp"
 #include "graphics/direct3d11/D3D11RenderDevice.hpp"
 #include "graphics/metal/MetalRenderDevice.hpp"
+#include "graphics/software/SoftwareRenderDevice.hpp"
 
 namespace ouzel
 {
@@ -65,6 +67,8 @@ namespace ouzel
                 return Driver::Direct3D11;
             else if (driver == "metal")
                 return Driver::Metal;
+            else if (driver == "software")
+                return Driver::Software;
             else
                 throw std::runtime_error("Invalid graphics driver");
         }
@@ -76,6 +80,7 @@ namespace ouzel
             if (availableDrivers.empty())
             {
                 availableDrivers.insert(Driver::Empty);
+                availableDrivers.insert(Driver::Software);
 
 #if OUZEL_COMPILE_OPENGL
                 availableDrivers.insert(Driver::OpenGL);
@@ -146,6 +151,10 @@ namespace ouzel
 #  endif
                     break;
 #endif
+                case Driver::Software:
+                    engine->log(Log::Level::Info) << "Using software render driver";
+                    device = std::make_unique<software::RenderDevice>(std::bind(&Renderer::handleEvent, this, std::placeholders::_1));
+                    break;
                 default:
                     engine->log(Log::Level::Info) << "Not using render driver";
                     device = std::make_unique<empty::RenderDevice>(std::bind(&Renderer::handleEvent, this, std::placeholders::_1));
@@ -172,7 +181,6 @@ namespace ouzel
             {
                 std::unique_lock<std::mutex> lock(frameMutex);
                 newFrame = true;
-                refillQueue = true;
                 lock.unlock();
                 frameCondition.notify_all();
             }
@@ -182,7 +190,7 @@ namespace ouzel
         {
             size = newSize;
 
-            addCommand(std::make_unique<ResizeCommand>(newSize));
+            addCommand<ResizeCommand>(newSize);
         }
 
         void Renderer::saveScreenshot(const std::string& filename)
@@ -192,7 +200,7 @@ namespace ouzel
 
         void Renderer::setRenderTarget(uintptr_t renderTarget)
         {
-            addCommand(std::make_unique<SetRenderTargetCommand>(renderTarget));
+            addCommand<SetRenderTargetCommand>(renderTarget);
         }
 
         void Renderer::clearRenderTarget(bool clearColorBuffer,
@@ -202,29 +210,29 @@ namespace ouzel
                                          float clearDepth,
                                          uint32_t clearStencil)
         {
-            addCommand(std::make_unique<ClearRenderTargetCommand>(clearColorBuffer,
-                                                                  clearDepthBuffer,
-                                                                  clearStencilBuffer,
-                                                                  clearColor,
-                                                                  clearDepth,
-                                                                  clearStencil));
+            addCommand<ClearRenderTargetCommand>(clearColorBuffer,
+                                                 clearDepthBuffer,
+                                                 clearStencilBuffer,
+                                                 clearColor,
+                                                 clearDepth,
+                                                 clearStencil);
         }
 
         void Renderer::setScissorTest(bool enabled, const RectF& rectangle)
         {
-            addCommand(std::make_unique<SetScissorTestCommand>(enabled, rectangle));
+            addCommand<SetScissorTestCommand>(enabled, rectangle);
         }
 
         void Renderer::setViewport(const RectF& viewport)
         {
-            addCommand(std::make_unique<SetViewportCommand>(viewport));
+            addCommand<SetViewportCommand>(viewport);
         }
 
         void Renderer::setDepthStencilState(uintptr_t depthStencilState,
                                             uint32_t stencilReferenceValue)
         {
-            addCommand(std::make_unique<SetDepthStencilStateCommand>(depthStencilState,
-                                                                     stencilReferenceValue));
+            addCommand<SetDepthStencilStateCommand>(depthStencilState,
+                                                    stencilReferenceValue);
         }
 
         void Renderer::setPipelineState(uintptr_t blendState,
@@ -232,10 +240,10 @@ namespace ouzel
                                         CullMode cullMode,
                                         FillMode fillMode)
         {
-            addCommand(std::make_unique<SetPipelineStateCommand>(blendState,
-                                                                 shader,
-                                                                 cullMode,
-                                                                 fillMode));
+            addCommand<SetPipelineStateCommand>(blendState,
+                                                shader,
+                                                cullMode,
+                                                fillMode);
         }
 
         void Renderer::draw(uintptr_t indexBuffer,
@@ -248,42 +256,123 @@ namespace ouzel
             if (!indexBuffer || !vertexBuffer)
                 throw std::runtime_error("Invalid mesh buffer passed to render queue");
 
-            addCommand(std::make_unique<DrawCommand>(indexBuffer,
-                                                     indexCount,
-                                                     indexSize,
-                                                     vertexBuffer,
-                                                     drawMode,
-                                                     startIndex));
+            addCommand<DrawCommand>(indexBuffer,
+                                    indexCount,
+                                    indexSize,
+                                    vertexBuffer,
+                                    drawMode,
+                                    startIndex);
+        }
+
+        void Renderer::drawInstanced(uintptr_t indexBuffer,
+                                     uint32_t indexCount,
+                                     uint32_t indexSize,
+                                     uintptr_t vertexBuffer,
+                                     DrawMode drawMode,
+                                     uint32_t startIndex,
+                                     Span<const Instance> instances)
+        {
+            if (!indexBuffer || !vertexBuffer)
+                throw std::runtime_error("Invalid mesh buffer passed to render queue");
+
+            if (instances.empty()) return;
+
+            addCommand<DrawInstancedCommand>(indexBuffer,
+                                             indexCount,
+                                             indexSize,
+                                             vertexBuffer,
+                                             drawMode,
+                                             startIndex,
+                                             commandBuffer.pushData(instances));
+        }
+
+        void Renderer::multiDraw(uintptr_t indexBuffer,
+                                 uint32_t indexSize,
+                                 uintptr_t vertexBuffer,
+                                 DrawMode drawMode,
+                                 Span<const DrawRange> ranges)
+        {
+            if (!indexBuffer || !vertexBuffer)
+                throw std::runtime_error("Invalid mesh buffer passed to render queue");
+
+            if (ranges.empty()) return;
+
+            addCommand<MultiDrawCommand>(indexBuffer,
+                                         indexSize,
+                                         vertexBuffer,
+                                         drawMode,
+                                         commandBuffer.pushData(ranges));
+        }
+
+        Renderer::TransientGeometry Renderer::allocateTransientGeometry(Span<const uint16_t> indices,
+                                                                        Span<const Vertex> vertices)
+        {
+            constexpr size_t maxBlockVertexCount = std::numeric_limits<uint16_t>::max() + size_t(1);
+
+            if (indices.empty() || vertices.empty() || vertices.size() > maxBlockVertexCount)
+                throw std::runtime_error("Invalid transient geometry");
+
+            // the vertices of a block are addressed with 16-bit indices, so a full block continues in the next buffers
+            if (!transientBlockCount ||
+                commandBuffer.getTransientBlocks().back().vertexCount + vertices.size() > maxBlockVertexCount)
+            {
+                std::vector<TransientBuffers>& buffers = transientBuffers[transientBufferSet];
+
+                if (transientBlockCount >= buffers.size())
+                    buffers.push_back({Buffer(*this, BufferType::Index, Flags::Dynamic | Flags::Transient),
+                                       Buffer(*this, BufferType::Vertex, Flags::Dynamic | Flags::Transient)});
+
+                const TransientBuffers& blockBuffers = buffers[transientBlockCount++];
+                const uint32_t block = commandBuffer.beginTransientBlock(blockBuffers.indexBuffer.getResource(),
+                                                                         blockBuffers.vertexBuffer.getResource());
+
+                addCommand<UploadTransientGeometryCommand>(block);
+            }
+
+            const TransientBlock& block = commandBuffer.getTransientBlocks().back();
+
+            TransientGeometry result;
+            result.indexBuffer = block.indexBuffer;
+            result.vertexBuffer = block.vertexBuffer;
+            result.startIndex = commandBuffer.pushTransientGeometry(indices, vertices);
+            return result;
         }
 
         void Renderer::pushDebugMarker(const std::string& name)
         {
-            addCommand(std::make_unique<PushDebugMarkerCommand>(name));
+            addCommand<PushDebugMarkerCommand>(commandBuffer.pushString(name));
         }
 
         void Renderer::popDebugMarker()
         {
-            addCommand(std::make_unique<PopDebugMarkerCommand>());
+            addCommand<PopDebugMarkerCommand>();
         }
 
-        void Renderer::setShaderConstants(std::vector<std::vector<float>> fragmentShaderConstants,
-                                          std::vector<std::vector<float>> vertexShaderConstants)
+        void Renderer::setShaderConstants(std::initializer_list<Span<const float>> fragmentShaderConstants,
+                                          std::initializer_list<Span<const float>> vertexShaderConstants)
         {
-            addCommand(std::make_unique<SetShaderConstantsCommand>(fragmentShaderConstants,
-                                                                   vertexShaderConstants));
+            const ConstantBlock fragmentShaderConstantBlock = commandBuffer.pushConstants(fragmentShaderConstants);
+            const ConstantBlock vertexShaderConstantBlock = commandBuffer.pushConstants(vertexShaderConstants);
+
+            addCommand<SetShaderConstantsCommand>(fragmentShaderConstantBlock, vertexShaderConstantBlock);
         }
 
-        void Renderer::setTextures(const std::vector<uintptr_t>& textures)
+        void Renderer::setTextures(const std::array<uintptr_t, SetTexturesCommand::MAX_TEXTURES>& textures)
         {
-            addCommand(std::make_unique<SetTexturesCommand>(textures));
+            addCommand<SetTexturesCommand>(textures);
         }
 
         void Renderer::present()
         {
-            refillQueue = false;
-            addCommand(std::make_unique<PresentCommand>());
-            device->submitCommandBuffer(std::move(commandBuffer));
-            commandBuffer = CommandBuffer();
+            addCommand<PresentCommand>();
+            device->submitFrame(std::move(commandBuffer));
+
+            transientBlockCount = 0;
+            if (++transientBufferSet >= TRANSIENT_BUFFER_SETS) transientBufferSet = 0;
+
+            // reuse the memory of a command buffer the device has finished with
+            if (!device->acquireCommandBuffer(commandBuffer))
+                commandBuffer = CommandBuffer();
         }
 
         void Renderer::waitForNextFrame()
@@ -3,14 +3,17 @@
 #ifndef OUZEL_GRAPHICS_RENDERER_HPP
 #define OUZEL_GRAPHICS_RENDERER_HPP
 
+#include <array>
 #include <cstdint>
 #include <functional>
+#include <initializer_list>
 #include <memory>
 #include <string>
 #include <vector>
 #include <queue>
 #include <set>
 #include <atomic>
+#include "graphics/Buffer.hpp"
 #include "graphics/Commands.hpp"
 #include "graphics/Driver.hpp"
 #include "graphics/RenderDevice.hpp"
@@ -27,6 +30,14 @@ namespace ouzel
         {
             friend Window;
         public:
+            // where the geometry was copied to in the transient buffers of the frame
+            struct TransientGeometry final
+            {
+                uintptr_t indexBuffer;
+                uintptr_t vertexBuffer;
+                uint32_t startIndex;
+            };
+
             Renderer(Driver driver,
                      Window* newWindow,
                      const Size2U& newSize,
@@ -69,20 +80,61 @@ namespace ouzel
                       uintptr_t vertexBuffer,
                       DrawMode drawMode,
                       uint32_t startIndex);
+            // draws the mesh once for every instance, the instances are copied to the command buffer
+            void drawInstanced(uintptr_t indexBuffer,
+                               uint32_t indexCount,
+                               uint32_t indexSize,
+                               uintptr_t vertexBuffer,
+                               DrawMode drawMode,
+                               uint32_t startIndex,
+                               Span<const Instance> instances);
+            void multiDraw(uintptr_t indexBuffer,
+                           uint32_t indexSize,
+                           uintptr_t vertexBuffer,
+                           DrawMode drawMode,
+                           Span<const DrawRange> ranges);
+            // copies geometry that is drawn only in the current frame to the command buffer, the transient
+            // geometry of the whole frame is uploaded at once, the indices are 16-bit and start from zero
+            TransientGeometry allocateTransientGeometry(Span<const uint16_t> indices,
+                                                        Span<const Vertex> vertices);
             void pushDebugMarker(const std::string& name);
             void popDebugMarker();
-            void setShaderConstants(std::vector<std::vector<float>> fragmentShaderConstants,
-                                    std::vector<std::vector<float>> vertexShaderConstants);
-            void setTextures(const std::vector<uintptr_t>& textures);
+            // the constants are given in the order of the shader's constant info and copied to the constant arena
+            void setShaderConstants(std::initializer_list<Span<const float>> fragmentShaderConstants,
+                                    std::initializer_list<Span<const float>> vertexShaderConstants);
+            void setTextures(const std::array<uintptr_t, SetTexturesCommand::MAX_TEXTURES>& textures);
+
+            template <class T, class ...Args>
+            inline void addCommand(Args&&... args)
+            {
+                commandBuffer.pushCommand<T>(std::forward<Args>(args)...);
+            }
 
-            inline void addCommand(std::unique_ptr<Command> command)
+            // the data of the commands is copied to the command buffer before the command that refers to it is added
+            template <class T>
+            inline Span<const T> addData(Span<const T> data)
             {
-                commandBuffer.pushCommand(std::move(command));
+                return commandBuffer.pushData(data);
             }
+
+            template <class T>
+            inline Span<T> allocateData(size_t count)
+            {
+                return commandBuffer.allocateData<T>(count);
+            }
+
+            inline const char* addString(const std::string& str)
+            {
+                return commandBuffer.pushString(str);
+            }
+
             void present();
 
             void waitForNextFrame();
-            inline bool getRefillQueue() const noexcept { return refillQueue; }
+            inline bool getRefillQueue() const noexcept
+            {
+                return device->getQueueDepth() < device->getFramesInFlight();
+            }
 
             Vector2F convertScreenToNormalizedLocation(const Vector2F& position)
             {
@@ -105,10 +157,22 @@ namespace ouzel
             Size2U size;
             CommandBuffer commandBuffer;
 
+            struct TransientBuffers final
+            {
+                Buffer indexBuffer;
+                Buffer vertexBuffer;
+            };
+
+            // every frame that can be queued writes to its own transient buffers,
+            // so the buffers are not overwritten while the previous frames are drawn from them
+            static constexpr uint32_t TRANSIENT_BUFFER_SETS = RenderDevice::MAX_FRAMES_IN_FLIGHT + 1;
+            std::vector<TransientBuffers> transientBuffers[TRANSIENT_BUFFER_SETS];
+            uint32_t transientBufferSet = 0;
+            uint32_t transientBlockCount = 0;
+
             bool newFrame = false;
             std::mutex frameMutex;
             std::condition_variable frameCondition;
-            std::atomic_bool refillQueue{true};
         };
     } // namespace graphics
 } // namespace ouzel
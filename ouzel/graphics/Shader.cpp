@@ -1,5 +1,6 @@
 // Copyright 2015-2019 Elviss Strazdins. All rights reserved.
 
+#include <algorithm>
 #include "Shader.hpp"
 #include "Renderer.hpp"
 
@@ -7,6 +8,23 @@ namespace ouzel
 {
     namespace graphics
     {
+        namespace
+        {
+            Span<const ShaderConstantInfo> addConstantInfo(Renderer& renderer,
+                                                           const std::vector<std::pair<std::string, DataType>>& constantInfo)
+            {
+                Span<ShaderConstantInfo> result = renderer.allocateData<ShaderConstantInfo>(constantInfo.size());
+
+                for (size_t i = 0; i < constantInfo.size(); ++i)
+                {
+                    result[i].name = renderer.addString(constantInfo[i].first);
+                    result[i].dataType = constantInfo[i].second;
+                }
+
+                return result;
+            }
+        }
+
         Shader::Shader(Renderer& initRenderer):
             resource(initRenderer.getDevice()->createResource())
         {
@@ -21,20 +39,25 @@ namespace ouzel
                        uint32_t initFragmentShaderDataAlignment,
                        uint32_t initVertexShaderDataAlignment,
                        const std::string& fragmentShaderFunction,
-                       const std::string& vertexShaderFunction):
+                       const std::string& vertexShaderFunction,
+                       const std::vector<uint8_t>& instancedVertexShader):
             resource(initRenderer.getDevice()->createResource()),
             vertexAttributes(initVertexAttributes)
         {
-            initRenderer.addCommand(std::make_unique<InitShaderCommand>(resource,
-                                                                        initFragmentShader,
-                                                                        initVertexShader,
-                                                                        initVertexAttributes,
-                                                                        initFragmentShaderConstantInfo,
-                                                                        initVertexShaderConstantInfo,
-                                                                        initFragmentShaderDataAlignment,
-                                                                        initVertexShaderDataAlignment,
-                                                                        fragmentShaderFunction,
-                                                                        vertexShaderFunction));
+            Span<Vertex::Attribute::Usage> vertexAttributeData = initRenderer.allocateData<Vertex::Attribute::Usage>(initVertexAttributes.size());
+            std::copy(initVertexAttributes.begin(), initVertexAttributes.end(), vertexAttributeData.begin());
+
+            initRenderer.addCommand<InitShaderCommand>(resource,
+                                                       initRenderer.addData<uint8_t>(initFragmentShader),
+                                                       initRenderer.addData<uint8_t>(initVertexShader),
+                                                       vertexAttributeData,
+                                                       addConstantInfo(initRenderer, initFragmentShaderConstantInfo),
+                                                       addConstantInfo(initRenderer, initVertexShaderConstantInfo),
+                                                       initFragmentShaderDataAlignment,
+                                                       initVertexShaderDataAlignment,
+                                                       initRenderer.addString(fragmentShaderFunction),
+                                                       initRenderer.addString(vertexShaderFunction),
+                                                       initRenderer.addData<uint8_t>(instancedVertexShader));
         }
     } // namespace graphics
 } // namespace ouzel
@@ -32,7 +32,8 @@ namespace ouzel
                    uint32_t initFragmentShaderDataAlignment = 0,
                    uint32_t initVertexShaderDataAlignment = 0,
                    const std::string& fragmentShaderFunction = "",
-                   const std::string& vertexShaderFunction = "");
+                   const std::string& vertexShaderFunction = "",
+                   const std::vector<uint8_t>& instancedVertexShader = std::vector<uint8_t>());
 
             inline auto& getResource() const noexcept { return resource; }
 
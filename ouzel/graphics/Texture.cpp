@@ -1,8 +1,18 @@
 // Copyright 2015-2019 Elviss Strazdins. All rights reserved.
 
+#include <algorithm>
+#include <array>
+#include <cmath>
 #include <stdexcept>
+#include <thread>
+#if defined(__ARM_NEON__)
+#  include <arm_neon.h>
+#elif defined(__SSE2__)
+#  include <emmintrin.h>
+#endif
 #include "Texture.hpp"
 #include "Renderer.hpp"
+#include "math/MathUtils.hpp"
 
 namespace ouzel
 {
@@ -46,498 +56,396 @@ namespace ouzel
                 0.9406006932F, 0.9489649534F, 0.957369566F, 0.9658146501F, 0.9743002057F, 0.9828262329F, 0.9913928509F, 1.0F
             };
 
-            void downsample2x2A8(uint32_t width, uint32_t height,
-                                 const std::vector<float>& original, std::vector<float>& resized)
+            // levels with at least this many pixels are downsampled on multiple threads
+            constexpr uint32_t PARALLEL_PIXEL_COUNT = 512 * 512;
+
+            inline float gammaDecode(uint8_t value) noexcept
+            {
+                return GAMMA_DECODE[value]; // std::pow(value / 255.0F, GAMMA);
+            }
+
+            class GammaEncoder final
             {
-                const uint32_t dstWidth = width >> 1;
-                const uint32_t dstHeight = height >> 1;
-                const uint32_t pitch = width * 1;
-                resized.resize(dstWidth * dstHeight * 1);
-                const float* src = original.data();
-                float* dst = resized.data();
-
-                if (dstWidth > 0 && dstHeight > 0)
+            public:
+                static constexpr uint32_t STEP_COUNT = 4096;
+
+                GammaEncoder()
                 {
-                    for (uint32_t y = 0; y < dstHeight; ++y, src += pitch * 2)
+                    // linear values half way between two neighbouring encoded values
+                    for (size_t i = 0; i < thresholds.size(); ++i)
+                        thresholds[i] = std::pow((i + 0.5F) / 255.0F, GAMMA);
+
+                    // encoded value at the start of the previous step, never larger than the encoded value of the step
+                    for (uint32_t i = 0; i < STEP_COUNT; ++i)
                     {
-                        const float* pixel = src;
-                        for (uint32_t x = 0; x < dstWidth; ++x, pixel += 2, dst += 1)
-                        {
-                            float a = 0.0F;
-                            a += pixel[0];
-                            a += pixel[1];
-                            a += pixel[pitch + 0];
-                            a += pixel[pitch + 1];
-                            dst[0] = a / 4.0F;
-                        }
+                        const float value = (i > 0 ? i - 1 : 0) / static_cast<float>(STEP_COUNT - 1);
+                        steps[i] = static_cast<uint8_t>(std::upper_bound(thresholds.begin(), thresholds.end(), value) - thresholds.begin());
                     }
                 }
-                else if (dstHeight > 0)
-                {
-                    for (uint32_t y = 0; y < dstHeight; ++y, src += pitch * 2, dst += 1)
-                    {
-                        const float* pixel = src;
 
-                        float a = 0.0F;
-                        a += pixel[0];
-                        a += pixel[pitch + 0];
-                        dst[0] = a / 2.0F;
-                    }
-                }
-                else if (dstWidth > 0)
+                // same as std::round(std::pow(value, 1.0F / GAMMA) * 255.0F)
+                uint8_t encode(float value) const noexcept
                 {
-                    const float* pixel = src;
-                    for (uint32_t x = 0; x < dstWidth; ++x, pixel += 2, dst += 1)
-                    {
-                        float a = 0.0F;
-                        a += pixel[0];
-                        a += pixel[1];
-                        dst[0] = a / 2.0F;
-                    }
+                    uint32_t result = steps[static_cast<uint32_t>(clamp(value, 0.0F, 1.0F) * (STEP_COUNT - 1))];
+
+                    // the gamma curve is steep near zero, so a step can span several encoded values
+                    while (result < thresholds.size() && value >= thresholds[result]) ++result;
+
+                    return static_cast<uint8_t>(result);
                 }
+
+            private:
+                std::array<float, 255> thresholds;
+                std::array<uint8_t, STEP_COUNT> steps;
+            };
+
+            inline uint8_t gammaEncode(float value)
+            {
+                static const GammaEncoder encoder;
+                return encoder.encode(value);
             }
 
-            void downsample2x2R8(uint32_t width, uint32_t height,
-                                 const std::vector<float>& original, std::vector<float>& resized)
+            inline uint8_t average(uint32_t a, uint32_t b, uint32_t c, uint32_t d) noexcept
             {
-                std::vector<float> normalized(width * height * 1);
+                return static_cast<uint8_t>((a + b + c + d + 2) >> 2);
+            }
 
-                const uint32_t dstWidth = width >> 1;
-                const uint32_t dstHeight = height >> 1;
-                const uint32_t pitch = width * 1;
-                resized.resize(dstWidth * dstHeight * 1);
-                const float* src = original.data();
-                float* dst = resized.data();
+            // each of the row functions averages 2x2 blocks of two source rows into one destination row
+            void downsampleRowR8(const uint8_t* src0, const uint8_t* src1, uint8_t* dst, uint32_t dstWidth)
+            {
+                uint32_t x = 0;
 
-                if (dstWidth > 0 && dstHeight > 0)
+                if (isSimdAvailable)
                 {
-                    for (uint32_t y = 0; y < dstHeight; ++y, src += pitch * 2)
+#if defined(__ARM_NEON__)
+                    for (; x + 8 <= dstWidth; x += 8)
                     {
-                        const float* pixel = src;
-                        for (uint32_t x = 0; x < dstWidth; ++x, pixel += 2, dst += 1)
-                        {
-                            float r = 0.0F;
-                            r += pixel[0];
-                            r += pixel[1];
-                            r += pixel[pitch + 0];
-                            r += pixel[pitch + 1];
-                            dst[0] = r / 4.0F;
-                        }
+                        const uint16x8_t sum = vpadalq_u8(vpaddlq_u8(vld1q_u8(src0 + x * 2)), vld1q_u8(src1 + x * 2));
+                        vst1_u8(dst + x, vrshrn_n_u16(sum, 2));
                     }
-                }
-                else if (dstHeight > 0)
-                {
-                    for (uint32_t y = 0; y < dstHeight; ++y, src += pitch * 2, dst += 1)
+#elif defined(__SSE2__)
+                    const __m128i lowMask = _mm_set1_epi16(0x00FF);
+                    const __m128i rounding = _mm_set1_epi16(2);
+
+                    for (; x + 8 <= dstWidth; x += 8)
                     {
-                        const float* pixel = src;
+                        const __m128i row0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src0 + x * 2));
+                        const __m128i row1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src1 + x * 2));
 
-                        float r = 0.0F;
-                        r += pixel[0];
-                        r += pixel[pitch + 0];
-                        dst[0] = r / 2.0F;
+                        __m128i sum = _mm_add_epi16(_mm_and_si128(row0, lowMask), _mm_srli_epi16(row0, 8));
+                        sum = _mm_add_epi16(sum, _mm_and_si128(row1, lowMask));
+                        sum = _mm_add_epi16(sum, _mm_srli_epi16(row1, 8));
+                        sum = _mm_srli_epi16(_mm_add_epi16(sum, rounding), 2);
+
+                        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + x), _mm_packus_epi16(sum, sum));
                     }
+#endif
                 }
-                else if (dstWidth > 0)
+
+                for (; x < dstWidth; ++x)
                 {
-                    const float* pixel = src;
-                    for (uint32_t x = 0; x < dstWidth; ++x, pixel += 2, dst += 1)
-                    {
-                        float r = 0.0F;
-                        r += pixel[0];
-                        r += pixel[1];
-                        dst[0] = r / 2.0F;
-                    }
+                    const uint8_t* pixel0 = src0 + x * 2;
+                    const uint8_t* pixel1 = src1 + x * 2;
+                    dst[x] = average(pixel0[0], pixel0[1], pixel1[0], pixel1[1]);
                 }
             }
 
-            void downsample2x2Rg8(uint32_t width, uint32_t height,
-                                  const std::vector<float>& original, std::vector<float>& resized)
+            void downsampleRowRg8(const uint8_t* src0, const uint8_t* src1, uint8_t* dst, uint32_t dstWidth)
             {
-                std::vector<float> normalized(width * height * 2);
-
-                const uint32_t dstWidth = width >> 1;
-                const uint32_t dstHeight = height >> 1;
-                const uint32_t pitch = width * 2;
-                resized.resize(dstWidth * dstHeight * 2);
-                const float* src = original.data();
-                float* dst = resized.data();
+                uint32_t x = 0;
 
-                if (dstWidth > 0 && dstHeight > 0)
+                if (isSimdAvailable)
                 {
-                    for (uint32_t y = 0; y < dstHeight; ++y, src += pitch * 2)
+#if defined(__ARM_NEON__)
+                    for (; x + 8 <= dstWidth; x += 8)
                     {
-                        const float* pixel = src;
-                        for (uint32_t x = 0; x < dstWidth; ++x, pixel += 4, dst += 2)
-                        {
-                            float r = 0.0F;
-                            float g = 0.0F;
-
-                            r += pixel[0];
-                            g += pixel[1];
-
-                            r += pixel[2];
-                            g += pixel[3];
+                        const uint8x16x2_t row0 = vld2q_u8(src0 + x * 4);
+                        const uint8x16x2_t row1 = vld2q_u8(src1 + x * 4);
 
-                            r += pixel[pitch + 0];
-                            g += pixel[pitch + 1];
-
-                            r += pixel[pitch + 2];
-                            g += pixel[pitch + 3];
-
-                            dst[0] = r / 4.0F;
-                            dst[1] = g / 4.0F;
-                        }
+                        uint8x8x2_t result;
+                        result.val[0] = vrshrn_n_u16(vpadalq_u8(vpaddlq_u8(row0.val[0]), row1.val[0]), 2);
+                        result.val[1] = vrshrn_n_u16(vpadalq_u8(vpaddlq_u8(row0.val[1]), row1.val[1]), 2);
+                        vst2_u8(dst + x * 2, result);
                     }
-                }
-                else if (dstHeight > 0)
-                {
-                    for (uint32_t y = 0; y < dstHeight; ++y, src += pitch * 2, dst += 2)
-                    {
-                        const float* pixel = src;
-                        float r = 0.0F;
-                        float g = 0.0F;
+#elif defined(__SSE2__)
+                    const __m128i zero = _mm_setzero_si128();
+                    const __m128i rounding = _mm_set1_epi16(2);
 
-                        r += pixel[0];
-                        g += pixel[1];
+                    for (; x + 4 <= dstWidth; x += 4)
+                    {
+                        const __m128i row0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src0 + x * 4));
+                        const __m128i row1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src1 + x * 4));
 
-                        r += pixel[pitch + 0];
-                        g += pixel[pitch + 1];
+                        // every 32-bit lane holds one pixel with 16-bit channels
+                        const __m128i low = _mm_add_epi16(_mm_unpacklo_epi8(row0, zero), _mm_unpacklo_epi8(row1, zero));
+                        const __m128i high = _mm_add_epi16(_mm_unpackhi_epi8(row0, zero), _mm_unpackhi_epi8(row1, zero));
+                        const __m128i even = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(low), _mm_castsi128_ps(high), _MM_SHUFFLE(2, 0, 2, 0)));
+                        const __m128i odd = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(low), _mm_castsi128_ps(high), _MM_SHUFFLE(3, 1, 3, 1)));
+                        const __m128i sum = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(even, odd), rounding), 2);
 
-                        dst[0] = r / 2.0F;
-                        dst[1] = g / 2.0F;
+                        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + x * 2), _mm_packus_epi16(sum, sum));
                     }
+#endif
                 }
-                else if (dstWidth > 0)
-                {
-                    const float* pixel = src;
-                    for (uint32_t x = 0; x < dstWidth; ++x, pixel += 4, dst += 2)
-                    {
-                        float r = 0.0F;
-                        float g = 0.0F;
-
-                        r += pixel[0];
-                        g += pixel[1];
 
-                        r += pixel[2];
-                        g += pixel[3];
-
-                        dst[0] = r / 2.0F;
-                        dst[1] = g / 2.0F;
-                    }
+                for (; x < dstWidth; ++x)
+                {
+                    const uint8_t* pixel0 = src0 + x * 4;
+                    const uint8_t* pixel1 = src1 + x * 4;
+                    dst[x * 2 + 0] = average(pixel0[0], pixel0[2], pixel1[0], pixel1[2]);
+                    dst[x * 2 + 1] = average(pixel0[1], pixel0[3], pixel1[1], pixel1[3]);
                 }
             }
 
-            void downsample2x2Rgba8(uint32_t width, uint32_t height,
-                                    const std::vector<float>& original, std::vector<float>& resized)
+            // the color is averaged only from the pixels that are not fully transparent
+            void downsampleRowRgba8(const uint8_t* src0, const uint8_t* src1, uint8_t* dst, uint32_t dstWidth)
             {
-                const uint32_t dstWidth = width >> 1;
-                const uint32_t dstHeight = height >> 1;
-                const uint32_t pitch = width * 4;
-                resized.resize(dstWidth * dstHeight * 4);
-                const float* src = original.data();
-                float* dst = resized.data();
-
-                if (dstWidth > 0 && dstHeight > 0)
+                uint32_t x = 0;
+
+                if (isSimdAvailable)
                 {
-                    for (uint32_t y = 0; y < dstHeight; ++y, src += pitch * 2)
+#if defined(__ARM_NEON__)
+                    // reciprocals of the opaque pixel count (0-4) in 1.15 fixed point
+                    static const uint8_t reciprocalLowBytes[8] = {0x00, 0x00, 0x00, 0xAB, 0x00, 0x00, 0x00, 0x00};
+                    static const uint8_t reciprocalHighBytes[8] = {0x00, 0x80, 0x40, 0x2A, 0x20, 0x00, 0x00, 0x00};
+                    const uint8x8_t reciprocalLow = vld1_u8(reciprocalLowBytes);
+                    const uint8x8_t reciprocalHigh = vld1_u8(reciprocalHighBytes);
+                    const uint8x16_t one = vdupq_n_u8(1);
+
+                    for (; x + 8 <= dstWidth; x += 8)
                     {
-                        const float* pixel = src;
-                        for (uint32_t x = 0; x < dstWidth; ++x, pixel += 8, dst += 4)
+                        const uint8x16x4_t row0 = vld4q_u8(src0 + x * 8);
+                        const uint8x16x4_t row1 = vld4q_u8(src1 + x * 8);
+
+                        const uint8x16_t opaque0 = vtstq_u8(row0.val[3], row0.val[3]);
+                        const uint8x16_t opaque1 = vtstq_u8(row1.val[3], row1.val[3]);
+                        const uint8x8_t count = vmovn_u16(vpadalq_u8(vpaddlq_u8(vandq_u8(opaque0, one)), vandq_u8(opaque1, one)));
+                        const uint16x8_t reciprocal = vorrq_u16(vshll_n_u8(vtbl1_u8(reciprocalHigh, count), 8),
+                                                                vmovl_u8(vtbl1_u8(reciprocalLow, count)));
+
+                        uint8x8x4_t result;
+                        for (int c = 0; c < 3; ++c)
                         {
-                            float pixels = 0.0F;
-                            float r = 0.0F;
-                            float g = 0.0F;
-                            float b = 0.0F;
-                            float a = 0.0F;
-
-                            if (pixel[3] > 0.0F)
-                            {
-                                r += pixel[0];
-                                g += pixel[1];
-                                b += pixel[2];
-                                pixels += 1.0F;
-                            }
-                            a += pixel[3];
-
-                            if (pixel[7] > 0.0F)
-                            {
-                                r += pixel[4];
-                                g += pixel[5];
-                                b += pixel[6];
-                                pixels += 1.0F;
-                            }
-                            a += pixel[7];
-
-                            if (pixel[pitch + 3] > 0.0F)
-                            {
-                                r += pixel[pitch + 0];
-                                g += pixel[pitch + 1];
-                                b += pixel[pitch + 2];
-                                pixels += 1.0F;
-                            }
-                            a += pixel[pitch + 3];
-
-                            if (pixel[pitch + 7] > 0.0F)
-                            {
-                                r += pixel[pitch + 4];
-                                g += pixel[pitch + 5];
-                                b += pixel[pitch + 6];
-                                pixels += 1.0F;
-                            }
-                            a += pixel[pitch + 7];
-
-                            if (pixels > 0.0F)
-                            {
-                                dst[0] = r / pixels;
-                                dst[1] = g / pixels;
-                                dst[2] = b / pixels;
-                                dst[3] = a / 4.0F;
-                            }
-                            else
-                            {
-                                dst[0] = 0;
-                                dst[1] = 0;
-                                dst[2] = 0;
-                                dst[3] = 0;
-                            }
+                            const uint16x8_t sum = vpadalq_u8(vpaddlq_u8(vandq_u8(row0.val[c], opaque0)),
+                                                              vandq_u8(row1.val[c], opaque1));
+                            result.val[c] = vmovn_u16(vcombine_u16(vrshrn_n_u32(vmull_u16(vget_low_u16(sum), vget_low_u16(reciprocal)), 15),
+                                                                   vrshrn_n_u32(vmull_u16(vget_high_u16(sum), vget_high_u16(reciprocal)), 15)));
                         }
+                        result.val[3] = vrshrn_n_u16(vpadalq_u8(vpaddlq_u8(row0.val[3]), row1.val[3]), 2);
+
+                        vst4_u8(dst + x * 4, result);
                     }
+#elif defined(__SSE2__)
+                    const __m128i zero = _mm_setzero_si128();
+                    const __m128i one = _mm_set1_epi32(1);
+                    const __m128i alphaMask = _mm_slli_epi32(_mm_set1_epi32(0xFF), 24);
+                    const __m128i alphaLanes = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+                    const __m128i rounding = _mm_set1_epi16(2);
+                    const __m128 half = _mm_set1_ps(0.5F);
+                    const __m128 minCount = _mm_set1_ps(1.0F);
+
+                    for (; x + 2 <= dstWidth; x += 2)
+                    {
+                        __m128i row0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src0 + x * 8));
+                        __m128i row1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src1 + x * 8));
+
+                        // clear the color of the transparent pixels
+                        const __m128i transparent0 = _mm_cmpeq_epi32(_mm_and_si128(row0, alphaMask), zero);
+                        const __m128i transparent1 = _mm_cmpeq_epi32(_mm_and_si128(row1, alphaMask), zero);
+                        row0 = _mm_andnot_si128(_mm_andnot_si128(alphaMask, transparent0), row0);
+                        row1 = _mm_andnot_si128(_mm_andnot_si128(alphaMask, transparent1), row1);
+
+                        const __m128i low = _mm_add_epi16(_mm_unpacklo_epi8(row0, zero), _mm_unpacklo_epi8(row1, zero));
+                        const __m128i high = _mm_add_epi16(_mm_unpackhi_epi8(row0, zero), _mm_unpackhi_epi8(row1, zero));
+                        const __m128i sum = _mm_add_epi16(_mm_unpacklo_epi64(low, high), _mm_unpackhi_epi64(low, high));
+
+                        const __m128 opaque = _mm_cvtepi32_ps(_mm_add_epi32(_mm_andnot_si128(transparent0, one),
+                                                                            _mm_andnot_si128(transparent1, one)));
+                        const __m128 count0 = _mm_max_ps(_mm_add_ps(_mm_shuffle_ps(opaque, opaque, _MM_SHUFFLE(0, 0, 0, 0)),
+                                                                    _mm_shuffle_ps(opaque, opaque, _MM_SHUFFLE(1, 1, 1, 1))), minCount);
+                        const __m128 count1 = _mm_max_ps(_mm_add_ps(_mm_shuffle_ps(opaque, opaque, _MM_SHUFFLE(2, 2, 2, 2)),
+                                                                    _mm_shuffle_ps(opaque, opaque, _MM_SHUFFLE(3, 3, 3, 3))), minCount);
+
+                        const __m128i color0 = _mm_cvttps_epi32(_mm_add_ps(_mm_div_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(sum, zero)), count0), half));
+                        const __m128i color1 = _mm_cvttps_epi32(_mm_add_ps(_mm_div_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(sum, zero)), count1), half));
+                        const __m128i color = _mm_packs_epi32(color0, color1);
+                        const __m128i alpha = _mm_srli_epi16(_mm_add_epi16(sum, rounding), 2);
+                        const __m128i result = _mm_or_si128(_mm_and_si128(alphaLanes, alpha), _mm_andnot_si128(alphaLanes, color));
+
+                        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + x * 4), _mm_packus_epi16(result, result));
+                    }
+#endif
                 }
-                else if (dstHeight > 0)
+
+                for (; x < dstWidth; ++x)
                 {
-                    for (uint32_t y = 0; y < dstHeight; ++y, src += pitch * 2, dst += 4)
-                    {
-                        const float* pixel = src;
+                    const uint8_t* pixels[] = {src0 + x * 8, src0 + x * 8 + 4, src1 + x * 8, src1 + x * 8 + 4};
 
-                        float pixels = 0.0F;
-                        float r = 0.0F;
-                        float g = 0.0F;
-                        float b = 0.0F;
-                        float a = 0.0F;
+                    uint32_t count = 0;
+                    uint32_t r = 0;
+                    uint32_t g = 0;
+                    uint32_t b = 0;
 
+                    for (const uint8_t* pixel : pixels)
                         if (pixel[3] > 0)
                         {
                             r += pixel[0];
                             g += pixel[1];
                             b += pixel[2];
-                            pixels += 1.0F;
+                            ++count;
                         }
-                        a = pixel[3];
 
-                        if (pixel[pitch + 3] > 0)
-                        {
-                            r += pixel[pitch + 0];
-                            g += pixel[pitch + 1];
-                            b += pixel[pitch + 2];
-                            pixels += 1.0F;
-                        }
-                        a += pixel[pitch + 3];
+                    uint8_t* pixel = dst + x * 4;
 
-                        if (pixels > 0.0F)
-                        {
-                            dst[0] = r / pixels;
-                            dst[1] = g / pixels;
-                            dst[2] = b / pixels;
-                            dst[3] = a / 2.0F;
-                        }
-                        else
-                        {
-                            dst[0] = 0;
-                            dst[1] = 0;
-                            dst[2] = 0;
-                            dst[3] = 0;
-                        }
+                    if (count > 0)
+                    {
+                        pixel[0] = static_cast<uint8_t>((r * 2 + count) / (count * 2));
+                        pixel[1] = static_cast<uint8_t>((g * 2 + count) / (count * 2));
+                        pixel[2] = static_cast<uint8_t>((b * 2 + count) / (count * 2));
+                    }
+                    else
+                    {
+                        pixel[0] = 0;
+                        pixel[1] = 0;
+                        pixel[2] = 0;
                     }
+
+                    pixel[3] = average(pixels[0][3], pixels[1][3], pixels[2][3], pixels[3][3]);
                 }
-                else if (dstWidth > 0)
+            }
+
+            // sRGB colors are averaged in linear space
+            void downsampleRowRgba8SRgb(const uint8_t* src0, const uint8_t* src1, uint8_t* dst, uint32_t dstWidth)
+            {
+                for (uint32_t x = 0; x < dstWidth; ++x)
                 {
-                    const float* pixel = src;
-                    for (uint32_t x = 0; x < dstWidth; ++x, pixel += 8, dst += 4)
-                    {
-                        float pixels = 0.0F;
-                        float r = 0.0F;
-                        float g = 0.0F;
-                        float b = 0.0F;
-                        float a = 0.0F;
+                    const uint8_t* pixels[] = {src0 + x * 8, src0 + x * 8 + 4, src1 + x * 8, src1 + x * 8 + 4};
 
+                    float count = 0.0F;
+                    float r = 0.0F;
+                    float g = 0.0F;
+                    float b = 0.0F;
+
+                    for (const uint8_t* pixel : pixels)
                         if (pixel[3] > 0)
                         {
-                            r += pixel[0];
-                            g += pixel[1];
-                            b += pixel[2];
-                            pixels += 1.0F;
+                            r += gammaDecode(pixel[0]);
+                            g += gammaDecode(pixel[1]);
+                            b += gammaDecode(pixel[2]);
+                            count += 1.0F;
                         }
-                        a += pixel[3];
 
-                        if (pixel[7] > 0)
-                        {
-                            r += pixel[4];
-                            g += pixel[5];
-                            b += pixel[6];
-                            pixels += 1.0F;
-                        }
-                        a += pixel[7];
+                    uint8_t* pixel = dst + x * 4;
 
-                        if (pixels > 0.0F)
-                        {
-                            dst[0] = r / pixels;
-                            dst[1] = g / pixels;
-                            dst[2] = b / pixels;
-                            dst[3] = a / 2.0F;
-                        }
-                        else
-                        {
-                            dst[0] = 0;
-                            dst[1] = 0;
-                            dst[2] = 0;
-                            dst[3] = 0;
-                        }
+                    if (count > 0.0F)
+                    {
+                        pixel[0] = gammaEncode(r / count);
+                        pixel[1] = gammaEncode(g / count);
+                        pixel[2] = gammaEncode(b / count);
                     }
+                    else
+                    {
+                        pixel[0] = 0;
+                        pixel[1] = 0;
+                        pixel[2] = 0;
+                    }
+
+                    pixel[3] = average(pixels[0][3], pixels[1][3], pixels[2][3], pixels[3][3]);
                 }
             }
 
-            inline float gammaDecode(uint8_t value) noexcept
-            {
-                return GAMMA_DECODE[value]; // std::pow(value / 255.0F, GAMMA);
-            }
+            using DownsampleRowFunction = void(*)(const uint8_t*, const uint8_t*, uint8_t*, uint32_t);
 
-            inline uint8_t gammaEncode(float value) noexcept
+            DownsampleRowFunction getDownsampleRowFunction(PixelFormat pixelFormat)
             {
-                return static_cast<uint8_t>(std::round(std::pow(value, 1.0F / GAMMA) * 255.0F));
+                switch (pixelFormat)
+                {
+                    case PixelFormat::RGBA8UNorm: return downsampleRowRgba8;
+                    case PixelFormat::RGBA8UNormSRGB: return downsampleRowRgba8SRgb;
+                    case PixelFormat::RG8UNorm: return downsampleRowRg8;
+                    case PixelFormat::R8UNorm: return downsampleRowR8;
+                    case PixelFormat::A8UNorm: return downsampleRowR8;
+                    default: throw std::runtime_error("Invalid pixel format");
+                }
             }
 
-            void decode(const Size2U& size,
-                        const std::vector<uint8_t>& encodedData,
-                        PixelFormat pixelFormat,
-                        std::vector<float>& decodedData)
+            void downsampleRows(DownsampleRowFunction downsampleRow, uint32_t pixelSize,
+                                const Size2U& size, const uint8_t* src,
+                                const Size2U& newSize, uint8_t* dst,
+                                uint32_t startRow, uint32_t endRow)
             {
-                const uint32_t channelCount = getChannelCount(pixelFormat);
-                const uint32_t pitch = size.width() * channelCount;
-                decodedData.resize(size.width() * size.height() * channelCount);
-                const uint8_t* src = encodedData.data();
-                float* dst = decodedData.data();
+                const uint32_t pitch = size.v[0] * pixelSize;
+                const uint32_t newPitch = newSize.v[0] * pixelSize;
 
-                switch (pixelFormat)
+                for (uint32_t y = startRow; y < endRow; ++y)
                 {
-                    case PixelFormat::RGBA8UNorm:
-                    case PixelFormat::RGBA8UNormSRGB:
-                        for (uint32_t y = 0; y < size.height(); ++y, src += pitch)
-                        {
-                            const uint8_t* pixel = src;
-                            for (uint32_t x = 0; x < size.width(); ++x, pixel += 4, dst += 4)
-                            {
-                                dst[0] = gammaDecode(pixel[0]); // red
-                                dst[1] = gammaDecode(pixel[1]); // green
-                                dst[2] = gammaDecode(pixel[2]); // blue
-                                dst[3] = pixel[3] / 255.0F; // alpha
-                            }
-                        }
-                        break;
+                    // one pixel high levels are averaged only horizontally
+                    const uint8_t* src0 = src + std::min(y * 2, size.v[1] - 1) * pitch;
+                    const uint8_t* src1 = src + std::min(y * 2 + 1, size.v[1] - 1) * pitch;
 
-                    case PixelFormat::RG8UNorm:
-                        for (uint32_t y = 0; y < size.height(); ++y, src += pitch)
-                        {
-                            const uint8_t* pixel = src;
-                            for (uint32_t x = 0; x < size.width(); ++x, pixel += 2, dst += 2)
-                            {
-                                dst[0] = gammaDecode(pixel[0]); // red
-                                dst[1] = gammaDecode(pixel[1]); // green
-                            }
-                        }
-                        break;
-
-                    case PixelFormat::R8UNorm:
-                        for (uint32_t y = 0; y < size.height(); ++y, src += pitch)
-                        {
-                            const uint8_t* pixel = src;
-                            for (uint32_t x = 0; x < size.width(); ++x, pixel += 4, dst += 1)
-                            {
-                                dst[0] = gammaDecode(pixel[0]); // red
-                            }
-                        }
-                        break;
-
-                    case PixelFormat::A8UNorm:
-                        for (uint32_t y = 0; y < size.height(); ++y, src += pitch)
-                        {
-                            const uint8_t* pixel = src;
-                            for (uint32_t x = 0; x < size.width(); ++x, pixel += 1, dst += 1)
-                            {
-                                dst[0] = pixel[0] / 255.0F; // alpha
-                            }
-                        }
-                        break;
-
-                    default:
-                        throw std::runtime_error("Invalid pixel format");
+                    if (size.v[0] == 1)
+                    {
+                        // duplicate the only column, so that it is averaged only vertically
+                        uint8_t column0[8];
+                        uint8_t column1[8];
+                        std::copy(src0, src0 + pixelSize, column0);
+                        std::copy(src0, src0 + pixelSize, column0 + pixelSize);
+                        std::copy(src1, src1 + pixelSize, column1);
+                        std::copy(src1, src1 + pixelSize, column1 + pixelSize);
+
+                        downsampleRow(column0, column1, dst + y * newPitch, 1);
+                    }
+                    else
+                        downsampleRow(src0, src1, dst + y * newPitch, newSize.v[0]);
                 }
             }
 
-            void encode(const Size2U& size,
-                        const std::vector<float>& decodedData,
-                        PixelFormat pixelFormat,
-                        std::vector<uint8_t>& encodedData)
+            void downsample(PixelFormat pixelFormat,
+                            const Size2U& size, const std::vector<uint8_t>& data,
+                            const Size2U& newSize, std::vector<uint8_t>& newData,
+                            bool parallel)
             {
+                const DownsampleRowFunction downsampleRow = getDownsampleRowFunction(pixelFormat);
                 const uint32_t pixelSize = getPixelSize(pixelFormat);
-                const uint32_t pitch = size.width() * pixelSize;
-                encodedData.resize(size.width() * size.height() * pixelSize);
-                const float* src = decodedData.data();
-                uint8_t* dst = encodedData.data();
+                const uint32_t rowCount = newSize.v[1];
 
-                switch (pixelFormat)
-                {
-                    case PixelFormat::RGBA8UNorm:
-                    case PixelFormat::RGBA8UNormSRGB:
-                        for (uint32_t y = 0; y < size.height(); ++y, src += pitch)
-                        {
-                            const float* pixel = src;
-                            for (uint32_t x = 0; x < size.width(); ++x, pixel += 4, dst += 4)
-                            {
-                                dst[0] = gammaEncode(pixel[0]); // red
-                                dst[1] = gammaEncode(pixel[1]); // green
-                                dst[2] = gammaEncode(pixel[2]); // blue
-                                dst[3] = static_cast<uint8_t>(std::round(pixel[3] * 255.0F)); // alpha
-                            }
-                        }
-                        break;
+#if !defined(__EMSCRIPTEN__)
+                const uint32_t threadCount = (parallel && newSize.v[0] * newSize.v[1] >= PARALLEL_PIXEL_COUNT) ?
+                    std::min(std::max(std::thread::hardware_concurrency(), 1U), rowCount) : 1;
 
-                    case PixelFormat::RG8UNorm:
-                        for (uint32_t y = 0; y < size.height(); ++y, src += pitch)
-                        {
-                            const float* pixel = src;
-                            for (uint32_t x = 0; x < size.width(); ++x, pixel += 2, dst += 2)
-                            {
-                                dst[0] = gammaEncode(pixel[0]); // red
-                                dst[1] = gammaEncode(pixel[1]); // green
-                            }
-                        }
-                        break;
-
-                    case PixelFormat::R8UNorm:
-                        for (uint32_t y = 0; y < size.height(); ++y, src += pitch)
-                        {
-                            const float* pixel = src;
-                            for (uint32_t x = 0; x < size.width(); ++x, pixel += 1, dst += 1)
-                            {
-                                dst[0] = gammaEncode(pixel[0]); // red
-                            }
-                        }
-                        break;
+                if (threadCount > 1)
+                {
+                    const uint32_t rowsPerThread = (rowCount + threadCount - 1) / threadCount;
+                    std::vector<std::thread> threads;
+                    threads.reserve(threadCount - 1);
 
-                    case PixelFormat::A8UNorm:
-                        for (uint32_t y = 0; y < size.height(); ++y, src += pitch)
-                        {
-                            const float* pixel = src;
-                            for (uint32_t x = 0; x < size.width(); ++x, pixel += 1, dst += 1)
-                            {
-                                dst[0] = static_cast<uint8_t>(std::round(pixel[0] * 255.0F)); // alpha
-                            }
-                        }
-                        break;
+                    try
+                    {
+                        for (uint32_t startRow = rowsPerThread; startRow < rowCount; startRow += rowsPerThread)
+                            threads.emplace_back(downsampleRows, downsampleRow, pixelSize,
+                                                 size, data.data(), newSize, newData.data(),
+                                                 startRow, std::min(startRow + rowsPerThread, rowCount));
+
+                        downsampleRows(downsampleRow, pixelSize,
+                                       size, data.data(), newSize, newData.data(),
+                                       0, rowsPerThread);
+                    }
+                    catch (...)
+                    {
+                        for (std::thread& thread : threads) thread.join();
+                        throw;
+                    }
 
-                    default:
-                        throw std::runtime_error("Invalid pixel format");
+                    for (std::thread& thread : threads) thread.join();
+                    return;
                 }
+#else
+                static_cast<void>(parallel);
+#endif
+
+                downsampleRows(downsampleRow, pixelSize,
+                               size, data.data(), newSize, newData.data(),
+                               0, rowCount);
             }
 
             std::vector<std::pair<Size2U, std::vector<uint8_t>>> calculateSizes(const Size2U& size,
@@ -571,27 +479,22 @@ namespace ouzel
                 return levels;
             }
 
+
             std::vector<std::pair<Size2U, std::vector<uint8_t>>> calculateSizes(const Size2U& size,
                                                                                 const std::vector<uint8_t>& data,
                                                                                 uint32_t mipmaps,
-                                                                                PixelFormat pixelFormat)
+                                                                                PixelFormat pixelFormat,
+                                                                                bool parallel = true)
             {
                 std::vector<std::pair<Size2U, std::vector<uint8_t>>> levels;
 
                 uint32_t newWidth = size.v[0];
                 uint32_t newHeight = size.v[1];
 
+                const uint32_t pixelSize = getPixelSize(pixelFormat);
                 levels.emplace_back(size, data);
 
-                uint32_t previousWidth = newWidth;
-                uint32_t previousHeight = newHeight;
-                std::vector<float> previousData;
-
-                decode(size, data, pixelFormat, previousData);
-
-                std::vector<float> newData;
-                std::vector<uint8_t> encodedData;
-
+                // every level is downsampled directly from the previous one
                 while ((newWidth > 1 || newHeight > 1) &&
                     (mipmaps == 0 || levels.size() < mipmaps))
                 {
@@ -602,40 +505,29 @@ namespace ouzel
                     if (newHeight < 1) newHeight = 1;
 
                     auto mipMapSize = Size2U(newWidth, newHeight);
+                    std::vector<uint8_t> newData(newWidth * newHeight * pixelSize);
 
-                    switch (pixelFormat)
-                    {
-                        case PixelFormat::RGBA8UNorm:
-                        case PixelFormat::RGBA8UNormSRGB:
-                            downsample2x2Rgba8(previousWidth, previousHeight, previousData, newData);
-                            break;
-
-                        case PixelFormat::RG8UNorm:
-                            downsample2x2Rg8(previousWidth, previousHeight, previousData, newData);
-                            break;
-
-                        case PixelFormat::R8UNorm:
-                            downsample2x2R8(previousWidth, previousHeight, previousData, newData);
-                            break;
+                    downsample(pixelFormat, levels.back().first, levels.back().second, mipMapSize, newData, parallel);
 
-                        case PixelFormat::A8UNorm:
-                            downsample2x2A8(previousWidth, previousHeight, previousData, newData);
-                            break;
-
-                        default:
-                            throw std::runtime_error("Invalid pixel format");
-                    }
+                    levels.emplace_back(mipMapSize, std::move(newData));
+                }
 
-                    encode(mipMapSize, newData, pixelFormat, encodedData);
-                    levels.emplace_back(mipMapSize, encodedData);
+                return levels;
+            }
 
-                    previousData = newData;
+            // copies the levels to the command buffer, so that the command can refer to them
+            Span<const TextureLevel> addLevels(Renderer& renderer,
+                                               const std::vector<std::pair<Size2U, std::vector<uint8_t>>>& levels)
+            {
+                Span<TextureLevel> result = renderer.allocateData<TextureLevel>(levels.size());
 
-                    previousWidth = newWidth;
-                    previousHeight = newHeight;
+                for (size_t i = 0; i < levels.size(); ++i)
+                {
+                    result[i].size = levels[i].first;
+                    result[i].data = renderer.addData<uint8_t>(levels[i].second);
                 }
 
-                return levels;
+                return result;
             }
         }
 
@@ -668,12 +560,12 @@ namespace ouzel
 
             std::vector<std::pair<Size2U, std::vector<uint8_t>>> levels = calculateSizes(size, mipmaps, pixelFormat);
 
-            initRenderer.addCommand(std::make_unique<InitTextureCommand>(resource,
-                                                                        levels,
-                                                                        TextureType::TwoDimensional,
-                                                                        flags,
-                                                                        sampleCount,
-                                                                        pixelFormat));
+            initRenderer.addCommand<InitTextureCommand>(resource,
+                                                       addLevels(initRenderer, levels),
+                                                       TextureType::TwoDimensional,
+                                                       flags,
+                                                       sampleCount,
+                                                       pixelFormat);
         }
 
         Texture::Texture(Renderer& initRenderer,
@@ -699,12 +591,12 @@ namespace ouzel
 
             std::vector<std::pair<Size2U, std::vector<uint8_t>>> levels = calculateSizes(size, initData, mipmaps, pixelFormat);
 
-            initRenderer.addCommand(std::make_unique<InitTextureCommand>(resource,
-                                                                         levels,
-                                                                         TextureType::TwoDimensional,
-                                                                         flags,
-                                                                         sampleCount,
-                                                                         pixelFormat));
+            initRenderer.addCommand<InitTextureCommand>(resource,
+                                                        addLevels(initRenderer, levels),
+                                                        TextureType::TwoDimensional,
+                                                        flags,
+                                                        sampleCount,
+                                                        pixelFormat);
         }
 
         Texture::Texture(Renderer& initRenderer,
@@ -732,12 +624,21 @@ namespace ouzel
                 levels.resize(1);
             }
 
-            initRenderer.addCommand(std::make_unique<InitTextureCommand>(resource,
-                                                                         levels,
-                                                                         TextureType::TwoDimensional,
-                                                                         flags,
-                                                                         sampleCount,
-                                                                         pixelFormat));
+            initRenderer.addCommand<InitTextureCommand>(resource,
+                                                        addLevels(initRenderer, levels),
+                                                        TextureType::TwoDimensional,
+                                                        flags,
+                                                        sampleCount,
+                                                        pixelFormat);
+        }
+
+        std::vector<std::pair<Size2U, std::vector<uint8_t>>> Texture::generateLevels(const Size2U& size,
+                                                                                     const std::vector<uint8_t>& data,
+                                                                                     uint32_t mipmaps,
+                                                                                     PixelFormat pixelFormat)
+        {
+            // the loader threads already keep the cores busy, so the rows are not split between more threads
+            return calculateSizes(size, data, mipmaps, pixelFormat, false);
         }
 
         void Texture::setData(const std::vector<uint8_t>& newData, CubeFace face)
@@ -748,9 +649,30 @@ namespace ouzel
             std::vector<std::pair<Size2U, std::vector<uint8_t>>> levels = calculateSizes(size, newData, mipmaps, pixelFormat);
 
             if (resource)
-                renderer->addCommand(std::make_unique<SetTextureDataCommand>(resource,
-                                                                             levels,
-                                                                             face));
+                renderer->addCommand<SetTextureDataCommand>(resource,
+                                                            addLevels(*renderer, levels),
+                                                            face);
+        }
+
+        void Texture::setRegionData(uint32_t x, uint32_t y, const Size2U& regionSize, Span<const uint8_t> newData)
+        {
+            if (!(flags & Flags::Dynamic) || flags & Flags::BindRenderTarget)
+                throw std::runtime_error("Texture is not dynamic");
+
+            if (mipmaps != 1)
+                throw std::runtime_error("Texture regions can only be set for textures without mip maps");
+
+            if (x + regionSize.v[0] > size.v[0] || y + regionSize.v[1] > size.v[1])
+                throw std::runtime_error("Invalid texture region");
+
+            if (newData.size() != regionSize.v[0] * regionSize.v[1] * getPixelSize(pixelFormat))
+                throw std::runtime_error("Invalid texture data");
+
+            if (resource)
+                renderer->addCommand<SetTextureRegionCommand>(resource,
+                                                              x, y,
+                                                              regionSize,
+                                                              renderer->addData<uint8_t>(newData));
         }
 
         void Texture::setFilter(SamplerFilter newFilter)
@@ -758,13 +680,13 @@ namespace ouzel
             filter = newFilter;
 
             if (resource)
-                renderer->addCommand(std::make_unique<SetTextureParametersCommand>(resource,
-                                                                                   filter,
-                                                                                   addressX,
-                                                                                   addressY,
-                                                                                   addressZ,
-                                                                                   borderColor,
-                                                                                   maxAnisotropy));
+                renderer->addCommand<SetTextureParametersCommand>(resource,
+                                                                  filter,
+                                                                  addressX,
+                                                                  addressY,
+                                                                  addressZ,
+                                                                  borderColor,
+                                                                  maxAnisotropy);
         }
 
         void Texture::setAddressX(SamplerAddressMode newAddressX)
@@ -772,13 +694,13 @@ namespace ouzel
             addressX = newAddressX;
 
             if (resource)
-                renderer->addCommand(std::make_unique<SetTextureParametersCommand>(resource,
-                                                                                   filter,
-                                                                                   addressX,
-                                                                                   addressY,
-                                                                                   addressZ,
-                                                                                   borderColor,
-                                                                                   maxAnisotropy));
+                renderer->addCommand<SetTextureParametersCommand>(resource,
+                                                                  filter,
+                                                                  addressX,
+                                                                  addressY,
+                                                                  addressZ,
+                                                                  borderColor,
+                                                                  maxAnisotropy);
         }
 
         void Texture::setAddressY(SamplerAddressMode newAddressY)
@@ -786,13 +708,13 @@ namespace ouzel
             addressY = newAddressY;
 
             if (resource)
-                renderer->addCommand(std::make_unique<SetTextureParametersCommand>(resource,
-                                                                                   filter,
-                                                                                   addressX,
-                                                                                   addressY,
-                                                                                   addressZ,
-                                                                                   borderColor,
-                                                                                   maxAnisotropy));
+                renderer->addCommand<SetTextureParametersCommand>(resource,
+                                                                  filter,
+                                                                  addressX,
+                                                                  addressY,
+                                                                  addressZ,
+                                                                  borderColor,
+                                                                  maxAnisotropy);
         }
 
         void Texture::setAddressZ(SamplerAddressMode newAddressZ)
@@ -800,13 +722,13 @@ namespace ouzel
             addressZ = newAddressZ;
 
             if (resource)
-                renderer->addCommand(std::make_unique<SetTextureParametersCommand>(resource,
-                                                                                   filter,
-                                                                                   addressX,
-                                                                                   addressY,
-                                                                                   addressZ,
-                                                                                   borderColor,
-                                                                                   maxAnisotropy));
+                renderer->addCommand<SetTextureParametersCommand>(resource,
+                                                                  filter,
+                                                                  addressX,
+                                                                  addressY,
+                                                                  addressZ,
+                                                                  borderColor,
+                                                                  maxAnisotropy);
         }
 
         void Texture::setBorderColor(Color newBorderColor)
@@ -814,13 +736,13 @@ namespace ouzel
             borderColor = newBorderColor;
 
             if (resource)
-                renderer->addCommand(std::make_unique<SetTextureParametersCommand>(resource,
-                                                                                   filter,
-                                                                                   addressX,
-                                                                                   addressY,
-                                                                                   addressZ,
-                                                                                   borderColor,
-                                                                                   maxAnisotropy));
+                renderer->addCommand<SetTextureParametersCommand>(resource,
+                                                                  filter,
+                                                                  addressX,
+                                                                  addressY,
+                                                                  addressZ,
+                                                                  borderColor,
+                                                                  maxAnisotropy);
         }
 
         void Texture::setMaxAnisotropy(uint32_t newMaxAnisotropy)
@@ -828,13 +750,13 @@ namespace ouzel
             maxAnisotropy = newMaxAnisotropy;
 
             if (resource)
-                renderer->addCommand(std::make_unique<SetTextureParametersCommand>(resource,
-                                                                                   filter,
-                                                                                   addressX,
-                                                                                   addressY,
-                                                                                   addressZ,
-                                                                                   borderColor,
-                                                                                   maxAnisotropy));
+                renderer->addCommand<SetTextureParametersCommand>(resource,
+                                                                  filter,
+                                                                  addressX,
+                                                                  addressY,
+                                                                  addressZ,
+                                                                  borderColor,
+                                                                  maxAnisotropy);
         }
     } // namespace graphics
 } // namespace ouzel
@@ -14,6 +14,7 @@
 #include "graphics/TextureType.hpp"
 #include "math/Color.hpp"
 #include "math/Size.hpp"
+#include "utils/Span.hpp"
 
 namespace ouzel
 {
@@ -45,11 +46,20 @@ namespace ouzel
                     uint32_t initFlags = 0,
                     PixelFormat initPixelFormat = PixelFormat::RGBA8UNorm);
 
+            // downsamples the image to the given number of levels (0 for the full chain) on the calling thread
+            // without touching the renderer, so that it can be done on a loader thread
+            static std::vector<std::pair<Size2U, std::vector<uint8_t>>> generateLevels(const Size2U& size,
+                                                                                       const std::vector<uint8_t>& data,
+                                                                                       uint32_t mipmaps,
+                                                                                       PixelFormat pixelFormat);
+
             inline auto& getResource() const noexcept { return resource; }
 
             inline auto& getSize() const noexcept { return size; }
 
             void setData(const std::vector<uint8_t>& newData, CubeFace face = CubeFace::PositiveX);
+            // updates a rectangle of a dynamic texture without mipmaps
+            void setRegionData(uint32_t x, uint32_t y, const Size2U& regionSize, Span<const uint8_t> newData);
 
             inline auto getFlags() const noexcept { return flags; }
             inline auto getMipmaps() const noexcept { return mipmaps; }
@@ -16,7 +16,7 @@ namespace ouzel
             Buffer::Buffer(RenderDevice& initRenderDevice,
                            BufferType initType,
                            uint32_t initFlags,
-                           const std::vector<uint8_t>& data,
+                           Span<const uint8_t> data,
                            uint32_t initSize):
                 RenderResource(initRenderDevice),
                 type(initType),
@@ -26,7 +26,7 @@ namespace ouzel
                 createBuffer(initSize, data);
             }
 
-            void Buffer::setData(const std::vector<uint8_t>& data)
+            void Buffer::setData(Span<const uint8_t> data)
             {
                 if (!(flags & Flags::Dynamic))
                     throw std::runtime_error("Buffer is not dynamic");
@@ -56,7 +56,7 @@ namespace ouzel
                 }
             }
 
-            void Buffer::createBuffer(UINT newSize, const std::vector<uint8_t>& data)
+            void Buffer::createBuffer(UINT newSize, Span<const uint8_t> data)
             {
                 if (newSize)
                 {
@@ -4,6 +4,7 @@
 
 #if OUZEL_COMPILE_DIRECT3D11
 
+#include <algorithm>
 #include <cassert>
 #include "D3D11RenderDevice.hpp"
 #include "D3D11BlendState.hpp"
@@ -113,10 +114,12 @@ namespace ouzel
             {
                 running = false;
                 CommandBuffer commandBuffer;
-                commandBuffer.pushCommand(std::make_unique<PresentCommand>());
+                commandBuffer.pushCommand<PresentCommand>();
                 submitCommandBuffer(std::move(commandBuffer));
 
                 if (renderThread.isJoinable()) renderThread.join();
+
+                if (compilerModule) FreeLibrary(compilerModule);
             }
 
             void RenderDevice::init(Window* newWindow,
@@ -174,6 +177,17 @@ namespace ouzel
                 if (featureLevel >= D3D_FEATURE_LEVEL_10_0)
                     npotTexturesSupported = true;
 
+                // instance data streams need at least feature level 9.3
+                instancingSupported = featureLevel >= D3D_FEATURE_LEVEL_9_3;
+
+                // the instanced vertex shaders are compiled from source when they are loaded
+                compilerModule = LoadLibraryW(L"d3dcompiler_47.dll");
+
+                if (compilerModule)
+                    compileProc = reinterpret_cast<pD3DCompile>(GetProcAddress(compilerModule, "D3DCompile"));
+                else
+                    engine->log(Log::Level::Warning) << "Failed to load the shader compiler, instances will be drawn one by one";
+
 
 				void* dxgiDevicePtr;
                 device->QueryInterface(IID_IDXGIDevice, &dxgiDevicePtr);
@@ -375,8 +389,6 @@ namespace ouzel
                 graphics::RenderDevice::process();
                 executeAll();
 
-                std::vector<float> shaderData;
-
                 uint32_t fillModeIndex = 0;
                 uint32_t scissorEnableIndex = 0;
                 uint32_t cullModeIndex = 0;
@@ -387,15 +399,11 @@ namespace ouzel
                 std::vector<ID3D11SamplerState*> currentSamplerStates;
 
                 CommandBuffer commandBuffer;
-                std::unique_ptr<Command> command;
+                const Command* command;
 
                 for (;;)
                 {
-                    std::unique_lock<std::mutex> lock(commandQueueMutex);
-                    while (commandQueue.empty()) commandQueueCondition.wait(lock);
-                    commandBuffer = std::move(commandQueue.front());
-                    commandQueue.pop();
-                    lock.unlock();
+                    waitForCommandBuffer(commandBuffer);
 
                     while (!commandBuffer.isEmpty())
                     {
@@ -405,7 +413,7 @@ namespace ouzel
                         {
                             case Command::Type::Resize:
                             {
-                                auto resizeCommand = static_cast<const ResizeCommand*>(command.get());
+                                auto resizeCommand = static_cast<const ResizeCommand*>(command);
                                 resizeBackBuffer(static_cast<UINT>(resizeCommand->size.v[0]),
                                                  static_cast<UINT>(resizeCommand->size.v[1]));
                                 break;
@@ -422,14 +430,14 @@ namespace ouzel
 
                             case Command::Type::DeleteResource:
                             {
-                                auto deleteResourceCommand = static_cast<const DeleteResourceCommand*>(command.get());
+                                auto deleteResourceCommand = static_cast<const DeleteResourceCommand*>(command);
                                 resources[deleteResourceCommand->resource - 1].reset();
                                 break;
                             }
 
                             case Command::Type::InitRenderTarget:
                             {
-                                auto initRenderTargetCommand = static_cast<const InitRenderTargetCommand*>(command.get());
+                                auto initRenderTargetCommand = static_cast<const InitRenderTargetCommand*>(command);
 
                                 std::set<Texture*> colorTextures;
                                 for (const uintptr_t colorTextureId : initRenderTargetCommand->colorTextures)
@@ -447,7 +455,7 @@ namespace ouzel
 
                             case Command::Type::SetRenderTarget:
                             {
-                                auto setRenderTargetCommand = static_cast<const SetRenderTargetCommand*>(command.get());
+                                auto setRenderTargetCommand = static_cast<const SetRenderTargetCommand*>(command);
 
                                 if (currentRenderTarget)
                                     currentRenderTarget->resolve();
@@ -470,7 +478,7 @@ namespace ouzel
 
                             case Command::Type::ClearRenderTarget:
                             {
-                                auto clearCommand = static_cast<const ClearRenderTargetCommand*>(command.get());
+                                auto clearCommand = static_cast<const ClearRenderTargetCommand*>(command);
 
                                 FLOAT frameBufferClearColor[4]{clearCommand->clearColor.normR(),
                                     clearCommand->clearColor.normG(),
@@ -507,7 +515,7 @@ namespace ouzel
 
                             case Command::Type::Blit:
                             {
-                                auto blitCommand = static_cast<const BlitCommand*>(command.get());
+                                auto blitCommand = static_cast<const BlitCommand*>(command);
 
                                 Texture* sourceTexture = getResource<Texture>(blitCommand->sourceTexture);
                                 Texture* destinationTexture = getResource<Texture>(blitCommand->destinationTexture);
@@ -533,7 +541,7 @@ namespace ouzel
 
                             case Command::Type::SetScissorTest:
                             {
-                                auto setScissorTestCommand = static_cast<const SetScissorTestCommand*>(command.get());
+                                auto setScissorTestCommand = static_cast<const SetScissorTestCommand*>(command);
 
                                 if (setScissorTestCommand->enabled)
                                 {
@@ -555,7 +563,7 @@ namespace ouzel
 
                             case Command::Type::SetViewport:
                             {
-                                auto setViewportCommand = static_cast<const SetViewportCommand*>(command.get());
+                                auto setViewportCommand = static_cast<const SetViewportCommand*>(command);
 
                                 D3D11_VIEWPORT viewport;
                                 viewport.MinDepth = 0.0F;
@@ -571,7 +579,7 @@ namespace ouzel
 
                             case Command::Type::InitDepthStencilState:
                             {
-                                auto initDepthStencilStateCommand = static_cast<const InitDepthStencilStateCommand*>(command.get());
+                                auto initDepthStencilStateCommand = static_cast<const InitDepthStencilStateCommand*>(command);
                                 auto depthStencilState = std::make_unique<DepthStencilState>(*this,
                                                                                              initDepthStencilStateCommand->depthTest,
                                                                                              initDepthStencilStateCommand->depthWrite,
@@ -596,7 +604,7 @@ namespace ouzel
 
                             case Command::Type::SetDepthStencilState:
                             {
-                                auto setDepthStencilStateCommand = static_cast<const SetDepthStencilStateCommand*>(command.get());
+                                auto setDepthStencilStateCommand = static_cast<const SetDepthStencilStateCommand*>(command);
 
                                 if (setDepthStencilStateCommand->depthStencilState)
                                 {
@@ -613,7 +621,7 @@ namespace ouzel
 
                             case Command::Type::SetPipelineState:
                             {
-                                auto setPipelineStateCommand = static_cast<const SetPipelineStateCommand*>(command.get());
+                                auto setPipelineStateCommand = static_cast<const SetPipelineStateCommand*>(command);
 
                                 BlendState* blendState = getResource<BlendState>(setPipelineStateCommand->blendState);
                                 Shader* shader = getResource<Shader>(setPipelineStateCommand->shader);
@@ -663,7 +671,7 @@ namespace ouzel
 
                             case Command::Type::Draw:
                             {
-                                auto drawCommand = static_cast<const DrawCommand*>(command.get());
+                                auto drawCommand = static_cast<const DrawCommand*>(command);
 
                                 // draw mesh buffer
                                 Buffer* indexBuffer = getResource<Buffer>(drawCommand->indexBuffer);
@@ -688,6 +696,110 @@ namespace ouzel
 
                                 context->DrawIndexed(drawCommand->indexCount, drawCommand->startIndex, 0);
 
+                                ++currentDrawCallCount;
+
+                                break;
+                            }
+
+                            case Command::Type::DrawInstanced:
+                            {
+                                auto drawInstancedCommand = static_cast<const DrawInstancedCommand*>(command);
+
+                                if (!currentShader)
+                                    throw std::runtime_error("No shader set");
+
+                                // draw mesh buffer
+                                Buffer* indexBuffer = getResource<Buffer>(drawInstancedCommand->indexBuffer);
+                                Buffer* vertexBuffer = getResource<Buffer>(drawInstancedCommand->vertexBuffer);
+
+                                assert(indexBuffer);
+                                assert(indexBuffer->getBuffer());
+                                assert(vertexBuffer);
+                                assert(vertexBuffer->getBuffer());
+
+                                if (drawInstancedCommand->instances.empty()) break;
+
+                                context->IASetIndexBuffer(indexBuffer->getBuffer().get(),
+                                                          getIndexFormat(drawInstancedCommand->indexSize), 0);
+                                context->IASetPrimitiveTopology(getPrimitiveTopology(drawInstancedCommand->drawMode));
+
+                                if (currentShader->getInstancedVertexShader())
+                                {
+                                    uploadInstances(drawInstancedCommand->instances);
+
+                                    ID3D11Buffer* buffers[] = {vertexBuffer->getBuffer().get(), instanceBuffer.get()};
+                                    UINT strides[] = {sizeof(Vertex), sizeof(Instance)};
+                                    UINT offsets[] = {0, 0};
+                                    context->IASetVertexBuffers(0, 2, buffers, strides, offsets);
+
+                                    // the instanced vertex shader multiplies the vertex color with the instance color,
+                                    // so the color constant of the pixel shader is white, the vertex shader constants are not read
+                                    const float white[] = {1.0F, 1.0F, 1.0F, 1.0F};
+                                    setShaderConstants(*currentShader, white, currentShader->getVertexShaderConstants());
+
+                                    context->VSSetShader(currentShader->getInstancedVertexShader().get(), nullptr, 0);
+                                    context->IASetInputLayout(currentShader->getInstancedInputLayout().get());
+
+                                    context->DrawIndexedInstanced(drawInstancedCommand->indexCount,
+                                                                  static_cast<UINT>(drawInstancedCommand->instances.size()),
+                                                                  drawInstancedCommand->startIndex, 0, 0);
+
+                                    ++currentDrawCallCount;
+
+                                    context->VSSetShader(currentShader->getVertexShader().get(), nullptr, 0);
+                                    context->IASetInputLayout(currentShader->getInputLayout().get());
+                                }
+                                else
+                                {
+                                    ID3D11Buffer* buffers[] = {vertexBuffer->getBuffer().get()};
+                                    UINT strides[] = {sizeof(Vertex)};
+                                    UINT offsets[] = {0};
+                                    context->IASetVertexBuffers(0, 1, buffers, strides, offsets);
+
+                                    // shaders without an instanced vertex shader take the transform and the color from
+                                    // the constant buffers, so they are updated for every instance
+                                    for (const Instance& instance : drawInstancedCommand->instances)
+                                    {
+                                        setShaderConstants(*currentShader, instance.color, instance.modelViewProjection);
+
+                                        context->DrawIndexed(drawInstancedCommand->indexCount, drawInstancedCommand->startIndex, 0);
+
+                                        ++currentDrawCallCount;
+                                    }
+                                }
+
+                                break;
+                            }
+
+                            case Command::Type::MultiDraw:
+                            {
+                                auto multiDrawCommand = static_cast<const MultiDrawCommand*>(command);
+
+                                // draw mesh buffer
+                                Buffer* indexBuffer = getResource<Buffer>(multiDrawCommand->indexBuffer);
+                                Buffer* vertexBuffer = getResource<Buffer>(multiDrawCommand->vertexBuffer);
+
+                                assert(indexBuffer);
+                                assert(indexBuffer->getBuffer());
+                                assert(vertexBuffer);
+                                assert(vertexBuffer->getBuffer());
+
+                                ID3D11Buffer* buffers[] = {vertexBuffer->getBuffer().get()};
+                                UINT strides[] = {sizeof(Vertex)};
+                                UINT offsets[] = {0};
+                                context->IASetVertexBuffers(0, 1, buffers, strides, offsets);
+                                context->IASetIndexBuffer(indexBuffer->getBuffer().get(),
+                                                          getIndexFormat(multiDrawCommand->indexSize), 0);
+                                context->IASetPrimitiveTopology(getPrimitiveTopology(multiDrawCommand->drawMode));
+
+                                // Direct3D 11 has no multi-draw, so the ranges are drawn one by one
+                                for (const DrawRange& range : multiDrawCommand->ranges)
+                                {
+                                    context->DrawIndexed(range.indexCount, range.startIndex, 0);
+
+                                    ++currentDrawCallCount;
+                                }
+
                                 break;
                             }
 
@@ -705,7 +817,7 @@ namespace ouzel
 
                             case Command::Type::InitBlendState:
                             {
-                                auto initBlendStateCommand = static_cast<const InitBlendStateCommand*>(command.get());
+                                auto initBlendStateCommand = static_cast<const InitBlendStateCommand*>(command);
 
                                 auto blendState = std::make_unique<BlendState>(*this,
                                                                                initBlendStateCommand->enableBlending,
@@ -725,7 +837,7 @@ namespace ouzel
 
                             case Command::Type::InitBuffer:
                             {
-                                auto initBufferCommand = static_cast<const InitBufferCommand*>(command.get());
+                                auto initBufferCommand = static_cast<const InitBufferCommand*>(command);
 
                                 auto buffer = std::make_unique<Buffer>(*this,
                                                                        initBufferCommand->bufferType,
@@ -741,16 +853,29 @@ namespace ouzel
 
                             case Command::Type::SetBufferData:
                             {
-                                auto setBufferDataCommand = static_cast<const SetBufferDataCommand*>(command.get());
+                                auto setBufferDataCommand = static_cast<const SetBufferDataCommand*>(command);
 
                                 Buffer* buffer = getResource<Buffer>(setBufferDataCommand->buffer);
                                 buffer->setData(setBufferDataCommand->data);
                                 break;
                             }
 
+                            case Command::Type::UploadTransientGeometry:
+                            {
+                                auto uploadTransientGeometryCommand = static_cast<const UploadTransientGeometryCommand*>(command);
+
+                                const TransientBlock& block = commandBuffer.getTransientBlocks()[uploadTransientGeometryCommand->block];
+
+                                Buffer* indexBuffer = getResource<Buffer>(block.indexBuffer);
+                                Buffer* vertexBuffer = getResource<Buffer>(block.vertexBuffer);
+                                indexBuffer->setData(commandBuffer.getTransientIndexData(block));
+                                vertexBuffer->setData(commandBuffer.getTransientVertexData(block));
+                                break;
+                            }
+
                             case Command::Type::InitShader:
                             {
-                                auto initShaderCommand = static_cast<const InitShaderCommand*>(command.get());
+                                auto initShaderCommand = static_cast<const InitShaderCommand*>(command);
 
                                 auto shader = std::make_unique<Shader>(*this,
                                                                        initShaderCommand->fragmentShader,
@@ -761,7 +886,8 @@ namespace ouzel
                                                                        initShaderCommand->fragmentShaderDataAlignment,
                                                                        initShaderCommand->vertexShaderDataAlignment,
                                                                        initShaderCommand->fragmentShaderFunction,
-                                                                       initShaderCommand->vertexShaderFunction);
+                                                                       initShaderCommand->vertexShaderFunction,
+                                                                       initShaderCommand->instancedVertexShader);
 
                                 if (initShaderCommand->shader > resources.size())
                                     resources.resize(initShaderCommand->shader);
@@ -771,69 +897,21 @@ namespace ouzel
 
                             case Command::Type::SetShaderConstants:
                             {
-                                auto setShaderConstantsCommand = static_cast<const SetShaderConstantsCommand*>(command.get());
+                                auto setShaderConstantsCommand = static_cast<const SetShaderConstantsCommand*>(command);
 
                                 if (!currentShader)
                                     throw std::runtime_error("No shader set");
 
-                                // pixel shader constants
-                                const std::vector<Shader::Location>& fragmentShaderConstantLocations = currentShader->getFragmentShaderConstantLocations();
-
-                                if (setShaderConstantsCommand->fragmentShaderConstants.size() > fragmentShaderConstantLocations.size())
-                                    throw std::runtime_error("Invalid pixel shader constant size");
-
-                                shaderData.clear();
-
-                                for (size_t i = 0; i < setShaderConstantsCommand->fragmentShaderConstants.size(); ++i)
-                                {
-                                    const Shader::Location& fragmentShaderConstantLocation = fragmentShaderConstantLocations[i];
-                                    const std::vector<float>& fragmentShaderConstant = setShaderConstantsCommand->fragmentShaderConstants[i];
-
-                                    if (sizeof(float) * fragmentShaderConstant.size() != fragmentShaderConstantLocation.size)
-                                        throw std::runtime_error("Invalid pixel shader constant size");
-
-                                    shaderData.insert(shaderData.end(), fragmentShaderConstant.begin(), fragmentShaderConstant.end());
-                                }
-
-                                uploadBuffer(currentShader->getFragmentShaderConstantBuffer().get(),
-                                             shaderData.data(),
-                                             static_cast<uint32_t>(sizeof(float) * shaderData.size()));
-
-                                ID3D11Buffer* fragmentShaderConstantBuffers[1] = {currentShader->getFragmentShaderConstantBuffer().get()};
-                                context->PSSetConstantBuffers(0, 1, fragmentShaderConstantBuffers);
-
-                                // vertex shader constants
-                                const std::vector<Shader::Location>& vertexShaderConstantLocations = currentShader->getVertexShaderConstantLocations();
-
-                                if (setShaderConstantsCommand->vertexShaderConstants.size() > vertexShaderConstantLocations.size())
-                                    throw std::runtime_error("Invalid vertex shader constant size");
-
-                                shaderData.clear();
-
-                                for (size_t i = 0; i < setShaderConstantsCommand->vertexShaderConstants.size(); ++i)
-                                {
-                                    const Shader::Location& vertexShaderConstantLocation = vertexShaderConstantLocations[i];
-                                    const std::vector<float>& vertexShaderConstant = setShaderConstantsCommand->vertexShaderConstants[i];
-
-                                    if (sizeof(float) * vertexShaderConstant.size() != vertexShaderConstantLocation.size)
-                                        throw std::runtime_error("Invalid vertex shader constant size");
-
-                                    shaderData.insert(shaderData.end(), vertexShaderConstant.begin(), vertexShaderConstant.end());
-                                }
-
-                                uploadBuffer(currentShader->getVertexShaderConstantBuffer().get(),
-                                             shaderData.data(),
-                                             static_cast<uint32_t>(sizeof(float) * shaderData.size()));
-
-                                ID3D11Buffer* vertexShaderConstantBuffers[1] = {currentShader->getVertexShaderConstantBuffer().get()};
-                                context->VSSetConstantBuffers(0, 1, vertexShaderConstantBuffers);
+                                setShaderConstants(*currentShader,
+                                                   commandBuffer.getConstants(setShaderConstantsCommand->fragmentShaderConstants),
+                                                   commandBuffer.getConstants(setShaderConstantsCommand->vertexShaderConstants));
 
                                 break;
                             }
 
                             case Command::Type::InitTexture:
                             {
-                                auto initTextureCommand = static_cast<const InitTextureCommand*>(command.get());
+                                auto initTextureCommand = static_cast<const InitTextureCommand*>(command);
 
                                 auto texture = std::make_unique<Texture>(*this,
                                                                          initTextureCommand->levels,
@@ -850,7 +928,7 @@ namespace ouzel
 
                             case Command::Type::SetTextureData:
                             {
-                                auto setTextureDataCommand = static_cast<const SetTextureDataCommand*>(command.get());
+                                auto setTextureDataCommand = static_cast<const SetTextureDataCommand*>(command);
 
                                 Texture* texture = getResource<Texture>(setTextureDataCommand->texture);
                                 texture->setData(setTextureDataCommand->levels);
@@ -858,9 +936,22 @@ namespace ouzel
                                 break;
                             }
 
+                            case Command::Type::SetTextureRegion:
+                            {
+                                auto setTextureRegionCommand = static_cast<const SetTextureRegionCommand*>(command);
+
+                                Texture* texture = getResource<Texture>(setTextureRegionCommand->texture);
+                                texture->setRegionData(setTextureRegionCommand->x,
+                                                       setTextureRegionCommand->y,
+                                                       setTextureRegionCommand->size,
+                                                       setTextureRegionCommand->data);
+
+                                break;
+                            }
+
                             case Command::Type::SetTextureParameters:
                             {
-                                auto setTextureParametersCommand = static_cast<const SetTextureParametersCommand*>(command.get());
+                                auto setTextureParametersCommand = static_cast<const SetTextureParametersCommand*>(command);
 
                                 Texture* texture = getResource<Texture>(setTextureParametersCommand->texture);
                                 texture->setFilter((setTextureParametersCommand->filter == SamplerFilter::Default) ? textureFilter : setTextureParametersCommand->filter);
@@ -874,7 +965,7 @@ namespace ouzel
 
                             case Command::Type::SetTextures:
                             {
-                                auto setTexturesCommand = static_cast<const SetTexturesCommand*>(command.get());
+                                auto setTexturesCommand = static_cast<const SetTexturesCommand*>(command);
 
                                 currentResourceViews.clear();
                                 currentSamplerStates.clear();
@@ -901,7 +992,11 @@ namespace ouzel
                                 throw std::runtime_error("Invalid command");
                         }
 
-                        if (command->type == Command::Type::Present) return;
+                        if (command->type == Command::Type::Present)
+                        {
+                            finishCommandBuffer(commandBuffer);
+                            return;
+                        }
                     }
                 }
             }
@@ -1092,6 +1187,67 @@ namespace ouzel
                 }
             }
 
+            void RenderDevice::setShaderConstants(Shader& shader,
+                                                  Span<const float> fragmentShaderConstants,
+                                                  Span<const float> vertexShaderConstants)
+            {
+                // pixel shader constants
+                const std::vector<Shader::Location>& fragmentShaderConstantLocations = shader.getFragmentShaderConstantLocations();
+                const uint32_t fragmentShaderConstantSize = static_cast<uint32_t>(sizeof(float) * fragmentShaderConstants.size());
+
+                // the constants are packed in the order of the locations, so they must end at the end of one
+                if (fragmentShaderConstantSize &&
+                    std::none_of(fragmentShaderConstantLocations.begin(), fragmentShaderConstantLocations.end(),
+                                 [fragmentShaderConstantSize](const Shader::Location& location) {
+                                     return location.offset + location.size == fragmentShaderConstantSize;
+                                 }))
+                    throw std::runtime_error("Invalid pixel shader constant size");
+
+                std::vector<float>& currentFragmentShaderConstants = shader.getFragmentShaderConstants();
+
+                // the constant buffer is updated only when its contents change
+                if (currentFragmentShaderConstants.size() != fragmentShaderConstants.size() ||
+                    (fragmentShaderConstantSize && std::memcmp(currentFragmentShaderConstants.data(), fragmentShaderConstants.data(), fragmentShaderConstantSize) != 0))
+                {
+                    uploadBuffer(shader.getFragmentShaderConstantBuffer().get(),
+                                 fragmentShaderConstants.data(),
+                                 fragmentShaderConstantSize);
+
+                    currentFragmentShaderConstants.assign(fragmentShaderConstants.begin(), fragmentShaderConstants.end());
+                }
+
+                ID3D11Buffer* fragmentShaderConstantBuffers[1] = {shader.getFragmentShaderConstantBuffer().get()};
+                context->PSSetConstantBuffers(0, 1, fragmentShaderConstantBuffers);
+
+                // vertex shader constants
+                const std::vector<Shader::Location>& vertexShaderConstantLocations = shader.getVertexShaderConstantLocations();
+                const uint32_t vertexShaderConstantSize = static_cast<uint32_t>(sizeof(float) * vertexShaderConstants.size());
+
+                // the constants are packed in the order of the locations, so they must end at the end of one
+                if (vertexShaderConstantSize &&
+                    std::none_of(vertexShaderConstantLocations.begin(), vertexShaderConstantLocations.end(),
+                                 [vertexShaderConstantSize](const Shader::Location& location) {
+                                     return location.offset + location.size == vertexShaderConstantSize;
+                                 }))
+                    throw std::runtime_error("Invalid vertex shader constant size");
+
+                std::vector<float>& currentVertexShaderConstants = shader.getVertexShaderConstants();
+
+                // the constant buffer is updated only when its contents change
+                if (currentVertexShaderConstants.size() != vertexShaderConstants.size() ||
+                    (vertexShaderConstantSize && std::memcmp(currentVertexShaderConstants.data(), vertexShaderConstants.data(), vertexShaderConstantSize) != 0))
+                {
+                    uploadBuffer(shader.getVertexShaderConstantBuffer().get(),
+                                 vertexShaderConstants.data(),
+                                 vertexShaderConstantSize);
+
+                    currentVertexShaderConstants.assign(vertexShaderConstants.begin(), vertexShaderConstants.end());
+                }
+
+                ID3D11Buffer* vertexShaderConstantBuffers[1] = {shader.getVertexShaderConstantBuffer().get()};
+                context->VSSetConstantBuffers(0, 1, vertexShaderConstantBuffers);
+            }
+
             void RenderDevice::uploadBuffer(ID3D11Buffer* buffer, const void* data, uint32_t dataSize)
             {
                 D3D11_MAPPED_SUBRESOURCE mappedSubresource;
@@ -1104,6 +1260,34 @@ namespace ouzel
                 context->Unmap(buffer, 0);
             }
 
+            void RenderDevice::uploadInstances(Span<const Instance> instances)
+            {
+                const auto dataSize = static_cast<UINT>(instances.size() * sizeof(Instance));
+
+                if (instanceBufferSize < dataSize)
+                {
+                    instanceBufferSize = std::max(dataSize, instanceBufferSize * 2);
+
+                    D3D11_BUFFER_DESC instanceBufferDesc;
+                    instanceBufferDesc.ByteWidth = instanceBufferSize;
+                    instanceBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+                    instanceBufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+                    instanceBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+                    instanceBufferDesc.MiscFlags = 0;
+                    instanceBufferDesc.StructureByteStride = 0;
+
+                    ID3D11Buffer* newInstanceBuffer;
+
+                    HRESULT hr;
+                    if (FAILED(hr = device->CreateBuffer(&instanceBufferDesc, nullptr, &newInstanceBuffer)))
+                        throw std::system_error(hr, errorCategory, "Failed to create Direct3D 11 instance buffer");
+
+                    instanceBuffer = newInstanceBuffer;
+                }
+
+                uploadBuffer(instanceBuffer.get(), instances.data(), dataSize);
+            }
+
             ID3D11SamplerState* RenderDevice::getSamplerState(const SamplerStateDesc& desc)
             {
                 auto samplerStatesIterator = samplerStates.find(desc);
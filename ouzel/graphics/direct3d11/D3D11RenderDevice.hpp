@@ -23,6 +23,7 @@
 #  define NOMINMAX
 #endif
 #include <d3d11.h>
+#include <d3dcompiler.h>
 #pragma pop_macro("WIN32_LEAN_AND_MEAN")
 #pragma pop_macro("NOMINMAX")
 
@@ -39,6 +40,8 @@ namespace ouzel
         {
             const std::error_category& getErrorCategory() noexcept;
 
+            class Shader;
+
             class RenderDevice final: public graphics::RenderDevice
             {
                 friend Renderer;
@@ -51,6 +54,10 @@ namespace ouzel
                 inline auto& getDevice() const noexcept { return device; }
                 inline auto& getContext() const noexcept { return context; }
 
+                inline auto isInstancingSupported() const noexcept { return instancingSupported; }
+                // D3DCompile of the shader compiler library, null if the library is not available
+                inline auto getCompileProc() const noexcept { return compileProc; }
+
                 ID3D11SamplerState* getSamplerState(const SamplerStateDesc& desc);
                 void setFullscreen(bool newFullscreen);
 
@@ -75,6 +82,10 @@ namespace ouzel
                 void process() final;
                 void resizeBackBuffer(UINT newWidth, UINT newHeight);
                 void uploadBuffer(ID3D11Buffer* buffer, const void* data, uint32_t dataSize);
+                void uploadInstances(Span<const Instance> instances);
+                void setShaderConstants(Shader& shader,
+                                        Span<const float> fragmentShaderConstants,
+                                        Span<const float> vertexShaderConstants);
                 void generateScreenshot(const std::string& filename) final;
                 void renderMain();
 
@@ -92,6 +103,14 @@ namespace ouzel
                 Pointer<ID3D11DepthStencilView> depthStencilView;
                 Pointer<ID3D11DepthStencilState> defaultDepthStencilState;
 
+                bool instancingSupported = false;
+                HMODULE compilerModule = nullptr;
+                pD3DCompile compileProc = nullptr;
+
+                // per-instance vertex stream of the instanced draw calls
+                Pointer<ID3D11Buffer> instanceBuffer;
+                UINT instanceBufferSize = 0;
+
                 UINT frameBufferWidth = 0;
                 UINT frameBufferHeight = 0;
 
@@ -4,6 +4,7 @@
 
 #if OUZEL_COMPILE_DIRECT3D11
 
+#include <cstddef>
 #include <stdexcept>
 #include "D3D11Shader.hpp"
 #include "D3D11RenderDevice.hpp"
@@ -85,20 +86,25 @@ namespace ouzel
             }
 
             Shader::Shader(RenderDevice& initRenderDevice,
-                           const std::vector<uint8_t>& fragmentShaderData,
-                           const std::vector<uint8_t>& vertexShaderData,
-                           const std::set<Vertex::Attribute::Usage>& initVertexAttributes,
-                           const std::vector<std::pair<std::string, DataType>>& initFragmentShaderConstantInfo,
-                           const std::vector<std::pair<std::string, DataType>>& initVertexShaderConstantInfo,
+                           Span<const uint8_t> fragmentShaderData,
+                           Span<const uint8_t> vertexShaderData,
+                           Span<const Vertex::Attribute::Usage> initVertexAttributes,
+                           Span<const ShaderConstantInfo> initFragmentShaderConstantInfo,
+                           Span<const ShaderConstantInfo> initVertexShaderConstantInfo,
                            uint32_t,
                            uint32_t,
-                           const std::string&,
-                           const std::string&):
+                           const char*,
+                           const char*,
+                           Span<const uint8_t> instancedVertexShaderSource):
                 RenderResource(initRenderDevice),
-                vertexAttributes(initVertexAttributes),
-                fragmentShaderConstantInfo(initFragmentShaderConstantInfo),
-                vertexShaderConstantInfo(initVertexShaderConstantInfo)
+                vertexAttributes(initVertexAttributes.begin(), initVertexAttributes.end())
             {
+                for (const ShaderConstantInfo& info : initFragmentShaderConstantInfo)
+                    fragmentShaderConstantInfo.emplace_back(info.name, info.dataType);
+
+                for (const ShaderConstantInfo& info : initVertexShaderConstantInfo)
+                    vertexShaderConstantInfo.emplace_back(info.name, info.dataType);
+
 				ID3D11PixelShader* newPixelShader;
 
                 HRESULT hr;
@@ -191,6 +197,70 @@ namespace ouzel
 
 				inputLayout = newInputLayout;
 
+                if (renderDevice.isInstancingSupported() &&
+                    renderDevice.getCompileProc() &&
+                    !instancedVertexShaderSource.empty())
+                {
+                    ID3DBlob* newInstancedVertexShaderBlob;
+                    ID3DBlob* newErrorBlob = nullptr;
+
+                    hr = renderDevice.getCompileProc()(instancedVertexShaderSource.data(),
+                                                       instancedVertexShaderSource.size(),
+                                                       nullptr, nullptr, nullptr,
+                                                       "main", "vs_4_0_level_9_3",
+                                                       D3DCOMPILE_OPTIMIZATION_LEVEL3, 0,
+                                                       &newInstancedVertexShaderBlob, &newErrorBlob);
+
+                    Pointer<ID3DBlob> errorBlob = newErrorBlob;
+
+                    if (FAILED(hr))
+                    {
+                        std::string message = "Failed to compile the Direct3D 11 instanced vertex shader";
+                        if (errorBlob)
+                            message += ": " + std::string(static_cast<const char*>(errorBlob->GetBufferPointer()),
+                                                          errorBlob->GetBufferSize());
+                        throw std::system_error(hr, getErrorCategory(), message);
+                    }
+
+                    Pointer<ID3DBlob> instancedVertexShaderBlob = newInstancedVertexShaderBlob;
+
+                    ID3D11VertexShader* newInstancedVertexShader;
+
+                    if (FAILED(hr = renderDevice.getDevice()->CreateVertexShader(instancedVertexShaderBlob->GetBufferPointer(),
+                                                                                 instancedVertexShaderBlob->GetBufferSize(),
+                                                                                 nullptr, &newInstancedVertexShader)))
+                        throw std::system_error(hr, getErrorCategory(), "Failed to create a Direct3D 11 vertex shader");
+
+                    instancedVertexShader = newInstancedVertexShader;
+
+                    // the instance stream is bound to the second input slot, one element per instance
+                    for (UINT column = 0; column < 4; ++column)
+                        vertexInputElements.push_back({
+                            "INSTANCE_TRANSFORM", column,
+                            DXGI_FORMAT_R32G32B32A32_FLOAT,
+                            1, static_cast<UINT>(offsetof(Instance, modelViewProjection) + column * 4 * sizeof(float)),
+                            D3D11_INPUT_PER_INSTANCE_DATA, 1
+                        });
+
+                    vertexInputElements.push_back({
+                        "INSTANCE_COLOR", 0,
+                        DXGI_FORMAT_R32G32B32A32_FLOAT,
+                        1, static_cast<UINT>(offsetof(Instance, color)),
+                        D3D11_INPUT_PER_INSTANCE_DATA, 1
+                    });
+
+                    ID3D11InputLayout* newInstancedInputLayout;
+
+                    if (FAILED(hr = renderDevice.getDevice()->CreateInputLayout(vertexInputElements.data(),
+                                                                                static_cast<UINT>(vertexInputElements.size()),
+                                                                                instancedVertexShaderBlob->GetBufferPointer(),
+                                                                                instancedVertexShaderBlob->GetBufferSize(),
+                                                                                &newInstancedInputLayout)))
+                        throw std::system_error(hr, getErrorCategory(), "Failed to create Direct3D 11 input layout for vertex shader");
+
+                    instancedInputLayout = newInstancedInputLayout;
+                }
+
                 if (!fragmentShaderConstantInfo.empty())
                 {
                     fragmentShaderConstantLocations.reserve(fragmentShaderConstantInfo.size());
@@ -24,6 +24,7 @@
 
 #include "graphics/direct3d11/D3D11RenderResource.hpp"
 #include "graphics/direct3d11/D3D11Pointer.hpp"
+#include "graphics/Commands.hpp"
 #include "graphics/DataType.hpp"
 #include "graphics/Vertex.hpp"
 
@@ -39,15 +40,16 @@ namespace ouzel
             {
             public:
                 Shader(RenderDevice& initRenderDevice,
-                       const std::vector<uint8_t>& fragmentShaderData,
-                       const std::vector<uint8_t>& vertexShaderData,
-                       const std::set<Vertex::Attribute::Usage>& initVertexAttributes,
-                       const std::vector<std::pair<std::string, DataType>>& initFragmentShaderConstantInfo,
-                       const std::vector<std::pair<std::string, DataType>>& initVertexShaderConstantInfo,
+                       Span<const uint8_t> fragmentShaderData,
+                       Span<const uint8_t> vertexShaderData,
+                       Span<const Vertex::Attribute::Usage> initVertexAttributes,
+                       Span<const ShaderConstantInfo> initFragmentShaderConstantInfo,
+                       Span<const ShaderConstantInfo> initVertexShaderConstantInfo,
                        uint32_t,
                        uint32_t,
-                       const std::string& fragmentShaderFunction,
-                       const std::string& vertexShaderFunction);
+                       const char* fragmentShaderFunction,
+                       const char* vertexShaderFunction,
+                       Span<const uint8_t> instancedVertexShaderSource);
 
                 struct Location final
                 {
@@ -72,6 +74,14 @@ namespace ouzel
                 inline auto& getVertexShaderConstantBuffer() const noexcept { return vertexShaderConstantBuffer; }
                 inline auto& getInputLayout() const noexcept { return inputLayout; }
 
+                // vertex shader that reads the transform and the color from the per-instance stream, null if the shader has none
+                inline auto& getInstancedVertexShader() const noexcept { return instancedVertexShader; }
+                inline auto& getInstancedInputLayout() const noexcept { return instancedInputLayout; }
+
+                // contents of the constant buffers after the last update
+                inline auto& getFragmentShaderConstants() noexcept { return fragmentShaderConstants; }
+                inline auto& getVertexShaderConstants() noexcept { return vertexShaderConstants; }
+
             private:
                 std::set<Vertex::Attribute::Usage> vertexAttributes;
 
@@ -81,6 +91,8 @@ namespace ouzel
 				Pointer<ID3D11PixelShader> fragmentShader;
 				Pointer<ID3D11VertexShader> vertexShader;
 				Pointer<ID3D11InputLayout> inputLayout;
+                Pointer<ID3D11VertexShader> instancedVertexShader;
+                Pointer<ID3D11InputLayout> instancedInputLayout;
 
 				Pointer<ID3D11Buffer> fragmentShaderConstantBuffer;
 				Pointer<ID3D11Buffer> vertexShaderConstantBuffer;
@@ -89,6 +101,9 @@ namespace ouzel
                 uint32_t fragmentShaderConstantSize = 0;
                 std::vector<Location> vertexShaderConstantLocations;
                 uint32_t vertexShaderConstantSize = 0;
+
+                std::vector<float> fragmentShaderConstants;
+                std::vector<float> vertexShaderConstants;
             };
         } // namespace d3d11
     } // namespace graphics
@@ -4,6 +4,7 @@
 
 #if OUZEL_COMPILE_DIRECT3D11
 
+#include <algorithm>
 #include <stdexcept>
 #include "D3D11Texture.hpp"
 #include "D3D11RenderDevice.hpp"
@@ -95,7 +96,7 @@ namespace ouzel
             }
 
             Texture::Texture(RenderDevice& initRenderDevice,
-                             const std::vector<std::pair<Size2U, std::vector<uint8_t>>>& levels,
+                             Span<const TextureLevel> levels,
                              TextureType type,
                              uint32_t initFlags,
                              uint32_t initSampleCount,
@@ -130,8 +131,8 @@ namespace ouzel
                     }
                 }
 
-                width = static_cast<UINT>(levels.front().first.v[0]);
-                height = static_cast<UINT>(levels.front().first.v[1]);
+                width = static_cast<UINT>(levels[0].size.v[0]);
+                height = static_cast<UINT>(levels[0].size.v[1]);
 
                 if (!width || !height)
                     throw std::runtime_error("Invalid texture size");
@@ -181,8 +182,8 @@ namespace ouzel
 
                     for (size_t level = 0; level < levels.size(); ++level)
                     {
-                        subresourceData[level].pSysMem = levels[level].second.data();
-                        subresourceData[level].SysMemPitch = static_cast<UINT>(levels[level].first.v[0] * pixelSize);
+                        subresourceData[level].pSysMem = levels[level].data.data();
+                        subresourceData[level].SysMemPitch = static_cast<UINT>(levels[level].size.v[0] * pixelSize);
                         subresourceData[level].SysMemSlicePitch = 0;
                     }
 
@@ -195,6 +196,10 @@ namespace ouzel
 					texture = newTexture;
                 }
 
+                if (flags & Flags::Dynamic && !(flags & Flags::BindRenderTarget) &&
+                    mipmaps == 1 && !levels.empty())
+                    data.assign(levels[0].data.begin(), levels[0].data.end());
+
                 if (flags & Flags::BindRenderTarget)
                 {
                     if (sampleCount > 1)
@@ -333,54 +338,82 @@ namespace ouzel
                 updateSamplerState();
             }
 
-            void Texture::setData(const std::vector<std::pair<Size2U, std::vector<uint8_t>>>& levels)
+            void Texture::setData(Span<const TextureLevel> levels)
             {
                 if (!(flags & Flags::Dynamic) || flags & Flags::BindRenderTarget)
                     throw std::runtime_error("Texture is not dynamic");
 
+                if (mipmaps == 1 && !levels.empty())
+                    data.assign(levels[0].data.begin(), levels[0].data.end());
+
                 for (size_t level = 0; level < levels.size(); ++level)
                 {
-                    if (!levels[level].second.empty())
-                    {
-                        D3D11_MAPPED_SUBRESOURCE mappedSubresource;
-                        mappedSubresource.pData = nullptr;
-                        mappedSubresource.RowPitch = 0;
-                        mappedSubresource.DepthPitch = 0;
+                    if (!levels[level].data.empty())
+                        uploadLevel(static_cast<UINT>(level), levels[level].size, levels[level].data);
+                }
+            }
 
-                        HRESULT hr;
-                        if (FAILED(hr = renderDevice.getContext()->Map(texture.get(), static_cast<UINT>(level),
-                                                                       (level == 0) ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE,
-                                                                       0, &mappedSubresource)))
-                            throw std::system_error(hr, getErrorCategory(), "Failed to map Direct3D 11 texture");
+            void Texture::setRegionData(uint32_t x, uint32_t y, const Size2U& regionSize, Span<const uint8_t> regionData)
+            {
+                if (!(flags & Flags::Dynamic) || flags & Flags::BindRenderTarget)
+                    throw std::runtime_error("Texture is not dynamic");
 
-                        uint8_t* destination = static_cast<uint8_t*>(mappedSubresource.pData);
+                if (mipmaps != 1)
+                    throw std::runtime_error("Texture has mip maps");
 
-                        if (mappedSubresource.RowPitch == levels[level].first.v[0] * pixelSize)
-                        {
-                            std::copy(levels[level].second.begin(),
-                                      levels[level].second.end(),
-                                      destination);
-                        }
-                        else
-                        {
-                            auto source = levels[level].second.begin();
-                            auto rowSize = static_cast<uint32_t>(levels[level].first.v[0]) * pixelSize;
-                            auto rows = static_cast<UINT>(levels[level].first.v[1]);
-
-                            for (UINT row = 0; row < rows; ++row)
-                            {
-                                std::copy(source,
-                                          source + rowSize,
-                                          destination);
-
-                                source += levels[level].first.v[0] * pixelSize;
-                                destination += mappedSubresource.RowPitch;
-                            }
-                        }
+                if (data.size() != width * height * pixelSize)
+                    data.resize(width * height * pixelSize);
+
+                const uint32_t rowSize = regionSize.v[0] * pixelSize;
+                const uint32_t pitch = width * pixelSize;
 
-                        renderDevice.getContext()->Unmap(texture.get(), static_cast<UINT>(level));
+                for (uint32_t row = 0; row < regionSize.v[1]; ++row)
+                    std::copy(regionData.begin() + row * rowSize,
+                              regionData.begin() + (row + 1) * rowSize,
+                              data.begin() + (y + row) * pitch + x * pixelSize);
+
+                uploadLevel(0, Size2U(width, height), data);
+            }
+
+            void Texture::uploadLevel(UINT level, const Size2U& levelSize, Span<const uint8_t> levelData)
+            {
+                D3D11_MAPPED_SUBRESOURCE mappedSubresource;
+                mappedSubresource.pData = nullptr;
+                mappedSubresource.RowPitch = 0;
+                mappedSubresource.DepthPitch = 0;
+
+                HRESULT hr;
+                if (FAILED(hr = renderDevice.getContext()->Map(texture.get(), level,
+                                                               (level == 0) ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE,
+                                                               0, &mappedSubresource)))
+                    throw std::system_error(hr, getErrorCategory(), "Failed to map Direct3D 11 texture");
+
+                uint8_t* destination = static_cast<uint8_t*>(mappedSubresource.pData);
+
+                if (mappedSubresource.RowPitch == levelSize.v[0] * pixelSize)
+                {
+                    std::copy(levelData.begin(),
+                              levelData.end(),
+                              destination);
+                }
+                else
+                {
+                    auto source = levelData.begin();
+                    auto rowSize = static_cast<uint32_t>(levelSize.v[0]) * pixelSize;
+                    auto rows = static_cast<UINT>(levelSize.v[1]);
+
+                    for (UINT row = 0; row < rows; ++row)
+                    {
+                        std::copy(source,
+                                  source + rowSize,
+                                  destination);
+
+                        source += levelSize.v[0] * pixelSize;
+                        destination += mappedSubresource.RowPitch;
                     }
                 }
+
+                renderDevice.getContext()->Unmap(texture.get(), level);
             }
 
             void Texture::setFilter(SamplerFilter filter)
@@ -24,6 +24,7 @@
 
 #include "graphics/direct3d11/D3D11RenderResource.hpp"
 #include "graphics/direct3d11/D3D11Pointer.hpp"
+#include "graphics/Commands.hpp"
 #include "graphics/PixelFormat.hpp"
 #include "graphics/SamplerAddressMode.hpp"
 #include "graphics/SamplerFilter.hpp"
@@ -57,13 +58,14 @@ namespace ouzel
             {
             public:
                 Texture(RenderDevice& initRenderDevice,
-                        const std::vector<std::pair<Size2U, std::vector<uint8_t>>>& levels,
+                        Span<const TextureLevel> levels,
                         TextureType type,
                         uint32_t initFlags = 0,
                         uint32_t initSampleCount = 1,
                         PixelFormat initPixelFormat = PixelFormat::RGBA8UNorm);
 
-                void setData(const std::vector<std::pair<Size2U, std::vector<uint8_t>>>& levels);
+                void setData(Span<const TextureLevel> levels);
+                void setRegionData(uint32_t x, uint32_t y, const Size2U& regionSize, Span<const uint8_t> regionData);
                 void setFilter(SamplerFilter filter);
                 void setAddressX(SamplerAddressMode addressX);
                 void setAddressY(SamplerAddressMode addressY);
@@ -89,6 +91,7 @@ namespace ouzel
 
             private:
                 void updateSamplerState();
+                void uploadLevel(UINT level, const Size2U& levelSize, Span<const uint8_t> levelData);
 
                 uint32_t flags = 0;
                 uint32_t mipmaps = 0;
@@ -97,6 +100,9 @@ namespace ouzel
                 uint32_t pixelSize = 0;
                 SamplerStateDesc samplerDescriptor;
 
+                // dynamic textures can only be mapped with discard, so a copy of the data is kept for region updates
+                std::vector<uint8_t> data;
+
                 Pointer<ID3D11Texture2D> texture;
 				Pointer<ID3D11Texture2D> msaaTexture;
 				Pointer<ID3D11ShaderResourceView> resourceView;
@@ -0,0 +1,127 @@
+// Copyright 2015-2019 Elviss Strazdins. All rights reserved.
+
+#include "EmptyRenderDevice.hpp"
+#include "core/Engine.hpp"
+#include "utils/Log.hpp"
+
+namespace ouzel
+{
+    namespace graphics
+    {
+        namespace empty
+        {
+            RenderDevice::RenderDevice(const std::function<void(const Event&)>& initCallback):
+                graphics::RenderDevice(Driver::Empty, initCallback)
+            {
+            }
+
+            RenderDevice::~RenderDevice()
+            {
+                running = false;
+                CommandBuffer commandBuffer;
+                commandBuffer.pushCommand<PresentCommand>();
+                submitCommandBuffer(std::move(commandBuffer));
+
+                if (renderThread.isJoinable()) renderThread.join();
+            }
+
+            void RenderDevice::init(Window* newWindow,
+                                    const Size2U& newSize,
+                                    uint32_t newSampleCount,
+                                    SamplerFilter newTextureFilter,
+                                    uint32_t newMaxAnisotropy,
+                                    bool newSrgb,
+                                    bool newVerticalSync,
+                                    bool newDepth,
+                                    bool newStencil,
+                                    bool newDebugRenderer)
+            {
+                graphics::RenderDevice::init(newWindow,
+                                             newSize,
+                                             newSampleCount,
+                                             newTextureFilter,
+                                             newMaxAnisotropy,
+                                             newSrgb,
+                                             newVerticalSync,
+                                             newDepth,
+                                             newStencil,
+                                             newDebugRenderer);
+
+#if !defined(__EMSCRIPTEN__)
+                running = true;
+                renderThread = Thread(&RenderDevice::renderMain, this);
+#endif
+            }
+
+            void RenderDevice::renderMain()
+            {
+                Thread::setCurrentThreadName("Render");
+
+                while (running)
+                {
+                    try
+                    {
+                        process();
+                    }
+                    catch (const std::exception& e)
+                    {
+                        engine->log(Log::Level::Error) << e.what();
+                    }
+                }
+            }
+
+            void RenderDevice::process()
+            {
+                graphics::RenderDevice::process();
+                executeAll();
+
+                CommandBuffer commandBuffer;
+                const Command* command;
+
+                for (;;)
+                {
+                    waitForCommandBuffer(commandBuffer);
+
+                    while (!commandBuffer.isEmpty())
+                    {
+                        command = commandBuffer.popCommand();
+
+                        switch (command->type)
+                        {
+                            case Command::Type::Draw:
+                            {
+                                ++currentDrawCallCount;
+                                break;
+                            }
+
+                            case Command::Type::DrawInstanced:
+                            {
+                                // there is no instancing, every instance would be drawn separately
+                                auto drawInstancedCommand = static_cast<const DrawInstancedCommand*>(command);
+                                currentDrawCallCount += static_cast<uint32_t>(drawInstancedCommand->instances.size());
+                                break;
+                            }
+
+                            case Command::Type::MultiDraw:
+                            {
+                                // there is no multi-draw, every range would be drawn separately
+                                auto multiDrawCommand = static_cast<const MultiDrawCommand*>(command);
+                                currentDrawCallCount += static_cast<uint32_t>(multiDrawCommand->ranges.size());
+                                break;
+                            }
+
+                            default:
+                                break;
+                        }
+
+                        if (command->type == Command::Type::Present)
+                        {
+                            finishCommandBuffer(commandBuffer);
+                            return;
+                        }
+                    }
+                }
+            }
+        } // namespace empty
+    } // namespace graphics
+} // namespace ouzel
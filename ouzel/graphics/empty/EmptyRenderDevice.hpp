@@ -3,7 +3,9 @@
 #ifndef OUZEL_GRAPHICS_EMPTYRENDERDEVICE_HPP
 #define OUZEL_GRAPHICS_EMPTYRENDERDEVICE_HPP
 
+#include <atomic>
 #include "graphics/RenderDevice.hpp"
+#include "utils/Thread.hpp"
 
 namespace ouzel
 {
@@ -11,16 +13,30 @@ namespace ouzel
     {
         namespace empty
         {
+            // Consumes the command buffers without rendering, the draw calls are counted as if they were emulated
             class RenderDevice final: public graphics::RenderDevice
             {
             public:
-                explicit RenderDevice(const std::function<void(const Event&)>& initCallback):
-                    graphics::RenderDevice(Driver::Empty, initCallback)
-                {
-                }
+                explicit RenderDevice(const std::function<void(const Event&)>& initCallback);
+                ~RenderDevice();
 
             private:
-                void process() final {}
+                void init(Window* newWindow,
+                          const Size2U& newSize,
+                          uint32_t newSampleCount,
+                          SamplerFilter newTextureFilter,
+                          uint32_t newMaxAnisotropy,
+                          bool newSrgb,
+                          bool newVerticalSync,
+                          bool newDepth,
+                          bool newStencil,
+                          bool newDebugRenderer) final;
+
+                void process() final;
+                void renderMain();
+
+                std::atomic_bool running{false};
+                Thread renderThread;
             };
         } // namespace empty
     } // namespace graphics
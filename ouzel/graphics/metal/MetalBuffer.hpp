@@ -18,6 +18,7 @@ typedef id MTLBufferPtr;
 #include "graphics/metal/MetalRenderResource.hpp"
 #include "graphics/metal/MetalPointer.hpp"
 #include "graphics/BufferType.hpp"
+#include "utils/Span.hpp"
 
 namespace ouzel
 {
@@ -33,10 +34,10 @@ namespace ouzel
                 Buffer(RenderDevice& initRenderDevice,
                        BufferType initType,
                        uint32_t initFlags,
-                       const std::vector<uint8_t>& initData,
+                       Span<const uint8_t> initData,
                        uint32_t initSize);
 
-                void setData(const std::vector<uint8_t>& data);
+                void setData(Span<const uint8_t> data);
 
                 inline auto getFlags() const noexcept { return flags; }
                 inline auto getType() const noexcept { return type; }
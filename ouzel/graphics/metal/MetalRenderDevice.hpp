@@ -22,6 +22,7 @@ typedef id<MTLBuffer> MTLBufferPtr;
 typedef MTLRenderPassDescriptor* MTLRenderPassDescriptorPtr;
 typedef id<MTLSamplerState> MTLSamplerStatePtr;
 typedef id<MTLCommandQueue> MTLCommandQueuePtr;
+typedef id<MTLRenderCommandEncoder> MTLRenderCommandEncoderPtr;
 typedef id<MTLRenderPipelineState> MTLRenderPipelineStatePtr;
 typedef id<MTLTexture> MTLTexturePtr;
 typedef id<MTLDepthStencilState> MTLDepthStencilStatePtr;
@@ -63,6 +64,8 @@ namespace ouzel
             public:
                 static constexpr size_t BUFFER_SIZE = 1024 * 1024; // size of shader constant buffer
                 static constexpr size_t BUFFER_COUNT = 3; // allow encoding up to 3 command buffers simultaneously
+                static constexpr NSUInteger INSTANCE_BUFFER_INDEX = 2; // vertex buffer index of the per-instance stream
+                static constexpr NSUInteger INSTANCE_ATTRIBUTE_INDEX = 5; // first per-instance attribute, after the vertex attributes
 
                 static bool available();
 
@@ -102,11 +105,12 @@ namespace ouzel
                     std::vector<MTLPixelFormat> colorFormats;
                     MTLPixelFormat depthFormat;
                     MTLPixelFormat stencilFormat;
+                    bool instanced = false;
 
                     bool operator<(const PipelineStateDesc& other) const noexcept
                     {
-                        return std::tie(blendState, shader, sampleCount, colorFormats, depthFormat) <
-                            std::tie(other.blendState, other.shader, other.sampleCount, colorFormats, other.depthFormat);
+                        return std::tie(blendState, shader, sampleCount, colorFormats, depthFormat, instanced) <
+                            std::tie(other.blendState, other.shader, other.sampleCount, colorFormats, other.depthFormat, other.instanced);
                     }
                 };
 
@@ -124,6 +128,24 @@ namespace ouzel
                     uint32_t offset = 0;
                 };
 
+                // constants of a shader stage that were last copied to a shader constant buffer
+                struct ShaderConstants
+                {
+                    std::vector<float> data;
+                    MTLBufferPtr buffer = nil;
+                    uint32_t offset = 0;
+                };
+
+                void setShaderConstants(MTLRenderCommandEncoderPtr renderCommandEncoder,
+                                        Shader& shader,
+                                        ShaderConstants& currentFragmentShaderConstants,
+                                        ShaderConstants& currentVertexShaderConstants,
+                                        Span<const float> fragmentShaderConstants,
+                                        Span<const float> vertexShaderConstants);
+
+                // copies the instances to the shader constant buffer of the frame, they must fit in one buffer
+                std::pair<MTLBufferPtr, NSUInteger> uploadInstances(Span<const Instance> instances);
+
                 uint32_t shaderConstantBufferIndex = 0;
                 ShaderConstantBuffer shaderConstantBuffers[BUFFER_COUNT];
 
@@ -6,7 +6,9 @@
 
 #include <Availability.h>
 #include <TargetConditionals.h>
+#include <algorithm>
 #include <cassert>
+#include <cstring>
 #include <stdexcept>
 #include "MetalRenderDevice.hpp"
 #include "MetalBlendState.hpp"
@@ -277,7 +279,8 @@ namespace ouzel
                 MTLRenderPassDescriptorPtr currentRenderPassDescriptor = nil;
                 id<MTLRenderCommandEncoder> currentRenderCommandEncoder = nil;
                 PipelineStateDesc currentPipelineStateDesc;
-                std::vector<float> shaderData;
+                ShaderConstants currentFragmentShaderConstants;
+                ShaderConstants currentVertexShaderConstants;
 
                 if (++shaderConstantBufferIndex >= BUFFER_COUNT) shaderConstantBufferIndex = 0;
                 ShaderConstantBuffer& shaderConstantBuffer = shaderConstantBuffers[shaderConstantBufferIndex];
@@ -287,15 +290,11 @@ namespace ouzel
                 Shader* currentShader = nullptr;
 
                 CommandBuffer commandBuffer;
-                std::unique_ptr<Command> command;
+                const Command* command;
 
                 for (;;)
                 {
-                    std::unique_lock<std::mutex> lock(commandQueueMutex);
-                    while (commandQueue.empty()) commandQueueCondition.wait(lock);
-                    commandBuffer = std::move(commandQueue.front());
-                    commandQueue.pop();
-                    lock.unlock();
+                    waitForCommandBuffer(commandBuffer);
 
                     while (!commandBuffer.isEmpty())
                     {
@@ -305,7 +304,7 @@ namespace ouzel
                         {
                             case Command::Type::Resize:
                             {
-                                auto resizeCommand = static_cast<const ResizeCommand*>(command.get());
+                                auto resizeCommand = static_cast<const ResizeCommand*>(command);
                                 const CGSize drawableSize = CGSizeMake(resizeCommand->size.v[0],
                                                                        resizeCommand->size.v[1]);
                                 metalLayer.drawableSize = drawableSize;
@@ -327,14 +326,14 @@ namespace ouzel
 
                             case Command::Type::DeleteResource:
                             {
-                                auto deleteResourceCommand = static_cast<const DeleteResourceCommand*>(command.get());
+                                auto deleteResourceCommand = static_cast<const DeleteResourceCommand*>(command);
                                 resources[deleteResourceCommand->resource - 1].reset();
                                 break;
                             }
 
                             case Command::Type::InitRenderTarget:
                             {
-                                auto initRenderTargetCommand = static_cast<const InitRenderTargetCommand*>(command.get());
+                                auto initRenderTargetCommand = static_cast<const InitRenderTargetCommand*>(command);
 
                                 std::set<Texture*> colorTextures;
                                 for (const uintptr_t colorTextureId : initRenderTargetCommand->colorTextures)
@@ -352,7 +351,7 @@ namespace ouzel
 
                             case Command::Type::SetRenderTarget:
                             {
-                                auto setRenderTargetCommand = static_cast<const SetRenderTargetCommand*>(command.get());
+                                auto setRenderTargetCommand = static_cast<const SetRenderTargetCommand*>(command);
 
                                 MTLRenderPassDescriptorPtr newRenderPassDescriptor;
 
@@ -398,7 +397,7 @@ namespace ouzel
 
                             case Command::Type::ClearRenderTarget:
                             {
-                                auto clearCommand = static_cast<const ClearRenderTargetCommand*>(command.get());
+                                auto clearCommand = static_cast<const ClearRenderTargetCommand*>(command);
 
                                 if (currentRenderCommandEncoder)
                                     [currentRenderCommandEncoder endEncoding];
@@ -434,14 +433,14 @@ namespace ouzel
 
                             case Command::Type::Blit:
                             {
-                                //auto blitCommand = static_cast<const BlitCommand*>(command.get());
+                                //auto blitCommand = static_cast<const BlitCommand*>(command);
                                 //MTLBlitCommandEncoder
                                 break;
                             }
 
                             case Command::Type::SetScissorTest:
                             {
-                                auto setScissorTestCommand = static_cast<const SetScissorTestCommand*>(command.get());
+                                auto setScissorTestCommand = static_cast<const SetScissorTestCommand*>(command);
 
                                 // create a new render command encoder to set up a new scissor rect
                                 if (currentRenderCommandEncoder)
@@ -463,7 +462,7 @@ namespace ouzel
 
                             case Command::Type::SetViewport:
                             {
-                                auto setViewportCommand = static_cast<const SetViewportCommand*>(command.get());
+                                auto setViewportCommand = static_cast<const SetViewportCommand*>(command);
 
                                 if (!currentRenderCommandEncoder)
                                     throw std::runtime_error("Metal render command encoder not initialized");
@@ -483,7 +482,7 @@ namespace ouzel
 
                             case Command::Type::InitDepthStencilState:
                             {
-                                auto initDepthStencilStateCommand = static_cast<const InitDepthStencilStateCommand*>(command.get());
+                                auto initDepthStencilStateCommand = static_cast<const InitDepthStencilStateCommand*>(command);
                                 auto depthStencilState = std::make_unique<DepthStencilState>(*this,
                                                                                              initDepthStencilStateCommand->depthTest,
                                                                                              initDepthStencilStateCommand->depthWrite,
@@ -509,7 +508,7 @@ namespace ouzel
 
                             case Command::Type::SetDepthStencilState:
                             {
-                                auto setDepthStencilStateCommand = static_cast<const SetDepthStencilStateCommand*>(command.get());
+                                auto setDepthStencilStateCommand = static_cast<const SetDepthStencilStateCommand*>(command);
 
                                 if (!currentRenderCommandEncoder)
                                     throw std::runtime_error("Metal render command encoder not initialized");
@@ -530,7 +529,7 @@ namespace ouzel
 
                             case Command::Type::SetPipelineState:
                             {
-                                auto setPipelineStateCommand = static_cast<const SetPipelineStateCommand*>(command.get());
+                                auto setPipelineStateCommand = static_cast<const SetPipelineStateCommand*>(command);
 
                                 if (!currentRenderCommandEncoder)
                                     throw std::runtime_error("Metal render command encoder not initialized");
@@ -553,7 +552,7 @@ namespace ouzel
 
                             case Command::Type::Draw:
                             {
-                                auto drawCommand = static_cast<const DrawCommand*>(command.get());
+                                auto drawCommand = static_cast<const DrawCommand*>(command);
 
                                 if (!currentRenderCommandEncoder)
                                     throw std::runtime_error("Metal render command encoder not initialized");
@@ -580,17 +579,148 @@ namespace ouzel
                                                                        indexBuffer:indexBuffer->getBuffer().get()
                                                                  indexBufferOffset:drawCommand->startIndex * drawCommand->indexSize];
 
+                                ++currentDrawCallCount;
+
+                                break;
+                            }
+
+                            case Command::Type::DrawInstanced:
+                            {
+                                auto drawInstancedCommand = static_cast<const DrawInstancedCommand*>(command);
+
+                                if (!currentRenderCommandEncoder)
+                                    throw std::runtime_error("Metal render command encoder not initialized");
+
+                                if (!currentShader)
+                                    throw std::runtime_error("No shader set");
+
+                                // mesh buffer
+                                Buffer* indexBuffer = getResource<Buffer>(drawInstancedCommand->indexBuffer);
+                                Buffer* vertexBuffer = getResource<Buffer>(drawInstancedCommand->vertexBuffer);
+
+                                assert(indexBuffer);
+                                assert(indexBuffer->getBuffer());
+                                assert(vertexBuffer);
+                                assert(vertexBuffer->getBuffer());
+
+                                [currentRenderCommandEncoder setVertexBuffer:vertexBuffer->getBuffer().get() offset:0 atIndex:0];
+
+                                PipelineStateDesc instancedPipelineStateDesc = currentPipelineStateDesc;
+                                instancedPipelineStateDesc.instanced = true;
+
+                                MTLRenderPipelineStatePtr instancedPipelineState = currentShader->getInstancedVertexShader() ?
+                                    getPipelineState(instancedPipelineStateDesc) : nil;
+
+                                if (instancedPipelineState)
+                                {
+                                    // the instanced vertex function multiplies the vertex color with the instance color,
+                                    // so the color constant of the fragment function is white, the vertex constants are not read
+                                    const float white[] = {1.0F, 1.0F, 1.0F, 1.0F};
+                                    setShaderConstants(currentRenderCommandEncoder,
+                                                       *currentShader,
+                                                       currentFragmentShaderConstants,
+                                                       currentVertexShaderConstants,
+                                                       white,
+                                                       Span<const float>());
+
+                                    [currentRenderCommandEncoder setRenderPipelineState:instancedPipelineState];
+
+                                    // the instances are copied to the shader constant buffers of the frame,
+                                    // at most a buffer at a time
+                                    const auto maxInstanceCount = BUFFER_SIZE / sizeof(Instance);
+                                    Span<const Instance> instances = drawInstancedCommand->instances;
+
+                                    while (!instances.empty())
+                                    {
+                                        const auto instanceCount = std::min(instances.size(), maxInstanceCount);
+                                        const auto instanceData = uploadInstances(Span<const Instance>(instances.data(), instanceCount));
+
+                                        [currentRenderCommandEncoder setVertexBuffer:instanceData.first
+                                                                              offset:instanceData.second
+                                                                             atIndex:INSTANCE_BUFFER_INDEX];
+
+                                        [currentRenderCommandEncoder drawIndexedPrimitives:getPrimitiveType(drawInstancedCommand->drawMode)
+                                                                                indexCount:drawInstancedCommand->indexCount
+                                                                                 indexType:getIndexType(drawInstancedCommand->indexSize)
+                                                                               indexBuffer:indexBuffer->getBuffer().get()
+                                                                         indexBufferOffset:drawInstancedCommand->startIndex * drawInstancedCommand->indexSize
+                                                                             instanceCount:instanceCount];
+
+                                        ++currentDrawCallCount;
+
+                                        instances = Span<const Instance>(instances.data() + instanceCount, instances.size() - instanceCount);
+                                    }
+
+                                    MTLRenderPipelineStatePtr pipelineState = getPipelineState(currentPipelineStateDesc);
+                                    if (pipelineState) [currentRenderCommandEncoder setRenderPipelineState:pipelineState];
+                                }
+                                else
+                                {
+                                    // shaders without an instanced vertex function take the transform and the color from
+                                    // the constant buffers, so they are set for every instance
+                                    for (const Instance& instance : drawInstancedCommand->instances)
+                                    {
+                                        setShaderConstants(currentRenderCommandEncoder,
+                                                           *currentShader,
+                                                           currentFragmentShaderConstants,
+                                                           currentVertexShaderConstants,
+                                                           instance.color,
+                                                           instance.modelViewProjection);
+
+                                        [currentRenderCommandEncoder drawIndexedPrimitives:getPrimitiveType(drawInstancedCommand->drawMode)
+                                                                                indexCount:drawInstancedCommand->indexCount
+                                                                                 indexType:getIndexType(drawInstancedCommand->indexSize)
+                                                                               indexBuffer:indexBuffer->getBuffer().get()
+                                                                         indexBufferOffset:drawInstancedCommand->startIndex * drawInstancedCommand->indexSize];
+
+                                        ++currentDrawCallCount;
+                                    }
+                                }
+
+                                break;
+                            }
+
+                            case Command::Type::MultiDraw:
+                            {
+                                auto multiDrawCommand = static_cast<const MultiDrawCommand*>(command);
+
+                                if (!currentRenderCommandEncoder)
+                                    throw std::runtime_error("Metal render command encoder not initialized");
+
+                                // mesh buffer
+                                Buffer* indexBuffer = getResource<Buffer>(multiDrawCommand->indexBuffer);
+                                Buffer* vertexBuffer = getResource<Buffer>(multiDrawCommand->vertexBuffer);
+
+                                assert(indexBuffer);
+                                assert(indexBuffer->getBuffer());
+                                assert(vertexBuffer);
+                                assert(vertexBuffer->getBuffer());
+
+                                [currentRenderCommandEncoder setVertexBuffer:vertexBuffer->getBuffer().get() offset:0 atIndex:0];
+
+                                // Metal has no multi-draw without indirect buffers, so the ranges are drawn one by one
+                                for (const DrawRange& range : multiDrawCommand->ranges)
+                                {
+                                    [currentRenderCommandEncoder drawIndexedPrimitives:getPrimitiveType(multiDrawCommand->drawMode)
+                                                                            indexCount:range.indexCount
+                                                                             indexType:getIndexType(multiDrawCommand->indexSize)
+                                                                           indexBuffer:indexBuffer->getBuffer().get()
+                                                                     indexBufferOffset:range.startIndex * multiDrawCommand->indexSize];
+
+                                    ++currentDrawCallCount;
+                                }
+
                                 break;
                             }
 
                             case Command::Type::PushDebugMarker:
                             {
-                                auto pushDebugMarkerCommand = static_cast<const PushDebugMarkerCommand*>(command.get());
+                                auto pushDebugMarkerCommand = static_cast<const PushDebugMarkerCommand*>(command);
 
                                 if (!currentRenderCommandEncoder)
                                     throw std::runtime_error("Metal render command encoder not initialized");
 
-                                [currentRenderCommandEncoder pushDebugGroup:static_cast<NSString* _Nonnull>([NSString stringWithUTF8String:pushDebugMarkerCommand->name.c_str()])];
+                                [currentRenderCommandEncoder pushDebugGroup:static_cast<NSString* _Nonnull>([NSString stringWithUTF8String:pushDebugMarkerCommand->name])];
                                 break;
                             }
 
@@ -607,7 +737,7 @@ namespace ouzel
 
                             case Command::Type::InitBlendState:
                             {
-                                auto initBlendStateCommand = static_cast<const InitBlendStateCommand*>(command.get());
+                                auto initBlendStateCommand = static_cast<const InitBlendStateCommand*>(command);
 
                                 auto blendState = std::make_unique<BlendState>(*this,
                                                                                initBlendStateCommand->enableBlending,
@@ -627,7 +757,7 @@ namespace ouzel
 
                             case Command::Type::InitBuffer:
                             {
-                                auto initBufferCommand = static_cast<const InitBufferCommand*>(command.get());
+                                auto initBufferCommand = static_cast<const InitBufferCommand*>(command);
 
                                 auto buffer = std::make_unique<Buffer>(*this,
                                                                         initBufferCommand->bufferType,
@@ -643,16 +773,29 @@ namespace ouzel
 
                             case Command::Type::SetBufferData:
                             {
-                                auto setBufferDataCommand = static_cast<const SetBufferDataCommand*>(command.get());
+                                auto setBufferDataCommand = static_cast<const SetBufferDataCommand*>(command);
 
                                 Buffer* buffer = getResource<Buffer>(setBufferDataCommand->buffer);
                                 buffer->setData(setBufferDataCommand->data);
                                 break;
                             }
 
+                            case Command::Type::UploadTransientGeometry:
+                            {
+                                auto uploadTransientGeometryCommand = static_cast<const UploadTransientGeometryCommand*>(command);
+
+                                const TransientBlock& block = commandBuffer.getTransientBlocks()[uploadTransientGeometryCommand->block];
+
+                                Buffer* indexBuffer = getResource<Buffer>(block.indexBuffer);
+                                Buffer* vertexBuffer = getResource<Buffer>(block.vertexBuffer);
+                                indexBuffer->setData(commandBuffer.getTransientIndexData(block));
+                                vertexBuffer->setData(commandBuffer.getTransientVertexData(block));
+                                break;
+                            }
+
                             case Command::Type::InitShader:
                             {
-                                auto initShaderCommand = static_cast<const InitShaderCommand*>(command.get());
+                                auto initShaderCommand = static_cast<const InitShaderCommand*>(command);
 
                                 auto shader = std::make_unique<Shader>(*this,
                                                                        initShaderCommand->fragmentShader,
@@ -663,7 +806,8 @@ namespace ouzel
                                                                        initShaderCommand->fragmentShaderDataAlignment,
                                                                        initShaderCommand->vertexShaderDataAlignment,
                                                                        initShaderCommand->fragmentShaderFunction,
-                                                                       initShaderCommand->vertexShaderFunction);
+                                                                       initShaderCommand->vertexShaderFunction,
+                                                                       initShaderCommand->instancedVertexShader);
 
                                 if (initShaderCommand->shader > resources.size())
                                     resources.resize(initShaderCommand->shader);
@@ -673,7 +817,7 @@ namespace ouzel
 
                             case Command::Type::SetShaderConstants:
                             {
-                                auto setShaderConstantsCommand = static_cast<const SetShaderConstantsCommand*>(command.get());
+                                auto setShaderConstantsCommand = static_cast<const SetShaderConstantsCommand*>(command);
 
                                 if (!currentRenderCommandEncoder)
                                     throw std::runtime_error("Metal render command encoder not initialized");
@@ -681,114 +825,19 @@ namespace ouzel
                                 if (!currentShader)
                                     throw std::runtime_error("No shader set");
 
-                                // pixel shader constants
-                                const std::vector<Shader::Location>& fragmentShaderConstantLocations = currentShader->getFragmentShaderConstantLocations();
-
-                                if (setShaderConstantsCommand->fragmentShaderConstants.size() > fragmentShaderConstantLocations.size())
-                                    throw std::runtime_error("Invalid pixel shader constant size");
-
-                                shaderData.clear();
-
-                                for (size_t i = 0; i < setShaderConstantsCommand->fragmentShaderConstants.size(); ++i)
-                                {
-                                    const Shader::Location& fragmentShaderConstantLocation = fragmentShaderConstantLocations[i];
-                                    const std::vector<float>& fragmentShaderConstant = setShaderConstantsCommand->fragmentShaderConstants[i];
-
-                                    if (sizeof(float) * fragmentShaderConstant.size() != fragmentShaderConstantLocation.size)
-                                        throw std::runtime_error("Invalid pixel shader constant size");
-
-                                    shaderData.insert(shaderData.end(), fragmentShaderConstant.begin(), fragmentShaderConstant.end());
-                                }
-
-                                shaderConstantBuffer.offset = ((shaderConstantBuffer.offset + currentShader->getFragmentShaderAlignment() - 1) /
-                                                               currentShader->getFragmentShaderAlignment()) * currentShader->getFragmentShaderAlignment(); // round up to nearest aligned pointer
-
-                                if (shaderConstantBuffer.offset + getVectorSize(shaderData) > BUFFER_SIZE)
-                                {
-                                    ++shaderConstantBuffer.index;
-                                    shaderConstantBuffer.offset = 0;
-                                }
-
-                                if (shaderConstantBuffer.index >= shaderConstantBuffer.buffers.size())
-                                {
-                                    MTLBufferPtr buffer = [device.get() newBufferWithLength:BUFFER_SIZE
-                                                                                    options:MTLResourceCPUCacheModeWriteCombined];
-
-                                    if (!buffer)
-                                        throw std::runtime_error("Failed to create Metal buffer");
-
-                                    shaderConstantBuffer.buffers.push_back(buffer);
-                                }
-
-                                MTLBufferPtr currentBuffer = shaderConstantBuffer.buffers[shaderConstantBuffer.index].get();
-
-                                std::copy(reinterpret_cast<const char*>(shaderData.data()),
-                                          reinterpret_cast<const char*>(shaderData.data()) + sizeof(float) * shaderData.size(),
-                                          static_cast<char*>([currentBuffer contents]) + shaderConstantBuffer.offset);
-
-                                [currentRenderCommandEncoder setFragmentBuffer:currentBuffer
-                                                                        offset:shaderConstantBuffer.offset
-                                                                       atIndex:1];
-
-                                shaderConstantBuffer.offset += static_cast<uint32_t>(getVectorSize(shaderData));
-
-                                // vertex shader constants
-                                const std::vector<Shader::Location>& vertexShaderConstantLocations = currentShader->getVertexShaderConstantLocations();
-
-                                if (setShaderConstantsCommand->vertexShaderConstants.size() > vertexShaderConstantLocations.size())
-                                    throw std::runtime_error("Invalid vertex shader constant size");
-
-                                shaderData.clear();
-
-                                for (size_t i = 0; i < setShaderConstantsCommand->vertexShaderConstants.size(); ++i)
-                                {
-                                    const Shader::Location& vertexShaderConstantLocation = vertexShaderConstantLocations[i];
-                                    const std::vector<float>& vertexShaderConstant = setShaderConstantsCommand->vertexShaderConstants[i];
-
-                                    if (sizeof(float) * vertexShaderConstant.size() != vertexShaderConstantLocation.size)
-                                        throw std::runtime_error("Invalid vertex shader constant size");
-
-                                    shaderData.insert(shaderData.end(), vertexShaderConstant.begin(), vertexShaderConstant.end());
-                                }
-
-                                shaderConstantBuffer.offset = ((shaderConstantBuffer.offset + currentShader->getVertexShaderAlignment() - 1) /
-                                                               currentShader->getVertexShaderAlignment()) * currentShader->getVertexShaderAlignment(); // round up to nearest aligned pointer
-
-                                if (shaderConstantBuffer.offset + getVectorSize(shaderData) > BUFFER_SIZE)
-                                {
-                                    ++shaderConstantBuffer.index;
-                                    shaderConstantBuffer.offset = 0;
-                                }
-
-                                if (shaderConstantBuffer.index >= shaderConstantBuffer.buffers.size())
-                                {
-                                    MTLBufferPtr buffer = [device.get() newBufferWithLength:BUFFER_SIZE
-                                                                                    options:MTLResourceCPUCacheModeWriteCombined];
-
-                                    if (!buffer)
-                                        throw std::runtime_error("Failed to create Metal buffer");
-
-                                    shaderConstantBuffer.buffers.push_back(buffer);
-                                }
-
-                                currentBuffer = shaderConstantBuffer.buffers[shaderConstantBuffer.index].get();
-
-                                std::copy(reinterpret_cast<const char*>(shaderData.data()),
-                                          reinterpret_cast<const char*>(shaderData.data()) + sizeof(float) * shaderData.size(),
-                                          static_cast<char*>([currentBuffer contents]) + shaderConstantBuffer.offset);
-
-                                [currentRenderCommandEncoder setVertexBuffer:currentBuffer
-                                                                      offset:shaderConstantBuffer.offset
-                                                                     atIndex:1];
-
-                                shaderConstantBuffer.offset += static_cast<uint32_t>(getVectorSize(shaderData));
+                                setShaderConstants(currentRenderCommandEncoder,
+                                                   *currentShader,
+                                                   currentFragmentShaderConstants,
+                                                   currentVertexShaderConstants,
+                                                   commandBuffer.getConstants(setShaderConstantsCommand->fragmentShaderConstants),
+                                                   commandBuffer.getConstants(setShaderConstantsCommand->vertexShaderConstants));
 
                                 break;
                             }
 
                             case Command::Type::InitTexture:
                             {
-                                auto initTextureCommand = static_cast<const InitTextureCommand*>(command.get());
+                                auto initTextureCommand = static_cast<const InitTextureCommand*>(command);
 
                                 auto texture = std::make_unique<Texture>(*this,
                                                                          initTextureCommand->levels,
@@ -805,7 +854,7 @@ namespace ouzel
 
                             case Command::Type::SetTextureData:
                             {
-                                auto setTextureDataCommand = static_cast<const SetTextureDataCommand*>(command.get());
+                                auto setTextureDataCommand = static_cast<const SetTextureDataCommand*>(command);
 
                                 Texture* texture = getResource<Texture>(setTextureDataCommand->texture);
                                 texture->setData(setTextureDataCommand->levels);
@@ -813,9 +862,22 @@ namespace ouzel
                                 break;
                             }
 
+                            case Command::Type::SetTextureRegion:
+                            {
+                                auto setTextureRegionCommand = static_cast<const SetTextureRegionCommand*>(command);
+
+                                Texture* texture = getResource<Texture>(setTextureRegionCommand->texture);
+                                texture->setRegionData(setTextureRegionCommand->x,
+                                                       setTextureRegionCommand->y,
+                                                       setTextureRegionCommand->size,
+                                                       setTextureRegionCommand->data);
+
+                                break;
+                            }
+
                             case Command::Type::SetTextureParameters:
                             {
-                                auto setTextureParametersCommand = static_cast<const SetTextureParametersCommand*>(command.get());
+                                auto setTextureParametersCommand = static_cast<const SetTextureParametersCommand*>(command);
 
                                 Texture* texture = getResource<Texture>(setTextureParametersCommand->texture);
                                 texture->setFilter(setTextureParametersCommand->filter == SamplerFilter::Default ? textureFilter : setTextureParametersCommand->filter);
@@ -829,7 +891,7 @@ namespace ouzel
 
                             case Command::Type::SetTextures:
                             {
-                                auto setTexturesCommand = static_cast<const SetTexturesCommand*>(command.get());
+                                auto setTexturesCommand = static_cast<const SetTexturesCommand*>(command);
 
                                 if (!currentRenderCommandEncoder)
                                     throw std::runtime_error("Metal render command encoder not initialized");
@@ -854,9 +916,175 @@ namespace ouzel
                             default: throw std::runtime_error("Invalid command");
                         }
 
-                        if (command->type == Command::Type::Present) return;
+                        if (command->type == Command::Type::Present)
+                        {
+                            finishCommandBuffer(commandBuffer);
+                            return;
+                        }
+                    }
+                }
+            }
+
+            void RenderDevice::setShaderConstants(MTLRenderCommandEncoderPtr renderCommandEncoder,
+                                                  Shader& shader,
+                                                  ShaderConstants& currentFragmentShaderConstants,
+                                                  ShaderConstants& currentVertexShaderConstants,
+                                                  Span<const float> fragmentShaderConstants,
+                                                  Span<const float> vertexShaderConstants)
+            {
+                ShaderConstantBuffer& shaderConstantBuffer = shaderConstantBuffers[shaderConstantBufferIndex];
+
+                // pixel shader constants
+                const std::vector<Shader::Location>& fragmentShaderConstantLocations = shader.getFragmentShaderConstantLocations();
+                const uint32_t fragmentShaderConstantSize = static_cast<uint32_t>(sizeof(float) * fragmentShaderConstants.size());
+
+                // the constants are packed in the order of the locations, so they must end at the end of one
+                if (fragmentShaderConstantSize &&
+                    std::none_of(fragmentShaderConstantLocations.begin(), fragmentShaderConstantLocations.end(),
+                                 [fragmentShaderConstantSize](const Shader::Location& location) {
+                                     return location.offset + location.size == fragmentShaderConstantSize;
+                                 }))
+                    throw std::runtime_error("Invalid pixel shader constant size");
+
+                const uint32_t fragmentShaderAlignment = shader.getFragmentShaderAlignment();
+
+                // constants that are the same as the last ones are bound from where those were copied to
+                if (!currentFragmentShaderConstants.buffer ||
+                    currentFragmentShaderConstants.offset % fragmentShaderAlignment != 0 ||
+                    currentFragmentShaderConstants.data.size() != fragmentShaderConstants.size() ||
+                    (fragmentShaderConstantSize && std::memcmp(currentFragmentShaderConstants.data.data(), fragmentShaderConstants.data(), fragmentShaderConstantSize) != 0))
+                {
+                    shaderConstantBuffer.offset = ((shaderConstantBuffer.offset + fragmentShaderAlignment - 1) /
+                                                   fragmentShaderAlignment) * fragmentShaderAlignment; // round up to nearest aligned pointer
+
+                    if (shaderConstantBuffer.offset + fragmentShaderConstantSize > BUFFER_SIZE)
+                    {
+                        ++shaderConstantBuffer.index;
+                        shaderConstantBuffer.offset = 0;
+                    }
+
+                    if (shaderConstantBuffer.index >= shaderConstantBuffer.buffers.size())
+                    {
+                        MTLBufferPtr buffer = [device.get() newBufferWithLength:BUFFER_SIZE
+                                                                        options:MTLResourceCPUCacheModeWriteCombined];
+
+                        if (!buffer)
+                            throw std::runtime_error("Failed to create Metal buffer");
+
+                        shaderConstantBuffer.buffers.push_back(buffer);
+                    }
+
+                    MTLBufferPtr currentBuffer = shaderConstantBuffer.buffers[shaderConstantBuffer.index].get();
+
+                    std::copy(reinterpret_cast<const char*>(fragmentShaderConstants.data()),
+                              reinterpret_cast<const char*>(fragmentShaderConstants.data()) + fragmentShaderConstantSize,
+                              static_cast<char*>([currentBuffer contents]) + shaderConstantBuffer.offset);
+
+                    currentFragmentShaderConstants.data.assign(fragmentShaderConstants.begin(), fragmentShaderConstants.end());
+                    currentFragmentShaderConstants.buffer = currentBuffer;
+                    currentFragmentShaderConstants.offset = shaderConstantBuffer.offset;
+
+                    shaderConstantBuffer.offset += fragmentShaderConstantSize;
+                }
+
+                [renderCommandEncoder setFragmentBuffer:currentFragmentShaderConstants.buffer
+                                                 offset:currentFragmentShaderConstants.offset
+                                                atIndex:1];
+
+                // vertex shader constants
+                const std::vector<Shader::Location>& vertexShaderConstantLocations = shader.getVertexShaderConstantLocations();
+                const uint32_t vertexShaderConstantSize = static_cast<uint32_t>(sizeof(float) * vertexShaderConstants.size());
+
+                // the constants are packed in the order of the locations, so they must end at the end of one
+                if (vertexShaderConstantSize &&
+                    std::none_of(vertexShaderConstantLocations.begin(), vertexShaderConstantLocations.end(),
+                                 [vertexShaderConstantSize](const Shader::Location& location) {
+                                     return location.offset + location.size == vertexShaderConstantSize;
+                                 }))
+                    throw std::runtime_error("Invalid vertex shader constant size");
+
+                const uint32_t vertexShaderAlignment = shader.getVertexShaderAlignment();
+
+                // constants that are the same as the last ones are bound from where those were copied to
+                if (!currentVertexShaderConstants.buffer ||
+                    currentVertexShaderConstants.offset % vertexShaderAlignment != 0 ||
+                    currentVertexShaderConstants.data.size() != vertexShaderConstants.size() ||
+                    (vertexShaderConstantSize && std::memcmp(currentVertexShaderConstants.data.data(), vertexShaderConstants.data(), vertexShaderConstantSize) != 0))
+                {
+                    shaderConstantBuffer.offset = ((shaderConstantBuffer.offset + vertexShaderAlignment - 1) /
+                                                   vertexShaderAlignment) * vertexShaderAlignment; // round up to nearest aligned pointer
+
+                    if (shaderConstantBuffer.offset + vertexShaderConstantSize > BUFFER_SIZE)
+                    {
+                        ++shaderConstantBuffer.index;
+                        shaderConstantBuffer.offset = 0;
+                    }
+
+                    if (shaderConstantBuffer.index >= shaderConstantBuffer.buffers.size())
+                    {
+                        MTLBufferPtr buffer = [device.get() newBufferWithLength:BUFFER_SIZE
+                                                                        options:MTLResourceCPUCacheModeWriteCombined];
+
+                        if (!buffer)
+                            throw std::runtime_error("Failed to create Metal buffer");
+
+                        shaderConstantBuffer.buffers.push_back(buffer);
                     }
+
+                    MTLBufferPtr currentBuffer = shaderConstantBuffer.buffers[shaderConstantBuffer.index].get();
+
+                    std::copy(reinterpret_cast<const char*>(vertexShaderConstants.data()),
+                              reinterpret_cast<const char*>(vertexShaderConstants.data()) + vertexShaderConstantSize,
+                              static_cast<char*>([currentBuffer contents]) + shaderConstantBuffer.offset);
+
+                    currentVertexShaderConstants.data.assign(vertexShaderConstants.begin(), vertexShaderConstants.end());
+                    currentVertexShaderConstants.buffer = currentBuffer;
+                    currentVertexShaderConstants.offset = shaderConstantBuffer.offset;
+
+                    shaderConstantBuffer.offset += vertexShaderConstantSize;
                 }
+
+                [renderCommandEncoder setVertexBuffer:currentVertexShaderConstants.buffer
+                                               offset:currentVertexShaderConstants.offset
+                                              atIndex:1];
+            }
+
+            std::pair<MTLBufferPtr, NSUInteger> RenderDevice::uploadInstances(Span<const Instance> instances)
+            {
+                ShaderConstantBuffer& shaderConstantBuffer = shaderConstantBuffers[shaderConstantBufferIndex];
+
+                const auto dataSize = static_cast<uint32_t>(instances.size() * sizeof(Instance));
+
+                // vertex buffer offsets must be aligned to 4 bytes
+                shaderConstantBuffer.offset = ((shaderConstantBuffer.offset + 3) / 4) * 4;
+
+                if (shaderConstantBuffer.offset + dataSize > BUFFER_SIZE)
+                {
+                    ++shaderConstantBuffer.index;
+                    shaderConstantBuffer.offset = 0;
+                }
+
+                if (shaderConstantBuffer.index >= shaderConstantBuffer.buffers.size())
+                {
+                    MTLBufferPtr buffer = [device.get() newBufferWithLength:BUFFER_SIZE
+                                                                    options:MTLResourceCPUCacheModeWriteCombined];
+
+                    if (!buffer)
+                        throw std::runtime_error("Failed to create Metal buffer");
+
+                    shaderConstantBuffer.buffers.push_back(buffer);
+                }
+
+                MTLBufferPtr currentBuffer = shaderConstantBuffer.buffers[shaderConstantBuffer.index].get();
+                const NSUInteger offset = shaderConstantBuffer.offset;
+
+                std::copy(reinterpret_cast<const char*>(instances.data()),
+                          reinterpret_cast<const char*>(instances.data()) + dataSize,
+                          static_cast<char*>([currentBuffer contents]) + offset);
+
+                shaderConstantBuffer.offset += dataSize;
+
+                return std::make_pair(currentBuffer, offset);
             }
 
             void RenderDevice::generateScreenshot(const std::string& filename)
@@ -909,9 +1137,21 @@ namespace ouzel
                         assert(desc.shader->getVertexShader());
                         assert(desc.shader->getVertexDescriptor());
 
-                        pipelineStateDescriptor.get().vertexFunction = desc.shader->getVertexShader().get();
+                        if (desc.instanced)
+                        {
+                            assert(desc.shader->getInstancedVertexShader());
+                            assert(desc.shader->getInstancedVertexDescriptor());
+
+                            pipelineStateDescriptor.get().vertexFunction = desc.shader->getInstancedVertexShader().get();
+                            pipelineStateDescriptor.get().vertexDescriptor = desc.shader->getInstancedVertexDescriptor().get();
+                        }
+                        else
+                        {
+                            pipelineStateDescriptor.get().vertexFunction = desc.shader->getVertexShader().get();
+                            pipelineStateDescriptor.get().vertexDescriptor = desc.shader->getVertexDescriptor().get();
+                        }
+
                         pipelineStateDescriptor.get().fragmentFunction = desc.shader->getFragmentShader().get();
-                        pipelineStateDescriptor.get().vertexDescriptor = desc.shader->getVertexDescriptor().get();
                     }
 
                     for (size_t i = 0; i < desc.colorFormats.size(); ++i)
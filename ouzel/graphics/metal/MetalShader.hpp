@@ -21,6 +21,7 @@ typedef id MTLVertexDescriptorPtr;
 
 #include "graphics/metal/MetalRenderResource.hpp"
 #include "graphics/metal/MetalPointer.hpp"
+#include "graphics/Commands.hpp"
 #include "graphics/DataType.hpp"
 #include "graphics/Vertex.hpp"
 
@@ -36,15 +37,16 @@ namespace ouzel
             {
             public:
                 Shader(RenderDevice& initRenderDevice,
-                       const std::vector<uint8_t>& fragmentShaderData,
-                       const std::vector<uint8_t>& vertexShaderData,
-                       const std::set<Vertex::Attribute::Usage>& initVertexAttributes,
-                       const std::vector<std::pair<std::string, DataType>>& initFragmentShaderConstantInfo,
-                       const std::vector<std::pair<std::string, DataType>>& initVertexShaderConstantInfo,
+                       Span<const uint8_t> fragmentShaderData,
+                       Span<const uint8_t> vertexShaderData,
+                       Span<const Vertex::Attribute::Usage> initVertexAttributes,
+                       Span<const ShaderConstantInfo> initFragmentShaderConstantInfo,
+                       Span<const ShaderConstantInfo> initVertexShaderConstantInfo,
                        uint32_t initFragmentShaderDataAlignment,
                        uint32_t initVertexShaderDataAlignment,
-                       const std::string& fragmentShaderFunction,
-                       const std::string& vertexShaderFunction);
+                       const char* fragmentShaderFunction,
+                       const char* vertexShaderFunction,
+                       Span<const uint8_t> instancedVertexShaderSource);
 
                 struct Location final
                 {
@@ -70,6 +72,10 @@ namespace ouzel
 
                 inline auto& getVertexDescriptor() const noexcept { return vertexDescriptor; }
 
+                // vertex function that reads the transform and the color from the per-instance stream, nil if the shader has none
+                inline auto& getInstancedVertexShader() const noexcept { return instancedVertexShader; }
+                inline auto& getInstancedVertexDescriptor() const noexcept { return instancedVertexDescriptor; }
+
                 inline auto getFragmentShaderConstantBufferSize() const noexcept { return fragmentShaderConstantSize; }
                 inline auto getVertexShaderConstantBufferSize() const noexcept { return vertexShaderConstantSize; }
 
@@ -85,6 +91,8 @@ namespace ouzel
                 Pointer<MTLFunctionPtr> vertexShader;
 
                 Pointer<MTLVertexDescriptorPtr> vertexDescriptor;
+                Pointer<MTLFunctionPtr> instancedVertexShader;
+                Pointer<MTLVertexDescriptorPtr> instancedVertexDescriptor;
 
                 std::vector<Location> fragmentShaderConstantLocations;
                 uint32_t fragmentShaderConstantSize = 0;
@@ -5,6 +5,7 @@
 #if OUZEL_COMPILE_METAL
 
 #include <algorithm>
+#include <cstddef>
 #include <stdexcept>
 #include "MetalShader.hpp"
 #include "MetalRenderDevice.hpp"
@@ -86,28 +87,33 @@ namespace ouzel
             }
 
             Shader::Shader(RenderDevice& initRenderDevice,
-                           const std::vector<uint8_t>& fragmentShaderData,
-                           const std::vector<uint8_t>& vertexShaderData,
-                           const std::set<Vertex::Attribute::Usage>& initVertexAttributes,
-                           const std::vector<std::pair<std::string, DataType>>& initFragmentShaderConstantInfo,
-                           const std::vector<std::pair<std::string, DataType>>& initVertexShaderConstantInfo,
+                           Span<const uint8_t> fragmentShaderData,
+                           Span<const uint8_t> vertexShaderData,
+                           Span<const Vertex::Attribute::Usage> initVertexAttributes,
+                           Span<const ShaderConstantInfo> initFragmentShaderConstantInfo,
+                           Span<const ShaderConstantInfo> initVertexShaderConstantInfo,
                            uint32_t initFragmentShaderDataAlignment,
                            uint32_t initVertexShaderDataAlignment,
-                           const std::string& fragmentShaderFunction,
-                           const std::string& vertexShaderFunction):
+                           const char* fragmentShaderFunction,
+                           const char* vertexShaderFunction,
+                           Span<const uint8_t> instancedVertexShaderSource):
                 RenderResource(initRenderDevice),
-                vertexAttributes(initVertexAttributes),
-                fragmentShaderConstantInfo(initFragmentShaderConstantInfo),
-                vertexShaderConstantInfo(initVertexShaderConstantInfo)
+                vertexAttributes(initVertexAttributes.begin(), initVertexAttributes.end())
             {
+                for (const ShaderConstantInfo& info : initFragmentShaderConstantInfo)
+                    fragmentShaderConstantInfo.emplace_back(info.name, info.dataType);
+
+                for (const ShaderConstantInfo& info : initVertexShaderConstantInfo)
+                    vertexShaderConstantInfo.emplace_back(info.name, info.dataType);
+
                 if (initFragmentShaderDataAlignment)
                     fragmentShaderAlignment = initFragmentShaderDataAlignment;
                 else
                 {
                     fragmentShaderAlignment = 0;
 
-                    for (const std::pair<std::string, DataType>& info : initFragmentShaderConstantInfo)
-                        fragmentShaderAlignment += getDataTypeSize(info.second);
+                    for (const ShaderConstantInfo& info : initFragmentShaderConstantInfo)
+                        fragmentShaderAlignment += getDataTypeSize(info.dataType);
                 }
 
                 if (initVertexShaderDataAlignment)
@@ -116,14 +122,15 @@ namespace ouzel
                 {
                     vertexShaderAlignment = 0;
 
-                    for (const std::pair<std::string, DataType>& info : initVertexShaderConstantInfo)
-                        vertexShaderAlignment += getDataTypeSize(info.second);
+                    for (const ShaderConstantInfo& info : initVertexShaderConstantInfo)
+                        vertexShaderAlignment += getDataTypeSize(info.dataType);
                 }
 
                 uint32_t index = 0;
                 NSUInteger offset = 0;
 
                 vertexDescriptor = [[MTLVertexDescriptor alloc] init];
+                instancedVertexDescriptor = [[MTLVertexDescriptor alloc] init];
 
                 for (const Vertex::Attribute& vertexAttribute : RenderDevice::VERTEX_ATTRIBUTES)
                 {
@@ -137,6 +144,9 @@ namespace ouzel
                         vertexDescriptor.get().attributes[index].format = vertexFormat;
                         vertexDescriptor.get().attributes[index].offset = offset;
                         vertexDescriptor.get().attributes[index].bufferIndex = 0;
+                        instancedVertexDescriptor.get().attributes[index].format = vertexFormat;
+                        instancedVertexDescriptor.get().attributes[index].offset = offset;
+                        instancedVertexDescriptor.get().attributes[index].bufferIndex = 0;
                         ++index;
                     }
 
@@ -147,6 +157,27 @@ namespace ouzel
                 vertexDescriptor.get().layouts[0].stepRate = 1;
                 vertexDescriptor.get().layouts[0].stepFunction = MTLVertexStepFunctionPerVertex;
 
+                instancedVertexDescriptor.get().layouts[0].stride = offset;
+                instancedVertexDescriptor.get().layouts[0].stepRate = 1;
+                instancedVertexDescriptor.get().layouts[0].stepFunction = MTLVertexStepFunctionPerVertex;
+
+                // the columns of the model view projection matrix and the color of the instance stream
+                for (NSUInteger column = 0; column < 4; ++column)
+                {
+                    const NSUInteger attribute = RenderDevice::INSTANCE_ATTRIBUTE_INDEX + column;
+                    instancedVertexDescriptor.get().attributes[attribute].format = MTLVertexFormatFloat4;
+                    instancedVertexDescriptor.get().attributes[attribute].offset = offsetof(Instance, modelViewProjection) + column * 4 * sizeof(float);
+                    instancedVertexDescriptor.get().attributes[attribute].bufferIndex = RenderDevice::INSTANCE_BUFFER_INDEX;
+                }
+
+                instancedVertexDescriptor.get().attributes[RenderDevice::INSTANCE_ATTRIBUTE_INDEX + 4].format = MTLVertexFormatFloat4;
+                instancedVertexDescriptor.get().attributes[RenderDevice::INSTANCE_ATTRIBUTE_INDEX + 4].offset = offsetof(Instance, color);
+                instancedVertexDescriptor.get().attributes[RenderDevice::INSTANCE_ATTRIBUTE_INDEX + 4].bufferIndex = RenderDevice::INSTANCE_BUFFER_INDEX;
+
+                instancedVertexDescriptor.get().layouts[RenderDevice::INSTANCE_BUFFER_INDEX].stride = sizeof(Instance);
+                instancedVertexDescriptor.get().layouts[RenderDevice::INSTANCE_BUFFER_INDEX].stepRate = 1;
+                instancedVertexDescriptor.get().layouts[RenderDevice::INSTANCE_BUFFER_INDEX].stepFunction = MTLVertexStepFunctionPerInstance;
+
                 NSError* err;
 
                 dispatch_data_t fragmentShaderDispatchData = dispatch_data_create(fragmentShaderData.data(), fragmentShaderData.size(), nullptr, DISPATCH_DATA_DESTRUCTOR_DEFAULT);
@@ -156,7 +187,7 @@ namespace ouzel
                 if (!fragmentShaderLibrary || err != nil)
                     throw std::runtime_error("Failed to load pixel shader, " + std::string(err ? [err.localizedDescription cStringUsingEncoding:NSUTF8StringEncoding] : "unknown error"));
 
-                fragmentShader = [fragmentShaderLibrary.get() newFunctionWithName:static_cast<NSString* _Nonnull>([NSString stringWithUTF8String:fragmentShaderFunction.c_str()])];
+                fragmentShader = [fragmentShaderLibrary.get() newFunctionWithName:static_cast<NSString* _Nonnull>([NSString stringWithUTF8String:fragmentShaderFunction])];
 
                 if (!fragmentShader || err != nil)
                     throw std::runtime_error("Failed to get function from shader, " + std::string(err ? [err.localizedDescription cStringUsingEncoding:NSUTF8StringEncoding] : "unknown error"));
@@ -180,11 +211,31 @@ namespace ouzel
                 if (!vertexShaderLibrary || err != nil)
                     throw std::runtime_error("Failed to load vertex shader, " + std::string(err ? [err.localizedDescription cStringUsingEncoding:NSUTF8StringEncoding] : "unknown error"));
 
-                vertexShader = [vertexShaderLibrary.get() newFunctionWithName:static_cast<NSString* _Nonnull>([NSString stringWithUTF8String:vertexShaderFunction.c_str()])];
+                vertexShader = [vertexShaderLibrary.get() newFunctionWithName:static_cast<NSString* _Nonnull>([NSString stringWithUTF8String:vertexShaderFunction])];
 
                 if (!vertexShader || err != nil)
                     throw std::runtime_error("Failed to get function from shader, " + std::string(err ? [err.localizedDescription cStringUsingEncoding:NSUTF8StringEncoding] : "unknown error"));
 
+                // the instanced vertex function is compiled from source, there is no offline compiled library for it
+                if (!instancedVertexShaderSource.empty())
+                {
+                    Pointer<NSString*> instancedVertexShaderString = [[NSString alloc] initWithBytes:instancedVertexShaderSource.data()
+                                                                                              length:instancedVertexShaderSource.size()
+                                                                                            encoding:NSUTF8StringEncoding];
+
+                    Pointer<id<MTLLibrary>> instancedVertexShaderLibrary = [renderDevice.getDevice().get() newLibraryWithSource:instancedVertexShaderString.get()
+                                                                                                                       options:nil
+                                                                                                                         error:&err];
+
+                    if (!instancedVertexShaderLibrary)
+                        throw std::runtime_error("Failed to compile instanced vertex shader, " + std::string(err ? [err.localizedDescription cStringUsingEncoding:NSUTF8StringEncoding] : "unknown error"));
+
+                    instancedVertexShader = [instancedVertexShaderLibrary.get() newFunctionWithName:static_cast<NSString* _Nonnull>([NSString stringWithUTF8String:vertexShaderFunction])];
+
+                    if (!instancedVertexShader)
+                        throw std::runtime_error("Failed to get function from instanced vertex shader");
+                }
+
                 if (!vertexShaderConstantInfo.empty())
                 {
                     vertexShaderConstantLocations.reserve(vertexShaderConstantInfo.size());
@@ -26,6 +26,7 @@ typedef NSUInteger MTLLoadAction;
 #include <tuple>
 #include "graphics/metal/MetalRenderResource.hpp"
 #include "graphics/metal/MetalPointer.hpp"
+#include "graphics/Commands.hpp"
 #include "graphics/PixelFormat.hpp"
 #include "graphics/SamplerAddressMode.hpp"
 #include "graphics/SamplerFilter.hpp"
@@ -60,13 +61,14 @@ namespace ouzel
             {
             public:
                 Texture(RenderDevice& initRenderDevice,
-                        const std::vector<std::pair<Size2U, std::vector<uint8_t>>>& levels,
+                        Span<const TextureLevel> levels,
                         TextureType type,
                         uint32_t initFlags = 0,
                         uint32_t initSampleCount = 1,
                         PixelFormat initPixelFormat = PixelFormat::RGBA8UNorm);
 
-                void setData(const std::vector<std::pair<Size2U, std::vector<uint8_t>>>& levels);
+                void setData(Span<const TextureLevel> levels);
+                void setRegionData(uint32_t x, uint32_t y, const Size2U& regionSize, Span<const uint8_t> data);
                 void setFilter(SamplerFilter filter);
                 void setAddressX(SamplerAddressMode addressX);
                 void setAddressY(SamplerAddressMode addressY);
@@ -96,7 +96,7 @@ namespace ouzel
             }
 
             Texture::Texture(RenderDevice& initRenderDevice,
-                             const std::vector<std::pair<Size2U, std::vector<uint8_t>>>& levels,
+                             Span<const TextureLevel> levels,
                              TextureType type,
                              uint32_t initFlags,
                              uint32_t initSampleCount,
@@ -115,8 +115,8 @@ namespace ouzel
                 if (pixelFormat == MTLPixelFormatInvalid)
                     throw std::runtime_error("Invalid pixel format");
 
-                width = static_cast<NSUInteger>(levels.front().first.v[0]);
-                height = static_cast<NSUInteger>(levels.front().first.v[1]);
+                width = static_cast<NSUInteger>(levels[0].size.v[0]);
+                height = static_cast<NSUInteger>(levels[0].size.v[1]);
 
                 if (!width || !height)
                     throw std::runtime_error("Invalid texture size");
@@ -176,13 +176,13 @@ namespace ouzel
                 {
                     for (size_t level = 0; level < levels.size(); ++level)
                     {
-                        if (!levels[level].second.empty())
+                        if (!levels[level].data.empty())
                             [texture.get() replaceRegion:MTLRegionMake2D(0, 0,
-                                                                         static_cast<NSUInteger>(levels[level].first.v[0]),
-                                                                         static_cast<NSUInteger>(levels[level].first.v[1]))
+                                                                         static_cast<NSUInteger>(levels[level].size.v[0]),
+                                                                         static_cast<NSUInteger>(levels[level].size.v[1]))
                                              mipmapLevel:level
-                                               withBytes:levels[level].second.data()
-                                             bytesPerRow:static_cast<NSUInteger>(levels[level].first.v[0] * pixelSize)];
+                                               withBytes:levels[level].data.data()
+                                             bytesPerRow:static_cast<NSUInteger>(levels[level].size.v[0] * pixelSize)];
                     }
                 }
 
@@ -195,7 +195,7 @@ namespace ouzel
                 updateSamplerState();
             }
 
-            void Texture::setData(const std::vector<std::pair<Size2U, std::vector<uint8_t>>>& levels)
+            void Texture::setData(Span<const TextureLevel> levels)
             {
                 if (!(flags & Flags::Dynamic) ||
                     flags & Flags::BindRenderTarget)
@@ -203,16 +203,31 @@ namespace ouzel
 
                 for (size_t level = 0; level < levels.size(); ++level)
                 {
-                    if (!levels[level].second.empty())
+                    if (!levels[level].data.empty())
                         [texture.get() replaceRegion:MTLRegionMake2D(0, 0,
-                                                                     static_cast<NSUInteger>(levels[level].first.v[0]),
-                                                                     static_cast<NSUInteger>(levels[level].first.v[1]))
+                                                                     static_cast<NSUInteger>(levels[level].size.v[0]),
+                                                                     static_cast<NSUInteger>(levels[level].size.v[1]))
                                          mipmapLevel:level
-                                           withBytes:levels[level].second.data()
-                                         bytesPerRow:static_cast<NSUInteger>(levels[level].first.v[0] * pixelSize)];
+                                           withBytes:levels[level].data.data()
+                                         bytesPerRow:static_cast<NSUInteger>(levels[level].size.v[0] * pixelSize)];
                 }
             }
 
+            void Texture::setRegionData(uint32_t x, uint32_t y, const Size2U& regionSize, Span<const uint8_t> data)
+            {
+                if (!(flags & Flags::Dynamic) ||
+                    flags & Flags::BindRenderTarget)
+                    throw std::runtime_error("Texture is not dynamic");
+
+                [texture.get() replaceRegion:MTLRegionMake2D(static_cast<NSUInteger>(x),
+                                                             static_cast<NSUInteger>(y),
+                                                             static_cast<NSUInteger>(regionSize.v[0]),
+                                                             static_cast<NSUInteger>(regionSize.v[1]))
+                                 mipmapLevel:0
+                                   withBytes:data.data()
+                                 bytesPerRow:static_cast<NSUInteger>(regionSize.v[0] * pixelSize)];
+            }
+
             void Texture::setFilter(SamplerFilter filter)
             {
                 samplerDescriptor.filter = filter;
@@ -58,7 +58,7 @@ namespace ouzel
             {
                 running = false;
                 CommandBuffer commandBuffer;
-                commandBuffer.pushCommand(std::make_unique<PresentCommand>());
+                commandBuffer.pushCommand<PresentCommand>();
                 submitCommandBuffer(std::move(commandBuffer));
 
                 if (displayLink)
@@ -144,7 +144,7 @@ namespace ouzel
                         running = false;
 
                         CommandBuffer commandBuffer;
-                        commandBuffer.pushCommand(std::make_unique<PresentCommand>());
+                        commandBuffer.pushCommand<PresentCommand>();
                         submitCommandBuffer(std::move(commandBuffer));
 
                         if (displayLink)
@@ -16,12 +16,12 @@ namespace ouzel
             Buffer::Buffer(RenderDevice& initRenderDevice,
                            BufferType initType,
                            uint32_t initFlags,
-                           const std::vector<uint8_t>& initData,
+                           Span<const uint8_t> initData,
                            uint32_t initSize):
                 RenderResource(initRenderDevice),
                 type(initType),
                 flags(initFlags),
-                data(initData),
+                data(initData.begin(), initData.end()),
                 size(static_cast<GLsizeiptr>(initSize))
             {
                 createBuffer();
@@ -74,7 +74,7 @@ namespace ouzel
                 }
             }
 
-            void Buffer::setData(const std::vector<uint8_t>& newData)
+            void Buffer::setData(Span<const uint8_t> newData)
             {
                 if (!(flags & Flags::Dynamic))
                     throw std::runtime_error("Buffer is not dynamic");
@@ -82,31 +82,37 @@ namespace ouzel
                 if (newData.empty())
                     throw std::invalid_argument("Data is empty");
 
-                data = newData;
+                // the copy is only needed to restore the buffer after the context is lost
+                if (!(flags & Flags::Transient))
+                    data.assign(newData.begin(), newData.end());
 
                 if (!bufferId)
                     throw std::runtime_error("Buffer not initialized");
 
                 renderDevice.bindBuffer(bufferType, bufferId);
 
-                if (static_cast<GLsizeiptr>(data.size()) > size)
+                const auto dataSize = static_cast<GLsizeiptr>(newData.size());
+
+                if (dataSize > size)
                 {
-                    size = static_cast<GLsizeiptr>(data.size());
+                    size = dataSize;
 
-                    renderDevice.glBufferDataProc(bufferType, size, data.data(), GL_DYNAMIC_DRAW);
+                    renderDevice.glBufferDataProc(bufferType, size, newData.data(), GL_DYNAMIC_DRAW);
 
                     GLenum error;
 
-                    if ((error = renderDevice.glGetErrorProc()) != GL_NO_ERROR)
+                    if (renderDevice.isDebugRenderer() && (error = renderDevice.glGetErrorProc()) != GL_NO_ERROR)
                         throw std::system_error(makeErrorCode(error), "Failed to create buffer");
                 }
                 else
                 {
-                    renderDevice.glBufferSubDataProc(bufferType, 0, static_cast<GLsizeiptr>(data.size()), data.data());
+                    // orphan the storage, so that the driver does not wait for the draw calls that still use the previous data
+                    renderDevice.glBufferDataProc(bufferType, size, nullptr, GL_DYNAMIC_DRAW);
+                    renderDevice.glBufferSubDataProc(bufferType, 0, dataSize, newData.data());
 
                     GLenum error;
 
-                    if ((error = renderDevice.glGetErrorProc()) != GL_NO_ERROR)
+                    if (renderDevice.isDebugRenderer() && (error = renderDevice.glGetErrorProc()) != GL_NO_ERROR)
                         throw std::system_error(makeErrorCode(error), "Failed to upload buffer");
                 }
             }
@@ -21,6 +21,7 @@
 
 #include "graphics/opengl/OGLRenderResource.hpp"
 #include "graphics/BufferType.hpp"
+#include "utils/Span.hpp"
 
 namespace ouzel
 {
@@ -36,13 +37,13 @@ namespace ouzel
                 Buffer(RenderDevice& initRenderDevice,
                        BufferType initType,
                        uint32_t initFlags,
-                       const std::vector<uint8_t>& initData,
+                       Span<const uint8_t> initData,
                        uint32_t initSize);
                 ~Buffer();
 
                 void reload() final;
 
-                void setData(const std::vector<uint8_t>& newData);
+                void setData(Span<const uint8_t> newData);
 
                 inline auto getFlags() const noexcept { return flags; }
                 inline auto getType() const noexcept { return type; }
@@ -10,6 +10,8 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cstddef>
+#include <cstring>
 #include <stdexcept>
 
 #include "graphics/opengl/OGL.h"
@@ -332,6 +334,11 @@ namespace ouzel
                 return std::error_code(static_cast<int>(e), errorCategory);
             }
 
+            constexpr GLuint RenderDevice::INSTANCE_ATTRIBUTE_LOCATION;
+            constexpr GLuint RenderDevice::FRAGMENT_UNIFORM_BLOCK_BINDING;
+            constexpr GLuint RenderDevice::VERTEX_UNIFORM_BLOCK_BINDING;
+            constexpr GLuint RenderDevice::INSTANCED_FRAGMENT_UNIFORM_BLOCK_BINDING;
+
             RenderDevice::RenderDevice(const std::function<void(const Event&)>& initCallback):
                 graphics::RenderDevice(Driver::OpenGL, initCallback),
                 textureBaseLevelSupported(false),
@@ -351,7 +358,13 @@ namespace ouzel
 
             RenderDevice::~RenderDevice()
             {
+                for (const auto& vertexArray : vertexArrays)
+                    glDeleteVertexArraysProc(1, &vertexArray.second);
+
                 if (vertexArrayId) glDeleteVertexArraysProc(1, &vertexArrayId);
+                if (instanceBufferId) glDeleteBuffersProc(1, &instanceBufferId);
+                if (uniformBufferId) glDeleteBuffersProc(1, &uniformBufferId);
+                if (immediateUniformBufferId) glDeleteBuffersProc(1, &immediateUniformBufferId);
 
                 resources.clear();
             }
@@ -548,7 +561,7 @@ namespace ouzel
                         extensions = explodeString(std::string(reinterpret_cast<const char*>(extensionsPtr)), ' ');
                 }
 
-                engine->log(Log::Level::All) << "Supported OpenGL extensions: " << extensions;
+                engine->log<Log::Level::All>() << "Supported OpenGL extensions: " << extensions;
 
                 textureBaseLevelSupported = false;
                 textureMaxLevelSupported = false;
@@ -587,6 +600,30 @@ namespace ouzel
                     glUniform3uivProc = getExtProcAddress<PFNGLUNIFORM3UIVPROC>("glUniform3uiv");
                     glUniform4uivProc = getExtProcAddress<PFNGLUNIFORM4UIVPROC>("glUniform4uiv");
 
+#if OUZEL_OPENGLES
+                    glDrawElementsInstancedProc = getExtProcAddress<PFNGLDRAWELEMENTSINSTANCEDPROC>("glDrawElementsInstanced");
+                    glVertexAttribDivisorProc = getExtProcAddress<PFNGLVERTEXATTRIBDIVISORPROC>("glVertexAttribDivisor");
+#else
+                    if (isVersionGreaterOrEqual(apiMajorVersion, apiMinorVersion, 3, 1)) // at least OpenGL 3.1
+                        glDrawElementsInstancedProc = getExtProcAddress<PFNGLDRAWELEMENTSINSTANCEDPROC>("glDrawElementsInstanced");
+
+                    if (isVersionGreaterOrEqual(apiMajorVersion, apiMinorVersion, 3, 3)) // at least OpenGL 3.3
+                        glVertexAttribDivisorProc = getExtProcAddress<PFNGLVERTEXATTRIBDIVISORPROC>("glVertexAttribDivisor");
+#endif
+
+#if !OUZEL_OPENGLES
+                    if (isVersionGreaterOrEqual(apiMajorVersion, apiMinorVersion, 3, 1)) // at least OpenGL 3.1
+#endif
+                    {
+                        glGetUniformBlockIndexProc = getExtProcAddress<PFNGLGETUNIFORMBLOCKINDEXPROC>("glGetUniformBlockIndex");
+                        glUniformBlockBindingProc = getExtProcAddress<PFNGLUNIFORMBLOCKBINDINGPROC>("glUniformBlockBinding");
+                        glGetActiveUniformBlockivProc = getExtProcAddress<PFNGLGETACTIVEUNIFORMBLOCKIVPROC>("glGetActiveUniformBlockiv");
+                        glGetUniformIndicesProc = getExtProcAddress<PFNGLGETUNIFORMINDICESPROC>("glGetUniformIndices");
+                        glGetActiveUniformsivProc = getExtProcAddress<PFNGLGETACTIVEUNIFORMSIVPROC>("glGetActiveUniformsiv");
+                        glBindBufferRangeProc = getExtProcAddress<PFNGLBINDBUFFERRANGEPROC>("glBindBufferRange");
+                        glBindBufferBaseProc = getExtProcAddress<PFNGLBINDBUFFERBASEPROC>("glBindBufferBase");
+                    }
+
 #if OUZEL_OPENGL_INTERFACE_EAGL
                     glGenVertexArraysProc = getExtProcAddress<PFNGLGENVERTEXARRAYSPROC>("glGenVertexArraysOES");
                     glBindVertexArrayProc = getExtProcAddress<PFNGLBINDVERTEXARRAYPROC>("glBindVertexArrayOES");
@@ -637,6 +674,8 @@ namespace ouzel
                     textureBaseLevelSupported = true;
                     textureMaxLevelSupported = true;
                     uintElementIndexSupported = true;
+
+                    glMultiDrawElementsProc = getExtProcAddress<PFNGLMULTIDRAWELEMENTSPROC>("glMultiDrawElements");
 #endif
                 }
 
@@ -693,6 +732,8 @@ namespace ouzel
 #  if !OUZEL_OPENGL_INTERFACE_EAGL
                     else if (extension == "GL_EXT_copy_image")
                         glCopyImageSubDataProc = getExtProcAddress<PFNGLCOPYIMAGESUBDATAEXTPROC>("glCopyImageSubDataEXT");
+                    else if (extension == "GL_EXT_multi_draw_arrays")
+                        glMultiDrawElementsProc = getExtProcAddress<PFNGLMULTIDRAWELEMENTSEXTPROC>("glMultiDrawElementsEXT");
                     else if (extension == "GL_EXT_multisampled_render_to_texture")
                     {
                         multisamplingSupported = true;
@@ -709,6 +750,16 @@ namespace ouzel
 #else // OpenGL
                     else if (extension == "GL_ARB_copy_image")
                         glCopyImageSubDataProc = getExtProcAddress<PFNGLCOPYIMAGESUBDATAPROC>("glCopyImageSubData");
+                    else if (extension == "GL_ARB_draw_instanced")
+                    {
+                        if (!glDrawElementsInstancedProc)
+                            glDrawElementsInstancedProc = getExtProcAddress<PFNGLDRAWELEMENTSINSTANCEDPROC>("glDrawElementsInstancedARB");
+                    }
+                    else if (extension == "GL_ARB_instanced_arrays")
+                    {
+                        if (!glVertexAttribDivisorProc)
+                            glVertexAttribDivisorProc = getExtProcAddress<PFNGLVERTEXATTRIBDIVISORPROC>("glVertexAttribDivisorARB");
+                    }
                     else if (extension == "GL_ARB_vertex_array_object")
                     {
                         glGenVertexArraysProc = getExtProcAddress<PFNGLGENVERTEXARRAYSPROC>("glGenVertexArrays");
@@ -768,12 +819,30 @@ namespace ouzel
                 {
                     glGenVertexArraysProc(1, &vertexArrayId);
 
-                    glBindVertexArrayProc(vertexArrayId);
+                    bindVertexArray(vertexArrayId);
 
                     if ((error = glGetErrorProc()) != GL_NO_ERROR)
                         throw std::system_error(makeErrorCode(error), "Failed to bind vertex array");
                 }
 
+                if (isInstancingSupported())
+                {
+                    glGenBuffersProc(1, &instanceBufferId);
+
+                    if ((error = glGetErrorProc()) != GL_NO_ERROR)
+                        throw std::system_error(makeErrorCode(error), "Failed to create instance buffer");
+                }
+
+                if (isUniformBufferSupported())
+                {
+                    glGetIntegervProc(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformBufferAlignment);
+                    glGenBuffersProc(1, &uniformBufferId);
+                    glGenBuffersProc(1, &immediateUniformBufferId);
+
+                    if ((error = glGetErrorProc()) != GL_NO_ERROR)
+                        throw std::system_error(makeErrorCode(error), "Failed to create uniform buffers");
+                }
+
                 setFrontFace(GL_CW);
             }
 
@@ -836,6 +905,414 @@ namespace ouzel
                 }
             }
 
+            void RenderDevice::setVertexAttributes()
+            {
+                GLuint vertexOffset = 0;
+
+                for (GLuint index = 0; index < RenderDevice::VERTEX_ATTRIBUTES.size(); ++index)
+                {
+                    const Vertex::Attribute& vertexAttribute = RenderDevice::VERTEX_ATTRIBUTES[index];
+
+                    glEnableVertexAttribArrayProc(index);
+                    glVertexAttribPointerProc(index,
+                                              getArraySize(vertexAttribute.dataType),
+                                              getVertexType(vertexAttribute.dataType),
+                                              isNormalized(vertexAttribute.dataType),
+                                              static_cast<GLsizei>(sizeof(Vertex)),
+                                              reinterpret_cast<void*>(static_cast<uintptr_t>(vertexOffset)));
+                    currentAPICallCount += 2;
+
+                    vertexOffset += getDataTypeSize(vertexAttribute.dataType);
+                }
+
+                GLenum error;
+                if (debugRenderer && (error = glGetErrorProc()) != GL_NO_ERROR)
+                    throw std::system_error(makeErrorCode(error), "Failed to update vertex attributes");
+            }
+
+            void RenderDevice::setUniform(const Shader::Location& location,
+                                          const float* data,
+                                          float* currentData,
+                                          size_t size)
+            {
+                // the program keeps the values of its uniforms, so the ones that did not change are not set again
+                if (std::memcmp(data, currentData, size * sizeof(float)) != 0)
+                {
+                    setUniform(location.location, location.dataType, data);
+                    ++currentAPICallCount;
+                    std::copy(data, data + size, currentData);
+                }
+            }
+
+            void RenderDevice::bindBuffers(const Buffer& indexBuffer, const Buffer& vertexBuffer)
+            {
+                if (vertexArrayId)
+                {
+                    // the vertex array object keeps the buffer bindings and the vertex attributes,
+                    // so they are set up only for the first draw call with the buffers
+                    const auto buffers = std::make_pair(vertexBuffer.getBufferId(), indexBuffer.getBufferId());
+                    auto vertexArrayIterator = vertexArrays.find(buffers);
+
+                    if (vertexArrayIterator != vertexArrays.end())
+                    {
+                        bindVertexArray(vertexArrayIterator->second);
+                        stateCache.bufferId[GL_ELEMENT_ARRAY_BUFFER] = indexBuffer.getBufferId();
+                    }
+                    else
+                    {
+                        GLuint newVertexArrayId;
+                        glGenVertexArraysProc(1, &newVertexArrayId);
+                        ++currentAPICallCount;
+                        vertexArrays[buffers] = newVertexArrayId;
+
+                        bindVertexArray(newVertexArrayId);
+
+                        // bindBuffer would switch back to the default vertex array
+                        glBindBufferProc(GL_ELEMENT_ARRAY_BUFFER, indexBuffer.getBufferId());
+                        ++currentAPICallCount;
+                        stateCache.bufferId[GL_ELEMENT_ARRAY_BUFFER] = indexBuffer.getBufferId();
+
+                        bindBuffer(GL_ARRAY_BUFFER, vertexBuffer.getBufferId());
+                        setVertexAttributes();
+
+                        GLenum error;
+                        if ((error = glGetErrorProc()) != GL_NO_ERROR)
+                            throw std::system_error(makeErrorCode(error), "Failed to create vertex array");
+                    }
+                }
+                else
+                {
+                    bindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer.getBufferId());
+                    bindBuffer(GL_ARRAY_BUFFER, vertexBuffer.getBufferId());
+                    setVertexAttributes();
+                }
+            }
+
+            void RenderDevice::drawElements(DrawMode drawMode,
+                                            uint32_t indexCount,
+                                            uint32_t indexSize,
+                                            uint32_t startIndex)
+            {
+                glDrawElementsProc(getDrawMode(drawMode),
+                                   static_cast<GLsizei>(indexCount),
+                                   getIndexType(indexSize),
+                                   reinterpret_cast<void*>(static_cast<uintptr_t>(startIndex * indexSize)));
+                ++currentAPICallCount;
+
+                GLenum error;
+                if (debugRenderer && (error = glGetErrorProc()) != GL_NO_ERROR)
+                    throw std::system_error(makeErrorCode(error), "Failed to draw elements");
+
+                ++currentDrawCallCount;
+            }
+
+            void RenderDevice::drawElementsInstanced(const Shader& shader,
+                                                     DrawMode drawMode,
+                                                     uint32_t indexCount,
+                                                     uint32_t indexSize,
+                                                     uint32_t startIndex,
+                                                     Span<const Instance> instances)
+            {
+                // the instances of every draw call are streamed to the same buffer, its previous storage is orphaned
+                bindBuffer(GL_ARRAY_BUFFER, instanceBufferId);
+                glBufferDataProc(GL_ARRAY_BUFFER,
+                                 static_cast<GLsizeiptr>(instances.size() * sizeof(Instance)),
+                                 instances.data(),
+                                 GL_STREAM_DRAW);
+                ++currentAPICallCount;
+
+                // the columns of the matrix followed by the color, they advance once per instance
+                for (GLuint column = 0; column < 4; ++column)
+                {
+                    const GLuint location = INSTANCE_ATTRIBUTE_LOCATION + column;
+                    const auto offset = offsetof(Instance, modelViewProjection) + column * 4 * sizeof(float);
+
+                    glEnableVertexAttribArrayProc(location);
+                    glVertexAttribPointerProc(location, 4, GL_FLOAT, GL_FALSE,
+                                              static_cast<GLsizei>(sizeof(Instance)),
+                                              reinterpret_cast<void*>(static_cast<uintptr_t>(offset)));
+                    glVertexAttribDivisorProc(location, 1);
+                }
+
+                glEnableVertexAttribArrayProc(INSTANCE_ATTRIBUTE_LOCATION + 4);
+                glVertexAttribPointerProc(INSTANCE_ATTRIBUTE_LOCATION + 4, 4, GL_FLOAT, GL_FALSE,
+                                          static_cast<GLsizei>(sizeof(Instance)),
+                                          reinterpret_cast<void*>(static_cast<uintptr_t>(offsetof(Instance, color))));
+                glVertexAttribDivisorProc(INSTANCE_ATTRIBUTE_LOCATION + 4, 1);
+                currentAPICallCount += 15;
+
+                useProgram(shader.getInstancedProgramId());
+
+                if (shader.getInstancedUniformBufferId())
+                {
+                    glBindBufferBaseProc(GL_UNIFORM_BUFFER, INSTANCED_FRAGMENT_UNIFORM_BLOCK_BINDING,
+                                         shader.getInstancedUniformBufferId());
+                    ++currentAPICallCount;
+                    stateCache.bufferId[GL_UNIFORM_BUFFER] = shader.getInstancedUniformBufferId();
+                }
+
+                glDrawElementsInstancedProc(getDrawMode(drawMode),
+                                            static_cast<GLsizei>(indexCount),
+                                            getIndexType(indexSize),
+                                            reinterpret_cast<void*>(static_cast<uintptr_t>(startIndex * indexSize)),
+                                            static_cast<GLsizei>(instances.size()));
+                ++currentAPICallCount;
+
+                GLenum error;
+                if (debugRenderer && (error = glGetErrorProc()) != GL_NO_ERROR)
+                    throw std::system_error(makeErrorCode(error), "Failed to draw instanced elements");
+
+                ++currentDrawCallCount;
+
+                // without vertex array objects the attributes stay enabled for the next draw calls
+                if (!vertexArrayId)
+                {
+                    for (GLuint location = INSTANCE_ATTRIBUTE_LOCATION; location < INSTANCE_ATTRIBUTE_LOCATION + 5; ++location)
+                        glDisableVertexAttribArrayProc(location);
+                    currentAPICallCount += 5;
+                }
+
+                useProgram(shader.getProgramId());
+            }
+
+            namespace
+            {
+                GLintptr appendUniformBlock(const Shader::UniformBlock& block,
+                                            Span<const float> constants,
+                                            GLint alignment,
+                                            std::vector<uint8_t>& data)
+                {
+                    if (!block.size || constants.empty()) return -1;
+
+                    const size_t offset = (data.size() + static_cast<size_t>(alignment) - 1) /
+                        static_cast<size_t>(alignment) * static_cast<size_t>(alignment);
+                    data.resize(offset + static_cast<size_t>(block.size));
+
+                    size_t constantOffset = 0;
+                    for (const Shader::UniformBlock::Member& member : block.members)
+                    {
+                        if (constantOffset == constants.size()) break;
+
+                        const size_t size = getDataTypeSize(member.dataType) / sizeof(float);
+
+                        if (constantOffset + size > constants.size())
+                            throw std::runtime_error("Invalid shader constant size");
+
+                        uint8_t* destination = data.data() + offset + member.offset;
+
+                        // the columns of the matrices are aligned to the matrix stride in the std140 layout
+                        if (member.matrixStride > 0)
+                        {
+                            const size_t columns = (member.dataType == DataType::FloatMatrix3) ? 3 : 4;
+                            const size_t rows = size / columns;
+
+                            for (size_t column = 0; column < columns; ++column)
+                                std::memcpy(destination + column * static_cast<size_t>(member.matrixStride),
+                                            constants.data() + constantOffset + column * rows,
+                                            rows * sizeof(float));
+                        }
+                        else
+                            std::memcpy(destination, constants.data() + constantOffset, size * sizeof(float));
+
+                        constantOffset += size;
+                    }
+
+                    if (constantOffset != constants.size())
+                        throw std::runtime_error("Invalid shader constant size");
+
+                    return static_cast<GLintptr>(offset);
+                }
+            }
+
+            void RenderDevice::packUniformBlocks(const CommandBuffer& commandBuffer)
+            {
+                uniformBufferData.clear();
+                uniformBlockRanges.clear();
+                uniformBlockRangeIndex = 0;
+                replacedResources.clear();
+
+                const Shader* shader = nullptr;
+
+                for (const Command* command = commandBuffer.peekCommand(); command; command = commandBuffer.peekCommand(command))
+                {
+                    if (command->type == Command::Type::DeleteResource)
+                        replacedResources.push_back(static_cast<const DeleteResourceCommand*>(command)->resource);
+                    else if (command->type == Command::Type::InitShader)
+                        replacedResources.push_back(static_cast<const InitShaderCommand*>(command)->shader);
+                    else if (command->type == Command::Type::SetPipelineState)
+                    {
+                        // shaders that are created or deleted by this command buffer are not known yet,
+                        // their constants are uploaded when the command is executed
+                        const uintptr_t resource = static_cast<const SetPipelineStateCommand*>(command)->shader;
+                        shader = (resource && resource <= resources.size() &&
+                                  std::find(replacedResources.begin(), replacedResources.end(), resource) == replacedResources.end()) ?
+                            getResource<Shader>(resource) : nullptr;
+                    }
+                    else if (command->type == Command::Type::SetShaderConstants)
+                    {
+                        UniformBlockRange range;
+
+                        if (shader && (shader->getFragmentUniformBlock().size || shader->getVertexUniformBlock().size))
+                        {
+                            auto setShaderConstantsCommand = static_cast<const SetShaderConstantsCommand*>(command);
+                            range = appendUniformBlocks(*shader,
+                                                        commandBuffer.getConstants(setShaderConstantsCommand->fragmentShaderConstants),
+                                                        commandBuffer.getConstants(setShaderConstantsCommand->vertexShaderConstants),
+                                                        uniformBufferData);
+                            range.packed = true;
+                        }
+
+                        uniformBlockRanges.push_back(range);
+                    }
+                }
+
+                if (!uniformBufferData.empty())
+                {
+                    // the previous storage of the buffer is orphaned, so the upload does not wait for the previous frame
+                    bindBuffer(GL_UNIFORM_BUFFER, uniformBufferId);
+                    glBufferDataProc(GL_UNIFORM_BUFFER,
+                                     static_cast<GLsizeiptr>(uniformBufferData.size()),
+                                     uniformBufferData.data(),
+                                     GL_STREAM_DRAW);
+                    ++currentAPICallCount;
+
+                    GLenum error;
+                    if (debugRenderer && (error = glGetErrorProc()) != GL_NO_ERROR)
+                        throw std::system_error(makeErrorCode(error), "Failed to upload uniform buffer data");
+                }
+            }
+
+            RenderDevice::UniformBlockRange RenderDevice::appendUniformBlocks(const Shader& shader,
+                                                                               Span<const float> fragmentShaderConstants,
+                                                                               Span<const float> vertexShaderConstants,
+                                                                               std::vector<uint8_t>& data) const
+            {
+                UniformBlockRange range;
+                range.fragmentOffset = appendUniformBlock(shader.getFragmentUniformBlock(),
+                                                          fragmentShaderConstants,
+                                                          uniformBufferAlignment,
+                                                          data);
+                range.vertexOffset = appendUniformBlock(shader.getVertexUniformBlock(),
+                                                        vertexShaderConstants,
+                                                        uniformBufferAlignment,
+                                                        data);
+                return range;
+            }
+
+            void RenderDevice::bindUniformBlocks(const Shader& shader,
+                                                 GLuint bufferId,
+                                                 const UniformBlockRange& range)
+            {
+                if (range.fragmentOffset != -1)
+                {
+                    glBindBufferRangeProc(GL_UNIFORM_BUFFER, FRAGMENT_UNIFORM_BLOCK_BINDING, bufferId,
+                                          range.fragmentOffset, shader.getFragmentUniformBlock().size);
+                    ++currentAPICallCount;
+                }
+
+                if (range.vertexOffset != -1)
+                {
+                    glBindBufferRangeProc(GL_UNIFORM_BUFFER, VERTEX_UNIFORM_BLOCK_BINDING, bufferId,
+                                          range.vertexOffset, shader.getVertexUniformBlock().size);
+                    ++currentAPICallCount;
+                }
+
+                // binding a range binds the buffer to the generic binding point too
+                if (range.fragmentOffset != -1 || range.vertexOffset != -1)
+                    stateCache.bufferId[GL_UNIFORM_BUFFER] = bufferId;
+
+                GLenum error;
+                if (debugRenderer && (error = glGetErrorProc()) != GL_NO_ERROR)
+                    throw std::system_error(makeErrorCode(error), "Failed to bind uniform buffer range");
+            }
+
+            void RenderDevice::setShaderConstants(Shader& shader,
+                                                  Span<const float> fragmentShaderConstants,
+                                                  Span<const float> vertexShaderConstants,
+                                                  const UniformBlockRange* packedRange)
+            {
+                const bool fragmentUniformBlock = shader.getFragmentUniformBlock().size != 0;
+                const bool vertexUniformBlock = shader.getVertexUniformBlock().size != 0;
+
+                if (packedRange)
+                    bindUniformBlocks(shader, uniformBufferId, *packedRange);
+                else if (fragmentUniformBlock || vertexUniformBlock)
+                {
+                    // constants that were not packed with the command buffer get an upload of their own
+                    immediateUniformBufferData.clear();
+                    const UniformBlockRange range = appendUniformBlocks(shader,
+                                                                        fragmentShaderConstants,
+                                                                        vertexShaderConstants,
+                                                                        immediateUniformBufferData);
+
+                    if (!immediateUniformBufferData.empty())
+                    {
+                        bindBuffer(GL_UNIFORM_BUFFER, immediateUniformBufferId);
+                        glBufferDataProc(GL_UNIFORM_BUFFER,
+                                         static_cast<GLsizeiptr>(immediateUniformBufferData.size()),
+                                         immediateUniformBufferData.data(),
+                                         GL_STREAM_DRAW);
+                        ++currentAPICallCount;
+
+                        bindUniformBlocks(shader, immediateUniformBufferId, range);
+                    }
+                }
+
+                if (!fragmentUniformBlock)
+                {
+                    // pixel shader constants
+                    const std::vector<Shader::Location>& fragmentShaderConstantLocations = shader.getFragmentShaderConstantLocations();
+                    std::vector<float>& currentFragmentShaderConstants = shader.getFragmentShaderConstants();
+
+                    size_t offset = 0;
+                    for (const Shader::Location& fragmentShaderConstantLocation : fragmentShaderConstantLocations)
+                    {
+                        if (offset == fragmentShaderConstants.size()) break;
+
+                        const size_t size = getDataTypeSize(fragmentShaderConstantLocation.dataType) / sizeof(float);
+
+                        if (offset + size > fragmentShaderConstants.size())
+                            throw std::runtime_error("Invalid pixel shader constant size");
+
+                        setUniform(fragmentShaderConstantLocation,
+                                   fragmentShaderConstants.data() + offset,
+                                   currentFragmentShaderConstants.data() + offset,
+                                   size);
+                        offset += size;
+                    }
+
+                    if (offset != fragmentShaderConstants.size())
+                        throw std::runtime_error("Invalid pixel shader constant size");
+                }
+
+                if (!vertexUniformBlock)
+                {
+                    // vertex shader constants
+                    const std::vector<Shader::Location>& vertexShaderConstantLocations = shader.getVertexShaderConstantLocations();
+                    std::vector<float>& currentVertexShaderConstants = shader.getVertexShaderConstants();
+
+                    size_t offset = 0;
+                    for (const Shader::Location& vertexShaderConstantLocation : vertexShaderConstantLocations)
+                    {
+                        if (offset == vertexShaderConstants.size()) break;
+
+                        const size_t size = getDataTypeSize(vertexShaderConstantLocation.dataType) / sizeof(float);
+
+                        if (offset + size > vertexShaderConstants.size())
+                            throw std::runtime_error("Invalid vertex shader constant size");
+
+                        setUniform(vertexShaderConstantLocation,
+                                   vertexShaderConstants.data() + offset,
+                                   currentVertexShaderConstants.data() + offset,
+                                   size);
+                        offset += size;
+                    }
+
+                    if (offset != vertexShaderConstants.size())
+                        throw std::runtime_error("Invalid vertex shader constant size");
+                }
+            }
+
             void RenderDevice::process()
             {
                 graphics::RenderDevice::process();
@@ -845,15 +1322,14 @@ namespace ouzel
                 Shader* currentShader = nullptr;
 
                 CommandBuffer commandBuffer;
-                std::unique_ptr<Command> command;
+                const Command* command;
 
                 for (;;)
                 {
-                    std::unique_lock<std::mutex> lock(commandQueueMutex);
-                    while (commandQueue.empty()) commandQueueCondition.wait(lock);
-                    commandBuffer = std::move(commandQueue.front());
-                    commandQueue.pop();
-                    lock.unlock();
+                    waitForCommandBuffer(commandBuffer);
+
+                    if (isUniformBufferSupported())
+                        packUniformBlocks(commandBuffer);
 
                     while (!commandBuffer.isEmpty())
                     {
@@ -863,7 +1339,7 @@ namespace ouzel
                         {
                             case Command::Type::Resize:
                             {
-                                auto resizeCommand = static_cast<const ResizeCommand*>(command.get());
+                                auto resizeCommand = static_cast<const ResizeCommand*>(command);
                                 frameBufferWidth = static_cast<GLsizei>(resizeCommand->size.v[0]);
                                 frameBufferHeight = static_cast<GLsizei>(resizeCommand->size.v[1]);
                                 resizeFrameBuffer();
@@ -878,14 +1354,14 @@ namespace ouzel
 
                             case Command::Type::DeleteResource:
                             {
-                                auto deleteResourceCommand = static_cast<const DeleteResourceCommand*>(command.get());
+                                auto deleteResourceCommand = static_cast<const DeleteResourceCommand*>(command);
                                 resources[deleteResourceCommand->resource - 1].reset();
                                 break;
                             }
 
                             case Command::Type::InitRenderTarget:
                             {
-                                auto initRenderTargetCommand = static_cast<const InitRenderTargetCommand*>(command.get());
+                                auto initRenderTargetCommand = static_cast<const InitRenderTargetCommand*>(command);
 
                                 std::set<Texture*> colorTextures;
                                 for (const uintptr_t colorTextureId : initRenderTargetCommand->colorTextures)
@@ -903,7 +1379,7 @@ namespace ouzel
 
                             case Command::Type::SetRenderTarget:
                             {
-                                auto setRenderTargetCommand = static_cast<const SetRenderTargetCommand*>(command.get());
+                                auto setRenderTargetCommand = static_cast<const SetRenderTargetCommand*>(command);
 
                                 if (setRenderTargetCommand->renderTarget)
                                 {
@@ -924,7 +1400,7 @@ namespace ouzel
 
                             case Command::Type::ClearRenderTarget:
                             {
-                                auto clearCommand = static_cast<const ClearRenderTargetCommand*>(command.get());
+                                auto clearCommand = static_cast<const ClearRenderTargetCommand*>(command);
 
                                 const GLbitfield clearMask = (clearCommand->clearColorBuffer ? GL_COLOR_BUFFER_BIT : 0) |
                                     (clearCommand->clearDepthBuffer ? GL_DEPTH_BUFFER_BIT : 0 |
@@ -980,7 +1456,7 @@ namespace ouzel
                             case Command::Type::Blit:
                             {
 #if !OUZEL_OPENGLES
-                                auto blitCommand = static_cast<const BlitCommand*>(command.get());
+                                auto blitCommand = static_cast<const BlitCommand*>(command);
 
                                 Texture* sourceTexture = getResource<Texture>(blitCommand->sourceTexture);
                                 Texture* destinationTexture = getResource<Texture>(blitCommand->destinationTexture);
@@ -1008,7 +1484,7 @@ namespace ouzel
 
                             case Command::Type::SetScissorTest:
                             {
-                                auto setScissorTestCommand = static_cast<const SetScissorTestCommand*>(command.get());
+                                auto setScissorTestCommand = static_cast<const SetScissorTestCommand*>(command);
 
                                 setScissorTest(setScissorTestCommand->enabled,
                                                static_cast<GLint>(setScissorTestCommand->rectangle.position.v[0]),
@@ -1021,7 +1497,7 @@ namespace ouzel
 
                             case Command::Type::SetViewport:
                             {
-                                auto setViewportCommand = static_cast<const SetViewportCommand*>(command.get());
+                                auto setViewportCommand = static_cast<const SetViewportCommand*>(command);
 
                                 setViewport(static_cast<GLint>(setViewportCommand->viewport.position.v[0]),
                                             static_cast<GLint>(setViewportCommand->viewport.position.v[1]),
@@ -1033,7 +1509,7 @@ namespace ouzel
 
                             case Command::Type::InitDepthStencilState:
                             {
-                                auto initDepthStencilStateCommand = static_cast<const InitDepthStencilStateCommand*>(command.get());
+                                auto initDepthStencilStateCommand = static_cast<const InitDepthStencilStateCommand*>(command);
                                 auto depthStencilState = std::make_unique<DepthStencilState>(*this,
                                                                                              initDepthStencilStateCommand->depthTest,
                                                                                              initDepthStencilStateCommand->depthWrite,
@@ -1058,7 +1534,7 @@ namespace ouzel
 
                             case Command::Type::SetDepthStencilState:
                             {
-                                auto setDepthStencilStateCommand = static_cast<const SetDepthStencilStateCommand*>(command.get());
+                                auto setDepthStencilStateCommand = static_cast<const SetDepthStencilStateCommand*>(command);
 
                                 if (setDepthStencilStateCommand->depthStencilState)
                                 {
@@ -1066,7 +1542,7 @@ namespace ouzel
 
                                     enableDepthTest(depthStencilState->getDepthTest());
                                     setDepthMask(depthStencilState->getDepthMask());
-                                    glDepthFuncProc(depthStencilState->getCompareFunction());
+                                    setDepthFunc(depthStencilState->getCompareFunction());
                                     enableStencilTest(depthStencilState->getStencilTest());
                                     setStencilMask(depthStencilState->getStencilWriteMask());
                                     glStencilOpSeparateProc(GL_FRONT,
@@ -1085,6 +1561,7 @@ namespace ouzel
                                                               depthStencilState->getBackFaceFunction(),
                                                               static_cast<GLint>(setDepthStencilStateCommand->stencilReferenceValue),
                                                               depthStencilState->getStencilReadMask());
+                                    currentAPICallCount += 4;
                                 }
                                 else
                                 {
@@ -1096,7 +1573,7 @@ namespace ouzel
                                 }
 
                                 GLenum error;
-                                if ((error = glGetErrorProc()) != GL_NO_ERROR)
+                                if (debugRenderer && (error = glGetErrorProc()) != GL_NO_ERROR)
                                     throw std::system_error(makeErrorCode(error), "Failed to update depth stencil state");
 
                                 break;
@@ -1104,7 +1581,7 @@ namespace ouzel
 
                             case Command::Type::SetPipelineState:
                             {
-                                auto setPipelineStateCommand = static_cast<const SetPipelineStateCommand*>(command.get());
+                                auto setPipelineStateCommand = static_cast<const SetPipelineStateCommand*>(command);
 
                                 BlendState* blendState = getResource<BlendState>(setPipelineStateCommand->blendState);
                                 Shader* shader = getResource<Shader>(setPipelineStateCommand->shader);
@@ -1154,7 +1631,7 @@ namespace ouzel
 
                             case Command::Type::Draw:
                             {
-                                auto drawCommand = static_cast<const DrawCommand*>(command.get());
+                                auto drawCommand = static_cast<const DrawCommand*>(command);
 
                                 // mesh buffer
                                 Buffer* indexBuffer = getResource<Buffer>(drawCommand->indexBuffer);
@@ -1166,49 +1643,118 @@ namespace ouzel
                                 assert(vertexBuffer->getBufferId());
 
                                 // draw
-                                bindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer->getBufferId());
-                                bindBuffer(GL_ARRAY_BUFFER, vertexBuffer->getBufferId());
+                                bindBuffers(*indexBuffer, *vertexBuffer);
 
-                                GLuint vertexOffset = 0;
+                                assert(drawCommand->indexCount);
+                                assert(indexBuffer->getSize());
+                                assert(vertexBuffer->getSize());
 
-                                for (GLuint index = 0; index < RenderDevice::VERTEX_ATTRIBUTES.size(); ++index)
-                                {
-                                    const Vertex::Attribute& vertexAttribute = RenderDevice::VERTEX_ATTRIBUTES[index];
+                                drawElements(drawCommand->drawMode,
+                                             drawCommand->indexCount,
+                                             drawCommand->indexSize,
+                                             drawCommand->startIndex);
+
+                                break;
+                            }
 
-                                    glEnableVertexAttribArrayProc(index);
-                                    glVertexAttribPointerProc(index,
-                                                              getArraySize(vertexAttribute.dataType),
-                                                              getVertexType(vertexAttribute.dataType),
-                                                              isNormalized(vertexAttribute.dataType),
-                                                              static_cast<GLsizei>(sizeof(Vertex)),
-                                                              reinterpret_cast<void*>(static_cast<uintptr_t>(vertexOffset)));
+                            case Command::Type::DrawInstanced:
+                            {
+                                auto drawInstancedCommand = static_cast<const DrawInstancedCommand*>(command);
+
+                                if (!currentShader)
+                                    throw std::runtime_error("No shader set");
 
-                                    vertexOffset += getDataTypeSize(vertexAttribute.dataType);
+                                // mesh buffer
+                                Buffer* indexBuffer = getResource<Buffer>(drawInstancedCommand->indexBuffer);
+                                Buffer* vertexBuffer = getResource<Buffer>(drawInstancedCommand->vertexBuffer);
+
+                                assert(indexBuffer);
+                                assert(indexBuffer->getBufferId());
+                                assert(vertexBuffer);
+                                assert(vertexBuffer->getBufferId());
+
+                                bindBuffers(*indexBuffer, *vertexBuffer);
+
+                                if (drawInstancedCommand->instances.empty()) break;
+
+                                if (currentShader->getInstancedProgramId())
+                                    drawElementsInstanced(*currentShader,
+                                                          drawInstancedCommand->drawMode,
+                                                          drawInstancedCommand->indexCount,
+                                                          drawInstancedCommand->indexSize,
+                                                          drawInstancedCommand->startIndex,
+                                                          drawInstancedCommand->instances);
+                                else
+                                {
+                                    // shaders without an instanced vertex shader take the transform and the color as uniforms,
+                                    // so the instances are drawn one by one and only the uniforms that differ are set
+                                    for (const Instance& instance : drawInstancedCommand->instances)
+                                    {
+                                        setShaderConstants(*currentShader, instance.color, instance.modelViewProjection);
+
+                                        drawElements(drawInstancedCommand->drawMode,
+                                                     drawInstancedCommand->indexCount,
+                                                     drawInstancedCommand->indexSize,
+                                                     drawInstancedCommand->startIndex);
+                                    }
                                 }
 
-                                GLenum error;
-                                if ((error = glGetErrorProc()) != GL_NO_ERROR)
-                                    throw std::system_error(makeErrorCode(error), "Failed to update vertex attributes");
+                                break;
+                            }
 
-                                assert(drawCommand->indexCount);
-                                assert(indexBuffer->getSize());
-                                assert(vertexBuffer->getSize());
+                            case Command::Type::MultiDraw:
+                            {
+                                auto multiDrawCommand = static_cast<const MultiDrawCommand*>(command);
+
+                                // mesh buffer
+                                Buffer* indexBuffer = getResource<Buffer>(multiDrawCommand->indexBuffer);
+                                Buffer* vertexBuffer = getResource<Buffer>(multiDrawCommand->vertexBuffer);
+
+                                assert(indexBuffer);
+                                assert(indexBuffer->getBufferId());
+                                assert(vertexBuffer);
+                                assert(vertexBuffer->getBufferId());
+
+                                bindBuffers(*indexBuffer, *vertexBuffer);
+
+                                if (glMultiDrawElementsProc)
+                                {
+                                    multiDrawCounts.clear();
+                                    multiDrawOffsets.clear();
+
+                                    for (const DrawRange& range : multiDrawCommand->ranges)
+                                    {
+                                        multiDrawCounts.push_back(static_cast<GLsizei>(range.indexCount));
+                                        multiDrawOffsets.push_back(reinterpret_cast<const void*>(static_cast<uintptr_t>(range.startIndex * multiDrawCommand->indexSize)));
+                                    }
 
-                                glDrawElementsProc(getDrawMode(drawCommand->drawMode),
-                                                   static_cast<GLsizei>(drawCommand->indexCount),
-                                                   getIndexType(drawCommand->indexSize),
-                                                   reinterpret_cast<void*>(static_cast<uintptr_t>(drawCommand->startIndex * drawCommand->indexSize)));
+                                    glMultiDrawElementsProc(getDrawMode(multiDrawCommand->drawMode),
+                                                            multiDrawCounts.data(),
+                                                            getIndexType(multiDrawCommand->indexSize),
+                                                            multiDrawOffsets.data(),
+                                                            static_cast<GLsizei>(multiDrawCounts.size()));
+                                    ++currentAPICallCount;
+
+                                    GLenum error;
+                                    if (debugRenderer && (error = glGetErrorProc()) != GL_NO_ERROR)
+                                        throw std::system_error(makeErrorCode(error), "Failed to draw elements");
 
-                                if ((error = glGetErrorProc()) != GL_NO_ERROR)
-                                    throw std::system_error(makeErrorCode(error), "Failed to draw elements");
+                                    ++currentDrawCallCount;
+                                }
+                                else
+                                    for (const DrawRange& range : multiDrawCommand->ranges)
+                                        drawElements(multiDrawCommand->drawMode,
+                                                     range.indexCount,
+                                                     multiDrawCommand->indexSize,
+                                                     range.startIndex);
 
                                 break;
                             }
 
                             case Command::Type::PushDebugMarker:
                             {
-                                auto pushDebugMarkerCommand = static_cast<const PushDebugMarkerCommand*>(command.get());
-                                if (glPushGroupMarkerEXTProc) glPushGroupMarkerEXTProc(0, pushDebugMarkerCommand->name.c_str());
+                                auto pushDebugMarkerCommand = static_cast<const PushDebugMarkerCommand*>(command);
+                                if (glPushGroupMarkerEXTProc) glPushGroupMarkerEXTProc(0, pushDebugMarkerCommand->name);
                                 break;
                             }
 
@@ -1220,7 +1766,7 @@ namespace ouzel
 
                             case Command::Type::InitBlendState:
                             {
-                                auto initBlendStateCommand = static_cast<const InitBlendStateCommand*>(command.get());
+                                auto initBlendStateCommand = static_cast<const InitBlendStateCommand*>(command);
 
                                 auto blendState = std::make_unique<BlendState>(*this,
                                                                                initBlendStateCommand->enableBlending,
@@ -1240,7 +1786,7 @@ namespace ouzel
 
                             case Command::Type::InitBuffer:
                             {
-                                auto initBufferCommand = static_cast<const InitBufferCommand*>(command.get());
+                                auto initBufferCommand = static_cast<const InitBufferCommand*>(command);
 
                                 auto buffer = std::make_unique<Buffer>(*this,
                                                                        initBufferCommand->bufferType,
@@ -1256,16 +1802,29 @@ namespace ouzel
 
                             case Command::Type::SetBufferData:
                             {
-                                auto setBufferDataCommand = static_cast<const SetBufferDataCommand*>(command.get());
+                                auto setBufferDataCommand = static_cast<const SetBufferDataCommand*>(command);
 
                                 Buffer* buffer = getResource<Buffer>(setBufferDataCommand->buffer);
                                 buffer->setData(setBufferDataCommand->data);
                                 break;
                             }
 
+                            case Command::Type::UploadTransientGeometry:
+                            {
+                                auto uploadTransientGeometryCommand = static_cast<const UploadTransientGeometryCommand*>(command);
+
+                                const TransientBlock& block = commandBuffer.getTransientBlocks()[uploadTransientGeometryCommand->block];
+
+                                Buffer* indexBuffer = getResource<Buffer>(block.indexBuffer);
+                                Buffer* vertexBuffer = getResource<Buffer>(block.vertexBuffer);
+                                indexBuffer->setData(commandBuffer.getTransientIndexData(block));
+                                vertexBuffer->setData(commandBuffer.getTransientVertexData(block));
+                                break;
+                            }
+
                             case Command::Type::InitShader:
                             {
-                                auto initShaderCommand = static_cast<const InitShaderCommand*>(command.get());
+                                auto initShaderCommand = static_cast<const InitShaderCommand*>(command);
 
                                 auto shader = std::make_unique<Shader>(*this,
                                                                        initShaderCommand->fragmentShader,
@@ -1276,7 +1835,8 @@ namespace ouzel
                                                                        initShaderCommand->fragmentShaderDataAlignment,
                                                                        initShaderCommand->vertexShaderDataAlignment,
                                                                        initShaderCommand->fragmentShaderFunction,
-                                                                       initShaderCommand->vertexShaderFunction);
+                                                                       initShaderCommand->vertexShaderFunction,
+                                                                       initShaderCommand->instancedVertexShader);
 
                                 if (initShaderCommand->shader > resources.size())
                                     resources.resize(initShaderCommand->shader);
@@ -1286,49 +1846,29 @@ namespace ouzel
 
                             case Command::Type::SetShaderConstants:
                             {
-                                auto setShaderConstantsCommand = static_cast<const SetShaderConstantsCommand*>(command.get());
+                                auto setShaderConstantsCommand = static_cast<const SetShaderConstantsCommand*>(command);
 
                                 if (!currentShader)
                                     throw std::runtime_error("No shader set");
 
-                                // pixel shader constants
-                                const std::vector<Shader::Location>& fragmentShaderConstantLocations = currentShader->getFragmentShaderConstantLocations();
-
-                                if (setShaderConstantsCommand->fragmentShaderConstants.size() > fragmentShaderConstantLocations.size())
-                                    throw std::runtime_error("Invalid pixel shader constant size");
-
-                                for (size_t i = 0; i < setShaderConstantsCommand->fragmentShaderConstants.size(); ++i)
+                                // the ranges are recorded for every set shader constants command in the same order
+                                const UniformBlockRange* packedRange = nullptr;
+                                if (uniformBlockRangeIndex < uniformBlockRanges.size())
                                 {
-                                    const Shader::Location& fragmentShaderConstantLocation = fragmentShaderConstantLocations[i];
-                                    const std::vector<float>& fragmentShaderConstant = setShaderConstantsCommand->fragmentShaderConstants[i];
-
-                                    setUniform(fragmentShaderConstantLocation.location,
-                                               fragmentShaderConstantLocation.dataType,
-                                               fragmentShaderConstant.data());
-                                }
-
-                                // vertex shader constants
-                                const std::vector<Shader::Location>& vertexShaderConstantLocations = currentShader->getVertexShaderConstantLocations();
-
-                                if (setShaderConstantsCommand->vertexShaderConstants.size() > vertexShaderConstantLocations.size())
-                                    throw std::runtime_error("Invalid vertex shader constant size");
-
-                                for (size_t i = 0; i < setShaderConstantsCommand->vertexShaderConstants.size(); ++i)
-                                {
-                                    const Shader::Location& vertexShaderConstantLocation = vertexShaderConstantLocations[i];
-                                    const std::vector<float>& vertexShaderConstant = setShaderConstantsCommand->vertexShaderConstants[i];
-
-                                    setUniform(vertexShaderConstantLocation.location,
-                                               vertexShaderConstantLocation.dataType,
-                                               vertexShaderConstant.data());
+                                    const UniformBlockRange& range = uniformBlockRanges[uniformBlockRangeIndex++];
+                                    if (range.packed) packedRange = &range;
                                 }
 
+                                setShaderConstants(*currentShader,
+                                                   commandBuffer.getConstants(setShaderConstantsCommand->fragmentShaderConstants),
+                                                   commandBuffer.getConstants(setShaderConstantsCommand->vertexShaderConstants),
+                                                   packedRange);
                                 break;
                             }
 
                             case Command::Type::InitTexture:
                             {
-                                auto initTextureCommand = static_cast<const InitTextureCommand*>(command.get());
+                                auto initTextureCommand = static_cast<const InitTextureCommand*>(command);
 
                                 auto texture = std::make_unique<Texture>(*this,
                                                                          initTextureCommand->levels,
@@ -1345,7 +1885,7 @@ namespace ouzel
 
                             case Command::Type::SetTextureData:
                             {
-                                auto setTextureDataCommand = static_cast<const SetTextureDataCommand*>(command.get());
+                                auto setTextureDataCommand = static_cast<const SetTextureDataCommand*>(command);
 
                                 Texture* texture = getResource<Texture>(setTextureDataCommand->texture);
                                 texture->setData(setTextureDataCommand->levels);
@@ -1353,9 +1893,22 @@ namespace ouzel
                                 break;
                             }
 
+                            case Command::Type::SetTextureRegion:
+                            {
+                                auto setTextureRegionCommand = static_cast<const SetTextureRegionCommand*>(command);
+
+                                Texture* texture = getResource<Texture>(setTextureRegionCommand->texture);
+                                texture->setRegionData(setTextureRegionCommand->x,
+                                                       setTextureRegionCommand->y,
+                                                       setTextureRegionCommand->size,
+                                                       setTextureRegionCommand->data);
+
+                                break;
+                            }
+
                             case Command::Type::SetTextureParameters:
                             {
-                                auto setTextureParametersCommand = static_cast<const SetTextureParametersCommand*>(command.get());
+                                auto setTextureParametersCommand = static_cast<const SetTextureParametersCommand*>(command);
 
                                 Texture* texture = getResource<Texture>(setTextureParametersCommand->texture);
                                 texture->setFilter(setTextureParametersCommand->filter == SamplerFilter::Default ? textureFilter : setTextureParametersCommand->filter);
@@ -1368,7 +1921,7 @@ namespace ouzel
 
                             case Command::Type::SetTextures:
                             {
-                                auto setTexturesCommand = static_cast<const SetTexturesCommand*>(command.get());
+                                auto setTexturesCommand = static_cast<const SetTexturesCommand*>(command);
 
                                 for (uint32_t layer = 0; layer < setTexturesCommand->textures.size(); ++layer)
                                 {
@@ -1385,7 +1938,11 @@ namespace ouzel
                                 throw std::runtime_error("Invalid command");
                         }
 
-                        if (command->type == Command::Type::Present) return;
+                        if (command->type == Command::Type::Present)
+                        {
+                            finishCommandBuffer(commandBuffer);
+                            return;
+                        }
                     }
                 }
             }
@@ -10,6 +10,8 @@
 #include <cstring>
 #include <array>
 #include <atomic>
+#include <limits>
+#include <map>
 #include <memory>
 #include <queue>
 #include <system_error>
@@ -41,10 +43,15 @@ namespace ouzel
         {
             std::error_code makeErrorCode(GLenum e);
 
+            class Buffer;
+
             class RenderDevice: public graphics::RenderDevice
             {
                 friend Renderer;
             public:
+                // the buffer binding is not known, so the next bind is not skipped
+                static constexpr GLuint INVALID_BUFFER_ID = std::numeric_limits<GLuint>::max();
+
                 PFNGLGETINTEGERVPROC glGetIntegervProc = nullptr;
                 PFNGLGETSTRINGPROC glGetStringProc = nullptr;
                 PFNGLGETERRORPROC glGetErrorProc = nullptr;
@@ -73,6 +80,7 @@ namespace ouzel
                 PFNGLCULLFACEPROC glCullFaceProc = nullptr;
                 PFNGLSCISSORPROC glScissorProc = nullptr;
                 PFNGLDRAWELEMENTSPROC glDrawElementsProc = nullptr;
+                PFNGLDRAWELEMENTSINSTANCEDPROC glDrawElementsInstancedProc = nullptr;
                 PFNGLREADPIXELSPROC glReadPixelsProc = nullptr;
 
                 PFNGLBLENDFUNCSEPARATEPROC glBlendFuncSeparateProc = nullptr;
@@ -117,6 +125,7 @@ namespace ouzel
                 PFNGLMAPBUFFERRANGEEXTPROC glMapBufferRangeProc = nullptr;
                 PFNGLFRAMEBUFFERTEXTURE2DMULTISAMPLEEXTPROC glFramebufferTexture2DMultisampleProc = nullptr;
                 PFNGLCOPYIMAGESUBDATAEXTPROC glCopyImageSubDataProc = nullptr;
+                PFNGLMULTIDRAWELEMENTSEXTPROC glMultiDrawElementsProc = nullptr;
 #  if OUZEL_OPENGL_INTERFACE_EAGL
                 PFNGLDISCARDFRAMEBUFFEREXTPROC glDiscardFramebufferEXTProc = nullptr;
                 PFNGLRENDERBUFFERSTORAGEMULTISAMPLEAPPLEPROC glRenderbufferStorageMultisampleAPPLEProc = nullptr;
@@ -129,6 +138,7 @@ namespace ouzel
                 PFNGLUNMAPBUFFERPROC glUnmapBufferProc = nullptr;
                 PFNGLMAPBUFFERRANGEPROC glMapBufferRangeProc = nullptr;
                 PFNGLCOPYIMAGESUBDATAPROC glCopyImageSubDataProc = nullptr;
+                PFNGLMULTIDRAWELEMENTSPROC glMultiDrawElementsProc = nullptr;
 #endif
 
                 PFNGLCREATESHADERPROC glCreateShaderProc = nullptr;
@@ -148,12 +158,19 @@ namespace ouzel
                 PFNGLGETPROGRAMIVPROC glGetProgramivProc = nullptr;
                 PFNGLGETPROGRAMINFOLOGPROC glGetProgramInfoLogProc = nullptr;
                 PFNGLGETUNIFORMLOCATIONPROC glGetUniformLocationProc = nullptr;
+                PFNGLGETUNIFORMBLOCKINDEXPROC glGetUniformBlockIndexProc = nullptr;
+                PFNGLUNIFORMBLOCKBINDINGPROC glUniformBlockBindingProc = nullptr;
+                PFNGLGETACTIVEUNIFORMBLOCKIVPROC glGetActiveUniformBlockivProc = nullptr;
+                PFNGLGETUNIFORMINDICESPROC glGetUniformIndicesProc = nullptr;
+                PFNGLGETACTIVEUNIFORMSIVPROC glGetActiveUniformsivProc = nullptr;
 
                 PFNGLBINDBUFFERPROC glBindBufferProc = nullptr;
                 PFNGLDELETEBUFFERSPROC glDeleteBuffersProc = nullptr;
                 PFNGLGENBUFFERSPROC glGenBuffersProc = nullptr;
                 PFNGLBUFFERDATAPROC glBufferDataProc = nullptr;
                 PFNGLBUFFERSUBDATAPROC glBufferSubDataProc = nullptr;
+                PFNGLBINDBUFFERRANGEPROC glBindBufferRangeProc = nullptr;
+                PFNGLBINDBUFFERBASEPROC glBindBufferBaseProc = nullptr;
 
                 PFNGLGENVERTEXARRAYSPROC glGenVertexArraysProc = nullptr;
                 PFNGLBINDVERTEXARRAYPROC glBindVertexArrayProc = nullptr;
@@ -161,6 +178,7 @@ namespace ouzel
                 PFNGLENABLEVERTEXATTRIBARRAYPROC glEnableVertexAttribArrayProc = nullptr;
                 PFNGLDISABLEVERTEXATTRIBARRAYPROC glDisableVertexAttribArrayProc = nullptr;
                 PFNGLVERTEXATTRIBPOINTERPROC glVertexAttribPointerProc = nullptr;
+                PFNGLVERTEXATTRIBDIVISORPROC glVertexAttribDivisorProc = nullptr;
 
                 PFNGLGETSTRINGIPROC glGetStringiProc = nullptr;
                 PFNGLPUSHGROUPMARKEREXTPROC glPushGroupMarkerEXTProc = nullptr;
@@ -171,16 +189,27 @@ namespace ouzel
 
                 inline auto isTextureBaseLevelSupported() const noexcept { return textureBaseLevelSupported; }
                 inline auto isTextureMaxLevelSupported() const noexcept { return textureMaxLevelSupported; }
+                inline auto isInstancingSupported() const noexcept { return glDrawElementsInstancedProc && glVertexAttribDivisorProc; }
+                inline auto isUniformBufferSupported() const noexcept { return glGetUniformBlockIndexProc && glBindBufferRangeProc; }
+
+                // location of the first per-instance attribute of the instanced programs, after the vertex attributes
+                static constexpr GLuint INSTANCE_ATTRIBUTE_LOCATION = 5;
+
+                // uniform buffer bindings of the uniform blocks of the shaders
+                static constexpr GLuint FRAGMENT_UNIFORM_BLOCK_BINDING = 0;
+                static constexpr GLuint VERTEX_UNIFORM_BLOCK_BINDING = 1;
+                static constexpr GLuint INSTANCED_FRAGMENT_UNIFORM_BLOCK_BINDING = 2;
 
                 inline void setFrontFace(GLenum mode)
                 {
                     if (stateCache.frontFace != mode)
                     {
                         glFrontFaceProc(mode);
+                        ++currentAPICallCount;
                         stateCache.frontFace = mode;
 
                         GLenum error;
-                        if ((error = glGetErrorProc()) != GL_NO_ERROR)
+                        if (debugRenderer && (error = glGetErrorProc()) != GL_NO_ERROR)
                             throw std::system_error(makeErrorCode(error), "Failed to set front face mode");
                     }
                 }
@@ -189,12 +218,19 @@ namespace ouzel
                 {
                     if (stateCache.textures[target].textureId[layer] != textureId)
                     {
-                        glActiveTextureProc(GL_TEXTURE0 + layer);
+                        if (stateCache.activeTexture != layer)
+                        {
+                            glActiveTextureProc(GL_TEXTURE0 + layer);
+                            ++currentAPICallCount;
+                            stateCache.activeTexture = layer;
+                        }
+
                         glBindTextureProc(target, textureId);
+                        ++currentAPICallCount;
                         stateCache.textures[target].textureId[layer] = textureId;
 
                         GLenum error;
-                        if ((error = glGetErrorProc()) != GL_NO_ERROR)
+                        if (debugRenderer && (error = glGetErrorProc()) != GL_NO_ERROR)
                             throw std::system_error(makeErrorCode(error), "Failed to bind texture");
                     }
                 }
@@ -204,10 +240,11 @@ namespace ouzel
                     if (stateCache.programId != programId)
                     {
                         glUseProgramProc(programId);
+                        ++currentAPICallCount;
                         stateCache.programId = programId;
 
                         GLenum error;
-                        if ((error = glGetErrorProc()) != GL_NO_ERROR)
+                        if (debugRenderer && (error = glGetErrorProc()) != GL_NO_ERROR)
                             throw std::system_error(makeErrorCode(error), "Failed to bind program");
                     }
                 }
@@ -217,25 +254,48 @@ namespace ouzel
                     if (stateCache.frameBufferId != bufferId)
                     {
                         glBindFramebufferProc(GL_FRAMEBUFFER, bufferId);
+                        ++currentAPICallCount;
                         stateCache.frameBufferId = bufferId;
 
                         GLenum error;
-                        if ((error = glGetErrorProc()) != GL_NO_ERROR)
+                        if (debugRenderer && (error = glGetErrorProc()) != GL_NO_ERROR)
                             throw std::system_error(makeErrorCode(error), "Failed to bind frame buffer");
                     }
                 }
 
+                inline void bindVertexArray(GLuint newVertexArrayId)
+                {
+                    if (stateCache.vertexArrayId != newVertexArrayId)
+                    {
+                        glBindVertexArrayProc(newVertexArrayId);
+                        ++currentAPICallCount;
+                        stateCache.vertexArrayId = newVertexArrayId;
+
+                        // the element array buffer binding is a part of the vertex array object
+                        stateCache.bufferId[GL_ELEMENT_ARRAY_BUFFER] = INVALID_BUFFER_ID;
+
+                        GLenum error;
+                        if (debugRenderer && (error = glGetErrorProc()) != GL_NO_ERROR)
+                            throw std::system_error(makeErrorCode(error), "Failed to bind vertex array");
+                    }
+                }
+
                 inline void bindBuffer(GLuint target, GLuint bufferId)
                 {
+                    // the vertex arrays of the draw calls must not pick up the element array buffers of the buffer updates
+                    if (target == GL_ELEMENT_ARRAY_BUFFER && vertexArrayId)
+                        bindVertexArray(vertexArrayId);
+
                     GLuint& currentBufferId = stateCache.bufferId[target];
 
                     if (currentBufferId != bufferId)
                     {
                         glBindBufferProc(target, bufferId);
+                        ++currentAPICallCount;
                         currentBufferId = bufferId;
 
                         GLenum error;
-                        if ((error = glGetErrorProc()) != GL_NO_ERROR)
+                        if (debugRenderer && (error = glGetErrorProc()) != GL_NO_ERROR)
                             throw std::system_error(makeErrorCode(error), "Failed to bind element array buffer");
                     }
                 }
@@ -252,9 +312,10 @@ namespace ouzel
                             glEnableProc(GL_SCISSOR_TEST);
                         else
                             glDisableProc(GL_SCISSOR_TEST);
+                        ++currentAPICallCount;
 
                         GLenum error;
-                        if ((error = glGetErrorProc()) != GL_NO_ERROR)
+                        if (debugRenderer && (error = glGetErrorProc()) != GL_NO_ERROR)
                             throw std::system_error(makeErrorCode(error), "Failed to set scissor test");
 
                         stateCache.scissorTestEnabled = scissorTestEnabled;
@@ -268,6 +329,7 @@ namespace ouzel
                             stateCache.scissorHeight != height)
                         {
                             glScissorProc(x, y, width, height);
+                            ++currentAPICallCount;
                             stateCache.scissorX = x;
                             stateCache.scissorY = y;
                             stateCache.scissorWidth = width;
@@ -275,7 +337,7 @@ namespace ouzel
                         }
 
                         GLenum error;
-                        if ((error = glGetErrorProc()) != GL_NO_ERROR)
+                        if (debugRenderer && (error = glGetErrorProc()) != GL_NO_ERROR)
                             throw std::system_error(makeErrorCode(error), "Failed to set scissor test");
                     }
                 }
@@ -288,9 +350,10 @@ namespace ouzel
                             glEnableProc(GL_DEPTH_TEST);
                         else
                             glDisableProc(GL_DEPTH_TEST);
+                        ++currentAPICallCount;
 
                         GLenum error;
-                        if ((error = glGetErrorProc()) != GL_NO_ERROR)
+                        if (debugRenderer && (error = glGetErrorProc()) != GL_NO_ERROR)
                             throw std::system_error(makeErrorCode(error), "Failed to change depth test state");
 
                         stateCache.depthTestEnabled = enable;
@@ -305,9 +368,10 @@ namespace ouzel
                             glEnableProc(GL_STENCIL_TEST);
                         else
                             glDisableProc(GL_STENCIL_TEST);
+                        ++currentAPICallCount;
 
                         GLenum error;
-                        if ((error = glGetErrorProc()) != GL_NO_ERROR)
+                        if (debugRenderer && (error = glGetErrorProc()) != GL_NO_ERROR)
                             throw std::system_error(makeErrorCode(error), "Failed to change stencil test state");
 
                         stateCache.stencilTestEnabled = enable;
@@ -325,13 +389,14 @@ namespace ouzel
                         stateCache.viewportHeight != height)
                     {
                         glViewportProc(x, y, width, height);
+                        ++currentAPICallCount;
                         stateCache.viewportX = x;
                         stateCache.viewportY = y;
                         stateCache.viewportWidth = width;
                         stateCache.viewportHeight = height;
 
                         GLenum error;
-                        if ((error = glGetErrorProc()) != GL_NO_ERROR)
+                        if (debugRenderer && (error = glGetErrorProc()) != GL_NO_ERROR)
                             throw std::system_error(makeErrorCode(error), "Failed to set viewport");
                     }
                 }
@@ -350,11 +415,12 @@ namespace ouzel
                             glEnableProc(GL_BLEND);
                         else
                             glDisableProc(GL_BLEND);
+                        ++currentAPICallCount;
 
                         stateCache.blendEnabled = blendEnabled;
 
                         GLenum error;
-                        if ((error = glGetErrorProc()) != GL_NO_ERROR)
+                        if (debugRenderer && (error = glGetErrorProc()) != GL_NO_ERROR)
                             throw std::system_error(makeErrorCode(error), "Failed to enable blend state");
                     }
 
@@ -365,6 +431,7 @@ namespace ouzel
                         {
                             glBlendEquationSeparateProc(modeRGB,
                                                         modeAlpha);
+                            ++currentAPICallCount;
 
                             stateCache.blendModeRGB = modeRGB;
                             stateCache.blendModeAlpha = modeAlpha;
@@ -379,6 +446,7 @@ namespace ouzel
                                                     dfactorRGB,
                                                     sfactorAlpha,
                                                     dfactorAlpha);
+                            ++currentAPICallCount;
 
                             stateCache.blendSourceFactorRGB = sfactorRGB;
                             stateCache.blendDestFactorRGB = dfactorRGB;
@@ -387,7 +455,7 @@ namespace ouzel
                         }
 
                         GLenum error;
-                        if ((error = glGetErrorProc()) != GL_NO_ERROR)
+                        if (debugRenderer && (error = glGetErrorProc()) != GL_NO_ERROR)
                             throw std::system_error(makeErrorCode(error), "Failed to set blend state");
                     }
                 }
@@ -403,6 +471,7 @@ namespace ouzel
                         stateCache.alphaMask != alphaMask)
                     {
                         glColorMaskProc(redMask, greenMask, blueMask, alphaMask);
+                        ++currentAPICallCount;
 
                         stateCache.redMask = redMask;
                         stateCache.greenMask = greenMask;
@@ -410,7 +479,7 @@ namespace ouzel
                         stateCache.alphaMask = alphaMask;
 
                         GLenum error;
-                        if ((error = glGetErrorProc()) != GL_NO_ERROR)
+                        if (debugRenderer && (error = glGetErrorProc()) != GL_NO_ERROR)
                             throw std::system_error(makeErrorCode(error), "Failed to set color mask");
                     }
                 }
@@ -420,9 +489,10 @@ namespace ouzel
                     if (stateCache.depthMask != flag)
                     {
                         glDepthMaskProc(flag);
+                        ++currentAPICallCount;
 
                         GLenum error;
-                        if ((error = glGetErrorProc()) != GL_NO_ERROR)
+                        if (debugRenderer && (error = glGetErrorProc()) != GL_NO_ERROR)
                             throw std::system_error(makeErrorCode(error), "Failed to change depth mask state");
 
                         stateCache.depthMask = flag;
@@ -434,9 +504,10 @@ namespace ouzel
                     if (stateCache.depthFunc != depthFunc)
                     {
                         glDepthFuncProc(depthFunc);
+                        ++currentAPICallCount;
 
                         GLenum error;
-                        if ((error = glGetErrorProc()) != GL_NO_ERROR)
+                        if (debugRenderer && (error = glGetErrorProc()) != GL_NO_ERROR)
                             throw std::system_error(makeErrorCode(error), "Failed to change depth test state");
 
                         stateCache.depthFunc = depthFunc;
@@ -448,9 +519,10 @@ namespace ouzel
                     if (stateCache.stencilMask != stencilMask)
                     {
                         glStencilMaskProc(stencilMask);
+                        ++currentAPICallCount;
 
                         GLenum error;
-                        if ((error = glGetErrorProc()) != GL_NO_ERROR)
+                        if (debugRenderer && (error = glGetErrorProc()) != GL_NO_ERROR)
                             throw std::system_error(makeErrorCode(error), "Failed to change stencil mask");
 
                         stateCache.stencilMask = stencilMask;
@@ -466,11 +538,12 @@ namespace ouzel
                             glEnableProc(GL_CULL_FACE);
                         else
                             glDisableProc(GL_CULL_FACE);
+                        ++currentAPICallCount;
 
                         stateCache.cullEnabled = cullEnabled;
 
                         GLenum error;
-                        if ((error = glGetErrorProc()) != GL_NO_ERROR)
+                        if (debugRenderer && (error = glGetErrorProc()) != GL_NO_ERROR)
                             throw std::system_error(makeErrorCode(error), "Failed to enable cull face");
                     }
 
@@ -479,11 +552,12 @@ namespace ouzel
                         if (stateCache.cullFace != cullFace)
                         {
                             glCullFaceProc(cullFace);
+                            ++currentAPICallCount;
                             stateCache.cullFace = cullFace;
                         }
 
                         GLenum error;
-                        if ((error = glGetErrorProc()) != GL_NO_ERROR)
+                        if (debugRenderer && (error = glGetErrorProc()) != GL_NO_ERROR)
                             throw std::system_error(makeErrorCode(error), "Failed to set cull face");
                     }
                 }
@@ -496,11 +570,12 @@ namespace ouzel
                                          clearColorValue[1],
                                          clearColorValue[2],
                                          clearColorValue[3]);
+                        ++currentAPICallCount;
 
                         stateCache.clearColor = clearColorValue;
 
                         GLenum error;
-                        if ((error = glGetErrorProc()) != GL_NO_ERROR)
+                        if (debugRenderer && (error = glGetErrorProc()) != GL_NO_ERROR)
                             throw std::system_error(makeErrorCode(error), "Failed to set clear color");
                     }
                 }
@@ -514,11 +589,12 @@ namespace ouzel
 #else
                         glClearDepthProc(clearDepthValue);
 #endif
+                        ++currentAPICallCount;
 
                         stateCache.clearDepth = clearDepthValue;
 
                         GLenum error;
-                        if ((error = glGetErrorProc()) != GL_NO_ERROR)
+                        if (debugRenderer && (error = glGetErrorProc()) != GL_NO_ERROR)
                             throw std::system_error(makeErrorCode(error), "Failed to set clear depth");
                     }
                 }
@@ -528,21 +604,36 @@ namespace ouzel
                     if (stateCache.clearStencil != clearStencilValue)
                     {
                         glClearStencilProc(clearStencilValue);
+                        ++currentAPICallCount;
 
                         stateCache.clearStencil = clearStencilValue;
 
                         GLenum error;
-                        if ((error = glGetErrorProc()) != GL_NO_ERROR)
+                        if (debugRenderer && (error = glGetErrorProc()) != GL_NO_ERROR)
                             throw std::system_error(makeErrorCode(error), "Failed to set clear stencil");
                     }
                 }
 
                 void deleteBuffer(GLuint bufferId)
                 {
+                    for (auto i = vertexArrays.begin(); i != vertexArrays.end();)
+                    {
+                        if (i->first.first == bufferId || i->first.second == bufferId)
+                        {
+                            if (stateCache.vertexArrayId == i->second) stateCache.vertexArrayId = 0;
+                            glDeleteVertexArraysProc(1, &i->second);
+                            i = vertexArrays.erase(i);
+                        }
+                        else
+                            ++i;
+                    }
+
                     GLuint& elementArrayBufferId = stateCache.bufferId[GL_ELEMENT_ARRAY_BUFFER];
                     if (elementArrayBufferId == bufferId) elementArrayBufferId = 0;
                     GLuint& arrayBufferId = stateCache.bufferId[GL_ARRAY_BUFFER];
                     if (arrayBufferId == bufferId) arrayBufferId = 0;
+                    GLuint& boundUniformBufferId = stateCache.bufferId[GL_UNIFORM_BUFFER];
+                    if (boundUniformBufferId == bufferId) boundUniformBufferId = 0;
                     glDeleteBuffersProc(1, &bufferId);
                 }
 
@@ -578,12 +669,13 @@ namespace ouzel
                     if (stateCache.polygonFillMode != polygonFillMode)
                     {
                         glPolygonModeProc(GL_FRONT_AND_BACK, polygonFillMode);
+                        ++currentAPICallCount;
 
                         stateCache.polygonFillMode = polygonFillMode;
 
                         GLenum error;
 
-                        if ((error = glGetErrorProc()) != GL_NO_ERROR)
+                        if (debugRenderer && (error = glGetErrorProc()) != GL_NO_ERROR)
                             throw std::system_error(makeErrorCode(error), "Failed to set blend state");
                     }
                 }
@@ -612,12 +704,68 @@ namespace ouzel
                 void process() override;
                 virtual void present();
                 void generateScreenshot(const std::string& filename) override;
+                void setVertexAttributes();
+                void bindBuffers(const Buffer& indexBuffer, const Buffer& vertexBuffer);
+                void drawElements(DrawMode drawMode,
+                                  uint32_t indexCount,
+                                  uint32_t indexSize,
+                                  uint32_t startIndex);
+                void drawElementsInstanced(const Shader& shader,
+                                           DrawMode drawMode,
+                                           uint32_t indexCount,
+                                           uint32_t indexSize,
+                                           uint32_t startIndex,
+                                           Span<const Instance> instances);
+
+                // offsets of the uniform blocks of a set shader constants command in a uniform buffer,
+                // -1 for the stages that are not set from a uniform block
+                struct UniformBlockRange final
+                {
+                    bool packed = false;
+                    GLintptr fragmentOffset = -1;
+                    GLintptr vertexOffset = -1;
+                };
+
+                void packUniformBlocks(const CommandBuffer& commandBuffer);
+                UniformBlockRange appendUniformBlocks(const Shader& shader,
+                                                      Span<const float> fragmentShaderConstants,
+                                                      Span<const float> vertexShaderConstants,
+                                                      std::vector<uint8_t>& data) const;
+                void bindUniformBlocks(const Shader& shader,
+                                       GLuint bufferId,
+                                       const UniformBlockRange& range);
+                void setShaderConstants(Shader& shader,
+                                        Span<const float> fragmentShaderConstants,
+                                        Span<const float> vertexShaderConstants,
+                                        const UniformBlockRange* packedRange = nullptr);
                 void setUniform(GLint location, DataType dataType, const void* data);
+                void setUniform(const Shader::Location& location,
+                                const float* data,
+                                float* currentData,
+                                size_t size);
 
                 GLuint frameBufferId = 0;
                 GLsizei frameBufferWidth = 0;
                 GLsizei frameBufferHeight = 0;
                 GLuint vertexArrayId = 0;
+                GLuint instanceBufferId = 0; // per-instance vertex stream of the instanced draw calls
+
+                // the uniform blocks of all the set shader constants commands of a command buffer are packed
+                // to one buffer before the commands are executed and uploaded with a single update
+                GLuint uniformBufferId = 0;
+                GLuint immediateUniformBufferId = 0; // constants of the shaders that were not known when packing
+                GLint uniformBufferAlignment = 256;
+                std::vector<uint8_t> uniformBufferData;
+                std::vector<uint8_t> immediateUniformBufferData;
+                std::vector<UniformBlockRange> uniformBlockRanges;
+                std::vector<uintptr_t> replacedResources; // resources that are deleted or created while packing
+                size_t uniformBlockRangeIndex = 0;
+
+                // vertex array objects of the draw calls by their vertex and index buffers
+                std::map<std::pair<GLuint, GLuint>, GLuint> vertexArrays;
+
+                std::vector<GLsizei> multiDrawCounts;
+                std::vector<const void*> multiDrawOffsets;
 
                 bool textureBaseLevelSupported:1;
                 bool textureMaxLevelSupported:1;
@@ -632,6 +780,7 @@ namespace ouzel
                         GLuint textureId[16]{0};
                     };
 
+                    GLuint activeTexture = 0;
                     std::unordered_map<GLenum, Textures> textures{
 #if !OUZEL_OPENGLES
                         {GL_TEXTURE_1D, Textures{}},
@@ -642,6 +791,7 @@ namespace ouzel
                     };
                     GLuint programId = 0;
                     GLuint frameBufferId = 0;
+                    GLuint vertexArrayId = 0;
 
                     std::unordered_map<GLenum, GLuint> bufferId{
                         {GL_ELEMENT_ARRAY_BUFFER, 0},
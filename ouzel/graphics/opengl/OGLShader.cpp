@@ -4,6 +4,7 @@
 
 #if OUZEL_COMPILE_OPENGL
 
+#include <cstring>
 #include "OGLShader.hpp"
 #include "OGLRenderDevice.hpp"
 
@@ -14,28 +15,37 @@ namespace ouzel
         namespace opengl
         {
             Shader::Shader(RenderDevice& initRenderDevice,
-                           const std::vector<uint8_t>& initFragmentShader,
-                           const std::vector<uint8_t>& initVertexShader,
-                           const std::set<Vertex::Attribute::Usage>& initVertexAttributes,
-                           const std::vector<std::pair<std::string, DataType>>& initFragmentShaderConstantInfo,
-                           const std::vector<std::pair<std::string, DataType>>& initVertexShaderConstantInfo,
+                           Span<const uint8_t> initFragmentShader,
+                           Span<const uint8_t> initVertexShader,
+                           Span<const Vertex::Attribute::Usage> initVertexAttributes,
+                           Span<const ShaderConstantInfo> initFragmentShaderConstantInfo,
+                           Span<const ShaderConstantInfo> initVertexShaderConstantInfo,
                            uint32_t,
                            uint32_t,
-                           const std::string&,
-                           const std::string&):
+                           const char*,
+                           const char*,
+                           Span<const uint8_t> initInstancedVertexShader):
                 RenderResource(initRenderDevice),
-                fragmentShaderData(initFragmentShader),
-                vertexShaderData(initVertexShader),
-                vertexAttributes(initVertexAttributes),
-                fragmentShaderConstantInfo(initFragmentShaderConstantInfo),
-                vertexShaderConstantInfo(initVertexShaderConstantInfo)
+                fragmentShaderData(initFragmentShader.begin(), initFragmentShader.end()),
+                vertexShaderData(initVertexShader.begin(), initVertexShader.end()),
+                instancedVertexShaderData(initInstancedVertexShader.begin(), initInstancedVertexShader.end()),
+                vertexAttributes(initVertexAttributes.begin(), initVertexAttributes.end())
             {
+                for (const ShaderConstantInfo& info : initFragmentShaderConstantInfo)
+                    fragmentShaderConstantInfo.emplace_back(info.name, info.dataType);
+
+                for (const ShaderConstantInfo& info : initVertexShaderConstantInfo)
+                    vertexShaderConstantInfo.emplace_back(info.name, info.dataType);
+
                 compileShader();
             }
 
             Shader::~Shader()
             {
+                if (instancedUniformBufferId) renderDevice.deleteBuffer(instancedUniformBufferId);
+                if (instancedProgramId) renderDevice.deleteProgram(instancedProgramId);
                 if (programId) renderDevice.deleteProgram(programId);
+                if (instancedVertexShaderId) renderDevice.glDeleteShaderProc(instancedVertexShaderId);
                 if (vertexShaderId) renderDevice.glDeleteShaderProc(vertexShaderId);
                 if (fragmentShaderId) renderDevice.glDeleteShaderProc(fragmentShaderId);
             }
@@ -45,6 +55,9 @@ namespace ouzel
                 fragmentShaderId = 0;
                 vertexShaderId = 0;
                 programId = 0;
+                instancedVertexShaderId = 0;
+                instancedProgramId = 0;
+                instancedUniformBufferId = 0;
 
                 compileShader();
             }
@@ -65,15 +78,15 @@ namespace ouzel
                 return std::string();
             }
 
-            std::string Shader::getProgramMessage() const
+            std::string Shader::getProgramMessage(GLuint program) const
             {
                 GLint logLength = 0;
-                renderDevice.glGetProgramivProc(programId, GL_INFO_LOG_LENGTH, &logLength);
+                renderDevice.glGetProgramivProc(program, GL_INFO_LOG_LENGTH, &logLength);
 
                 if (logLength > 0)
                 {
                     std::vector<char> logMessage(static_cast<size_t>(logLength));
-                    renderDevice.glGetProgramInfoLogProc(programId, logLength, nullptr, logMessage.data());
+                    renderDevice.glGetProgramInfoLogProc(program, logLength, nullptr, logMessage.data());
 
                     return std::string("Shader linking error: ") + logMessage.data();
                 }
@@ -81,43 +94,39 @@ namespace ouzel
                 return std::string();
             }
 
-            void Shader::compileShader()
+            GLuint Shader::compileShader(GLenum type, const std::vector<uint8_t>& data) const
             {
-                fragmentShaderId = renderDevice.glCreateShaderProc(GL_FRAGMENT_SHADER);
+                const GLuint shaderId = renderDevice.glCreateShaderProc(type);
 
-                const auto fragmentShaderBuffer = reinterpret_cast<const GLchar*>(fragmentShaderData.data());
-                const auto fragmentShaderSize = static_cast<GLint>(fragmentShaderData.size());
+                const auto shaderBuffer = reinterpret_cast<const GLchar*>(data.data());
+                const auto shaderSize = static_cast<GLint>(data.size());
 
-                renderDevice.glShaderSourceProc(fragmentShaderId, 1, &fragmentShaderBuffer, &fragmentShaderSize);
-                renderDevice.glCompileShaderProc(fragmentShaderId);
+                renderDevice.glShaderSourceProc(shaderId, 1, &shaderBuffer, &shaderSize);
+                renderDevice.glCompileShaderProc(shaderId);
 
                 GLint status;
-                renderDevice.glGetShaderivProc(fragmentShaderId, GL_COMPILE_STATUS, &status);
+                renderDevice.glGetShaderivProc(shaderId, GL_COMPILE_STATUS, &status);
                 if (status == GL_FALSE)
-                    throw std::runtime_error("Failed to compile pixel shader, error: " + getShaderMessage(fragmentShaderId));
+                {
+                    const std::string message = getShaderMessage(shaderId);
+                    renderDevice.glDeleteShaderProc(shaderId);
+
+                    if (type == GL_FRAGMENT_SHADER)
+                        throw std::runtime_error("Failed to compile pixel shader, error: " + message);
+                    else
+                        throw std::runtime_error("Failed to compile vertex shader, error: " + message);
+                }
 
                 GLenum error;
 
                 if ((error = renderDevice.glGetErrorProc()) != GL_NO_ERROR)
                     throw std::system_error(makeErrorCode(error), "Failed to get shader compile status");
 
-                vertexShaderId = renderDevice.glCreateShaderProc(GL_VERTEX_SHADER);
-
-                auto vertexShaderBuffer = reinterpret_cast<const GLchar*>(vertexShaderData.data());
-                auto vertexShaderSize = static_cast<GLint>(vertexShaderData.size());
-
-                renderDevice.glShaderSourceProc(vertexShaderId, 1, &vertexShaderBuffer, &vertexShaderSize);
-                renderDevice.glCompileShaderProc(vertexShaderId);
-
-                renderDevice.glGetShaderivProc(vertexShaderId, GL_COMPILE_STATUS, &status);
-                if (status == GL_FALSE)
-                    throw std::runtime_error("Failed to compile vertex shader, error: " + getShaderMessage(vertexShaderId));
-
-                programId = renderDevice.glCreateProgramProc();
-
-                renderDevice.glAttachShaderProc(programId, vertexShaderId);
-                renderDevice.glAttachShaderProc(programId, fragmentShaderId);
+                return shaderId;
+            }
 
+            void Shader::linkProgram(GLuint program, bool instanced) const
+            {
                 GLuint index = 0;
 
                 for (const Vertex::Attribute& vertexAttribute : RenderDevice::VERTEX_ATTRIBUTES)
@@ -165,31 +174,189 @@ namespace ouzel
                                 throw std::runtime_error("Invalid vertex attribute usage");
                         }
 
-                        renderDevice.glBindAttribLocationProc(programId, index, name);
+                        renderDevice.glBindAttribLocationProc(program, index, name);
                         ++index;
                     }
                 }
 
-                renderDevice.glLinkProgramProc(programId);
+                if (instanced)
+                {
+                    // the matrix takes four locations, one for each column
+                    renderDevice.glBindAttribLocationProc(program, RenderDevice::INSTANCE_ATTRIBUTE_LOCATION, "instanceModelViewProj");
+                    renderDevice.glBindAttribLocationProc(program, RenderDevice::INSTANCE_ATTRIBUTE_LOCATION + 4, "instanceColor");
+                }
+
+                renderDevice.glLinkProgramProc(program);
 
-                renderDevice.glGetProgramivProc(programId, GL_LINK_STATUS, &status);
+                GLint status;
+                renderDevice.glGetProgramivProc(program, GL_LINK_STATUS, &status);
                 if (status == GL_FALSE)
-                    throw std::runtime_error("Failed to link shader" + getProgramMessage());
+                    throw std::runtime_error("Failed to link shader" + getProgramMessage(program));
+
+                GLenum error;
 
                 if ((error = renderDevice.glGetErrorProc()) != GL_NO_ERROR)
                     throw std::system_error(makeErrorCode(error), "Failed to get shader link status");
+            }
+
+            Shader::UniformBlock Shader::getUniformBlock(const GLchar* name,
+                                                         GLuint binding,
+                                                         const std::vector<std::pair<std::string, DataType>>& constantInfo) const
+            {
+                UniformBlock block;
+
+                const GLuint blockIndex = renderDevice.glGetUniformBlockIndexProc(programId, name);
+                if (blockIndex == GL_INVALID_INDEX) return block;
+
+                renderDevice.glUniformBlockBindingProc(programId, blockIndex, binding);
+
+                GLint size;
+                renderDevice.glGetActiveUniformBlockivProc(programId, blockIndex, GL_UNIFORM_BLOCK_DATA_SIZE, &size);
+                block.size = size;
+
+                std::vector<const GLchar*> names;
+                names.reserve(constantInfo.size());
+                for (const std::pair<std::string, DataType>& info : constantInfo)
+                    names.push_back(info.first.c_str());
+
+                const auto count = static_cast<GLsizei>(constantInfo.size());
+                std::vector<GLuint> indices(constantInfo.size());
+                renderDevice.glGetUniformIndicesProc(programId, count, names.data(), indices.data());
+
+                for (const GLuint index : indices)
+                    if (index == GL_INVALID_INDEX)
+                        throw std::runtime_error("Failed to get OpenGL uniform index");
+
+                std::vector<GLint> offsets(constantInfo.size());
+                std::vector<GLint> matrixStrides(constantInfo.size());
+                renderDevice.glGetActiveUniformsivProc(programId, count, indices.data(), GL_UNIFORM_OFFSET, offsets.data());
+                renderDevice.glGetActiveUniformsivProc(programId, count, indices.data(), GL_UNIFORM_MATRIX_STRIDE, matrixStrides.data());
+
+                GLenum error;
+
+                if ((error = renderDevice.glGetErrorProc()) != GL_NO_ERROR)
+                    throw std::system_error(makeErrorCode(error), "Failed to get OpenGL uniform block");
+
+                block.members.reserve(constantInfo.size());
+                for (size_t i = 0; i < constantInfo.size(); ++i)
+                    block.members.emplace_back(offsets[i], matrixStrides[i], constantInfo[i].second);
+
+                return block;
+            }
+
+            void Shader::compileShader()
+            {
+                fragmentShaderId = compileShader(GL_FRAGMENT_SHADER, fragmentShaderData);
+                vertexShaderId = compileShader(GL_VERTEX_SHADER, vertexShaderData);
+
+                programId = renderDevice.glCreateProgramProc();
+
+                renderDevice.glAttachShaderProc(programId, vertexShaderId);
+                renderDevice.glAttachShaderProc(programId, fragmentShaderId);
+
+                linkProgram(programId, false);
 
                 renderDevice.glDetachShaderProc(programId, vertexShaderId);
                 renderDevice.glDeleteShaderProc(vertexShaderId);
                 vertexShaderId = 0;
 
                 renderDevice.glDetachShaderProc(programId, fragmentShaderId);
+
+                // the instanced program is linked with the same fragment shader
+                if (!instancedVertexShaderData.empty() && renderDevice.isInstancingSupported())
+                {
+                    instancedVertexShaderId = compileShader(GL_VERTEX_SHADER, instancedVertexShaderData);
+
+                    instancedProgramId = renderDevice.glCreateProgramProc();
+
+                    renderDevice.glAttachShaderProc(instancedProgramId, instancedVertexShaderId);
+                    renderDevice.glAttachShaderProc(instancedProgramId, fragmentShaderId);
+
+                    linkProgram(instancedProgramId, true);
+
+                    renderDevice.glDetachShaderProc(instancedProgramId, instancedVertexShaderId);
+                    renderDevice.glDeleteShaderProc(instancedVertexShaderId);
+                    instancedVertexShaderId = 0;
+
+                    renderDevice.glDetachShaderProc(instancedProgramId, fragmentShaderId);
+                }
+
                 renderDevice.glDeleteShaderProc(fragmentShaderId);
                 fragmentShaderId = 0;
 
+                GLenum error;
+
                 if ((error = renderDevice.glGetErrorProc()) != GL_NO_ERROR)
                     throw std::system_error(makeErrorCode(error), "Failed to detach shader");
 
+                // the built-in shaders declare their constants in uniform blocks, so that the constants
+                // of a frame can be uploaded with a single buffer update
+                fragmentUniformBlock = UniformBlock();
+                vertexUniformBlock = UniformBlock();
+
+                if (renderDevice.isUniformBufferSupported())
+                {
+                    fragmentUniformBlock = getUniformBlock("FragmentConstants",
+                                                           RenderDevice::FRAGMENT_UNIFORM_BLOCK_BINDING,
+                                                           fragmentShaderConstantInfo);
+                    vertexUniformBlock = getUniformBlock("VertexConstants",
+                                                         RenderDevice::VERTEX_UNIFORM_BLOCK_BINDING,
+                                                         vertexShaderConstantInfo);
+                }
+
+                if (instancedProgramId)
+                {
+                    renderDevice.useProgram(instancedProgramId);
+
+                    const GLint texture0Location = renderDevice.glGetUniformLocationProc(instancedProgramId, "texture0");
+                    if (texture0Location != -1) renderDevice.glUniform1iProc(texture0Location, 0);
+
+                    const GLint texture1Location = renderDevice.glGetUniformLocationProc(instancedProgramId, "texture1");
+                    if (texture1Location != -1) renderDevice.glUniform1iProc(texture1Location, 1);
+
+                    // the instanced vertex shader multiplies the vertex color with the instance color,
+                    // so the color constant of the fragment shader stays white
+                    if (!fragmentShaderConstantInfo.empty() &&
+                        fragmentShaderConstantInfo.front().second == DataType::FloatVector4)
+                    {
+                        const GLint colorLocation = renderDevice.glGetUniformLocationProc(instancedProgramId,
+                                                                                          fragmentShaderConstantInfo.front().first.c_str());
+                        const GLfloat white[] = {1.0F, 1.0F, 1.0F, 1.0F};
+                        if (colorLocation != -1) renderDevice.glUniform4fvProc(colorLocation, 1, white);
+                    }
+
+                    // a uniform block can not be set per program, so the instanced program reads the fragment
+                    // constants from a binding of its own that holds the white color
+                    const GLuint fragmentBlockIndex = fragmentUniformBlock.size ?
+                        renderDevice.glGetUniformBlockIndexProc(instancedProgramId, "FragmentConstants") :
+                        GL_INVALID_INDEX;
+
+                    if (fragmentBlockIndex != GL_INVALID_INDEX)
+                    {
+                        renderDevice.glUniformBlockBindingProc(instancedProgramId, fragmentBlockIndex,
+                                                               RenderDevice::INSTANCED_FRAGMENT_UNIFORM_BLOCK_BINDING);
+
+                        // the fragment shader is the same, so the layout of the block is the same as in the program
+                        std::vector<uint8_t> data(static_cast<size_t>(fragmentUniformBlock.size));
+                        if (!fragmentUniformBlock.members.empty() &&
+                            fragmentUniformBlock.members.front().dataType == DataType::FloatVector4)
+                        {
+                            const GLfloat white[] = {1.0F, 1.0F, 1.0F, 1.0F};
+                            std::memcpy(data.data() + fragmentUniformBlock.members.front().offset, white, sizeof(white));
+                        }
+
+                        renderDevice.glGenBuffersProc(1, &instancedUniformBufferId);
+                        renderDevice.bindBuffer(GL_UNIFORM_BUFFER, instancedUniformBufferId);
+                        renderDevice.glBufferDataProc(GL_UNIFORM_BUFFER,
+                                                      fragmentUniformBlock.size,
+                                                      data.data(),
+                                                      GL_STATIC_DRAW);
+                    }
+
+                    if ((error = renderDevice.glGetErrorProc()) != GL_NO_ERROR)
+                        throw std::system_error(makeErrorCode(error), "Failed to set the uniforms of the instanced program");
+                }
+
                 renderDevice.useProgram(programId);
 
                 const GLint texture0Location = renderDevice.glGetUniformLocationProc(programId, "texture0");
@@ -201,9 +368,11 @@ namespace ouzel
                 if ((error = renderDevice.glGetErrorProc()) != GL_NO_ERROR)
                     throw std::system_error(makeErrorCode(error), "Failed to get uniform location");
 
-                if (!fragmentShaderConstantInfo.empty())
+                fragmentShaderConstantLocations.clear();
+                vertexShaderConstantLocations.clear();
+
+                if (!fragmentShaderConstantInfo.empty() && !fragmentUniformBlock.size)
                 {
-                    fragmentShaderConstantLocations.clear();
                     fragmentShaderConstantLocations.reserve(fragmentShaderConstantInfo.size());
 
                     for (const std::pair<std::string, DataType>& info : fragmentShaderConstantInfo)
@@ -220,9 +389,8 @@ namespace ouzel
                     }
                 }
 
-                if (!vertexShaderConstantInfo.empty())
+                if (!vertexShaderConstantInfo.empty() && !vertexUniformBlock.size)
                 {
-                    vertexShaderConstantLocations.clear();
                     vertexShaderConstantLocations.reserve(vertexShaderConstantInfo.size());
 
                     for (const std::pair<std::string, DataType>& info : vertexShaderConstantInfo)
@@ -238,6 +406,19 @@ namespace ouzel
                         vertexShaderConstantLocations.emplace_back(location, info.second);
                     }
                 }
+
+                // uniforms are zero after the program is linked
+                uint32_t fragmentShaderConstantSize = 0;
+                for (const std::pair<std::string, DataType>& info : fragmentShaderConstantInfo)
+                    fragmentShaderConstantSize += getDataTypeSize(info.second);
+
+                fragmentShaderConstants.assign(fragmentShaderConstantSize / sizeof(float), 0.0F);
+
+                uint32_t vertexShaderConstantSize = 0;
+                for (const std::pair<std::string, DataType>& info : vertexShaderConstantInfo)
+                    vertexShaderConstantSize += getDataTypeSize(info.second);
+
+                vertexShaderConstants.assign(vertexShaderConstantSize / sizeof(float), 0.0F);
             }
         } // namespace opengl
     } // namespace graphics
@@ -22,6 +22,7 @@
 #endif
 
 #include "graphics/opengl/OGLRenderResource.hpp"
+#include "graphics/Commands.hpp"
 #include "graphics/DataType.hpp"
 #include "graphics/Vertex.hpp"
 
@@ -37,15 +38,16 @@ namespace ouzel
             {
             public:
                 Shader(RenderDevice& initRenderDevice,
-                       const std::vector<uint8_t>& initFragmentShader,
-                       const std::vector<uint8_t>& initVertexShader,
-                       const std::set<Vertex::Attribute::Usage>& initVertexAttributes,
-                       const std::vector<std::pair<std::string, DataType>>& initFragmentShaderConstantInfo,
-                       const std::vector<std::pair<std::string, DataType>>& initVertexShaderConstantInfo,
+                       Span<const uint8_t> initFragmentShader,
+                       Span<const uint8_t> initVertexShader,
+                       Span<const Vertex::Attribute::Usage> initVertexAttributes,
+                       Span<const ShaderConstantInfo> initFragmentShaderConstantInfo,
+                       Span<const ShaderConstantInfo> initVertexShaderConstantInfo,
                        uint32_t initFragmentShaderDataAlignment,
                        uint32_t initVertexShaderDataAlignment,
-                       const std::string& fragmentShaderFunction,
-                       const std::string& vertexShaderFunction);
+                       const char* fragmentShaderFunction,
+                       const char* vertexShaderFunction,
+                       Span<const uint8_t> initInstancedVertexShader);
                 ~Shader();
 
                 void reload() final;
@@ -61,20 +63,60 @@ namespace ouzel
                     DataType dataType;
                 };
 
+                // std140 layout of the constants of a stage that are declared in a uniform block
+                struct UniformBlock final
+                {
+                    struct Member final
+                    {
+                        Member(GLint initOffset, GLint initMatrixStride, DataType initDataType):
+                            offset(initOffset), matrixStride(initMatrixStride), dataType(initDataType)
+                        {
+                        }
+
+                        GLint offset;
+                        GLint matrixStride;
+                        DataType dataType;
+                    };
+
+                    GLsizeiptr size = 0; // zero if the constants of the stage are plain uniforms
+                    std::vector<Member> members;
+                };
+
                 inline auto& getVertexAttributes() const noexcept { return vertexAttributes; }
 
                 inline auto& getFragmentShaderConstantLocations() const noexcept { return fragmentShaderConstantLocations; }
                 inline auto& getVertexShaderConstantLocations() const noexcept { return vertexShaderConstantLocations; }
 
+                // values of the uniforms that were last set on the program
+                inline auto& getFragmentShaderConstants() noexcept { return fragmentShaderConstants; }
+                inline auto& getVertexShaderConstants() noexcept { return vertexShaderConstants; }
+
+                inline auto& getFragmentUniformBlock() const noexcept { return fragmentUniformBlock; }
+                inline auto& getVertexUniformBlock() const noexcept { return vertexUniformBlock; }
+
                 inline auto getProgramId() const noexcept { return programId; }
 
+                // program of the instanced vertex shader and the fragment shader, zero if the shader has no
+                // instanced vertex shader or the device can not draw instances
+                inline auto getInstancedProgramId() const noexcept { return instancedProgramId; }
+
+                // fragment uniform block of the instanced program with a white color, zero if the fragment
+                // constants of the shader are plain uniforms
+                inline auto getInstancedUniformBufferId() const noexcept { return instancedUniformBufferId; }
+
             private:
                 void compileShader();
+                GLuint compileShader(GLenum type, const std::vector<uint8_t>& data) const;
+                void linkProgram(GLuint program, bool instanced) const;
                 std::string getShaderMessage(GLuint shaderId) const;
-                std::string getProgramMessage() const;
+                std::string getProgramMessage(GLuint program) const;
+                UniformBlock getUniformBlock(const GLchar* name,
+                                             GLuint binding,
+                                             const std::vector<std::pair<std::string, DataType>>& constantInfo) const;
 
                 std::vector<uint8_t> fragmentShaderData;
                 std::vector<uint8_t> vertexShaderData;
+                std::vector<uint8_t> instancedVertexShaderData;
 
                 std::set<Vertex::Attribute::Usage> vertexAttributes;
 
@@ -84,9 +126,18 @@ namespace ouzel
                 GLuint fragmentShaderId = 0;
                 GLuint vertexShaderId = 0;
                 GLuint programId = 0;
+                GLuint instancedVertexShaderId = 0;
+                GLuint instancedProgramId = 0;
+                GLuint instancedUniformBufferId = 0;
 
                 std::vector<Location> fragmentShaderConstantLocations;
                 std::vector<Location> vertexShaderConstantLocations;
+
+                UniformBlock fragmentUniformBlock;
+                UniformBlock vertexUniformBlock;
+
+                std::vector<float> fragmentShaderConstants;
+                std::vector<float> vertexShaderConstants;
             };
         } // namespace opengl
     } // namespace graphics
@@ -4,6 +4,7 @@
 
 #if OUZEL_COMPILE_OPENGL
 
+#include <algorithm>
 #include <stdexcept>
 #include "OGLTexture.hpp"
 #include "OGLRenderDevice.hpp"
@@ -260,13 +261,12 @@ namespace ouzel
             }
 
             Texture::Texture(RenderDevice& initRenderDevice,
-                             const std::vector<std::pair<Size2U, std::vector<uint8_t>>>& initLevels,
+                             Span<const TextureLevel> initLevels,
                              TextureType type,
                              uint32_t initFlags,
                              uint32_t initSampleCount,
                              PixelFormat initPixelFormat):
                 RenderResource(initRenderDevice),
-                levels(initLevels),
                 flags(initFlags),
                 mipmaps(static_cast<uint32_t>(initLevels.size())),
                 sampleCount(initSampleCount),
@@ -275,6 +275,10 @@ namespace ouzel
                 pixelFormat(getOpenGlPixelFormat(initPixelFormat)),
                 pixelType(getOpenGlPixelType(initPixelFormat))
             {
+                levels.reserve(initLevels.size());
+                for (const TextureLevel& level : initLevels)
+                    levels.emplace_back(level.size, std::vector<uint8_t>(level.data.begin(), level.data.end()));
+
                 if ((flags & Flags::BindRenderTarget) && (mipmaps == 0 || mipmaps > 1))
                     throw std::runtime_error("Invalid mip map count");
 
@@ -381,12 +385,18 @@ namespace ouzel
                 }
             }
 
-            void Texture::setData(const std::vector<std::pair<Size2U, std::vector<uint8_t>>>& newLevels)
+            void Texture::setData(Span<const TextureLevel> newLevels)
             {
                 if (!(flags & Flags::Dynamic) || flags & Flags::BindRenderTarget)
                     throw std::runtime_error("Texture is not dynamic");
 
-                levels = newLevels;
+                // the level vectors are reused, their storage is kept between the updates
+                levels.resize(newLevels.size());
+                for (size_t level = 0; level < newLevels.size(); ++level)
+                {
+                    levels[level].first = newLevels[level].size;
+                    levels[level].second.assign(newLevels[level].data.begin(), newLevels[level].data.end());
+                }
 
                 if (!textureId)
                     throw std::runtime_error("Texture not initialized");
@@ -409,6 +419,44 @@ namespace ouzel
                     throw std::system_error(makeErrorCode(error), "Failed to upload texture data");
             }
 
+            void Texture::setRegionData(uint32_t x, uint32_t y, const Size2U& regionSize, Span<const uint8_t> data)
+            {
+                if (!(flags & Flags::Dynamic) || flags & Flags::BindRenderTarget)
+                    throw std::runtime_error("Texture is not dynamic");
+
+                if (levels.empty() || !regionSize.v[0] || !regionSize.v[1])
+                    return;
+
+                // keep the level data up to date, it is needed to restore the texture after a context loss
+                std::pair<Size2U, std::vector<uint8_t>>& level = levels.front();
+                const size_t pixelSize = data.size() / (regionSize.v[0] * regionSize.v[1]);
+                const size_t rowSize = regionSize.v[0] * pixelSize;
+                const size_t pitch = level.first.v[0] * pixelSize;
+
+                if (level.second.size() >= pitch * level.first.v[1])
+                    for (uint32_t row = 0; row < regionSize.v[1]; ++row)
+                        std::copy(data.begin() + static_cast<std::ptrdiff_t>(row * rowSize),
+                                  data.begin() + static_cast<std::ptrdiff_t>((row + 1) * rowSize),
+                                  level.second.begin() + static_cast<std::ptrdiff_t>((y + row) * pitch + x * pixelSize));
+
+                if (!textureId)
+                    throw std::runtime_error("Texture not initialized");
+
+                renderDevice.bindTexture(textureTarget, 0, textureId);
+
+                renderDevice.glTexSubImage2DProc(GL_TEXTURE_2D, 0,
+                                                 static_cast<GLint>(x), static_cast<GLint>(y),
+                                                 static_cast<GLsizei>(regionSize.v[0]),
+                                                 static_cast<GLsizei>(regionSize.v[1]),
+                                                 pixelFormat, pixelType,
+                                                 data.data());
+
+                GLenum error;
+
+                if ((error = renderDevice.glGetErrorProc()) != GL_NO_ERROR)
+                    throw std::system_error(makeErrorCode(error), "Failed to upload texture region");
+            }
+
             void Texture::setFilter(SamplerFilter newFilter)
             {
                 filter = newFilter;
@@ -23,6 +23,7 @@
 #endif
 
 #include "graphics/opengl/OGLRenderResource.hpp"
+#include "graphics/Commands.hpp"
 #include "graphics/PixelFormat.hpp"
 #include "graphics/SamplerAddressMode.hpp"
 #include "graphics/SamplerFilter.hpp"
@@ -41,7 +42,7 @@ namespace ouzel
             {
             public:
                 Texture(RenderDevice& initRenderDevice,
-                        const std::vector<std::pair<Size2U, std::vector<uint8_t>>>& initLevels,
+                        Span<const TextureLevel> initLevels,
                         TextureType type,
                         uint32_t initFlags = 0,
                         uint32_t initSampleCount = 1,
@@ -50,7 +51,8 @@ namespace ouzel
 
                 void reload() final;
 
-                void setData(const std::vector<std::pair<Size2U, std::vector<uint8_t>>>& newLevels);
+                void setData(Span<const TextureLevel> newLevels);
+                void setRegionData(uint32_t x, uint32_t y, const Size2U& regionSize, Span<const uint8_t> data);
                 void setFilter(SamplerFilter newFilter);
                 void setAddressX(SamplerAddressMode newAddressX);
                 void setAddressY(SamplerAddressMode newAddressY);
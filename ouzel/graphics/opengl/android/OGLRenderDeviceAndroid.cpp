@@ -61,7 +61,7 @@ namespace ouzel
             {
                 running = false;
                 CommandBuffer commandBuffer;
-                commandBuffer.pushCommand(std::make_unique<PresentCommand>());
+                commandBuffer.pushCommand<PresentCommand>();
                 submitCommandBuffer(std::move(commandBuffer));
 
                 if (renderThread.isJoinable()) renderThread.join();
@@ -202,7 +202,7 @@ namespace ouzel
             {
                 running = false;
                 CommandBuffer commandBuffer;
-                commandBuffer.pushCommand(std::make_unique<PresentCommand>());
+                commandBuffer.pushCommand<PresentCommand>();
                 submitCommandBuffer(std::move(commandBuffer));
 
                 if (renderThread.isJoinable()) renderThread.join();
@@ -286,9 +286,10 @@ namespace ouzel
                 frameBufferHeight = surfaceHeight;
 
                 stateCache = StateCache();
+                vertexArrays.clear(); // the vertex arrays were deleted with the context
 
                 glDisableProc(GL_DITHER);
-                glDepthFuncProc(GL_LEQUAL);
+                setDepthFunc(GL_LEQUAL);
 
                 GLenum error;
 
@@ -296,6 +297,7 @@ namespace ouzel
                     throw std::system_error(makeErrorCode(error), "Failed to set depth function");
 
                 if (glGenVertexArraysProc) glGenVertexArraysProc(1, &vertexArrayId);
+                if (isInstancingSupported()) glGenBuffersProc(1, &instanceBufferId);
 
                 for (const std::unique_ptr<RenderResource>& resource : resources)
                     if (resource) resource->invalidate();
@@ -314,7 +316,7 @@ namespace ouzel
             {
                 running = false;
                 CommandBuffer commandBuffer;
-                commandBuffer.pushCommand(std::make_unique<PresentCommand>());
+                commandBuffer.pushCommand<PresentCommand>();
                 submitCommandBuffer(std::move(commandBuffer));
 
                 if (renderThread.isJoinable()) renderThread.join();
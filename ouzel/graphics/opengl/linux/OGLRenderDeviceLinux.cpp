@@ -66,7 +66,7 @@ namespace ouzel
             {
                 running = false;
                 CommandBuffer commandBuffer;
-                commandBuffer.pushCommand(std::make_unique<PresentCommand>());
+                commandBuffer.pushCommand<PresentCommand>();
                 submitCommandBuffer(std::move(commandBuffer));
 
                 if (renderThread.isJoinable()) renderThread.join();
@@ -121,7 +121,7 @@ namespace ouzel
                 if (!glXQueryVersion(engineLinux->getDisplay(), &glxMajor, &glxMinor))
                     throw std::runtime_error("Failed to get GLX version");
 
-                engine->log(Log::Level::All) << "GLX version: " << glxMajor << "." << glxMinor;
+                engine->log<Log::Level::All>() << "GLX version: " << glxMajor << "." << glxMinor;
 
                 Screen* screen = XDefaultScreenOfDisplay(engineLinux->getDisplay());
                 const int screenIndex = XScreenNumberOfScreen(screen);
@@ -137,7 +137,7 @@ namespace ouzel
                 if (const char* extensionsPtr = glXQueryExtensionsString(engineLinux->getDisplay(), screenIndex))
                     extensions = explodeString(std::string(extensionsPtr), ' ');
 
-                engine->log(Log::Level::All) << "Supported GLX extensions: " << extensions;
+                engine->log<Log::Level::All>() << "Supported GLX extensions: " << extensions;
 
                 glXMakeCurrent(engineLinux->getDisplay(), None, nullptr);
                 glXDestroyContext(engineLinux->getDisplay(), tempContext);
@@ -152,7 +152,7 @@ namespace ouzel
             {
                 running = false;
                 CommandBuffer commandBuffer;
-                commandBuffer.pushCommand(std::make_unique<PresentCommand>());
+                commandBuffer.pushCommand<PresentCommand>();
                 submitCommandBuffer(std::move(commandBuffer));
 
                 if (renderThread.isJoinable()) renderThread.join();
@@ -197,7 +197,7 @@ namespace ouzel
                     if (const char* extensionsPtr = wglGetExtensionsStringProc(deviceContext))
                         extensions = explodeString(std::string(extensionsPtr), ' ');
 
-                    engine->log(Log::Level::All) << "Supported WGL extensions: " << extensions;
+                    engine->log<Log::Level::All>() << "Supported WGL extensions: " << extensions;
                 }
 
                 PFNWGLCHOOSEPIXELFORMATARBPROC wglChoosePixelFormatProc = nullptr;
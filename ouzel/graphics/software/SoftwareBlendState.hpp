@@ -0,0 +1,64 @@
+// Copyright 2015-2019 Elviss Strazdins. All rights reserved.
+
+#ifndef OUZEL_GRAPHICS_SOFTWAREBLENDSTATE_HPP
+#define OUZEL_GRAPHICS_SOFTWAREBLENDSTATE_HPP
+
+#include "graphics/software/SoftwareRenderResource.hpp"
+#include "graphics/BlendFactor.hpp"
+#include "graphics/BlendOperation.hpp"
+#include "graphics/ColorMask.hpp"
+
+namespace ouzel
+{
+    namespace graphics
+    {
+        namespace software
+        {
+            class BlendState final: public RenderResource
+            {
+            public:
+                BlendState(RenderDevice& initRenderDevice,
+                           bool initEnableBlending,
+                           BlendFactor initColorBlendSource,
+                           BlendFactor initColorBlendDest,
+                           BlendOperation initColorOperation,
+                           BlendFactor initAlphaBlendSource,
+                           BlendFactor initAlphaBlendDest,
+                           BlendOperation initAlphaOperation,
+                           ColorMask initColorMask):
+                    RenderResource(initRenderDevice),
+                    blendEnabled(initEnableBlending),
+                    colorBlendSource(initColorBlendSource),
+                    colorBlendDest(initColorBlendDest),
+                    colorOperation(initColorOperation),
+                    alphaBlendSource(initAlphaBlendSource),
+                    alphaBlendDest(initAlphaBlendDest),
+                    alphaOperation(initAlphaOperation),
+                    colorMask(initColorMask)
+                {
+                }
+
+                inline auto isBlendEnabled() const noexcept { return blendEnabled; }
+                inline auto getColorBlendSource() const noexcept { return colorBlendSource; }
+                inline auto getColorBlendDest() const noexcept { return colorBlendDest; }
+                inline auto getColorOperation() const noexcept { return colorOperation; }
+                inline auto getAlphaBlendSource() const noexcept { return alphaBlendSource; }
+                inline auto getAlphaBlendDest() const noexcept { return alphaBlendDest; }
+                inline auto getAlphaOperation() const noexcept { return alphaOperation; }
+                inline auto getColorMask() const noexcept { return colorMask; }
+
+            private:
+                bool blendEnabled = false;
+                BlendFactor colorBlendSource = BlendFactor::One;
+                BlendFactor colorBlendDest = BlendFactor::Zero;
+                BlendOperation colorOperation = BlendOperation::Add;
+                BlendFactor alphaBlendSource = BlendFactor::One;
+                BlendFactor alphaBlendDest = BlendFactor::Zero;
+                BlendOperation alphaOperation = BlendOperation::Add;
+                ColorMask colorMask = ColorMask::All;
+            };
+        } // namespace software
+    } // namespace graphics
+} // namespace ouzel
+
+#endif // OUZEL_GRAPHICS_SOFTWAREBLENDSTATE_HPP
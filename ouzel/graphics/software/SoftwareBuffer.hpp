@@ -0,0 +1,63 @@
+// Copyright 2015-2019 Elviss Strazdins. All rights reserved.
+
+#ifndef OUZEL_GRAPHICS_SOFTWAREBUFFER_HPP
+#define OUZEL_GRAPHICS_SOFTWAREBUFFER_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include "graphics/software/SoftwareRenderResource.hpp"
+#include "graphics/BufferType.hpp"
+#include "graphics/Flags.hpp"
+#include "utils/Span.hpp"
+
+namespace ouzel
+{
+    namespace graphics
+    {
+        namespace software
+        {
+            class Buffer final: public RenderResource
+            {
+            public:
+                Buffer(RenderDevice& initRenderDevice,
+                       BufferType initType,
+                       uint32_t initFlags,
+                       Span<const uint8_t> initData,
+                       uint32_t initSize):
+                    RenderResource(initRenderDevice),
+                    type(initType),
+                    flags(initFlags),
+                    data(initData.begin(), initData.end())
+                {
+                    if (data.size() < initSize) data.resize(initSize);
+                }
+
+                void setData(Span<const uint8_t> newData)
+                {
+                    if (!(flags & Flags::Dynamic))
+                        throw std::runtime_error("Buffer is not dynamic");
+
+                    if (newData.empty())
+                        throw std::invalid_argument("Data is empty");
+
+                    // the buffer never shrinks like the buffers of the other drivers
+                    if (newData.size() > data.size()) data.resize(newData.size());
+                    std::copy(newData.begin(), newData.end(), data.begin());
+                }
+
+                inline auto getType() const noexcept { return type; }
+                inline auto getFlags() const noexcept { return flags; }
+                inline auto& getData() const noexcept { return data; }
+
+            private:
+                BufferType type;
+                uint32_t flags = 0;
+                std::vector<uint8_t> data;
+            };
+        } // namespace software
+    } // namespace graphics
+} // namespace ouzel
+
+#endif // OUZEL_GRAPHICS_SOFTWAREBUFFER_HPP
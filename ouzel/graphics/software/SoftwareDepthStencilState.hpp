@@ -0,0 +1,88 @@
+// Copyright 2015-2019 Elviss Strazdins. All rights reserved.
+
+#ifndef OUZEL_GRAPHICS_SOFTWAREDEPTHSTENCILSTATE_HPP
+#define OUZEL_GRAPHICS_SOFTWAREDEPTHSTENCILSTATE_HPP
+
+#include <cstdint>
+#include "graphics/software/SoftwareRenderResource.hpp"
+#include "graphics/CompareFunction.hpp"
+#include "graphics/StencilOperation.hpp"
+
+namespace ouzel
+{
+    namespace graphics
+    {
+        namespace software
+        {
+            class DepthStencilState final: public RenderResource
+            {
+            public:
+                struct StencilFace final
+                {
+                    StencilOperation failureOperation = StencilOperation::Keep;
+                    StencilOperation depthFailureOperation = StencilOperation::Keep;
+                    StencilOperation passOperation = StencilOperation::Keep;
+                    CompareFunction compareFunction = CompareFunction::AlwaysPass;
+                };
+
+                DepthStencilState(RenderDevice& initRenderDevice,
+                                  bool initDepthTest,
+                                  bool initDepthWrite,
+                                  CompareFunction initCompareFunction,
+                                  bool initStencilEnabled,
+                                  uint32_t initStencilReadMask,
+                                  uint32_t initStencilWriteMask,
+                                  StencilOperation initFrontFaceStencilFailureOperation,
+                                  StencilOperation initFrontFaceStencilDepthFailureOperation,
+                                  StencilOperation initFrontFaceStencilPassOperation,
+                                  CompareFunction initFrontFaceStencilCompareFunction,
+                                  StencilOperation initBackFaceStencilFailureOperation,
+                                  StencilOperation initBackFaceStencilDepthFailureOperation,
+                                  StencilOperation initBackFaceStencilPassOperation,
+                                  CompareFunction initBackFaceStencilCompareFunction):
+                    RenderResource(initRenderDevice),
+                    depthTest(initDepthTest),
+                    depthWrite(initDepthWrite),
+                    compareFunction(initCompareFunction),
+                    stencilTest(initStencilEnabled),
+                    stencilReadMask(static_cast<uint8_t>(initStencilReadMask)),
+                    stencilWriteMask(static_cast<uint8_t>(initStencilWriteMask)),
+                    frontFace{
+                        initFrontFaceStencilFailureOperation,
+                        initFrontFaceStencilDepthFailureOperation,
+                        initFrontFaceStencilPassOperation,
+                        initFrontFaceStencilCompareFunction
+                    },
+                    backFace{
+                        initBackFaceStencilFailureOperation,
+                        initBackFaceStencilDepthFailureOperation,
+                        initBackFaceStencilPassOperation,
+                        initBackFaceStencilCompareFunction
+                    }
+                {
+                }
+
+                inline auto getDepthTest() const noexcept { return depthTest; }
+                inline auto getDepthWrite() const noexcept { return depthWrite; }
+                inline auto getCompareFunction() const noexcept { return compareFunction; }
+                inline auto getStencilTest() const noexcept { return stencilTest; }
+                inline auto getStencilReadMask() const noexcept { return stencilReadMask; }
+                inline auto getStencilWriteMask() const noexcept { return stencilWriteMask; }
+                inline auto& getFrontFace() const noexcept { return frontFace; }
+                inline auto& getBackFace() const noexcept { return backFace; }
+
+            private:
+                bool depthTest = false;
+                bool depthWrite = false;
+                CompareFunction compareFunction = CompareFunction::AlwaysPass;
+                bool stencilTest = false;
+                uint8_t stencilReadMask = 0xFF;
+                uint8_t stencilWriteMask = 0xFF;
+                StencilFace frontFace;
+                StencilFace backFace;
+            };
+        } // namespace software
+    } // namespace graphics
+} // namespace ouzel
+
+#endif // OUZEL_GRAPHICS_SOFTWAREDEPTHSTENCILSTATE_HPP
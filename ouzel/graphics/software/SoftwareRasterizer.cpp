@@ -0,0 +1,1060 @@
+// Copyright 2015-2019 Elviss Strazdins. All rights reserved.
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#if defined(__ARM_NEON__)
+#  include <arm_neon.h>
+#elif defined(__SSE2__)
+#  include <emmintrin.h>
+#endif
+#include "SoftwareRasterizer.hpp"
+#include "SoftwareTexture.hpp"
+#include "math/MathUtils.hpp"
+
+namespace ouzel
+{
+    namespace graphics
+    {
+        namespace software
+        {
+            namespace
+            {
+                // the clip space guard band keeps the fixed-point coordinates in range
+                constexpr float GUARD_BAND = 2.0F;
+                constexpr float MIN_W = 0.00001F;
+                constexpr size_t CLIP_PLANE_COUNT = 7;
+                constexpr size_t MAX_POLYGON_VERTICES = 3 + CLIP_PLANE_COUNT;
+                constexpr size_t MAX_BINNED_TRIANGLES = 65536;
+                constexpr float SUBPIXEL_SCALE = static_cast<float>(1 << Rasterizer::SUBPIXEL_BITS);
+                constexpr int64_t HALF_PIXEL = 1 << (Rasterizer::SUBPIXEL_BITS - 1);
+
+                alignas(16) constexpr float LANE_OFFSETS[4] = {0.0F, 1.0F, 2.0F, 3.0F};
+
+                struct ScalarInt4 final
+                {
+                    int32_t v[4];
+
+                    static inline ScalarInt4 splat(int32_t value) noexcept { return {{value, value, value, value}}; }
+                    static inline ScalarInt4 load(const int32_t* values) noexcept { return {{values[0], values[1], values[2], values[3]}}; }
+
+                    inline ScalarInt4 operator+(const ScalarInt4& other) const noexcept
+                    {
+                        return {{v[0] + other.v[0], v[1] + other.v[1], v[2] + other.v[2], v[3] + other.v[3]}};
+                    }
+
+                    // lanes of the result are all ones for the lanes that are greater
+                    inline ScalarInt4 operator>(const ScalarInt4& other) const noexcept
+                    {
+                        return {{v[0] > other.v[0] ? -1 : 0, v[1] > other.v[1] ? -1 : 0,
+                            v[2] > other.v[2] ? -1 : 0, v[3] > other.v[3] ? -1 : 0}};
+                    }
+
+                    inline uint32_t getMask() const noexcept
+                    {
+                        return (v[0] ? 1U : 0U) | (v[1] ? 2U : 0U) | (v[2] ? 4U : 0U) | (v[3] ? 8U : 0U);
+                    }
+                };
+
+                struct ScalarFloat4 final
+                {
+                    using Int4 = ScalarInt4;
+
+                    float v[4];
+
+                    static inline ScalarFloat4 splat(float value) noexcept { return {{value, value, value, value}}; }
+                    static inline ScalarFloat4 load(const float* values) noexcept { return {{values[0], values[1], values[2], values[3]}}; }
+                    inline void store(float* values) const noexcept { std::copy(std::begin(v), std::end(v), values); }
+
+                    template <class Operation>
+                    inline ScalarFloat4 apply(const ScalarFloat4& other, Operation operation) const noexcept
+                    {
+                        return {{operation(v[0], other.v[0]), operation(v[1], other.v[1]),
+                            operation(v[2], other.v[2]), operation(v[3], other.v[3])}};
+                    }
+
+                    template <class Operation>
+                    inline ScalarInt4 compare(const ScalarFloat4& other, Operation operation) const noexcept
+                    {
+                        return {{operation(v[0], other.v[0]) ? -1 : 0, operation(v[1], other.v[1]) ? -1 : 0,
+                            operation(v[2], other.v[2]) ? -1 : 0, operation(v[3], other.v[3]) ? -1 : 0}};
+                    }
+
+                    inline ScalarFloat4 operator+(const ScalarFloat4& o) const noexcept { return apply(o, [](float a, float b) noexcept { return a + b; }); }
+                    inline ScalarFloat4 operator-(const ScalarFloat4& o) const noexcept { return apply(o, [](float a, float b) noexcept { return a - b; }); }
+                    inline ScalarFloat4 operator*(const ScalarFloat4& o) const noexcept { return apply(o, [](float a, float b) noexcept { return a * b; }); }
+                    inline ScalarFloat4 operator/(const ScalarFloat4& o) const noexcept { return apply(o, [](float a, float b) noexcept { return a / b; }); }
+
+                    inline ScalarInt4 operator<(const ScalarFloat4& o) const noexcept { return compare(o, [](float a, float b) noexcept { return a < b; }); }
+                    inline ScalarInt4 operator<=(const ScalarFloat4& o) const noexcept { return compare(o, [](float a, float b) noexcept { return a <= b; }); }
+                    inline ScalarInt4 operator>(const ScalarFloat4& o) const noexcept { return compare(o, [](float a, float b) noexcept { return a > b; }); }
+                    inline ScalarInt4 operator>=(const ScalarFloat4& o) const noexcept { return compare(o, [](float a, float b) noexcept { return a >= b; }); }
+                    inline ScalarInt4 operator==(const ScalarFloat4& o) const noexcept { return compare(o, [](float a, float b) noexcept { return a == b; }); }
+                    inline ScalarInt4 operator!=(const ScalarFloat4& o) const noexcept { return compare(o, [](float a, float b) noexcept { return a != b; }); }
+
+                    static inline ScalarFloat4 min(const ScalarFloat4& a, const ScalarFloat4& b) noexcept
+                    {
+                        return a.apply(b, [](float x, float y) noexcept { return y < x ? y : x; });
+                    }
+
+                    static inline ScalarFloat4 max(const ScalarFloat4& a, const ScalarFloat4& b) noexcept
+                    {
+                        return a.apply(b, [](float x, float y) noexcept { return x < y ? y : x; });
+                    }
+                };
+
+#if defined(__ARM_NEON__)
+                struct SimdInt4 final
+                {
+                    int32x4_t v;
+
+                    static inline SimdInt4 splat(int32_t value) noexcept { return {vdupq_n_s32(value)}; }
+                    static inline SimdInt4 load(const int32_t* values) noexcept { return {vld1q_s32(values)}; }
+
+                    inline SimdInt4 operator+(const SimdInt4& other) const noexcept { return {vaddq_s32(v, other.v)}; }
+                    inline SimdInt4 operator>(const SimdInt4& other) const noexcept { return {vreinterpretq_s32_u32(vcgtq_s32(v, other.v))}; }
+
+                    inline uint32_t getMask() const noexcept
+                    {
+                        const uint32x4_t bits = vshrq_n_u32(vreinterpretq_u32_s32(v), 31);
+                        return vgetq_lane_u32(bits, 0) | (vgetq_lane_u32(bits, 1) << 1) |
+                            (vgetq_lane_u32(bits, 2) << 2) | (vgetq_lane_u32(bits, 3) << 3);
+                    }
+                };
+
+                struct SimdFloat4 final
+                {
+                    using Int4 = SimdInt4;
+
+                    float32x4_t v;
+
+                    static inline SimdFloat4 splat(float value) noexcept { return {vdupq_n_f32(value)}; }
+                    static inline SimdFloat4 load(const float* values) noexcept { return {vld1q_f32(values)}; }
+                    inline void store(float* values) const noexcept { vst1q_f32(values, v); }
+
+                    inline SimdFloat4 operator+(const SimdFloat4& o) const noexcept { return {vaddq_f32(v, o.v)}; }
+                    inline SimdFloat4 operator-(const SimdFloat4& o) const noexcept { return {vsubq_f32(v, o.v)}; }
+                    inline SimdFloat4 operator*(const SimdFloat4& o) const noexcept { return {vmulq_f32(v, o.v)}; }
+                    inline SimdFloat4 operator/(const SimdFloat4& o) const noexcept
+                    {
+                        // reciprocal estimate refined with two Newton-Raphson steps
+                        float32x4_t reciprocal = vrecpeq_f32(o.v);
+                        reciprocal = vmulq_f32(vrecpsq_f32(o.v, reciprocal), reciprocal);
+                        reciprocal = vmulq_f32(vrecpsq_f32(o.v, reciprocal), reciprocal);
+                        return {vmulq_f32(v, reciprocal)};
+                    }
+
+                    inline SimdInt4 operator<(const SimdFloat4& o) const noexcept { return {vreinterpretq_s32_u32(vcltq_f32(v, o.v))}; }
+                    inline SimdInt4 operator<=(const SimdFloat4& o) const noexcept { return {vreinterpretq_s32_u32(vcleq_f32(v, o.v))}; }
+                    inline SimdInt4 operator>(const SimdFloat4& o) const noexcept { return {vreinterpretq_s32_u32(vcgtq_f32(v, o.v))}; }
+                    inline SimdInt4 operator>=(const SimdFloat4& o) const noexcept { return {vreinterpretq_s32_u32(vcgeq_f32(v, o.v))}; }
+                    inline SimdInt4 operator==(const SimdFloat4& o) const noexcept { return {vreinterpretq_s32_u32(vceqq_f32(v, o.v))}; }
+                    inline SimdInt4 operator!=(const SimdFloat4& o) const noexcept { return {vreinterpretq_s32_u32(vmvnq_u32(vceqq_f32(v, o.v)))}; }
+
+                    static inline SimdFloat4 min(const SimdFloat4& a, const SimdFloat4& b) noexcept { return {vminq_f32(a.v, b.v)}; }
+                    static inline SimdFloat4 max(const SimdFloat4& a, const SimdFloat4& b) noexcept { return {vmaxq_f32(a.v, b.v)}; }
+                };
+#elif defined(__SSE2__)
+                struct SimdInt4 final
+                {
+                    __m128i v;
+
+                    static inline SimdInt4 splat(int32_t value) noexcept { return {_mm_set1_epi32(value)}; }
+                    static inline SimdInt4 load(const int32_t* values) noexcept { return {_mm_loadu_si128(reinterpret_cast<const __m128i*>(values))}; }
+
+                    inline SimdInt4 operator+(const SimdInt4& other) const noexcept { return {_mm_add_epi32(v, other.v)}; }
+                    inline SimdInt4 operator>(const SimdInt4& other) const noexcept { return {_mm_cmpgt_epi32(v, other.v)}; }
+
+                    inline uint32_t getMask() const noexcept
+                    {
+                        return static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(v)));
+                    }
+                };
+
+                struct SimdFloat4 final
+                {
+                    using Int4 = SimdInt4;
+
+                    __m128 v;
+
+                    static inline SimdFloat4 splat(float value) noexcept { return {_mm_set1_ps(value)}; }
+                    static inline SimdFloat4 load(const float* values) noexcept { return {_mm_loadu_ps(values)}; }
+                    inline void store(float* values) const noexcept { _mm_storeu_ps(values, v); }
+
+                    inline SimdFloat4 operator+(const SimdFloat4& o) const noexcept { return {_mm_add_ps(v, o.v)}; }
+                    inline SimdFloat4 operator-(const SimdFloat4& o) const noexcept { return {_mm_sub_ps(v, o.v)}; }
+                    inline SimdFloat4 operator*(const SimdFloat4& o) const noexcept { return {_mm_mul_ps(v, o.v)}; }
+                    inline SimdFloat4 operator/(const SimdFloat4& o) const noexcept { return {_mm_div_ps(v, o.v)}; }
+
+                    inline SimdInt4 operator<(const SimdFloat4& o) const noexcept { return {_mm_castps_si128(_mm_cmplt_ps(v, o.v))}; }
+                    inline SimdInt4 operator<=(const SimdFloat4& o) const noexcept { return {_mm_castps_si128(_mm_cmple_ps(v, o.v))}; }
+                    inline SimdInt4 operator>(const SimdFloat4& o) const noexcept { return {_mm_castps_si128(_mm_cmpgt_ps(v, o.v))}; }
+                    inline SimdInt4 operator>=(const SimdFloat4& o) const noexcept { return {_mm_castps_si128(_mm_cmpge_ps(v, o.v))}; }
+                    inline SimdInt4 operator==(const SimdFloat4& o) const noexcept { return {_mm_castps_si128(_mm_cmpeq_ps(v, o.v))}; }
+                    inline SimdInt4 operator!=(const SimdFloat4& o) const noexcept { return {_mm_castps_si128(_mm_cmpneq_ps(v, o.v))}; }
+
+                    static inline SimdFloat4 min(const SimdFloat4& a, const SimdFloat4& b) noexcept { return {_mm_min_ps(b.v, a.v)}; }
+                    static inline SimdFloat4 max(const SimdFloat4& a, const SimdFloat4& b) noexcept { return {_mm_max_ps(b.v, a.v)}; }
+                };
+#endif
+
+                // rounds towards negative infinity unlike the division operator
+                inline int64_t floorDivide(int64_t a, int64_t b) noexcept
+                {
+                    return (a >= 0) ? a / b : -((-a + b - 1) / b);
+                }
+
+                float getPlaneDistance(const Rasterizer::Vertex& vertex, size_t plane) noexcept
+                {
+                    const float* position = vertex.position;
+
+                    switch (plane)
+                    {
+                        case 0: return position[3] - MIN_W;
+                        case 1: return position[2]; // near plane at z = 0
+                        case 2: return position[3] - position[2];
+                        case 3: return GUARD_BAND * position[3] + position[0];
+                        case 4: return GUARD_BAND * position[3] - position[0];
+                        case 5: return GUARD_BAND * position[3] + position[1];
+                        default: return GUARD_BAND * position[3] - position[1];
+                    }
+                }
+
+                uint32_t getOutcode(const Rasterizer::Vertex& vertex) noexcept
+                {
+                    uint32_t result = 0;
+                    for (size_t plane = 0; plane < CLIP_PLANE_COUNT; ++plane)
+                        if (getPlaneDistance(vertex, plane) < 0.0F)
+                            result |= 1U << plane;
+                    return result;
+                }
+
+                Rasterizer::Vertex interpolate(const Rasterizer::Vertex& vertex0, const Rasterizer::Vertex& vertex1, float t) noexcept
+                {
+                    Rasterizer::Vertex result;
+                    for (size_t i = 0; i < 4; ++i)
+                    {
+                        result.position[i] = vertex0.position[i] + (vertex1.position[i] - vertex0.position[i]) * t;
+                        result.color[i] = vertex0.color[i] + (vertex1.color[i] - vertex0.color[i]) * t;
+                    }
+                    for (size_t i = 0; i < 2; ++i)
+                        result.texCoord[i] = vertex0.texCoord[i] + (vertex1.texCoord[i] - vertex0.texCoord[i]) * t;
+                    return result;
+                }
+
+                template <class F>
+                void computePlanes(const float (&attributes)[3][8], const float (&weights)[3][3], float (&planes)[3][8]) noexcept
+                {
+                    for (size_t i = 0; i < 8; i += 4)
+                    {
+                        const F attributes0 = F::load(attributes[0] + i);
+                        const F attributes1 = F::load(attributes[1] + i);
+                        const F attributes2 = F::load(attributes[2] + i);
+
+                        for (size_t plane = 0; plane < 3; ++plane)
+                            (attributes0 * F::splat(weights[0][plane]) +
+                             attributes1 * F::splat(weights[1][plane]) +
+                             attributes2 * F::splat(weights[2][plane])).store(planes[plane] + i);
+                    }
+                }
+
+                template <class F>
+                typename F::Int4 compare(CompareFunction compareFunction, const F& a, const F& b) noexcept
+                {
+                    switch (compareFunction)
+                    {
+                        case CompareFunction::NeverPass: return F::Int4::splat(0);
+                        case CompareFunction::PassIfLess: return a < b;
+                        case CompareFunction::PassIfEqual: return a == b;
+                        case CompareFunction::PassIfLessEqual: return a <= b;
+                        case CompareFunction::PassIfGreater: return a > b;
+                        case CompareFunction::PassIfNotEqual: return a != b;
+                        case CompareFunction::PassIfGreaterEqual: return a >= b;
+                        case CompareFunction::AlwaysPass: return F::Int4::splat(-1);
+                        default: return F::Int4::splat(0);
+                    }
+                }
+
+                bool compareStencil(CompareFunction compareFunction, uint8_t a, uint8_t b) noexcept
+                {
+                    switch (compareFunction)
+                    {
+                        case CompareFunction::NeverPass: return false;
+                        case CompareFunction::PassIfLess: return a < b;
+                        case CompareFunction::PassIfEqual: return a == b;
+                        case CompareFunction::PassIfLessEqual: return a <= b;
+                        case CompareFunction::PassIfGreater: return a > b;
+                        case CompareFunction::PassIfNotEqual: return a != b;
+                        case CompareFunction::PassIfGreaterEqual: return a >= b;
+                        case CompareFunction::AlwaysPass: return true;
+                        default: return false;
+                    }
+                }
+
+                uint8_t applyStencilOperation(StencilOperation operation, uint8_t value,
+                                              uint8_t reference, uint8_t writeMask) noexcept
+                {
+                    uint8_t result = value;
+
+                    switch (operation)
+                    {
+                        case StencilOperation::Keep: break;
+                        case StencilOperation::Zero: result = 0; break;
+                        case StencilOperation::Replace: result = reference; break;
+                        case StencilOperation::IncrementClamp: if (result < 255) ++result; break;
+                        case StencilOperation::DecrementClamp: if (result > 0) --result; break;
+                        case StencilOperation::Invert: result = static_cast<uint8_t>(~result); break;
+                        case StencilOperation::IncrementWrap: ++result; break;
+                        case StencilOperation::DecrementWrap: --result; break;
+                        default: break;
+                    }
+
+                    return static_cast<uint8_t>((value & ~writeMask) | (result & writeMask));
+                }
+
+                template <class F>
+                F getBlendFactor(BlendFactor blendFactor, const F (&source)[4], const F (&destination)[4], size_t channel) noexcept
+                {
+                    const F one = F::splat(1.0F);
+
+                    switch (blendFactor)
+                    {
+                        case BlendFactor::Zero: return F::splat(0.0F);
+                        case BlendFactor::One: return one;
+                        case BlendFactor::SrcColor: return source[channel];
+                        case BlendFactor::InvSrcColor: return one - source[channel];
+                        case BlendFactor::SrcAlpha: return source[3];
+                        case BlendFactor::InvSrcAlpha: return one - source[3];
+                        case BlendFactor::DestAlpha: return destination[3];
+                        case BlendFactor::InvDestAlpha: return one - destination[3];
+                        case BlendFactor::DestColor: return destination[channel];
+                        case BlendFactor::InvDestColor: return one - destination[channel];
+                        case BlendFactor::SrcAlphaSat: return (channel == 3) ? one : F::min(source[3], one - destination[3]);
+                        // the blend factor can not be set, so it is white
+                        case BlendFactor::BlendFactor: return one;
+                        case BlendFactor::InvBlendFactor: return F::splat(0.0F);
+                        default: return one;
+                    }
+                }
+
+                template <class F>
+                F blend(BlendOperation blendOperation, BlendFactor sourceFactor, BlendFactor destinationFactor,
+                        const F (&source)[4], const F (&destination)[4], size_t channel) noexcept
+                {
+                    switch (blendOperation)
+                    {
+                        case BlendOperation::Add:
+                            return source[channel] * getBlendFactor(sourceFactor, source, destination, channel) +
+                                destination[channel] * getBlendFactor(destinationFactor, source, destination, channel);
+                        case BlendOperation::Subtract:
+                            return source[channel] * getBlendFactor(sourceFactor, source, destination, channel) -
+                                destination[channel] * getBlendFactor(destinationFactor, source, destination, channel);
+                        case BlendOperation::RevSubtract:
+                            return destination[channel] * getBlendFactor(destinationFactor, source, destination, channel) -
+                                source[channel] * getBlendFactor(sourceFactor, source, destination, channel);
+                        case BlendOperation::Min:
+                            return F::min(source[channel], destination[channel]);
+                        case BlendOperation::Max:
+                            return F::max(source[channel], destination[channel]);
+                        default:
+                            return source[channel];
+                    }
+                }
+
+                // shades up to four horizontally adjacent pixels, the coverage has a bit for every pixel
+                template <class F>
+                void shadePixels(const Rasterizer::FrameBuffer& frameBuffer,
+                                 const Rasterizer::DrawState& state,
+                                 const Rasterizer::Triangle& triangle,
+                                 int32_t x, int32_t y, uint32_t coverage)
+                {
+                    const size_t pixelIndex = static_cast<size_t>(y) * frameBuffer.width + static_cast<size_t>(x);
+                    const F offsetX = F::splat(static_cast<float>(x - triangle.minX)) + F::load(LANE_OFFSETS);
+                    const F offsetY = F::splat(static_cast<float>(y - triangle.minY));
+
+                    const auto interpolateAttribute = [&triangle, &offsetX, &offsetY](size_t attribute) noexcept {
+                        return F::splat(triangle.planes[0][attribute]) +
+                            F::splat(triangle.planes[1][attribute]) * offsetX +
+                            F::splat(triangle.planes[2][attribute]) * offsetY;
+                    };
+
+                    // depth and stencil tests
+                    uint32_t depthPass = coverage;
+                    alignas(16) float depth[4] = {0.0F, 0.0F, 0.0F, 0.0F};
+
+                    if (state.depthTest && frameBuffer.depth)
+                    {
+                        F::min(F::max(interpolateAttribute(0), F::splat(0.0F)), F::splat(1.0F)).store(depth);
+
+                        alignas(16) float destinationDepth[4] = {0.0F, 0.0F, 0.0F, 0.0F};
+                        for (uint32_t lane = 0; lane < 4; ++lane)
+                            if (coverage & (1U << lane))
+                                destinationDepth[lane] = frameBuffer.depth[pixelIndex + lane];
+
+                        depthPass &= compare(state.depthFunction, F::load(depth), F::load(destinationDepth)).getMask();
+                    }
+
+                    uint32_t pass = depthPass;
+
+                    if (state.stencilTest && frameBuffer.stencil)
+                    {
+                        const Rasterizer::StencilFace& face = triangle.frontFacing ? state.frontFace : state.backFace;
+                        const auto reference = static_cast<uint8_t>(state.stencilReference & state.stencilReadMask);
+                        pass = 0;
+
+                        for (uint32_t lane = 0; lane < 4; ++lane)
+                            if (coverage & (1U << lane))
+                            {
+                                uint8_t& stencil = frameBuffer.stencil[pixelIndex + lane];
+                                const bool stencilPass = compareStencil(face.compareFunction, reference,
+                                                                        static_cast<uint8_t>(stencil & state.stencilReadMask));
+                                const StencilOperation operation = !stencilPass ? face.failureOperation :
+                                    (depthPass & (1U << lane)) ? face.passOperation : face.depthFailureOperation;
+
+                                stencil = applyStencilOperation(operation, stencil, state.stencilReference, state.stencilWriteMask);
+
+                                if (stencilPass && (depthPass & (1U << lane)))
+                                    pass |= 1U << lane;
+                            }
+                    }
+
+                    if (!pass) return;
+
+                    if (state.depthTest && state.depthWrite && frameBuffer.depth)
+                        for (uint32_t lane = 0; lane < 4; ++lane)
+                            if (pass & (1U << lane))
+                                frameBuffer.depth[pixelIndex + lane] = depth[lane];
+
+                    // the color and texture programs
+                    F source[4];
+                    F u;
+                    F v;
+
+                    if (triangle.perspective)
+                    {
+                        const F w = F::splat(1.0F) / interpolateAttribute(1);
+                        for (size_t channel = 0; channel < 4; ++channel)
+                            source[channel] = interpolateAttribute(2 + channel) * w;
+                        u = interpolateAttribute(6) * w;
+                        v = interpolateAttribute(7) * w;
+                    }
+                    else
+                    {
+                        for (size_t channel = 0; channel < 4; ++channel)
+                            source[channel] = interpolateAttribute(2 + channel);
+                        u = interpolateAttribute(6);
+                        v = interpolateAttribute(7);
+                    }
+
+                    for (size_t channel = 0; channel < 4; ++channel)
+                        source[channel] = source[channel] * F::splat(state.color[channel]);
+
+                    if (state.texture)
+                    {
+                        alignas(16) float texCoordU[4];
+                        alignas(16) float texCoordV[4];
+                        alignas(16) float texels[4][4] = {};
+                        u.store(texCoordU);
+                        v.store(texCoordV);
+
+                        for (uint32_t lane = 0; lane < 4; ++lane)
+                            if (pass & (1U << lane))
+                            {
+                                float texel[4];
+                                state.texture->sample(texCoordU[lane], texCoordV[lane], triangle.lod, texel);
+                                for (size_t channel = 0; channel < 4; ++channel)
+                                    texels[channel][lane] = texel[channel];
+                            }
+
+                        for (size_t channel = 0; channel < 4; ++channel)
+                            source[channel] = source[channel] * F::load(texels[channel]);
+                    }
+
+                    const F zero = F::splat(0.0F);
+                    const F one = F::splat(1.0F);
+
+                    for (size_t channel = 0; channel < 4; ++channel)
+                        source[channel] = F::min(F::max(source[channel], zero), one);
+
+                    // blending
+                    uint8_t* color = frameBuffer.color + pixelIndex * 4;
+                    F result[4];
+
+                    if (state.blendEnabled)
+                    {
+                        alignas(16) float destinationColor[4][4] = {};
+                        for (uint32_t lane = 0; lane < 4; ++lane)
+                            if (pass & (1U << lane))
+                                for (size_t channel = 0; channel < 4; ++channel)
+                                    destinationColor[channel][lane] = color[lane * 4 + channel];
+
+                        const F scale = F::splat(1.0F / 255.0F);
+                        const F destination[4] = {
+                            F::load(destinationColor[0]) * scale,
+                            F::load(destinationColor[1]) * scale,
+                            F::load(destinationColor[2]) * scale,
+                            F::load(destinationColor[3]) * scale
+                        };
+
+                        for (size_t channel = 0; channel < 3; ++channel)
+                            result[channel] = blend(state.colorOperation, state.colorBlendSource, state.colorBlendDest,
+                                                    source, destination, channel);
+
+                        result[3] = blend(state.alphaOperation, state.alphaBlendSource, state.alphaBlendDest,
+                                          source, destination, 3);
+                    }
+                    else
+                        std::copy(std::begin(source), std::end(source), std::begin(result));
+
+                    alignas(16) float resultColor[4][4];
+                    const F maxValue = F::splat(255.0F);
+                    const F half = F::splat(0.5F);
+
+                    for (size_t channel = 0; channel < 4; ++channel)
+                        (F::min(F::max(result[channel], zero), one) * maxValue + half).store(resultColor[channel]);
+
+                    for (uint32_t lane = 0; lane < 4; ++lane)
+                        if (pass & (1U << lane))
+                            for (size_t channel = 0; channel < 4; ++channel)
+                                if (state.colorMask & (1U << channel))
+                                    color[lane * 4 + channel] = static_cast<uint8_t>(resultColor[channel][lane]);
+                }
+
+                template <class F>
+                void shadeTile(const Rasterizer::FrameBuffer& frameBuffer,
+                               const std::vector<Rasterizer::DrawState>& states,
+                               const std::vector<Rasterizer::Triangle>& triangles,
+                               const std::vector<uint32_t>& bin,
+                               int32_t tileX, int32_t tileY)
+                {
+                    using I = typename F::Int4;
+
+                    const int32_t tileMinX = tileX * Rasterizer::TILE_SIZE;
+                    const int32_t tileMinY = tileY * Rasterizer::TILE_SIZE;
+                    const int32_t tileMaxX = std::min(tileMinX + Rasterizer::TILE_SIZE, static_cast<int32_t>(frameBuffer.width)) - 1;
+                    const int32_t tileMaxY = std::min(tileMinY + Rasterizer::TILE_SIZE, static_cast<int32_t>(frameBuffer.height)) - 1;
+
+                    for (const uint32_t triangleIndex : bin)
+                    {
+                        const Rasterizer::Triangle& triangle = triangles[triangleIndex];
+                        const Rasterizer::DrawState& state = states[triangle.state];
+
+                        const int32_t minX = std::max(tileMinX, triangle.minX);
+                        const int32_t minY = std::max(tileMinY, triangle.minY);
+                        const int32_t maxX = std::min(tileMaxX, triangle.maxX);
+                        const int32_t maxY = std::min(tileMaxY, triangle.maxY);
+
+                        if (minX > maxX || minY > maxY) continue;
+
+                        // an edge that does not cross the rectangle either rejects the triangle or covers the whole
+                        // rectangle, the values of the edges that cross it fit into 32 bits
+                        int32_t edgeValues[3];
+                        int32_t edgeStepX[3];
+                        int32_t edgeStepY[3];
+                        size_t edgeCount = 0;
+                        bool rejected = false;
+
+                        for (size_t edge = 0; edge < 3; ++edge)
+                        {
+                            const int64_t value = triangle.edgeConstants[edge] +
+                                static_cast<int64_t>(triangle.edgeStepX[edge]) * minX +
+                                static_cast<int64_t>(triangle.edgeStepY[edge]) * minY;
+                            const int64_t deltaX = static_cast<int64_t>(triangle.edgeStepX[edge]) * (maxX - minX + 3);
+                            const int64_t deltaY = static_cast<int64_t>(triangle.edgeStepY[edge]) * (maxY - minY);
+
+                            if (value + std::max(deltaX, int64_t(0)) + std::max(deltaY, int64_t(0)) < 0)
+                            {
+                                rejected = true;
+                                break;
+                            }
+
+                            if (value + std::min(deltaX, int64_t(0)) + std::min(deltaY, int64_t(0)) < 0)
+                            {
+                                edgeValues[edgeCount] = static_cast<int32_t>(value);
+                                edgeStepX[edgeCount] = triangle.edgeStepX[edge];
+                                edgeStepY[edgeCount] = triangle.edgeStepY[edge];
+                                ++edgeCount;
+                            }
+                        }
+
+                        if (rejected) continue;
+
+                        I laneSteps[3];
+                        for (size_t edge = 0; edge < edgeCount; ++edge)
+                        {
+                            const int32_t steps[4] = {0, edgeStepX[edge], edgeStepX[edge] * 2, edgeStepX[edge] * 3};
+                            laneSteps[edge] = I::load(steps);
+                        }
+
+                        const I minusOne = I::splat(-1);
+
+                        for (int32_t y = minY; y <= maxY; ++y)
+                        {
+                            for (int32_t x = minX; x <= maxX; x += 4)
+                            {
+                                uint32_t coverage = (1U << std::min(maxX - x + 1, 4)) - 1U;
+
+                                for (size_t edge = 0; edge < edgeCount && coverage; ++edge)
+                                {
+                                    const int32_t value = edgeValues[edge] +
+                                        edgeStepX[edge] * (x - minX) + edgeStepY[edge] * (y - minY);
+                                    coverage &= ((I::splat(value) + laneSteps[edge]) > minusOne).getMask();
+                                }
+
+                                if (coverage)
+                                    shadePixels<F>(frameBuffer, state, triangle, x, y, coverage);
+                            }
+                        }
+                    }
+                }
+            }
+
+            constexpr int32_t Rasterizer::TILE_SIZE;
+            constexpr int32_t Rasterizer::SUBPIXEL_BITS;
+            constexpr uint32_t Rasterizer::MAX_FRAME_BUFFER_SIZE;
+
+            Rasterizer::Rasterizer()
+            {
+#if !defined(__EMSCRIPTEN__)
+                // the thread that flushes the rasterizer shades the tiles too
+                const uint32_t workerCount = std::max(std::thread::hardware_concurrency(), 1U) - 1;
+
+                for (uint32_t i = 0; i < workerCount; ++i)
+                    workers.emplace_back(&Rasterizer::workerMain, this);
+#endif
+            }
+
+            Rasterizer::~Rasterizer()
+            {
+                std::unique_lock<std::mutex> lock(jobMutex);
+                running = false;
+                lock.unlock();
+                jobCondition.notify_all();
+
+                for (Thread& worker : workers)
+                    if (worker.isJoinable()) worker.join();
+            }
+
+            void Rasterizer::setFrameBuffer(const FrameBuffer& newFrameBuffer)
+            {
+                flush();
+
+                if (newFrameBuffer.width > MAX_FRAME_BUFFER_SIZE || newFrameBuffer.height > MAX_FRAME_BUFFER_SIZE)
+                    throw std::runtime_error("Frame buffer is too big");
+
+                frameBuffer = newFrameBuffer;
+                tileCountX = (static_cast<int32_t>(frameBuffer.width) + TILE_SIZE - 1) / TILE_SIZE;
+                tileCountY = (static_cast<int32_t>(frameBuffer.height) + TILE_SIZE - 1) / TILE_SIZE;
+                bins.resize(static_cast<size_t>(tileCountX * tileCountY));
+            }
+
+            void Rasterizer::clear(bool clearColor, const std::array<float, 4>& color,
+                                   bool clearDepth, float depth,
+                                   bool clearStencil, uint8_t stencil)
+            {
+                flush();
+
+                const size_t pixelCount = static_cast<size_t>(frameBuffer.width) * frameBuffer.height;
+
+                if (clearColor && frameBuffer.color)
+                {
+                    uint8_t pixel[4];
+                    for (size_t channel = 0; channel < 4; ++channel)
+                        pixel[channel] = static_cast<uint8_t>(clamp(color[channel], 0.0F, 1.0F) * 255.0F + 0.5F);
+
+                    for (size_t i = 0; i < pixelCount; ++i)
+                        std::copy(std::begin(pixel), std::end(pixel), frameBuffer.color + i * 4);
+                }
+
+                if (clearDepth && frameBuffer.depth)
+                    std::fill(frameBuffer.depth, frameBuffer.depth + pixelCount, depth);
+
+                if (clearStencil && frameBuffer.stencil)
+                    std::fill(frameBuffer.stencil, frameBuffer.stencil + pixelCount, stencil);
+            }
+
+            void Rasterizer::setState(const DrawState& state)
+            {
+                states.push_back(state);
+
+                clipMinX = std::max(static_cast<int32_t>(std::floor(state.viewportX)), 0);
+                clipMinY = std::max(static_cast<int32_t>(std::floor(state.viewportY)), 0);
+                clipMaxX = std::min(static_cast<int32_t>(std::ceil(state.viewportX + state.viewportWidth)), static_cast<int32_t>(frameBuffer.width));
+                clipMaxY = std::min(static_cast<int32_t>(std::ceil(state.viewportY + state.viewportHeight)), static_cast<int32_t>(frameBuffer.height));
+
+                if (state.scissorTest)
+                {
+                    clipMinX = std::max(clipMinX, state.scissorX);
+                    clipMinY = std::max(clipMinY, state.scissorY);
+                    clipMaxX = std::min(clipMaxX, state.scissorX + state.scissorWidth);
+                    clipMaxY = std::min(clipMaxY, state.scissorY + state.scissorHeight);
+                }
+            }
+
+            void Rasterizer::drawTriangle(const Vertex& vertex0, const Vertex& vertex1, const Vertex& vertex2)
+            {
+                const uint32_t outcodes[3] = {getOutcode(vertex0), getOutcode(vertex1), getOutcode(vertex2)};
+
+                if (outcodes[0] & outcodes[1] & outcodes[2]) return;
+
+                ScreenVertex screenVertices[MAX_POLYGON_VERTICES];
+
+                if (!(outcodes[0] | outcodes[1] | outcodes[2]))
+                {
+                    screenVertices[0] = project(vertex0);
+                    screenVertices[1] = project(vertex1);
+                    screenVertices[2] = project(vertex2);
+                    drawPolygon(screenVertices, 3);
+                    return;
+                }
+
+                // Sutherland-Hodgman clipping against the planes that the triangle crosses
+                Vertex polygons[2][MAX_POLYGON_VERTICES] = {{vertex0, vertex1, vertex2}};
+                size_t vertexCount = 3;
+                size_t current = 0;
+                const uint32_t crossedPlanes = outcodes[0] | outcodes[1] | outcodes[2];
+
+                for (size_t plane = 0; plane < CLIP_PLANE_COUNT; ++plane)
+                {
+                    if (!(crossedPlanes & (1U << plane))) continue;
+
+                    const Vertex* input = polygons[current];
+                    Vertex* output = polygons[current ^ 1];
+                    size_t outputCount = 0;
+
+                    for (size_t i = 0; i < vertexCount; ++i)
+                    {
+                        const Vertex& vertex = input[i];
+                        const Vertex& next = input[(i + 1) % vertexCount];
+                        const float distance = getPlaneDistance(vertex, plane);
+                        const float nextDistance = getPlaneDistance(next, plane);
+
+                        if (distance >= 0.0F)
+                            output[outputCount++] = vertex;
+
+                        if ((distance >= 0.0F) != (nextDistance >= 0.0F))
+                            output[outputCount++] = interpolate(vertex, next, distance / (distance - nextDistance));
+                    }
+
+                    vertexCount = outputCount;
+                    current ^= 1;
+
+                    if (vertexCount < 3) return;
+                }
+
+                for (size_t i = 0; i < vertexCount; ++i)
+                    screenVertices[i] = project(polygons[current][i]);
+
+                drawPolygon(screenVertices, vertexCount);
+            }
+
+            void Rasterizer::drawLine(const Vertex& vertex0, const Vertex& vertex1)
+            {
+                // Liang-Barsky clipping
+                float start = 0.0F;
+                float end = 1.0F;
+
+                for (size_t plane = 0; plane < CLIP_PLANE_COUNT; ++plane)
+                {
+                    const float distance0 = getPlaneDistance(vertex0, plane);
+                    const float distance1 = getPlaneDistance(vertex1, plane);
+
+                    if (distance0 < 0.0F && distance1 < 0.0F) return;
+
+                    if (distance0 < 0.0F)
+                        start = std::max(start, distance0 / (distance0 - distance1));
+                    else if (distance1 < 0.0F)
+                        end = std::min(end, distance0 / (distance0 - distance1));
+                }
+
+                if (start > end) return;
+
+                drawScreenLine(project(start > 0.0F ? interpolate(vertex0, vertex1, start) : vertex0),
+                               project(end < 1.0F ? interpolate(vertex0, vertex1, end) : vertex1));
+            }
+
+            void Rasterizer::drawPoint(const Vertex& vertex)
+            {
+                if (getOutcode(vertex)) return;
+
+                const ScreenVertex center = project(vertex);
+                ScreenVertex corners[4] = {center, center, center, center};
+                corners[0].x -= 0.5F; corners[0].y -= 0.5F;
+                corners[1].x += 0.5F; corners[1].y -= 0.5F;
+                corners[2].x += 0.5F; corners[2].y += 0.5F;
+                corners[3].x -= 0.5F; corners[3].y += 0.5F;
+
+                setupTriangle(corners[0], corners[1], corners[2], false);
+                setupTriangle(corners[0], corners[2], corners[3], false);
+            }
+
+            void Rasterizer::drawPolygon(ScreenVertex* vertices, size_t vertexCount)
+            {
+                if (states.back().fillMode == FillMode::Wireframe)
+                {
+                    // faces are culled before they are outlined
+                    float area = 0.0F;
+                    for (size_t i = 0; i < vertexCount; ++i)
+                    {
+                        const ScreenVertex& vertex = vertices[i];
+                        const ScreenVertex& next = vertices[(i + 1) % vertexCount];
+                        area += vertex.x * next.y - next.x * vertex.y;
+                    }
+
+                    const CullMode cullMode = states.back().cullMode;
+                    if ((cullMode == CullMode::Back && area < 0.0F) ||
+                        (cullMode == CullMode::Front && area > 0.0F))
+                        return;
+
+                    for (size_t i = 0; i < vertexCount; ++i)
+                        drawScreenLine(vertices[i], vertices[(i + 1) % vertexCount]);
+                }
+                else
+                {
+                    for (size_t i = 1; i + 1 < vertexCount; ++i)
+                        setupTriangle(vertices[0], vertices[i], vertices[i + 1], true);
+                }
+            }
+
+            void Rasterizer::drawScreenLine(const ScreenVertex& vertex0, const ScreenVertex& vertex1)
+            {
+                const float deltaX = vertex1.x - vertex0.x;
+                const float deltaY = vertex1.y - vertex0.y;
+
+                if (deltaX == 0.0F && deltaY == 0.0F) return;
+
+                // the line is a quad that is one pixel wide across its minor axis
+                const float offsetX = (std::fabs(deltaX) >= std::fabs(deltaY)) ? 0.0F : 0.5F;
+                const float offsetY = (std::fabs(deltaX) >= std::fabs(deltaY)) ? 0.5F : 0.0F;
+
+                ScreenVertex corners[4] = {vertex0, vertex0, vertex1, vertex1};
+                corners[0].x -= offsetX; corners[0].y -= offsetY;
+                corners[1].x += offsetX; corners[1].y += offsetY;
+                corners[2].x += offsetX; corners[2].y += offsetY;
+                corners[3].x -= offsetX; corners[3].y -= offsetY;
+
+                setupTriangle(corners[0], corners[1], corners[2], false);
+                setupTriangle(corners[0], corners[2], corners[3], false);
+            }
+
+            Rasterizer::ScreenVertex Rasterizer::project(const Vertex& vertex) const
+            {
+                const DrawState& state = states.back();
+                const float inverseW = 1.0F / vertex.position[3];
+
+                ScreenVertex result;
+                result.x = state.viewportX + (vertex.position[0] * inverseW + 1.0F) * 0.5F * state.viewportWidth;
+                result.y = state.viewportY + (1.0F - vertex.position[1] * inverseW) * 0.5F * state.viewportHeight;
+                result.attributes[0] = vertex.position[2] * inverseW;
+                result.attributes[1] = inverseW;
+                std::copy(std::begin(vertex.color), std::end(vertex.color), result.attributes + 2);
+                std::copy(std::begin(vertex.texCoord), std::end(vertex.texCoord), result.attributes + 6);
+                return result;
+            }
+
+            void Rasterizer::setupTriangle(const ScreenVertex& vertex0, const ScreenVertex& vertex1, const ScreenVertex& vertex2,
+                                           bool cull)
+            {
+                if (triangles.size() >= MAX_BINNED_TRIANGLES) flush();
+
+                const ScreenVertex* vertices[3] = {&vertex0, &vertex1, &vertex2};
+                int64_t x[3];
+                int64_t y[3];
+
+                for (size_t i = 0; i < 3; ++i)
+                {
+                    x[i] = static_cast<int64_t>(std::lround(vertices[i]->x * SUBPIXEL_SCALE));
+                    y[i] = static_cast<int64_t>(std::lround(vertices[i]->y * SUBPIXEL_SCALE));
+                }
+
+                int64_t area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+                if (area == 0) return;
+
+                const DrawState& state = states.back();
+
+                // the front faces are clockwise on the screen
+                const bool frontFacing = area > 0;
+                if (cull &&
+                    ((state.cullMode == CullMode::Back && !frontFacing) ||
+                     (state.cullMode == CullMode::Front && frontFacing)))
+                    return;
+
+                if (area < 0)
+                {
+                    std::swap(x[1], x[2]);
+                    std::swap(y[1], y[2]);
+                    std::swap(vertices[1], vertices[2]);
+                    area = -area;
+                }
+
+                // pixels whose centers are inside the bounding box
+                Triangle triangle;
+                triangle.minX = std::max(clipMinX, static_cast<int32_t>(floorDivide(std::min({x[0], x[1], x[2]}) - HALF_PIXEL + (1 << SUBPIXEL_BITS) - 1, 1 << SUBPIXEL_BITS)));
+                triangle.minY = std::max(clipMinY, static_cast<int32_t>(floorDivide(std::min({y[0], y[1], y[2]}) - HALF_PIXEL + (1 << SUBPIXEL_BITS) - 1, 1 << SUBPIXEL_BITS)));
+                triangle.maxX = std::min(clipMaxX - 1, static_cast<int32_t>(floorDivide(std::max({x[0], x[1], x[2]}) - HALF_PIXEL, 1 << SUBPIXEL_BITS)));
+                triangle.maxY = std::min(clipMaxY - 1, static_cast<int32_t>(floorDivide(std::max({y[0], y[1], y[2]}) - HALF_PIXEL, 1 << SUBPIXEL_BITS)));
+
+                if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY) return;
+
+                // edge functions of the pixel centers, positive inside the triangle
+                float weights[3][3];
+                const double inverseArea = 1.0 / static_cast<double>(area);
+
+                for (size_t edge = 0; edge < 3; ++edge)
+                {
+                    const size_t next = (edge + 1) % 3;
+                    const int64_t deltaX = x[next] - x[edge];
+                    const int64_t deltaY = y[next] - y[edge];
+                    const int64_t stepX = -deltaY << SUBPIXEL_BITS;
+                    const int64_t stepY = deltaX << SUBPIXEL_BITS;
+                    const int64_t constant = deltaX * (HALF_PIXEL - y[edge]) - deltaY * (HALF_PIXEL - x[edge]);
+
+                    // top-left fill rule, the pixels on the other edges are not covered
+                    const bool topLeft = deltaY < 0 || (deltaY == 0 && deltaX > 0);
+
+                    triangle.edgeStepX[edge] = static_cast<int32_t>(stepX);
+                    triangle.edgeStepY[edge] = static_cast<int32_t>(stepY);
+                    triangle.edgeConstants[edge] = topLeft ? constant : constant - 1;
+
+                    // the edge function divided by the area is the barycentric coordinate of the opposite vertex
+                    const size_t vertex = (edge + 2) % 3;
+                    weights[vertex][0] = static_cast<float>(static_cast<double>(constant + stepX * triangle.minX + stepY * triangle.minY) * inverseArea);
+                    weights[vertex][1] = static_cast<float>(static_cast<double>(stepX) * inverseArea);
+                    weights[vertex][2] = static_cast<float>(static_cast<double>(stepY) * inverseArea);
+                }
+
+                // attributes are interpolated in screen space if the w of all the vertices is the same
+                triangle.perspective = vertices[0]->attributes[1] != vertices[1]->attributes[1] ||
+                    vertices[0]->attributes[1] != vertices[2]->attributes[1];
+
+                float attributes[3][8];
+                for (size_t i = 0; i < 3; ++i)
+                {
+                    std::copy(std::begin(vertices[i]->attributes), std::end(vertices[i]->attributes), attributes[i]);
+
+                    if (triangle.perspective)
+                        for (size_t attribute = 2; attribute < 8; ++attribute)
+                            attributes[i][attribute] *= vertices[i]->attributes[1];
+                }
+
+#if defined(__ARM_NEON__) || defined(__SSE2__)
+                if (isSimdAvailable)
+                    computePlanes<SimdFloat4>(attributes, weights, triangle.planes);
+                else
+#endif
+                    computePlanes<ScalarFloat4>(attributes, weights, triangle.planes);
+
+                // level of detail of the whole triangle from the texture coordinate gradients
+                triangle.lod = 0.0F;
+
+                if (state.texture)
+                {
+                    const Size2U& textureSize = state.texture->getSize();
+                    float gradients[2][2] = {{0.0F, 0.0F}, {0.0F, 0.0F}};
+
+                    for (size_t i = 0; i < 3; ++i)
+                        for (size_t axis = 0; axis < 2; ++axis)
+                        {
+                            gradients[axis][0] += vertices[i]->attributes[6] * weights[i][axis + 1] * static_cast<float>(textureSize.v[0]);
+                            gradients[axis][1] += vertices[i]->attributes[7] * weights[i][axis + 1] * static_cast<float>(textureSize.v[1]);
+                        }
+
+                    const float scale = std::max(gradients[0][0] * gradients[0][0] + gradients[0][1] * gradients[0][1],
+                                                 gradients[1][0] * gradients[1][0] + gradients[1][1] * gradients[1][1]);
+                    triangle.lod = (scale > 0.0F) ? 0.5F * std::log2(scale) : 0.0F;
+                }
+
+                triangle.state = static_cast<uint32_t>(states.size() - 1);
+                triangle.frontFacing = frontFacing;
+
+                const auto triangleIndex = static_cast<uint32_t>(triangles.size());
+                triangles.push_back(triangle);
+
+                for (int32_t tileY = triangle.minY / TILE_SIZE; tileY <= triangle.maxY / TILE_SIZE; ++tileY)
+                    for (int32_t tileX = triangle.minX / TILE_SIZE; tileX <= triangle.maxX / TILE_SIZE; ++tileX)
+                    {
+                        const auto tile = static_cast<uint32_t>(tileY * tileCountX + tileX);
+                        std::vector<uint32_t>& bin = bins[tile];
+                        if (bin.empty()) binnedTiles.push_back(tile);
+                        bin.push_back(triangleIndex);
+                    }
+            }
+
+            void Rasterizer::flush()
+            {
+                if (!binnedTiles.empty())
+                {
+                    nextTile = 0;
+
+                    std::unique_lock<std::mutex> lock(jobMutex);
+                    ++jobIndex;
+                    busyWorkerCount = static_cast<uint32_t>(workers.size());
+                    lock.unlock();
+                    jobCondition.notify_all();
+
+                    shadeTiles();
+
+                    lock.lock();
+                    finishCondition.wait(lock, [this]() { return busyWorkerCount == 0; });
+                    lock.unlock();
+
+                    for (const uint32_t tile : binnedTiles)
+                        bins[tile].clear();
+
+                    binnedTiles.clear();
+                }
+
+                triangles.clear();
+
+                // the last state is still used by the primitives that are drawn after the flush
+                if (states.size() > 1)
+                    states.erase(states.begin(), states.end() - 1);
+            }
+
+            void Rasterizer::shadeTiles()
+            {
+                for (;;)
+                {
+                    const size_t index = nextTile++;
+                    if (index >= binnedTiles.size()) break;
+
+                    const uint32_t tile = binnedTiles[index];
+                    const auto tileX = static_cast<int32_t>(tile) % tileCountX;
+                    const auto tileY = static_cast<int32_t>(tile) / tileCountX;
+
+#if defined(__ARM_NEON__) || defined(__SSE2__)
+                    if (isSimdAvailable)
+                        shadeTile<SimdFloat4>(frameBuffer, states, triangles, bins[tile], tileX, tileY);
+                    else
+#endif
+                        shadeTile<ScalarFloat4>(frameBuffer, states, triangles, bins[tile], tileX, tileY);
+                }
+            }
+
+            void Rasterizer::workerMain()
+            {
+                Thread::setCurrentThreadName("Rasterizer");
+
+                uint32_t currentJobIndex = 0;
+
+                for (;;)
+                {
+                    std::unique_lock<std::mutex> lock(jobMutex);
+                    jobCondition.wait(lock, [this, currentJobIndex]() { return !running || jobIndex != currentJobIndex; });
+                    if (!running) break;
+                    currentJobIndex = jobIndex;
+                    lock.unlock();
+
+                    shadeTiles();
+
+                    lock.lock();
+                    if (--busyWorkerCount == 0)
+                    {
+                        lock.unlock();
+                        finishCondition.notify_all();
+                    }
+                }
+            }
+        } // namespace software
+    } // namespace graphics
+} // namespace ouzel
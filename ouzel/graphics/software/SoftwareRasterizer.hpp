@@ -0,0 +1,194 @@
+// Copyright 2015-2019 Elviss Strazdins. All rights reserved.
+
+#ifndef OUZEL_GRAPHICS_SOFTWARERASTERIZER_HPP
+#define OUZEL_GRAPHICS_SOFTWARERASTERIZER_HPP
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include "graphics/BlendFactor.hpp"
+#include "graphics/BlendOperation.hpp"
+#include "graphics/CompareFunction.hpp"
+#include "graphics/RasterizerState.hpp"
+#include "graphics/StencilOperation.hpp"
+#include "utils/Thread.hpp"
+
+namespace ouzel
+{
+    namespace graphics
+    {
+        namespace software
+        {
+            class Texture;
+
+            // Tile-based rasterizer, the triangles are binned into screen tiles and the tiles are shaded
+            // in parallel. The triangles of a tile are shaded in the order they were drawn, so the result
+            // does not depend on the number of threads.
+            class Rasterizer final
+            {
+            public:
+                static constexpr int32_t TILE_SIZE = 32;
+                static constexpr int32_t SUBPIXEL_BITS = 4;
+                // the fixed-point edge functions of a tile fit into 32 bits for frame buffers up to this size
+                static constexpr uint32_t MAX_FRAME_BUFFER_SIZE = 8192;
+
+                struct FrameBuffer final
+                {
+                    uint32_t width = 0;
+                    uint32_t height = 0;
+                    uint8_t* color = nullptr; // RGBA8
+                    float* depth = nullptr;
+                    uint8_t* stencil = nullptr;
+                };
+
+                struct StencilFace final
+                {
+                    StencilOperation failureOperation = StencilOperation::Keep;
+                    StencilOperation depthFailureOperation = StencilOperation::Keep;
+                    StencilOperation passOperation = StencilOperation::Keep;
+                    CompareFunction compareFunction = CompareFunction::AlwaysPass;
+                };
+
+                struct DrawState final
+                {
+                    // top-left origin like the other drivers that have an identity projection transform
+                    float viewportX = 0.0F;
+                    float viewportY = 0.0F;
+                    float viewportWidth = 0.0F;
+                    float viewportHeight = 0.0F;
+
+                    bool scissorTest = false;
+                    int32_t scissorX = 0;
+                    int32_t scissorY = 0;
+                    int32_t scissorWidth = 0;
+                    int32_t scissorHeight = 0;
+
+                    CullMode cullMode = CullMode::NoCull;
+                    FillMode fillMode = FillMode::Solid;
+
+                    bool blendEnabled = false;
+                    BlendFactor colorBlendSource = BlendFactor::One;
+                    BlendFactor colorBlendDest = BlendFactor::Zero;
+                    BlendOperation colorOperation = BlendOperation::Add;
+                    BlendFactor alphaBlendSource = BlendFactor::One;
+                    BlendFactor alphaBlendDest = BlendFactor::Zero;
+                    BlendOperation alphaOperation = BlendOperation::Add;
+                    uint8_t colorMask = 0x0F;
+
+                    bool depthTest = false;
+                    bool depthWrite = false;
+                    CompareFunction depthFunction = CompareFunction::PassIfLess;
+
+                    bool stencilTest = false;
+                    uint8_t stencilReadMask = 0xFF;
+                    uint8_t stencilWriteMask = 0xFF;
+                    uint8_t stencilReference = 0;
+                    StencilFace frontFace;
+                    StencilFace backFace;
+
+                    std::array<float, 4> color{{1.0F, 1.0F, 1.0F, 1.0F}};
+                    const Texture* texture = nullptr; // the color program is used if there is no texture
+                };
+
+                struct Vertex final
+                {
+                    float position[4]; // clip space
+                    float color[4];
+                    float texCoord[2];
+                };
+
+                struct ScreenVertex final
+                {
+                    float x;
+                    float y;
+                    float attributes[8]; // z, 1/w, red, green, blue, alpha, u, v
+                };
+
+                struct Triangle final
+                {
+                    // values at the top-left pixel of the bounds and the x and y gradients of the attributes
+                    alignas(16) float planes[3][8];
+                    int64_t edgeConstants[3]; // biased for the fill rule
+                    int32_t edgeStepX[3];
+                    int32_t edgeStepY[3];
+                    int32_t minX;
+                    int32_t minY;
+                    int32_t maxX;
+                    int32_t maxY;
+                    float lod;
+                    uint32_t state;
+                    bool frontFacing;
+                    bool perspective;
+                };
+
+                Rasterizer();
+                ~Rasterizer();
+
+                Rasterizer(const Rasterizer&) = delete;
+                Rasterizer& operator=(const Rasterizer&) = delete;
+
+                Rasterizer(Rasterizer&&) = delete;
+                Rasterizer& operator=(Rasterizer&&) = delete;
+
+                // flushes the triangles that were drawn to the previous frame buffer
+                void setFrameBuffer(const FrameBuffer& newFrameBuffer);
+                inline auto& getFrameBuffer() const noexcept { return frameBuffer; }
+
+                // clears the whole frame buffer regardless of the scissor test
+                void clear(bool clearColor, const std::array<float, 4>& color,
+                           bool clearDepth, float depth,
+                           bool clearStencil, uint8_t stencil);
+
+                // the state is used by the primitives until the next call
+                void setState(const DrawState& state);
+
+                void drawTriangle(const Vertex& vertex0, const Vertex& vertex1, const Vertex& vertex2);
+                void drawLine(const Vertex& vertex0, const Vertex& vertex1);
+                void drawPoint(const Vertex& vertex);
+
+                // shades the binned triangles, must be called before the frame buffer or the textures are accessed
+                void flush();
+
+            private:
+                void drawPolygon(ScreenVertex* vertices, size_t vertexCount);
+                void drawScreenLine(const ScreenVertex& vertex0, const ScreenVertex& vertex1);
+                void setupTriangle(const ScreenVertex& vertex0, const ScreenVertex& vertex1, const ScreenVertex& vertex2,
+                                   bool cull);
+                ScreenVertex project(const Vertex& vertex) const;
+
+                void shadeTiles();
+                void workerMain();
+
+                FrameBuffer frameBuffer;
+                int32_t tileCountX = 0;
+                int32_t tileCountY = 0;
+
+                // viewport, scissor and frame buffer bounds of the current state
+                int32_t clipMinX = 0;
+                int32_t clipMinY = 0;
+                int32_t clipMaxX = 0;
+                int32_t clipMaxY = 0;
+
+                std::vector<DrawState> states;
+                std::vector<Triangle> triangles;
+                std::vector<std::vector<uint32_t>> bins;
+                std::vector<uint32_t> binnedTiles;
+
+                std::atomic<size_t> nextTile{0};
+
+                bool running = true;
+                uint32_t jobIndex = 0;
+                uint32_t busyWorkerCount = 0;
+                std::mutex jobMutex;
+                std::condition_variable jobCondition;
+                std::condition_variable finishCondition;
+                std::vector<Thread> workers; // started after all the other members are initialized
+            };
+        } // namespace software
+    } // namespace graphics
+} // namespace ouzel
+
+#endif // OUZEL_GRAPHICS_SOFTWARERASTERIZER_HPP
@@ -0,0 +1,780 @@
+// Copyright 2015-2019 Elviss Strazdins. All rights reserved.
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include "SoftwareRenderDevice.hpp"
+#include "SoftwareBlendState.hpp"
+#include "SoftwareBuffer.hpp"
+#include "SoftwareDepthStencilState.hpp"
+#include "SoftwareRenderTarget.hpp"
+#include "SoftwareShader.hpp"
+#include "SoftwareTexture.hpp"
+#include "core/Engine.hpp"
+#include "utils/Log.hpp"
+#include "stb_image_write.h"
+
+namespace ouzel
+{
+    namespace graphics
+    {
+        namespace software
+        {
+            namespace
+            {
+                uint32_t getIndex(const uint8_t* indices, uint32_t indexSize, uint32_t index)
+                {
+                    switch (indexSize)
+                    {
+                        case 2:
+                        {
+                            uint16_t result;
+                            std::memcpy(&result, indices + index * 2, sizeof(result));
+                            return result;
+                        }
+                        case 4:
+                        {
+                            uint32_t result;
+                            std::memcpy(&result, indices + index * 4, sizeof(result));
+                            return result;
+                        }
+                        default:
+                            throw std::runtime_error("Invalid index size");
+                    }
+                }
+
+                Rasterizer::StencilFace getStencilFace(const DepthStencilState::StencilFace& stencilFace) noexcept
+                {
+                    Rasterizer::StencilFace result;
+                    result.failureOperation = stencilFace.failureOperation;
+                    result.depthFailureOperation = stencilFace.depthFailureOperation;
+                    result.passOperation = stencilFace.passOperation;
+                    result.compareFunction = stencilFace.compareFunction;
+                    return result;
+                }
+            }
+
+            RenderDevice::RenderDevice(const std::function<void(const Event&)>& initCallback):
+                graphics::RenderDevice(Driver::Software, initCallback)
+            {
+                apiMajorVersion = 1;
+                apiMinorVersion = 0;
+            }
+
+            RenderDevice::~RenderDevice()
+            {
+                running = false;
+                CommandBuffer commandBuffer;
+                commandBuffer.pushCommand<PresentCommand>();
+                submitCommandBuffer(std::move(commandBuffer));
+
+                if (renderThread.isJoinable()) renderThread.join();
+            }
+
+            void RenderDevice::init(Window* newWindow,
+                                    const Size2U& newSize,
+                                    uint32_t newSampleCount,
+                                    SamplerFilter newTextureFilter,
+                                    uint32_t newMaxAnisotropy,
+                                    bool newSrgb,
+                                    bool newVerticalSync,
+                                    bool newDepth,
+                                    bool newStencil,
+                                    bool newDebugRenderer)
+            {
+                graphics::RenderDevice::init(newWindow,
+                                             newSize,
+                                             newSampleCount,
+                                             newTextureFilter,
+                                             newMaxAnisotropy,
+                                             newSrgb,
+                                             newVerticalSync,
+                                             newDepth,
+                                             newStencil,
+                                             newDebugRenderer);
+
+                // the rasterizer does not multisample and does not convert to sRGB
+                sampleCount = 1;
+                srgb = false;
+
+                npotTexturesSupported = true;
+                renderTargetsSupported = true;
+                clampToBorderSupported = true;
+
+                resizeFrameBuffer(newSize);
+                setRenderTarget(nullptr);
+
+#if !defined(__EMSCRIPTEN__)
+                running = true;
+                renderThread = Thread(&RenderDevice::renderMain, this);
+#endif
+            }
+
+            void RenderDevice::renderMain()
+            {
+                Thread::setCurrentThreadName("Render");
+
+                while (running)
+                {
+                    try
+                    {
+                        process();
+                    }
+                    catch (const std::exception& e)
+                    {
+                        engine->log(Log::Level::Error) << e.what();
+                    }
+                }
+            }
+
+            void RenderDevice::process()
+            {
+                graphics::RenderDevice::process();
+                executeAll();
+
+                CommandBuffer commandBuffer;
+                const Command* command;
+
+                for (;;)
+                {
+                    waitForCommandBuffer(commandBuffer);
+
+                    while (!commandBuffer.isEmpty())
+                    {
+                        command = commandBuffer.popCommand();
+
+                        switch (command->type)
+                        {
+                            case Command::Type::Resize:
+                            {
+                                auto resizeCommand = static_cast<const ResizeCommand*>(command);
+                                resizeFrameBuffer(resizeCommand->size);
+                                break;
+                            }
+
+                            case Command::Type::Present:
+                            {
+                                // there is no window surface, the frame stays in the color buffer
+                                rasterizer.flush();
+                                break;
+                            }
+
+                            case Command::Type::DeleteResource:
+                            {
+                                auto deleteResourceCommand = static_cast<const DeleteResourceCommand*>(command);
+
+                                // the binned triangles may still refer to the texture
+                                rasterizer.flush();
+
+                                RenderResource* resource = resources[deleteResourceCommand->resource - 1].get();
+                                if (resource == currentRenderTarget) setRenderTarget(nullptr);
+                                if (resource == currentShader) currentShader = nullptr;
+                                if (resource == currentTexture) currentTexture = nullptr;
+
+                                resources[deleteResourceCommand->resource - 1].reset();
+                                break;
+                            }
+
+                            case Command::Type::InitRenderTarget:
+                            {
+                                auto initRenderTargetCommand = static_cast<const InitRenderTargetCommand*>(command);
+
+                                std::set<Texture*> colorTextures;
+                                for (const uintptr_t colorTextureId : initRenderTargetCommand->colorTextures)
+                                    colorTextures.insert(getResource<Texture>(colorTextureId));
+
+                                auto renderTarget = std::make_unique<RenderTarget>(*this,
+                                                                                   colorTextures,
+                                                                                   getResource<Texture>(initRenderTargetCommand->depthTexture));
+
+                                if (initRenderTargetCommand->renderTarget > resources.size())
+                                    resources.resize(initRenderTargetCommand->renderTarget);
+                                resources[initRenderTargetCommand->renderTarget - 1] = std::move(renderTarget);
+                                break;
+                            }
+
+                            case Command::Type::SetRenderTarget:
+                            {
+                                auto setRenderTargetCommand = static_cast<const SetRenderTargetCommand*>(command);
+                                setRenderTarget(getResource<RenderTarget>(setRenderTargetCommand->renderTarget));
+                                break;
+                            }
+
+                            case Command::Type::ClearRenderTarget:
+                            {
+                                auto clearCommand = static_cast<const ClearRenderTargetCommand*>(command);
+
+                                rasterizer.clear(clearCommand->clearColorBuffer, clearCommand->clearColor.norm(),
+                                                 clearCommand->clearDepthBuffer, clearCommand->clearDepth,
+                                                 clearCommand->clearStencilBuffer, static_cast<uint8_t>(clearCommand->clearStencil));
+                                break;
+                            }
+
+                            case Command::Type::Blit:
+                            {
+                                auto blitCommand = static_cast<const BlitCommand*>(command);
+
+                                rasterizer.flush();
+
+                                Texture* sourceTexture = getResource<Texture>(blitCommand->sourceTexture);
+                                Texture* destinationTexture = getResource<Texture>(blitCommand->destinationTexture);
+
+                                if (blitCommand->sourceLevel >= sourceTexture->getLevels().size() ||
+                                    blitCommand->destinationLevel >= destinationTexture->getLevels().size())
+                                    throw std::runtime_error("Invalid mip level");
+
+                                const Texture::Level& sourceLevel = sourceTexture->getLevels()[blitCommand->sourceLevel];
+                                Texture::Level& destinationLevel = destinationTexture->getLevels()[blitCommand->destinationLevel];
+
+                                if (blitCommand->sourceX + blitCommand->sourceWidth > sourceLevel.size.v[0] ||
+                                    blitCommand->sourceY + blitCommand->sourceHeight > sourceLevel.size.v[1] ||
+                                    blitCommand->destinationX + blitCommand->sourceWidth > destinationLevel.size.v[0] ||
+                                    blitCommand->destinationY + blitCommand->sourceHeight > destinationLevel.size.v[1])
+                                    throw std::runtime_error("Invalid blit region");
+
+                                for (uint32_t row = 0; row < blitCommand->sourceHeight; ++row)
+                                {
+                                    const size_t sourceOffset = ((blitCommand->sourceY + row) * sourceLevel.size.v[0] + blitCommand->sourceX) * 4;
+                                    const size_t destinationOffset = ((blitCommand->destinationY + row) * destinationLevel.size.v[0] + blitCommand->destinationX) * 4;
+
+                                    std::copy(sourceLevel.data.begin() + static_cast<std::ptrdiff_t>(sourceOffset),
+                                              sourceLevel.data.begin() + static_cast<std::ptrdiff_t>(sourceOffset + blitCommand->sourceWidth * 4),
+                                              destinationLevel.data.begin() + static_cast<std::ptrdiff_t>(destinationOffset));
+                                }
+                                break;
+                            }
+
+                            case Command::Type::Compute:
+                            {
+                                // compute shaders are not supported by the rasterizer
+                                break;
+                            }
+
+                            case Command::Type::SetScissorTest:
+                            {
+                                auto setScissorTestCommand = static_cast<const SetScissorTestCommand*>(command);
+
+                                drawState.scissorTest = setScissorTestCommand->enabled;
+                                drawState.scissorX = static_cast<int32_t>(setScissorTestCommand->rectangle.position.v[0]);
+                                drawState.scissorY = static_cast<int32_t>(setScissorTestCommand->rectangle.position.v[1]);
+                                drawState.scissorWidth = static_cast<int32_t>(setScissorTestCommand->rectangle.size.v[0]);
+                                drawState.scissorHeight = static_cast<int32_t>(setScissorTestCommand->rectangle.size.v[1]);
+                                break;
+                            }
+
+                            case Command::Type::SetViewport:
+                            {
+                                auto setViewportCommand = static_cast<const SetViewportCommand*>(command);
+
+                                drawState.viewportX = setViewportCommand->viewport.position.v[0];
+                                drawState.viewportY = setViewportCommand->viewport.position.v[1];
+                                drawState.viewportWidth = setViewportCommand->viewport.size.v[0];
+                                drawState.viewportHeight = setViewportCommand->viewport.size.v[1];
+                                break;
+                            }
+
+                            case Command::Type::InitDepthStencilState:
+                            {
+                                auto initDepthStencilStateCommand = static_cast<const InitDepthStencilStateCommand*>(command);
+                                auto depthStencilState = std::make_unique<DepthStencilState>(*this,
+                                                                                             initDepthStencilStateCommand->depthTest,
+                                                                                             initDepthStencilStateCommand->depthWrite,
+                                                                                             initDepthStencilStateCommand->compareFunction,
+                                                                                             initDepthStencilStateCommand->stencilEnabled,
+                                                                                             initDepthStencilStateCommand->stencilReadMask,
+                                                                                             initDepthStencilStateCommand->stencilWriteMask,
+                                                                                             initDepthStencilStateCommand->frontFaceStencilFailureOperation,
+                                                                                             initDepthStencilStateCommand->frontFaceStencilDepthFailureOperation,
+                                                                                             initDepthStencilStateCommand->frontFaceStencilPassOperation,
+                                                                                             initDepthStencilStateCommand->frontFaceStencilCompareFunction,
+                                                                                             initDepthStencilStateCommand->backFaceStencilFailureOperation,
+                                                                                             initDepthStencilStateCommand->backFaceStencilDepthFailureOperation,
+                                                                                             initDepthStencilStateCommand->backFaceStencilPassOperation,
+                                                                                             initDepthStencilStateCommand->backFaceStencilCompareFunction);
+
+                                if (initDepthStencilStateCommand->depthStencilState > resources.size())
+                                    resources.resize(initDepthStencilStateCommand->depthStencilState);
+                                resources[initDepthStencilStateCommand->depthStencilState - 1] = std::move(depthStencilState);
+                                break;
+                            }
+
+                            case Command::Type::SetDepthStencilState:
+                            {
+                                auto setDepthStencilStateCommand = static_cast<const SetDepthStencilStateCommand*>(command);
+
+                                if (setDepthStencilStateCommand->depthStencilState)
+                                {
+                                    DepthStencilState* depthStencilState = getResource<DepthStencilState>(setDepthStencilStateCommand->depthStencilState);
+
+                                    drawState.depthTest = depthStencilState->getDepthTest();
+                                    drawState.depthWrite = depthStencilState->getDepthWrite();
+                                    drawState.depthFunction = depthStencilState->getCompareFunction();
+                                    drawState.stencilTest = depthStencilState->getStencilTest();
+                                    drawState.stencilReadMask = depthStencilState->getStencilReadMask();
+                                    drawState.stencilWriteMask = depthStencilState->getStencilWriteMask();
+                                    drawState.stencilReference = static_cast<uint8_t>(setDepthStencilStateCommand->stencilReferenceValue);
+                                    drawState.frontFace = getStencilFace(depthStencilState->getFrontFace());
+                                    drawState.backFace = getStencilFace(depthStencilState->getBackFace());
+                                }
+                                else
+                                {
+                                    drawState.depthTest = false;
+                                    drawState.depthWrite = false;
+                                    drawState.depthFunction = CompareFunction::PassIfLess;
+                                    drawState.stencilTest = false;
+                                    drawState.stencilWriteMask = 0xFF;
+                                }
+
+                                break;
+                            }
+
+                            case Command::Type::SetPipelineState:
+                            {
+                                auto setPipelineStateCommand = static_cast<const SetPipelineStateCommand*>(command);
+
+                                BlendState* blendState = getResource<BlendState>(setPipelineStateCommand->blendState);
+                                currentShader = getResource<Shader>(setPipelineStateCommand->shader);
+
+                                if (blendState)
+                                {
+                                    drawState.blendEnabled = blendState->isBlendEnabled();
+                                    drawState.colorBlendSource = blendState->getColorBlendSource();
+                                    drawState.colorBlendDest = blendState->getColorBlendDest();
+                                    drawState.colorOperation = blendState->getColorOperation();
+                                    drawState.alphaBlendSource = blendState->getAlphaBlendSource();
+                                    drawState.alphaBlendDest = blendState->getAlphaBlendDest();
+                                    drawState.alphaOperation = blendState->getAlphaOperation();
+                                    drawState.colorMask = static_cast<uint8_t>(blendState->getColorMask());
+                                }
+                                else
+                                {
+                                    drawState.blendEnabled = false;
+                                    drawState.colorMask = static_cast<uint8_t>(ColorMask::All);
+                                }
+
+                                drawState.cullMode = setPipelineStateCommand->cullMode;
+                                drawState.fillMode = setPipelineStateCommand->fillMode;
+                                break;
+                            }
+
+                            case Command::Type::Draw:
+                            {
+                                auto drawCommand = static_cast<const DrawCommand*>(command);
+
+                                Buffer* indexBuffer = getResource<Buffer>(drawCommand->indexBuffer);
+                                Buffer* vertexBuffer = getResource<Buffer>(drawCommand->vertexBuffer);
+
+                                if (!indexBuffer || !vertexBuffer)
+                                    throw std::runtime_error("Invalid mesh buffer");
+
+                                draw(*indexBuffer,
+                                     drawCommand->indexCount,
+                                     drawCommand->indexSize,
+                                     *vertexBuffer,
+                                     drawCommand->drawMode,
+                                     drawCommand->startIndex);
+
+                                ++currentDrawCallCount;
+
+                                break;
+                            }
+
+                            case Command::Type::DrawInstanced:
+                            {
+                                auto drawInstancedCommand = static_cast<const DrawInstancedCommand*>(command);
+
+                                Buffer* indexBuffer = getResource<Buffer>(drawInstancedCommand->indexBuffer);
+                                Buffer* vertexBuffer = getResource<Buffer>(drawInstancedCommand->vertexBuffer);
+
+                                if (!indexBuffer || !vertexBuffer)
+                                    throw std::runtime_error("Invalid mesh buffer");
+
+                                if (!currentShader)
+                                    throw std::runtime_error("No shader set");
+
+                                // the rasterizer draws the mesh with the constants of each instance
+                                for (const Instance& instance : drawInstancedCommand->instances)
+                                {
+                                    currentShader->setConstants(instance.color, instance.modelViewProjection);
+
+                                    draw(*indexBuffer,
+                                         drawInstancedCommand->indexCount,
+                                         drawInstancedCommand->indexSize,
+                                         *vertexBuffer,
+                                         drawInstancedCommand->drawMode,
+                                         drawInstancedCommand->startIndex);
+
+                                    ++currentDrawCallCount;
+                                }
+
+                                break;
+                            }
+
+                            case Command::Type::MultiDraw:
+                            {
+                                auto multiDrawCommand = static_cast<const MultiDrawCommand*>(command);
+
+                                Buffer* indexBuffer = getResource<Buffer>(multiDrawCommand->indexBuffer);
+                                Buffer* vertexBuffer = getResource<Buffer>(multiDrawCommand->vertexBuffer);
+
+                                if (!indexBuffer || !vertexBuffer)
+                                    throw std::runtime_error("Invalid mesh buffer");
+
+                                for (const DrawRange& range : multiDrawCommand->ranges)
+                                {
+                                    draw(*indexBuffer,
+                                         range.indexCount,
+                                         multiDrawCommand->indexSize,
+                                         *vertexBuffer,
+                                         multiDrawCommand->drawMode,
+                                         range.startIndex);
+
+                                    ++currentDrawCallCount;
+                                }
+
+                                break;
+                            }
+
+                            case Command::Type::PushDebugMarker:
+                            case Command::Type::PopDebugMarker:
+                                break;
+
+                            case Command::Type::InitBlendState:
+                            {
+                                auto initBlendStateCommand = static_cast<const InitBlendStateCommand*>(command);
+
+                                auto blendState = std::make_unique<BlendState>(*this,
+                                                                               initBlendStateCommand->enableBlending,
+                                                                               initBlendStateCommand->colorBlendSource,
+                                                                               initBlendStateCommand->colorBlendDest,
+                                                                               initBlendStateCommand->colorOperation,
+                                                                               initBlendStateCommand->alphaBlendSource,
+                                                                               initBlendStateCommand->alphaBlendDest,
+                                                                               initBlendStateCommand->alphaOperation,
+                                                                               initBlendStateCommand->colorMask);
+
+                                if (initBlendStateCommand->blendState > resources.size())
+                                    resources.resize(initBlendStateCommand->blendState);
+                                resources[initBlendStateCommand->blendState - 1] = std::move(blendState);
+                                break;
+                            }
+
+                            case Command::Type::InitBuffer:
+                            {
+                                auto initBufferCommand = static_cast<const InitBufferCommand*>(command);
+
+                                auto buffer = std::make_unique<Buffer>(*this,
+                                                                       initBufferCommand->bufferType,
+                                                                       initBufferCommand->flags,
+                                                                       initBufferCommand->data,
+                                                                       initBufferCommand->size);
+
+                                if (initBufferCommand->buffer > resources.size())
+                                    resources.resize(initBufferCommand->buffer);
+                                resources[initBufferCommand->buffer - 1] = std::move(buffer);
+                                break;
+                            }
+
+                            case Command::Type::SetBufferData:
+                            {
+                                auto setBufferDataCommand = static_cast<const SetBufferDataCommand*>(command);
+
+                                // the vertices are transformed when they are drawn, so the buffer can be changed
+                                Buffer* buffer = getResource<Buffer>(setBufferDataCommand->buffer);
+                                buffer->setData(setBufferDataCommand->data);
+                                break;
+                            }
+
+                            case Command::Type::UploadTransientGeometry:
+                            {
+                                auto uploadTransientGeometryCommand = static_cast<const UploadTransientGeometryCommand*>(command);
+
+                                const TransientBlock& block = commandBuffer.getTransientBlocks()[uploadTransientGeometryCommand->block];
+
+                                Buffer* indexBuffer = getResource<Buffer>(block.indexBuffer);
+                                Buffer* vertexBuffer = getResource<Buffer>(block.vertexBuffer);
+                                indexBuffer->setData(commandBuffer.getTransientIndexData(block));
+                                vertexBuffer->setData(commandBuffer.getTransientVertexData(block));
+                                break;
+                            }
+
+                            case Command::Type::InitShader:
+                            {
+                                auto initShaderCommand = static_cast<const InitShaderCommand*>(command);
+
+                                auto shader = std::make_unique<Shader>(*this,
+                                                                       initShaderCommand->vertexAttributes,
+                                                                       initShaderCommand->fragmentShaderConstantInfo,
+                                                                       initShaderCommand->vertexShaderConstantInfo);
+
+                                if (initShaderCommand->shader > resources.size())
+                                    resources.resize(initShaderCommand->shader);
+                                resources[initShaderCommand->shader - 1] = std::move(shader);
+                                break;
+                            }
+
+                            case Command::Type::SetShaderConstants:
+                            {
+                                auto setShaderConstantsCommand = static_cast<const SetShaderConstantsCommand*>(command);
+
+                                if (!currentShader)
+                                    throw std::runtime_error("No shader set");
+
+                                currentShader->setConstants(commandBuffer.getConstants(setShaderConstantsCommand->fragmentShaderConstants),
+                                                            commandBuffer.getConstants(setShaderConstantsCommand->vertexShaderConstants));
+                                break;
+                            }
+
+                            case Command::Type::InitTexture:
+                            {
+                                auto initTextureCommand = static_cast<const InitTextureCommand*>(command);
+
+                                auto texture = std::make_unique<Texture>(*this,
+                                                                         initTextureCommand->levels,
+                                                                         initTextureCommand->textureType,
+                                                                         initTextureCommand->flags,
+                                                                         initTextureCommand->sampleCount,
+                                                                         initTextureCommand->pixelFormat);
+
+                                if (initTextureCommand->texture > resources.size())
+                                    resources.resize(initTextureCommand->texture);
+                                resources[initTextureCommand->texture - 1] = std::move(texture);
+                                break;
+                            }
+
+                            case Command::Type::SetTextureData:
+                            {
+                                auto setTextureDataCommand = static_cast<const SetTextureDataCommand*>(command);
+
+                                rasterizer.flush();
+
+                                Texture* texture = getResource<Texture>(setTextureDataCommand->texture);
+                                texture->setData(setTextureDataCommand->levels);
+
+                                // the levels of a render target texture could have been reallocated
+                                if (currentRenderTarget) setRenderTarget(currentRenderTarget);
+                                break;
+                            }
+
+                            case Command::Type::SetTextureRegion:
+                            {
+                                auto setTextureRegionCommand = static_cast<const SetTextureRegionCommand*>(command);
+
+                                rasterizer.flush();
+
+                                Texture* texture = getResource<Texture>(setTextureRegionCommand->texture);
+                                texture->setRegionData(setTextureRegionCommand->x,
+                                                       setTextureRegionCommand->y,
+                                                       setTextureRegionCommand->size,
+                                                       setTextureRegionCommand->data);
+                                break;
+                            }
+
+                            case Command::Type::SetTextureParameters:
+                            {
+                                auto setTextureParametersCommand = static_cast<const SetTextureParametersCommand*>(command);
+
+                                rasterizer.flush();
+
+                                Texture* texture = getResource<Texture>(setTextureParametersCommand->texture);
+                                texture->setFilter(setTextureParametersCommand->filter == SamplerFilter::Default ? textureFilter : setTextureParametersCommand->filter);
+                                texture->setAddressX(setTextureParametersCommand->addressX);
+                                texture->setAddressY(setTextureParametersCommand->addressY);
+                                texture->setAddressZ(setTextureParametersCommand->addressZ);
+                                texture->setBorderColor(setTextureParametersCommand->borderColor);
+                                break;
+                            }
+
+                            case Command::Type::SetTextures:
+                            {
+                                auto setTexturesCommand = static_cast<const SetTexturesCommand*>(command);
+
+                                // the built-in programs sample only the first texture
+                                currentTexture = (setTexturesCommand->textures[0] != 0) ?
+                                    getResource<Texture>(setTexturesCommand->textures[0]) : nullptr;
+                                break;
+                            }
+
+                            default:
+                                throw std::runtime_error("Invalid command");
+                        }
+
+                        if (command->type == Command::Type::Present)
+                        {
+                            finishCommandBuffer(commandBuffer);
+                            return;
+                        }
+                    }
+                }
+            }
+
+            void RenderDevice::resizeFrameBuffer(const Size2U& newSize)
+            {
+                rasterizer.flush();
+
+                frameBufferSize = newSize;
+
+                const size_t pixelCount = static_cast<size_t>(newSize.v[0]) * newSize.v[1];
+                colorBuffer.assign(pixelCount * 4, 0);
+                if (depth) depthBuffer.assign(pixelCount, 1.0F);
+                if (stencil) stencilBuffer.assign(pixelCount, 0);
+
+                if (!currentRenderTarget) setRenderTarget(nullptr);
+            }
+
+            void RenderDevice::setRenderTarget(RenderTarget* renderTarget)
+            {
+                Rasterizer::FrameBuffer frameBuffer;
+
+                if (renderTarget)
+                {
+                    // only the first color texture is rendered to
+                    const auto& colorTextures = renderTarget->getColorTextures();
+                    Texture* colorTexture = colorTextures.empty() ? nullptr : *colorTextures.begin();
+                    Texture* depthTexture = renderTarget->getDepthTexture();
+                    Texture* sizeTexture = colorTexture ? colorTexture : depthTexture;
+
+                    if (sizeTexture)
+                    {
+                        frameBuffer.width = sizeTexture->getSize().v[0];
+                        frameBuffer.height = sizeTexture->getSize().v[1];
+                    }
+
+                    if (colorTexture && !colorTexture->getLevels().empty())
+                        frameBuffer.color = colorTexture->getLevels()[0].data.data();
+
+                    if (depthTexture)
+                    {
+                        if (depthTexture->getSize() != sizeTexture->getSize())
+                            throw std::runtime_error("Render target textures must be of the same size");
+
+                        if (!depthTexture->getDepth().empty()) frameBuffer.depth = depthTexture->getDepth().data();
+                        if (!depthTexture->getStencil().empty()) frameBuffer.stencil = depthTexture->getStencil().data();
+                    }
+                }
+                else
+                {
+                    frameBuffer.width = frameBufferSize.v[0];
+                    frameBuffer.height = frameBufferSize.v[1];
+                    frameBuffer.color = colorBuffer.data();
+                    if (!depthBuffer.empty()) frameBuffer.depth = depthBuffer.data();
+                    if (!stencilBuffer.empty()) frameBuffer.stencil = stencilBuffer.data();
+                }
+
+                rasterizer.setFrameBuffer(frameBuffer);
+                currentRenderTarget = renderTarget;
+            }
+
+            void RenderDevice::draw(const Buffer& indexBuffer, uint32_t indexCount, uint32_t indexSize,
+                                    const Buffer& vertexBuffer, DrawMode drawMode, uint32_t startIndex)
+            {
+                if (!currentShader)
+                    throw std::runtime_error("No shader set");
+
+                if (!indexCount) return;
+
+                const std::vector<uint8_t>& indexData = indexBuffer.getData();
+                const std::vector<uint8_t>& vertexData = vertexBuffer.getData();
+
+                if ((static_cast<uint64_t>(startIndex) + indexCount) * indexSize > indexData.size())
+                    throw std::runtime_error("Index buffer is too small");
+
+                const uint8_t* indices = indexData.data() + static_cast<size_t>(startIndex) * indexSize;
+
+                // transform only the vertices that the indices refer to
+                uint32_t minIndex = std::numeric_limits<uint32_t>::max();
+                uint32_t maxIndex = 0;
+
+                for (uint32_t i = 0; i < indexCount; ++i)
+                {
+                    const uint32_t index = getIndex(indices, indexSize, i);
+                    minIndex = std::min(minIndex, index);
+                    maxIndex = std::max(maxIndex, index);
+                }
+
+                if ((static_cast<uint64_t>(maxIndex) + 1) * sizeof(Vertex) > vertexData.size())
+                    throw std::runtime_error("Vertex buffer is too small");
+
+                const Matrix4F& modelViewProjection = currentShader->getModelViewProjection();
+                const float* m = modelViewProjection.m;
+                const bool textured = currentShader->getProgram() == Shader::Program::Texture;
+
+                transformedVertices.resize(maxIndex - minIndex + 1);
+
+                for (uint32_t index = minIndex; index <= maxIndex; ++index)
+                {
+                    Vertex vertex;
+                    std::memcpy(&vertex, vertexData.data() + static_cast<size_t>(index) * sizeof(Vertex), sizeof(Vertex));
+
+                    const float x = vertex.position.v[0];
+                    const float y = vertex.position.v[1];
+                    const float z = vertex.position.v[2];
+
+                    Rasterizer::Vertex& result = transformedVertices[index - minIndex];
+                    for (size_t i = 0; i < 4; ++i)
+                        result.position[i] = x * m[i] + y * m[4 + i] + z * m[8 + i] + m[12 + i];
+
+                    const std::array<float, 4> color = vertex.color.norm();
+                    std::copy(color.begin(), color.end(), result.color);
+
+                    result.texCoord[0] = vertex.texCoords[0].v[0];
+                    result.texCoord[1] = vertex.texCoords[0].v[1];
+                }
+
+                drawState.color = currentShader->getColor();
+                drawState.texture = textured ? currentTexture : nullptr;
+                rasterizer.setState(drawState);
+
+                const auto getVertex = [this, indices, indexSize, minIndex](uint32_t i) -> const Rasterizer::Vertex& {
+                    return transformedVertices[getIndex(indices, indexSize, i) - minIndex];
+                };
+
+                switch (drawMode)
+                {
+                    case DrawMode::PointList:
+                        for (uint32_t i = 0; i < indexCount; ++i)
+                            rasterizer.drawPoint(getVertex(i));
+                        break;
+                    case DrawMode::LineList:
+                        for (uint32_t i = 0; i + 1 < indexCount; i += 2)
+                            rasterizer.drawLine(getVertex(i), getVertex(i + 1));
+                        break;
+                    case DrawMode::LineStrip:
+                        for (uint32_t i = 0; i + 1 < indexCount; ++i)
+                            rasterizer.drawLine(getVertex(i), getVertex(i + 1));
+                        break;
+                    case DrawMode::TriangleList:
+                        for (uint32_t i = 0; i + 2 < indexCount; i += 3)
+                            rasterizer.drawTriangle(getVertex(i), getVertex(i + 1), getVertex(i + 2));
+                        break;
+                    case DrawMode::TriangleStrip:
+                        // every other triangle is flipped to keep the winding of the strip
+                        for (uint32_t i = 0; i + 2 < indexCount; ++i)
+                            if (i % 2)
+                                rasterizer.drawTriangle(getVertex(i + 1), getVertex(i), getVertex(i + 2));
+                            else
+                                rasterizer.drawTriangle(getVertex(i), getVertex(i + 1), getVertex(i + 2));
+                        break;
+                    default:
+                        throw std::runtime_error("Invalid draw mode");
+                }
+            }
+
+            void RenderDevice::generateScreenshot(const std::string& filename)
+            {
+                rasterizer.flush();
+
+                const int pixelSize = 4;
+
+                if (!stbi_write_png(filename.c_str(),
+                                    static_cast<int>(frameBufferSize.v[0]),
+                                    static_cast<int>(frameBufferSize.v[1]),
+                                    pixelSize,
+                                    colorBuffer.data(),
+                                    static_cast<int>(frameBufferSize.v[0]) * pixelSize))
+                    throw std::runtime_error("Failed to save image to file");
+            }
+        } // namespace software
+    } // namespace graphics
+} // namespace ouzel
@@ -0,0 +1,83 @@
+// Copyright 2015-2019 Elviss Strazdins. All rights reserved.
+
+#ifndef OUZEL_GRAPHICS_SOFTWARERENDERDEVICE_HPP
+#define OUZEL_GRAPHICS_SOFTWARERENDERDEVICE_HPP
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "graphics/DrawMode.hpp"
+#include "graphics/RenderDevice.hpp"
+#include "graphics/software/SoftwareRasterizer.hpp"
+#include "graphics/software/SoftwareRenderResource.hpp"
+#include "utils/Thread.hpp"
+
+namespace ouzel
+{
+    namespace graphics
+    {
+        namespace software
+        {
+            class Buffer;
+            class RenderTarget;
+            class Shader;
+            class Texture;
+
+            // Renders on the CPU to a frame buffer in memory, so it does not need a window system or a GPU,
+            // the frames can be read back with screenshots
+            class RenderDevice final: public graphics::RenderDevice
+            {
+                friend Renderer;
+            public:
+                explicit RenderDevice(const std::function<void(const Event&)>& initCallback);
+                ~RenderDevice();
+
+                template <class T>
+                inline auto getResource(uintptr_t id) const
+                {
+                    return id ? static_cast<T*>(resources[id - 1].get()) : nullptr;
+                }
+
+            private:
+                void init(Window* newWindow,
+                          const Size2U& newSize,
+                          uint32_t newSampleCount,
+                          SamplerFilter newTextureFilter,
+                          uint32_t newMaxAnisotropy,
+                          bool newSrgb,
+                          bool newVerticalSync,
+                          bool newDepth,
+                          bool newStencil,
+                          bool newDebugRenderer) final;
+
+                void process() final;
+                void generateScreenshot(const std::string& filename) final;
+                void renderMain();
+
+                void resizeFrameBuffer(const Size2U& newSize);
+                void setRenderTarget(RenderTarget* renderTarget);
+                void draw(const Buffer& indexBuffer, uint32_t indexCount, uint32_t indexSize,
+                          const Buffer& vertexBuffer, DrawMode drawMode, uint32_t startIndex);
+
+                Size2U frameBufferSize;
+                std::vector<uint8_t> colorBuffer;
+                std::vector<float> depthBuffer;
+                std::vector<uint8_t> stencilBuffer;
+
+                Rasterizer rasterizer;
+                Rasterizer::DrawState drawState;
+                RenderTarget* currentRenderTarget = nullptr;
+                Shader* currentShader = nullptr;
+                Texture* currentTexture = nullptr;
+                std::vector<Rasterizer::Vertex> transformedVertices;
+
+                std::vector<std::unique_ptr<RenderResource>> resources;
+
+                std::atomic_bool running{false};
+                Thread renderThread;
+            };
+        } // namespace software
+    } // namespace graphics
+} // namespace ouzel
+
+#endif // OUZEL_GRAPHICS_SOFTWARERENDERDEVICE_HPP
@@ -0,0 +1,40 @@
+// Copyright 2015-2019 Elviss Strazdins. All rights reserved.
+
+#ifndef OUZEL_GRAPHICS_SOFTWARERENDERTARGET_HPP
+#define OUZEL_GRAPHICS_SOFTWARERENDERTARGET_HPP
+
+#include <set>
+#include "graphics/software/SoftwareRenderResource.hpp"
+
+namespace ouzel
+{
+    namespace graphics
+    {
+        namespace software
+        {
+            class Texture;
+
+            class RenderTarget final: public RenderResource
+            {
+            public:
+                RenderTarget(RenderDevice& initRenderDevice,
+                             const std::set<Texture*>& initColorTextures,
+                             Texture* initDepthTexture):
+                    RenderResource(initRenderDevice),
+                    colorTextures(initColorTextures),
+                    depthTexture(initDepthTexture)
+                {
+                }
+
+                inline auto& getColorTextures() const noexcept { return colorTextures; }
+                inline auto getDepthTexture() const noexcept { return depthTexture; }
+
+            private:
+                std::set<Texture*> colorTextures;
+                Texture* depthTexture = nullptr;
+            };
+        } // namespace software
+    } // namespace graphics
+} // namespace ouzel
+
+#endif // OUZEL_GRAPHICS_SOFTWARERENDERTARGET_HPP
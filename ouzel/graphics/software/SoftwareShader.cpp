@@ -0,0 +1,78 @@
+// Copyright 2015-2019 Elviss Strazdins. All rights reserved.
+
+#include <algorithm>
+#include <stdexcept>
+#include "SoftwareShader.hpp"
+
+namespace ouzel
+{
+    namespace graphics
+    {
+        namespace software
+        {
+            Shader::Shader(RenderDevice& initRenderDevice,
+                           Span<const Vertex::Attribute::Usage> initVertexAttributes,
+                           Span<const ShaderConstantInfo> initFragmentShaderConstantInfo,
+                           Span<const ShaderConstantInfo> initVertexShaderConstantInfo):
+                RenderResource(initRenderDevice),
+                program(std::find(initVertexAttributes.begin(), initVertexAttributes.end(),
+                                  Vertex::Attribute::Usage::TextureCoordinates0) != initVertexAttributes.end() ?
+                        Program::Texture : Program::Color)
+            {
+                for (const ShaderConstantInfo& info : initFragmentShaderConstantInfo)
+                    fragmentShaderConstantInfo.emplace_back(info.name, info.dataType);
+
+                for (const ShaderConstantInfo& info : initVertexShaderConstantInfo)
+                    vertexShaderConstantInfo.emplace_back(info.name, info.dataType);
+            }
+
+            void Shader::setConstants(Span<const float> fragmentShaderConstants,
+                                      Span<const float> vertexShaderConstants)
+            {
+                size_t offset = 0;
+
+                for (const auto& info : fragmentShaderConstantInfo)
+                {
+                    if (offset == fragmentShaderConstants.size()) break;
+
+                    const size_t size = getDataTypeSize(info.second) / sizeof(float);
+
+                    if (offset + size > fragmentShaderConstants.size())
+                        throw std::runtime_error("Invalid pixel shader constant size");
+
+                    if (info.first == "color")
+                        std::copy(fragmentShaderConstants.begin() + offset,
+                                  fragmentShaderConstants.begin() + offset + std::min(size, color.size()),
+                                  color.begin());
+
+                    offset += size;
+                }
+
+                if (offset != fragmentShaderConstants.size())
+                    throw std::runtime_error("Invalid pixel shader constant size");
+
+                offset = 0;
+
+                for (const auto& info : vertexShaderConstantInfo)
+                {
+                    if (offset == vertexShaderConstants.size()) break;
+
+                    const size_t size = getDataTypeSize(info.second) / sizeof(float);
+
+                    if (offset + size > vertexShaderConstants.size())
+                        throw std::runtime_error("Invalid vertex shader constant size");
+
+                    if (info.first == "modelViewProj")
+                        std::copy(vertexShaderConstants.begin() + offset,
+                                  vertexShaderConstants.begin() + offset + std::min(size, sizeof(modelViewProjection.m) / sizeof(float)),
+                                  std::begin(modelViewProjection.m));
+
+                    offset += size;
+                }
+
+                if (offset != vertexShaderConstants.size())
+                    throw std::runtime_error("Invalid vertex shader constant size");
+            }
+        } // namespace software
+    } // namespace graphics
+} // namespace ouzel
@@ -0,0 +1,60 @@
+// Copyright 2015-2019 Elviss Strazdins. All rights reserved.
+
+#ifndef OUZEL_GRAPHICS_SOFTWARESHADER_HPP
+#define OUZEL_GRAPHICS_SOFTWARESHADER_HPP
+
+#include <array>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+#include "graphics/software/SoftwareRenderResource.hpp"
+#include "graphics/Commands.hpp"
+#include "graphics/DataType.hpp"
+#include "graphics/Vertex.hpp"
+#include "math/Matrix.hpp"
+#include "utils/Span.hpp"
+
+namespace ouzel
+{
+    namespace graphics
+    {
+        namespace software
+        {
+            // The rasterizer implements the programs of the built-in shaders, the bytecode is ignored and
+            // the program is selected by the vertex attributes
+            class Shader final: public RenderResource
+            {
+            public:
+                enum class Program
+                {
+                    Color, // vertex color multiplied by the "color" constant
+                    Texture // the color program multiplied by the first texture
+                };
+
+                Shader(RenderDevice& initRenderDevice,
+                       Span<const Vertex::Attribute::Usage> initVertexAttributes,
+                       Span<const ShaderConstantInfo> initFragmentShaderConstantInfo,
+                       Span<const ShaderConstantInfo> initVertexShaderConstantInfo);
+
+                void setConstants(Span<const float> fragmentShaderConstants,
+                                  Span<const float> vertexShaderConstants);
+
+                inline auto getProgram() const noexcept { return program; }
+                inline auto& getColor() const noexcept { return color; }
+                inline auto& getModelViewProjection() const noexcept { return modelViewProjection; }
+
+            private:
+                Program program = Program::Color;
+
+                std::vector<std::pair<std::string, DataType>> fragmentShaderConstantInfo;
+                std::vector<std::pair<std::string, DataType>> vertexShaderConstantInfo;
+
+                std::array<float, 4> color{{1.0F, 1.0F, 1.0F, 1.0F}};
+                Matrix4F modelViewProjection = Matrix4F::identity();
+            };
+        } // namespace software
+    } // namespace graphics
+} // namespace ouzel
+
+#endif // OUZEL_GRAPHICS_SOFTWARESHADER_HPP
@@ -0,0 +1,255 @@
+// Copyright 2015-2019 Elviss Strazdins. All rights reserved.
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include "SoftwareTexture.hpp"
+#include "graphics/Flags.hpp"
+
+namespace ouzel
+{
+    namespace graphics
+    {
+        namespace software
+        {
+            namespace
+            {
+                std::vector<uint8_t> convertLevel(const Size2U& size,
+                                                  Span<const uint8_t> data,
+                                                  PixelFormat pixelFormat)
+                {
+                    const size_t pixelCount = size.v[0] * size.v[1];
+                    std::vector<uint8_t> result(pixelCount * 4);
+
+                    if (data.empty()) return result;
+
+                    if (data.size() < pixelCount * getPixelSize(pixelFormat))
+                        throw std::runtime_error("Invalid texture data size");
+
+                    switch (pixelFormat)
+                    {
+                        case PixelFormat::RGBA8UNorm:
+                        case PixelFormat::RGBA8UNormSRGB:
+                            std::copy(data.begin(), data.begin() + static_cast<std::ptrdiff_t>(result.size()), result.begin());
+                            break;
+                        case PixelFormat::RG8UNorm:
+                            for (size_t i = 0; i < pixelCount; ++i)
+                            {
+                                result[i * 4 + 0] = data[i * 2 + 0];
+                                result[i * 4 + 1] = data[i * 2 + 1];
+                                result[i * 4 + 3] = 255;
+                            }
+                            break;
+                        case PixelFormat::R8UNorm:
+                            for (size_t i = 0; i < pixelCount; ++i)
+                            {
+                                result[i * 4 + 0] = data[i];
+                                result[i * 4 + 3] = 255;
+                            }
+                            break;
+                        case PixelFormat::A8UNorm:
+                            for (size_t i = 0; i < pixelCount; ++i)
+                                result[i * 4 + 3] = data[i];
+                            break;
+                        default:
+                            throw std::runtime_error("Unsupported pixel format");
+                    }
+
+                    return result;
+                }
+
+                // returns -1 for coordinates that sample the border color
+                int32_t getTexelCoordinate(int32_t coordinate, int32_t size, SamplerAddressMode addressMode) noexcept
+                {
+                    switch (addressMode)
+                    {
+                        case SamplerAddressMode::ClampToEdge:
+                            return std::min(std::max(coordinate, 0), size - 1);
+                        case SamplerAddressMode::ClampToBorder:
+                            return (coordinate < 0 || coordinate >= size) ? -1 : coordinate;
+                        case SamplerAddressMode::Repeat:
+                        {
+                            const int32_t result = coordinate % size;
+                            return result < 0 ? result + size : result;
+                        }
+                        case SamplerAddressMode::MirrorRepeat:
+                        {
+                            int32_t result = coordinate % (size * 2);
+                            if (result < 0) result += size * 2;
+                            return result < size ? result : size * 2 - 1 - result;
+                        }
+                        default:
+                            return -1;
+                    }
+                }
+            }
+
+            Texture::Texture(RenderDevice& initRenderDevice,
+                             Span<const TextureLevel> initLevels,
+                             TextureType type,
+                             uint32_t initFlags,
+                             uint32_t initSampleCount,
+                             PixelFormat initPixelFormat):
+                RenderResource(initRenderDevice),
+                flags(initFlags),
+                sampleCount(initSampleCount),
+                pixelFormat(initPixelFormat)
+            {
+                if (type != TextureType::TwoDimensional)
+                    throw std::runtime_error("Unsupported texture type");
+
+                if (initLevels.empty())
+                    throw std::runtime_error("Invalid mip map count");
+
+                size = initLevels[0].size;
+
+                if (pixelFormat == PixelFormat::Depth || pixelFormat == PixelFormat::DepthStencil)
+                {
+                    depth.resize(size.v[0] * size.v[1], 1.0F);
+                    if (pixelFormat == PixelFormat::DepthStencil)
+                        stencil.resize(size.v[0] * size.v[1], 0);
+                }
+                else
+                {
+                    levels.reserve(initLevels.size());
+
+                    for (const TextureLevel& level : initLevels)
+                        levels.push_back(Level{level.size, convertLevel(level.size, level.data, pixelFormat)});
+                }
+            }
+
+            void Texture::setData(Span<const TextureLevel> newLevels)
+            {
+                if (!(flags & Flags::Dynamic) || flags & Flags::BindRenderTarget)
+                    throw std::runtime_error("Texture is not dynamic");
+
+                for (size_t i = 0; i < newLevels.size() && i < levels.size(); ++i)
+                    if (!newLevels[i].data.empty())
+                        levels[i] = Level{newLevels[i].size, convertLevel(newLevels[i].size, newLevels[i].data, pixelFormat)};
+            }
+
+            void Texture::setRegionData(uint32_t x, uint32_t y, const Size2U& regionSize, Span<const uint8_t> data)
+            {
+                if (!(flags & Flags::Dynamic) || flags & Flags::BindRenderTarget)
+                    throw std::runtime_error("Texture is not dynamic");
+
+                if (levels.empty() || !regionSize.v[0] || !regionSize.v[1])
+                    return;
+
+                Level& level = levels.front();
+
+                if (x + regionSize.v[0] > level.size.v[0] || y + regionSize.v[1] > level.size.v[1])
+                    throw std::runtime_error("Invalid texture region");
+
+                const std::vector<uint8_t> region = convertLevel(regionSize, data, pixelFormat);
+                const size_t rowSize = regionSize.v[0] * 4;
+                const size_t pitch = level.size.v[0] * 4;
+
+                for (uint32_t row = 0; row < regionSize.v[1]; ++row)
+                    std::copy(region.begin() + static_cast<std::ptrdiff_t>(row * rowSize),
+                              region.begin() + static_cast<std::ptrdiff_t>((row + 1) * rowSize),
+                              level.data.begin() + static_cast<std::ptrdiff_t>((y + row) * pitch + x * 4));
+            }
+
+            void Texture::sample(float u, float v, float lod, float* result) const
+            {
+                if (levels.empty())
+                {
+                    std::fill(result, result + 4, 0.0F);
+                    return;
+                }
+
+                const float maxLevel = static_cast<float>(levels.size() - 1);
+                const Level& nearestLevel = levels[static_cast<size_t>(std::min(std::max(std::round(lod), 0.0F), maxLevel))];
+
+                switch (filter)
+                {
+                    case SamplerFilter::Point:
+                        sampleNearest(nearestLevel, u, v, result);
+                        break;
+                    case SamplerFilter::Linear:
+                        // linear minification and nearest magnification
+                        if (lod > 0.0F)
+                            sampleBilinear(nearestLevel, u, v, result);
+                        else
+                            sampleNearest(nearestLevel, u, v, result);
+                        break;
+                    case SamplerFilter::Bilinear:
+                        sampleBilinear(nearestLevel, u, v, result);
+                        break;
+                    case SamplerFilter::Trilinear:
+                    {
+                        const float level = std::min(std::max(lod, 0.0F), maxLevel);
+                        const float firstLevel = std::floor(level);
+                        const float t = level - firstLevel;
+
+                        sampleBilinear(levels[static_cast<size_t>(firstLevel)], u, v, result);
+
+                        if (t > 0.0F)
+                        {
+                            float secondResult[4];
+                            sampleBilinear(levels[static_cast<size_t>(firstLevel) + 1], u, v, secondResult);
+
+                            for (size_t c = 0; c < 4; ++c)
+                                result[c] += (secondResult[c] - result[c]) * t;
+                        }
+                        break;
+                    }
+                    default:
+                        // sampled on the rasterizer threads, so an invalid filter can not throw
+                        sampleNearest(nearestLevel, u, v, result);
+                        break;
+                }
+            }
+
+            void Texture::sampleNearest(const Level& level, float u, float v, float* result) const
+            {
+                fetch(level,
+                      static_cast<int32_t>(std::floor(u * static_cast<float>(level.size.v[0]))),
+                      static_cast<int32_t>(std::floor(v * static_cast<float>(level.size.v[1]))),
+                      result);
+            }
+
+            void Texture::sampleBilinear(const Level& level, float u, float v, float* result) const
+            {
+                const float x = u * static_cast<float>(level.size.v[0]) - 0.5F;
+                const float y = v * static_cast<float>(level.size.v[1]) - 0.5F;
+                const float x0 = std::floor(x);
+                const float y0 = std::floor(y);
+                const float tx = x - x0;
+                const float ty = y - y0;
+                const auto texelX = static_cast<int32_t>(x0);
+                const auto texelY = static_cast<int32_t>(y0);
+
+                float texels[4][4];
+                fetch(level, texelX, texelY, texels[0]);
+                fetch(level, texelX + 1, texelY, texels[1]);
+                fetch(level, texelX, texelY + 1, texels[2]);
+                fetch(level, texelX + 1, texelY + 1, texels[3]);
+
+                for (size_t c = 0; c < 4; ++c)
+                {
+                    const float top = texels[0][c] + (texels[1][c] - texels[0][c]) * tx;
+                    const float bottom = texels[2][c] + (texels[3][c] - texels[2][c]) * tx;
+                    result[c] = top + (bottom - top) * ty;
+                }
+            }
+
+            void Texture::fetch(const Level& level, int32_t x, int32_t y, float* result) const
+            {
+                const int32_t texelX = getTexelCoordinate(x, static_cast<int32_t>(level.size.v[0]), addressX);
+                const int32_t texelY = getTexelCoordinate(y, static_cast<int32_t>(level.size.v[1]), addressY);
+
+                if (texelX < 0 || texelY < 0)
+                    std::copy(borderColor.begin(), borderColor.end(), result);
+                else
+                {
+                    const uint8_t* texel = level.data.data() + (static_cast<size_t>(texelY) * level.size.v[0] + static_cast<size_t>(texelX)) * 4;
+
+                    for (size_t c = 0; c < 4; ++c)
+                        result[c] = texel[c] / 255.0F;
+                }
+            }
+        } // namespace software
+    } // namespace graphics
+} // namespace ouzel
@@ -0,0 +1,88 @@
+// Copyright 2015-2019 Elviss Strazdins. All rights reserved.
+
+#ifndef OUZEL_GRAPHICS_SOFTWARETEXTURE_HPP
+#define OUZEL_GRAPHICS_SOFTWARETEXTURE_HPP
+
+#include <array>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "graphics/software/SoftwareRenderResource.hpp"
+#include "graphics/Commands.hpp"
+#include "graphics/PixelFormat.hpp"
+#include "graphics/SamplerAddressMode.hpp"
+#include "graphics/SamplerFilter.hpp"
+#include "graphics/TextureType.hpp"
+#include "math/Color.hpp"
+#include "math/Size.hpp"
+
+namespace ouzel
+{
+    namespace graphics
+    {
+        namespace software
+        {
+            // Color textures are stored as RGBA8 levels, depth textures as a float depth and an 8-bit stencil plane
+            class Texture final: public RenderResource
+            {
+            public:
+                struct Level final
+                {
+                    Size2U size;
+                    std::vector<uint8_t> data;
+                };
+
+                Texture(RenderDevice& initRenderDevice,
+                        Span<const TextureLevel> initLevels,
+                        TextureType type,
+                        uint32_t initFlags = 0,
+                        uint32_t initSampleCount = 1,
+                        PixelFormat initPixelFormat = PixelFormat::RGBA8UNorm);
+
+                void setData(Span<const TextureLevel> newLevels);
+                void setRegionData(uint32_t x, uint32_t y, const Size2U& regionSize, Span<const uint8_t> data);
+                inline void setFilter(SamplerFilter newFilter) noexcept { filter = newFilter; }
+                inline void setAddressX(SamplerAddressMode newAddressX) noexcept { addressX = newAddressX; }
+                inline void setAddressY(SamplerAddressMode newAddressY) noexcept { addressY = newAddressY; }
+                inline void setAddressZ(SamplerAddressMode newAddressZ) noexcept { addressZ = newAddressZ; }
+                inline void setBorderColor(Color newBorderColor) noexcept { borderColor = newBorderColor.norm(); }
+
+                inline auto getFlags() const noexcept { return flags; }
+                inline auto getSampleCount() const noexcept { return sampleCount; }
+                inline auto getPixelFormat() const noexcept { return pixelFormat; }
+
+                inline auto& getSize() const noexcept { return size; }
+                inline auto& getLevels() noexcept { return levels; }
+                inline auto& getLevels() const noexcept { return levels; }
+                inline auto& getDepth() noexcept { return depth; }
+                inline auto& getStencil() noexcept { return stencil; }
+
+                // writes the normalized RGBA color at the texture coordinates to the result,
+                // the level of detail selects the mip level
+                void sample(float u, float v, float lod, float* result) const;
+
+            private:
+                void sampleNearest(const Level& level, float u, float v, float* result) const;
+                void sampleBilinear(const Level& level, float u, float v, float* result) const;
+                void fetch(const Level& level, int32_t x, int32_t y, float* result) const;
+
+                uint32_t flags = 0;
+                uint32_t sampleCount = 1;
+                PixelFormat pixelFormat = PixelFormat::RGBA8UNorm;
+
+                SamplerFilter filter = SamplerFilter::Point;
+                SamplerAddressMode addressX = SamplerAddressMode::ClampToEdge;
+                SamplerAddressMode addressY = SamplerAddressMode::ClampToEdge;
+                SamplerAddressMode addressZ = SamplerAddressMode::ClampToEdge;
+                std::array<float, 4> borderColor{{0.0F, 0.0F, 0.0F, 0.0F}};
+
+                Size2U size;
+                std::vector<Level> levels;
+                std::vector<float> depth;
+                std::vector<uint8_t> stencil;
+            };
+        } // namespace software
+    } // namespace graphics
+} // namespace ouzel
+
+#endif // OUZEL_GRAPHICS_SOFTWARETEXTURE_HPP
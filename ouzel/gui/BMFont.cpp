@@ -29,8 +29,8 @@ namespace ouzel
                 return c <= 0x1F;
             }
 
-            void skipWhitespaces(const std::vector<uint8_t>& str,
-                                 std::vector<uint8_t>::const_iterator& iterator)
+            void skipWhitespaces(Span<const uint8_t> str,
+                                 const uint8_t*& iterator)
             {
                 while (iterator != str.end())
                     if (isWhitespace(*iterator))
@@ -39,8 +39,8 @@ namespace ouzel
                         break;
             }
 
-            void skipLine(const std::vector<uint8_t>& str,
-                          std::vector<uint8_t>::const_iterator& iterator)
+            void skipLine(Span<const uint8_t> str,
+                          const uint8_t*& iterator)
             {
                 while (iterator != str.end())
                 {
@@ -54,8 +54,8 @@ namespace ouzel
                 }
             }
 
-            std::string parseString(const std::vector<uint8_t>& str,
-                                    std::vector<uint8_t>::const_iterator& iterator)
+            std::string parseString(Span<const uint8_t> str,
+                                    const uint8_t*& iterator)
             {
                 if (iterator == str.end())
                     throw std::runtime_error("Invalid string");
@@ -100,8 +100,8 @@ namespace ouzel
                 return result;
             }
 
-            std::string parseInt(const std::vector<uint8_t>& str,
-                                 std::vector<uint8_t>::const_iterator& iterator)
+            std::string parseInt(Span<const uint8_t> str,
+                                 const uint8_t*& iterator)
             {
                 std::string result;
                 uint32_t length = 1;
@@ -126,8 +126,8 @@ namespace ouzel
                 return result;
             }
 
-            void expectToken(const std::vector<uint8_t>& str,
-                             std::vector<uint8_t>::const_iterator& iterator,
+            void expectToken(Span<const uint8_t> str,
+                             const uint8_t*& iterator,
                              char token)
             {
                 if (iterator == str.end() || *iterator != static_cast<uint8_t>(token))
@@ -137,7 +137,7 @@ namespace ouzel
             }
         }
 
-        BMFont::BMFont(const std::vector<uint8_t>& data)
+        BMFont::BMFont(Span<const uint8_t> data)
         {
             auto iterator = data.cbegin();
 
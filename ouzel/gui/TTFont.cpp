@@ -1,5 +1,6 @@
 // Copyright 2015-2019 Elviss Strazdins. All rights reserved.
 
+#include <algorithm>
 #include <cassert>
 #include <stdexcept>
 #include "TTFont.hpp"
@@ -28,8 +29,26 @@ namespace ouzel
 {
     namespace gui
     {
-        TTFont::TTFont(const std::vector<uint8_t>& initData, bool initMipmaps):
-            data(initData),
+        namespace
+        {
+            constexpr uint32_t GLYPH_SPACING = 2;
+
+            void clearAtlasData(std::vector<uint8_t>& data, const Size2U& size)
+            {
+                data.resize(size.v[0] * size.v[1] * 4);
+
+                for (size_t i = 0; i < data.size(); i += 4)
+                {
+                    data[i + 0] = 255;
+                    data[i + 1] = 255;
+                    data[i + 2] = 255;
+                    data[i + 3] = 0;
+                }
+            }
+        }
+
+        TTFont::TTFont(Span<const uint8_t> initData, bool initMipmaps):
+            data(initData.begin(), initData.end()),
             mipmaps(initMipmaps)
         {
             const int offset = stbtt_GetFontOffsetForIndex(data.data(), 0);
@@ -41,6 +60,8 @@ namespace ouzel
 
             if (!stbtt_InitFont(font.get(), data.data(), offset))
                 throw std::runtime_error("Failed to load font");
+
+            stbtt_GetFontVMetrics(font.get(), &ascent, &descent, &lineGap);
         }
 
         Font::RenderData TTFont::getRenderData(const std::string& text,
@@ -51,111 +72,30 @@ namespace ouzel
             if (!font)
                 throw std::runtime_error("Font not loaded");
 
-            constexpr uint32_t SPACING = 2;
-
-            struct CharDescriptor final
-            {
-                uint16_t x = 0;
-                uint16_t y = 0;
-                uint16_t width = 0;
-                uint16_t height = 0;
-                Vector2F offset;
-                float advance = 0;
-                std::vector<uint8_t> bitmap;
-            };
-
-            std::unordered_map<uint32_t, CharDescriptor> chars;
-
             const float s = stbtt_ScaleForPixelHeight(font.get(), fontSize);
 
             const std::u32string utf32Text = utf8::toUtf32(text);
 
-            std::set<char32_t> glyphs;
-            for (const char32_t i : utf32Text)
-                glyphs.insert(i);
-
-            uint16_t width = 0;
-            uint16_t height = 0;
-
-            int ascent;
-            int descent;
-            int lineGap;
-            stbtt_GetFontVMetrics(font.get(), &ascent, &descent, &lineGap);
-
-            for (const char32_t c : glyphs)
-            {
-                int w;
-                int h;
-                int xoff;
-                int yoff;
-
-                if (const int index = stbtt_FindGlyphIndex(font.get(), static_cast<int>(c)))
-                {
-                    int advance;
-                    int leftBearing;
-                    stbtt_GetGlyphHMetrics(font.get(), index, &advance, &leftBearing);
-
-                    CharDescriptor charDesc;
-
-                    if (unsigned char* bitmap = stbtt_GetGlyphBitmapSubpixel(font.get(), s, s, 0.0F, 0.0F, index, &w, &h, &xoff, &yoff))
-                    {
-                        charDesc.width = static_cast<uint16_t>(w);
-                        charDesc.height = static_cast<uint16_t>(h);
-                        charDesc.offset.v[0] = static_cast<float>(leftBearing * s);
-                        charDesc.offset.v[1] = static_cast<float>(yoff + (ascent - descent) * s);
-                        charDesc.bitmap = std::vector<uint8_t>(bitmap, bitmap + h * w);
-                        charDesc.x = width;
-
-                        width += static_cast<uint16_t>(w);
-                        height = height > static_cast<uint16_t>(h) ? height : static_cast<uint16_t>(h);
-
-                        stbtt_FreeBitmap(bitmap, nullptr);
-                    }
-
-                    charDesc.advance = static_cast<float>(advance * s);
-
-                    if (!chars.empty())
-                        width += SPACING;
-
-                    chars[c] = charDesc;
-                }
-            }
-
-            std::vector<uint8_t> textureData(width * height * 4);
-
-            for (uint16_t posX = 0; posX < width; ++posX)
+            auto atlasIterator = atlases.find(fontSize);
+            if (atlasIterator == atlases.end())
             {
-                for (uint16_t posY = 0; posY < height; ++posY)
-                {
-                    textureData[(posY * width + posX) * 4 + 0] = 255;
-                    textureData[(posY * width + posX) * 4 + 1] = 255;
-                    textureData[(posY * width + posX) * 4 + 2] = 255;
-                    textureData[(posY * width + posX) * 4 + 3] = 0;
-                }
+                atlasIterator = atlases.insert(std::make_pair(fontSize, GlyphAtlas())).first;
+                GlyphAtlas& newAtlas = atlasIterator->second;
+                newAtlas.size = Size2U(INITIAL_ATLAS_SIZE, INITIAL_ATLAS_SIZE);
+                clearAtlasData(newAtlas.data, newAtlas.size);
             }
 
-            for (const auto& c : chars)
-            {
-                const CharDescriptor& charDesc = c.second;
+            GlyphAtlas& atlas = atlasIterator->second;
+            ++atlas.useCounter;
 
-                for (uint16_t posX = 0; posX < charDesc.width; ++posX)
-                {
-                    for (uint16_t posY = 0; posY < charDesc.height; ++posY)
-                    {
-                        textureData[(posY * width + posX + charDesc.x) * 4 + 0] = 255;
-                        textureData[(posY * width + posX + charDesc.x) * 4 + 1] = 255;
-                        textureData[(posY * width + posX + charDesc.x) * 4 + 2] = 255;
-                        textureData[(posY * width + posX + charDesc.x) * 4 + 3] = charDesc.bitmap[posY * charDesc.width + posX];
-                    }
-                }
-            }
+            // rasterize the missing glyphs first, adding a glyph can move the other glyphs of the atlas
+            for (const char32_t c : utf32Text)
+                getGlyph(atlas, c, s);
 
-            RenderData result;
+            updateTexture(atlas);
 
-            auto texture = std::make_shared<graphics::Texture>(*engine->getRenderer(),
-                                                               textureData,
-                                                               Size2U(width, height), 0,
-                                                               mipmaps ? 0 : 1);
+            const float width = static_cast<float>(atlas.size.v[0]);
+            const float height = static_cast<float>(atlas.size.v[1]);
 
             Vector2F position;
 
@@ -170,11 +110,11 @@ namespace ouzel
 
             for (auto i = utf32Text.begin(); i != utf32Text.end(); ++i)
             {
-                auto iter = chars.find(*i);
+                auto iter = atlas.glyphs.find(*i);
 
-                if (iter != chars.end())
+                if (iter != atlas.glyphs.end())
                 {
-                    const CharDescriptor& f = iter->second;
+                    const Glyph& f = iter->second;
 
                     auto startIndex = static_cast<uint16_t>(vertices.size());
                     indices.push_back(startIndex + 0);
@@ -185,11 +125,11 @@ namespace ouzel
                     indices.push_back(startIndex + 3);
                     indices.push_back(startIndex + 2);
 
-                    Vector2F leftTop(f.x / static_cast<float>(width),
-                                     f.y / static_cast<float>(height));
+                    Vector2F leftTop(f.x / width,
+                                     f.y / height);
 
-                    Vector2F rightBottom((f.x + f.width) / static_cast<float>(width),
-                                         (f.y + f.height) / static_cast<float>(height));
+                    Vector2F rightBottom((f.x + f.width) / width,
+                                         (f.y + f.height) / height);
 
                     textCoords[0] = Vector2F(leftTop.v[0], rightBottom.v[1]);
                     textCoords[1] = Vector2F(rightBottom.v[0], rightBottom.v[1]);
@@ -206,12 +146,7 @@ namespace ouzel
                                           color, textCoords[3], Vector3F{0.0F, 0.0F, -1.0F});
 
                     if ((i + 1) != utf32Text.end())
-                    {
-                        const int kernAdvance = stbtt_GetCodepointKernAdvance(font.get(),
-                                                                              static_cast<int>(*i),
-                                                                              static_cast<int>(*(i + 1)));
-                        position.v[0] += static_cast<float>(kernAdvance) * s;
-                    }
+                        position.v[0] += static_cast<float>(getKerning(*i, *(i + 1))) * s;
 
                     position.v[0] += f.advance;
                 }
@@ -235,7 +170,258 @@ namespace ouzel
             for (graphics::Vertex& vertex : vertices)
                 vertex.position.v[1] += textHeight * (1.0F - anchor.v[1]);
 
-            return std::make_tuple(std::move(indices), std::move(vertices), std::move(texture));
+            return std::make_tuple(std::move(indices), std::move(vertices), atlas.texture);
+        }
+
+        const TTFont::Glyph* TTFont::getGlyph(GlyphAtlas& atlas, char32_t c, float scale) const
+        {
+            auto i = atlas.glyphs.find(c);
+
+            if (i != atlas.glyphs.end())
+            {
+                i->second.lastUse = atlas.useCounter;
+                return &i->second;
+            }
+
+            const int index = stbtt_FindGlyphIndex(font.get(), static_cast<int>(c));
+            if (!index) return nullptr;
+
+            int advance;
+            int leftBearing;
+            stbtt_GetGlyphHMetrics(font.get(), index, &advance, &leftBearing);
+
+            Glyph glyph;
+            glyph.advance = static_cast<float>(advance * scale);
+            glyph.lastUse = atlas.useCounter;
+
+            std::vector<uint8_t> bitmap;
+
+            int w;
+            int h;
+            int xoff;
+            int yoff;
+
+            if (unsigned char* glyphBitmap = stbtt_GetGlyphBitmapSubpixel(font.get(), scale, scale, 0.0F, 0.0F, index, &w, &h, &xoff, &yoff))
+            {
+                glyph.width = static_cast<uint16_t>(w);
+                glyph.height = static_cast<uint16_t>(h);
+                glyph.offset.v[0] = static_cast<float>(leftBearing * scale);
+                glyph.offset.v[1] = static_cast<float>(yoff + (ascent - descent) * scale);
+                bitmap.assign(glyphBitmap, glyphBitmap + h * w);
+
+                stbtt_FreeBitmap(glyphBitmap, nullptr);
+            }
+
+            bool evicted = false;
+
+            while (!packGlyph(atlas, glyph, bitmap.data()))
+            {
+                if (atlas.size.v[0] < MAX_ATLAS_SIZE)
+                    growAtlas(atlas);
+                else if (!evicted)
+                {
+                    evictGlyphs(atlas);
+                    evicted = true;
+                }
+                else
+                {
+                    // keep the metrics so that the rest of the text is laid out correctly,
+                    // the glyph is rasterized again when an eviction makes room for it
+                    engine->log(Log::Level::Warning) << "Glyph " << static_cast<uint32_t>(c) << " does not fit in the font atlas";
+                    glyph.width = 0;
+                    glyph.height = 0;
+                    glyph.packed = false;
+                    break;
+                }
+            }
+
+            return &(atlas.glyphs[c] = glyph);
+        }
+
+        bool TTFont::packGlyph(GlyphAtlas& atlas, Glyph& glyph, const uint8_t* bitmap) const
+        {
+            if (!glyph.width || !glyph.height)
+            {
+                glyph.x = 0;
+                glyph.y = 0;
+                return true;
+            }
+
+            if (atlas.rowX + glyph.width > atlas.size.v[0])
+            {
+                // start a new row
+                atlas.rowX = 0;
+                atlas.rowY += atlas.rowHeight + GLYPH_SPACING;
+                atlas.rowHeight = 0;
+            }
+
+            if (atlas.rowX + glyph.width > atlas.size.v[0] ||
+                atlas.rowY + glyph.height > atlas.size.v[1])
+                return false;
+
+            glyph.x = static_cast<uint16_t>(atlas.rowX);
+            glyph.y = static_cast<uint16_t>(atlas.rowY);
+
+            atlas.rowX += glyph.width + GLYPH_SPACING;
+            if (glyph.height > atlas.rowHeight) atlas.rowHeight = glyph.height;
+
+            const uint32_t pitch = atlas.size.v[0] * 4;
+
+            for (uint32_t posY = 0; posY < glyph.height; ++posY)
+                for (uint32_t posX = 0; posX < glyph.width; ++posX)
+                    atlas.data[(glyph.y + posY) * pitch + (glyph.x + posX) * 4 + 3] = bitmap[posY * glyph.width + posX];
+
+            if (!atlas.textureDirty)
+            {
+                if (atlas.dirtyMinX >= atlas.dirtyMaxX || atlas.dirtyMinY >= atlas.dirtyMaxY)
+                {
+                    atlas.dirtyMinX = glyph.x;
+                    atlas.dirtyMinY = glyph.y;
+                    atlas.dirtyMaxX = glyph.x + glyph.width;
+                    atlas.dirtyMaxY = glyph.y + glyph.height;
+                }
+                else
+                {
+                    if (glyph.x < atlas.dirtyMinX) atlas.dirtyMinX = glyph.x;
+                    if (glyph.y < atlas.dirtyMinY) atlas.dirtyMinY = glyph.y;
+                    if (glyph.x + glyph.width > atlas.dirtyMaxX) atlas.dirtyMaxX = glyph.x + glyph.width;
+                    if (glyph.y + glyph.height > atlas.dirtyMaxY) atlas.dirtyMaxY = glyph.y + glyph.height;
+                }
+            }
+
+            return true;
+        }
+
+        void TTFont::growAtlas(GlyphAtlas& atlas) const
+        {
+            const Size2U newSize(atlas.size.v[0] * 2, atlas.size.v[1] * 2);
+
+            std::vector<uint8_t> newData;
+            clearAtlasData(newData, newSize);
+
+            const uint32_t pitch = atlas.size.v[0] * 4;
+            const uint32_t newPitch = newSize.v[0] * 4;
+
+            for (uint32_t row = 0; row < atlas.size.v[1]; ++row)
+                std::copy(atlas.data.begin() + row * pitch,
+                          atlas.data.begin() + (row + 1) * pitch,
+                          newData.begin() + row * newPitch);
+
+            atlas.size = newSize;
+            atlas.data = std::move(newData);
+            atlas.textureDirty = true;
+        }
+
+        void TTFont::evictGlyphs(GlyphAtlas& atlas) const
+        {
+            std::vector<std::pair<char32_t, Glyph>> oldGlyphs(atlas.glyphs.begin(), atlas.glyphs.end());
+            std::sort(oldGlyphs.begin(), oldGlyphs.end(),
+                      [](const std::pair<char32_t, Glyph>& a, const std::pair<char32_t, Glyph>& b) noexcept {
+                          return a.second.lastUse > b.second.lastUse;
+                      });
+
+            const std::vector<uint8_t> oldData = std::move(atlas.data);
+            const uint32_t pitch = atlas.size.v[0] * 4;
+
+            atlas.glyphs.clear();
+            clearAtlasData(atlas.data, atlas.size);
+            atlas.rowX = 0;
+            atlas.rowY = 0;
+            atlas.rowHeight = 0;
+            atlas.textureDirty = true;
+
+            // keep the glyphs of the current text and the most recently used glyphs until half of the atlas is filled
+            const uint32_t maxArea = atlas.size.v[0] * atlas.size.v[1] / 2;
+            uint32_t area = 0;
+            std::vector<uint8_t> bitmap;
+
+            for (const auto& oldGlyph : oldGlyphs)
+            {
+                if (oldGlyph.second.lastUse != atlas.useCounter && area >= maxArea)
+                    break;
+
+                // glyphs that did not fit before are rasterized again when they are used after the eviction
+                if (!oldGlyph.second.packed)
+                {
+                    if (oldGlyph.second.lastUse == atlas.useCounter)
+                        atlas.glyphs[oldGlyph.first] = oldGlyph.second;
+                    continue;
+                }
+
+                Glyph glyph = oldGlyph.second;
+
+                bitmap.resize(glyph.width * glyph.height);
+                for (uint32_t posY = 0; posY < glyph.height; ++posY)
+                    for (uint32_t posX = 0; posX < glyph.width; ++posX)
+                        bitmap[posY * glyph.width + posX] = oldData[(glyph.y + posY) * pitch + (glyph.x + posX) * 4 + 3];
+
+                if (!packGlyph(atlas, glyph, bitmap.data()))
+                {
+                    if (oldGlyph.second.lastUse != atlas.useCounter)
+                        break;
+
+                    // the current text does not fit in the atlas, its remaining glyphs are not drawn
+                    engine->log(Log::Level::Warning) << "Glyph " << static_cast<uint32_t>(oldGlyph.first) << " does not fit in the font atlas";
+                    glyph.width = 0;
+                    glyph.height = 0;
+                    glyph.packed = false;
+                }
+
+                area += (glyph.width + GLYPH_SPACING) * (glyph.height + GLYPH_SPACING);
+                atlas.glyphs[oldGlyph.first] = glyph;
+            }
+        }
+
+        void TTFont::updateTexture(GlyphAtlas& atlas) const
+        {
+            if (atlas.textureDirty)
+            {
+                // the previous texture is kept alive by the render data that still uses it
+                atlas.texture = std::make_shared<graphics::Texture>(*engine->getRenderer(),
+                                                                    atlas.data,
+                                                                    atlas.size,
+                                                                    graphics::Flags::Dynamic,
+                                                                    mipmaps ? 0 : 1);
+                atlas.textureDirty = false;
+            }
+            else if (atlas.dirtyMinX < atlas.dirtyMaxX && atlas.dirtyMinY < atlas.dirtyMaxY)
+            {
+                if (atlas.texture->getMipmaps() != 1)
+                    atlas.texture->setData(atlas.data);
+                else
+                {
+                    const Size2U regionSize(atlas.dirtyMaxX - atlas.dirtyMinX,
+                                            atlas.dirtyMaxY - atlas.dirtyMinY);
+                    const uint32_t pitch = atlas.size.v[0] * 4;
+                    const uint32_t rowSize = regionSize.v[0] * 4;
+
+                    std::vector<uint8_t> regionData(rowSize * regionSize.v[1]);
+
+                    for (uint32_t row = 0; row < regionSize.v[1]; ++row)
+                        std::copy(atlas.data.begin() + (atlas.dirtyMinY + row) * pitch + atlas.dirtyMinX * 4,
+                                  atlas.data.begin() + (atlas.dirtyMinY + row) * pitch + atlas.dirtyMinX * 4 + rowSize,
+                                  regionData.begin() + row * rowSize);
+
+                    atlas.texture->setRegionData(atlas.dirtyMinX, atlas.dirtyMinY, regionSize, regionData);
+                }
+            }
+
+            atlas.dirtyMinX = atlas.dirtyMinY = 0;
+            atlas.dirtyMaxX = atlas.dirtyMaxY = 0;
+        }
+
+        int TTFont::getKerning(char32_t first, char32_t second) const
+        {
+            const uint64_t key = (static_cast<uint64_t>(first) << 32) | second;
+
+            auto i = kerning.find(key);
+            if (i != kerning.end()) return i->second;
+
+            const int kernAdvance = stbtt_GetCodepointKernAdvance(font.get(),
+                                                                  static_cast<int>(first),
+                                                                  static_cast<int>(second));
+            kerning[key] = kernAdvance;
+            return kernAdvance;
         }
     } // namespace gui
 } // namespace ouzel
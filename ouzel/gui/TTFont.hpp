@@ -4,6 +4,7 @@
 #define OUZEL_GUI_TTFONT_HPP
 
 #include "gui/Font.hpp"
+#include "utils/Span.hpp"
 
 struct stbtt_fontinfo;
 
@@ -14,8 +15,11 @@ namespace ouzel
         class TTFont final: public Font
         {
         public:
+            static constexpr uint32_t INITIAL_ATLAS_SIZE = 256;
+            static constexpr uint32_t MAX_ATLAS_SIZE = 2048;
+
             TTFont() = default;
-            TTFont(const std::vector<uint8_t>& newData, bool newMipmaps = true);
+            TTFont(Span<const uint8_t> newData, bool newMipmaps = true);
 
             RenderData getRenderData(const std::string& text,
                                      Color color,
@@ -25,9 +29,57 @@ namespace ouzel
             float getStringWidth(const std::string& text);
 
         private:
+            struct Glyph final
+            {
+                uint16_t x = 0;
+                uint16_t y = 0;
+                uint16_t width = 0;
+                uint16_t height = 0;
+                Vector2F offset;
+                float advance = 0.0F;
+                uint32_t lastUse = 0;
+                bool packed = true; // glyphs that did not fit in the atlas take up space but are not drawn
+            };
+
+            // glyphs of one font size packed into rows of a texture, the texture is replaced
+            // when the atlas grows or evicts glyphs, so that the previous render data stays valid
+            struct GlyphAtlas final
+            {
+                Size2U size;
+                std::vector<uint8_t> data;
+                std::shared_ptr<graphics::Texture> texture;
+                std::unordered_map<char32_t, Glyph> glyphs;
+
+                uint32_t rowX = 0;
+                uint32_t rowY = 0;
+                uint32_t rowHeight = 0;
+
+                bool textureDirty = true;
+                uint32_t dirtyMinX = 0;
+                uint32_t dirtyMinY = 0;
+                uint32_t dirtyMaxX = 0;
+                uint32_t dirtyMaxY = 0;
+
+                uint32_t useCounter = 0;
+            };
+
+            const Glyph* getGlyph(GlyphAtlas& atlas, char32_t c, float scale) const;
+            bool packGlyph(GlyphAtlas& atlas, Glyph& glyph, const uint8_t* bitmap) const;
+            void growAtlas(GlyphAtlas& atlas) const;
+            void evictGlyphs(GlyphAtlas& atlas) const;
+            void updateTexture(GlyphAtlas& atlas) const;
+            int getKerning(char32_t first, char32_t second) const;
+
             std::unique_ptr<stbtt_fontinfo> font;
             std::vector<uint8_t> data;
             bool mipmaps = true;
+
+            int ascent = 0;
+            int descent = 0;
+            int lineGap = 0;
+
+            mutable std::map<float, GlyphAtlas> atlases;
+            mutable std::unordered_map<uint64_t, int> kerning;
         };
     } // namespace gui
 } // namespace ouzel
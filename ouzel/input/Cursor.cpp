@@ -51,7 +51,7 @@ namespace ouzel
         void Cursor::init(const std::string& filename, const Vector2F& hotSpot)
         {
             // TODO: load with asset loader
-            const std::vector<uint8_t> data = engine->getFileSystem().readFile(filename);
+            const storage::FileView data = engine->getFileSystem().readFileView(filename);
 
             int width;
             int height;
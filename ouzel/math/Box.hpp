@@ -43,9 +43,9 @@ namespace ouzel
         bool intersects(const Box& aabb) const noexcept
         {
             for (size_t i = 0; i < N; ++i)
-                if (aabb.min.v[0] > max.v[0]) return false;
+                if (aabb.min.v[i] > max.v[i]) return false;
             for (size_t i = 0; i < N; ++i)
-                if (aabb.max.v[0] < min.v[0]) return false;
+                if (aabb.max.v[i] < min.v[i]) return false;
             return true;
         }
 
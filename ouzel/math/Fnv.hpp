@@ -3,6 +3,7 @@
 #ifndef OUZEL_MATH_FNV_HPP
 #define OUZEL_MATH_FNV_HPP
 
+#include <cstddef>
 #include <cstdint>
 
 namespace ouzel
@@ -23,6 +24,15 @@ namespace ouzel
         {
             return (i < sizeof(Value)) ? hash<Result>(value, i + 1, (result * prime<Result>) ^ ((value >> (i * 8)) & 0xFF)) : result;
         }
+
+        template <typename Result>
+        constexpr Result hash(const char* str, size_t length, Result result = offsetBasis<Result>) noexcept
+        {
+            for (size_t i = 0; i < length; ++i)
+                result = (result * prime<Result>) ^ static_cast<uint8_t>(str[i]);
+
+            return result;
+        }
     } // namespace fnv
 } // namespace ouzel
 
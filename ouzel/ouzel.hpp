@@ -3,8 +3,10 @@
 #ifndef OUZEL_HPP
 #define OUZEL_HPP
 
+#include "assets/AssetId.hpp"
 #include "assets/Bundle.hpp"
 #include "assets/Cache.hpp"
+#include "assets/Handle.hpp"
 #include "assets/Loader.hpp"
 #include "assets/BmfLoader.hpp"
 #include "assets/ColladaLoader.hpp"
@@ -95,6 +95,7 @@ namespace ouzel
             if (i != children.end())
             {
                 std::rotate(children.begin(), i, i + 1);
+                if (layer) layer->visitOrderDirty = true;
 
                 return true;
             }
@@ -109,6 +110,7 @@ namespace ouzel
             if (i != children.end())
             {
                 std::rotate(i, i + 1, children.end());
+                if (layer) layer->visitOrderDirty = true;
 
                 return true;
             }
@@ -122,6 +124,7 @@ namespace ouzel
             {
                 if (entered) actor->leave();
                 actor->parent = nullptr;
+                actor->setLayer(nullptr);
             }
 
             children.clear();
@@ -243,56 +246,100 @@ namespace ouzel
         Actor::~Actor()
         {
             if (parent) parent->removeChild(this);
+            if (layer) setLayer(nullptr);
 
             for (const auto& component : components)
                 component->setActor(nullptr);
         }
 
-        void Actor::visit(std::vector<Actor*>& drawQueue,
-                          const Matrix4F& newParentTransform,
-                          bool parentTransformDirty,
-                          Camera* camera,
-                          Order parentOrder,
-                          bool parentHidden)
+        void Actor::markSpatialIndexDirty()
+        {
+            if (!layer || spatialIndexDirty) return;
+
+            spatialIndexDirty = true;
+            layer->dirtyActors.push_back(this);
+        }
+
+        void Actor::updateSpatialIndex(const Matrix4F& newParentTransform,
+                                       bool parentTransformDirty,
+                                       Order parentOrder,
+                                       bool parentHidden)
         {
             worldOrder = parentOrder + order;
             worldHidden = parentHidden || hidden;
 
+            // the actor is indexed below, so the transform update must not queue it again
+            spatialIndexDirty = true;
+
             if (parentTransformDirty) updateTransform(newParentTransform);
             if (transformDirty) calculateTransform();
 
-            if (!worldHidden)
-            {
-                const Box3F boundingBox = getBoundingBox();
+            const Box3F boundingBox = getBoundingBox();
+            Box2F worldBoundingBox;
 
-                if (cullDisabled || (!boundingBox.isEmpty() && camera->checkVisibility(getTransform(), boundingBox)))
+            if (!boundingBox.isEmpty())
+                for (uint32_t corner = 0; corner < 8; ++corner)
                 {
-                    auto upperBound = std::upper_bound(drawQueue.begin(), drawQueue.end(), this,
-                                                       [](Actor* a, Actor* b) noexcept {
-                                                           return a->worldOrder > b->worldOrder;
-                                                       });
-
-                    drawQueue.insert(upperBound, this);
+                    auto point = Vector3F{(corner & 1) ? boundingBox.max.v[0] : boundingBox.min.v[0],
+                                          (corner & 2) ? boundingBox.max.v[1] : boundingBox.min.v[1],
+                                          (corner & 4) ? boundingBox.max.v[2] : boundingBox.min.v[2]};
+                    transform.transformPoint(point);
+                    worldBoundingBox.insertPoint(Vector2F(point));
                 }
-            }
+
+            layer->spatialIndex.updateActor(this, worldBoundingBox);
+            spatialIndexDirty = false;
 
             for (Actor* actor : children)
-                actor->visit(drawQueue, transform, updateChildrenTransform, camera, worldOrder, worldHidden);
+                actor->updateSpatialIndex(transform, updateChildrenTransform, worldOrder, worldHidden);
 
             updateChildrenTransform = false;
         }
 
+        void Actor::updateVisitOrder(uint32_t& nextVisitOrder)
+        {
+            visitOrder = nextVisitOrder++;
+
+            for (Actor* actor : children)
+                actor->updateVisitOrder(nextVisitOrder);
+        }
+
         void Actor::draw(Camera* camera, bool wireframe)
         {
             if (transformDirty)
                 calculateTransform();
 
+            SpriteBatch* spriteBatch = layer ? &layer->getSpriteBatch() : nullptr;
+            InstanceBatch* instanceBatch = layer ? &layer->getInstanceBatch() : nullptr;
+
             for (Component* component : components)
                 if (!component->isHidden())
+                {
+                    if (spriteBatch && instanceBatch)
+                    {
+                        // only one of the batches has pending draws at a time, so the draw order is kept
+                        if (component->batch(*spriteBatch, transform, opacity))
+                        {
+                            instanceBatch->flush();
+                            continue;
+                        }
+
+                        if (component->batchInstance(*instanceBatch, transform, opacity))
+                        {
+                            spriteBatch->flush();
+                            continue;
+                        }
+
+                        // keep the draw order of the components that are not batched
+                        spriteBatch->flush();
+                        instanceBatch->flush();
+                    }
+
                     component->draw(transform,
                                     opacity,
                                     camera->getRenderViewProjection(),
                                     wireframe);
+                }
         }
 
         void Actor::addChild(Actor* actor)
@@ -378,9 +425,34 @@ namespace ouzel
             updateLocalTransform();
         }
 
+        void Actor::setOrder(Order newOrder)
+        {
+            order = newOrder;
+
+            markSpatialIndexDirty();
+        }
+
+        void Actor::setCullDisabled(bool newCullDisabled)
+        {
+            if (layer && newCullDisabled != cullDisabled)
+            {
+                if (newCullDisabled)
+                    layer->unculledActors.push_back(this);
+                else
+                {
+                    auto i = std::find(layer->unculledActors.begin(), layer->unculledActors.end(), this);
+                    if (i != layer->unculledActors.end()) layer->unculledActors.erase(i);
+                }
+            }
+
+            cullDisabled = newCullDisabled;
+        }
+
         void Actor::setHidden(bool newHidden)
         {
             hidden = newHidden;
+
+            markSpatialIndexDirty();
         }
 
         bool Actor::pointOn(const Vector2F& worldPosition) const
@@ -423,6 +495,7 @@ namespace ouzel
         void Actor::updateLocalTransform()
         {
             localTransformDirty = transformDirty = inverseTransformDirty = true;
+            markSpatialIndexDirty();
             for (Component* component : components)
                 component->updateTransform();
         }
@@ -431,6 +504,7 @@ namespace ouzel
         {
             parentTransform = newParentTransform;
             transformDirty = inverseTransformDirty = true;
+            markSpatialIndexDirty();
             for (Component* component : components)
                 component->updateTransform();
         }
@@ -519,6 +593,8 @@ namespace ouzel
 
             component->setActor(this);
             components.push_back(component);
+
+            markSpatialIndexDirty();
         }
 
         bool Actor::removeComponent(Component* component)
@@ -531,6 +607,7 @@ namespace ouzel
             {
                 component->setActor(nullptr);
                 components.erase(componentIterator);
+                markSpatialIndexDirty();
                 result = true;
             }
 
@@ -550,12 +627,46 @@ namespace ouzel
 
             components.clear();
             ownedComponents.clear();
+
+            markSpatialIndexDirty();
         }
 
         void Actor::setLayer(Layer* newLayer)
         {
+            const bool layerChanged = (layer != newLayer);
+
+            if (layer && layerChanged)
+            {
+                layer->spatialIndex.removeActor(this);
+
+                if (spatialIndexDirty)
+                {
+                    auto i = std::find(layer->dirtyActors.begin(), layer->dirtyActors.end(), this);
+                    if (i != layer->dirtyActors.end())
+                    {
+                        *i = layer->dirtyActors.back();
+                        layer->dirtyActors.pop_back();
+                    }
+
+                    spatialIndexDirty = false;
+                }
+
+                if (cullDisabled)
+                {
+                    auto i = std::find(layer->unculledActors.begin(), layer->unculledActors.end(), this);
+                    if (i != layer->unculledActors.end()) layer->unculledActors.erase(i);
+                }
+            }
+
             ActorContainer::setLayer(newLayer);
 
+            if (layer && layerChanged)
+            {
+                markSpatialIndexDirty();
+                if (cullDisabled) layer->unculledActors.push_back(this);
+                layer->visitOrderDirty = true;
+            }
+
             for (Component* component : components)
                 component->setLayer(newLayer);
         }
@@ -46,8 +46,8 @@ namespace ouzel
 
             inline auto getLayer() const noexcept { return layer; }
 
-            std::vector<std::pair<Actor*, Vector3F>> findActors(const Vector2F& position) const;
-            std::vector<Actor*> findActors(const std::vector<Vector2F>& edges) const;
+            virtual std::vector<std::pair<Actor*, Vector3F>> findActors(const Vector2F& position) const;
+            virtual std::vector<Actor*> findActors(const std::vector<Vector2F>& edges) const;
 
         protected:
             virtual void setLayer(Layer* newLayer);
@@ -65,6 +65,7 @@ namespace ouzel
         class Actor: public ActorContainer
         {
             friend ActorContainer;
+            friend Component;
             friend Layer;
         public:
             using Order = int32_t;
@@ -72,12 +73,6 @@ namespace ouzel
             Actor() = default;
             ~Actor() override;
 
-            virtual void visit(std::vector<Actor*>& drawQueue,
-                               const Matrix4F& newParentTransform,
-                               bool parentTransformDirty,
-                               Camera* camera,
-                               Order parentOrder,
-                               bool parentHidden);
             virtual void draw(Camera* camera, bool wireframe);
 
             virtual const Vector3F& getPosition() const noexcept { return position; }
@@ -85,7 +80,7 @@ namespace ouzel
             virtual void setPosition(const Vector3F& newPosition);
 
             inline auto getOrder() const noexcept { return order; }
-            inline void setOrder(Order newOrder) { order = newOrder; }
+            void setOrder(Order newOrder);
 
             virtual const QuaternionF& getRotation() const noexcept { return rotation; }
             virtual void setRotation(const QuaternionF& newRotation);
@@ -109,7 +104,7 @@ namespace ouzel
             virtual void setPickable(bool newPickable) { pickable = newPickable; }
 
             virtual bool isCullDisabled() const noexcept { return cullDisabled; }
-            virtual void setCullDisabled(bool newCullDisabled) { cullDisabled = newCullDisabled; }
+            virtual void setCullDisabled(bool newCullDisabled);
 
             virtual bool isHidden() const noexcept { return hidden; }
             virtual void setHidden(bool newHidden);
@@ -165,6 +160,16 @@ namespace ouzel
             void updateLocalTransform();
             void updateTransform(const Matrix4F& newParentTransform);
 
+            // queues the actor to be indexed by the layer before the next draw or pick
+            void markSpatialIndexDirty();
+
+            // updates the world state and the spatial index entries of the actor and its children
+            void updateSpatialIndex(const Matrix4F& newParentTransform,
+                                    bool parentTransformDirty,
+                                    Order parentOrder,
+                                    bool parentHidden);
+            void updateVisitOrder(uint32_t& nextVisitOrder);
+
             virtual void calculateLocalTransform() const;
             virtual void calculateTransform() const;
 
@@ -179,6 +184,7 @@ namespace ouzel
             mutable bool inverseTransformDirty = true;
             mutable bool localTransformDirty = true;
             mutable bool updateChildrenTransform = true;
+            bool spatialIndexDirty = false; // the actor is in the dirty actor list of the layer
 
             bool flipX = false;
             bool flipY = false;
@@ -194,6 +200,7 @@ namespace ouzel
             float opacity = 1.0F;
             Order order = 0;
             Order worldOrder = 0;
+            uint32_t visitOrder = 0;
 
             ActorContainer* parent = nullptr;
 
@@ -20,6 +20,20 @@ namespace ouzel
         {
         }
 
+        bool Component::batch(SpriteBatch&,
+                              const Matrix4F&,
+                              float)
+        {
+            return false;
+        }
+
+        bool Component::batchInstance(InstanceBatch&,
+                                      const Matrix4F&,
+                                      float)
+        {
+            return false;
+        }
+
         bool Component::pointOn(const Vector2F& position) const
         {
             return boundingBox.containsPoint(Vector3F(position));
@@ -107,5 +121,10 @@ namespace ouzel
         void Component::updateTransform()
         {
         }
+
+        void Component::invalidateBoundingBox()
+        {
+            if (actor) actor->markSpatialIndexDirty();
+        }
     } // namespace scene
 } // namespace ouzel
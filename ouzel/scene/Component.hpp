@@ -16,7 +16,9 @@ namespace ouzel
     namespace scene
     {
         class Actor;
+        class InstanceBatch;
         class Layer;
+        class SpriteBatch;
 
         class Component
         {
@@ -35,15 +37,23 @@ namespace ouzel
                               float opacity,
                               const Matrix4F& renderViewProjection,
                               bool wireframe);
+            // returns false if the component can not be drawn as a part of a sprite batch
+            virtual bool batch(SpriteBatch& spriteBatch,
+                               const Matrix4F& transformMatrix,
+                               float opacity);
+            // returns false if the component can not be drawn as an instance of an instanced draw call
+            virtual bool batchInstance(InstanceBatch& instanceBatch,
+                                       const Matrix4F& transformMatrix,
+                                       float opacity);
 
             virtual const Box3F& getBoundingBox() const noexcept { return boundingBox; }
-            virtual void setBoundingBox(const Box3F& newBoundingBox) { boundingBox = newBoundingBox; }
+            virtual void setBoundingBox(const Box3F& newBoundingBox) { boundingBox = newBoundingBox; invalidateBoundingBox(); }
 
             virtual bool pointOn(const Vector2F& position) const;
             virtual bool shapeOverlaps(const std::vector<Vector2F>& edges) const;
 
             inline auto isHidden() const noexcept { return hidden; }
-            inline void setHidden(bool newHidden) { hidden = newHidden; }
+            inline void setHidden(bool newHidden) { hidden = newHidden; invalidateBoundingBox(); }
 
             inline auto getActor() const noexcept { return actor; }
             void removeFromActor();
@@ -52,6 +62,8 @@ namespace ouzel
             virtual void setActor(Actor* newActor);
             virtual void setLayer(Layer* newLayer);
             virtual void updateTransform();
+            // must be called after the bounding box changes, so that the actor is indexed again
+            void invalidateBoundingBox();
 
             Box3F boundingBox;
             bool hidden = false;
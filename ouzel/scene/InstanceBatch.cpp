@@ -0,0 +1,84 @@
+// Copyright 2015-2019 Elviss Strazdins. All rights reserved.
+
+#include <algorithm>
+#include "InstanceBatch.hpp"
+#include "core/Engine.hpp"
+#include "graphics/Renderer.hpp"
+
+namespace ouzel
+{
+    namespace scene
+    {
+        void InstanceBatch::begin(const Matrix4F& newRenderViewProjection, bool newWireframe)
+        {
+            flush();
+
+            renderViewProjection = newRenderViewProjection;
+            wireframe = newWireframe;
+        }
+
+        void InstanceBatch::end()
+        {
+            flush();
+        }
+
+        void InstanceBatch::draw(uintptr_t newBlendState,
+                                 uintptr_t newShader,
+                                 graphics::CullMode newCullMode,
+                                 const std::array<uintptr_t, graphics::SetTexturesCommand::MAX_TEXTURES>& newTextures,
+                                 uintptr_t newIndexBuffer,
+                                 uint32_t newIndexCount,
+                                 uint32_t newIndexSize,
+                                 uintptr_t newVertexBuffer,
+                                 const Matrix4F& transformMatrix,
+                                 const float color[4])
+        {
+            if (!instances.empty() &&
+                (blendState != newBlendState ||
+                 shader != newShader ||
+                 cullMode != newCullMode ||
+                 textures != newTextures ||
+                 indexBuffer != newIndexBuffer ||
+                 indexCount != newIndexCount ||
+                 indexSize != newIndexSize ||
+                 vertexBuffer != newVertexBuffer))
+                flush();
+
+            blendState = newBlendState;
+            shader = newShader;
+            cullMode = newCullMode;
+            textures = newTextures;
+            indexBuffer = newIndexBuffer;
+            indexCount = newIndexCount;
+            indexSize = newIndexSize;
+            vertexBuffer = newVertexBuffer;
+
+            const Matrix4F modelViewProj = renderViewProjection * transformMatrix;
+
+            graphics::Instance instance;
+            std::copy(std::begin(modelViewProj.m), std::end(modelViewProj.m), instance.modelViewProjection);
+            std::copy(color, color + 4, instance.color);
+            instances.push_back(instance);
+        }
+
+        void InstanceBatch::flush()
+        {
+            if (instances.empty()) return;
+
+            engine->getRenderer()->setPipelineState(blendState,
+                                                    shader,
+                                                    cullMode,
+                                                    wireframe ? graphics::FillMode::Wireframe : graphics::FillMode::Solid);
+            engine->getRenderer()->setTextures(textures);
+            engine->getRenderer()->drawInstanced(indexBuffer,
+                                                 indexCount,
+                                                 indexSize,
+                                                 vertexBuffer,
+                                                 graphics::DrawMode::TriangleList,
+                                                 0,
+                                                 instances);
+
+            instances.clear();
+        }
+    } // namespace scene
+} // namespace ouzel
@@ -0,0 +1,57 @@
+// Copyright 2015-2019 Elviss Strazdins. All rights reserved.
+
+#ifndef OUZEL_SCENE_INSTANCEBATCH_HPP
+#define OUZEL_SCENE_INSTANCEBATCH_HPP
+
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "math/Matrix.hpp"
+#include "graphics/Commands.hpp"
+#include "graphics/RasterizerState.hpp"
+
+namespace ouzel
+{
+    namespace scene
+    {
+        // Merges consecutive draws of the same mesh with the same pipeline state and textures
+        // into one instanced draw call, every instance keeps its own transformation and color
+        class InstanceBatch final
+        {
+        public:
+            void begin(const Matrix4F& newRenderViewProjection, bool newWireframe);
+            void end();
+
+            void draw(uintptr_t blendState,
+                      uintptr_t shader,
+                      graphics::CullMode cullMode,
+                      const std::array<uintptr_t, graphics::SetTexturesCommand::MAX_TEXTURES>& textures,
+                      uintptr_t indexBuffer,
+                      uint32_t indexCount,
+                      uint32_t indexSize,
+                      uintptr_t vertexBuffer,
+                      const Matrix4F& transformMatrix,
+                      const float color[4]);
+
+            // issues the draw call for the collected instances
+            void flush();
+
+        private:
+            Matrix4F renderViewProjection = Matrix4F::identity();
+            bool wireframe = false;
+
+            uintptr_t blendState = 0;
+            uintptr_t shader = 0;
+            graphics::CullMode cullMode = graphics::CullMode::NoCull;
+            std::array<uintptr_t, graphics::SetTexturesCommand::MAX_TEXTURES> textures{};
+            uintptr_t indexBuffer = 0;
+            uint32_t indexCount = 0;
+            uint32_t indexSize = 0;
+            uintptr_t vertexBuffer = 0;
+
+            std::vector<graphics::Instance> instances;
+        };
+    } // namespace scene
+} // namespace ouzel
+
+#endif // OUZEL_SCENE_INSTANCEBATCH_HPP
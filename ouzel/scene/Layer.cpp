@@ -2,6 +2,7 @@
 
 #include <cassert>
 #include <algorithm>
+#include <limits>
 #include "Layer.hpp"
 #include "core/Engine.hpp"
 #include "Actor.hpp"
@@ -23,24 +24,76 @@ namespace ouzel
         Layer::~Layer()
         {
             if (scene) scene->removeLayer(this);
+
+            // detach the actors while the spatial index still exists
+            for (Actor* actor : children)
+                actor->setLayer(nullptr);
         }
 
         void Layer::draw()
         {
+            updateSpatialIndex();
+
             for (Camera* camera : cameras)
             {
-                std::vector<Actor*> drawQueue;
+                drawQueue.clear();
 
-                for (Actor* actor : children)
-                    actor->visit(drawQueue, Matrix4F::identity(), false, camera, 0, false);
+                // the view volume of the camera projected on the XY plane
+                Box2F visibleArea;
+                for (uint32_t corner = 0; corner < 8; ++corner)
+                {
+                    const Vector4F clipPosition{(corner & 1) ? 1.0F : -1.0F,
+                                                (corner & 2) ? 1.0F : -1.0F,
+                                                (corner & 4) ? 1.0F : -1.0F,
+                                                1.0F};
+                    Vector4F worldPosition;
+                    camera->getInverseViewProjection().transformVector(clipPosition, worldPosition);
+
+                    // the view volume is not bounded (e.g. infinite far plane)
+                    if (worldPosition.v[3] <= std::numeric_limits<float>::epsilon())
+                    {
+                        visibleArea = Box2F(Vector2F{std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest()},
+                                            Vector2F{std::numeric_limits<float>::max(), std::numeric_limits<float>::max()});
+                        break;
+                    }
+
+                    visibleArea.insertPoint(Vector2F{worldPosition.v[0] / worldPosition.v[3],
+                                                     worldPosition.v[1] / worldPosition.v[3]});
+                }
+
+                candidates.clear();
+                spatialIndex.query(visibleArea, candidates);
+
+                for (Actor* actor : candidates)
+                    if (!actor->worldHidden && !actor->cullDisabled &&
+                        camera->checkVisibility(actor->getTransform(), actor->getBoundingBox()))
+                        drawQueue.push_back(actor);
+
+                for (Actor* actor : unculledActors)
+                    if (!actor->worldHidden)
+                        drawQueue.push_back(actor);
+
+                // actors with a higher order are drawn first, actors with the same order are drawn in the visit order
+                std::sort(drawQueue.begin(), drawQueue.end(),
+                          [](const Actor* a, const Actor* b) noexcept {
+                              return a->worldOrder == b->worldOrder ?
+                                  a->visitOrder < b->visitOrder :
+                                  a->worldOrder > b->worldOrder;
+                          });
 
                 engine->getRenderer()->setRenderTarget(camera->getRenderTarget() ? camera->getRenderTarget()->getResource() : 0);
                 engine->getRenderer()->setViewport(camera->getRenderViewport());
                 engine->getRenderer()->setDepthStencilState(camera->getDepthStencilState() ? camera->getDepthStencilState()->getResource() : 0,
                                                             camera->getStencilReferenceValue());
 
+                spriteBatch.begin(camera->getRenderViewProjection(), camera->getWireframe());
+                instanceBatch.begin(camera->getRenderViewProjection(), camera->getWireframe());
+
                 for (Actor* actor : drawQueue)
                     actor->draw(camera, camera->getWireframe());
+
+                spriteBatch.end();
+                instanceBatch.end();
             }
         }
 
@@ -144,6 +197,57 @@ namespace ouzel
             return result;
         }
 
+        std::vector<std::pair<Actor*, Vector3F>> Layer::findActors(const Vector2F& position) const
+        {
+            std::vector<std::pair<Actor*, Vector3F>> actors;
+
+            updateSpatialIndex();
+
+            candidates.clear();
+            spatialIndex.query(position, candidates);
+
+            // the topmost actor (drawn last) comes first
+            std::sort(candidates.begin(), candidates.end(),
+                      [](const Actor* a, const Actor* b) noexcept {
+                          return a->worldOrder == b->worldOrder ?
+                              a->visitOrder > b->visitOrder :
+                              a->worldOrder < b->worldOrder;
+                      });
+
+            for (Actor* actor : candidates)
+                if (!actor->isWorldHidden() && actor->isPickable() && actor->pointOn(position))
+                    actors.emplace_back(actor, actor->convertWorldToLocal(Vector3F(position)));
+
+            return actors;
+        }
+
+        std::vector<Actor*> Layer::findActors(const std::vector<Vector2F>& edges) const
+        {
+            std::vector<Actor*> actors;
+
+            Box2F area;
+            for (const Vector2F& edge : edges)
+                area.insertPoint(edge);
+
+            updateSpatialIndex();
+
+            candidates.clear();
+            spatialIndex.query(area, candidates);
+
+            std::sort(candidates.begin(), candidates.end(),
+                      [](const Actor* a, const Actor* b) noexcept {
+                          return a->worldOrder == b->worldOrder ?
+                              a->visitOrder > b->visitOrder :
+                              a->worldOrder < b->worldOrder;
+                      });
+
+            for (Actor* actor : candidates)
+                if (!actor->isWorldHidden() && actor->isPickable() && actor->shapeOverlaps(edges))
+                    actors.push_back(actor);
+
+            return actors;
+        }
+
         void Layer::setOrder(int32_t newOrder)
         {
             order = newOrder;
@@ -162,6 +266,53 @@ namespace ouzel
             recalculateProjection();
         }
 
+        void Layer::updateSpatialIndex() const
+        {
+            if (visitOrderDirty)
+            {
+                uint32_t nextVisitOrder = 0;
+                for (Actor* actor : children)
+                    actor->updateVisitOrder(nextVisitOrder);
+
+                visitOrderDirty = false;
+            }
+
+            for (size_t i = 0; i < dirtyActors.size(); ++i)
+            {
+                Actor* actor = dirtyActors[i];
+
+                // the actor was already indexed together with its dirty ancestor
+                if (!actor->spatialIndexDirty) continue;
+
+                bool ancestorDirty = false;
+                for (const ActorContainer* ancestor = actor->parent; ancestor != this;)
+                {
+                    const auto ancestorActor = static_cast<const Actor*>(ancestor);
+                    if (ancestorActor->spatialIndexDirty)
+                    {
+                        ancestorDirty = true;
+                        break;
+                    }
+
+                    ancestor = ancestorActor->parent;
+                }
+
+                // the subtree of the actor is updated when the dirty ancestor is
+                if (ancestorDirty) continue;
+
+                if (actor->parent == this)
+                    actor->updateSpatialIndex(Matrix4F::identity(), false, 0, false);
+                else
+                {
+                    const auto parentActor = static_cast<const Actor*>(actor->parent);
+                    actor->updateSpatialIndex(parentActor->getTransform(), false,
+                                              parentActor->worldOrder, parentActor->worldHidden);
+                }
+            }
+
+            dirtyActors.clear();
+        }
+
         void Layer::removeFromScene()
         {
             if (scene) scene->removeLayer(this);
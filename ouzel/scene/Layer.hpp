@@ -6,6 +6,9 @@
 #include <cstdint>
 #include <vector>
 #include "scene/Actor.hpp"
+#include "scene/InstanceBatch.hpp"
+#include "scene/SpatialIndex.hpp"
+#include "scene/SpriteBatch.hpp"
 #include "math/Vector.hpp"
 
 namespace ouzel
@@ -18,6 +21,8 @@ namespace ouzel
 
         class Layer: public ActorContainer
         {
+            friend ActorContainer;
+            friend Actor;
             friend Scene;
             friend Camera;
             friend Light;
@@ -32,11 +37,16 @@ namespace ouzel
             void addChild(Actor* actor) override;
 
             inline auto& getCameras() const noexcept { return cameras; }
+            inline auto& getSpriteBatch() noexcept { return spriteBatch; }
+            inline auto& getInstanceBatch() noexcept { return instanceBatch; }
 
             std::pair<Actor*, Vector3F> pickActor(const Vector2F& position, bool renderTargets = false) const;
             std::vector<std::pair<Actor*, Vector3F>> pickActors(const Vector2F& position, bool renderTargets = false) const;
             std::vector<Actor*> pickActors(const std::vector<Vector2F>& edges, bool renderTargets = false) const;
 
+            std::vector<std::pair<Actor*, Vector3F>> findActors(const Vector2F& position) const override;
+            std::vector<Actor*> findActors(const std::vector<Vector2F>& edges) const override;
+
             inline auto getOrder() const noexcept { return order; }
             void setOrder(Order newOrder);
 
@@ -53,11 +63,24 @@ namespace ouzel
             virtual void recalculateProjection();
             void enter() override;
 
+            // indexes only the actors changed since the last draw or pick
+            void updateSpatialIndex() const;
+
             Scene* scene = nullptr;
 
             std::vector<Camera*> cameras;
             std::vector<Light*> lights;
 
+            SpriteBatch spriteBatch;
+            InstanceBatch instanceBatch;
+            std::vector<Actor*> drawQueue;
+
+            SpatialIndex spatialIndex;
+            mutable std::vector<Actor*> dirtyActors; // actors moved, hidden or added since the index was updated
+            std::vector<Actor*> unculledActors; // actors with culling disabled are drawn by every camera
+            mutable bool visitOrderDirty = false; // actors were added or reordered since the visit order was updated
+            mutable std::vector<Actor*> candidates;
+
             Order order = 0;
         };
     } // namespace scene
@@ -69,25 +69,24 @@ namespace ouzel
 
                 const float colorVector[] = {1.0F, 1.0F, 1.0F, opacity};
 
-                std::vector<std::vector<float>> pixelShaderConstants(1);
-                pixelShaderConstants[0] = {std::begin(colorVector), std::end(colorVector)};
-
-                std::vector<std::vector<float>> vertexShaderConstants(1);
-                vertexShaderConstants[0] = {std::begin(transform.m), std::end(transform.m)};
-
                 engine->getRenderer()->setPipelineState(blendState->getResource(),
                                                         shader->getResource(),
                                                         graphics::CullMode::NoCull,
                                                         wireframe ? graphics::FillMode::Wireframe : graphics::FillMode::Solid);
-                engine->getRenderer()->setShaderConstants(pixelShaderConstants,
-                                                          vertexShaderConstants);
+                engine->getRenderer()->setShaderConstants({colorVector},
+                                                          {transform.m});
                 engine->getRenderer()->setTextures({wireframe ? whitePixelTexture->getResource() : texture->getResource()});
-                engine->getRenderer()->draw(indexBuffer->getResource(),
+
+                // only the quads of the live particles are copied to the transient buffers of the frame
+                const auto geometry = engine->getRenderer()->allocateTransientGeometry(Span<const uint16_t>(indices.data(), particleCount * 6),
+                                                                                       Span<const graphics::Vertex>(vertices.data(), particleCount * 4));
+
+                engine->getRenderer()->draw(geometry.indexBuffer,
                                             particleCount * 6,
                                             sizeof(uint16_t),
-                                            vertexBuffer->getResource(),
+                                            geometry.vertexBuffer,
                                             graphics::DrawMode::TriangleList,
-                                            0);
+                                            geometry.startIndex);
             }
         }
 
@@ -236,6 +235,8 @@ namespace ouzel
                     for (uint32_t i = 0; i < particleCount; ++i)
                         boundingBox.insertPoint(Vector3F(particles[i].position));
                 }
+
+                invalidateBoundingBox();
             }
         }
 
@@ -313,17 +314,6 @@ namespace ouzel
                                       Vector2F{1.0F, 0.0F}, Vector3F{0.0F, 0.0F, -1.0F});
             }
 
-            indexBuffer = std::make_unique<graphics::Buffer>(*engine->getRenderer(),
-                                                             graphics::BufferType::Index, 0,
-                                                             indices.data(),
-                                                             static_cast<uint32_t>(getVectorSize(indices)));
-
-            vertexBuffer = std::make_unique<graphics::Buffer>(*engine->getRenderer(),
-                                                              graphics::BufferType::Vertex,
-                                                              graphics::Flags::Dynamic,
-                                                              vertices.data(),
-                                                              static_cast<uint32_t>(getVectorSize(vertices)));
-
             particles.resize(particleSystemData.maxParticles);
         }
 
@@ -373,8 +363,6 @@ namespace ouzel
                     vertices[i * 4 + 3].position = Vector3F(c + position);
                     vertices[i * 4 + 3].color = color;
                 }
-
-                vertexBuffer->setData(vertices.data(), static_cast<uint32_t>(getVectorSize(vertices)));
             }
         }
 
@@ -12,7 +12,6 @@
 #include "events/EventHandler.hpp"
 #include "graphics/Vertex.hpp"
 #include "graphics/BlendState.hpp"
-#include "graphics/Buffer.hpp"
 #include "graphics/Shader.hpp"
 #include "graphics/Texture.hpp"
 
@@ -196,9 +195,6 @@ namespace ouzel
 
             std::vector<Particle> particles;
 
-            std::unique_ptr<graphics::Buffer> indexBuffer;
-            std::unique_ptr<graphics::Buffer> vertexBuffer;
-
             std::vector<uint16_t> indices;
             std::vector<graphics::Vertex> vertices;
 
@@ -34,36 +34,56 @@ namespace ouzel
                             renderViewProjection,
                             wireframe);
 
-            if (dirty)
+            uintptr_t drawIndexBuffer = indexBuffer.getResource();
+            uintptr_t drawVertexBuffer = vertexBuffer.getResource();
+            uint32_t startIndex = 0;
+
+            // shapes that changed since the last draw are drawn from the transient buffers of the frame,
+            // they are uploaded to the buffers of the renderer only once they stop changing
+            if (dirty && !indices.empty() && !vertices.empty())
+            {
+                const auto geometry = engine->getRenderer()->allocateTransientGeometry(indices, vertices);
+                drawIndexBuffer = geometry.indexBuffer;
+                drawVertexBuffer = geometry.vertexBuffer;
+                startIndex = geometry.startIndex;
+
+                dirty = false;
+                buffersDirty = true;
+            }
+            else if (dirty || buffersDirty)
             {
                 if (!indices.empty()) indexBuffer.setData(indices.data(), static_cast<uint32_t>(getVectorSize(indices)));
                 if (!vertices.empty()) vertexBuffer.setData(vertices.data(), static_cast<uint32_t>(getVectorSize(vertices)));
                 dirty = false;
+                buffersDirty = false;
             }
 
             const Matrix4F modelViewProj = renderViewProjection * transformMatrix;
             const float colorVector[] = {1.0F, 1.0F, 1.0F, opacity};
 
-            for (const DrawCommand& drawCommand : drawCommands)
+            if (drawCommands.empty()) return;
+
+            engine->getRenderer()->setPipelineState(blendState->getResource(),
+                                                    shader->getResource(),
+                                                    graphics::CullMode::NoCull,
+                                                    wireframe ? graphics::FillMode::Wireframe : graphics::FillMode::Solid);
+            engine->getRenderer()->setShaderConstants({colorVector},
+                                                      {modelViewProj.m});
+
+            // consecutive shapes with the same draw mode are drawn with one multi-draw command
+            for (auto i = drawCommands.begin(); i != drawCommands.end();)
             {
-                std::vector<std::vector<float>> fragmentShaderConstants(1);
-                fragmentShaderConstants[0] = {std::begin(colorVector), std::end(colorVector)};
-
-                std::vector<std::vector<float>> vertexShaderConstants(1);
-                vertexShaderConstants[0] = {std::begin(modelViewProj.m), std::end(modelViewProj.m)};
-
-                engine->getRenderer()->setPipelineState(blendState->getResource(),
-                                                        shader->getResource(),
-                                                        graphics::CullMode::NoCull,
-                                                        wireframe ? graphics::FillMode::Wireframe : graphics::FillMode::Solid);
-                engine->getRenderer()->setShaderConstants(fragmentShaderConstants,
-                                                          vertexShaderConstants);
-                engine->getRenderer()->draw(indexBuffer.getResource(),
-                                            drawCommand.indexCount,
-                                            sizeof(uint16_t),
-                                            vertexBuffer.getResource(),
-                                            drawCommand.mode,
-                                            drawCommand.startIndex);
+                const graphics::DrawMode mode = i->mode;
+
+                drawRanges.clear();
+                for (; i != drawCommands.end() && i->mode == mode; ++i)
+                    drawRanges.push_back({i->indexCount, startIndex + i->startIndex});
+
+                engine->getRenderer()->multiDraw(drawIndexBuffer,
+                                                 sizeof(uint16_t),
+                                                 drawVertexBuffer,
+                                                 mode,
+                                                 drawRanges);
             }
         }
 
@@ -76,6 +96,7 @@ namespace ouzel
             vertices.clear();
 
             dirty = true;
+            invalidateBoundingBox();
         }
 
         void ShapeRenderer::line(const Vector2F& start, const Vector2F& finish, Color color, float thickness)
@@ -139,6 +160,7 @@ namespace ouzel
             drawCommands.push_back(command);
 
             dirty = true;
+            invalidateBoundingBox();
         }
 
         void ShapeRenderer::circle(const Vector2F& position,
@@ -251,6 +273,7 @@ namespace ouzel
             drawCommands.push_back(command);
 
             dirty = true;
+            invalidateBoundingBox();
         }
 
         void ShapeRenderer::rectangle(const RectF& rectangle,
@@ -398,6 +421,7 @@ namespace ouzel
             drawCommands.push_back(command);
 
             dirty = true;
+            invalidateBoundingBox();
         }
 
         void ShapeRenderer::polygon(const std::vector<Vector2F>& edges,
@@ -460,6 +484,7 @@ namespace ouzel
             drawCommands.push_back(command);
 
             dirty = true;
+            invalidateBoundingBox();
         }
 
         namespace
@@ -535,6 +560,7 @@ namespace ouzel
             drawCommands.push_back(command);
 
             dirty = true;
+            invalidateBoundingBox();
         }
     } // namespace scene
 } // namespace ouzel
@@ -80,10 +80,12 @@ namespace ouzel
             graphics::Buffer vertexBuffer;
 
             std::vector<DrawCommand> drawCommands;
+            std::vector<graphics::DrawRange> drawRanges;
 
             std::vector<uint16_t> indices;
             std::vector<graphics::Vertex> vertices;
             bool dirty = false;
+            bool buffersDirty = false;
         };
     } // namespace scene
 } // namespace ouzel
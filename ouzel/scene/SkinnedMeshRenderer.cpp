@@ -21,6 +21,8 @@ namespace ouzel
         {
             boundingBox = meshData.boundingBox;
             material = meshData.material;
+
+            invalidateBoundingBox();
         }
 
         void SkinnedMeshRenderer::draw(const Matrix4F& transformMatrix,
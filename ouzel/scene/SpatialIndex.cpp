@@ -0,0 +1,198 @@
+// Copyright 2015-2019 Elviss Strazdins. All rights reserved.
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include "SpatialIndex.hpp"
+
+namespace ouzel
+{
+    namespace scene
+    {
+        SpatialIndex::SpatialIndex(float initCellSize):
+            cellSize(initCellSize)
+        {
+            if (cellSize <= 0.0F)
+                throw std::runtime_error("Invalid cell size");
+        }
+
+        void SpatialIndex::updateActor(Actor* actor, const Box2F& boundingBox)
+        {
+            if (boundingBox.isEmpty())
+            {
+                removeActor(actor);
+                return;
+            }
+
+            const int32_t minX = getCellCoordinate(boundingBox.min.v[0]);
+            const int32_t minY = getCellCoordinate(boundingBox.min.v[1]);
+            const int32_t maxX = getCellCoordinate(boundingBox.max.v[0]);
+            const int32_t maxY = getCellCoordinate(boundingBox.max.v[1]);
+
+            auto i = entries.find(actor);
+
+            if (i == entries.end())
+            {
+                i = entries.insert(std::make_pair(actor, Entry{actor, boundingBox, minX, minY, maxX, maxY, false, 0})).first;
+                insertEntry(i->second);
+            }
+            else
+            {
+                Entry& entry = i->second;
+                entry.boundingBox = boundingBox;
+
+                // the actor stayed in the same cells
+                if (entry.minX == minX && entry.minY == minY &&
+                    entry.maxX == maxX && entry.maxY == maxY)
+                    return;
+
+                eraseEntry(entry);
+                entry.minX = minX;
+                entry.minY = minY;
+                entry.maxX = maxX;
+                entry.maxY = maxY;
+                insertEntry(entry);
+            }
+        }
+
+        void SpatialIndex::removeActor(const Actor* actor)
+        {
+            auto i = entries.find(actor);
+
+            if (i != entries.end())
+            {
+                eraseEntry(i->second);
+                entries.erase(i);
+            }
+        }
+
+        void SpatialIndex::clear()
+        {
+            entries.clear();
+            cells.clear();
+            largeEntries.clear();
+        }
+
+        void SpatialIndex::query(const Box2F& area, std::vector<Actor*>& result) const
+        {
+            if (area.isEmpty()) return;
+
+            if (++currentQueryStamp == 0)
+            {
+                for (const auto& i : entries)
+                    i.second.queryStamp = 0;
+
+                currentQueryStamp = 1;
+            }
+
+            for (const Entry* entry : largeEntries)
+                checkEntry(*entry, area, result);
+
+            const int32_t minX = getCellCoordinate(area.min.v[0]);
+            const int32_t minY = getCellCoordinate(area.min.v[1]);
+            const int32_t maxX = getCellCoordinate(area.max.v[0]);
+            const int32_t maxY = getCellCoordinate(area.max.v[1]);
+
+            const uint64_t cellCount = static_cast<uint64_t>(static_cast<int64_t>(maxX) - minX + 1) *
+                static_cast<uint64_t>(static_cast<int64_t>(maxY) - minY + 1);
+
+            // visit only the occupied cells if the area covers more cells than there are
+            if (cellCount > cells.size())
+            {
+                for (const auto& cell : cells)
+                    for (const Entry* entry : cell.second)
+                        checkEntry(*entry, area, result);
+            }
+            else
+            {
+                for (int32_t x = minX; x <= maxX; ++x)
+                    for (int32_t y = minY; y <= maxY; ++y)
+                    {
+                        auto cell = cells.find(getCellKey(x, y));
+
+                        if (cell != cells.end())
+                            for (const Entry* entry : cell->second)
+                                checkEntry(*entry, area, result);
+                    }
+            }
+        }
+
+        void SpatialIndex::query(const Vector2F& position, std::vector<Actor*>& result) const
+        {
+            query(Box2F(position, position), result);
+        }
+
+        int32_t SpatialIndex::getCellCoordinate(float value) const noexcept
+        {
+            // limit the coordinates, so that the cell count of an area always fits in 64 bits
+            constexpr float limit = 1073741824.0F;
+            const float coordinate = std::floor(value / cellSize);
+
+            if (coordinate < -limit) return -1073741824;
+            else if (coordinate > limit) return 1073741824;
+            else return static_cast<int32_t>(coordinate);
+        }
+
+        void SpatialIndex::insertEntry(Entry& entry)
+        {
+            const uint64_t cellCount = static_cast<uint64_t>(static_cast<int64_t>(entry.maxX) - entry.minX + 1) *
+                static_cast<uint64_t>(static_cast<int64_t>(entry.maxY) - entry.minY + 1);
+
+            entry.large = (cellCount > MAX_CELLS_PER_ENTRY);
+
+            if (entry.large)
+                largeEntries.push_back(&entry);
+            else
+            {
+                for (int32_t x = entry.minX; x <= entry.maxX; ++x)
+                    for (int32_t y = entry.minY; y <= entry.maxY; ++y)
+                        cells[getCellKey(x, y)].push_back(&entry);
+            }
+        }
+
+        void SpatialIndex::eraseEntry(const Entry& entry)
+        {
+            if (entry.large)
+            {
+                auto i = std::find(largeEntries.begin(), largeEntries.end(), &entry);
+
+                if (i != largeEntries.end())
+                {
+                    *i = largeEntries.back();
+                    largeEntries.pop_back();
+                }
+            }
+            else
+            {
+                for (int32_t x = entry.minX; x <= entry.maxX; ++x)
+                    for (int32_t y = entry.minY; y <= entry.maxY; ++y)
+                    {
+                        auto cell = cells.find(getCellKey(x, y));
+
+                        if (cell != cells.end())
+                        {
+                            std::vector<Entry*>& cellEntries = cell->second;
+                            auto i = std::find(cellEntries.begin(), cellEntries.end(), &entry);
+
+                            if (i != cellEntries.end())
+                            {
+                                *i = cellEntries.back();
+                                cellEntries.pop_back();
+                            }
+
+                            if (cellEntries.empty()) cells.erase(cell);
+                        }
+                    }
+            }
+        }
+
+        void SpatialIndex::checkEntry(const Entry& entry, const Box2F& area, std::vector<Actor*>& result) const
+        {
+            if (entry.queryStamp == currentQueryStamp) return;
+            entry.queryStamp = currentQueryStamp;
+
+            if (entry.boundingBox.intersects(area))
+                result.push_back(entry.actor);
+        }
+    } // namespace scene
+} // namespace ouzel
@@ -0,0 +1,74 @@
+// Copyright 2015-2019 Elviss Strazdins. All rights reserved.
+
+#ifndef OUZEL_SCENE_SPATIALINDEX_HPP
+#define OUZEL_SCENE_SPATIALINDEX_HPP
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "math/Box.hpp"
+
+namespace ouzel
+{
+    namespace scene
+    {
+        class Actor;
+
+        // Uniform grid over the world space bounding boxes of actors, entries are updated only when an actor moves
+        class SpatialIndex final
+        {
+        public:
+            static constexpr uint32_t MAX_CELLS_PER_ENTRY = 64;
+
+            explicit SpatialIndex(float initCellSize = 256.0F);
+
+            SpatialIndex(const SpatialIndex&) = delete;
+            SpatialIndex& operator=(const SpatialIndex&) = delete;
+
+            SpatialIndex(SpatialIndex&&) = delete;
+            SpatialIndex& operator=(SpatialIndex&&) = delete;
+
+            void updateActor(Actor* actor, const Box2F& boundingBox);
+            void removeActor(const Actor* actor);
+            void clear();
+
+            // appends actors whose bounding boxes overlap the area, every actor is reported once
+            void query(const Box2F& area, std::vector<Actor*>& result) const;
+            void query(const Vector2F& position, std::vector<Actor*>& result) const;
+
+            inline auto getCellSize() const noexcept { return cellSize; }
+            inline auto getActorCount() const noexcept { return entries.size(); }
+
+        private:
+            struct Entry final
+            {
+                Actor* actor;
+                Box2F boundingBox;
+                int32_t minX;
+                int32_t minY;
+                int32_t maxX;
+                int32_t maxY;
+                bool large;
+                mutable uint32_t queryStamp;
+            };
+
+            int32_t getCellCoordinate(float value) const noexcept;
+            static uint64_t getCellKey(int32_t x, int32_t y) noexcept
+            {
+                return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y);
+            }
+
+            void insertEntry(Entry& entry);
+            void eraseEntry(const Entry& entry);
+            void checkEntry(const Entry& entry, const Box2F& area, std::vector<Actor*>& result) const;
+
+            float cellSize;
+            std::unordered_map<const Actor*, Entry> entries;
+            std::unordered_map<uint64_t, std::vector<Entry*>> cells;
+            std::vector<Entry*> largeEntries; // entries that span too many cells
+            mutable uint32_t currentQueryStamp = 0;
+        };
+    } // namespace scene
+} // namespace ouzel
+
+#endif // OUZEL_SCENE_SPATIALINDEX_HPP
@@ -0,0 +1,90 @@
+// Copyright 2015-2019 Elviss Strazdins. All rights reserved.
+
+#include <algorithm>
+#include <limits>
+#include "SpriteBatch.hpp"
+#include "core/Engine.hpp"
+#include "graphics/Renderer.hpp"
+
+namespace ouzel
+{
+    namespace scene
+    {
+        void SpriteBatch::begin(const Matrix4F& newRenderViewProjection, bool newWireframe)
+        {
+            flush();
+
+            renderViewProjection = newRenderViewProjection;
+            wireframe = newWireframe;
+        }
+
+        void SpriteBatch::end()
+        {
+            flush();
+        }
+
+        void SpriteBatch::draw(uintptr_t blendState,
+                               uintptr_t shader,
+                               const std::array<uintptr_t, graphics::SetTexturesCommand::MAX_TEXTURES>& textures,
+                               const std::vector<uint16_t>& newIndices,
+                               const std::vector<graphics::Vertex>& newVertices,
+                               const Matrix4F& transformMatrix,
+                               const float color[4])
+        {
+            // the shared index buffer uses 16-bit indices
+            if (vertices.size() + newVertices.size() > std::numeric_limits<uint16_t>::max() + size_t(1))
+                flush();
+
+            // the color stays a shader constant, so that it keeps its precision and values above one
+            if (batches.empty() ||
+                batches.back().blendState != blendState ||
+                batches.back().shader != shader ||
+                batches.back().textures != textures ||
+                !std::equal(color, color + 4, batches.back().color))
+                batches.push_back({blendState, shader, textures,
+                                   {color[0], color[1], color[2], color[3]},
+                                   static_cast<uint32_t>(indices.size()), 0});
+
+            batches.back().indexCount += static_cast<uint32_t>(newIndices.size());
+
+            const auto baseVertex = static_cast<uint16_t>(vertices.size());
+            for (const uint16_t index : newIndices)
+                indices.push_back(static_cast<uint16_t>(baseVertex + index));
+
+            for (graphics::Vertex vertex : newVertices)
+            {
+                transformMatrix.transformPoint(vertex.position);
+                vertices.push_back(vertex);
+            }
+        }
+
+        void SpriteBatch::flush()
+        {
+            if (batches.empty()) return;
+
+            // the batches of all the layers share the transient buffers of the frame
+            const auto geometry = engine->getRenderer()->allocateTransientGeometry(indices, vertices);
+
+            for (const Batch& batch : batches)
+            {
+                engine->getRenderer()->setPipelineState(batch.blendState,
+                                                        batch.shader,
+                                                        graphics::CullMode::NoCull,
+                                                        wireframe ? graphics::FillMode::Wireframe : graphics::FillMode::Solid);
+                engine->getRenderer()->setShaderConstants({batch.color},
+                                                          {renderViewProjection.m});
+                engine->getRenderer()->setTextures(batch.textures);
+                engine->getRenderer()->draw(geometry.indexBuffer,
+                                            batch.indexCount,
+                                            sizeof(uint16_t),
+                                            geometry.vertexBuffer,
+                                            graphics::DrawMode::TriangleList,
+                                            geometry.startIndex + batch.startIndex);
+            }
+
+            batches.clear();
+            indices.clear();
+            vertices.clear();
+        }
+    } // namespace scene
+} // namespace ouzel
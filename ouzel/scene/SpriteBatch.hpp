@@ -0,0 +1,58 @@
+// Copyright 2015-2019 Elviss Strazdins. All rights reserved.
+
+#ifndef OUZEL_SCENE_SPRITEBATCH_HPP
+#define OUZEL_SCENE_SPRITEBATCH_HPP
+
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "math/Color.hpp"
+#include "math/Matrix.hpp"
+#include "graphics/Commands.hpp"
+#include "graphics/Vertex.hpp"
+
+namespace ouzel
+{
+    namespace scene
+    {
+        // Collects sprite geometry transformed on the CPU into shared buffers and merges
+        // consecutive sprites with the same pipeline state, textures and color into one draw call
+        class SpriteBatch final
+        {
+        public:
+            void begin(const Matrix4F& newRenderViewProjection, bool newWireframe);
+            void end();
+
+            void draw(uintptr_t blendState,
+                      uintptr_t shader,
+                      const std::array<uintptr_t, graphics::SetTexturesCommand::MAX_TEXTURES>& textures,
+                      const std::vector<uint16_t>& indices,
+                      const std::vector<graphics::Vertex>& vertices,
+                      const Matrix4F& transformMatrix,
+                      const float color[4]);
+
+            // issues the draw calls for all the collected sprites
+            void flush();
+
+        private:
+            struct Batch final
+            {
+                uintptr_t blendState;
+                uintptr_t shader;
+                std::array<uintptr_t, graphics::SetTexturesCommand::MAX_TEXTURES> textures;
+                float color[4];
+                uint32_t startIndex;
+                uint32_t indexCount;
+            };
+
+            Matrix4F renderViewProjection = Matrix4F::identity();
+            bool wireframe = false;
+
+            std::vector<Batch> batches;
+            std::vector<uint16_t> indices;
+            std::vector<graphics::Vertex> vertices;
+        };
+    } // namespace scene
+} // namespace ouzel
+
+#endif // OUZEL_SCENE_SPRITEBATCH_HPP
@@ -23,7 +23,7 @@ namespace ouzel
                                  const Vector2F& pivot):
             name(frameName)
         {
-            const std::vector<uint16_t> indices = {0, 1, 2, 1, 3, 2};
+            indices = {0, 1, 2, 1, 3, 2};
             indexCount = static_cast<uint32_t>(indices.size());
 
             Vector2F textCoords[4];
@@ -57,7 +57,7 @@ namespace ouzel
                 textCoords[3] = Vector2F(rightBottom.v[0], rightBottom.v[1]);
             }
 
-            const std::vector<graphics::Vertex> vertices{
+            vertices = {
                 graphics::Vertex(Vector3F{finalOffset.v[0], finalOffset.v[1], 0.0F}, Color::white(),
                                  textCoords[0], Vector3F{0.0F, 0.0F, -1.0F}),
                 graphics::Vertex(Vector3F{finalOffset.v[0] + frameRectangle.size.v[0], finalOffset.v[1], 0.0F}, Color::white(),
@@ -83,9 +83,11 @@ namespace ouzel
         }
 
         SpriteData::Frame::Frame(const std::string& frameName,
-                                 const std::vector<uint16_t>& indices,
-                                 const std::vector<graphics::Vertex>& vertices):
-            name(frameName)
+                                 const std::vector<uint16_t>& frameIndices,
+                                 const std::vector<graphics::Vertex>& frameVertices):
+            name(frameName),
+            indices(frameIndices),
+            vertices(frameVertices)
         {
             indexCount = static_cast<uint32_t>(indices.size());
 
@@ -104,13 +106,15 @@ namespace ouzel
         }
 
         SpriteData::Frame::Frame(const std::string& frameName,
-                                 const std::vector<uint16_t>& indices,
-                                 const std::vector<graphics::Vertex>& vertices,
+                                 const std::vector<uint16_t>& frameIndices,
+                                 const std::vector<graphics::Vertex>& frameVertices,
                                  const RectF& frameRectangle,
                                  const Size2F& sourceSize,
                                  const Vector2F& sourceOffset,
                                  const Vector2F& pivot):
-            name(frameName)
+            name(frameName),
+            indices(frameIndices),
+            vertices(frameVertices)
         {
             indexCount = static_cast<uint32_t>(indices.size());
 
@@ -132,7 +136,8 @@ namespace ouzel
                                                               static_cast<uint32_t>(getVectorSize(vertices)));
         }
 
-        SpriteRenderer::SpriteRenderer()
+        SpriteRenderer::SpriteRenderer():
+            textureShader(engine->getCache().getShader(SHADER_TEXTURE))
         {
             updateHandler.updateHandler = [this](const UpdateEvent& event){
                 update(event.delta);
@@ -329,14 +334,10 @@ namespace ouzel
                             renderViewProjection,
                             wireframe);
 
-            if (currentAnimation != animationQueue.end() &&
-                currentAnimation->animation->frameInterval > 0.0F &&
-                !currentAnimation->animation->frames.empty() &&
-                material)
-            {
-                auto currentFrame = static_cast<size_t>(currentTime / currentAnimation->animation->frameInterval);
-                if (currentFrame >= currentAnimation->animation->frames.size()) currentFrame = currentAnimation->animation->frames.size() - 1;
+            const SpriteData::Frame* frame = getCurrentFrame();
 
+            if (frame && material)
+            {
                 const Matrix4F modelViewProj = renderViewProjection * transformMatrix * offsetMatrix;
                 const float colorVector[] = {
                     material->diffuseColor.normR(),
@@ -345,36 +346,62 @@ namespace ouzel
                     material->diffuseColor.normA() * opacity * material->opacity
                 };
 
-                std::vector<std::vector<float>> fragmentShaderConstants(1);
-                fragmentShaderConstants[0] = {std::begin(colorVector), std::end(colorVector)};
-
-                std::vector<std::vector<float>> vertexShaderConstants(1);
-                vertexShaderConstants[0] = {std::begin(modelViewProj.m), std::end(modelViewProj.m)};
-
-                std::vector<uintptr_t> textures;
-                textures.reserve(graphics::Material::TEXTURE_LAYERS);
-                for (const std::shared_ptr<graphics::Texture>& texture : material->textures)
-                    textures.push_back(texture ? texture->getResource() : 0);
+                std::array<uintptr_t, graphics::SetTexturesCommand::MAX_TEXTURES> textures{};
+                for (uint32_t i = 0; i < graphics::Material::TEXTURE_LAYERS; ++i)
+                    if (const auto& texture = material->textures[i])
+                        textures[i] = texture->getResource();
 
                 engine->getRenderer()->setPipelineState(material->blendState->getResource(),
                                                         material->shader->getResource(),
                                                         graphics::CullMode::NoCull,
                                                         wireframe ? graphics::FillMode::Wireframe : graphics::FillMode::Solid);
-                engine->getRenderer()->setShaderConstants(fragmentShaderConstants,
-                                                          vertexShaderConstants);
+                engine->getRenderer()->setShaderConstants({colorVector},
+                                                          {modelViewProj.m});
                 engine->getRenderer()->setTextures(textures);
 
-                const SpriteData::Frame& frame = currentAnimation->animation->frames[currentFrame];
-
-                engine->getRenderer()->draw(frame.getIndexBuffer()->getResource(),
-                                            frame.getIndexCount(),
+                engine->getRenderer()->draw(frame->getIndexBuffer()->getResource(),
+                                            frame->getIndexCount(),
                                             sizeof(uint16_t),
-                                            frame.getVertexBuffer()->getResource(),
+                                            frame->getVertexBuffer()->getResource(),
                                             graphics::DrawMode::TriangleList,
                                             0);
             }
         }
 
+        bool SpriteRenderer::batch(SpriteBatch& spriteBatch,
+                                   const Matrix4F& transformMatrix,
+                                   float opacity)
+        {
+            // only the texture shader is known to take just the color and the transformation as constants
+            if (!material || material->shader != textureShader)
+                return false;
+
+            if (const SpriteData::Frame* frame = getCurrentFrame())
+            {
+                const float colorVector[] = {
+                    material->diffuseColor.normR(),
+                    material->diffuseColor.normG(),
+                    material->diffuseColor.normB(),
+                    material->diffuseColor.normA() * opacity * material->opacity
+                };
+
+                std::array<uintptr_t, graphics::SetTexturesCommand::MAX_TEXTURES> textures{};
+                for (uint32_t i = 0; i < graphics::Material::TEXTURE_LAYERS; ++i)
+                    if (const auto& texture = material->textures[i])
+                        textures[i] = texture->getResource();
+
+                spriteBatch.draw(material->blendState->getResource(),
+                                 material->shader->getResource(),
+                                 textures,
+                                 frame->getIndices(),
+                                 frame->getVertices(),
+                                 transformMatrix * offsetMatrix,
+                                 colorVector);
+            }
+
+            return true;
+        }
+
         void SpriteRenderer::setOffset(const Vector2F& newOffset)
         {
             offset = newOffset;
@@ -485,6 +512,19 @@ namespace ouzel
             running = true;
         }
 
+        const SpriteData::Frame* SpriteRenderer::getCurrentFrame() const
+        {
+            if (currentAnimation == animationQueue.end() ||
+                currentAnimation->animation->frameInterval <= 0.0F ||
+                currentAnimation->animation->frames.empty())
+                return nullptr;
+
+            auto currentFrame = static_cast<size_t>(currentTime / currentAnimation->animation->frameInterval);
+            if (currentFrame >= currentAnimation->animation->frames.size()) currentFrame = currentAnimation->animation->frames.size() - 1;
+
+            return &currentAnimation->animation->frames[currentFrame];
+        }
+
         void SpriteRenderer::updateBoundingBox()
         {
             if (currentAnimation != animationQueue.end() &&
@@ -508,6 +548,8 @@ namespace ouzel
             }
             else
                 boundingBox.reset();
+
+            invalidateBoundingBox();
         }
     } // namespace scene
 } // namespace ouzel
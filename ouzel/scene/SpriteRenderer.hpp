@@ -8,6 +8,7 @@
 #include <memory>
 #include <vector>
 #include "scene/Component.hpp"
+#include "scene/SpriteBatch.hpp"
 #include "math/Box.hpp"
 #include "math/Rect.hpp"
 #include "math/Size.hpp"
@@ -39,12 +40,12 @@ namespace ouzel
                       const Vector2F& pivot);
 
                 Frame(const std::string& frameName,
-                      const std::vector<uint16_t>& indices,
-                      const std::vector<graphics::Vertex>& vertices);
+                      const std::vector<uint16_t>& frameIndices,
+                      const std::vector<graphics::Vertex>& frameVertices);
 
                 Frame(const std::string& frameName,
-                      const std::vector<uint16_t>& indices,
-                      const std::vector<graphics::Vertex>& vertices,
+                      const std::vector<uint16_t>& frameIndices,
+                      const std::vector<graphics::Vertex>& frameVertices,
                       const RectF& frameRectangle,
                       const Size2F& sourceSize,
                       const Vector2F& sourceOffset,
@@ -56,11 +57,15 @@ namespace ouzel
                 inline auto getIndexCount() const noexcept { return indexCount; }
                 inline auto& getIndexBuffer() const noexcept { return indexBuffer; }
                 inline auto& getVertexBuffer() const noexcept { return vertexBuffer; }
+                inline auto& getIndices() const noexcept { return indices; }
+                inline auto& getVertices() const noexcept { return vertices; }
 
             private:
                 std::string name;
                 Box2F boundingBox;
                 uint32_t indexCount = 0;
+                std::vector<uint16_t> indices;
+                std::vector<graphics::Vertex> vertices;
                 std::shared_ptr<graphics::Buffer> indexBuffer;
                 std::shared_ptr<graphics::Buffer> vertexBuffer;
             };
@@ -100,6 +105,9 @@ namespace ouzel
                       float opacity,
                       const Matrix4F& renderViewProjection,
                       bool wireframe) override;
+            bool batch(SpriteBatch& spriteBatch,
+                       const Matrix4F& transformMatrix,
+                       float opacity) override;
 
             inline auto& getMaterial() const noexcept { return material; }
             inline void setMaterial(const std::shared_ptr<graphics::Material>& newMaterial) { material = newMaterial; }
@@ -123,8 +131,10 @@ namespace ouzel
 
         private:
             void updateBoundingBox();
+            const SpriteData::Frame* getCurrentFrame() const;
 
             std::shared_ptr<graphics::Material> material;
+            const graphics::Shader* textureShader = nullptr;
             std::map<std::string, SpriteData::Animation> animations;
 
             struct QueuedAnimation final
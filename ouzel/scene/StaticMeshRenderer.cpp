@@ -65,6 +65,8 @@ namespace ouzel
             indexSize = meshData.indexSize;
             indexBuffer = &meshData.indexBuffer;
             vertexBuffer = &meshData.vertexBuffer;
+
+            invalidateBoundingBox();
         }
 
         void StaticMeshRenderer::draw(const Matrix4F& transformMatrix,
@@ -85,22 +87,17 @@ namespace ouzel
                 material->diffuseColor.normA() * opacity * material->opacity
             };
 
-            std::vector<std::vector<float>> fragmentShaderConstants(1);
-            fragmentShaderConstants[0] = {std::begin(colorVector), std::end(colorVector)};
-
-            std::vector<std::vector<float>> vertexShaderConstants(1);
-            vertexShaderConstants[0] = {std::begin(modelViewProj.m), std::end(modelViewProj.m)};
-
-            std::vector<uintptr_t> textures;
-            for (const std::shared_ptr<graphics::Texture>& texture : material->textures)
-                textures.push_back(texture ? texture->getResource() : 0);
+            std::array<uintptr_t, graphics::SetTexturesCommand::MAX_TEXTURES> textures{};
+            for (uint32_t i = 0; i < graphics::Material::TEXTURE_LAYERS; ++i)
+                if (const auto& texture = material->textures[i])
+                    textures[i] = texture->getResource();
 
             engine->getRenderer()->setPipelineState(material->blendState->getResource(),
                                                     material->shader->getResource(),
                                                     material->cullMode,
                                                     wireframe ? graphics::FillMode::Wireframe : graphics::FillMode::Solid);
-            engine->getRenderer()->setShaderConstants(fragmentShaderConstants,
-                                                      vertexShaderConstants);
+            engine->getRenderer()->setShaderConstants({colorVector},
+                                                      {modelViewProj.m});
             engine->getRenderer()->setTextures(textures);
             engine->getRenderer()->draw(indexBuffer->getResource(),
                                         indexCount,
@@ -109,5 +106,36 @@ namespace ouzel
                                         graphics::DrawMode::TriangleList,
                                         0);
         }
+
+        bool StaticMeshRenderer::batchInstance(InstanceBatch& instanceBatch,
+                                               const Matrix4F& transformMatrix,
+                                               float opacity)
+        {
+            const float colorVector[] = {
+                material->diffuseColor.normR(),
+                material->diffuseColor.normG(),
+                material->diffuseColor.normB(),
+                material->diffuseColor.normA() * opacity * material->opacity
+            };
+
+            std::array<uintptr_t, graphics::SetTexturesCommand::MAX_TEXTURES> textures{};
+            for (uint32_t i = 0; i < graphics::Material::TEXTURE_LAYERS; ++i)
+                if (const auto& texture = material->textures[i])
+                    textures[i] = texture->getResource();
+
+            // actors that share the mesh and the material are drawn with one instanced draw call
+            instanceBatch.draw(material->blendState->getResource(),
+                               material->shader->getResource(),
+                               material->cullMode,
+                               textures,
+                               indexBuffer->getResource(),
+                               indexCount,
+                               indexSize,
+                               vertexBuffer->getResource(),
+                               transformMatrix,
+                               colorVector);
+
+            return true;
+        }
     } // namespace scene
 } // namespace ouzel
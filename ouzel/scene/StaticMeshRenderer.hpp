@@ -5,6 +5,7 @@
 
 #include <vector>
 #include "scene/Component.hpp"
+#include "scene/InstanceBatch.hpp"
 #include "graphics/Buffer.hpp"
 #include "graphics/Material.hpp"
 #include "graphics/Vertex.hpp"
@@ -42,6 +43,9 @@ namespace ouzel
                       float opacity,
                       const Matrix4F& renderViewProjection,
                       bool wireframe) override;
+            bool batchInstance(InstanceBatch& instanceBatch,
+                               const Matrix4F& transformMatrix,
+                               float opacity) override;
 
             inline auto& getMaterial() const noexcept { return material; }
             inline void setMaterial(const graphics::Material* newMaterial)
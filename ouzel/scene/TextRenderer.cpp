@@ -31,14 +31,14 @@ namespace ouzel
         {
             whitePixelTexture = engine->getCache().getTexture(TEXTURE_WHITE_PIXEL);
 
-            font = engine->getCache().getFont(fontFile);
+            font = assets::Handle<gui::Font>(engine->getCache(), fontFile);
 
             updateText();
         }
 
         void TextRenderer::setFont(const std::string& fontFile)
         {
-            font = engine->getCache().getFont(fontFile);
+            font = assets::Handle<gui::Font>(engine->getCache(), fontFile);
 
             updateText();
         }
@@ -67,36 +67,53 @@ namespace ouzel
                             renderViewProjection,
                             wireframe);
 
-            if (needsMeshUpdate)
+            // the font is looked up again only after the bundles have changed
+            if (font.get() != renderedFont)
+                updateText();
+
+            if (!texture) return;
+
+            uintptr_t drawIndexBuffer = indexBuffer.getResource();
+            uintptr_t drawVertexBuffer = vertexBuffer.getResource();
+            uint32_t startIndex = 0;
+
+            // text that changed since the last draw is drawn from the transient buffers of the frame,
+            // it is uploaded to the buffers of the renderer only once it stops changing
+            if (needsMeshUpdate && !indices.empty())
+            {
+                const auto geometry = engine->getRenderer()->allocateTransientGeometry(indices, vertices);
+                drawIndexBuffer = geometry.indexBuffer;
+                drawVertexBuffer = geometry.vertexBuffer;
+                startIndex = geometry.startIndex;
+
+                needsMeshUpdate = false;
+                needsBufferUpdate = true;
+            }
+            else if (needsMeshUpdate || needsBufferUpdate)
             {
                 indexBuffer.setData(indices.data(), static_cast<uint32_t>(getVectorSize(indices)));
                 vertexBuffer.setData(vertices.data(), static_cast<uint32_t>(getVectorSize(vertices)));
 
                 needsMeshUpdate = false;
+                needsBufferUpdate = false;
             }
 
             const Matrix4F modelViewProj = renderViewProjection * transformMatrix;
             const float colorVector[] = {color.normR(), color.normG(), color.normB(), color.normA() * opacity};
 
-            std::vector<std::vector<float>> fragmentShaderConstants(1);
-            fragmentShaderConstants[0] = {std::begin(colorVector), std::end(colorVector)};
-
-            std::vector<std::vector<float>> vertexShaderConstants(1);
-            vertexShaderConstants[0] = {std::begin(modelViewProj.m), std::end(modelViewProj.m)};
-
             engine->getRenderer()->setPipelineState(blendState->getResource(),
                                                     shader->getResource(),
                                                     graphics::CullMode::NoCull,
                                                     wireframe ? graphics::FillMode::Wireframe : graphics::FillMode::Solid);
-            engine->getRenderer()->setShaderConstants(fragmentShaderConstants,
-                                                      vertexShaderConstants);
+            engine->getRenderer()->setShaderConstants({colorVector},
+                                                      {modelViewProj.m});
             engine->getRenderer()->setTextures({wireframe ? whitePixelTexture->getResource() : texture->getResource()});
-            engine->getRenderer()->draw(indexBuffer.getResource(),
+            engine->getRenderer()->draw(drawIndexBuffer,
                                         static_cast<uint32_t>(indices.size()),
                                         sizeof(uint16_t),
-                                        vertexBuffer.getResource(),
+                                        drawVertexBuffer,
                                         graphics::DrawMode::TriangleList,
-                                        0);
+                                        startIndex);
         }
 
         void TextRenderer::setText(const std::string& newText)
@@ -115,9 +132,11 @@ namespace ouzel
         {
             boundingBox.reset();
 
-            if (font)
+            renderedFont = font.get();
+
+            if (renderedFont)
             {
-                std::tie(indices, vertices, texture) = font->getRenderData(text, Color::white(), fontSize, textAnchor);
+                std::tie(indices, vertices, texture) = renderedFont->getRenderData(text, Color::white(), fontSize, textAnchor);
                 needsMeshUpdate = true;
 
                 for (const graphics::Vertex& vertex : vertices)
@@ -129,6 +148,8 @@ namespace ouzel
                 vertices.clear();
                 texture.reset();
             }
+
+            invalidateBoundingBox();
         }
     } // namespace scene
 } // namespace ouzel
@@ -5,6 +5,7 @@
 
 #include <string>
 #include "scene/Component.hpp"
+#include "assets/Handle.hpp"
 #include "math/Color.hpp"
 #include "gui/BMFont.hpp"
 #include "graphics/BlendState.hpp"
@@ -68,7 +69,8 @@ namespace ouzel
             std::shared_ptr<graphics::Texture> texture;
             std::shared_ptr<graphics::Texture> whitePixelTexture;
 
-            const gui::Font* font = nullptr;
+            assets::Handle<gui::Font> font;
+            const gui::Font* renderedFont = nullptr; // the font that the mesh was built with
             std::string text;
             float fontSize = 1.0F;
             Vector2F textAnchor;
@@ -79,6 +81,7 @@ namespace ouzel
             Color color = Color::white();
 
             bool needsMeshUpdate = false;
+            bool needsBufferUpdate = false;
         };
     } // namespace scene
 } // namespace ouzel
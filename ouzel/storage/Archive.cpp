@@ -0,0 +1,254 @@
+// Copyright 2015-2019 Elviss Strazdins. All rights reserved.
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include "Archive.hpp"
+#include "utils/Utils.hpp"
+
+namespace ouzel
+{
+    namespace storage
+    {
+        namespace
+        {
+            constexpr uint32_t LOCAL_HEADER_SIGNATURE = 0x04034B50;
+            constexpr uint32_t CENTRAL_DIRECTORY_SIGNATURE = 0x02014B50;
+            constexpr uint32_t END_OF_CENTRAL_DIRECTORY_SIGNATURE = 0x06054B50;
+
+            constexpr size_t LOCAL_HEADER_SIZE = 30;
+            constexpr size_t CENTRAL_DIRECTORY_HEADER_SIZE = 46;
+            constexpr size_t END_OF_CENTRAL_DIRECTORY_SIZE = 22;
+            constexpr size_t MAX_COMMENT_SIZE = 65535;
+
+            constexpr uint16_t ENCRYPTED_FLAG = 0x0001;
+
+            constexpr uint16_t STORED_METHOD = 0;
+            constexpr uint16_t DEFLATE_METHOD = 8;
+
+            void decompress(const Archive::Entry& entry, const uint8_t* entryData, uint8_t* result)
+            {
+                // ZIP entries are raw DEFLATE streams without a zlib header
+                Inflater inflater(Span<const uint8_t>(entryData, entry.compressedSize));
+
+                if (inflater.inflate(result, entry.size) != entry.size)
+                    throw std::runtime_error("Failed to decompress archive entry");
+            }
+        }
+
+        Archive::Archive(const std::string& path):
+            file(std::make_shared<const MappedFile>(path))
+        {
+            const uint8_t* data = file->getData();
+            const size_t size = file->getSize();
+
+            if (size < END_OF_CENTRAL_DIRECTORY_SIZE)
+                throw std::runtime_error("Invalid archive");
+
+            // the end of central directory record is followed only by the archive comment
+            const size_t searchEnd = (size - END_OF_CENTRAL_DIRECTORY_SIZE > MAX_COMMENT_SIZE) ?
+                size - END_OF_CENTRAL_DIRECTORY_SIZE - MAX_COMMENT_SIZE : 0;
+
+            const uint8_t* endOfCentralDirectory = nullptr;
+
+            for (size_t offset = size - END_OF_CENTRAL_DIRECTORY_SIZE + 1; offset-- > searchEnd;)
+                if (decodeLittleEndian<uint32_t>(data + offset) == END_OF_CENTRAL_DIRECTORY_SIGNATURE)
+                {
+                    endOfCentralDirectory = data + offset;
+                    break;
+                }
+
+            if (!endOfCentralDirectory)
+                throw std::runtime_error("End of central directory not found");
+
+            const auto diskNumber = decodeLittleEndian<uint16_t>(endOfCentralDirectory + 4);
+            const auto centralDirectoryDisk = decodeLittleEndian<uint16_t>(endOfCentralDirectory + 6);
+            const auto entryCount = decodeLittleEndian<uint16_t>(endOfCentralDirectory + 10);
+            const auto centralDirectorySize = decodeLittleEndian<uint32_t>(endOfCentralDirectory + 12);
+            const auto centralDirectoryOffset = decodeLittleEndian<uint32_t>(endOfCentralDirectory + 16);
+
+            if (diskNumber != 0 || centralDirectoryDisk != 0)
+                throw std::runtime_error("Multi-disk archives are not supported");
+
+            if (entryCount == 0xFFFF ||
+                centralDirectorySize == 0xFFFFFFFF ||
+                centralDirectoryOffset == 0xFFFFFFFF)
+                throw std::runtime_error("ZIP64 archives are not supported");
+
+            if (centralDirectoryOffset > size ||
+                centralDirectorySize > size - centralDirectoryOffset)
+                throw std::runtime_error("Invalid central directory");
+
+            entries.reserve(entryCount);
+
+            const uint8_t* header = data + centralDirectoryOffset;
+            const uint8_t* centralDirectoryEnd = header + centralDirectorySize;
+
+            for (uint32_t i = 0; i < entryCount; ++i)
+            {
+                if (static_cast<size_t>(centralDirectoryEnd - header) < CENTRAL_DIRECTORY_HEADER_SIZE ||
+                    decodeLittleEndian<uint32_t>(header) != CENTRAL_DIRECTORY_SIGNATURE)
+                    throw std::runtime_error("Bad signature");
+
+                const auto flags = decodeLittleEndian<uint16_t>(header + 8);
+                const auto method = decodeLittleEndian<uint16_t>(header + 10);
+                const auto compressedSize = decodeLittleEndian<uint32_t>(header + 20);
+                const auto uncompressedSize = decodeLittleEndian<uint32_t>(header + 24);
+                const auto fileNameLength = decodeLittleEndian<uint16_t>(header + 28);
+                const auto extraFieldLength = decodeLittleEndian<uint16_t>(header + 30);
+                const auto commentLength = decodeLittleEndian<uint16_t>(header + 32);
+                const auto localHeaderOffset = decodeLittleEndian<uint32_t>(header + 42);
+
+                const size_t headerSize = CENTRAL_DIRECTORY_HEADER_SIZE + fileNameLength + extraFieldLength + commentLength;
+
+                if (static_cast<size_t>(centralDirectoryEnd - header) < headerSize)
+                    throw std::runtime_error("Invalid central directory");
+
+                std::string name(reinterpret_cast<const char*>(header + CENTRAL_DIRECTORY_HEADER_SIZE), fileNameLength);
+
+                header += headerSize;
+
+                // skip directories
+                if (!name.empty() && name.back() == '/')
+                    continue;
+
+                if (flags & ENCRYPTED_FLAG)
+                    throw std::runtime_error("Encrypted archives are not supported");
+
+                Entry entry;
+
+                if (method == STORED_METHOD)
+                    entry.compression = Compression::Stored;
+                else if (method == DEFLATE_METHOD)
+                    entry.compression = Compression::Deflate;
+                else
+                    throw std::runtime_error("Unsupported compression");
+
+                entry.localHeaderOffset = localHeaderOffset;
+                entry.compressedSize = compressedSize;
+                entry.size = uncompressedSize;
+
+                entries[std::move(name)] = entry;
+            }
+        }
+
+        std::vector<uint8_t> Archive::readFile(const std::string& filename) const
+        {
+            const Entry& entry = getEntry(filename);
+            const uint8_t* entryData = getEntryData(entry);
+
+            std::vector<uint8_t> data(entry.size);
+
+            if (entry.compression == Compression::Deflate)
+                decompress(entry, entryData, data.data());
+            else
+                std::copy(entryData, entryData + entry.size, data.begin());
+
+            return data;
+        }
+
+        FileView Archive::readFileView(const std::string& filename) const
+        {
+            const Entry& entry = getEntry(filename);
+            const uint8_t* entryData = getEntryData(entry);
+
+            if (entry.compression == Compression::Stored)
+                return FileView(file, Span<const uint8_t>(entryData, entry.size));
+
+            std::vector<uint8_t> data(entry.size);
+            decompress(entry, entryData, data.data());
+            return FileView(std::move(data));
+        }
+
+        Archive::EntryReader Archive::openFile(const std::string& filename) const
+        {
+            return EntryReader(*this, filename);
+        }
+
+        const Archive::Entry& Archive::getEntry(const std::string& filename) const
+        {
+            auto i = entries.find(filename);
+
+            if (i == entries.end())
+                throw std::runtime_error("File " + filename + " does not exist");
+
+            return i->second;
+        }
+
+        const uint8_t* Archive::getEntryData(const Entry& entry) const
+        {
+            const uint8_t* data = file->getData();
+            const size_t size = file->getSize();
+
+            if (entry.localHeaderOffset > size ||
+                size - entry.localHeaderOffset < LOCAL_HEADER_SIZE)
+                throw std::runtime_error("Invalid archive entry");
+
+            const uint8_t* localHeader = data + entry.localHeaderOffset;
+
+            if (decodeLittleEndian<uint32_t>(localHeader) != LOCAL_HEADER_SIGNATURE)
+                throw std::runtime_error("Bad signature");
+
+            // the extra field of the local header can differ from the one in the central directory
+            const auto fileNameLength = decodeLittleEndian<uint16_t>(localHeader + 26);
+            const auto extraFieldLength = decodeLittleEndian<uint16_t>(localHeader + 28);
+
+            const size_t dataOffset = entry.localHeaderOffset + LOCAL_HEADER_SIZE + fileNameLength + extraFieldLength;
+            const size_t dataSize = (entry.compression == Compression::Stored) ? entry.size : entry.compressedSize;
+
+            if (dataOffset > size || size - dataOffset < dataSize)
+                throw std::runtime_error("Invalid archive entry");
+
+            return data + dataOffset;
+        }
+
+        Archive::EntryReader::EntryReader(const Archive& archive, const std::string& filename):
+            file(archive.file)
+        {
+            const Entry& entry = archive.getEntry(filename);
+
+            compression = entry.compression;
+            data = archive.getEntryData(entry);
+            size = entry.size;
+
+            if (compression == Compression::Deflate)
+                inflater = Inflater(Span<const uint8_t>(data, entry.compressedSize));
+        }
+
+        uint32_t Archive::EntryReader::read(void* destination, uint32_t bytes)
+        {
+            uint32_t bytesRead = std::min(bytes, size - offset);
+
+            if (compression == Compression::Deflate)
+                bytesRead = static_cast<uint32_t>(inflater.inflate(static_cast<uint8_t*>(destination), bytesRead));
+            else
+                std::memcpy(destination, data + offset, bytesRead);
+
+            offset += bytesRead;
+            return bytesRead;
+        }
+
+        void Archive::EntryReader::seek(uint32_t newOffset)
+        {
+            if (newOffset > size)
+                throw std::runtime_error("Invalid offset");
+
+            if (compression == Compression::Deflate)
+            {
+                // the stream can only be decompressed forward
+                if (newOffset < offset)
+                {
+                    inflater.reset();
+                    offset = 0;
+                }
+
+                uint8_t skipped[1024];
+                while (offset < newOffset)
+                    if (read(skipped, std::min(newOffset - offset, static_cast<uint32_t>(sizeof(skipped)))) == 0)
+                        throw std::runtime_error("Failed to decompress archive entry");
+            }
+            else
+                offset = newOffset;
+        }
+    } // namespace storage
+} // namespace ouzel
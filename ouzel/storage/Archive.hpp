@@ -4,120 +4,86 @@
 #define OUZEL_STORAGE_ARCHIVE_HPP
 
 #include <cstdint>
-#include <map>
-#include <stdexcept>
+#include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
-#include "storage/File.hpp"
-#include "utils/Utils.hpp"
+#include "storage/FileView.hpp"
+#include "storage/Inflater.hpp"
+#include "storage/MappedFile.hpp"
 
 namespace ouzel
 {
     namespace storage
     {
+        // ZIP archive indexed from its central directory, the archive is mapped into memory,
+        // so entries can be read from multiple threads at the same time
         class Archive final
         {
         public:
-            Archive() = default;
-
-            explicit Archive(const std::string& path):
-                file{File(path, File::Mode::Read)}
+            enum class Compression
             {
-                constexpr uint32_t CENTRAL_DIRECTORY = 0x02014B50;
-                constexpr uint32_t HEADER_SIGNATURE = 0x04034B50;
-
-                for (;;)
-                {
-                    uint32_t signature;
-
-                    file.read(&signature, sizeof(signature), true);
-
-                    if (decodeLittleEndian<uint32_t>(&signature) == CENTRAL_DIRECTORY)
-                        break;
-
-                    if (decodeLittleEndian<uint32_t>(&signature) != HEADER_SIGNATURE)
-                        throw std::runtime_error("Bad signature");
-
-                    uint8_t version[2];
-
-                    file.read(version, sizeof(version), true);
-
-                    uint16_t flags;
-
-                    file.read(&flags, sizeof(flags), true);
-
-                    uint16_t compression;
-                    file.read(&compression, sizeof(compression), true);
-
-                    if (compression != 0x00)
-                        throw std::runtime_error("Unsupported compression");
-
-                    file.seek(4, File::Seek::Current); // skip modification time
-                    file.seek(4, File::Seek::Current); // skip CRC-32
-
-                    uint32_t compressedSize;
-                    file.read(&compressedSize, sizeof(compressedSize), true);
-
-                    uint32_t uncompressedSize;
-                    file.read(&uncompressedSize, sizeof(uncompressedSize), true);
-
-                    uint16_t fileNameLength;
-                    file.read(&fileNameLength, sizeof(fileNameLength), true);
-
-                    uint16_t extraFieldLength;
-                    file.read(&extraFieldLength, sizeof(extraFieldLength), true);
-
-                    std::vector<char> name(decodeLittleEndian<uint16_t>(&fileNameLength) + 1);
-
-                    file.read(name.data(), decodeLittleEndian<uint16_t>(&fileNameLength), true);
-
-                    name[decodeLittleEndian<uint16_t>(&fileNameLength)] = '\0';
-
-                    Entry& entry = entries[name.data()];
-                    entry.size = decodeLittleEndian<uint32_t>(&uncompressedSize);
-
-                    file.seek(decodeLittleEndian<uint16_t>(&extraFieldLength), File::Seek::Current); // skip extra field
-
-                    entry.offset = file.getOffset();
+                Stored,
+                Deflate
+            };
 
-                    file.seek(static_cast<int32_t>(decodeLittleEndian<uint32_t>(&uncompressedSize)),
-                              File::Seek::Current); // skip uncompressed size
-                }
-            }
+            struct Entry final
+            {
+                Compression compression;
+                uint32_t localHeaderOffset;
+                uint32_t compressedSize;
+                uint32_t size;
+            };
 
-            std::vector<uint8_t> readFile(const std::string& filename) const
+            // Sequential reader of one entry, stored entries are read directly from the mapping
+            // and deflated entries are decompressed as they are read
+            class EntryReader final
             {
-                std::vector<uint8_t> data;
+            public:
+                EntryReader(const Archive& archive, const std::string& filename);
 
-                auto i = entries.find(filename);
+                EntryReader(const EntryReader&) = delete;
+                EntryReader& operator=(const EntryReader&) = delete;
 
-                if (i == entries.end())
-                    throw std::runtime_error("File " + filename + " does not exist");
+                EntryReader(EntryReader&&) = default;
+                EntryReader& operator=(EntryReader&&) = default;
 
-                file.seek(static_cast<int32_t>(i->second.offset), File::Seek::Begin);
+                uint32_t read(void* destination, uint32_t bytes);
+                void seek(uint32_t newOffset);
 
-                data.resize(i->second.size);
+                inline auto getOffset() const noexcept { return offset; }
+                inline auto getSize() const noexcept { return size; }
 
-                file.read(data.data(), i->second.size, true);
+            private:
+                std::shared_ptr<const MappedFile> file; // the reader keeps the archive mapped
+                Compression compression = Compression::Stored;
+                const uint8_t* data = nullptr;
+                Inflater inflater;
+                uint32_t size = 0;
+                uint32_t offset = 0;
+            };
 
-                return data;
-            }
+            Archive() = default;
+            explicit Archive(const std::string& path);
+
+            std::vector<uint8_t> readFile(const std::string& filename) const;
+            // stored entries are not copied, the view keeps the archive mapped
+            FileView readFileView(const std::string& filename) const;
+            EntryReader openFile(const std::string& filename) const;
 
             bool fileExists(const std::string& filename) const
             {
                 return entries.find(filename) != entries.end();
             }
 
-        private:
-            File file;
+            inline auto getFileCount() const noexcept { return entries.size(); }
 
-            struct Entry final
-            {
-                uint32_t offset;
-                uint32_t size;
-            };
+        private:
+            const Entry& getEntry(const std::string& filename) const;
+            const uint8_t* getEntryData(const Entry& entry) const;
 
-            std::map<std::string, Entry> entries;
+            std::shared_ptr<const MappedFile> file;
+            std::unordered_map<std::string, Entry> entries;
         };
     } // namespace storage
 } // namespace ouzel
@@ -328,6 +328,24 @@ namespace ouzel
 #endif
             }
 
+            uint64_t getSize() const
+            {
+                if (file == INVALID)
+                    throw std::runtime_error("File is not open");
+
+#if defined(_WIN32)
+                LARGE_INTEGER size;
+                if (!GetFileSizeEx(file, &size))
+                    throw std::system_error(GetLastError(), std::system_category(), "Failed to get file size");
+                return static_cast<uint64_t>(size.QuadPart);
+#else
+                struct stat buf;
+                if (fstat(file, &buf) == -1)
+                    throw std::system_error(errno, std::system_category(), "Failed to get file size");
+                return static_cast<uint64_t>(buf.st_size);
+#endif
+            }
+
         private:
             Type file = INVALID;
         };
@@ -3,6 +3,7 @@
 #include "core/Setup.h"
 
 #include <algorithm>
+#include <limits>
 #include <stdexcept>
 #include <system_error>
 #if defined(_WIN32)
@@ -329,12 +330,15 @@ namespace ouzel
         std::vector<uint8_t> FileSystem::readFile(const std::string& filename, const bool searchResources) const
         {
             if (searchResources)
-                for (const auto& archive : archives)
-                    if (archive.second.fileExists(filename))
-                        return archive.second.readFile(filename);
+            {
+                if (const auto pack = findPack(filename))
+                    return pack->readFile(filename);
+
+                if (const auto archive = findArchive(filename))
+                    return archive->readFile(filename);
+            }
 
             std::vector<uint8_t> data;
-            char buffer[1024];
 
 #if defined(__ANDROID__)
             if (pathIsRelative(filename))
@@ -346,13 +350,19 @@ namespace ouzel
                 if (!asset)
                     throw std::runtime_error("Failed to open file " + filename);
 
+                data.resize(static_cast<size_t>(AAsset_getLength64(asset)));
+
+                size_t offset = 0;
                 int bytesRead = 0;
 
-                while ((bytesRead = AAsset_read(asset, buffer, sizeof(buffer))) > 0)
-                    data.insert(data.end(), reinterpret_cast<uint8_t*>(buffer), reinterpret_cast<uint8_t*>(buffer + bytesRead));
+                while (offset < data.size() &&
+                       (bytesRead = AAsset_read(asset, data.data() + offset, data.size() - offset)) > 0)
+                    offset += static_cast<size_t>(bytesRead);
 
                 AAsset_close(asset);
 
+                data.resize(offset);
+
                 return data;
             }
 #endif
@@ -365,12 +375,66 @@ namespace ouzel
 
             File file(path, File::Mode::Read);
 
-            while (const uint32_t size = file.read(buffer, sizeof(buffer)))
-                data.insert(data.end(), buffer, buffer + size);
+            const uint64_t size = file.getSize();
+            if (size > std::numeric_limits<size_t>::max())
+                throw std::runtime_error("File " + filename + " is too big");
+
+            // allocate the whole file at once and read it directly into the result
+            data.resize(static_cast<size_t>(size));
+
+            size_t offset = 0;
+            while (offset < data.size())
+            {
+                const auto chunkSize = static_cast<uint32_t>(std::min(data.size() - offset, static_cast<size_t>(std::numeric_limits<uint32_t>::max())));
+                const uint32_t bytesRead = file.read(data.data() + offset, chunkSize);
+                if (bytesRead == 0) break; // the file was truncated while reading
+                offset += bytesRead;
+            }
+
+            data.resize(offset);
 
             return data;
         }
 
+        FileView FileSystem::readFileView(const std::string& filename, const bool searchResources) const
+        {
+            if (searchResources)
+                if (const auto pack = findPack(filename))
+                    return pack->readFileView(filename);
+
+            return readUnpackedFileView(filename, searchResources);
+        }
+
+        FileView FileSystem::readFileView(const std::string& filename, uint32_t type, bool mipmaps) const
+        {
+            if (const auto pack = findPack(filename, type, mipmaps))
+                return pack->readFileView(filename, type, mipmaps);
+
+            // entries of the file cooked for other asset types are not usable
+            return readUnpackedFileView(filename, true);
+        }
+
+        FileView FileSystem::readUnpackedFileView(const std::string& filename, const bool searchResources) const
+        {
+            if (searchResources)
+                if (const auto archive = findArchive(filename))
+                    return archive->readFileView(filename);
+
+#if defined(__ANDROID__)
+            // assets inside the APK can not be mapped
+            if (pathIsRelative(filename))
+                return FileView(readFile(filename, searchResources));
+#endif
+
+            const auto path = getPath(filename, searchResources);
+
+            // file does not exist
+            if (path.empty())
+                throw std::runtime_error("Failed to find file " + filename);
+
+            return FileView(MappedFile(path));
+        }
+
         void FileSystem::writeFile(const std::string& filename, const std::vector<uint8_t>& data) const
         {
             File file(filename, File::Mode::Write | File::Mode::Create | File::Mode::Truncate);
@@ -540,11 +604,16 @@ namespace ouzel
 
         void FileSystem::addArchive(const std::string& name, Archive&& archive)
         {
-            archives.emplace_back(name, std::move(archive));
+            auto newArchive = std::make_shared<const Archive>(std::move(archive));
+
+            std::unique_lock<std::mutex> lock(mountMutex);
+            archives.emplace_back(name, std::move(newArchive));
         }
 
         void FileSystem::removeArchive(const std::string& name)
         {
+            std::unique_lock<std::mutex> lock(mountMutex);
+
             for (auto i = archives.begin(); i != archives.end();)
                 if (i->first == name)
                     i = archives.erase(i);
@@ -552,6 +621,66 @@ namespace ouzel
                     ++i;
         }
 
+        void FileSystem::addPack(const std::string& name, Pack&& pack)
+        {
+            auto newPack = std::make_shared<const Pack>(std::move(pack));
+
+            std::unique_lock<std::mutex> lock(mountMutex);
+
+            // a pack that is mounted again replaces the previous one
+            for (auto i = packs.begin(); i != packs.end();)
+                if (i->first == name)
+                    i = packs.erase(i);
+                else
+                    ++i;
+
+            packs.emplace_back(name, std::move(newPack));
+        }
+
+        void FileSystem::removePack(const std::string& name)
+        {
+            std::unique_lock<std::mutex> lock(mountMutex);
+
+            for (auto i = packs.begin(); i != packs.end();)
+                if (i->first == name)
+                    i = packs.erase(i);
+                else
+                    ++i;
+        }
+
+        std::shared_ptr<const Pack> FileSystem::findPack(const std::string& filename) const
+        {
+            std::unique_lock<std::mutex> lock(mountMutex);
+
+            for (const auto& pack : packs)
+                if (pack.second->fileExists(filename))
+                    return pack.second;
+
+            return nullptr;
+        }
+
+        std::shared_ptr<const Pack> FileSystem::findPack(const std::string& filename, uint32_t type, bool mipmaps) const
+        {
+            std::unique_lock<std::mutex> lock(mountMutex);
+
+            for (const auto& pack : packs)
+                if (pack.second->fileExists(filename, type, mipmaps))
+                    return pack.second;
+
+            return nullptr;
+        }
+
+        std::shared_ptr<const Archive> FileSystem::findArchive(const std::string& filename) const
+        {
+            std::unique_lock<std::mutex> lock(mountMutex);
+
+            for (const auto& archive : archives)
+                if (archive.second->fileExists(filename))
+                    return archive.second;
+
+            return nullptr;
+        }
+
         std::string FileSystem::getExtensionPart(const std::string& path)
         {
             const size_t pos = path.find_last_of('.');
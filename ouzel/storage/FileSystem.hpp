@@ -3,10 +3,14 @@
 #ifndef OUZEL_STORAGE_FILESYSTEM_HPP
 #define OUZEL_STORAGE_FILESYSTEM_HPP
 
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 #include <cstdint>
 #include "Archive.hpp"
+#include "FileView.hpp"
+#include "Pack.hpp"
 
 namespace ouzel
 {
@@ -25,6 +29,10 @@ namespace ouzel
             std::string getTempDirectory() const;
 
             std::vector<uint8_t> readFile(const std::string& filename, const bool searchResources = true) const;
+            // maps the file into memory instead of copying it when possible
+            FileView readFileView(const std::string& filename, const bool searchResources = true) const;
+            // reads the entry of the file that was cooked for the asset type and settings if it is in a pack
+            FileView readFileView(const std::string& filename, uint32_t type, bool mipmaps) const;
             void writeFile(const std::string& filename, const std::vector<uint8_t>& data) const;
 
             bool resourceFileExists(const std::string& filename) const;
@@ -33,6 +41,10 @@ namespace ouzel
             void removeResourcePath(const std::string& path);
             void addArchive(const std::string& name, Archive&& archive);
             void removeArchive(const std::string& name);
+            // files in the packs are found before the ones in the archives and the resource paths,
+            // packs and archives can be added and removed while the loader threads are reading files
+            void addPack(const std::string& name, Pack&& pack);
+            void removePack(const std::string& name);
 
             static std::string getExtensionPart(const std::string& path);
             static std::string getFilenamePart(const std::string& path);
@@ -43,10 +55,21 @@ namespace ouzel
             bool fileExists(const std::string& filename) const;
 
         private:
+            FileView readUnpackedFileView(const std::string& filename, const bool searchResources) const;
+
+            std::shared_ptr<const Pack> findPack(const std::string& filename) const;
+            std::shared_ptr<const Pack> findPack(const std::string& filename, uint32_t type, bool mipmaps) const;
+            std::shared_ptr<const Archive> findArchive(const std::string& filename) const;
+
             Engine& engine;
             std::string appPath;
             std::vector<std::string> resourcePaths;
-            std::vector<std::pair<std::string, Archive>> archives;
+
+            // a file is read from a pack or an archive after the lock is released, the shared pointer
+            // keeps the pack or the archive alive if it is removed in the meantime
+            mutable std::mutex mountMutex;
+            std::vector<std::pair<std::string, std::shared_ptr<const Archive>>> archives;
+            std::vector<std::pair<std::string, std::shared_ptr<const Pack>>> packs;
         };
     } // namespace storage
 } // namespace ouzel
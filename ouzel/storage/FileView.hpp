@@ -0,0 +1,66 @@
+// Copyright 2015-2019 Elviss Strazdins. All rights reserved.
+
+#ifndef OUZEL_STORAGE_FILEVIEW_HPP
+#define OUZEL_STORAGE_FILEVIEW_HPP
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "MappedFile.hpp"
+#include "utils/Span.hpp"
+
+namespace ouzel
+{
+    namespace storage
+    {
+        // Contents of a file that are either mapped into memory, read into a buffer if the file can not
+        // be mapped (e.g. it is inside an archive) or a part of the data of another object (e.g. a pack)
+        class FileView final
+        {
+        public:
+            FileView() noexcept = default;
+
+            explicit FileView(MappedFile&& initMappedFile) noexcept:
+                mappedFile(std::move(initMappedFile)),
+                view(mappedFile.getData(), mappedFile.getSize())
+            {
+            }
+
+            explicit FileView(std::vector<uint8_t>&& initBuffer) noexcept:
+                buffer(std::move(initBuffer)),
+                view(buffer.data(), buffer.size())
+            {
+            }
+
+            // the owner keeps the data alive for as long as the view exists
+            FileView(std::shared_ptr<const void> initOwner, Span<const uint8_t> initView) noexcept:
+                owner(std::move(initOwner)),
+                view(initView)
+            {
+            }
+
+            FileView(const FileView&) = delete;
+            FileView& operator=(const FileView&) = delete;
+
+            // moving the mapping and the vector keeps the address of the data
+            FileView(FileView&&) noexcept = default;
+            FileView& operator=(FileView&&) noexcept = default;
+
+            inline auto data() const noexcept { return view.data(); }
+            inline auto size() const noexcept { return view.size(); }
+            inline auto empty() const noexcept { return view.empty(); }
+            inline auto begin() const noexcept { return view.begin(); }
+            inline auto end() const noexcept { return view.end(); }
+
+            inline operator Span<const uint8_t>() const noexcept { return view; }
+
+        private:
+            MappedFile mappedFile;
+            std::vector<uint8_t> buffer;
+            std::shared_ptr<const void> owner;
+            Span<const uint8_t> view;
+        };
+    } // namespace storage
+} // namespace ouzel
+
+#endif // OUZEL_STORAGE_FILEVIEW_HPP
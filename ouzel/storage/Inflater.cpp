@@ -0,0 +1,387 @@
+// Copyright 2015-2019 Elviss Strazdins. All rights reserved.
+
+#include <algorithm>
+#include <stdexcept>
+#include "Inflater.hpp"
+
+namespace ouzel
+{
+    namespace storage
+    {
+        namespace
+        {
+            constexpr uint32_t WINDOW_SIZE = 32768;
+
+            constexpr uint32_t END_OF_BLOCK = 256;
+            constexpr uint32_t MAX_LITERAL_CODES = 286;
+            constexpr uint32_t MAX_DISTANCE_CODES = 30;
+
+            constexpr uint16_t lengthBases[29] = {
+                3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+            };
+
+            constexpr uint8_t lengthExtraBits[29] = {
+                0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+            };
+
+            constexpr uint16_t distanceBases[30] = {
+                1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+                257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+            };
+
+            constexpr uint8_t distanceExtraBits[30] = {
+                0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+                7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+            };
+
+            // the order in which the lengths of the code length code are stored
+            constexpr uint8_t codeLengthOrder[19] = {
+                16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+            };
+
+            // the bits of the Huffman codes are packed starting from the most significant one
+            inline uint32_t reverseBits(uint32_t code, uint32_t length) noexcept
+            {
+                uint32_t result = 0;
+                for (uint32_t i = 0; i < length; ++i, code >>= 1)
+                    result = (result << 1) | (code & 1);
+                return result;
+            }
+        }
+
+        constexpr uint32_t Inflater::FAST_BITS;
+
+        void Inflater::Huffman::init(const uint8_t* lengths, uint32_t count)
+        {
+            std::fill(std::begin(counts), std::end(counts), static_cast<uint16_t>(0));
+            for (uint32_t symbol = 0; symbol < count; ++symbol)
+                ++counts[lengths[symbol]];
+            counts[0] = 0;
+
+            // incomplete codes are allowed (e.g. a single distance code), but not over-subscribed ones
+            int32_t left = 1;
+            for (uint32_t length = 1; length < 16; ++length)
+            {
+                left = (left << 1) - counts[length];
+                if (left < 0)
+                    throw std::runtime_error("Invalid Huffman code");
+            }
+
+            // symbols sorted by the length and then by the value of their codes
+            uint16_t offsets[16];
+            offsets[1] = 0;
+            for (uint32_t length = 1; length < 15; ++length)
+                offsets[length + 1] = static_cast<uint16_t>(offsets[length] + counts[length]);
+
+            for (uint32_t symbol = 0; symbol < count; ++symbol)
+                if (lengths[symbol] != 0)
+                    symbols[offsets[lengths[symbol]]++] = static_cast<uint16_t>(symbol);
+
+            std::fill(std::begin(fast), std::end(fast), static_cast<uint16_t>(0));
+
+            uint32_t code = 0;
+            uint32_t index = 0;
+            for (uint32_t length = 1; length <= FAST_BITS; ++length, code <<= 1)
+                for (uint32_t i = 0; i < counts[length]; ++i, ++code, ++index)
+                {
+                    const auto entry = static_cast<uint16_t>((length << 9) | symbols[index]);
+
+                    // every entry that starts with the code decodes to the symbol
+                    for (uint32_t bits = reverseBits(code, length); bits < (1U << FAST_BITS); bits += (1U << length))
+                        fast[bits] = entry;
+                }
+        }
+
+        Inflater::Inflater(Span<const uint8_t> initData):
+            data(initData),
+            window(WINDOW_SIZE)
+        {
+        }
+
+        size_t Inflater::inflate(uint8_t* destination, size_t size)
+        {
+            size_t produced = 0;
+
+            while (produced < size)
+            {
+                if (matchLength > 0)
+                {
+                    const auto count = static_cast<uint32_t>(std::min(static_cast<size_t>(matchLength), size - produced));
+
+                    for (uint32_t i = 0; i < count; ++i, ++windowPosition)
+                        destination[produced++] = window[windowPosition & (WINDOW_SIZE - 1)] =
+                            window[(windowPosition - matchDistance) & (WINDOW_SIZE - 1)];
+
+                    matchLength -= count;
+                    outputSize += count;
+                    continue;
+                }
+
+                switch (state)
+                {
+                    case State::BlockHeader:
+                        if (finalBlock)
+                            state = State::End;
+                        else
+                            readBlockHeader();
+                        break;
+
+                    case State::Stored:
+                    {
+                        if (storedRemaining == 0)
+                        {
+                            state = State::BlockHeader;
+                            break;
+                        }
+
+                        const auto count = static_cast<uint32_t>(std::min(static_cast<size_t>(storedRemaining), size - produced));
+
+                        if (data.size() - position < count)
+                            throw std::runtime_error("Unexpected end of data");
+
+                        const uint8_t* source = data.data() + position;
+                        std::copy(source, source + count, destination + produced);
+
+                        // only the last WINDOW_SIZE bytes can be referenced by the following blocks
+                        const uint32_t windowCount = std::min(count, WINDOW_SIZE);
+                        for (uint32_t i = count - windowCount; i < count;)
+                        {
+                            const uint32_t offset = (windowPosition + i) & (WINDOW_SIZE - 1);
+                            const uint32_t segment = std::min(count - i, WINDOW_SIZE - offset);
+                            std::copy(source + i, source + i + segment, window.begin() + offset);
+                            i += segment;
+                        }
+
+                        position += count;
+                        produced += count;
+                        windowPosition += count;
+                        storedRemaining -= count;
+                        outputSize += count;
+                        break;
+                    }
+
+                    case State::Compressed:
+                    {
+                        uint32_t symbol = decodeSymbol(literalCode);
+
+                        if (symbol < END_OF_BLOCK)
+                        {
+                            destination[produced++] = window[windowPosition++ & (WINDOW_SIZE - 1)] = static_cast<uint8_t>(symbol);
+                            ++outputSize;
+                        }
+                        else if (symbol == END_OF_BLOCK)
+                            state = State::BlockHeader;
+                        else
+                        {
+                            symbol -= END_OF_BLOCK + 1;
+                            if (symbol >= 29)
+                                throw std::runtime_error("Invalid length code");
+
+                            matchLength = lengthBases[symbol] + getBits(lengthExtraBits[symbol]);
+
+                            symbol = decodeSymbol(distanceCode);
+                            if (symbol >= MAX_DISTANCE_CODES)
+                                throw std::runtime_error("Invalid distance code");
+
+                            matchDistance = distanceBases[symbol] + getBits(distanceExtraBits[symbol]);
+
+                            if (matchDistance > outputSize)
+                                throw std::runtime_error("Invalid distance");
+                        }
+                        break;
+                    }
+
+                    case State::End:
+                        return produced;
+                }
+            }
+
+            return produced;
+        }
+
+        void Inflater::reset() noexcept
+        {
+            position = 0;
+            bitBuffer = 0;
+            bitCount = 0;
+            state = State::BlockHeader;
+            finalBlock = false;
+            storedRemaining = 0;
+            matchLength = 0;
+            matchDistance = 0;
+            windowPosition = 0;
+            outputSize = 0;
+        }
+
+        void Inflater::refill() noexcept
+        {
+            while (bitCount <= 56 && position < data.size())
+            {
+                bitBuffer |= static_cast<uint64_t>(data[position++]) << bitCount;
+                bitCount += 8;
+            }
+        }
+
+        uint32_t Inflater::getBits(uint32_t count)
+        {
+            if (bitCount < count)
+            {
+                refill();
+                if (bitCount < count)
+                    throw std::runtime_error("Unexpected end of data");
+            }
+
+            const auto result = static_cast<uint32_t>(bitBuffer & ((1ULL << count) - 1));
+            bitBuffer >>= count;
+            bitCount -= count;
+            return result;
+        }
+
+        uint32_t Inflater::decodeSymbol(const Huffman& huffman)
+        {
+            refill();
+
+            const uint16_t entry = huffman.fast[bitBuffer & ((1U << FAST_BITS) - 1)];
+            const uint32_t length = entry >> 9;
+
+            if (entry != 0 && length <= bitCount)
+            {
+                bitBuffer >>= length;
+                bitCount -= length;
+                return entry & 0x1FF;
+            }
+
+            // longer codes are decoded one bit at a time
+            int32_t code = 0;
+            int32_t first = 0;
+            int32_t index = 0;
+
+            for (uint32_t codeLength = 1; codeLength < 16; ++codeLength)
+            {
+                code |= static_cast<int32_t>(getBits(1));
+                const int32_t count = huffman.counts[codeLength];
+
+                if (code - count < first)
+                    return huffman.symbols[index + (code - first)];
+
+                index += count;
+                first = (first + count) << 1;
+                code <<= 1;
+            }
+
+            throw std::runtime_error("Invalid Huffman code");
+        }
+
+        void Inflater::readBlockHeader()
+        {
+            finalBlock = getBits(1) != 0;
+
+            switch (getBits(2))
+            {
+                case 0:
+                {
+                    // stored blocks start at a byte boundary, the whole bytes left in the bit buffer are read again
+                    getBits(bitCount & 7);
+                    position -= bitCount / 8;
+                    bitBuffer = 0;
+                    bitCount = 0;
+
+                    if (data.size() - position < 4)
+                        throw std::runtime_error("Unexpected end of data");
+
+                    const auto length = static_cast<uint32_t>(data[position] | (data[position + 1] << 8));
+                    const auto complement = static_cast<uint32_t>(data[position + 2] | (data[position + 3] << 8));
+                    position += 4;
+
+                    if (length != (~complement & 0xFFFF))
+                        throw std::runtime_error("Invalid stored block length");
+
+                    storedRemaining = length;
+                    state = State::Stored;
+                    break;
+                }
+                case 1:
+                {
+                    uint8_t lengths[288];
+                    std::fill(lengths, lengths + 144, static_cast<uint8_t>(8));
+                    std::fill(lengths + 144, lengths + 256, static_cast<uint8_t>(9));
+                    std::fill(lengths + 256, lengths + 280, static_cast<uint8_t>(7));
+                    std::fill(lengths + 280, lengths + 288, static_cast<uint8_t>(8));
+                    literalCode.init(lengths, 288);
+
+                    std::fill(lengths, lengths + MAX_DISTANCE_CODES, static_cast<uint8_t>(5));
+                    distanceCode.init(lengths, MAX_DISTANCE_CODES);
+
+                    state = State::Compressed;
+                    break;
+                }
+                case 2:
+                    readDynamicCodes();
+                    state = State::Compressed;
+                    break;
+                default:
+                    throw std::runtime_error("Invalid block type");
+            }
+        }
+
+        void Inflater::readDynamicCodes()
+        {
+            const uint32_t literalCount = getBits(5) + 257;
+            const uint32_t distanceCount = getBits(5) + 1;
+            const uint32_t codeLengthCount = getBits(4) + 4;
+
+            if (literalCount > MAX_LITERAL_CODES || distanceCount > MAX_DISTANCE_CODES)
+                throw std::runtime_error("Too many codes");
+
+            uint8_t lengths[MAX_LITERAL_CODES + MAX_DISTANCE_CODES] = {};
+
+            for (uint32_t i = 0; i < codeLengthCount; ++i)
+                lengths[codeLengthOrder[i]] = static_cast<uint8_t>(getBits(3));
+
+            Huffman codeLengthCode;
+            codeLengthCode.init(lengths, 19);
+
+            std::fill(std::begin(lengths), std::end(lengths), static_cast<uint8_t>(0));
+
+            for (uint32_t index = 0; index < literalCount + distanceCount;)
+            {
+                const uint32_t symbol = decodeSymbol(codeLengthCode);
+
+                if (symbol < 16)
+                    lengths[index++] = static_cast<uint8_t>(symbol);
+                else
+                {
+                    uint8_t length = 0;
+                    uint32_t repeat;
+
+                    if (symbol == 16)
+                    {
+                        if (index == 0)
+                            throw std::runtime_error("Invalid code length repeat");
+
+                        length = lengths[index - 1];
+                        repeat = 3 + getBits(2);
+                    }
+                    else if (symbol == 17)
+                        repeat = 3 + getBits(3);
+                    else
+                        repeat = 11 + getBits(7);
+
+                    if (index + repeat > literalCount + distanceCount)
+                        throw std::runtime_error("Invalid code length repeat");
+
+                    std::fill(lengths + index, lengths + index + repeat, length);
+                    index += repeat;
+                }
+            }
+
+            if (lengths[END_OF_BLOCK] == 0)
+                throw std::runtime_error("Missing end of block code");
+
+            literalCode.init(lengths, literalCount);
+            distanceCode.init(lengths + literalCount, distanceCount);
+        }
+    } // namespace storage
+} // namespace ouzel
@@ -0,0 +1,76 @@
+// Copyright 2015-2019 Elviss Strazdins. All rights reserved.
+
+#ifndef OUZEL_STORAGE_INFLATER_HPP
+#define OUZEL_STORAGE_INFLATER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "utils/Span.hpp"
+
+namespace ouzel
+{
+    namespace storage
+    {
+        // Decompresses a raw DEFLATE stream (RFC 1951) as the output is requested, only the last 32 KiB
+        // of the output are kept for the back-references
+        class Inflater final
+        {
+        public:
+            Inflater() = default;
+            explicit Inflater(Span<const uint8_t> initData);
+
+            // returns less than the requested size only at the end of the stream
+            size_t inflate(uint8_t* destination, size_t size);
+
+            // starts again from the beginning of the stream
+            void reset() noexcept;
+
+        private:
+            static constexpr uint32_t FAST_BITS = 9;
+
+            struct Huffman final
+            {
+                void init(const uint8_t* lengths, uint32_t count);
+
+                uint16_t counts[16];
+                uint16_t symbols[288];
+                uint16_t fast[1U << FAST_BITS]; // length << 9 | symbol of the codes that are at most FAST_BITS long
+            };
+
+            enum class State
+            {
+                BlockHeader,
+                Stored,
+                Compressed,
+                End
+            };
+
+            void refill() noexcept;
+            uint32_t getBits(uint32_t count);
+            uint32_t decodeSymbol(const Huffman& huffman);
+            void readBlockHeader();
+            void readDynamicCodes();
+
+            Span<const uint8_t> data;
+            size_t position = 0;
+            uint64_t bitBuffer = 0;
+            uint32_t bitCount = 0;
+
+            State state = State::BlockHeader;
+            bool finalBlock = false;
+            uint32_t storedRemaining = 0;
+            uint32_t matchLength = 0;
+            uint32_t matchDistance = 0;
+
+            std::vector<uint8_t> window;
+            uint32_t windowPosition = 0;
+            uint64_t outputSize = 0;
+
+            Huffman literalCode;
+            Huffman distanceCode;
+        };
+    } // namespace storage
+} // namespace ouzel
+
+#endif // OUZEL_STORAGE_INFLATER_HPP
@@ -0,0 +1,116 @@
+// Copyright 2015-2019 Elviss Strazdins. All rights reserved.
+
+#ifndef OUZEL_STORAGE_MAPPEDFILE_HPP
+#define OUZEL_STORAGE_MAPPEDFILE_HPP
+
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#if !defined(_WIN32)
+#  include <sys/mman.h>
+#endif
+
+#include "File.hpp"
+
+namespace ouzel
+{
+    namespace storage
+    {
+        // Read-only view of a whole file mapped into the address space
+        class MappedFile final
+        {
+        public:
+            MappedFile() noexcept = default;
+
+            explicit MappedFile(const std::string& filename)
+            {
+                const File file(filename, File::Mode::Read);
+                const uint64_t fileSize = file.getSize();
+
+                if (fileSize > std::numeric_limits<size_t>::max())
+                    throw std::runtime_error("File " + filename + " is too big to map");
+
+                size = static_cast<size_t>(fileSize);
+
+                // empty files can not be mapped
+                if (size == 0) return;
+
+#if defined(_WIN32)
+                const HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+                if (!mapping)
+                    throw std::system_error(GetLastError(), std::system_category(), "Failed to create file mapping");
+
+                address = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+                const DWORD error = GetLastError();
+
+                // the view keeps the mapping alive
+                CloseHandle(mapping);
+
+                if (!address)
+                    throw std::system_error(error, std::system_category(), "Failed to map file");
+#else
+                address = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+                if (address == MAP_FAILED)
+                    throw std::system_error(errno, std::system_category(), "Failed to map file");
+
+#  if !defined(__EMSCRIPTEN__)
+                // loaders read the whole file, so start paging it in right away
+                madvise(address, size, MADV_WILLNEED);
+#  endif
+#endif
+                // the mapping stays valid after the file is closed
+            }
+
+            ~MappedFile()
+            {
+                unmap();
+            }
+
+            MappedFile(const MappedFile&) = delete;
+            MappedFile& operator=(const MappedFile&) = delete;
+
+            MappedFile(MappedFile&& other) noexcept:
+                address(other.address),
+                size(other.size)
+            {
+                other.address = nullptr;
+                other.size = 0;
+            }
+
+            MappedFile& operator=(MappedFile&& other) noexcept
+            {
+                if (&other == this) return *this;
+
+                unmap();
+                address = other.address;
+                size = other.size;
+                other.address = nullptr;
+                other.size = 0;
+
+                return *this;
+            }
+
+            inline auto getData() const noexcept { return static_cast<const uint8_t*>(address); }
+            inline auto getSize() const noexcept { return size; }
+
+        private:
+            void unmap() noexcept
+            {
+                if (address)
+#if defined(_WIN32)
+                    UnmapViewOfFile(address);
+#else
+                    munmap(address, size);
+#endif
+            }
+
+            void* address = nullptr;
+            size_t size = 0;
+        };
+    } // namespace storage
+} // namespace ouzel
+
+#endif // OUZEL_STORAGE_MAPPEDFILE_HPP
@@ -0,0 +1,194 @@
+// Copyright 2015-2019 Elviss Strazdins. All rights reserved.
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include "Pack.hpp"
+#include "utils/Utils.hpp"
+
+namespace ouzel
+{
+    namespace storage
+    {
+        namespace
+        {
+            constexpr uint32_t SIGNATURE = 0x4B505A4F; // "OZPK"
+
+            constexpr size_t HEADER_SIZE = 16;
+            constexpr size_t ENTRY_HEADER_SIZE = 36;
+            constexpr size_t DATA_ALIGNMENT = 16;
+
+            constexpr uint32_t MIPMAPS_FLAG = 0x01;
+
+            constexpr size_t align(size_t offset)
+            {
+                return (offset + DATA_ALIGNMENT - 1) & ~(DATA_ALIGNMENT - 1);
+            }
+        }
+
+        constexpr uint32_t Pack::VERSION;
+
+        Pack::Pack(FileView&& initData):
+            data(std::make_shared<const FileView>(std::move(initData)))
+        {
+            const uint8_t* bytes = data->data();
+            const size_t size = data->size();
+
+            if (size < HEADER_SIZE ||
+                decodeLittleEndian<uint32_t>(bytes) != SIGNATURE)
+                throw std::runtime_error("Invalid pack");
+
+            if (decodeLittleEndian<uint32_t>(bytes + 4) != VERSION)
+                throw std::runtime_error("Unsupported pack version");
+
+            const auto entryCount = decodeLittleEndian<uint32_t>(bytes + 8);
+
+            entries.reserve(entryCount);
+            entryIndices.reserve(entryCount);
+            fileIndices.reserve(entryCount);
+
+            size_t offset = HEADER_SIZE;
+
+            for (uint32_t i = 0; i < entryCount; ++i)
+            {
+                if (size - offset < ENTRY_HEADER_SIZE)
+                    throw std::runtime_error("Invalid pack entry");
+
+                const uint8_t* header = bytes + offset;
+
+                Entry entry;
+                entry.type = decodeLittleEndian<uint32_t>(header);
+                entry.mipmaps = (decodeLittleEndian<uint32_t>(header + 4) & MIPMAPS_FLAG) != 0;
+                entry.hash = decodeLittleEndian<uint64_t>(header + 8);
+                entry.offset = decodeLittleEndian<uint64_t>(header + 16);
+                entry.size = decodeLittleEndian<uint64_t>(header + 24);
+                const auto nameLength = decodeLittleEndian<uint16_t>(header + 32);
+                const auto filenameLength = decodeLittleEndian<uint16_t>(header + 34);
+
+                offset += ENTRY_HEADER_SIZE;
+
+                if (size - offset < static_cast<size_t>(nameLength) + filenameLength)
+                    throw std::runtime_error("Invalid pack entry");
+
+                entry.name.assign(reinterpret_cast<const char*>(bytes + offset), nameLength);
+                offset += nameLength;
+                entry.filename.assign(reinterpret_cast<const char*>(bytes + offset), filenameLength);
+                offset += filenameLength;
+
+                if (entry.offset > size || entry.size > size - entry.offset)
+                    throw std::runtime_error("Invalid pack entry");
+
+                // the first entry of a file is the one that is read when the asset type is not known
+                fileIndices.insert(std::make_pair(entry.filename, entries.size()));
+                entryIndices.insert(std::make_pair(EntryKey{entry.filename, entry.type, entry.mipmaps}, entries.size()));
+                entries.push_back(std::move(entry));
+            }
+        }
+
+        std::vector<uint8_t> Pack::encode(const std::vector<Entry>& entries,
+                                          const std::vector<Span<const uint8_t>>& entryData)
+        {
+            if (entries.size() != entryData.size())
+                throw std::runtime_error("Invalid entry data");
+
+            if (entries.size() > std::numeric_limits<uint32_t>::max())
+                throw std::runtime_error("Too many entries");
+
+            size_t offset = HEADER_SIZE;
+
+            for (const Entry& entry : entries)
+            {
+                if (entry.name.length() > std::numeric_limits<uint16_t>::max() ||
+                    entry.filename.length() > std::numeric_limits<uint16_t>::max())
+                    throw std::runtime_error("Entry name is too long");
+
+                offset += ENTRY_HEADER_SIZE + entry.name.length() + entry.filename.length();
+            }
+
+            // data that is shared by several entries is stored once
+            std::vector<uint64_t> offsets(entries.size());
+
+            for (size_t i = 0; i < entryData.size(); ++i)
+            {
+                auto previous = std::find_if(entryData.begin(), entryData.begin() + static_cast<std::ptrdiff_t>(i),
+                                             [&data = entryData[i]](const Span<const uint8_t>& other) noexcept {
+                    return other.data() == data.data() && other.size() == data.size();
+                });
+
+                if (previous != entryData.begin() + static_cast<std::ptrdiff_t>(i))
+                    offsets[i] = offsets[static_cast<size_t>(previous - entryData.begin())];
+                else
+                {
+                    offset = align(offset);
+                    offsets[i] = offset;
+                    offset += entryData[i].size();
+                }
+            }
+
+            std::vector<uint8_t> result(offset);
+
+            encodeLittleEndian<uint32_t>(result.data(), SIGNATURE);
+            encodeLittleEndian<uint32_t>(result.data() + 4, VERSION);
+            encodeLittleEndian<uint32_t>(result.data() + 8, static_cast<uint32_t>(entries.size()));
+            encodeLittleEndian<uint32_t>(result.data() + 12, 0);
+
+            offset = HEADER_SIZE;
+
+            for (size_t i = 0; i < entries.size(); ++i)
+            {
+                const Entry& entry = entries[i];
+                uint8_t* header = result.data() + offset;
+
+                encodeLittleEndian<uint32_t>(header, entry.type);
+                encodeLittleEndian<uint32_t>(header + 4, entry.mipmaps ? MIPMAPS_FLAG : 0);
+                encodeLittleEndian<uint64_t>(header + 8, entry.hash);
+                encodeLittleEndian<uint64_t>(header + 16, offsets[i]);
+                encodeLittleEndian<uint64_t>(header + 24, entryData[i].size());
+                encodeLittleEndian<uint16_t>(header + 32, static_cast<uint16_t>(entry.name.length()));
+                encodeLittleEndian<uint16_t>(header + 34, static_cast<uint16_t>(entry.filename.length()));
+                offset += ENTRY_HEADER_SIZE;
+
+                std::copy(entry.name.begin(), entry.name.end(), result.begin() + static_cast<std::ptrdiff_t>(offset));
+                offset += entry.name.length();
+                std::copy(entry.filename.begin(), entry.filename.end(), result.begin() + static_cast<std::ptrdiff_t>(offset));
+                offset += entry.filename.length();
+
+                std::copy(entryData[i].begin(), entryData[i].end(),
+                          result.begin() + static_cast<std::ptrdiff_t>(offsets[i]));
+            }
+
+            return result;
+        }
+
+        std::vector<uint8_t> Pack::readFile(const std::string& filename) const
+        {
+            const Span<const uint8_t> entryData = getData(getEntry(filename));
+            return std::vector<uint8_t>(entryData.begin(), entryData.end());
+        }
+
+        FileView Pack::readFileView(const std::string& filename) const
+        {
+            return FileView(data, getData(getEntry(filename)));
+        }
+
+        FileView Pack::readFileView(const std::string& filename, uint32_t type, bool mipmaps) const
+        {
+            auto i = entryIndices.find(EntryKey{filename, type, mipmaps});
+
+            if (i == entryIndices.end())
+                throw std::runtime_error("File " + filename + " does not exist");
+
+            return FileView(data, getData(entries[i->second]));
+        }
+
+        const Pack::Entry& Pack::getEntry(const std::string& filename) const
+        {
+            auto i = fileIndices.find(filename);
+
+            if (i == fileIndices.end())
+                throw std::runtime_error("File " + filename + " does not exist");
+
+            return entries[i->second];
+        }
+    } // namespace storage
+} // namespace ouzel
@@ -0,0 +1,97 @@
+// Copyright 2015-2019 Elviss Strazdins. All rights reserved.
+
+#ifndef OUZEL_STORAGE_PACK_HPP
+#define OUZEL_STORAGE_PACK_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "storage/FileView.hpp"
+#include "utils/Span.hpp"
+
+namespace ouzel
+{
+    namespace storage
+    {
+        // Cooked assets packed into a single file, the entries refer directly to the data of the pack,
+        // so they can be read without copying them
+        class Pack final
+        {
+        public:
+            static constexpr uint32_t VERSION = 1;
+
+            struct Entry final
+            {
+                uint32_t type = 0;
+                bool mipmaps = true;
+                uint64_t hash = 0; // hash of the source file and the settings it was cooked with
+                std::string name;
+                std::string filename;
+                uint64_t offset = 0;
+                uint64_t size = 0;
+            };
+
+            Pack() = default;
+            explicit Pack(FileView&& initData);
+
+            // entries with the same data (same pointer) share it in the pack, the offsets are ignored
+            static std::vector<uint8_t> encode(const std::vector<Entry>& entries,
+                                               const std::vector<Span<const uint8_t>>& entryData);
+
+            // in the order they were cooked
+            inline auto& getEntries() const noexcept { return entries; }
+
+            bool fileExists(const std::string& filename) const
+            {
+                return fileIndices.find(filename) != fileIndices.end();
+            }
+
+            // a file can be cooked for several asset types or with different settings
+            bool fileExists(const std::string& filename, uint32_t type, bool mipmaps) const
+            {
+                return entryIndices.find(EntryKey{filename, type, mipmaps}) != entryIndices.end();
+            }
+
+            Span<const uint8_t> getData(const Entry& entry) const noexcept
+            {
+                return Span<const uint8_t>(data->data() + entry.offset, static_cast<size_t>(entry.size));
+            }
+
+            std::vector<uint8_t> readFile(const std::string& filename) const;
+            FileView readFileView(const std::string& filename) const;
+            FileView readFileView(const std::string& filename, uint32_t type, bool mipmaps) const;
+
+        private:
+            struct EntryKey final
+            {
+                std::string filename;
+                uint32_t type;
+                bool mipmaps;
+
+                bool operator==(const EntryKey& other) const noexcept
+                {
+                    return type == other.type && mipmaps == other.mipmaps && filename == other.filename;
+                }
+            };
+
+            struct EntryKeyHash final
+            {
+                size_t operator()(const EntryKey& key) const noexcept
+                {
+                    return std::hash<std::string>()(key.filename) ^ (static_cast<size_t>(key.type) << 1) ^ (key.mipmaps ? 1 : 0);
+                }
+            };
+
+            const Entry& getEntry(const std::string& filename) const;
+
+            std::shared_ptr<const FileView> data;
+            std::vector<Entry> entries;
+            std::unordered_map<EntryKey, size_t, EntryKeyHash> entryIndices;
+            std::unordered_map<std::string, size_t> fileIndices; // the first entry of each file
+        };
+    } // namespace storage
+} // namespace ouzel
+
+#endif // OUZEL_STORAGE_PACK_HPP
@@ -5,10 +5,14 @@
 
 #include <algorithm>
 #include <cmath>
-#include <map>
+#include <cstdint>
+#include <cstdlib>
+#include <iterator>
+#include <limits>
 #include <stdexcept>
 #include <string>
 #include <type_traits>
+#include <utility>
 #include <vector>
 #include "utils/Utf8.hpp"
 
@@ -41,10 +45,17 @@ namespace ouzel
         {
             constexpr uint8_t UTF8_BOM[] = {0xEF, 0xBB, 0xBF};
 
+            // powers of ten that are exactly representable as a double
+            constexpr double EXACT_POWERS_OF_TEN[] = {
+                1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+            };
+
             inline void encodeString(std::vector<uint8_t>& data,
-                                    const std::u32string& str)
+                                     const std::string& str)
             {
-                for (const char32_t c : str)
+                // multi-byte UTF-8 sequences never contain bytes that have to be escaped
+                for (const char c : str)
                 {
                     if (c == '"') data.insert(data.end(), {'\\', '"'});
                     else if (c == '\\') data.insert(data.end(), {'\\', '\\'});
@@ -54,238 +65,409 @@ namespace ouzel
                     else if (c == '\n') data.insert(data.end(), {'\\', 'n'});
                     else if (c == '\r') data.insert(data.end(), {'\\', 'r'});
                     else if (c == '\t') data.insert(data.end(), {'\\', 't'});
-                    else if (c <= 0x1F)
+                    else if (static_cast<uint8_t>(c) <= 0x1F)
                     {
-                        data.insert(data.end(), {'\\', 'u'});
+                        data.insert(data.end(), {'\\', 'u', '0', '0'});
 
                         constexpr char digits[] = "0123456789abcdef";
-                        for (uint32_t p = 0; p < 4; ++p)
-                            data.push_back(static_cast<uint8_t>(digits[(c >> (12 - p * 4)) & 0x0F]));
+                        data.push_back(static_cast<uint8_t>(digits[(c >> 4) & 0x0F]));
+                        data.push_back(static_cast<uint8_t>(digits[c & 0x0F]));
                     }
                     else
-                    {
-                        std::string encoded = utf8::fromUtf32(c);
-                        data.insert(data.end(), encoded.begin(), encoded.end());
-                    }
+                        data.push_back(static_cast<uint8_t>(c));
                 }
             }
 
-            struct Token final
+            // Single pass parser that reads the UTF-8 encoded bytes directly
+            template <class Iterator>
+            class Parser final
             {
-                enum class Type
+            public:
+                struct Number final
                 {
-                    LiteralInteger, // integer
-                    LiteralFloat, // float
-                    LiteralString, // string
-                    KeywordTrue, // true
-                    KeywordFalse, // false
-                    KeywordNull, // null
-                    LeftBrace, // {
-                    RightBrace, // }
-                    LeftBracket, // [
-                    RightBracket, // ]
-                    Comma, // ,
-                    Colon // :
+                    bool isFloat = false;
+                    int64_t intValue = 0;
+                    double doubleValue = 0.0;
                 };
 
-                Type type;
-                std::u32string value;
-            };
+                Parser(Iterator initIterator, Iterator initEnd):
+                    iterator(initIterator), end(initEnd)
+                {
+                }
 
-            inline std::vector<Token> tokenize(const std::u32string& str)
-            {
-                std::vector<Token> tokens;
+                // returns the first character of the next token, a null character also ends the data
+                uint8_t peek()
+                {
+                    while (iterator != end)
+                    {
+                        const auto c = static_cast<uint8_t>(*iterator);
 
-                static const std::map<std::u32string, Token::Type> keywordMap{
-                    {{'t', 'r', 'u', 'e'}, Token::Type::KeywordTrue},
-                    {{'f', 'a', 'l', 's', 'e'}, Token::Type::KeywordFalse},
-                    {{'n', 'u', 'l', 'l'}, Token::Type::KeywordNull}
-                };
+                        if (c == ' ' || c == '\t' || c == '\r' || c == '\n')
+                            ++iterator;
+                        else if (c == '\0')
+                            break;
+                        else
+                            return c;
+                    }
 
-                // tokenize
-                for (auto iterator = str.cbegin(); iterator != str.cend();)
+                    throw ParseError("Unexpected end of data");
+                }
+
+                bool skip(char c)
                 {
-                    Token token;
+                    if (peek() != static_cast<uint8_t>(c)) return false;
+                    ++iterator;
+                    return true;
+                }
 
-                    if (*iterator == '-' ||
-                        (*iterator >= '0' && *iterator <= '9'))
-                    {
-                        token.type = Token::Type::LiteralInteger;
+                void expect(char c, const char* error)
+                {
+                    if (!skip(c)) throw ParseError(error);
+                }
 
-                        if (*iterator == '-')
-                        {
-                            token.value.push_back(*iterator);
-                            if (++iterator == str.cend() ||
-                                *iterator < '0' || *iterator > '9')
-                                throw ParseError("Invalid number");
-                        }
+                void parseString(std::string& result)
+                {
+                    expect('"', "Expected a string literal");
 
-                        while (iterator != str.cend() &&
-                            (*iterator >= '0' && *iterator <= '9'))
-                        {
-                            token.value.push_back(*iterator);
+                    result.clear();
+
+                    for (;;)
+                    {
+                        // copy the characters up to the next quote or escape at once
+                        Iterator start = iterator;
+                        while (iterator != end &&
+                               static_cast<uint8_t>(*iterator) > 0x1F &&
+                               *iterator != '"' &&
+                               *iterator != '\\')
                             ++iterator;
-                        }
 
-                        if (iterator != str.cend() && *iterator == '.')
-                        {
-                            token.type = Token::Type::LiteralFloat;
+                        result.append(start, iterator);
 
-                            token.value.push_back(*iterator);
-                            ++iterator;
+                        if (iterator == end)
+                            throw ParseError("Unterminated string literal");
 
-                            while (iterator != str.cend() &&
-                                (*iterator >= '0' && *iterator <= '9'))
-                            {
-                                token.value.push_back(*iterator);
-                                ++iterator;
-                            }
-                        }
+                        const auto c = static_cast<uint8_t>(*iterator++);
 
-                        // parse exponent
-                        if (iterator != str.cend() &&
-                            (*iterator == 'e' || *iterator == 'E'))
+                        if (c == '"')
+                            break;
+                        else if (c == '\\')
                         {
-                            token.value.push_back(*iterator);
+                            if (iterator == end)
+                                throw ParseError("Unterminated string literal");
 
-                            if (++iterator == str.cend())
-                                throw ParseError("Invalid exponent");
+                            switch (*iterator++)
+                            {
+                                case '"': result.push_back('"'); break;
+                                case '\\': result.push_back('\\'); break;
+                                case '/': result.push_back('/'); break;
+                                case 'b': result.push_back('\b'); break;
+                                case 'f': result.push_back('\f'); break;
+                                case 'n': result.push_back('\n'); break;
+                                case 'r': result.push_back('\r'); break;
+                                case 't': result.push_back('\t'); break;
+                                case 'u':
+                                {
+                                    char32_t code = parseCodeUnit();
 
-                            if (*iterator == '+' || *iterator == '-')
-                                token.value.push_back(*iterator);
+                                    // characters outside of the BMP are encoded as surrogate pairs
+                                    if (code >= 0xD800 && code <= 0xDBFF &&
+                                        iterator != end && *iterator == '\\')
+                                    {
+                                        Iterator next = iterator;
+                                        if (++next != end && *next == 'u')
+                                        {
+                                            iterator = ++next;
+                                            const char32_t low = parseCodeUnit();
 
-                            if (++iterator == str.cend() || *iterator < '0' || *iterator > '9')
-                                throw ParseError("Invalid exponent");
+                                            if (low < 0xDC00 || low > 0xDFFF)
+                                                throw ParseError("Invalid surrogate pair");
 
-                            while (iterator != str.cend() &&
-                                (*iterator >= '0' && *iterator <= '9'))
-                            {
-                                token.value.push_back(*iterator);
-                                ++iterator;
+                                            code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                                        }
+                                    }
+
+                                    result += utf8::fromUtf32(code);
+                                    break;
+                                }
+                                default:
+                                    throw ParseError("Unrecognized escape character");
                             }
                         }
+                        else // control char
+                            throw ParseError("Unterminated string literal");
                     }
-                    else if (*iterator == '"') // string literal
-                    {
-                        token.type = Token::Type::LiteralString;
+                }
 
-                        for (;;)
+                Number parseNumber()
+                {
+                    Number result;
+                    const Iterator start = iterator;
+
+                    const bool negative = (iterator != end && *iterator == '-');
+                    if (negative) ++iterator;
+
+                    if (iterator == end || !isDigit(*iterator))
+                        throw ParseError("Invalid number");
+
+                    // the first 19 significant digits are accumulated exactly
+                    uint64_t mantissa = 0;
+                    int32_t exponent = 0;
+                    bool truncated = false;
+
+                    for (; iterator != end && isDigit(*iterator); ++iterator)
+                        if (mantissa < 1000000000000000000U)
+                            mantissa = mantissa * 10 + static_cast<uint8_t>(*iterator - '0');
+                        else
                         {
-                            if (++iterator == str.cend())
-                                throw ParseError("Unterminated string literal");
+                            ++exponent;
+                            truncated = true;
+                        }
 
-                            if (*iterator == '"')
+                    if (iterator != end && *iterator == '.')
+                    {
+                        result.isFloat = true;
+                        ++iterator;
+
+                        for (; iterator != end && isDigit(*iterator); ++iterator)
+                            if (mantissa < 1000000000000000000U)
                             {
-                                ++iterator;
-                                break;
+                                mantissa = mantissa * 10 + static_cast<uint8_t>(*iterator - '0');
+                                --exponent;
                             }
-                            else if (*iterator == '\\')
-                            {
-                                if (++iterator == str.cend())
-                                    throw ParseError("Unterminated string literal");
+                            else
+                                truncated = true;
+                    }
 
-                                switch (*iterator)
-                                {
-                                    case '"': token.value.push_back('"'); break;
-                                    case '\\': token.value.push_back('\\'); break;
-                                    case '/': token.value.push_back('/'); break;
-                                    case 'b': token.value.push_back('\b'); break;
-                                    case 'f': token.value.push_back('\f'); break;
-                                    case 'n': token.value.push_back('\n'); break;
-                                    case 'r': token.value.push_back('\r'); break;
-                                    case 't': token.value.push_back('\t'); break;
-                                    case 'u':
-                                    {
-                                        char32_t c = 0;
+                    if (iterator != end && (*iterator == 'e' || *iterator == 'E'))
+                    {
+                        result.isFloat = true;
 
-                                        for (uint32_t i = 0; i < 4; ++i, ++iterator)
-                                        {
-                                            if (iterator == str.cend())
-                                                throw ParseError("Unexpected end of data");
+                        if (++iterator == end)
+                            throw ParseError("Invalid exponent");
 
-                                            uint8_t code = 0;
+                        const bool negativeExponent = (*iterator == '-');
+                        if (*iterator == '+' || *iterator == '-') ++iterator;
 
-                                            if (*iterator >= '0' && *iterator <= '9') code = static_cast<uint8_t>(*iterator) - '0';
-                                            else if (*iterator >= 'a' && *iterator <='f') code = static_cast<uint8_t>(*iterator) - 'a' + 10;
-                                            else if (*iterator >= 'A' && *iterator <='F') code = static_cast<uint8_t>(*iterator) - 'A' + 10;
-                                            else
-                                                throw ParseError("Invalid character code");
+                        if (iterator == end || !isDigit(*iterator))
+                            throw ParseError("Invalid exponent");
 
-                                            c = (c << 4) | code;
-                                        }
+                        int32_t exponentValue = 0;
+                        for (; iterator != end && isDigit(*iterator); ++iterator)
+                            if (exponentValue < 100000)
+                                exponentValue = exponentValue * 10 + (*iterator - '0');
 
-                                        token.value.push_back(c);
-                                        break;
-                                    }
-                                    default:
-                                        throw ParseError("Unrecognized escape character");
-                                }
-                            }
-                            else if (*iterator <= 0x1F) // control char
-                                throw ParseError("Unterminated string literal");
-                            else
-                                token.value.push_back(*iterator);
-                        }
+                        exponent += negativeExponent ? -exponentValue : exponentValue;
                     }
-                    else if ((*iterator >= 'a' && *iterator <= 'z') ||
-                            (*iterator >= 'A' && *iterator <= 'Z') ||
-                            *iterator == '_')
+
+                    if (!result.isFloat && !truncated &&
+                        mantissa <= static_cast<uint64_t>(std::numeric_limits<int64_t>::max()) + (negative ? 1 : 0))
                     {
-                        while (iterator != str.cend() &&
-                            ((*iterator >= 'a' && *iterator <= 'z') ||
-                                (*iterator >= 'A' && *iterator <= 'Z') ||
-                                *iterator == '_' ||
-                                (*iterator >= '0' && *iterator <= '9')))
-                        {
-                            token.value.push_back(*iterator);
-                            ++iterator;
-                        }
+                        result.intValue = negative ?
+                            static_cast<int64_t>(0 - mantissa) :
+                            static_cast<int64_t>(mantissa);
+                        result.doubleValue = static_cast<double>(result.intValue);
+                        return result;
+                    }
 
-                        auto keywordIterator = keywordMap.find(token.value);
+                    result.isFloat = true;
 
-                        if (keywordIterator != keywordMap.end())
-                            token.type = keywordIterator->second;
-                        else
-                            throw ParseError("Unknown keyword " + utf8::fromUtf32(token.value));
-                    }
-                    else if (*iterator == ' ' ||
-                            *iterator == '\t' ||
-                            *iterator == '\r' ||
-                            *iterator == '\n') // whitespace or newline
+                    // both the mantissa and the power of ten are exact, so a single operation rounds correctly
+                    if (!truncated && mantissa <= (1ULL << 53) && exponent >= -22 && exponent <= 22)
                     {
-                        ++iterator;
-                        continue;
+                        const auto value = static_cast<double>(mantissa);
+                        result.doubleValue = (exponent < 0) ?
+                            value / EXACT_POWERS_OF_TEN[-exponent] :
+                            value * EXACT_POWERS_OF_TEN[exponent];
+                        if (negative) result.doubleValue = -result.doubleValue;
                     }
-                    else if (*iterator == '\0')
-                        break;
                     else
+                        result.doubleValue = std::strtod(std::string(start, iterator).c_str(), nullptr);
+
+                    return result;
+                }
+
+                bool parseBoolean()
+                {
+                    if (parseKeyword("true")) return true;
+                    else if (parseKeyword("false")) return false;
+                    else throw ParseError("Unknown keyword");
+                }
+
+                void parseNull()
+                {
+                    if (!parseKeyword("null"))
+                        throw ParseError("Unknown keyword");
+                }
+
+                template <class Handler>
+                void parse(Handler& handler)
+                {
+                    switch (peek())
                     {
-                        switch (*iterator)
+                        case '{':
                         {
-                            case '{': token.type = Token::Type::LeftBrace; break;
-                            case '}': token.type = Token::Type::RightBrace; break;
-                            case '[': token.type = Token::Type::LeftBracket; break;
-                            case ']': token.type = Token::Type::RightBracket; break;
-                            case ',': token.type = Token::Type::Comma; break;
-                            case ':': token.type = Token::Type::Colon; break;
-                            default: throw ParseError("Unknown character");
+                            ++iterator;
+                            handler.startObject();
+
+                            if (!skip('}'))
+                            {
+                                do
+                                {
+                                    parseString(buffer);
+                                    handler.key(buffer);
+                                    expect(':', "Expected a colon");
+                                    parse(handler);
+                                }
+                                while (skip(','));
+
+                                expect('}', "Expected a right brace");
+                            }
+
+                            handler.endObject();
+                            break;
                         }
+                        case '[':
+                        {
+                            ++iterator;
+                            handler.startArray();
 
-                        ++iterator;
+                            if (!skip(']'))
+                            {
+                                do parse(handler);
+                                while (skip(','));
+
+                                expect(']', "Expected a right bracket");
+                            }
+
+                            handler.endArray();
+                            break;
+                        }
+                        case '"':
+                            parseString(buffer);
+                            handler.string(buffer);
+                            break;
+                        case 't':
+                        case 'f':
+                            handler.boolean(parseBoolean());
+                            break;
+                        case 'n':
+                            parseNull();
+                            handler.null();
+                            break;
+                        default:
+                        {
+                            const Number number = parseNumber();
+                            if (number.isFloat)
+                                handler.floatingPoint(number.doubleValue);
+                            else
+                                handler.integer(number.intValue);
+                        }
                     }
+                }
 
-                    tokens.push_back(token);
+            private:
+                static constexpr bool isDigit(int c) noexcept
+                {
+                    return c >= '0' && c <= '9';
                 }
 
-                return tokens;
+                char32_t parseCodeUnit()
+                {
+                    char32_t c = 0;
+
+                    for (uint32_t i = 0; i < 4; ++i, ++iterator)
+                    {
+                        if (iterator == end)
+                            throw ParseError("Unexpected end of data");
+
+                        uint8_t code = 0;
+
+                        if (*iterator >= '0' && *iterator <= '9') code = static_cast<uint8_t>(*iterator) - '0';
+                        else if (*iterator >= 'a' && *iterator <='f') code = static_cast<uint8_t>(*iterator) - 'a' + 10;
+                        else if (*iterator >= 'A' && *iterator <='F') code = static_cast<uint8_t>(*iterator) - 'A' + 10;
+                        else
+                            throw ParseError("Invalid character code");
+
+                        c = (c << 4) | code;
+                    }
+
+                    return c;
+                }
+
+                bool parseKeyword(const char* keyword)
+                {
+                    Iterator i = iterator;
+
+                    for (; *keyword; ++keyword, ++i)
+                        if (i == end || *i != *keyword) return false;
+
+                    // keywords must not be followed by other identifier characters
+                    if (i != end &&
+                        ((*i >= 'a' && *i <= 'z') ||
+                         (*i >= 'A' && *i <= 'Z') ||
+                         *i == '_' ||
+                         isDigit(*i)))
+                        return false;
+
+                    iterator = i;
+                    return true;
+                }
+
+                Iterator iterator;
+                Iterator end;
+                std::string buffer; // reused for the strings passed to the handler
+            };
+
+            template <class T>
+            auto skipBom(const T& data, bool& bom)
+            {
+                auto begin = std::begin(data);
+
+                bom = std::distance(std::begin(data), std::end(data)) >= 3 &&
+                    std::equal(std::begin(data), std::begin(data) + 3,
+                               std::begin(UTF8_BOM));
+
+                if (bom) begin += 3;
+
+                return begin;
             }
         }
 
+        // Receives the values of a document that is parsed without building a DOM. The parser calls
+        // the handler's methods directly, so a derived class needs to hide only the ones it uses.
+        class Handler
+        {
+        public:
+            void startObject() {}
+            void key(const std::string&) {}
+            void endObject() {}
+            void startArray() {}
+            void endArray() {}
+            void null() {}
+            void boolean(bool) {}
+            void integer(int64_t) {}
+            void floatingPoint(double) {}
+            void string(const std::string&) {}
+        };
+
+        template <class T, class Handler>
+        void parse(const T& data, Handler& handler)
+        {
+            bool bom;
+            auto begin = skipBom(data, bom);
+
+            Parser<decltype(begin)> parser(begin, std::end(data));
+            parser.parse(handler);
+        }
+
         class Value
         {
         public:
+            // the containers use the heap on purpose: the vectors grow while the document is parsed, and an arena
+            // can not reuse the storage that they leave behind, so parsing into an arena was slower than the heap
             using Array = std::vector<Value>;
-            using Object = std::map<std::string, Value>;
+            // members are kept sorted by their key
+            using Object = std::vector<std::pair<std::string, Value>>;
 
             enum class Type
             {
@@ -325,7 +507,7 @@ namespace ouzel
             Value(const T& value): type(Type::Array), arrayValue(value) {}
 
             template <typename T, typename std::enable_if<std::is_same<T, Object>::value>::type* = nullptr>
-            Value(const T& value): type(Type::Object), objectValue(value) {}
+            Value(const T& value): type(Type::Object), objectValue(value) { sortMembers(); }
 
             template <typename T, typename std::enable_if<std::is_same<T, Type>::value>::type* = nullptr>
             inline Value& operator=(const T newType) noexcept
@@ -395,6 +577,7 @@ namespace ouzel
             {
                 type = Type::Object;
                 objectValue = value;
+                sortMembers();
                 return *this;
             }
 
@@ -501,20 +684,26 @@ namespace ouzel
             inline auto hasMember(const std::string& member) const
             {
                 if (type != Type::Object) throw TypeError("Wrong type");
-                return objectValue.find(member) != objectValue.end();
+                return findMember(member) != objectValue.end();
             }
 
             inline Value& operator[](const std::string& member)
             {
                 type = Type::Object;
-                return objectValue[member];
+
+                auto i = std::lower_bound(objectValue.begin(), objectValue.end(), member,
+                                          [](const Object::value_type& a, const std::string& b) { return a.first < b; });
+                if (i == objectValue.end() || i->first != member)
+                    i = objectValue.emplace(i, member, Value());
+
+                return i->second;
             }
 
             inline const Value& operator[](const std::string& member) const
             {
                 if (type != Type::Object) throw TypeError("Wrong type");
 
-                auto i = objectValue.find(member);
+                auto i = findMember(member);
                 if (i != objectValue.end())
                     return i->second;
                 else
@@ -545,156 +734,89 @@ namespace ouzel
             }
 
         protected:
-            template <class TokenIterator>
-            void parseValue(TokenIterator& iterator,
-                            TokenIterator end)
+            template <class Iterator>
+            void parseValue(Parser<Iterator>& parser)
             {
-                if (iterator == end)
-                    throw ParseError("Unexpected end of data");
-
-                if (iterator->type == Token::Type::LeftBrace)
-                    return parseObject(iterator, end);
-                else if (iterator->type == Token::Type::LeftBracket)
-                    return parseArray(iterator, end);
-                else if (iterator->type == Token::Type::LiteralInteger)
-                {
-                    type = Type::Integer;
-                    intValue = std::stoll(utf8::fromUtf32(iterator->value));
-                    ++iterator;
-                }
-                else if (iterator->type == Token::Type::LiteralFloat)
-                {
-                    type = Type::Float;
-                    doubleValue = std::stod(utf8::fromUtf32(iterator->value));
-                    ++iterator;
-                }
-                else if (iterator->type == Token::Type::LiteralString)
-                {
-                    type = Type::String;
-                    stringValue = utf8::fromUtf32(iterator->value);
-                    ++iterator;
-                }
-                else if (iterator->type == Token::Type::KeywordTrue ||
-                         iterator->type == Token::Type::KeywordFalse)
+                switch (parser.peek())
                 {
-                    type = Type::Boolean;
-                    boolValue = (iterator->type == Token::Type::KeywordTrue);
-                    ++iterator;
-                }
-                else if (iterator->type == Token::Type::KeywordNull)
-                {
-                    type = Type::Null;
-                    ++iterator;
-                }
-                else
-                    throw ParseError("Expected a value");
-            }
-
-            template <class TokenIterator>
-            void parseObject(TokenIterator& iterator,
-                             TokenIterator end)
-            {
-                if (iterator == end)
-                    throw ParseError("Unexpected end of data");
+                    case '{':
+                    {
+                        parser.skip('{');
+                        type = Type::Object;
+                        objectValue.clear();
 
-                if (iterator->type != Token::Type::LeftBrace)
-                    throw ParseError("Expected a left brace");
+                        if (!parser.skip('}'))
+                        {
+                            // the members are parsed in place and sorted once the object is complete
+                            do
+                            {
+                                objectValue.emplace_back();
+                                auto& member = objectValue.back();
+                                parser.parseString(member.first);
+                                parser.expect(':', "Expected a colon");
+                                member.second.parseValue(parser);
+                            }
+                            while (parser.skip(','));
 
-                ++iterator; // skip the left brace
+                            parser.expect('}', "Expected a right brace");
 
-                bool first = true;
+                            std::sort(objectValue.begin(), objectValue.end(),
+                                      [](const Object::value_type& a, const Object::value_type& b) { return a.first < b.first; });
 
-                for (;;)
-                {
-                    if (iterator == end)
-                        throw ParseError("Unexpected end of data");
-
-                    if (iterator->type == Token::Type::RightBrace)
-                    {
-                        ++iterator;// skip the right brace
+                            auto duplicate = std::adjacent_find(objectValue.begin(), objectValue.end(),
+                                                                [](const Object::value_type& a, const Object::value_type& b) { return a.first == b.first; });
+                            if (duplicate != objectValue.end())
+                                throw ParseError("Duplicate key value " + duplicate->first);
+                        }
                         break;
                     }
-
-                    if (first)
-                        first = false;
-                    else
+                    case '[':
                     {
-                        if (iterator->type != Token::Type::Comma)
-                            throw ParseError("Expected a comma");
-
-                        if (++iterator == end)
-                            throw ParseError("Unexpected end of data");
-                    }
-
-                    if (iterator->type != Token::Type::LiteralString)
-                        throw ParseError("Expected a string literal");
-
-                    std::string key = utf8::fromUtf32(iterator->value);
-
-                    if (objectValue.find(key) != objectValue.end())
-                        throw ParseError("Duplicate key value " + key);
-
-                    if (++iterator == end)
-                        throw ParseError("Unexpected end of data");
-
-                    if (iterator->type != Token::Type::Colon)
-                        throw ParseError("Expected a colon");
-
-                    if (++iterator == end)
-                        throw ParseError("Unexpected end of data");
-
-                    Value value;
-                    value.parseValue(iterator, end);
-
-                    objectValue[key] = value;
-                }
-
-                type = Type::Object;
-            }
-
-            template <class TokenIterator>
-            void parseArray(TokenIterator& iterator,
-                            TokenIterator end)
-            {
-                if (iterator == end)
-                    throw ParseError("Unexpected end of data");
-
-                if (iterator->type != Token::Type::LeftBracket)
-                    throw ParseError("Expected a left bracket");
-
-                ++iterator; // skip the left bracket
+                        parser.skip('[');
+                        type = Type::Array;
+                        arrayValue.clear();
 
-                bool first = true;
-
-                for (;;)
-                {
-                    if (iterator == end)
-                        throw ParseError("Unexpected end of data");
+                        if (!parser.skip(']'))
+                        {
+                            do
+                            {
+                                arrayValue.emplace_back();
+                                arrayValue.back().parseValue(parser);
+                            }
+                            while (parser.skip(','));
 
-                    if (iterator->type == Token::Type::RightBracket)
-                    {
-                        ++iterator;// skip the right bracket
+                            parser.expect(']', "Expected a right bracket");
+                        }
                         break;
                     }
-
-                    if (first)
-                        first = false;
-                    else
+                    case '"':
+                        type = Type::String;
+                        parser.parseString(stringValue);
+                        break;
+                    case 't':
+                    case 'f':
+                        type = Type::Boolean;
+                        boolValue = parser.parseBoolean();
+                        break;
+                    case 'n':
+                        parser.parseNull();
+                        type = Type::Null;
+                        break;
+                    default:
                     {
-                        if (iterator->type != Token::Type::Comma)
-                            throw ParseError("Expected a comma");
-
-                        if (++iterator == end)
-                            throw ParseError("Unexpected end of data");
+                        const auto number = parser.parseNumber();
+                        if (number.isFloat)
+                        {
+                            type = Type::Float;
+                            doubleValue = number.doubleValue;
+                        }
+                        else
+                        {
+                            type = Type::Integer;
+                            intValue = number.intValue;
+                        }
                     }
-
-                    Value value;
-                    value.parseValue(iterator, end);
-
-                    arrayValue.push_back(value);
                 }
-
-                type = Type::Array;
             }
 
             void encodeValue(std::vector<uint8_t>& data) const
@@ -720,7 +842,7 @@ namespace ouzel
                     }
                     case Type::String:
                         data.push_back('"');
-                        encodeString(data, utf8::toUtf32(stringValue));
+                        encodeString(data, stringValue);
                         data.push_back('"');
                         break;
                     case Type::Object:
@@ -735,7 +857,7 @@ namespace ouzel
                             else data.push_back(',');
 
                             data.push_back('"');
-                            encodeString(data, utf8::toUtf32(value.first));
+                            encodeString(data, value.first);
                             data.insert(data.end(), {'"', ':'});
                             value.second.encodeValue(data);
                         }
@@ -770,6 +892,24 @@ namespace ouzel
             }
 
         private:
+            Object::const_iterator findMember(const std::string& member) const
+            {
+                auto i = std::lower_bound(objectValue.begin(), objectValue.end(), member,
+                                          [](const Object::value_type& a, const std::string& b) { return a.first < b; });
+                return (i != objectValue.end() && i->first == member) ? i : objectValue.end();
+            }
+
+            void sortMembers()
+            {
+                std::stable_sort(objectValue.begin(), objectValue.end(),
+                                 [](const Object::value_type& a, const Object::value_type& b) { return a.first < b.first; });
+
+                // like with a map, the first of the duplicate members is kept
+                objectValue.erase(std::unique(objectValue.begin(), objectValue.end(),
+                                              [](const Object::value_type& a, const Object::value_type& b) { return a.first == b.first; }),
+                                  objectValue.end());
+            }
+
             Type type = Type::Object;
             union
             {
@@ -790,27 +930,10 @@ namespace ouzel
             template <class T>
             explicit Data(const T& data)
             {
-                std::u32string str;
-
-                // BOM
-                if (std::distance(std::begin(data), std::end(data)) >= 3 &&
-                    std::equal(std::begin(data), std::begin(data) + 3,
-                               std::begin(UTF8_BOM)))
-                {
-                    bom = true;
-                    str = utf8::toUtf32(std::begin(data) + 3, std::end(data));
-                }
-                else
-                {
-                    bom = false;
-                    str = utf8::toUtf32(data);
-                }
-
-                std::vector<Token> tokens = tokenize(str);
-
-                auto iterator = tokens.cbegin();
+                auto begin = skipBom(data, bom);
 
-                parseValue(iterator, tokens.cend());
+                Parser<decltype(begin)> parser(begin, std::end(data));
+                parseValue(parser);
             }
 
             std::vector<uint8_t> encode() const
@@ -9,6 +9,9 @@
 #elif TARGET_OS_IOS || TARGET_OS_TV
 #  include <sys/syslog.h>
 #elif TARGET_OS_MAC || defined(__linux__)
+#  include <cerrno>
+#  include <climits>
+#  include <sys/uio.h>
 #  include <unistd.h>
 #elif defined(_WIN32)
 #  pragma push_macro("WIN32_LEAN_AND_MEAN")
@@ -27,14 +30,370 @@
 #  include <emscripten.h>
 #endif
 
+#include <algorithm>
+#include <chrono>
 #include "Log.hpp"
+#include "SpscQueue.hpp"
 
 namespace ouzel
 {
+    namespace
+    {
+        // part of a formatted line, either in the log buffer or, if data is null, in the scratch string
+        struct Segment final
+        {
+            const char* data;
+            size_t offset;
+            size_t length;
+        };
+
+        struct Line final
+        {
+            Log::Level level;
+            size_t firstSegment;
+            size_t segmentCount;
+        };
+
+        template <typename T>
+        const uint8_t* read(const uint8_t* data, T& value) noexcept
+        {
+            memcpy(&value, data, sizeof(value));
+            return data + sizeof(value);
+        }
+
+        void appendScratch(std::string& scratch, std::vector<Segment>& segments, const std::string& str)
+        {
+            segments.push_back(Segment{nullptr, scratch.size(), str.length()});
+            scratch += str;
+        }
+
+        void formatArguments(const uint8_t* data, size_t size, std::string& scratch, std::vector<Segment>& segments)
+        {
+            constexpr char digits[] = "0123456789abcdef";
+
+            const uint8_t* end = data + size;
+
+            while (data != end)
+            {
+                Log::Argument argument;
+                data = read(data, argument);
+
+                switch (argument)
+                {
+                    case Log::Argument::Boolean:
+                    {
+                        uint8_t value;
+                        data = read(data, value);
+                        segments.push_back(value ? Segment{"true", 0, 4} : Segment{"false", 0, 5});
+                        break;
+                    }
+                    case Log::Argument::Hex:
+                    {
+                        uint8_t value;
+                        data = read(data, value);
+
+                        segments.push_back(Segment{nullptr, scratch.size(), 2});
+                        for (uint32_t p = 0; p < 2; ++p)
+                            scratch.push_back(digits[(value >> (4 - p * 4)) & 0x0F]);
+                        break;
+                    }
+                    case Log::Argument::Integer:
+                    {
+                        int64_t value;
+                        data = read(data, value);
+                        appendScratch(scratch, segments, std::to_string(value));
+                        break;
+                    }
+                    case Log::Argument::UnsignedInteger:
+                    {
+                        uint64_t value;
+                        data = read(data, value);
+                        appendScratch(scratch, segments, std::to_string(value));
+                        break;
+                    }
+                    case Log::Argument::FloatingPoint:
+                    {
+                        double value;
+                        data = read(data, value);
+                        appendScratch(scratch, segments, std::to_string(value));
+                        break;
+                    }
+                    case Log::Argument::String:
+                    {
+                        uint32_t length;
+                        data = read(data, length);
+                        segments.push_back(Segment{reinterpret_cast<const char*>(data), 0, length});
+                        data += length;
+                        break;
+                    }
+                    case Log::Argument::Pointer:
+                    {
+                        uintptr_t value;
+                        data = read(data, value);
+
+                        segments.push_back(Segment{nullptr, scratch.size(), sizeof(value) * 2});
+                        for (size_t i = 0; i < sizeof(value) * 2; ++i)
+                            scratch.push_back(digits[(value >> (sizeof(value) * 2 - i - 1) * 4) & 0x0F]);
+                        break;
+                    }
+                    default:
+                        return;
+                }
+            }
+        }
+
+        inline const char* getSegmentData(const Segment& segment, const std::string& scratch) noexcept
+        {
+            return segment.data ? segment.data : scratch.data() + segment.offset;
+        }
+
+#if defined(__EMSCRIPTEN__) || defined(__ANDROID__) || TARGET_OS_IOS || TARGET_OS_TV || !(TARGET_OS_MAC || defined(__linux__))
+        std::string getLineString(const Line& line, const std::vector<Segment>& segments, const std::string& scratch)
+        {
+            std::string result;
+
+            for (size_t i = line.firstSegment; i < line.firstSegment + line.segmentCount; ++i)
+                result.append(getSegmentData(segments[i], scratch), segments[i].length);
+
+            return result;
+        }
+#endif
+
+#if (TARGET_OS_MAC || defined(__linux__)) && !defined(__ANDROID__) && !TARGET_OS_IOS && !TARGET_OS_TV
+#  if defined(IOV_MAX)
+        constexpr size_t MAX_IO_VECTORS = IOV_MAX;
+#  else
+        constexpr size_t MAX_IO_VECTORS = 1024;
+#  endif
+
+        void writeVectors(int fd, iovec* vectors, size_t count)
+        {
+            size_t index = 0;
+            while (index < count)
+            {
+                const ssize_t written = writev(fd, vectors + index, static_cast<int>(std::min(count - index, MAX_IO_VECTORS)));
+                if (written == -1)
+                {
+                    if (errno == EINTR) continue;
+                    return;
+                }
+
+                // skip the written vectors and adjust the partially written one
+                auto remaining = static_cast<size_t>(written);
+                while (index < count && remaining >= vectors[index].iov_len)
+                    remaining -= vectors[index++].iov_len;
+
+                if (remaining > 0)
+                {
+                    vectors[index].iov_base = static_cast<char*>(vectors[index].iov_base) + remaining;
+                    vectors[index].iov_len -= remaining;
+                }
+            }
+        }
+
+        int getFileDescriptor(Log::Level level) noexcept
+        {
+            switch (level)
+            {
+                case Log::Level::Error:
+                case Log::Level::Warning:
+                    return STDERR_FILENO;
+                case Log::Level::Info:
+                case Log::Level::All:
+                    return STDOUT_FILENO;
+                default: return -1;
+            }
+        }
+#endif
+
+#if !defined(__EMSCRIPTEN__)
+        constexpr size_t BUFFER_SIZE = 65536; // must be a power of two
+        constexpr uint32_t PADDING = 0xFFFFFFFF;
+        constexpr size_t RECORD_HEADER_SIZE = sizeof(uint64_t) + sizeof(Log::Level);
+        constexpr size_t MAX_BATCH_SEGMENTS = 1024;
+
+        inline size_t alignEntrySize(size_t size) noexcept
+        {
+            return (size + sizeof(uint32_t) - 1) & ~(sizeof(uint32_t) - 1);
+        }
+
+        std::atomic<uint64_t> nextLoggerId{1};
+        thread_local Logger::OverflowPolicy overflowPolicy = Logger::OverflowPolicy::Wait;
+#endif
+    }
+
+#if !defined(__EMSCRIPTEN__)
+    // Log records written by one thread and read by the log thread, every entry is a 32-bit size
+    // followed by the record (sequence number, level and arguments) and entries never wrap around
+    // the end of the ring, so they can be formatted in place
+    class Logger::Buffer final
+    {
+    public:
+
+        static bool fits(size_t argumentsSize) noexcept
+        {
+            return alignEntrySize(sizeof(uint32_t) + RECORD_HEADER_SIZE + argumentsSize) <= BUFFER_SIZE;
+        }
+
+        // must be called only by the owning thread
+        bool push(uint64_t sequence, Log::Level level, const uint8_t* arguments, size_t argumentsSize) noexcept
+        {
+            const auto recordSize = static_cast<uint32_t>(RECORD_HEADER_SIZE + argumentsSize);
+            const size_t entrySize = alignEntrySize(sizeof(uint32_t) + recordSize);
+
+            size_t currentTail = bytes.getTail();
+            size_t position = currentTail & (BUFFER_SIZE - 1);
+
+            if (entrySize > BUFFER_SIZE - position)
+            {
+                // skip the rest of the ring
+                if (currentTail + BUFFER_SIZE - position - bytes.getHead() > BUFFER_SIZE)
+                    return false;
+
+                memcpy(bytes.getData() + position, &PADDING, sizeof(PADDING));
+                currentTail += BUFFER_SIZE - position;
+                bytes.commit(currentTail);
+                position = 0;
+            }
+
+            if (currentTail + entrySize - bytes.getHead() > BUFFER_SIZE)
+                return false;
+
+            uint8_t* entry = bytes.getData() + position;
+            memcpy(entry, &recordSize, sizeof(recordSize));
+            memcpy(entry + sizeof(recordSize), &sequence, sizeof(sequence));
+            memcpy(entry + sizeof(recordSize) + sizeof(sequence), &level, sizeof(level));
+            memcpy(entry + sizeof(recordSize) + RECORD_HEADER_SIZE, arguments, argumentsSize);
+
+            bytes.commit(currentTail + entrySize);
+            return true;
+        }
+
+        // must be called only by the log thread, returns the record at the cursor and the position after it
+        const uint8_t* peek(size_t& cursor, uint32_t& recordSize, size_t& next) const noexcept
+        {
+            for (;;)
+            {
+                if (cursor == bytes.getTail()) return nullptr;
+
+                const size_t position = cursor & (BUFFER_SIZE - 1);
+                memcpy(&recordSize, bytes.getData() + position, sizeof(recordSize));
+
+                if (recordSize == PADDING)
+                    cursor += BUFFER_SIZE - position;
+                else
+                {
+                    next = cursor + alignEntrySize(sizeof(uint32_t) + recordSize);
+                    return bytes.getData() + position + sizeof(uint32_t);
+                }
+            }
+        }
+
+        // frees the space up to the cursor, the records before it must not be accessed afterwards
+        void release(size_t cursor) noexcept
+        {
+            bytes.release(cursor);
+        }
+
+        inline auto getHead() const noexcept { return bytes.getHead(); }
+        inline auto isEmpty() const noexcept { return bytes.isEmpty(); }
+
+        std::atomic<uint32_t> dropped{0};
+
+    private:
+        SpscQueue<uint8_t> bytes{BUFFER_SIZE};
+    };
+
+    struct Logger::BufferNode final
+    {
+        std::shared_ptr<Buffer> buffer;
+        BufferNode* next;
+    };
+#endif
+
     Log::~Log()
     {
-        if (!s.empty())
-            logger.log(s, level);
+        if (size > 0)
+            logger.logStatement(*this);
+    }
+
+    Logger::Logger(Log::Level initThreshold):
+        threshold(initThreshold)
+#if !defined(__EMSCRIPTEN__)
+        , id(nextLoggerId++)
+#endif
+    {
+#if !defined(__EMSCRIPTEN__)
+        logThread = Thread(&Logger::logLoop, this);
+#endif
+    }
+
+    Logger::~Logger()
+    {
+#if !defined(__EMSCRIPTEN__)
+        std::unique_lock<std::mutex> lock(pendingMutex);
+        running = false;
+        lock.unlock();
+        pendingCondition.notify_all();
+
+        if (logThread.isJoinable()) logThread.join();
+
+        BufferNode* node = buffers.load(std::memory_order_acquire);
+        while (node)
+        {
+            BufferNode* next = node->next;
+            delete node;
+            node = next;
+        }
+#endif
+    }
+
+    void Logger::setOverflowPolicy(OverflowPolicy policy) noexcept
+    {
+#if defined(__EMSCRIPTEN__)
+        static_cast<void>(policy);
+#else
+        overflowPolicy = policy;
+#endif
+    }
+
+    void Logger::logStatement(const Log& statement) const
+    {
+#if defined(__EMSCRIPTEN__)
+        std::string scratch;
+        std::vector<Segment> segments;
+        formatArguments(statement.getData(), statement.size, scratch, segments);
+        logString(getLineString(Line{statement.level, 0, segments.size()}, segments, scratch), statement.level);
+#else
+        Buffer& buffer = getThreadBuffer();
+
+        if (!Buffer::fits(statement.size))
+        {
+            buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        const uint64_t recordSequence = sequence.fetch_add(1, std::memory_order_relaxed);
+
+        while (!buffer.push(recordSequence, statement.level, statement.getData(), statement.size))
+        {
+            if (overflowPolicy == OverflowPolicy::Drop ||
+                !running.load(std::memory_order_acquire))
+            {
+                buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+
+            notifyLogThread();
+            std::this_thread::yield();
+        }
+
+        // threads that must not block leave the waking up to the timeout of the log thread
+        if (overflowPolicy == OverflowPolicy::Drop)
+            pending.store(true, std::memory_order_release);
+        else
+            notifyLogThread();
+#endif
     }
 
     void Logger::logString(const std::string& str, Log::Level level)
@@ -62,32 +421,16 @@ namespace ouzel
         }
         syslog(priority, "%s", str.c_str());
 #elif TARGET_OS_MAC || defined(__linux__)
-        int fd = 0;
-        switch (level)
-        {
-            case Log::Level::Error:
-            case Log::Level::Warning:
-                fd = STDERR_FILENO;
-                break;
-            case Log::Level::Info:
-            case Log::Level::All:
-                fd = STDOUT_FILENO;
-                break;
-            default: return;
-        }
-
-        std::vector<char> output(str.begin(), str.end());
-        output.push_back('\n');
+        const int fd = getFileDescriptor(level);
+        if (fd == -1) return;
 
-        size_t offset = 0;
-        while (offset < output.size())
-        {
-            ssize_t written = write(fd, output.data() + offset, output.size() - offset);
-            if (written == -1)
-                return;
-
-            offset += static_cast<size_t>(written);
-        }
+        char newline = '\n';
+        iovec vectors[2];
+        vectors[0].iov_base = const_cast<char*>(str.data());
+        vectors[0].iov_len = str.length();
+        vectors[1].iov_base = &newline;
+        vectors[1].iov_len = 1;
+        writeVectors(fd, vectors, 2);
 #elif defined(_WIN32)
         const int bufferSize = MultiByteToWideChar(CP_UTF8, 0, str.c_str(), -1, nullptr, 0);
         if (bufferSize == 0)
@@ -137,4 +480,189 @@ namespace ouzel
         emscripten_log(flags, "%s", str.c_str());
 #endif
     }
+
+#if !defined(__EMSCRIPTEN__)
+    Logger::Buffer& Logger::getThreadBuffer() const
+    {
+        thread_local uint64_t bufferLoggerId = 0;
+        thread_local std::shared_ptr<Buffer> buffer;
+
+        if (bufferLoggerId != id)
+        {
+            buffer = std::make_shared<Buffer>();
+
+            // only the log thread removes nodes and it never removes the first one
+            auto node = new BufferNode{buffer, buffers.load(std::memory_order_relaxed)};
+            while (!buffers.compare_exchange_weak(node->next, node,
+                                                  std::memory_order_release,
+                                                  std::memory_order_relaxed));
+
+            bufferLoggerId = id;
+        }
+
+        return *buffer;
+    }
+
+    void Logger::notifyLogThread() const
+    {
+        if (!pending.exchange(true, std::memory_order_acq_rel))
+        {
+            // the log thread is either before its check of the pending flag or waiting
+            std::unique_lock<std::mutex> lock(pendingMutex);
+            lock.unlock();
+            pendingCondition.notify_one();
+        }
+    }
+
+    void Logger::logLoop()
+    {
+        Thread::setCurrentThreadName("Log");
+
+        for (;;)
+        {
+            std::unique_lock<std::mutex> lock(pendingMutex);
+            pendingCondition.wait_for(lock, std::chrono::milliseconds(100), [this]() {
+                return pending.load(std::memory_order_acquire) || !running.load(std::memory_order_acquire);
+            });
+            lock.unlock();
+
+            pending.store(false, std::memory_order_release);
+            const bool quit = !running.load(std::memory_order_acquire);
+
+            writeRecords();
+
+            if (quit) break;
+        }
+    }
+
+    void Logger::writeRecords()
+    {
+        struct Source final
+        {
+            Buffer* buffer;
+            size_t cursor;
+            size_t next;
+            const uint8_t* record;
+            uint32_t recordSize;
+        };
+
+        std::vector<Source> sources;
+        std::vector<Line> lines;
+        std::vector<Segment> segments;
+        std::string scratch;
+
+        for (BufferNode* node = buffers.load(std::memory_order_acquire); node; node = node->next)
+        {
+            Buffer& buffer = *node->buffer;
+
+            if (const uint32_t dropped = buffer.dropped.exchange(0, std::memory_order_relaxed))
+            {
+                lines.push_back(Line{Log::Level::Warning, segments.size(), 2});
+                appendScratch(scratch, segments, std::to_string(dropped));
+                segments.push_back(Segment{" log statements dropped", 0, 23});
+            }
+
+            Source source{&buffer, buffer.getHead(), 0, nullptr, 0};
+            source.record = buffer.peek(source.cursor, source.recordSize, source.next);
+            sources.push_back(source);
+        }
+
+        auto flush = [&lines, &segments, &scratch, &sources]() {
+#if defined(__ANDROID__) || TARGET_OS_IOS || TARGET_OS_TV
+            for (const Line& line : lines)
+                logString(getLineString(line, segments, scratch), line.level);
+#elif TARGET_OS_MAC || defined(__linux__)
+            // lines that go to the same stream are written with a single call
+            char newline = '\n';
+            std::vector<iovec> vectors;
+
+            for (size_t first = 0; first < lines.size();)
+            {
+                const int fd = getFileDescriptor(lines[first].level);
+
+                size_t last = first;
+                for (; last < lines.size() && getFileDescriptor(lines[last].level) == fd; ++last)
+                {
+                    for (size_t i = lines[last].firstSegment; i < lines[last].firstSegment + lines[last].segmentCount; ++i)
+                    {
+                        iovec vector;
+                        vector.iov_base = const_cast<char*>(getSegmentData(segments[i], scratch));
+                        vector.iov_len = segments[i].length;
+                        vectors.push_back(vector);
+                    }
+
+                    iovec vector;
+                    vector.iov_base = &newline;
+                    vector.iov_len = 1;
+                    vectors.push_back(vector);
+                }
+
+                if (fd != -1) writeVectors(fd, vectors.data(), vectors.size());
+                vectors.clear();
+                first = last;
+            }
+#else
+            for (const Line& line : lines)
+                logString(getLineString(line, segments, scratch), line.level);
+#endif
+            lines.clear();
+            segments.clear();
+            scratch.clear();
+
+            // the records are not referenced anymore
+            for (Source& source : sources)
+                source.buffer->release(source.cursor);
+        };
+
+        // records of all threads are merged in the order they were logged in
+        for (;;)
+        {
+            Source* oldest = nullptr;
+            uint64_t oldestSequence = 0;
+
+            for (Source& source : sources)
+                if (source.record)
+                {
+                    uint64_t recordSequence;
+                    memcpy(&recordSequence, source.record, sizeof(recordSequence));
+
+                    if (!oldest || recordSequence < oldestSequence)
+                    {
+                        oldest = &source;
+                        oldestSequence = recordSequence;
+                    }
+                }
+
+            if (!oldest) break;
+
+            Log::Level level;
+            memcpy(&level, oldest->record + sizeof(uint64_t), sizeof(level));
+
+            const size_t firstSegment = segments.size();
+            formatArguments(oldest->record + RECORD_HEADER_SIZE, oldest->recordSize - RECORD_HEADER_SIZE, scratch, segments);
+            lines.push_back(Line{level, firstSegment, segments.size() - firstSegment});
+
+            oldest->cursor = oldest->next;
+
+            if (segments.size() >= MAX_BATCH_SEGMENTS) flush();
+
+            oldest->record = oldest->buffer->peek(oldest->cursor, oldest->recordSize, oldest->next);
+        }
+
+        flush();
+
+        // free the buffers of the threads that have exited
+        BufferNode* previous = buffers.load(std::memory_order_acquire);
+        while (BufferNode* node = previous ? previous->next : nullptr)
+        {
+            if (node->buffer.use_count() == 1 && node->buffer->isEmpty())
+            {
+                previous->next = node->next;
+                delete node;
+            }
+            else
+                previous = node;
+        }
+    }
+#endif
 }
@@ -6,10 +6,13 @@
 #include <array>
 #include <atomic>
 #include <condition_variable>
+#include <cstdint>
+#include <cstring>
 #include <initializer_list>
+#include <iterator>
 #include <list>
+#include <memory>
 #include <mutex>
-#include <queue>
 #include <set>
 #include <string>
 #include <thread>
@@ -21,12 +24,19 @@
 #include "math/Vector.hpp"
 #include "utils/Thread.hpp"
 
+// the most verbose level that is compiled in (Off, Error, Warning, Info or All)
+#if !defined(OUZEL_MAX_LOG_LEVEL)
+#  define OUZEL_MAX_LOG_LEVEL All
+#endif
+
 namespace ouzel
 {
     class Logger;
 
+    // Log statements collect their arguments in a binary form, which is formatted on the log thread
     class Log final
     {
+        friend Logger;
     public:
         enum class Level
         {
@@ -37,24 +47,42 @@ namespace ouzel
             All
         };
 
-        explicit Log(const Logger& initLogger, Level initLevel = Level::Info):
-            logger(initLogger), level(initLevel)
+        // statements with a level above this are compiled out if the level is a template argument of Logger::log
+        static constexpr Level MAX_LEVEL = Level::OUZEL_MAX_LOG_LEVEL;
+
+        enum class Argument: uint8_t
         {
-        }
+            Boolean,
+            Hex,
+            Integer,
+            UnsignedInteger,
+            FloatingPoint,
+            String,
+            Pointer
+        };
+
+        explicit Log(const Logger& initLogger, Level initLevel = Level::Info);
 
         Log(const Log& other):
             logger(other.logger),
             level(other.level),
-            s(other.s)
+            enabled(other.enabled),
+            size(other.size),
+            inlineData(other.inlineData),
+            data(other.data)
         {
         }
 
         Log(Log&& other) noexcept:
             logger(other.logger),
             level(other.level),
-            s(std::move(other.s))
+            enabled(other.enabled),
+            size(other.size),
+            inlineData(other.inlineData),
+            data(std::move(other.data))
         {
             other.level = Level::Info;
+            other.size = 0;
         }
 
         Log& operator=(const Log& other)
@@ -62,7 +90,10 @@ namespace ouzel
             if (&other == this) return *this;
 
             level = other.level;
-            s = other.s;
+            enabled = other.enabled;
+            size = other.size;
+            inlineData = other.inlineData;
+            data = other.data;
 
             return *this;
         }
@@ -73,7 +104,11 @@ namespace ouzel
 
             level = other.level;
             other.level = Level::Info;
-            s = std::move(other.s);
+            enabled = other.enabled;
+            size = other.size;
+            other.size = 0;
+            inlineData = other.inlineData;
+            data = std::move(other.data);
 
             return *this;
         }
@@ -83,18 +118,14 @@ namespace ouzel
         template <typename T, typename std::enable_if<std::is_same<T, bool>::value>::type* = nullptr>
         Log& operator<<(const T val)
         {
-            s += val ? "true" : "false";
+            if (enabled) writeArgument(Argument::Boolean, static_cast<uint8_t>(val ? 1 : 0));
             return *this;
         }
 
         template <typename T, typename std::enable_if<std::is_same<T, uint8_t>::value>::type* = nullptr>
         Log& operator<<(const T val)
         {
-            constexpr char digits[] = "0123456789abcdef";
-
-            for (uint32_t p = 0; p < 2; ++p)
-                s.push_back(digits[(val >> (4 - p * 4)) & 0x0F]);
-
+            if (enabled) writeArgument(Argument::Hex, val);
             return *this;
         }
 
@@ -103,34 +134,33 @@ namespace ouzel
             !std::is_same<T, uint8_t>::value>::type* = nullptr>
         Log& operator<<(const T val)
         {
-            s += std::to_string(val);
+            if (enabled) writeNumber(val);
             return *this;
         }
 
         template <typename T, typename std::enable_if<std::is_same<T, std::string>::value>::type* = nullptr>
         Log& operator<<(const T& val)
         {
-            s += val;
+            if (enabled) writeString(val.data(), val.length());
             return *this;
         }
 
         template <typename T, typename std::enable_if<std::is_same<T, char>::value>::type* = nullptr>
         Log& operator<<(const T* val)
         {
-            s += val;
+            if (enabled) writeString(val, strlen(val));
             return *this;
         }
 
         template <typename T, typename std::enable_if<!std::is_same<T, char>::value>::type* = nullptr>
         Log& operator<<(const T* val)
         {
-            constexpr char digits[] = "0123456789abcdef";
-
-            uintptr_t ptrValue;
-            memcpy(&ptrValue, &val, sizeof(ptrValue));
-
-            for (size_t i = 0; i < sizeof(val) * 2; ++i)
-                s.push_back(digits[(ptrValue >> (sizeof(ptrValue) * 2 - i - 1) * 4) & 0x0F]);
+            if (enabled)
+            {
+                uintptr_t ptrValue;
+                memcpy(&ptrValue, &val, sizeof(ptrValue));
+                writeArgument(Argument::Pointer, ptrValue);
+            }
 
             return *this;
         }
@@ -145,11 +175,13 @@ namespace ouzel
         template <typename T, typename std::enable_if<isContainer<T>::value>::type* = nullptr>
         Log& operator<<(const T& val)
         {
+            if (!enabled) return *this;
+
             bool first = true;
 
             for (const auto& i : val)
             {
-                if (!first) s += ", ";
+                if (!first) writeString(", ", 2);
                 first = false;
 
                 operator<<(i);
@@ -161,107 +193,170 @@ namespace ouzel
         template <size_t N, size_t M, class T>
         Log& operator<<(const Matrix<N, M, T>& val)
         {
-            bool first = true;
-
-            for (const T c : val.m)
-            {
-                if (!first) s += ",";
-                first = false;
-                s += std::to_string(c);
-            }
-
+            if (enabled) writeNumbers(std::begin(val.m), std::end(val.m));
             return *this;
         }
 
         template <typename T>
         Log& operator<<(const Quaternion<T>& val)
         {
-            s += std::to_string(val.v[0]) + "," + std::to_string(val.v[1]) + "," +
-                std::to_string(val.v[2]) + "," + std::to_string(val.v[3]);
+            if (enabled) writeNumbers(std::begin(val.v), std::end(val.v));
             return *this;
         }
 
         template <size_t N, class T>
         Log& operator<<(const Size<N, T>& val)
         {
-            bool first = true;
-
-            for (const T c : val.v)
-            {
-                if (!first) s += ",";
-                first = false;
-                s += std::to_string(c);
-            }
+            if (enabled) writeNumbers(std::begin(val.v), std::end(val.v));
             return *this;
         }
 
         template <size_t N, class T>
         Log& operator<<(const Vector<N, T>& val)
         {
-            bool first = true;
+            if (enabled) writeNumbers(std::begin(val.v), std::end(val.v));
+            return *this;
+        }
+
+    private:
+        // most statements fit in the inline storage, so logging does not allocate
+        static constexpr size_t INLINE_SIZE = 256;
 
-            for (const T c : val.v)
+        void write(const void* value, size_t valueSize)
+        {
+            if (data.empty())
             {
-                if (!first) s += ",";
-                first = false;
-                s += std::to_string(c);
+                if (size + valueSize <= INLINE_SIZE)
+                {
+                    memcpy(inlineData.data() + size, value, valueSize);
+                    size += valueSize;
+                    return;
+                }
+
+                data.assign(inlineData.begin(), inlineData.begin() + size);
             }
-            return *this;
+
+            data.insert(data.end(),
+                        static_cast<const uint8_t*>(value),
+                        static_cast<const uint8_t*>(value) + valueSize);
+            size += valueSize;
+        }
+
+        template <typename T>
+        void writeArgument(Argument argument, const T value)
+        {
+            write(&argument, sizeof(argument));
+            write(&value, sizeof(value));
+        }
+
+        template <typename T, typename std::enable_if<std::is_floating_point<T>::value>::type* = nullptr>
+        void writeNumber(const T value)
+        {
+            writeArgument(Argument::FloatingPoint, static_cast<double>(value));
+        }
+
+        template <typename T, typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value>::type* = nullptr>
+        void writeNumber(const T value)
+        {
+            writeArgument(Argument::Integer, static_cast<int64_t>(value));
+        }
+
+        template <typename T, typename std::enable_if<std::is_integral<T>::value && std::is_unsigned<T>::value>::type* = nullptr>
+        void writeNumber(const T value)
+        {
+            writeArgument(Argument::UnsignedInteger, static_cast<uint64_t>(value));
+        }
+
+        template <class Iterator>
+        void writeNumbers(Iterator begin, Iterator end)
+        {
+            for (Iterator i = begin; i != end; ++i)
+            {
+                if (i != begin) writeString(",", 1);
+                writeNumber(*i);
+            }
+        }
+
+        void writeString(const char* value, size_t length)
+        {
+            const auto stringLength = static_cast<uint32_t>(length);
+            writeArgument(Argument::String, stringLength);
+            write(value, stringLength);
+        }
+
+        inline const uint8_t* getData() const noexcept
+        {
+            return data.empty() ? inlineData.data() : data.data();
         }
 
-    private:
         const Logger& logger;
         Level level = Level::Info;
-        std::string s;
+        bool enabled = false;
+        size_t size = 0;
+        std::array<uint8_t, INLINE_SIZE> inlineData;
+        std::vector<uint8_t> data;
+    };
+
+    // Statement with a level that is compiled out
+    class NullLog final
+    {
+    public:
+        template <typename T>
+        inline NullLog& operator<<(const T&) noexcept { return *this; }
     };
 
     class Logger final
     {
+        friend Log;
     public:
-        explicit Logger(Log::Level initThreshold = Log::Level::All):
-            threshold(initThreshold)
+        // what a thread does when its log buffer is full
+        enum class OverflowPolicy
         {
-#if !defined(__EMSCRIPTEN__)
-            logThread = Thread(&Logger::logLoop, this);
-#endif
-        }
+            Wait, // wait for the log thread to write out the buffer
+            Drop // drop the statement, for threads that must never block (e.g. audio)
+        };
+
+        explicit Logger(Log::Level initThreshold = Log::Level::All);
 
         Logger(const Logger&) = delete;
         Logger& operator=(const Logger&) = delete;
         Logger(Logger&&) = delete;
         Logger& operator=(Logger&&) = delete;
 
-        ~Logger()
+        ~Logger();
+
+        Log log(const Log::Level level = Log::Level::Info) const
         {
-#if !defined(__EMSCRIPTEN__)
-            std::unique_lock<std::mutex> lock(queueMutex);
-            commandQueue.push(Command(Command::Type::Quit));
-            lock.unlock();
-            queueCondition.notify_all();
-#endif
+            return Log(*this, level);
         }
 
-        Log log(const Log::Level level = Log::Level::Info) const
+        template <Log::Level level, typename std::enable_if<(level <= Log::MAX_LEVEL)>::type* = nullptr>
+        Log log() const
         {
             return Log(*this, level);
         }
 
+        template <Log::Level level, typename std::enable_if<(level > Log::MAX_LEVEL)>::type* = nullptr>
+        NullLog log() const noexcept
+        {
+            return NullLog();
+        }
+
         void log(const std::string& str, const Log::Level level = Log::Level::Info) const
         {
-            if (level <= threshold)
-            {
-#if defined(__EMSCRIPTEN__)
-                logString(str, level);
-#else
-                std::unique_lock<std::mutex> lock(queueMutex);
-                commandQueue.push(Command(Command::Type::LogString, level, str));
-                lock.unlock();
-                queueCondition.notify_all();
-#endif
-            }
+            Log(*this, level) << str;
         }
 
+        inline bool isEnabled(const Log::Level level) const noexcept
+        {
+            return level <= Log::MAX_LEVEL && level <= threshold.load(std::memory_order_relaxed);
+        }
+
+        // sets the overflow policy of the calling thread
+        static void setOverflowPolicy(OverflowPolicy policy) noexcept;
+
     private:
+        void logStatement(const Log& statement) const;
         static void logString(const std::string& str, const Log::Level level = Log::Level::Info);
 
 #ifdef DEBUG
@@ -271,56 +366,29 @@ namespace ouzel
 #endif
 
 #if !defined(__EMSCRIPTEN__)
-        class Command
-        {
-        public:
-            enum class Type
-            {
-                LogString,
-                Quit
-            };
-
-            explicit Command(const Type initType):
-                type(initType)
-            {
-            }
-
-            Command(const Type initType, const Log::Level initLevel,
-                    const std::string& initString):
-                type(initType),
-                level(initLevel),
-                str(initString)
-            {
-            }
-
-            Type type;
-            Log::Level level;
-            std::string str;
-        };
-
-        void logLoop()
-        {
-            for (;;)
-            {
-                std::unique_lock<std::mutex> lock(queueMutex);
-                while (commandQueue.empty()) queueCondition.wait(lock);
-                auto command = std::move(commandQueue.front());
-                commandQueue.pop();
-                lock.unlock();
-
-                if (command.type == Command::Type::LogString)
-                    logString(command.str, command.level);
-                else if (command.type == Command::Type::Quit)
-                    break;
-            }
-        }
-
-        mutable std::condition_variable queueCondition;
-        mutable std::mutex queueMutex;
-        mutable std::queue<Command> commandQueue;
+        class Buffer;
+        struct BufferNode;
+
+        Buffer& getThreadBuffer() const;
+        void notifyLogThread() const;
+        void logLoop();
+        void writeRecords();
+
+        const uint64_t id;
+        mutable std::atomic<BufferNode*> buffers{nullptr};
+        mutable std::atomic<uint64_t> sequence{0};
+        mutable std::atomic<bool> pending{false};
+        std::atomic<bool> running{true};
+        mutable std::condition_variable pendingCondition;
+        mutable std::mutex pendingMutex;
         Thread logThread;
 #endif
     };
+
+    inline Log::Log(const Logger& initLogger, Level initLevel):
+        logger(initLogger), level(initLevel), enabled(initLogger.isEnabled(initLevel))
+    {
+    }
 }
 
 #endif // OUZEL_UTILS_LOG_HPP
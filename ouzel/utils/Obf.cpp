@@ -1,9 +1,11 @@
 // Copyright 2015-2019 Elviss Strazdins. All rights reserved.
 
+#include <algorithm>
 #include <cstring>
 #include <stdexcept>
 #include "Obf.hpp"
 #include "Utils.hpp"
+#include "math/Fnv.hpp"
 
 namespace ouzel
 {
@@ -11,6 +13,11 @@ namespace ouzel
     {
         namespace
         {
+            constexpr uint32_t EMPTY_BUCKET = 0xFFFFFFFF;
+            // scanning a few keys is faster than hashing
+            constexpr size_t MIN_INDEXED_DICTIONARY_SIZE = 8;
+            constexpr uint32_t MAX_DEPTH = 256;
+
             // reading
             uint32_t readInt8(const std::vector<uint8_t>& buffer, uint32_t offset, uint8_t& result)
             {
@@ -189,17 +196,10 @@ namespace ouzel
                 return offset - originalOffset;
             }
 
-            uint32_t readDictionary(const std::vector<uint8_t>& buffer, uint32_t offset, std::map<std::string, Value>& result)
+            uint32_t readDictionaryMembers(const std::vector<uint8_t>& buffer, uint32_t offset, uint32_t count, std::map<std::string, Value>& result)
             {
                 const uint32_t originalOffset = offset;
 
-                if (buffer.size() - offset < sizeof(uint32_t))
-                    throw std::runtime_error("Not enough data");
-
-                const uint32_t count = decodeBigEndian<uint32_t>(buffer.data() + offset);
-
-                offset += sizeof(count);
-
                 for (uint32_t i = 0; i < count; ++i)
                 {
                     if (buffer.size() - offset < sizeof(uint16_t))
@@ -227,6 +227,47 @@ namespace ouzel
                 return offset - originalOffset;
             }
 
+            uint32_t readDictionary(const std::vector<uint8_t>& buffer, uint32_t offset, std::map<std::string, Value>& result)
+            {
+                const uint32_t originalOffset = offset;
+
+                if (buffer.size() - offset < sizeof(uint32_t))
+                    throw std::runtime_error("Not enough data");
+
+                const uint32_t count = decodeBigEndian<uint32_t>(buffer.data() + offset);
+
+                offset += sizeof(count);
+
+                offset += readDictionaryMembers(buffer, offset, count, result);
+
+                return offset - originalOffset;
+            }
+
+            uint32_t readIndexedDictionary(const std::vector<uint8_t>& buffer, uint32_t offset, std::map<std::string, Value>& result)
+            {
+                const uint32_t originalOffset = offset;
+
+                if (buffer.size() - offset < sizeof(uint32_t) * 2)
+                    throw std::runtime_error("Not enough data");
+
+                const uint32_t count = decodeBigEndian<uint32_t>(buffer.data() + offset);
+                const uint32_t bucketCount = decodeBigEndian<uint32_t>(buffer.data() + offset + sizeof(uint32_t));
+
+                offset += sizeof(uint32_t) * 2;
+
+                // the index is not needed when decoding the whole dictionary
+                const uint64_t indexSize = (static_cast<uint64_t>(count) + bucketCount) * sizeof(uint32_t);
+
+                if (buffer.size() - offset < indexSize)
+                    throw std::runtime_error("Not enough data");
+
+                offset += static_cast<uint32_t>(indexSize);
+
+                offset += readDictionaryMembers(buffer, offset, count, result);
+
+                return offset - originalOffset;
+            }
+
             // writing
             uint32_t writeInt8(std::vector<uint8_t>& buffer, uint8_t value)
             {
@@ -338,7 +379,7 @@ namespace ouzel
                 return size;
             }
 
-            uint32_t writeObject(std::vector<uint8_t>& buffer, const std::map<uint32_t, Value>& value)
+            uint32_t writeObject(std::vector<uint8_t>& buffer, const std::map<uint32_t, Value>& value, bool indexDictionaries)
             {
                 uint8_t lengthData[sizeof(uint32_t)];
 
@@ -358,13 +399,13 @@ namespace ouzel
 
                     size += sizeof(keyData);
 
-                    size += i.second.encode(buffer);
+                    size += i.second.encode(buffer, indexDictionaries);
                 }
 
                 return size;
             }
 
-            uint32_t writeArray(std::vector<uint8_t>& buffer, const std::vector<Value>& value)
+            uint32_t writeArray(std::vector<uint8_t>& buffer, const std::vector<Value>& value, bool indexDictionaries)
             {
                 uint8_t lengthData[sizeof(uint32_t)];
 
@@ -375,12 +416,12 @@ namespace ouzel
                 uint32_t size = sizeof(lengthData);
 
                 for (const auto& i : value)
-                    size += i.encode(buffer);
+                    size += i.encode(buffer, indexDictionaries);
 
                 return size;
             }
 
-            uint32_t writeDictionary(std::vector<uint8_t>& buffer, const std::map<std::string, Value>& value)
+            uint32_t writeDictionary(std::vector<uint8_t>& buffer, const std::map<std::string, Value>& value, bool indexDictionaries)
             {
                 uint8_t sizeData[sizeof(uint32_t)];
 
@@ -405,11 +446,224 @@ namespace ouzel
                                   reinterpret_cast<const uint8_t*>(i.first.data()) + i.first.length());
                     size += static_cast<uint32_t>(i.first.length());
 
-                    size += i.second.encode(buffer);
+                    size += i.second.encode(buffer, indexDictionaries);
                 }
 
                 return size;
             }
+
+            // The member count and the bucket count are followed by the offsets of the members
+            // and an open addressing hash table of member indices, the members are stored like
+            // in a regular dictionary
+            uint32_t writeIndexedDictionary(std::vector<uint8_t>& buffer, const std::map<std::string, Value>& value, bool indexDictionaries)
+            {
+                const size_t originalSize = buffer.size();
+
+                const auto count = static_cast<uint32_t>(value.size());
+
+                // keep the load factor at most 0.5
+                uint32_t bucketCount = 1;
+                while (bucketCount < count * 2) bucketCount *= 2;
+
+                writeInt32(buffer, count);
+                writeInt32(buffer, bucketCount);
+
+                const size_t offsetsPosition = buffer.size();
+                const size_t bucketsPosition = offsetsPosition + count * sizeof(uint32_t);
+                const size_t membersPosition = bucketsPosition + bucketCount * sizeof(uint32_t);
+
+                buffer.resize(bucketsPosition, 0);
+                buffer.resize(membersPosition, 0xFF); // all buckets are EMPTY_BUCKET
+
+                uint32_t index = 0;
+                for (const auto& i : value)
+                {
+                    encodeBigEndian<uint32_t>(buffer.data() + offsetsPosition + index * sizeof(uint32_t),
+                                              static_cast<uint32_t>(buffer.size() - membersPosition));
+
+                    uint32_t bucket = fnv::hash<uint32_t>(i.first.data(), i.first.length()) & (bucketCount - 1);
+                    while (decodeBigEndian<uint32_t>(buffer.data() + bucketsPosition + bucket * sizeof(uint32_t)) != EMPTY_BUCKET)
+                        bucket = (bucket + 1) & (bucketCount - 1);
+
+                    encodeBigEndian<uint32_t>(buffer.data() + bucketsPosition + bucket * sizeof(uint32_t), index);
+
+                    writeString(buffer, i.first);
+                    i.second.encode(buffer, indexDictionaries);
+
+                    ++index;
+                }
+
+                return static_cast<uint32_t>(buffer.size() - originalSize);
+            }
+
+            // viewing
+            const uint8_t* advance(const uint8_t* position, const uint8_t* end, size_t size)
+            {
+                if (static_cast<size_t>(end - position) < size)
+                    throw std::runtime_error("Not enough data");
+
+                return position + size;
+            }
+
+            // returns the position of the first element of a container
+            const uint8_t* getFirstElement(const uint8_t* position) noexcept
+            {
+                const auto marker = static_cast<Value::Marker>(*position);
+
+                if (marker == Value::Marker::IndexedDictionary)
+                {
+                    const uint32_t count = decodeBigEndian<uint32_t>(position + 1);
+                    const uint32_t bucketCount = decodeBigEndian<uint32_t>(position + 1 + sizeof(uint32_t));
+                    return position + 1 + sizeof(uint32_t) * 2 + (static_cast<size_t>(count) + bucketCount) * sizeof(uint32_t);
+                }
+                else
+                    return position + 1 + sizeof(uint32_t);
+            }
+
+            const uint8_t* getElementValue(Value::Marker marker, const uint8_t* position) noexcept
+            {
+                switch (marker)
+                {
+                    case Value::Marker::Object:
+                        return position + sizeof(uint32_t);
+                    case Value::Marker::Dictionary:
+                    case Value::Marker::IndexedDictionary:
+                        return position + sizeof(uint16_t) + decodeBigEndian<uint16_t>(position);
+                    default:
+                        return position;
+                }
+            }
+
+            // returns the end of a value in a validated buffer
+            const uint8_t* skipValue(const uint8_t* position) noexcept
+            {
+                const auto marker = static_cast<Value::Marker>(*position);
+
+                switch (marker)
+                {
+                    case Value::Marker::Int8: return position + 1 + sizeof(uint8_t);
+                    case Value::Marker::Int16: return position + 1 + sizeof(uint16_t);
+                    case Value::Marker::Int32: return position + 1 + sizeof(uint32_t);
+                    case Value::Marker::Int64: return position + 1 + sizeof(uint64_t);
+                    case Value::Marker::Float: return position + 1 + sizeof(float);
+                    case Value::Marker::Double: return position + 1 + sizeof(double);
+                    case Value::Marker::String:
+                        return position + 1 + sizeof(uint16_t) + decodeBigEndian<uint16_t>(position + 1);
+                    case Value::Marker::LongString:
+                    case Value::Marker::ByteArray:
+                        return position + 1 + sizeof(uint32_t) + decodeBigEndian<uint32_t>(position + 1);
+                    default:
+                    {
+                        const uint32_t count = decodeBigEndian<uint32_t>(position + 1);
+                        const uint8_t* element = getFirstElement(position);
+
+                        for (uint32_t i = 0; i < count; ++i)
+                            element = skipValue(getElementValue(marker, element));
+
+                        return element;
+                    }
+                }
+            }
+
+            const uint8_t* validateValue(const uint8_t* position, const uint8_t* end, uint32_t depth)
+            {
+                const uint8_t* markerPosition = position;
+                position = advance(position, end, 1);
+
+                switch (static_cast<Value::Marker>(*markerPosition))
+                {
+                    case Value::Marker::Int8: return advance(position, end, sizeof(uint8_t));
+                    case Value::Marker::Int16: return advance(position, end, sizeof(uint16_t));
+                    case Value::Marker::Int32: return advance(position, end, sizeof(uint32_t));
+                    case Value::Marker::Int64: return advance(position, end, sizeof(uint64_t));
+                    case Value::Marker::Float: return advance(position, end, sizeof(float));
+                    case Value::Marker::Double: return advance(position, end, sizeof(double));
+                    case Value::Marker::String:
+                    {
+                        const uint8_t* data = advance(position, end, sizeof(uint16_t));
+                        return advance(data, end, decodeBigEndian<uint16_t>(position));
+                    }
+                    case Value::Marker::LongString:
+                    case Value::Marker::ByteArray:
+                    {
+                        const uint8_t* data = advance(position, end, sizeof(uint32_t));
+                        return advance(data, end, decodeBigEndian<uint32_t>(position));
+                    }
+                    case Value::Marker::Object:
+                    case Value::Marker::Array:
+                    case Value::Marker::Dictionary:
+                    case Value::Marker::IndexedDictionary:
+                        break;
+                    default:
+                        throw std::runtime_error("Unsupported marker");
+                }
+
+                if (depth >= MAX_DEPTH)
+                    throw std::runtime_error("Maximum depth exceeded");
+
+                const auto marker = static_cast<Value::Marker>(*markerPosition);
+
+                const uint8_t* countPosition = position;
+                position = advance(position, end, sizeof(uint32_t));
+                const uint32_t count = decodeBigEndian<uint32_t>(countPosition);
+
+                if (marker == Value::Marker::Object)
+                {
+                    for (uint32_t i = 0; i < count; ++i)
+                        position = validateValue(advance(position, end, sizeof(uint32_t)), end, depth + 1);
+                }
+                else if (marker == Value::Marker::Array)
+                {
+                    for (uint32_t i = 0; i < count; ++i)
+                        position = validateValue(position, end, depth + 1);
+                }
+                else
+                {
+                    const uint8_t* offsets = nullptr;
+                    const uint8_t* buckets = nullptr;
+                    uint32_t bucketCount = 0;
+
+                    if (marker == Value::Marker::IndexedDictionary)
+                    {
+                        const uint8_t* bucketCountPosition = position;
+                        position = advance(position, end, sizeof(uint32_t));
+                        bucketCount = decodeBigEndian<uint32_t>(bucketCountPosition);
+
+                        // lookups stop at the first empty bucket
+                        if (bucketCount <= count || (bucketCount & (bucketCount - 1)) != 0)
+                            throw std::runtime_error("Invalid bucket count");
+
+                        if (static_cast<size_t>(end - position) / sizeof(uint32_t) < static_cast<uint64_t>(count) + bucketCount)
+                            throw std::runtime_error("Not enough data");
+
+                        offsets = position;
+                        buckets = offsets + count * sizeof(uint32_t);
+                        position = buckets + bucketCount * sizeof(uint32_t);
+                    }
+
+                    const uint8_t* members = position;
+
+                    for (uint32_t i = 0; i < count; ++i)
+                    {
+                        if (offsets &&
+                            decodeBigEndian<uint32_t>(offsets + i * sizeof(uint32_t)) != static_cast<uint32_t>(position - members))
+                            throw std::runtime_error("Invalid member offset");
+
+                        const uint8_t* keyPosition = advance(position, end, sizeof(uint16_t));
+                        position = validateValue(advance(keyPosition, end, decodeBigEndian<uint16_t>(position)), end, depth + 1);
+                    }
+
+                    for (uint32_t i = 0; i < bucketCount; ++i)
+                    {
+                        const uint32_t index = decodeBigEndian<uint32_t>(buckets + i * sizeof(uint32_t));
+
+                        if (index != EMPTY_BUCKET && index >= count)
+                            throw std::runtime_error("Invalid bucket");
+                    }
+                }
+
+                return position;
+            }
         }
 
         uint32_t Value::decode(const std::vector<uint8_t>& buffer, uint32_t offset)
@@ -523,6 +777,13 @@ namespace ouzel
                     ret = readDictionary(buffer, offset, dictionaryValue);
                     break;
                 }
+                case Marker::IndexedDictionary:
+                {
+                    type = Type::Dictionary;
+
+                    ret = readIndexedDictionary(buffer, offset, dictionaryValue);
+                    break;
+                }
                 default:
                     throw std::runtime_error("Unsupported marker");
             }
@@ -532,7 +793,7 @@ namespace ouzel
             return offset - originalOffset;
         }
 
-        uint32_t Value::encode(std::vector<uint8_t>& buffer) const
+        uint32_t Value::encode(std::vector<uint8_t>& buffer, bool indexDictionaries) const
         {
             uint32_t size = 0;
 
@@ -609,21 +870,30 @@ namespace ouzel
                 {
                     buffer.push_back(static_cast<uint8_t>(Marker::Object));
                     size += 1;
-                    ret = writeObject(buffer, objectValue);
+                    ret = writeObject(buffer, objectValue, indexDictionaries);
                     break;
                 }
                 case Type::Array:
                 {
                     buffer.push_back(static_cast<uint8_t>(Marker::Array));
                     size += 1;
-                    ret = writeArray(buffer, arrayValue);
+                    ret = writeArray(buffer, arrayValue, indexDictionaries);
                     break;
                 }
                 case Type::Dictionary:
                 {
-                    buffer.push_back(static_cast<uint8_t>(Marker::Dictionary));
-                    size += 1;
-                    ret = writeDictionary(buffer, dictionaryValue);
+                    if (indexDictionaries && dictionaryValue.size() >= MIN_INDEXED_DICTIONARY_SIZE)
+                    {
+                        buffer.push_back(static_cast<uint8_t>(Marker::IndexedDictionary));
+                        size += 1;
+                        ret = writeIndexedDictionary(buffer, dictionaryValue, indexDictionaries);
+                    }
+                    else
+                    {
+                        buffer.push_back(static_cast<uint8_t>(Marker::Dictionary));
+                        size += 1;
+                        ret = writeDictionary(buffer, dictionaryValue, indexDictionaries);
+                    }
                     break;
                 }
                 default:
@@ -634,5 +904,209 @@ namespace ouzel
 
             return size;
         }
+
+        View::Iterator& View::Iterator::operator++() noexcept
+        {
+            position = skipValue(getValuePosition());
+            ++index;
+
+            return *this;
+        }
+
+        uint32_t View::Iterator::getKey() const noexcept
+        {
+            assert(marker == Value::Marker::Object || marker == Value::Marker::Array);
+
+            return (marker == Value::Marker::Object) ? decodeBigEndian<uint32_t>(position) : index;
+        }
+
+        Span<const char> View::Iterator::getName() const noexcept
+        {
+            assert(marker == Value::Marker::Dictionary || marker == Value::Marker::IndexedDictionary);
+
+            return Span<const char>(reinterpret_cast<const char*>(position + sizeof(uint16_t)),
+                                    decodeBigEndian<uint16_t>(position));
+        }
+
+        const uint8_t* View::Iterator::getValuePosition() const noexcept
+        {
+            return getElementValue(marker, position);
+        }
+
+        View::View(Span<const uint8_t> buffer):
+            position(buffer.data())
+        {
+            validateValue(buffer.begin(), buffer.end(), 0);
+        }
+
+        Value::Type View::getType() const noexcept
+        {
+            switch (getMarker())
+            {
+                case Value::Marker::Int8:
+                case Value::Marker::Int16:
+                case Value::Marker::Int32:
+                case Value::Marker::Int64:
+                    return Value::Type::Int;
+                case Value::Marker::Float: return Value::Type::Float;
+                case Value::Marker::Double: return Value::Type::Double;
+                case Value::Marker::String:
+                case Value::Marker::LongString:
+                    return Value::Type::String;
+                case Value::Marker::ByteArray: return Value::Type::ByteArray;
+                case Value::Marker::Object: return Value::Type::Object;
+                case Value::Marker::Array: return Value::Type::Array;
+                default: return Value::Type::Dictionary;
+            }
+        }
+
+        size_t View::getEncodedSize() const noexcept
+        {
+            return static_cast<size_t>(skipValue(position) - position);
+        }
+
+        uint32_t View::getSize() const noexcept
+        {
+            assert(getType() == Value::Type::Object ||
+                   getType() == Value::Type::Array ||
+                   getType() == Value::Type::Dictionary);
+
+            return decodeBigEndian<uint32_t>(position + 1);
+        }
+
+        View::Iterator View::begin() const noexcept
+        {
+            return Iterator(getMarker(), getFirstElement(position), 0);
+        }
+
+        View::Iterator View::end() const noexcept
+        {
+            return Iterator(getMarker(), nullptr, getSize());
+        }
+
+        View::Iterator View::find(uint32_t key) const noexcept
+        {
+            assert(getType() == Value::Type::Object || getType() == Value::Type::Array);
+
+            const Iterator endIterator = end();
+
+            if (getMarker() == Value::Marker::Array && key >= endIterator.index)
+                return endIterator;
+
+            for (Iterator i = begin(); i != endIterator; ++i)
+                if (i.getKey() == key)
+                    return i;
+
+            return endIterator;
+        }
+
+        View::Iterator View::find(const std::string& key) const noexcept
+        {
+            assert(getType() == Value::Type::Dictionary);
+
+            const auto marker = getMarker();
+
+            if (marker == Value::Marker::IndexedDictionary)
+            {
+                const uint32_t count = getSize();
+                const uint32_t bucketCount = decodeBigEndian<uint32_t>(position + 1 + sizeof(uint32_t));
+                const uint8_t* offsets = position + 1 + sizeof(uint32_t) * 2;
+                const uint8_t* buckets = offsets + count * sizeof(uint32_t);
+                const uint8_t* members = buckets + bucketCount * sizeof(uint32_t);
+
+                uint32_t bucket = fnv::hash<uint32_t>(key.data(), key.length()) & (bucketCount - 1);
+
+                for (uint32_t probe = 0; probe < bucketCount; ++probe)
+                {
+                    const uint32_t index = decodeBigEndian<uint32_t>(buckets + bucket * sizeof(uint32_t));
+
+                    if (index == EMPTY_BUCKET) break;
+
+                    const Iterator i(marker, members + decodeBigEndian<uint32_t>(offsets + index * sizeof(uint32_t)), index);
+                    const Span<const char> name = i.getName();
+
+                    if (name.size() == key.length() && std::equal(name.begin(), name.end(), key.begin()))
+                        return i;
+
+                    bucket = (bucket + 1) & (bucketCount - 1);
+                }
+
+                return Iterator(marker, nullptr, count);
+            }
+            else
+            {
+                const Iterator endIterator = end();
+
+                for (Iterator i = begin(); i != endIterator; ++i)
+                {
+                    const Span<const char> name = i.getName();
+
+                    if (name.size() == key.length() && std::equal(name.begin(), name.end(), key.begin()))
+                        return i;
+                }
+
+                return endIterator;
+            }
+        }
+
+        uint64_t View::getInt() const noexcept
+        {
+            switch (getMarker())
+            {
+                case Value::Marker::Int8: return position[1];
+                case Value::Marker::Int16: return decodeBigEndian<uint16_t>(position + 1);
+                case Value::Marker::Int32: return decodeBigEndian<uint32_t>(position + 1);
+                case Value::Marker::Int64: return decodeBigEndian<uint64_t>(position + 1);
+                default:
+                    assert(false);
+                    return 0;
+            }
+        }
+
+        double View::getDouble() const noexcept
+        {
+            switch (getMarker())
+            {
+                case Value::Marker::Float:
+                {
+                    float result;
+                    memcpy(&result, position + 1, sizeof(result));
+                    return static_cast<double>(result);
+                }
+                case Value::Marker::Double:
+                {
+                    double result;
+                    memcpy(&result, position + 1, sizeof(result));
+                    return result;
+                }
+                default:
+                    assert(false);
+                    return 0.0;
+            }
+        }
+
+        Span<const char> View::getString() const noexcept
+        {
+            switch (getMarker())
+            {
+                case Value::Marker::String:
+                    return Span<const char>(reinterpret_cast<const char*>(position + 1 + sizeof(uint16_t)),
+                                            decodeBigEndian<uint16_t>(position + 1));
+                case Value::Marker::LongString:
+                    return Span<const char>(reinterpret_cast<const char*>(position + 1 + sizeof(uint32_t)),
+                                            decodeBigEndian<uint32_t>(position + 1));
+                default:
+                    assert(false);
+                    return Span<const char>();
+            }
+        }
+
+        Span<const uint8_t> View::getByteArray() const noexcept
+        {
+            assert(getMarker() == Value::Marker::ByteArray);
+
+            return Span<const uint8_t>(position + 1 + sizeof(uint32_t),
+                                       decodeBigEndian<uint32_t>(position + 1));
+        }
     } // namespace obf
 } // namespace ouzel
@@ -4,11 +4,16 @@
 #define OUZEL_UTILS_OBF_HPP
 
 #include <cassert>
+#include <cstddef>
 #include <cstdint>
+#include <iterator>
 #include <limits>
 #include <map>
+#include <stdexcept>
 #include <string>
+#include <type_traits>
 #include <vector>
+#include "utils/Span.hpp"
 
 namespace ouzel
 {
@@ -35,7 +40,8 @@ namespace ouzel
                 ByteArray = 9,
                 Object = 10,
                 Array = 11,
-                Dictionary = 12
+                Dictionary = 12,
+                IndexedDictionary = 13
             };
 
             enum class Type
@@ -208,7 +214,9 @@ namespace ouzel
             inline auto isStringType() const noexcept { return type == Type::String; }
 
             uint32_t decode(const std::vector<uint8_t>& buffer, uint32_t offset = 0);
-            uint32_t encode(std::vector<uint8_t>& buffer) const;
+            // if indexDictionaries is set, large dictionaries are written with a hash index,
+            // so that a View can look up their members in constant time
+            uint32_t encode(std::vector<uint8_t>& buffer, bool indexDictionaries = false) const;
 
             inline bool operator!()
             {
@@ -433,6 +441,155 @@ namespace ouzel
             Array arrayValue;
             Dictionary dictionaryValue;
         };
+
+        // Read-only view of an encoded value that refers directly to the encoded buffer,
+        // the buffer is validated once when the view is created and must outlive the view
+        class View final
+        {
+        public:
+            // Iterates the elements of an array or the members of an object or a dictionary
+            class Iterator final
+            {
+                friend View;
+            public:
+                using iterator_category = std::forward_iterator_tag;
+                using value_type = View;
+                using difference_type = std::ptrdiff_t;
+                using pointer = const View*;
+                using reference = View;
+
+                Iterator() noexcept = default;
+
+                inline View operator*() const noexcept { return View(getValuePosition()); }
+
+                Iterator& operator++() noexcept;
+
+                inline Iterator operator++(int) noexcept
+                {
+                    Iterator result = *this;
+                    ++(*this);
+                    return result;
+                }
+
+                inline bool operator==(const Iterator& other) const noexcept { return index == other.index; }
+                inline bool operator!=(const Iterator& other) const noexcept { return index != other.index; }
+
+                // key of an object member or index of an array element
+                uint32_t getKey() const noexcept;
+                // key of a dictionary member
+                Span<const char> getName() const noexcept;
+
+            private:
+                Iterator(Value::Marker initMarker, const uint8_t* initPosition, uint32_t initIndex) noexcept:
+                    marker(initMarker), position(initPosition), index(initIndex)
+                {
+                }
+
+                const uint8_t* getValuePosition() const noexcept;
+
+                Value::Marker marker = Value::Marker::Array;
+                const uint8_t* position = nullptr;
+                uint32_t index = 0;
+            };
+
+            View() noexcept = default;
+            explicit View(Span<const uint8_t> buffer);
+
+            // view of a missing element
+            inline auto isNull() const noexcept { return position == nullptr; }
+
+            inline auto getMarker() const noexcept
+            {
+                assert(position);
+                return static_cast<Value::Marker>(*position);
+            }
+
+            Value::Type getType() const noexcept;
+            inline auto isIntType() const noexcept { return getType() == Value::Type::Int; }
+            inline auto isFloatType() const noexcept { return getType() == Value::Type::Float || getType() == Value::Type::Double; }
+            inline auto isStringType() const noexcept { return getType() == Value::Type::String; }
+
+            // number of bytes the value takes in the buffer
+            size_t getEncodedSize() const noexcept;
+
+            template <typename T, typename std::enable_if<std::is_same<T, std::string>::value>::type* = nullptr>
+            std::string as() const
+            {
+                const Span<const char> result = getString();
+                return std::string(result.data(), result.size());
+            }
+
+            template <typename T, typename std::enable_if<std::is_same<T, Span<const char>>::value>::type* = nullptr>
+            Span<const char> as() const
+            {
+                return getString();
+            }
+
+            template <typename T, typename std::enable_if<std::is_integral<T>::value>::type* = nullptr>
+            T as() const
+            {
+                return static_cast<T>(getInt());
+            }
+
+            template <typename T, typename std::enable_if<std::is_floating_point<T>::value>::type* = nullptr>
+            T as() const
+            {
+                return static_cast<T>(getDouble());
+            }
+
+            template <typename T, typename std::enable_if<std::is_same<T, Span<const uint8_t>>::value>::type* = nullptr>
+            Span<const uint8_t> as() const
+            {
+                return getByteArray();
+            }
+
+            // number of elements in an array, object or dictionary
+            uint32_t getSize() const noexcept;
+
+            Iterator begin() const noexcept;
+            Iterator end() const noexcept;
+
+            Iterator find(uint32_t key) const noexcept;
+            Iterator find(const std::string& key) const noexcept;
+
+            inline View operator[](uint32_t key) const noexcept
+            {
+                const Iterator i = find(key);
+                return (i != end()) ? *i : View();
+            }
+
+            inline View operator[](const std::string& key) const noexcept
+            {
+                const Iterator i = find(key);
+                return (i != end()) ? *i : View();
+            }
+
+            // throws if the value is not an object or an array or if it does not have the element
+            View at(uint32_t key) const
+            {
+                if (isNull() || (getType() != Value::Type::Object && getType() != Value::Type::Array))
+                    throw std::runtime_error("Value is not an object or an array");
+
+                const Iterator i = find(key);
+                if (i == end())
+                    throw std::out_of_range("Element does not exist");
+
+                return *i;
+            }
+
+            inline bool hasElement(uint32_t key) const noexcept { return find(key) != end(); }
+            inline bool hasElement(const std::string& key) const noexcept { return find(key) != end(); }
+
+        private:
+            explicit View(const uint8_t* initPosition) noexcept: position(initPosition) {}
+
+            uint64_t getInt() const noexcept;
+            double getDouble() const noexcept;
+            Span<const char> getString() const noexcept;
+            Span<const uint8_t> getByteArray() const noexcept;
+
+            const uint8_t* position = nullptr;
+        };
     } // namespace obf
 } // namespace ouzel
 
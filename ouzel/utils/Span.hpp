@@ -0,0 +1,82 @@
+// Copyright 2015-2019 Elviss Strazdins. All rights reserved.
+
+#ifndef OUZEL_UTILS_SPAN_HPP
+#define OUZEL_UTILS_SPAN_HPP
+
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace ouzel
+{
+    // Non-owning view of a contiguous sequence of elements
+    template <class T>
+    class Span final
+    {
+    public:
+        using value_type = typename std::remove_cv<T>::type;
+        using iterator = T*;
+        using const_iterator = T*;
+
+        constexpr Span() noexcept = default;
+        constexpr Span(T* initData, size_t initSize) noexcept:
+            elements(initData), elementCount(initSize)
+        {
+        }
+
+        constexpr Span(T* begin, T* end) noexcept:
+            elements(begin), elementCount(static_cast<size_t>(end - begin))
+        {
+        }
+
+        template <size_t N>
+        constexpr Span(T (&array)[N]) noexcept:
+            elements(array), elementCount(N)
+        {
+        }
+
+        template <class Allocator>
+        Span(std::vector<value_type, Allocator>& vec) noexcept:
+            elements(vec.data()), elementCount(vec.size())
+        {
+        }
+
+        template <class Allocator, class U = T, typename std::enable_if<std::is_const<U>::value>::type* = nullptr>
+        Span(const std::vector<value_type, Allocator>& vec) noexcept:
+            elements(vec.data()), elementCount(vec.size())
+        {
+        }
+
+        template <class U, typename std::enable_if<std::is_convertible<U(*)[], T(*)[]>::value>::type* = nullptr>
+        constexpr Span(const Span<U>& other) noexcept:
+            elements(other.data()), elementCount(other.size())
+        {
+        }
+
+        constexpr T* data() const noexcept { return elements; }
+        constexpr size_t size() const noexcept { return elementCount; }
+        constexpr bool empty() const noexcept { return elementCount == 0; }
+
+        constexpr T* begin() const noexcept { return elements; }
+        constexpr T* end() const noexcept { return elements + elementCount; }
+        constexpr T* cbegin() const noexcept { return elements; }
+        constexpr T* cend() const noexcept { return elements + elementCount; }
+
+        constexpr T& operator[](size_t index) const noexcept { return elements[index]; }
+
+        Span subspan(size_t offset, size_t count) const
+        {
+            if (offset > elementCount || count > elementCount - offset)
+                throw std::out_of_range("Span out of range");
+
+            return Span(elements + offset, count);
+        }
+
+    private:
+        T* elements = nullptr;
+        size_t elementCount = 0;
+    };
+}
+
+#endif // OUZEL_UTILS_SPAN_HPP
@@ -0,0 +1,95 @@
+// Copyright 2015-2019 Elviss Strazdins. All rights reserved.
+
+#ifndef OUZEL_UTILS_SPSCQUEUE_HPP
+#define OUZEL_UTILS_SPSCQUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+namespace ouzel
+{
+    // Wait-free bounded queue for exactly one producer thread and one consumer thread
+    template <class T>
+    class SpscQueue final
+    {
+    public:
+        explicit SpscQueue(size_t initCapacity):
+            capacity(initCapacity),
+            elements(new T[initCapacity])
+        {
+        }
+
+        SpscQueue(const SpscQueue&) = delete;
+        SpscQueue& operator=(const SpscQueue&) = delete;
+
+        SpscQueue(SpscQueue&&) = delete;
+        SpscQueue& operator=(SpscQueue&&) = delete;
+
+        // must be called only by the producer, leaves the value untouched if the queue is full
+        bool push(T&& value)
+        {
+            const size_t currentTail = tail.load(std::memory_order_relaxed);
+            if (currentTail - head.load(std::memory_order_acquire) == capacity) return false;
+
+            elements[currentTail % capacity] = std::move(value);
+            tail.store(currentTail + 1, std::memory_order_release);
+            return true;
+        }
+
+        // must be called only by the consumer
+        bool pop(T& value)
+        {
+            const size_t currentHead = head.load(std::memory_order_relaxed);
+            if (currentHead == tail.load(std::memory_order_acquire)) return false;
+
+            value = std::move(elements[currentHead % capacity]);
+            head.store(currentHead + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Bulk access to the elements in place: the producer writes the free elements from the tail and
+        // publishes them with commit, the consumer reads the elements from the head up to the tail and
+        // frees them with release. Positions only grow, the element at a position is at position % capacity.
+
+        inline T* getData() noexcept { return elements.get(); }
+        inline const T* getData() const noexcept { return elements.get(); }
+
+        inline auto getHead() const noexcept { return head.load(std::memory_order_acquire); }
+        inline auto getTail() const noexcept { return tail.load(std::memory_order_acquire); }
+
+        // must be called only by the producer, publishes the elements before the position
+        inline void commit(size_t newTail) noexcept
+        {
+            tail.store(newTail, std::memory_order_release);
+        }
+
+        // must be called only by the consumer, the elements before the position must not be accessed afterwards
+        inline void release(size_t newHead) noexcept
+        {
+            head.store(newHead, std::memory_order_release);
+        }
+
+        inline auto isEmpty() const noexcept
+        {
+            return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+        }
+
+        // exact only when called from the producer or the consumer thread
+        inline size_t getCount() const noexcept
+        {
+            const size_t currentHead = head.load(std::memory_order_acquire);
+            return tail.load(std::memory_order_acquire) - currentHead;
+        }
+
+        inline auto getCapacity() const noexcept { return capacity; }
+
+    private:
+        const size_t capacity;
+        std::unique_ptr<T[]> elements;
+        std::atomic<size_t> head{0};
+        std::atomic<size_t> tail{0};
+    };
+} // namespace ouzel
+
+#endif // OUZEL_UTILS_SPSCQUEUE_HPP
@@ -4,6 +4,7 @@
 #define OUZEL_UTILS_UTILS_HPP
 
 #include <cstdint>
+#include <cstring>
 #include <random>
 #include <string>
 #include <type_traits>
@@ -26,7 +27,7 @@ namespace ouzel
         T result = 0;
 
         for (uintptr_t i = 0; i < sizeof(T); ++i)
-            result |= static_cast<T>(bytes[sizeof(buffer) - i - 1] << (i * 8));
+            result |= static_cast<T>(static_cast<T>(bytes[sizeof(T) - i - 1]) << (i * 8));
 
         return result;
     }
@@ -38,7 +39,7 @@ namespace ouzel
         T result = 0;
 
         for (uintptr_t i = 0; i < sizeof(T); ++i)
-            result |= static_cast<T>(bytes[i] << (i * 8));
+            result |= static_cast<T>(static_cast<T>(bytes[i]) << (i * 8));
 
         return result;
     }
@@ -61,6 +62,24 @@ namespace ouzel
             bytes[i] = static_cast<uint8_t>(value >> (i * 8));
     }
 
+    // floating point values are stored as the bits of their IEEE 754 representation
+    template <typename T, typename std::enable_if<std::is_same<T, float>::value>::type* = nullptr>
+    inline auto decodeLittleEndian(const void* buffer)
+    {
+        const auto bits = decodeLittleEndian<uint32_t>(buffer);
+        float result;
+        std::memcpy(&result, &bits, sizeof(result));
+        return result;
+    }
+
+    template <typename T, typename std::enable_if<std::is_same<T, float>::value>::type* = nullptr>
+    inline void encodeLittleEndian(void* buffer, const T value)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        encodeLittleEndian<uint32_t>(buffer, bits);
+    }
+
     template <typename T, typename std::enable_if<std::is_unsigned<T>::value>::type* = nullptr>
     auto hexToString(const T n, const size_t len = 0)
     {
@@ -3,10 +3,15 @@
 #ifndef OUZEL_UTILS_XML_HPP
 #define OUZEL_UTILS_XML_HPP
 
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
 #include <map>
 #include <stdexcept>
 #include <string>
+#include <utility>
 #include <vector>
+#include "utils/Span.hpp"
 #include "utils/Utf8.hpp"
 
 namespace ouzel
@@ -24,237 +29,472 @@ namespace ouzel
         {
             constexpr uint8_t UTF8_BOM[] = {0xEF, 0xBB, 0xBF};
 
-            constexpr auto isWhitespace(const char32_t c) noexcept
+            constexpr auto isWhitespace(const char c) noexcept
             {
                 return c == ' ' || c == '\t' || c == '\r' || c == '\n';
             }
 
-            constexpr auto isNameStartChar(const char32_t c) noexcept
+            // all the multi-byte UTF-8 sequences are accepted in names
+            constexpr auto isNameStartChar(const char c) noexcept
             {
                 return (c >= 'a' && c <= 'z') ||
                     (c >= 'A' && c <= 'Z') ||
                     c == ':' || c == '_' ||
-                    (c >= 0xC0 && c <= 0xD6) ||
-                    (c >= 0xD8 && c <= 0xF6) ||
-                    (c >= 0xF8 && c <= 0x2FF) ||
-                    (c >= 0x370 && c <= 0x37D) ||
-                    (c >= 0x37F && c <= 0x1FFF) ||
-                    (c >= 0x200C && c <= 0x200D) ||
-                    (c >= 0x2070 && c <= 0x218F);
+                    static_cast<uint8_t>(c) >= 0x80;
             }
 
-            constexpr auto isNameChar(const char32_t c) noexcept
+            constexpr auto isNameChar(const char c) noexcept
             {
                 return isNameStartChar(c) ||
                     c == '-' || c == '.' ||
-                    (c >= '0' && c <= '9') ||
-                    c == 0xB7 ||
-                    (c >= 0x0300 && c <= 0x036F) ||
-                    (c >= 0x203F && c <= 0x2040);
+                    (c >= '0' && c <= '9');
             }
 
-            inline void skipWhitespaces(std::u32string::const_iterator& iterator,
-                                        std::u32string::const_iterator end)
+            inline void encodeString(std::vector<uint8_t>& data,
+                                     const std::string& str)
             {
-                while (iterator != end)
-                    if (isWhitespace(*iterator))
-                        ++iterator;
-                    else
-                        break;
+                for (const char c : str)
+                {
+                    switch (c)
+                    {
+                        case '"':
+                            data.insert(data.end(), {'&', 'q', 'u', 'o', 't', ';'});
+                            break;
+                        case '&':
+                            data.insert(data.end(), {'&', 'a', 'm', 'p', ';'});
+                            break;
+                        case '\'':
+                            data.insert(data.end(), {'&', 'a', 'p', 'o', 's', ';'});
+                            break;
+                        case '<':
+                            data.insert(data.end(), {'&', 'l', 't', ';'});
+                            break;
+                        case '>':
+                            data.insert(data.end(), {'&', 'g', 't', ';'});
+                            break;
+                        default:
+                            data.push_back(static_cast<uint8_t>(c));
+                            break;
+                    }
+                }
             }
+        }
 
-            inline std::string parseName(std::u32string::const_iterator& iterator,
-                                         std::u32string::const_iterator end)
+        // Pull parser that reads the UTF-8 encoded bytes in place. Names and values are returned as views
+        // into the data, only the values that contain entities are decoded into a buffer that is reused.
+        // The views stay valid until the next call to read.
+        class Reader final
+        {
+        public:
+            enum class Token
             {
-                std::string result;
-
-                if (iterator == end)
-                    throw ParseError("Unexpected end of data");
+                StartTag,
+                EndTag, // also reported for empty element tags
+                Text,
+                CData,
+                Comment,
+                ProcessingInstruction,
+                End
+            };
 
-                if (!isNameStartChar(*iterator))
-                    throw ParseError("Invalid name start");
+            struct Attribute final
+            {
+                Span<const char> name;
+                Span<const char> value;
+            };
 
-                for (;;)
+            Reader(const char* initBegin, const char* initEnd,
+                   bool initPreserveWhitespaces = false):
+                iterator(initBegin), end(initEnd),
+                preserveWhitespaces(initPreserveWhitespaces)
+            {
+                if (end - iterator >= 3 &&
+                    std::equal(iterator, iterator + 3, std::begin(UTF8_BOM),
+                               [](char a, uint8_t b) noexcept { return static_cast<uint8_t>(a) == b; }))
                 {
-                    if (iterator == end)
-                        throw ParseError("Unexpected end of data");
-
-                    if (!isNameChar(*iterator))
-                        break;
-                    else
-                    {
-                        result += utf8::fromUtf32(*iterator);
-                        ++iterator;
-                    }
+                    bom = true;
+                    iterator += 3;
                 }
+            }
 
-                return result;
+            template <class T>
+            explicit Reader(const T& data,
+                            bool initPreserveWhitespaces = false):
+                Reader(reinterpret_cast<const char*>(data.data()),
+                       reinterpret_cast<const char*>(data.data()) + data.size(),
+                       initPreserveWhitespaces)
+            {
             }
 
-            inline std::string parseEntity(std::u32string::const_iterator& iterator,
-                                           std::u32string::const_iterator end)
+            Token read()
             {
-                std::string result;
+                attributes.clear();
+                value = Span<const char>();
 
-                if (iterator == end)
-                    throw ParseError("Unexpected end of data");
+                if (emptyElement)
+                {
+                    emptyElement = false;
+                    name = openTags.back();
+                    openTags.pop_back();
+                    return token = Token::EndTag;
+                }
 
-                if (*iterator != '&')
-                    throw ParseError("Expected an ampersand");
+                name = Span<const char>();
 
-                std::string value;
+                if (!preserveWhitespaces) skipWhitespaces();
 
-                for (;;)
+                if (iterator == end)
                 {
-                    if (++iterator == end)
+                    if (!openTags.empty())
                         throw ParseError("Unexpected end of data");
 
-                    if (*iterator == ';')
-                    {
-                        ++iterator;
-                        break;
-                    }
-                    else
-                        value.push_back(static_cast<char>(*iterator));
+                    return token = Token::End;
                 }
 
-                if (value.empty())
-                    throw ParseError("Invalid entity");
-
-                if (value == "quot")
-                    result = "\"";
-                else if (value == "amp")
-                    result = "&";
-                else if (value == "apos")
-                    result = "'";
-                else if (value == "lt")
-                    result = "<";
-                else if (value == "gt")
-                    result = ">";
-                else if (value[0] == '#')
+                if (*iterator != '<')
                 {
-                    if (value.length() < 2)
-                        throw ParseError("Invalid entity");
+                    const char* start = iterator;
+                    while (iterator != end && *iterator != '<') ++iterator;
 
-                    char32_t c = 0;
+                    buffer.clear();
+                    value = decode(start, iterator);
+                    return token = Token::Text;
+                }
 
-                    if (value[1] == 'x') // hex value
+                if (++iterator == end)
+                    throw ParseError("Unexpected end of data");
+
+                if (*iterator == '!') // <!
+                {
+                    if (++iterator == end)
+                        throw ParseError("Unexpected end of data");
+
+                    if (*iterator == '-') // <!-
                     {
-                        if (value.length() != 2 + 4)
-                            throw ParseError("Invalid entity");
+                        if (++iterator == end || *iterator != '-') // <!--
+                            throw ParseError("Expected a comment");
+
+                        const char* start = ++iterator;
 
-                        for (size_t i = 0; i < 4; ++i)
+                        for (;;)
                         {
-                            uint8_t code = 0;
+                            if (end - iterator < 3)
+                                throw ParseError("Unexpected end of data");
 
-                            if (value[i + 2] >= '0' && value[i + 2] <= '9')
-                                code = static_cast<uint8_t>(value[i + 2]) - '0';
-                            else if (value[i + 2] >= 'a' && value[i + 2] <='f')
-                                code = static_cast<uint8_t>(value[i + 2]) - 'a' + 10;
-                            else if (value[i + 2] >= 'A' && value[i + 2] <='F')
-                                code = static_cast<uint8_t>(value[i + 2]) - 'A' + 10;
-                            else
-                                throw ParseError("Invalid character code");
+                            if (iterator[0] == '-' && iterator[1] == '-') // --
+                            {
+                                if (iterator[2] != '>') // -->
+                                    throw ParseError("Unexpected double-hyphen inside comment");
 
-                            c = (c << 4) | code;
+                                value = Span<const char>(start, iterator);
+                                iterator += 3;
+                                break;
+                            }
+
+                            ++iterator;
                         }
+
+                        return token = Token::Comment;
                     }
-                    else
+                    else if (*iterator == '[') // <![
                     {
-                        if (value.length() != 1 + 4)
-                            throw ParseError("Invalid entity");
+                        ++iterator;
+                        const Span<const char> section = parseName();
 
-                        for (size_t i = 0; i < 4; ++i)
+                        if (std::string(section.begin(), section.end()) != "CDATA")
+                            throw ParseError("Expected CDATA");
+
+                        if (iterator == end)
+                            throw ParseError("Unexpected end of data");
+
+                        if (*iterator != '[')
+                            throw ParseError("Expected a left bracket");
+
+                        const char* start = ++iterator;
+
+                        for (;;)
                         {
-                            uint8_t code = 0;
+                            if (end - iterator < 3)
+                                throw ParseError("Unexpected end of data");
 
-                            if (value[i + 1] >= '0' && value[i + 1] <= '9')
-                                code = static_cast<uint8_t>(value[i + 1]) - '0';
-                            else
-                                throw ParseError("Invalid character code");
+                            if (iterator[0] == ']' && iterator[1] == ']' && iterator[2] == '>')
+                            {
+                                value = Span<const char>(start, iterator);
+                                iterator += 3;
+                                break;
+                            }
 
-                            c = c * 10 + code;
+                            ++iterator;
                         }
+
+                        return token = Token::CData;
                     }
+                    else
+                        throw ParseError("Type declarations are not supported");
+                }
+                else if (*iterator == '?') // <?
+                {
+                    ++iterator;
+                    name = parseName();
+                    parseAttributes(true);
+                    return token = Token::ProcessingInstruction;
+                }
+                else if (*iterator == '/') // </
+                {
+                    ++iterator;
+                    name = parseName();
 
-                    result = utf8::fromUtf32(c);
+                    if (openTags.empty() ||
+                        !std::equal(name.begin(), name.end(), openTags.back().begin(), openTags.back().end()))
+                        throw ParseError("Tag not closed properly");
+
+                    openTags.pop_back();
+
+                    if (iterator == end)
+                        throw ParseError("Unexpected end of data");
+
+                    if (*iterator != '>')
+                        throw ParseError("Expected a right angle bracket");
+
+                    ++iterator;
+
+                    return token = Token::EndTag;
                 }
-                else
-                    throw ParseError("Invalid entity");
+                else // <
+                {
+                    name = parseName();
+                    emptyElement = parseAttributes(false);
+                    openTags.push_back(name);
+                    return token = Token::StartTag;
+                }
+            }
 
-                return result;
+            inline auto getToken() const noexcept { return token; }
+            inline auto& getName() const noexcept { return name; }
+            inline auto& getValue() const noexcept { return value; }
+            inline auto& getAttributes() const noexcept { return attributes; }
+            inline auto getDepth() const noexcept { return openTags.size(); }
+            inline auto hasBom() const noexcept { return bom; }
+
+        private:
+            void skipWhitespaces() noexcept
+            {
+                while (iterator != end && isWhitespace(*iterator))
+                    ++iterator;
             }
 
-            inline std::string parseString(std::u32string::const_iterator& iterator,
-                                           std::u32string::const_iterator end)
+            Span<const char> parseName()
             {
-                std::string result;
+                if (iterator == end)
+                    throw ParseError("Unexpected end of data");
+
+                if (!isNameStartChar(*iterator))
+                    throw ParseError("Invalid name start");
+
+                const char* start = iterator;
+
+                while (iterator != end && isNameChar(*iterator))
+                    ++iterator;
 
                 if (iterator == end)
                     throw ParseError("Unexpected end of data");
 
-                if (*iterator != '"' && *iterator != '\'')
-                    throw ParseError("Expected quotes");
+                return Span<const char>(start, iterator);
+            }
 
-                auto quotes = *iterator;
+            // returns true if the tag is closed with a slash
+            bool parseAttributes(bool processingInstruction)
+            {
+                buffer.clear();
 
-                ++iterator;
+                // the decoded values are stored in the buffer, which can grow while the attributes are parsed
+                decodedValues.clear();
 
                 for (;;)
                 {
+                    skipWhitespaces();
+
                     if (iterator == end)
                         throw ParseError("Unexpected end of data");
 
-                    if (*iterator == quotes)
+                    if (processingInstruction && *iterator == '?')
                     {
+                        if (++iterator == end)
+                            throw ParseError("Unexpected end of data");
+
+                        if (*iterator != '>') // ?>
+                            throw ParseError("Expected a right angle bracket");
+
                         ++iterator;
                         break;
                     }
-                    else if (*iterator == '&')
+                    else if (!processingInstruction && *iterator == '>')
                     {
-                        std::string entity = parseEntity(iterator, end);
-                        result += entity;
+                        ++iterator;
+                        break;
                     }
-                    else
+                    else if (!processingInstruction && *iterator == '/')
                     {
-                        result += utf8::fromUtf32(*iterator);
+                        if (++iterator == end)
+                            throw ParseError("Unexpected end of data");
+
+                        if (*iterator != '>') // />
+                            throw ParseError("Expected a right angle bracket");
+
                         ++iterator;
+                        fixDecodedValues();
+                        return true;
                     }
+
+                    Attribute attribute;
+                    attribute.name = parseName();
+
+                    skipWhitespaces();
+
+                    if (iterator == end)
+                        throw ParseError("Unexpected end of data");
+
+                    if (*iterator != '=')
+                        throw ParseError("Expected an equal sign");
+
+                    ++iterator;
+
+                    skipWhitespaces();
+
+                    if (iterator == end)
+                        throw ParseError("Unexpected end of data");
+
+                    if (*iterator != '"' && *iterator != '\'')
+                        throw ParseError("Expected quotes");
+
+                    const char quotes = *iterator++;
+                    const char* start = iterator;
+
+                    while (iterator != end && *iterator != quotes) ++iterator;
+
+                    if (iterator == end)
+                        throw ParseError("Unexpected end of data");
+
+                    const size_t offset = buffer.size();
+                    attribute.value = decode(start, iterator++);
+
+                    if (buffer.size() != offset)
+                        decodedValues.emplace_back(attributes.size(), offset);
+
+                    attributes.push_back(attribute);
                 }
 
-                return result;
+                fixDecodedValues();
+                return false;
             }
 
-            inline void encodeString(std::vector<uint8_t>& data,
-                                     const std::u32string& str)
+            void fixDecodedValues()
             {
-                for (const char32_t c : str)
+                for (const auto& decodedValue : decodedValues)
                 {
-                    switch (c)
+                    Attribute& attribute = attributes[decodedValue.first];
+                    attribute.value = Span<const char>(buffer.data() + decodedValue.second, attribute.value.size());
+                }
+            }
+
+            // returns a view of the data if it contains no entities, otherwise decodes it to the end of the buffer
+            Span<const char> decode(const char* begin, const char* finish)
+            {
+                const char* ampersand = std::find(begin, finish, '&');
+                if (ampersand == finish) return Span<const char>(begin, finish);
+
+                const size_t offset = buffer.size();
+                buffer.append(begin, ampersand);
+
+                for (const char* i = ampersand; i != finish;)
+                {
+                    if (*i == '&')
                     {
-                        case '"':
-                            data.insert(data.end(), {'&', 'q', 'u', 'o', 't', ';'});
-                            break;
-                        case '&':
-                            data.insert(data.end(), {'&', 'a', 'm', 'p', ';'});
-                            break;
-                        case '\'':
-                            data.insert(data.end(), {'&', 'a', 'p', 'o', 's', ';'});
-                            break;
-                        case '<':
-                            data.insert(data.end(), {'&', 'l', 't', ';'});
-                            break;
-                        case '>':
-                            data.insert(data.end(), {'&', 'g', 't', ';'});
-                            break;
-                        default:
-                            std::string encoded = utf8::fromUtf32(c);
-                            data.insert(data.end(), encoded.begin(), encoded.end());
-                            break;
+                        const char* entityEnd = std::find(i, finish, ';');
+                        if (entityEnd == finish)
+                            throw ParseError("Unexpected end of data");
+
+                        decodeEntity(i + 1, entityEnd);
+                        i = entityEnd + 1;
                     }
+                    else
+                        buffer.push_back(*i++);
                 }
+
+                return Span<const char>(buffer.data() + offset, buffer.size() - offset);
+            }
+
+            void decodeEntity(const char* begin, const char* finish)
+            {
+                const std::string entity(begin, finish);
+
+                if (entity == "quot")
+                    buffer.push_back('"');
+                else if (entity == "amp")
+                    buffer.push_back('&');
+                else if (entity == "apos")
+                    buffer.push_back('\'');
+                else if (entity == "lt")
+                    buffer.push_back('<');
+                else if (entity == "gt")
+                    buffer.push_back('>');
+                else if (entity.length() >= 2 && entity[0] == '#')
+                {
+                    char32_t c = 0;
+
+                    if (entity[1] == 'x') // hex value
+                    {
+                        if (entity.length() < 3)
+                            throw ParseError("Invalid entity");
+
+                        for (size_t i = 2; i < entity.length(); ++i)
+                        {
+                            uint8_t code = 0;
+
+                            if (entity[i] >= '0' && entity[i] <= '9')
+                                code = static_cast<uint8_t>(entity[i]) - '0';
+                            else if (entity[i] >= 'a' && entity[i] <='f')
+                                code = static_cast<uint8_t>(entity[i]) - 'a' + 10;
+                            else if (entity[i] >= 'A' && entity[i] <='F')
+                                code = static_cast<uint8_t>(entity[i]) - 'A' + 10;
+                            else
+                                throw ParseError("Invalid character code");
+
+                            c = (c << 4) | code;
+                        }
+                    }
+                    else
+                    {
+                        for (size_t i = 1; i < entity.length(); ++i)
+                        {
+                            if (entity[i] < '0' || entity[i] > '9')
+                                throw ParseError("Invalid character code");
+
+                            c = c * 10 + static_cast<uint8_t>(entity[i] - '0');
+                        }
+                    }
+
+                    buffer += utf8::fromUtf32(c);
+                }
+                else
+                    throw ParseError("Invalid entity");
             }
-        }
+
+            const char* iterator;
+            const char* end;
+            bool preserveWhitespaces;
+            bool bom = false;
+
+            Token token = Token::End;
+            Span<const char> name;
+            Span<const char> value;
+            std::vector<Attribute> attributes;
+            std::vector<Span<const char>> openTags;
+            bool emptyElement = false;
+
+            std::string buffer;
+            std::vector<std::pair<size_t, size_t>> decodedValues; // attribute index and buffer offset
+        };
 
         class Data;
 
@@ -294,6 +534,8 @@ namespace ouzel
             inline auto& getValue() const noexcept { return value; }
             inline void setValue(const std::string& newValue) { value = newValue; }
 
+            inline auto& getAttributes() const noexcept { return attributes; }
+
             inline auto& getChildren() const noexcept { return children; }
 
             std::vector<Node>::iterator begin() { return children.begin(); }
@@ -303,255 +545,6 @@ namespace ouzel
             std::vector<Node>::const_iterator end() const { return children.end(); }
 
         protected:
-            void parse(std::u32string::const_iterator& iterator,
-                       std::u32string::const_iterator end,
-                       bool preserveWhitespaces = false,
-                       bool preserveComments = false,
-                       bool preserveProcessingInstructions = false)
-            {
-                if (iterator == end)
-                    throw ParseError("Unexpected end of data");
-
-                if (*iterator == '<')
-                {
-                    if (++iterator == end)
-                        throw ParseError("Unexpected end of data");
-
-                    if (*iterator == '!') // <!
-                    {
-                        if (++iterator == end)
-                            throw ParseError("Unexpected end of data");
-
-                        if (*iterator == '-') // <!-
-                        {
-                            if (++iterator == end)
-                                throw ParseError("Unexpected end of data");
-
-                            if (*iterator != '-') // <!--
-                                throw ParseError("Expected a comment");
-
-                            for (;;)
-                            {
-                                if (std::distance(++iterator, end) < 3)
-                                    throw ParseError("Unexpected end of data");
-
-                                if (*iterator == '-')
-                                {
-                                    if (*(iterator + 1) == '-') // --
-                                    {
-                                        iterator += 2;
-
-                                        if (*iterator == '>') // -->
-                                        {
-                                            ++iterator;
-                                            break;
-                                        }
-                                        else
-                                            throw ParseError("Unexpected double-hyphen inside comment");
-                                    }
-                                }
-
-                                value += utf8::fromUtf32(*iterator);
-                            }
-
-                            type = Type::Comment;
-                        }
-                        else if (*iterator == '[') // <![
-                        {
-                            ++iterator;
-                            std::string name;
-                            name = parseName(iterator, end);
-
-                            if (name != "CDATA")
-                                throw ParseError("Expected CDATA");
-
-                            if (iterator == end)
-                                throw ParseError("Unexpected end of data");
-
-                            if (*iterator != '[')
-                                throw ParseError("Expected a left bracket");
-
-                            for (;;)
-                            {
-                                if (std::distance(++iterator, end) < 3)
-                                    throw ParseError("Unexpected end of data");
-
-                                if (*iterator == ']' &&
-                                    *(iterator + 1) == ']' &&
-                                    *(iterator + 2) == '>')
-                                {
-                                    iterator += 3;
-                                    break;
-                                }
-
-                                value += utf8::fromUtf32(*iterator);
-                            }
-
-                            type = Type::CData;
-                        }
-                        else
-                            throw ParseError("Type declarations are not supported");
-                    }
-                    else if (*iterator == '?') // <?
-                    {
-                        ++iterator;
-                        value = parseName(iterator, end);
-
-                        for (;;)
-                        {
-                            skipWhitespaces(iterator, end);
-
-                            if (iterator == end)
-                                throw ParseError("Unexpected end of data");
-
-                            if (*iterator == '?')
-                            {
-                                if (++iterator == end)
-                                    throw ParseError("Unexpected end of data");
-
-                                if (*iterator != '>') // ?>
-                                    throw ParseError("Expected a right angle bracket");
-
-                                ++iterator;
-                                break;
-                            }
-
-                            std::string attribute = parseName(iterator, end);
-
-                            skipWhitespaces(iterator, end);
-
-                            if (iterator == end)
-                                throw ParseError("Unexpected end of data");
-
-                            if (*iterator != '=')
-                                throw ParseError("Expected an equal sign");
-
-                            ++iterator;
-
-                            skipWhitespaces(iterator, end);
-                            attributes[attribute] = parseString(iterator, end);
-                        }
-
-                        type = Type::ProcessingInstruction;
-                    }
-                    else // <
-                    {
-                        value = parseName(iterator, end);
-
-                        bool tagClosed = false;
-
-                        for (;;)
-                        {
-                            skipWhitespaces(iterator, end);
-
-                            if (iterator == end)
-                                throw ParseError("Unexpected end of data");
-
-                            if (*iterator == '>')
-                            {
-                                ++iterator;
-                                break;
-                            }
-                            else if (*iterator == '/')
-                            {
-                                if (++iterator == end)
-                                    throw ParseError("Unexpected end of data");
-
-                                if (*iterator != '>') // />
-                                    throw ParseError("Expected a right angle bracket");
-
-                                tagClosed = true;
-                                ++iterator;
-                                break;
-                            }
-
-                            std::string attribute;
-                            attribute = parseName(iterator, end);
-
-                            skipWhitespaces(iterator, end);
-
-                            if (iterator == end)
-                                throw ParseError("Unexpected end of data");
-
-                            if (*iterator != '=')
-                                throw ParseError("Expected an equal sign");
-
-                            ++iterator;
-
-                            skipWhitespaces(iterator, end);
-
-                            attributes[attribute] = parseString(iterator, end);
-                        }
-
-                        if (!tagClosed)
-                        {
-                            for (;;)
-                            {
-                                if (!preserveWhitespaces) skipWhitespaces(iterator, end);
-
-                                if (iterator == end)
-                                    throw ParseError("Unexpected end of data");
-
-                                if (*iterator == '<' &&
-                                    iterator + 1 != end &&
-                                    *(iterator + 1) == '/')
-                                {
-                                    ++iterator; // skip the left angle bracket
-                                    ++iterator; // skip the slash
-
-                                    std::string tag = parseName(iterator, end);
-
-                                    if (tag != value)
-                                        throw ParseError("Tag not closed properly");
-
-                                    if (iterator == end)
-                                        throw ParseError("Unexpected end of data");
-
-                                    if (*iterator != '>')
-                                        throw ParseError("Expected a right angle bracket");
-
-                                    ++iterator;
-
-                                    break;
-                                }
-                                else
-                                {
-                                    Node node;
-                                    node.parse(iterator, end, preserveWhitespaces, preserveComments, preserveProcessingInstructions);
-
-                                    if ((preserveComments || node.getType() != Type::Comment) &&
-                                        (preserveProcessingInstructions || node.getType() != Type::ProcessingInstruction))
-                                        children.push_back(node);
-                                }
-                            }
-                        }
-
-                        type = Type::Tag;
-                    }
-                }
-                else
-                {
-                    for (;;)
-                    {
-                        if (iterator == end || // end of a file
-                            *iterator == '<') // start of a tag
-                            break;
-                        else if (*iterator == '&')
-                        {
-                            std::string entity = parseEntity(iterator, end);
-                            value += entity;
-                        }
-                        else
-                        {
-                            value += utf8::fromUtf32(*iterator);
-                            ++iterator;
-                        }
-                    }
-
-                    type = Type::Text;
-                }
-            }
-
             void encode(std::vector<uint8_t>& data) const
             {
                 switch (type)
@@ -580,7 +573,7 @@ namespace ouzel
                             {
                                 data.insert(data.end(), attribute.first.begin(), attribute.first.end());
                                 data.insert(data.end(), {'=', '"'});
-                                encodeString(data, utf8::toUtf32(attribute.second));
+                                encodeString(data, attribute.second);
                                 data.insert(data.end(), '"');
                             }
                         }
@@ -619,7 +612,7 @@ namespace ouzel
                         }
                         break;
                     case Node::Type::Text:
-                        encodeString(data, utf8::toUtf32(value));
+                        encodeString(data, value);
                         break;
                     default:
                         throw ParseError("Unknown node type");
@@ -630,7 +623,7 @@ namespace ouzel
             }
 
         private:
-            Type type;
+            Type type = Type::Text;
 
             std::string value;
             std::map<std::string, std::string> attributes;
@@ -642,55 +635,74 @@ namespace ouzel
         public:
             Data() = default;
 
-            Data(const std::vector<uint8_t>& data,
-                 bool preserveWhitespaces = false,
-                 bool preserveComments = false,
-                 bool preserveProcessingInstructions = false)
+            template <class T>
+            explicit Data(const T& data,
+                          bool preserveWhitespaces = false,
+                          bool preserveComments = false,
+                          bool preserveProcessingInstructions = false)
             {
-                std::u32string str;
-
-                // BOM
-                if (data.size() >= 3 &&
-                    std::equal(data.begin(), data.begin() + 3,
-                               std::begin(UTF8_BOM), std::end(UTF8_BOM)))
-                {
-                    bom = true;
-                    str = utf8::toUtf32(data.begin() + 3, data.end());
-                }
-                else
-                {
-                    bom = false;
-                    str = utf8::toUtf32(data);
-                }
+                Reader reader(data, preserveWhitespaces);
+                bom = reader.hasBom();
 
                 bool rootTagFound = false;
 
-                auto iterator = str.cbegin();
+                // the children of the open tags, a vector is not modified while its last element is open
+                std::vector<std::vector<Node>*> parents{&children};
 
                 for (;;)
                 {
-                    if (!preserveWhitespaces) skipWhitespaces(iterator, str.end());
+                    const auto token = reader.read();
 
-                    if (iterator == str.end()) break;
+                    if (token == Reader::Token::End) break;
 
-                    Node node;
-                    node.parse(iterator, str.end(),
-                               preserveWhitespaces,
-                               preserveComments,
-                               preserveProcessingInstructions);
+                    if (token == Reader::Token::EndTag)
+                    {
+                        parents.pop_back();
+                        continue;
+                    }
+
+                    if ((token == Reader::Token::Comment && !preserveComments) ||
+                        (token == Reader::Token::ProcessingInstruction && !preserveProcessingInstructions))
+                        continue;
 
-                    if ((preserveComments || node.getType() != Node::Type::Comment) &&
-                        (preserveProcessingInstructions || node.getType() != Node::Type::ProcessingInstruction))
+                    std::vector<Node>& siblings = *parents.back();
+                    siblings.emplace_back();
+                    Node& node = siblings.back();
+
+                    switch (token)
                     {
-                        children.push_back(node);
+                        case Reader::Token::StartTag: node.type = Node::Type::Tag; break;
+                        case Reader::Token::Text: node.type = Node::Type::Text; break;
+                        case Reader::Token::CData: node.type = Node::Type::CData; break;
+                        case Reader::Token::Comment: node.type = Node::Type::Comment; break;
+                        case Reader::Token::ProcessingInstruction: node.type = Node::Type::ProcessingInstruction; break;
+                        default: throw ParseError("Unknown node type");
+                    }
+
+                    const auto& name = reader.getName();
+                    const auto& value = reader.getValue();
 
-                        if (node.getType() == Node::Type::Tag)
+                    if (token == Reader::Token::StartTag ||
+                        token == Reader::Token::ProcessingInstruction)
+                        node.value.assign(name.begin(), name.end());
+                    else
+                        node.value.assign(value.begin(), value.end());
+
+                    for (const auto& attribute : reader.getAttributes())
+                        node.attributes[std::string(attribute.name.begin(), attribute.name.end())]
+                            .assign(attribute.value.begin(), attribute.value.end());
+
+                    if (token == Reader::Token::StartTag)
+                    {
+                        if (parents.size() == 1)
                         {
                             if (rootTagFound)
                                 throw ParseError("Multiple root tags found");
                             else
                                 rootTagFound = true;
                         }
+
+                        parents.push_back(&node.children);
                     }
                 }
 
@@ -0,0 +1,29 @@
+// Copyright 2015-2019 Elviss Strazdins. All rights reserved.
+
+struct VSInput
+{
+    float3 position: POSITION;
+    float4 color: COLOR;
+    float2 texCoord0: TEXCOORD0;
+    float4 modelViewProj0: INSTANCE_TRANSFORM0;
+    float4 modelViewProj1: INSTANCE_TRANSFORM1;
+    float4 modelViewProj2: INSTANCE_TRANSFORM2;
+    float4 modelViewProj3: INSTANCE_TRANSFORM3;
+    float4 instanceColor: INSTANCE_COLOR;
+};
+
+struct VS2PS
+{
+    float4 position: SV_POSITION;
+    float4 color: COLOR;
+    float2 texCoord: TEXCOORD;
+};
+
+void main(in VSInput input, out VS2PS output)
+{
+    // the columns of the matrix are the rows of the float4x4
+    float4x4 modelViewProj = float4x4(input.modelViewProj0, input.modelViewProj1, input.modelViewProj2, input.modelViewProj3);
+    output.position = mul(float4(input.position, 1), modelViewProj);
+    output.color = input.color * input.instanceColor;
+    output.texCoord = input.texCoord0;
+}
@@ -0,0 +1,3 @@
+# the instanced vertex shaders are compiled when they are loaded, so their source is embedded
+xxd -i ColorVSInstanced.hlsl ColorVSInstancedD3D11.h
+xxd -i TextureVSInstanced.hlsl TextureVSInstancedD3D11.h
\ No newline at end of file
@@ -0,0 +1,32 @@
+// Copyright 2015-2019 Elviss Strazdins. All rights reserved.
+
+#include <simd/simd.h>
+
+using namespace metal;
+
+typedef struct
+{
+    float3 position [[attribute(0)]];
+    half4 color [[attribute(1)]];
+    float4 modelViewProj0 [[attribute(5)]];
+    float4 modelViewProj1 [[attribute(6)]];
+    float4 modelViewProj2 [[attribute(7)]];
+    float4 modelViewProj3 [[attribute(8)]];
+    float4 instanceColor [[attribute(9)]];
+} VSInput;
+
+typedef struct
+{
+    float4 position [[position]];
+    half4 color;
+} VS2PS;
+
+// Vertex shader function
+vertex VS2PS mainVS(VSInput input [[stage_in]])
+{
+    VS2PS output;
+    const float4x4 modelViewProj(input.modelViewProj0, input.modelViewProj1, input.modelViewProj2, input.modelViewProj3);
+    output.position = modelViewProj * float4(input.position, 1.0);
+    output.color = input.color * half4(input.instanceColor);
+    return output;
+}
@@ -72,6 +72,10 @@ xxd -i ColorVSTVOS.metallib ColorVSTVOS.h
 xxd -i TexturePSTVOS.metallib TexturePSTVOS.h
 xxd -i TextureVSTVOS.metallib TextureVSTVOS.h
 
+# the instanced vertex shaders are compiled when they are loaded, so their source is embedded
+xxd -i ColorVSInstanced.metal ColorVSInstancedMetal.h
+xxd -i TextureVSInstanced.metal TextureVSInstancedMetal.h
+
 rm -rf ./*.air
 rm -rf ./*.metalar
 rm -rf ./*.metallib
\ No newline at end of file
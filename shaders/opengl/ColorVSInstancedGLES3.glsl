@@ -0,0 +1,12 @@
+#version 300 es
+precision highp float;
+in vec3 position0;
+in vec4 color0;
+in mat4 instanceModelViewProj;
+in vec4 instanceColor;
+out lowp vec4 exColor;
+void main()
+{
+    gl_Position = instanceModelViewProj * vec4(position0, 1.0);
+    exColor = color0 * instanceColor;
+}
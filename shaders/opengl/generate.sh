@@ -9,12 +9,16 @@ xxd -i ColorPSGL3.glsl ColorPSGL3.h
 xxd -i ColorVSGL3.glsl ColorVSGL3.h
 xxd -i TexturePSGL3.glsl TexturePSGL3.h
 xxd -i TextureVSGL3.glsl TextureVSGL3.h
+xxd -i ColorVSInstancedGL3.glsl ColorVSInstancedGL3.h
+xxd -i TextureVSInstancedGL3.glsl TextureVSInstancedGL3.h
 
 # OpenGL 4
 xxd -i ColorPSGL4.glsl ColorPSGL4.h
 xxd -i ColorVSGL4.glsl ColorVSGL4.h
 xxd -i TexturePSGL4.glsl TexturePSGL4.h
 xxd -i TextureVSGL4.glsl TextureVSGL4.h
+xxd -i ColorVSInstancedGL4.glsl ColorVSInstancedGL4.h
+xxd -i TextureVSInstancedGL4.glsl TextureVSInstancedGL4.h
 
 # OpenGL ES 2
 xxd -i ColorPSGLES2.glsl ColorPSGLES2.h
@@ -26,4 +30,6 @@ xxd -i TextureVSGLES2.glsl TextureVSGLES2.h
 xxd -i ColorPSGLES3.glsl ColorPSGLES3.h
 xxd -i ColorVSGLES3.glsl ColorVSGLES3.h
 xxd -i TexturePSGLES3.glsl TexturePSGLES3.h
-xxd -i TextureVSGLES3.glsl TextureVSGLES3.h
\ No newline at end of file
+xxd -i TextureVSGLES3.glsl TextureVSGLES3.h
+xxd -i ColorVSInstancedGLES3.glsl ColorVSInstancedGLES3.h
+xxd -i TextureVSInstancedGLES3.glsl TextureVSInstancedGLES3.h
\ No newline at end of file
@@ -0,0 +1,353 @@
+// Copyright 2015-2019 Elviss Strazdins. All rights reserved.
+
+// Writes a ZIP archive with 40k stored entries and one with the same entries deflated, opens them
+// the way Archive did (walking every local header with small reads) and the way it does it now
+// (indexing the central directory of the mapped archive) and reports the open time and the
+// random-access throughput of both on one thread and on all the hardware threads
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <zlib.h>
+#include "storage/Archive.hpp"
+#include "storage/File.hpp"
+#include "utils/Utils.hpp"
+
+namespace
+{
+    using namespace ouzel;
+
+    constexpr uint32_t ENTRY_COUNT = 40000;
+    constexpr uint32_t MIN_ENTRY_SIZE = 64;
+    constexpr uint32_t MAX_ENTRY_SIZE = 2048;
+    constexpr uint32_t READ_COUNT = 200000;
+    constexpr uint32_t OPEN_ROUND_COUNT = 5;
+
+    void encode16(std::vector<uint8_t>& buffer, uint16_t value)
+    {
+        buffer.push_back(static_cast<uint8_t>(value));
+        buffer.push_back(static_cast<uint8_t>(value >> 8));
+    }
+
+    void encode32(std::vector<uint8_t>& buffer, uint32_t value)
+    {
+        encode16(buffer, static_cast<uint16_t>(value));
+        encode16(buffer, static_cast<uint16_t>(value >> 16));
+    }
+
+    std::vector<uint8_t> deflate(const std::vector<uint8_t>& data)
+    {
+        z_stream zStream{};
+
+        // ZIP entries are raw DEFLATE streams without the zlib header
+        if (deflateInit2(&zStream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+            throw std::runtime_error("Failed to initialize deflate");
+
+        std::vector<uint8_t> result(deflateBound(&zStream, static_cast<uLong>(data.size())));
+
+        zStream.next_in = const_cast<Bytef*>(data.data());
+        zStream.avail_in = static_cast<uInt>(data.size());
+        zStream.next_out = result.data();
+        zStream.avail_out = static_cast<uInt>(result.size());
+
+        const int status = ::deflate(&zStream, Z_FINISH);
+        deflateEnd(&zStream);
+
+        if (status != Z_STREAM_END)
+            throw std::runtime_error("Failed to deflate");
+
+        result.resize(zStream.total_out);
+        return result;
+    }
+
+    // writes an archive with the entries in the order of the names, returns the total size of the entries
+    uint64_t writeArchive(const std::string& path, const std::vector<std::string>& names, bool compress)
+    {
+        std::mt19937 randomEngine(1);
+        std::uniform_int_distribution<uint32_t> sizeDistribution(MIN_ENTRY_SIZE, MAX_ENTRY_SIZE);
+        std::uniform_int_distribution<uint32_t> byteDistribution('a', 'h');
+
+        std::vector<uint8_t> archive;
+        std::vector<uint8_t> centralDirectory;
+        uint64_t totalSize = 0;
+
+        for (const std::string& name : names)
+        {
+            std::vector<uint8_t> data(sizeDistribution(randomEngine));
+            for (uint8_t& byte : data) byte = static_cast<uint8_t>(byteDistribution(randomEngine));
+            totalSize += data.size();
+
+            const auto crc = static_cast<uint32_t>(crc32(0, data.data(), static_cast<uInt>(data.size())));
+            const std::vector<uint8_t> entryData = compress ? deflate(data) : data;
+            const uint16_t method = compress ? 8 : 0;
+            const auto localHeaderOffset = static_cast<uint32_t>(archive.size());
+
+            encode32(archive, 0x04034B50); // local file header signature
+            encode16(archive, 20); // version needed to extract
+            encode16(archive, 0); // flags
+            encode16(archive, method);
+            encode32(archive, 0); // modification time and date
+            encode32(archive, crc);
+            encode32(archive, static_cast<uint32_t>(entryData.size()));
+            encode32(archive, static_cast<uint32_t>(data.size()));
+            encode16(archive, static_cast<uint16_t>(name.size()));
+            encode16(archive, 0); // extra field length
+            archive.insert(archive.end(), name.begin(), name.end());
+            archive.insert(archive.end(), entryData.begin(), entryData.end());
+
+            encode32(centralDirectory, 0x02014B50); // central directory header signature
+            encode16(centralDirectory, 20); // version made by
+            encode16(centralDirectory, 20); // version needed to extract
+            encode16(centralDirectory, 0); // flags
+            encode16(centralDirectory, method);
+            encode32(centralDirectory, 0); // modification time and date
+            encode32(centralDirectory, crc);
+            encode32(centralDirectory, static_cast<uint32_t>(entryData.size()));
+            encode32(centralDirectory, static_cast<uint32_t>(data.size()));
+            encode16(centralDirectory, static_cast<uint16_t>(name.size()));
+            encode16(centralDirectory, 0); // extra field length
+            encode16(centralDirectory, 0); // comment length
+            encode16(centralDirectory, 0); // disk number
+            encode16(centralDirectory, 0); // internal attributes
+            encode32(centralDirectory, 0); // external attributes
+            encode32(centralDirectory, localHeaderOffset);
+            centralDirectory.insert(centralDirectory.end(), name.begin(), name.end());
+        }
+
+        const auto centralDirectoryOffset = static_cast<uint32_t>(archive.size());
+        archive.insert(archive.end(), centralDirectory.begin(), centralDirectory.end());
+
+        encode32(archive, 0x06054B50); // end of central directory signature
+        encode16(archive, 0); // disk number
+        encode16(archive, 0); // disk with the central directory
+        encode16(archive, static_cast<uint16_t>(names.size()));
+        encode16(archive, static_cast<uint16_t>(names.size()));
+        encode32(archive, static_cast<uint32_t>(centralDirectory.size()));
+        encode32(archive, centralDirectoryOffset);
+        encode16(archive, 0); // comment length
+
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(archive.data()), static_cast<std::streamsize>(archive.size()));
+
+        if (!file)
+            throw std::runtime_error("Failed to write " + path);
+
+        return totalSize;
+    }
+
+    // the previous Archive, it supports only stored entries and reads them with seek and read on the shared file
+    class LocalHeaderArchive final
+    {
+    public:
+        explicit LocalHeaderArchive(const std::string& path):
+            file(path, storage::File::Mode::Read)
+        {
+            for (;;)
+            {
+                uint8_t signature[4];
+                file.read(signature, sizeof(signature), true);
+
+                if (decodeLittleEndian<uint32_t>(signature) == 0x02014B50) // central directory
+                    break;
+
+                if (decodeLittleEndian<uint32_t>(signature) != 0x04034B50)
+                    throw std::runtime_error("Bad signature");
+
+                uint8_t versionAndFlags[4];
+                file.read(versionAndFlags, sizeof(versionAndFlags), true);
+
+                uint8_t compression[2];
+                file.read(compression, sizeof(compression), true);
+
+                if (decodeLittleEndian<uint16_t>(compression) != 0)
+                    throw std::runtime_error("Unsupported compression");
+
+                file.seek(4, storage::File::Seek::Current); // skip modification time
+                file.seek(4, storage::File::Seek::Current); // skip CRC-32
+
+                uint8_t sizes[12];
+                file.read(sizes, sizeof(sizes), true);
+
+                const auto uncompressedSize = decodeLittleEndian<uint32_t>(sizes + 4);
+                const auto fileNameLength = decodeLittleEndian<uint16_t>(sizes + 8);
+                const auto extraFieldLength = decodeLittleEndian<uint16_t>(sizes + 10);
+
+                std::vector<char> name(fileNameLength + 1U);
+                file.read(name.data(), fileNameLength, true);
+                name[fileNameLength] = '\0';
+
+                Entry& entry = entries[name.data()];
+                entry.size = uncompressedSize;
+
+                file.seek(extraFieldLength, storage::File::Seek::Current); // skip extra field
+
+                entry.offset = file.getOffset();
+
+                file.seek(static_cast<int32_t>(uncompressedSize), storage::File::Seek::Current);
+            }
+        }
+
+        std::vector<uint8_t> readFile(const std::string& filename) const
+        {
+            auto i = entries.find(filename);
+
+            if (i == entries.end())
+                throw std::runtime_error("File " + filename + " does not exist");
+
+            std::vector<uint8_t> data(i->second.size);
+
+            // the reads from multiple threads have to be serialized, because they share the file offset
+            std::lock_guard<std::mutex> lock(fileMutex);
+            file.seek(static_cast<int32_t>(i->second.offset), storage::File::Seek::Begin);
+            file.read(data.data(), i->second.size, true);
+
+            return data;
+        }
+
+    private:
+        struct Entry final
+        {
+            uint32_t offset;
+            uint32_t size;
+        };
+
+        storage::File file;
+        mutable std::mutex fileMutex;
+        std::map<std::string, Entry> entries;
+    };
+
+    // returns the milliseconds of the fastest open
+    template <class F>
+    double measureOpen(F open)
+    {
+        double result = std::numeric_limits<double>::max();
+
+        for (uint32_t round = 0; round < OPEN_ROUND_COUNT; ++round)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            open();
+            result = std::min(result, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1000.0);
+        }
+
+        return result;
+    }
+
+    // reads READ_COUNT entries in random order split between the threads, returns the seconds
+    template <class F>
+    double measureReads(F readFile, const std::vector<std::string>& names, uint32_t threadCount)
+    {
+        std::vector<std::thread> threads;
+        std::vector<size_t> checksums(threadCount);
+
+        const auto start = std::chrono::steady_clock::now();
+
+        for (uint32_t t = 0; t < threadCount; ++t)
+            threads.emplace_back([&, t]() {
+                std::mt19937 randomEngine(t + 1);
+                std::uniform_int_distribution<size_t> nameDistribution(0, names.size() - 1);
+
+                for (uint32_t i = t; i < READ_COUNT; i += threadCount)
+                    checksums[t] += readFile(names[nameDistribution(randomEngine)]).size();
+            });
+
+        for (std::thread& thread : threads)
+            thread.join();
+
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        size_t readSize = 0;
+        for (const size_t checksum : checksums) readSize += checksum;
+        if (readSize == 0) throw std::runtime_error("Nothing was read");
+
+        return seconds;
+    }
+
+    void printReads(const std::string& name, uint32_t threadCount, double seconds, double averageEntrySize)
+    {
+        std::cout << std::left << std::setw(34) << name << std::right <<
+            std::setw(8) << threadCount <<
+            std::fixed << std::setprecision(0) <<
+            std::setw(14) << READ_COUNT / seconds <<
+            std::setprecision(1) <<
+            std::setw(12) << READ_COUNT * averageEntrySize / (1024.0 * 1024.0) / seconds << '\n';
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const std::string storedPath = argc > 1 ? argv[1] : "ArchiveBenchmarkStored.zip";
+    const std::string deflatedPath = argc > 2 ? argv[2] : "ArchiveBenchmarkDeflated.zip";
+
+    try
+    {
+        std::vector<std::string> names;
+        names.reserve(ENTRY_COUNT);
+
+        for (uint32_t i = 0; i < ENTRY_COUNT; ++i)
+            names.push_back("assets/group" + std::to_string(i / 256) + "/entry" + std::to_string(i) + ".bin");
+
+        const uint64_t totalSize = writeArchive(storedPath, names, false);
+        writeArchive(deflatedPath, names, true);
+
+        const double averageEntrySize = static_cast<double>(totalSize) / ENTRY_COUNT;
+        const uint32_t threadCount = std::max(std::thread::hardware_concurrency(), 1U);
+
+        std::cout << "Archive with " << ENTRY_COUNT << " entries of " << MIN_ENTRY_SIZE << " to " << MAX_ENTRY_SIZE << " bytes\n";
+
+        std::cout << std::fixed << std::setprecision(2) <<
+            "Open, local headers (stored):       " << measureOpen([&]() { LocalHeaderArchive archive(storedPath); }) << " ms\n" <<
+            "Open, central directory (stored):   " << measureOpen([&]() { storage::Archive archive(storedPath); }) << " ms\n" <<
+            "Open, central directory (deflated): " << measureOpen([&]() { storage::Archive archive(deflatedPath); }) << " ms\n";
+
+        const LocalHeaderArchive localHeaderArchive(storedPath);
+        const storage::Archive storedArchive(storedPath);
+        const storage::Archive deflatedArchive(deflatedPath);
+
+        // both must read the same data
+        for (uint32_t i = 0; i < ENTRY_COUNT; i += 97)
+            if (localHeaderArchive.readFile(names[i]) != storedArchive.readFile(names[i]) ||
+                storedArchive.readFile(names[i]) != deflatedArchive.readFile(names[i]))
+                throw std::runtime_error("Entry " + names[i] + " differs");
+
+        auto readLocalHeader = [&](const std::string& name) { return localHeaderArchive.readFile(name); };
+        auto readStored = [&](const std::string& name) { return storedArchive.readFile(name); };
+        auto readStoredView = [&](const std::string& name) { return storedArchive.readFileView(name); };
+        auto readDeflated = [&](const std::string& name) { return deflatedArchive.readFile(name); };
+
+        std::cout << "Random reads                       Threads  Reads per s        MB/s\n";
+
+        for (const uint32_t threads : {1U, threadCount})
+        {
+            printReads("seek and read (stored)", threads, measureReads(readLocalHeader, names, threads), averageEntrySize);
+            printReads("readFile (stored)", threads, measureReads(readStored, names, threads), averageEntrySize);
+            printReads("readFileView (stored)", threads, measureReads(readStoredView, names, threads), averageEntrySize);
+            printReads("readFile (deflated)", threads, measureReads(readDeflated, names, threads), averageEntrySize);
+
+            if (threadCount == 1) break;
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << '\n';
+        std::remove(storedPath.c_str());
+        std::remove(deflatedPath.c_str());
+        return EXIT_FAILURE;
+    }
+
+    std::remove(storedPath.c_str());
+    std::remove(deflatedPath.c_str());
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,162 @@
+// Copyright 2015-2019 Elviss Strazdins. All rights reserved.
+
+// Records and executes the command buffer of a sprite heavy frame without a render device and
+// reports the frames per second and the heap allocations per frame of the command buffer
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <vector>
+#include "graphics/Commands.hpp"
+
+namespace
+{
+    size_t allocationCount = 0;
+}
+
+void* operator new(std::size_t size)
+{
+    ++allocationCount;
+
+    if (void* result = std::malloc(size ? size : 1))
+        return result;
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+namespace
+{
+    using namespace ouzel;
+    using namespace ouzel::graphics;
+
+    constexpr uint32_t SPRITE_COUNT = 2000;
+    constexpr uint32_t TEXT_COUNT = 8;
+    constexpr uint32_t GLYPH_COUNT = 4;
+    constexpr uint32_t FRAME_COUNT = 2000;
+
+    const std::string debugMarker = "Scene";
+
+    void recordFrame(CommandBuffer& commandBuffer,
+                     const std::vector<uint8_t>& meshData,
+                     const std::vector<uint8_t>& glyphData)
+    {
+        const float color[4] = {1.0F, 1.0F, 1.0F, 1.0F};
+        const float modelViewProjection[16] = {
+            1.0F, 0.0F, 0.0F, 0.0F,
+            0.0F, 1.0F, 0.0F, 0.0F,
+            0.0F, 0.0F, 1.0F, 0.0F,
+            0.0F, 0.0F, 0.0F, 1.0F
+        };
+
+        commandBuffer.pushCommand<PushDebugMarkerCommand>(commandBuffer.pushString(debugMarker));
+        commandBuffer.pushCommand<SetRenderTargetCommand>(0);
+        commandBuffer.pushCommand<ClearRenderTargetCommand>(true, true, false, Color::black(), 1.0F, 0);
+
+        for (uint32_t i = 0; i < TEXT_COUNT; ++i)
+            commandBuffer.pushCommand<SetBufferDataCommand>(100 + i, commandBuffer.pushData<uint8_t>(meshData));
+
+        for (uint32_t i = 0; i < GLYPH_COUNT; ++i)
+            commandBuffer.pushCommand<SetTextureRegionCommand>(200, i * 32, 0, Size2U(32, 32),
+                                                               commandBuffer.pushData<uint8_t>(glyphData));
+
+        for (uint32_t i = 0; i < SPRITE_COUNT; ++i)
+        {
+            commandBuffer.pushCommand<SetPipelineStateCommand>(1, 2 + i % 2, CullMode::NoCull, FillMode::Solid);
+
+            const ConstantBlock fragmentShaderConstants = commandBuffer.pushConstants({color});
+            const ConstantBlock vertexShaderConstants = commandBuffer.pushConstants({modelViewProjection});
+            commandBuffer.pushCommand<SetShaderConstantsCommand>(fragmentShaderConstants, vertexShaderConstants);
+
+            commandBuffer.pushCommand<SetTexturesCommand>(std::array<uintptr_t, SetTexturesCommand::MAX_TEXTURES>{{300 + i % 16}});
+            commandBuffer.pushCommand<DrawCommand>(10, 6, sizeof(uint16_t), 11, DrawMode::TriangleList, i * 6);
+        }
+
+        commandBuffer.pushCommand<PopDebugMarkerCommand>();
+        commandBuffer.pushCommand<PresentCommand>();
+    }
+
+    // reads every command the way a render device does and returns a sum of the data it has seen
+    size_t executeFrame(CommandBuffer& commandBuffer)
+    {
+        size_t result = 0;
+
+        while (!commandBuffer.isEmpty())
+        {
+            const Command* command = commandBuffer.popCommand();
+
+            switch (command->type)
+            {
+                case Command::Type::SetBufferData:
+                    result += static_cast<const SetBufferDataCommand*>(command)->data.size();
+                    break;
+                case Command::Type::SetTextureRegion:
+                    result += static_cast<const SetTextureRegionCommand*>(command)->data.size();
+                    break;
+                case Command::Type::SetShaderConstants:
+                {
+                    auto setShaderConstantsCommand = static_cast<const SetShaderConstantsCommand*>(command);
+                    result += commandBuffer.getConstants(setShaderConstantsCommand->vertexShaderConstants).size();
+                    break;
+                }
+                case Command::Type::Draw:
+                    result += static_cast<const DrawCommand*>(command)->indexCount;
+                    break;
+                default:
+                    ++result;
+                    break;
+            }
+        }
+
+        // the render device clears the command buffer before it is reused for the next frame
+        commandBuffer.clear();
+
+        return result;
+    }
+}
+
+int main()
+{
+    const std::vector<uint8_t> meshData(4096, 1);
+    const std::vector<uint8_t> glyphData(32 * 32 * 4, 2);
+
+    CommandBuffer commandBuffer;
+    size_t checksum = 0;
+
+    // the first frame grows the command buffer to the frame size
+    size_t startAllocationCount = allocationCount;
+    recordFrame(commandBuffer, meshData, glyphData);
+    checksum += executeFrame(commandBuffer);
+    const size_t firstFrameAllocations = allocationCount - startAllocationCount;
+
+    startAllocationCount = allocationCount;
+    const auto start = std::chrono::steady_clock::now();
+
+    for (uint32_t frame = 0; frame < FRAME_COUNT; ++frame)
+    {
+        recordFrame(commandBuffer, meshData, glyphData);
+        checksum += executeFrame(commandBuffer);
+    }
+
+    const auto end = std::chrono::steady_clock::now();
+    const size_t allocations = allocationCount - startAllocationCount;
+    const double seconds = std::chrono::duration<double>(end - start).count();
+
+    std::cout << "Command buffer: " << SPRITE_COUNT << " sprites, " << TEXT_COUNT << " buffer updates, " <<
+        GLYPH_COUNT << " texture region updates per frame (checksum " << checksum << ")\n";
+    std::cout << "Frames per second: " << static_cast<double>(FRAME_COUNT) / seconds << '\n';
+    std::cout << "Allocations per frame: " << static_cast<double>(allocations) / FRAME_COUNT <<
+        " (first frame: " << firstFrameAllocations << ")\n";
+
+    return EXIT_SUCCESS;
+}
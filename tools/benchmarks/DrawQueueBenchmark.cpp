@@ -0,0 +1,117 @@
+// Copyright 2015-2019 Elviss Strazdins. All rights reserved.
+
+// Builds the draw queue of a layer with 1k, 10k and 50k visible actors the way Actor::visit did
+// (a sorted insert for every actor) and the way Layer::draw does it (append and sort once) and
+// reports the time per frame of both
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace
+{
+    // the members of the actor that the draw queue is sorted by
+    struct Actor final
+    {
+        int32_t worldOrder;
+        uint32_t visitOrder;
+    };
+
+    constexpr int32_t ORDER_COUNT = 8;
+    constexpr double MIN_DURATION = 0.5; // seconds
+
+    void insertQueue(const std::vector<Actor*>& actors, std::vector<Actor*>& drawQueue)
+    {
+        drawQueue.clear();
+
+        for (Actor* actor : actors)
+        {
+            auto upperBound = std::upper_bound(drawQueue.begin(), drawQueue.end(), actor,
+                                               [](Actor* a, Actor* b) noexcept {
+                                                   return a->worldOrder > b->worldOrder;
+                                               });
+
+            drawQueue.insert(upperBound, actor);
+        }
+    }
+
+    void sortQueue(const std::vector<Actor*>& actors, std::vector<Actor*>& drawQueue)
+    {
+        drawQueue.clear();
+
+        for (Actor* actor : actors)
+            drawQueue.push_back(actor);
+
+        std::sort(drawQueue.begin(), drawQueue.end(),
+                  [](const Actor* a, const Actor* b) noexcept {
+                      return a->worldOrder == b->worldOrder ?
+                          a->visitOrder < b->visitOrder :
+                          a->worldOrder > b->worldOrder;
+                  });
+    }
+
+    // returns the milliseconds per frame
+    template <class F>
+    double measure(F buildQueue, const std::vector<Actor*>& actors, std::vector<Actor*>& drawQueue)
+    {
+        uint32_t frameCount = 0;
+        const auto start = std::chrono::steady_clock::now();
+        double seconds;
+
+        do
+        {
+            buildQueue(actors, drawQueue);
+            ++frameCount;
+            seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+        while (seconds < MIN_DURATION);
+
+        return seconds * 1000.0 / frameCount;
+    }
+}
+
+int main()
+{
+    std::mt19937 randomEngine(1);
+    std::uniform_int_distribution<int32_t> orderDistribution(0, ORDER_COUNT - 1);
+
+    std::cout << "Actors  Sorted insert (ms)  Append and sort (ms)\n";
+
+    for (const uint32_t actorCount : {1000U, 10000U, 50000U})
+    {
+        std::vector<Actor> actorStorage(actorCount);
+        std::vector<Actor*> actors;
+        actors.reserve(actorCount);
+
+        for (uint32_t i = 0; i < actorCount; ++i)
+        {
+            actorStorage[i].worldOrder = orderDistribution(randomEngine);
+            actorStorage[i].visitOrder = i;
+            actors.push_back(&actorStorage[i]);
+        }
+
+        std::vector<Actor*> insertedQueue;
+        std::vector<Actor*> sortedQueue;
+        const double insertTime = measure(insertQueue, actors, insertedQueue);
+        const double sortTime = measure(sortQueue, actors, sortedQueue);
+
+        // both must produce the same drawing order
+        if (insertedQueue != sortedQueue)
+        {
+            std::cerr << "Draw queues differ for " << actorCount << " actors\n";
+            return EXIT_FAILURE;
+        }
+
+        std::cout << std::setw(6) << actorCount <<
+            std::fixed << std::setprecision(3) <<
+            std::setw(20) << insertTime <<
+            std::setw(22) << sortTime << '\n';
+    }
+
+    return EXIT_SUCCESS;
+}
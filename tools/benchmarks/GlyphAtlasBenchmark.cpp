@@ -0,0 +1,119 @@
+// Copyright 2015-2019 Elviss Strazdins. All rights reserved.
+
+// Lays out a screen of text with a TrueType font whose glyph atlas is cold (every glyph is
+// rasterized and packed, like the first frame of a label) and warm (all the glyphs are in the
+// atlas already) and reports the milliseconds per layout and the glyphs per second of both
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+#include "core/Engine.hpp"
+#include "graphics/Renderer.hpp"
+#include "gui/TTFont.hpp"
+#include "stb_truetype.h"
+
+namespace
+{
+    using namespace ouzel;
+
+    // an engine without a window, the textures of the atlases are created on the empty render driver
+    class BenchmarkEngine final: public Engine
+    {
+    public:
+        BenchmarkEngine()
+        {
+            renderer = std::make_unique<graphics::Renderer>(graphics::Driver::Empty,
+                                                            nullptr,
+                                                            Size2U(1280, 720),
+                                                            1,
+                                                            graphics::SamplerFilter::Point,
+                                                            1,
+                                                            false,
+                                                            false,
+                                                            false,
+                                                            false,
+                                                            false);
+        }
+
+    private:
+        void runOnMainThread(const std::function<void()>& func) final
+        {
+            func();
+        }
+    };
+
+    constexpr float FONT_SIZE = 24.0F;
+    constexpr uint32_t COLD_LAYOUT_COUNT = 200;
+    constexpr uint32_t WARM_LAYOUT_COUNT = 2000;
+
+    const std::string text =
+        "The quick brown fox jumps over the lazy dog.\n"
+        "THE QUICK BROWN FOX JUMPS OVER THE LAZY DOG!\n"
+        "0123456789 +-*/=()[]{}<>.,:;'\"?!@#$%^&_|~\n"
+        "Score: 12345  Lives: 3  Level: 7  Time: 01:23\n"
+        "Pack my box with five dozen liquor jugs.\n"
+        "Sphinx of black quartz, judge my vow.\n";
+
+    size_t countGlyphs(const std::string& str)
+    {
+        size_t result = 0;
+        for (const char c : str)
+            if (c != '\n') ++result;
+        return result;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const std::string fontFile = argc > 1 ? argv[1] : "../../samples/Resources/AmosisTechnik.ttf";
+
+    std::ifstream file(fontFile, std::ios::binary);
+    if (!file)
+    {
+        std::cerr << "Failed to open " << fontFile << '\n';
+        return EXIT_FAILURE;
+    }
+
+    const std::vector<uint8_t> fontData{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+
+    BenchmarkEngine benchmarkEngine;
+
+    const size_t glyphCount = countGlyphs(text);
+    size_t checksum = 0;
+
+    // every layout gets a new font, so the atlas is created and all the glyphs are rasterized
+    auto start = std::chrono::steady_clock::now();
+
+    for (uint32_t i = 0; i < COLD_LAYOUT_COUNT; ++i)
+    {
+        gui::TTFont font(fontData, false);
+        checksum += std::get<1>(font.getRenderData(text, Color::white(), FONT_SIZE, Vector2F(0.5F, 0.5F))).size();
+    }
+
+    const double coldSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // the same font is used for every layout, so all the glyphs come from the atlas
+    gui::TTFont font(fontData, false);
+    checksum += std::get<1>(font.getRenderData(text, Color::white(), FONT_SIZE, Vector2F(0.5F, 0.5F))).size();
+
+    start = std::chrono::steady_clock::now();
+
+    for (uint32_t i = 0; i < WARM_LAYOUT_COUNT; ++i)
+        checksum += std::get<1>(font.getRenderData(text, Color::white(), FONT_SIZE, Vector2F(0.5F, 0.5F))).size();
+
+    const double warmSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "Glyph atlas: " << glyphCount << " glyphs per layout at " << FONT_SIZE <<
+        " pixels (checksum " << checksum << ")\n";
+    std::cout << "Cold atlas: " << coldSeconds * 1000.0 / COLD_LAYOUT_COUNT << " ms per layout, " <<
+        static_cast<double>(glyphCount * COLD_LAYOUT_COUNT) / coldSeconds << " glyphs per second\n";
+    std::cout << "Warm atlas: " << warmSeconds * 1000.0 / WARM_LAYOUT_COUNT << " ms per layout, " <<
+        static_cast<double>(glyphCount * WARM_LAYOUT_COUNT) / warmSeconds << " glyphs per second\n";
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,233 @@
+// Copyright 2015-2019 Elviss Strazdins. All rights reserved.
+
+// Compresses a buffer with zlib into a raw DEFLATE stream of stored, fixed Huffman and dynamic Huffman
+// blocks, inflates every stream with storage::Inflater at once and in small chunks, compares the output
+// with the output of zlib byte for byte and reports the megabytes per second of both decompressors
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <zlib.h>
+#include "storage/Inflater.hpp"
+
+namespace
+{
+    using namespace ouzel;
+
+    constexpr size_t DATA_SIZE = 4 * 1024 * 1024;
+    constexpr size_t CHUNK_SIZE = 4099; // not a power of two, so the chunks end in the middle of the matches
+    constexpr uint32_t ROUND_COUNT = 10;
+
+    struct Stream final
+    {
+        const char* name;
+        int level;
+        int strategy;
+        uint32_t blockType; // BTYPE of the first block
+    };
+
+    const Stream streams[] = {
+        {"stored", Z_NO_COMPRESSION, Z_DEFAULT_STRATEGY, 0},
+        {"fixed Huffman", Z_DEFAULT_COMPRESSION, Z_FIXED, 1},
+        {"dynamic Huffman", Z_DEFAULT_COMPRESSION, Z_DEFAULT_STRATEGY, 2}
+    };
+
+    // words with a skewed distribution for the matches and the literals and a few random runs,
+    // so that the streams have both short and long back-references and incompressible parts
+    std::vector<uint8_t> generateData()
+    {
+        static const char* words[] = {
+            "sprite", "texture", "shader", "actor", "layer", "camera", "sound", "mixer",
+            "the ", "of ", "and ", "a ", "in ", "\n", "{\"frames\": [", "], ", "0.5, ", "1024"
+        };
+
+        std::mt19937 randomEngine(1);
+        std::geometric_distribution<size_t> wordDistribution(0.2);
+        std::uniform_int_distribution<uint32_t> byteDistribution(0, 255);
+        std::uniform_int_distribution<uint32_t> runDistribution(0, 63);
+
+        std::vector<uint8_t> result;
+        result.reserve(DATA_SIZE);
+
+        while (result.size() < DATA_SIZE)
+        {
+            if (runDistribution(randomEngine) == 0)
+                for (uint32_t i = 0; i < 200; ++i)
+                    result.push_back(static_cast<uint8_t>(byteDistribution(randomEngine)));
+            else
+            {
+                const std::string word = words[std::min(wordDistribution(randomEngine), sizeof(words) / sizeof(words[0]) - 1)];
+                result.insert(result.end(), word.begin(), word.end());
+            }
+        }
+
+        result.resize(DATA_SIZE);
+        return result;
+    }
+
+    std::vector<uint8_t> deflate(const std::vector<uint8_t>& data, const Stream& stream)
+    {
+        z_stream zStream{};
+
+        // negative window bits produce a raw stream without the zlib header, like the ZIP entries
+        if (deflateInit2(&zStream, stream.level, Z_DEFLATED, -15, 8, stream.strategy) != Z_OK)
+            throw std::runtime_error("Failed to initialize deflate");
+
+        std::vector<uint8_t> result(deflateBound(&zStream, static_cast<uLong>(data.size())));
+
+        zStream.next_in = const_cast<Bytef*>(data.data());
+        zStream.avail_in = static_cast<uInt>(data.size());
+        zStream.next_out = result.data();
+        zStream.avail_out = static_cast<uInt>(result.size());
+
+        const int status = ::deflate(&zStream, Z_FINISH);
+        deflateEnd(&zStream);
+
+        if (status != Z_STREAM_END)
+            throw std::runtime_error("Failed to deflate");
+
+        result.resize(zStream.total_out);
+        return result;
+    }
+
+    std::vector<uint8_t> zlibInflate(const std::vector<uint8_t>& compressed, size_t size)
+    {
+        z_stream zStream{};
+
+        if (inflateInit2(&zStream, -15) != Z_OK)
+            throw std::runtime_error("Failed to initialize inflate");
+
+        std::vector<uint8_t> result(size);
+
+        zStream.next_in = const_cast<Bytef*>(compressed.data());
+        zStream.avail_in = static_cast<uInt>(compressed.size());
+        zStream.next_out = result.data();
+        zStream.avail_out = static_cast<uInt>(result.size());
+
+        const int status = ::inflate(&zStream, Z_FINISH);
+        inflateEnd(&zStream);
+
+        if (status != Z_STREAM_END)
+            throw std::runtime_error("Failed to inflate");
+
+        result.resize(zStream.total_out);
+        return result;
+    }
+
+    std::vector<uint8_t> ouzelInflate(const std::vector<uint8_t>& compressed, size_t size, size_t chunkSize)
+    {
+        storage::Inflater inflater(Span<const uint8_t>(compressed.data(), compressed.size()));
+
+        // one more byte than expected, so that the output past the end of the stream is detected too
+        std::vector<uint8_t> result(size + 1);
+        size_t resultSize = 0;
+
+        for (;;)
+        {
+            const size_t requested = std::min(chunkSize, result.size() - resultSize);
+            const size_t inflated = inflater.inflate(result.data() + resultSize, requested);
+            resultSize += inflated;
+
+            if (inflated < requested || resultSize == result.size()) break;
+        }
+
+        result.resize(resultSize);
+        return result;
+    }
+
+    // returns true if the outputs are the same, otherwise prints the first difference
+    bool compare(const std::string& name, const std::vector<uint8_t>& expected, const std::vector<uint8_t>& output)
+    {
+        const auto mismatch = std::mismatch(expected.begin(), expected.end(), output.begin(), output.end());
+
+        if (mismatch.first == expected.end() && mismatch.second == output.end())
+            return true;
+
+        std::cerr << name << ": output differs from zlib at byte " << (mismatch.first - expected.begin()) <<
+            " (" << output.size() << " bytes instead of " << expected.size() << ")\n";
+        return false;
+    }
+
+    // returns the megabytes of output per second of the fastest round
+    template <class F>
+    double measure(F function)
+    {
+        double seconds = std::numeric_limits<double>::max();
+
+        for (uint32_t round = 0; round < ROUND_COUNT; ++round)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            if (function().size() != DATA_SIZE)
+                throw std::runtime_error("Failed to inflate");
+            seconds = std::min(seconds, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        }
+
+        return static_cast<double>(DATA_SIZE) / (1024.0 * 1024.0) / seconds;
+    }
+}
+
+int main()
+{
+    try
+    {
+        const std::vector<uint8_t> data = generateData();
+        bool success = true;
+
+        std::cout << "Stream            Compressed (bytes)  zlib (MB/s)  Inflater (MB/s)\n";
+
+        for (const Stream& stream : streams)
+        {
+            const std::vector<uint8_t> compressed = deflate(data, stream);
+
+            // BTYPE follows the BFINAL bit in the first byte
+            if (((compressed[0] >> 1) & 0x03U) != stream.blockType)
+            {
+                std::cerr << stream.name << ": zlib did not produce the expected block type\n";
+                success = false;
+                continue;
+            }
+
+            const std::vector<uint8_t> expected = zlibInflate(compressed, data.size());
+            if (!compare(std::string(stream.name) + " (zlib)", data, expected))
+            {
+                success = false;
+                continue;
+            }
+
+            // the whole output with one call and in chunks that resume in the middle of the blocks
+            if (!compare(std::string(stream.name) + " (at once)", expected, ouzelInflate(compressed, data.size(), data.size() + 1)) ||
+                !compare(std::string(stream.name) + " (in chunks)", expected, ouzelInflate(compressed, data.size(), CHUNK_SIZE)))
+            {
+                success = false;
+                continue;
+            }
+
+            const double zlibSpeed = measure([&]() { return zlibInflate(compressed, data.size()); });
+            const double inflaterSpeed = measure([&]() { return ouzelInflate(compressed, data.size(), data.size() + 1); });
+
+            std::cout << std::left << std::setw(18) << stream.name << std::right <<
+                std::setw(18) << compressed.size() <<
+                std::fixed << std::setprecision(1) <<
+                std::setw(13) << zlibSpeed <<
+                std::setw(17) << inflaterSpeed << '\n';
+        }
+
+        if (!success) return EXIT_FAILURE;
+
+        std::cout << "All streams match zlib\n";
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,284 @@
+// Copyright 2015-2019 Elviss Strazdins. All rights reserved.
+
+// Runs the mixer kernels and the scalar loops that Bus, Mixer and AudioDevice used before them
+// on a 1024 frame buffer and reports the nanoseconds per buffer and the largest difference
+// between the outputs of both
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+#include "audio/mixer/Kernels.hpp"
+#include "math/MathUtils.hpp"
+
+namespace
+{
+    using namespace ouzel;
+    using namespace ouzel::audio;
+
+    constexpr uint32_t FRAMES = 1024;
+    constexpr uint32_t SOURCE_FRAMES = 941; // 44100 Hz source on a 48000 Hz bus
+    constexpr uint32_t ROUND_COUNT = 15;
+    constexpr uint32_t CALLS_PER_ROUND = 1000;
+
+    float checksum = 0.0F;
+
+    // the loops of the previous Bus.cpp
+    void scalarAdd(const std::vector<float>& buffer, std::vector<float>& samples)
+    {
+        for (size_t s = 0; s < samples.size(); ++s)
+            samples[s] += buffer[s];
+    }
+
+    void scalarResample(uint32_t channels, uint32_t sourceFrames, const std::vector<float>& sourceSamples,
+                        uint32_t frames, std::vector<float>& samples)
+    {
+        auto sourceIncrement = static_cast<float>(sourceFrames - 1) / static_cast<float>(frames - 1);
+        auto sourcePosition = 0.0F;
+
+        samples.resize(frames * channels);
+
+        for (uint32_t frame = 0; frame < frames - 1; ++frame)
+        {
+            auto sourceCurrentFrame = static_cast<uint32_t>(sourcePosition);
+            auto fraction = sourcePosition - sourceCurrentFrame;
+
+            uint32_t sourceNextFrame = sourceCurrentFrame + 1;
+
+            for (uint32_t channel = 0; channel < channels; ++channel)
+            {
+                const auto sourceChannel = &sourceSamples[channel * sourceFrames];
+                auto outputChannel = &samples[channel * frames];
+
+                outputChannel[frame] = lerp(sourceChannel[sourceCurrentFrame],
+                                            sourceChannel[sourceNextFrame],
+                                            fraction);
+            }
+
+            sourcePosition += sourceIncrement;
+        }
+
+        for (uint32_t channel = 0; channel < channels; ++channel)
+        {
+            const auto sourceChannel = &sourceSamples[channel * sourceFrames];
+            auto outputChannel = &samples[channel * frames];
+            outputChannel[frames - 1] = sourceChannel[sourceFrames - 1];
+        }
+    }
+
+    // the upmix 1 to 2 and the downmix 4 to 2 of the previous convert, followed by the accumulation
+    void scalarConvertAdd(uint32_t frames, uint32_t sourceChannels, const std::vector<float>& sourceSamples,
+                          std::vector<float>& buffer, std::vector<float>& samples)
+    {
+        buffer.resize(frames * 2);
+
+        if (sourceChannels == 1)
+        {
+            for (uint32_t frame = 0; frame < frames; ++frame)
+            {
+                buffer[0 * frames + frame] = sourceSamples[frame]; // L = M
+                buffer[1 * frames + frame] = sourceSamples[frame]; // R = M
+            }
+        }
+        else
+        {
+            for (uint32_t frame = 0; frame < frames; ++frame)
+            {
+                buffer[0 * frames + frame] = (sourceSamples[0 * frames + frame] +
+                                              sourceSamples[2 * frames + frame]) * 0.5F; // L = (L + SL) * 0.5
+                buffer[1 * frames + frame] = (sourceSamples[1 * frames + frame] +
+                                              sourceSamples[3 * frames + frame]) * 0.5F; // R = (R + RL) * 0.5
+            }
+        }
+
+        scalarAdd(buffer, samples);
+    }
+
+    // the loop of the previous Mixer.cpp
+    void scalarClamp(std::vector<float>& samples)
+    {
+        for (float& sample : samples)
+            sample = clamp(sample, -1.0F, 1.0F);
+    }
+
+    // the loops of the previous AudioDevice.cpp
+    template <class T>
+    void scalarInterleave(uint32_t frames, uint32_t channels, const std::vector<float>& buffer, T* resultPtr)
+    {
+        for (uint32_t channel = 0; channel < channels; ++channel)
+        {
+            const float* bufferChannel = &buffer[channel * frames];
+
+            for (uint32_t frame = 0; frame < frames; ++frame)
+                resultPtr[frame * channels + channel] = static_cast<T>(bufferChannel[frame] * (sizeof(T) == 2 ? 32767.0F : 1.0F));
+        }
+    }
+
+    // returns the nanoseconds per call of the fastest round, so that the other processes disturb the result less
+    template <class F>
+    double measure(F function)
+    {
+        double result = std::numeric_limits<double>::max();
+
+        for (uint32_t round = 0; round < ROUND_COUNT; ++round)
+        {
+            const auto start = std::chrono::steady_clock::now();
+
+            for (uint32_t i = 0; i < CALLS_PER_ROUND; ++i)
+                function();
+
+            const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            result = std::min(result, seconds * 1000000000.0 / CALLS_PER_ROUND);
+        }
+
+        return result;
+    }
+
+    template <class T>
+    double getMaxDifference(const std::vector<T>& a, const std::vector<T>& b)
+    {
+        double result = 0.0;
+        for (size_t i = 0; i < a.size(); ++i)
+            result = std::max(result, std::fabs(static_cast<double>(a[i]) - static_cast<double>(b[i])));
+        return result;
+    }
+
+    void printResult(const std::string& name, double scalarTime, double simdTime, double difference)
+    {
+        std::cout << std::left << std::setw(24) << name << std::right <<
+            std::fixed << std::setprecision(0) <<
+            std::setw(12) << scalarTime <<
+            std::setw(12) << simdTime <<
+            std::setprecision(2) << std::setw(10) << scalarTime / simdTime << 'x' <<
+            std::scientific << std::setprecision(1) << std::setw(14) << difference << '\n';
+    }
+}
+
+int main()
+{
+    std::mt19937 randomEngine(1);
+    std::uniform_real_distribution<float> sampleDistribution(-1.0F, 1.0F);
+
+    auto randomSamples = [&](size_t count, float scale) {
+        std::vector<float> result(count);
+        for (float& sample : result) sample = sampleDistribution(randomEngine) * scale;
+        return result;
+    };
+
+    std::cout << "Kernel (1024 frames)     Scalar (ns)   SIMD (ns)   Speedup   Max difference\n";
+
+    // accumulation of a stereo stream
+    {
+        const std::vector<float> source = randomSamples(FRAMES * 2, 0.5F);
+        std::vector<float> scalarSamples(FRAMES * 2);
+        std::vector<float> simdSamples(FRAMES * 2);
+
+        scalarAdd(source, scalarSamples);
+        mixer::addSamples(source.data(), simdSamples.data(), FRAMES * 2);
+        const double difference = getMaxDifference(scalarSamples, simdSamples);
+
+        // both are timed on the same buffers, so that their placement in memory does not favor either
+        const double scalarTime = measure([&]() { scalarAdd(source, scalarSamples); });
+        const double simdTime = measure([&]() { mixer::addSamples(source.data(), scalarSamples.data(), FRAMES * 2); });
+        checksum += scalarSamples[1] + simdSamples[1];
+        printResult("add 2ch", scalarTime, simdTime, difference);
+    }
+
+    // resampling of a stereo stream
+    {
+        const std::vector<float> source = randomSamples(SOURCE_FRAMES * 2, 1.0F);
+        std::vector<float> scalarSamples(FRAMES * 2);
+        std::vector<float> simdSamples(FRAMES * 2);
+
+        scalarResample(2, SOURCE_FRAMES, source, FRAMES, scalarSamples);
+        mixer::resampleSamples(2, SOURCE_FRAMES, source.data(), FRAMES, simdSamples.data());
+        const double difference = getMaxDifference(scalarSamples, simdSamples);
+
+        const double scalarTime = measure([&]() { scalarResample(2, SOURCE_FRAMES, source, FRAMES, scalarSamples); });
+        const double simdTime = measure([&]() { mixer::resampleSamples(2, SOURCE_FRAMES, source.data(), FRAMES, simdSamples.data()); });
+        checksum += scalarSamples[1] + simdSamples[1];
+        printResult("resample 2ch 44.1->48k", scalarTime, simdTime, difference);
+    }
+
+    // channel conversion and accumulation to a stereo bus
+    for (const uint32_t sourceChannels : {1U, 4U})
+    {
+        const std::vector<float> source = randomSamples(FRAMES * sourceChannels, 0.5F);
+        std::vector<float> buffer;
+        std::vector<float> scalarSamples(FRAMES * 2);
+        std::vector<float> simdSamples(FRAMES * 2);
+
+        scalarConvertAdd(FRAMES, sourceChannels, source, buffer, scalarSamples);
+        mixer::addConvertedSamples(FRAMES, sourceChannels, source.data(), 2, simdSamples.data());
+        const double difference = getMaxDifference(scalarSamples, simdSamples);
+
+        const double scalarTime = measure([&]() { scalarConvertAdd(FRAMES, sourceChannels, source, buffer, scalarSamples); });
+        const double simdTime = measure([&]() { mixer::addConvertedSamples(FRAMES, sourceChannels, source.data(), 2, scalarSamples.data()); });
+        checksum += scalarSamples[1] + simdSamples[1];
+        printResult("convert " + std::to_string(sourceChannels) + "->2 and add", scalarTime, simdTime, difference);
+    }
+
+    // clamping of the mixed stereo output
+    {
+        const std::vector<float> source = randomSamples(FRAMES * 2, 2.0F);
+        std::vector<float> scalarSamples = source;
+        std::vector<float> simdSamples = source;
+
+        scalarClamp(scalarSamples);
+        mixer::clampSamples(simdSamples.data(), FRAMES * 2);
+        const double difference = getMaxDifference(scalarSamples, simdSamples);
+
+        // the buffers are refilled, so that every call clamps samples that are out of range
+        const double scalarTime = measure([&]() {
+            std::copy(source.begin(), source.end(), scalarSamples.begin());
+            scalarClamp(scalarSamples);
+        });
+        const double simdTime = measure([&]() {
+            std::copy(source.begin(), source.end(), simdSamples.begin());
+            mixer::clampSamples(simdSamples.data(), FRAMES * 2);
+        });
+        checksum += scalarSamples[1] + simdSamples[1];
+        printResult("copy and clamp 2ch", scalarTime, simdTime, difference);
+    }
+
+    // interleaving of the stereo output for the audio device
+    {
+        const std::vector<float> source = randomSamples(FRAMES * 2, 1.0F);
+        std::vector<float> scalarSamples(FRAMES * 2);
+        std::vector<float> simdSamples(FRAMES * 2);
+
+        scalarInterleave(FRAMES, 2, source, scalarSamples.data());
+        mixer::interleaveSamples(FRAMES, 2, source.data(), simdSamples.data());
+        const double difference = getMaxDifference(scalarSamples, simdSamples);
+
+        const double scalarTime = measure([&]() { scalarInterleave(FRAMES, 2, source, scalarSamples.data()); });
+        const double simdTime = measure([&]() { mixer::interleaveSamples(FRAMES, 2, source.data(), simdSamples.data()); });
+        checksum += scalarSamples[1] + simdSamples[1];
+        printResult("interleave 2ch float", scalarTime, simdTime, difference);
+    }
+
+    {
+        const std::vector<float> source = randomSamples(FRAMES * 2, 1.0F);
+        std::vector<int16_t> scalarSamples(FRAMES * 2);
+        std::vector<int16_t> simdSamples(FRAMES * 2);
+
+        scalarInterleave(FRAMES, 2, source, scalarSamples.data());
+        mixer::interleaveSamples(FRAMES, 2, source.data(), simdSamples.data());
+        const double difference = getMaxDifference(scalarSamples, simdSamples);
+
+        const double scalarTime = measure([&]() { scalarInterleave(FRAMES, 2, source, scalarSamples.data()); });
+        const double simdTime = measure([&]() { mixer::interleaveSamples(FRAMES, 2, source.data(), simdSamples.data()); });
+        checksum += scalarSamples[1] + simdSamples[1];
+        printResult("interleave 2ch int16", scalarTime, simdTime, difference);
+    }
+
+    std::cout << "Checksum: " << checksum << '\n';
+
+    return EXIT_SUCCESS;
+}
@@ -2,19 +2,37 @@
 
 #include <cstdlib>
 #include <iostream>
+#include <memory>
 #include <set>
 #include <stdexcept>
+#include <string>
+#include <vector>
 #include "MakefileProject.hpp"
+#include "assets/Cache.hpp"
+#include "assets/Cooker.hpp"
+#include "core/Application.hpp"
+#include "storage/FileSystem.hpp"
+#include "storage/MappedFile.hpp"
 #include "VisualStudioProject.hpp"
 #include "XcodeProject.hpp"
 
+namespace ouzel
+{
+    // The tool does not start the engine, the entry point is only needed to link the engine library
+    std::unique_ptr<Application> main(const std::vector<std::string>&)
+    {
+        return nullptr;
+    }
+}
+
 int main(int argc, const char* argv[])
 {
     enum class Action
     {
         NONE,
         NEW_PROJECT,
-        GENERATE
+        GENERATE,
+        COOK
     };
 
     enum class Project
@@ -38,6 +56,7 @@ int main(int argc, const char* argv[])
     Action action = Action::NONE;
     std::string path;
     std::string name;
+    std::string output;
     std::set<Project> projects;
     std::set<Platform> platforms;
 
@@ -46,7 +65,7 @@ int main(int argc, const char* argv[])
         if (std::string(argv[i]) == "--help")
         {
             std::cout << "Usage:\n";
-            std::cout << argv[0] << " [--help] [--new-project <name>] [--generate <path>] [--project <all|makefile|visualstudio|xcode>] [--location <location>]\n";
+            std::cout << argv[0] << " [--help] [--new-project <name>] [--generate <path>] [--project <all|makefile|visualstudio|xcode>] [--location <location>] [--cook <asset list>] [--output <pack>]\n";
             return EXIT_SUCCESS;
         }
         else if (std::string(argv[i]) == "--new-project")
@@ -73,6 +92,22 @@ int main(int argc, const char* argv[])
 
             path = std::string(argv[i]);
         }
+        else if (std::string(argv[i]) == "--cook")
+        {
+            action = Action::COOK;
+
+            if (++i >= argc)
+                throw std::runtime_error("Invalid command");
+
+            path = std::string(argv[i]);
+        }
+        else if (std::string(argv[i]) == "--output")
+        {
+            if (++i >= argc)
+                throw std::runtime_error("Invalid command");
+
+            output = std::string(argv[i]);
+        }
         else if (std::string(argv[i]) == "--project")
         {
             if (std::string(argv[i]) == "all")
@@ -131,6 +166,24 @@ int main(int argc, const char* argv[])
                 break;
             case Action::GENERATE:
                 break;
+            case Action::COOK:
+            {
+                // the pack is written next to the asset list by default
+                if (output.empty())
+                    output = path.substr(0, path.find_last_of('.')) + ".pack";
+
+                const ouzel::storage::MappedFile assetList(path);
+                const auto assets = ouzel::assets::Bundle::readAssetList(ouzel::Span<const uint8_t>(assetList.getData(),
+                                                                                                     assetList.getSize()));
+
+                ouzel::assets::Cache cache;
+                ouzel::assets::Cooker cooker(cache);
+                cooker.cook(assets, ouzel::storage::FileSystem::getDirectoryPart(path), output);
+
+                std::cout << "Cooked " << cooker.getCookedAssetCount() << " assets, " <<
+                    cooker.getReusedAssetCount() << " unchanged assets reused\n";
+                break;
+            }
             default:
                 throw std::runtime_error("Invalid action selected");
         }